@@ -9,6 +9,7 @@
 #include "spdlog/spdlog.h"
 #include "spdlog/async.h"
 #include "spdlog/sinks/basic_file_sink.h"
+#include "spdlog/sinks/null_sink.h"
 
 #if defined(SPDLOG_USE_STD_FORMAT)
     #include <format>
@@ -18,12 +19,17 @@
     #include "spdlog/fmt/bundled/format.h"
 #endif
 
+#include "instrumentation.h"
 #include "utils.h"
+#include <algorithm>
 #include <atomic>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
@@ -32,6 +38,7 @@ using namespace spdlog::sinks;
 using namespace utils;
 
 void bench_mt(int howmany, std::shared_ptr<spdlog::logger> log, int thread_count);
+int sweep(int argc, char *argv[]);
 
 #ifdef _MSC_VER
     #pragma warning(push)
@@ -75,8 +82,15 @@ int main(int argc, char *argv[]) {
         spdlog::set_pattern("[%^%l%$] %v");
         if (argc == 1) {
             spdlog::info("Usage: {} <message_count> <threads> <q_size> <iterations>", argv[0]);
+            spdlog::info(
+                "       {} --sweep <message_count> <max_threads> <max_workers> <q_size> "
+                "<csv|json>",
+                argv[0]);
             return 0;
         }
+        if (std::strcmp(argv[1], "--sweep") == 0) {
+            return sweep(argc, argv);
+        }
 
         if (argc > 1) howmany = atoi(argv[1]);
         if (argc > 2) threads = atoi(argv[2]);
@@ -146,6 +160,7 @@ void thread_fun(std::shared_ptr<spdlog::logger> logger, int howmany) {
 void bench_mt(int howmany, std::shared_ptr<spdlog::logger> logger, int thread_count) {
     using std::chrono::high_resolution_clock;
     vector<std::thread> threads;
+    instrumentation::meter meter;
     auto start = high_resolution_clock::now();
 
     int msgs_per_thread = howmany / thread_count;
@@ -163,6 +178,163 @@ void bench_mt(int howmany, std::shared_ptr<spdlog::logger> logger, int thread_co
     }
 
     auto delta = high_resolution_clock::now() - start;
+    auto figures = meter.stop();
     auto delta_d = duration_cast<duration<double>>(delta).count();
-    spdlog::info("Elapsed: {} secs\t {:L}/sec", delta_d, int(howmany / delta_d));
+    spdlog::info("Elapsed: {} secs\t {:L}/sec\t {}", delta_d, int(howmany / delta_d),
+                 instrumentation::per_message(figures, static_cast<std::uint64_t>(howmany)));
+}
+
+//
+// sweep mode: throughput and cpu time per message from 1 to max_threads producers (doubling),
+// for each worker count (doubling up to max_workers), queue type and overflow policy, printed
+// as csv or json on stdout. the messages go to a null sink so that the queue and the
+// producers contention are measured, not the disk. the time and cpu run until the queue is
+// drained and the workers are joined.
+//
+
+struct sweep_point {
+    const char *queue;
+    const char *policy;
+    int workers;
+    int producers;
+    int messages;
+    double elapsed;  // seconds
+    double cpu;      // seconds, of the whole process
+    size_t dropped;  // overrun, discarded or sampled out
+};
+
+// powers of two from 1, and max itself
+std::vector<int> doubling(int max) {
+    std::vector<int> values;
+    for (int v = 1; v < max; v *= 2) {
+        values.push_back(v);
+    }
+    values.push_back(max);
+    return values;
+}
+
+sweep_point sweep_run(int howmany,
+                      int producers,
+                      int workers,
+                      size_t queue_size,
+                      async_queue_type queue_type,
+                      async_overflow_policy policy) {
+    using std::chrono::steady_clock;
+    details::thread_pool_options options(queue_size, static_cast<size_t>(workers));
+    options.queue_type = queue_type;
+    auto tp = std::make_shared<details::thread_pool>(std::move(options));
+    auto logger = std::make_shared<async_logger>(
+        "sweep", std::make_shared<spdlog::sinks::null_sink_mt>(), tp, policy);
+
+    auto cpu_start = std::clock();  // process cpu time (wall time with msvc)
+    auto start = steady_clock::now();
+    vector<std::thread> threads;
+    for (int t = 0; t < producers; ++t) {
+        int n = howmany / producers + (t == 0 ? howmany % producers : 0);
+        threads.emplace_back(thread_fun, logger, n);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    logger.reset();
+    auto dropped = tp->overrun_counter() + tp->discard_counter() + tp->sampled_out_counter();
+    tp.reset();  // drains the queue and joins the workers
+    auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    auto cpu = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    sweep_point point{};
+    point.workers = workers;
+    point.producers = producers;
+    point.messages = howmany;
+    point.elapsed = elapsed;
+    point.cpu = cpu;
+    point.dropped = dropped;
+    return point;
+}
+
+int sweep(int argc, char *argv[]) {
+    int howmany = argc > 2 ? atoi(argv[2]) : 1000000;
+    int max_threads =
+        argc > 3 ? atoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+    int max_workers = argc > 4 ? atoi(argv[4]) : 4;
+    int queue_size = argc > 5 ? atoi(argv[5]) : 8192;
+    std::string output = argc > 6 ? argv[6] : "csv";
+    if (howmany <= 0 || max_threads <= 0 || max_workers <= 0 || queue_size <= 0 ||
+        (output != "csv" && output != "json")) {
+        spdlog::error("Usage: {} --sweep <message_count> <max_threads> <max_workers> <q_size> "
+                      "<csv|json>",
+                      argv[0]);
+        return 1;
+    }
+
+    struct queue_choice {
+        const char *name;
+        async_queue_type type;
+    };
+    const queue_choice queues[] = {
+        {"blocking", async_queue_type::blocking},
+        {"lock_free", async_queue_type::lock_free},
+#ifndef SPDLOG_NO_TLS
+        {"per_thread", async_queue_type::per_thread},
+#endif
+        {"priority_lanes", async_queue_type::priority_lanes},
+    };
+    struct policy_choice {
+        const char *name;
+        async_overflow_policy policy;
+    };
+    const policy_choice policies[] = {
+        {"block", async_overflow_policy::block},
+        {"overrun_oldest", async_overflow_policy::overrun_oldest},
+        {"discard_new", async_overflow_policy::discard_new},
+        {"sample", async_overflow_policy::sample},
+    };
+
+    bool json = output == "json";
+    if (json) {
+        std::cout << "[" << std::flush;
+    } else {
+        std::cout << "queue,policy,workers,producers,messages,elapsed_s,msgs_per_sec,"
+                     "cpu_ns_per_msg,dropped"
+                  << std::endl;
+    }
+    bool first = true;
+    for (auto &queue : queues) {
+        for (auto &policy : policies) {
+            for (int workers : doubling(max_workers)) {
+                for (int producers : doubling(max_threads)) {
+                    auto point = sweep_run(howmany, producers, workers,
+                                           static_cast<size_t>(queue_size), queue.type,
+                                           policy.policy);
+                    point.queue = queue.name;
+                    point.policy = policy.name;
+                    auto per_sec = point.messages / point.elapsed;
+                    auto cpu_ns = point.cpu * 1e9 / point.messages;
+                    if (json) {
+                        std::cout << spdlog::fmt_lib::format(
+                                         "{}\n  {{\"queue\": \"{}\", \"policy\": \"{}\", "
+                                         "\"workers\": {}, \"producers\": {}, \"messages\": {}, "
+                                         "\"elapsed_s\": {:.6f}, \"msgs_per_sec\": {:.0f}, "
+                                         "\"cpu_ns_per_msg\": {:.1f}, \"dropped\": {}}}",
+                                         first ? "" : ",", point.queue, point.policy,
+                                         point.workers, point.producers, point.messages,
+                                         point.elapsed, per_sec, cpu_ns, point.dropped)
+                                  << std::flush;
+                    } else {
+                        std::cout << spdlog::fmt_lib::format(
+                                         "{},{},{},{},{},{:.6f},{:.0f},{:.1f},{}", point.queue,
+                                         point.policy, point.workers, point.producers,
+                                         point.messages, point.elapsed, per_sec, cpu_ns,
+                                         point.dropped)
+                                  << std::endl;
+                    }
+                    first = false;
+                }
+            }
+        }
+    }
+    if (json) {
+        std::cout << "\n]" << std::endl;
+    }
+    return 0;
 }
@@ -20,6 +20,7 @@
     #include "spdlog/fmt/bundled/format.h"
 #endif
 
+#include "instrumentation.h"
 #include "utils.h"
 #include <atomic>
 #include <cstdlib>  // EXIT_FAILURE
@@ -149,17 +150,19 @@ void bench(int howmany, std::shared_ptr<spdlog::logger> log) {
     using std::chrono::duration_cast;
     using std::chrono::high_resolution_clock;
 
+    instrumentation::meter meter;
     auto start = high_resolution_clock::now();
     for (auto i = 0; i < howmany; ++i) {
         log->info("Hello logger: msg number {}", i);
     }
 
     auto delta = high_resolution_clock::now() - start;
+    auto figures = meter.stop();
     auto delta_d = duration_cast<duration<double>>(delta).count();
 
-    spdlog::info(spdlog::fmt_lib::format(std::locale("en_US.UTF-8"),
-                                         "{:<30} Elapsed: {:0.2f} secs {:>16L}/sec", log->name(),
-                                         delta_d, size_t(howmany / delta_d)));
+    spdlog::info(spdlog::fmt_lib::format(
+        std::locale("en_US.UTF-8"), "{:<30} Elapsed: {:0.2f} secs {:>16L}/sec  {}", log->name(),
+        delta_d, size_t(howmany / delta_d), instrumentation::per_message(figures, howmany)));
     spdlog::drop(log->name());
 }
 
@@ -170,6 +173,7 @@ void bench_mt(int howmany, std::shared_ptr<spdlog::logger> log, size_t thread_co
 
     std::vector<std::thread> threads;
     threads.reserve(thread_count);
+    instrumentation::meter meter;
     auto start = high_resolution_clock::now();
     for (size_t t = 0; t < thread_count; ++t) {
         threads.emplace_back([&]() {
@@ -184,10 +188,11 @@ void bench_mt(int howmany, std::shared_ptr<spdlog::logger> log, size_t thread_co
     }
 
     auto delta = high_resolution_clock::now() - start;
+    auto figures = meter.stop();
     auto delta_d = duration_cast<duration<double>>(delta).count();
-    spdlog::info(spdlog::fmt_lib::format(std::locale("en_US.UTF-8"),
-                                         "{:<30} Elapsed: {:0.2f} secs {:>16L}/sec", log->name(),
-                                         delta_d, size_t(howmany / delta_d)));
+    spdlog::info(spdlog::fmt_lib::format(
+        std::locale("en_US.UTF-8"), "{:<30} Elapsed: {:0.2f} secs {:>16L}/sec  {}", log->name(),
+        delta_d, size_t(howmany / delta_d), instrumentation::per_message(figures, howmany)));
     spdlog::drop(log->name());
 }
 
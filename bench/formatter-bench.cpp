@@ -7,38 +7,119 @@
 
 #include "spdlog/spdlog.h"
 #include "spdlog/pattern_formatter.h"
+#ifndef SPDLOG_NO_TLS
+    #include "spdlog/mdc.h"
+#endif
 
-void bench_formatter(benchmark::State &state, std::string pattern) {
-    auto formatter = spdlog::details::make_unique<spdlog::pattern_formatter>(pattern);
-    spdlog::memory_buf_t dest;
-    std::string logger_name = "logger-name";
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "instrumentation.h"
+
+// a message to format: the payload, its source location and the mdc entries of the thread
+struct payload {
+    std::string name;
+    std::string text;
+    spdlog::source_loc source;
+    std::vector<std::pair<std::string, std::string>> mdc;
+};
+
+payload short_payload() {
     const char *text =
         "Hello. This is some message with length of 80                                   ";
+    return payload{"short", text, spdlog::source_loc{"a/b/c/d/myfile.cpp", 123, "some_func()"},
+                   {}};
+}
+
+// payloads as they come in real applications
+std::vector<payload> realistic_payloads() {
+    spdlog::source_loc here{__FILE__, __LINE__, SPDLOG_FUNCTION};
+    std::vector<payload> payloads;
+    payloads.push_back(short_payload());
+
+    std::string long_text = "Request failed after 3 retries: ";
+    while (long_text.size() < 1000) {
+        long_text += "upstream connection reset by peer while reading response header, ";
+    }
+    payloads.push_back(payload{"long", long_text, here, {}});
+
+    payloads.push_back(payload{
+        "json",
+        R"({"event":"order_created","order_id":"5f2b8c1e-9d4a-4e7b-a3c6-0f1e2d3c4b5a",)"
+        R"("customer":{"id":84213,"name":"Jane Doe","email":"jane.doe@example.com"},)"
+        R"("items":[{"sku":"A-1042","qty":2,"price":19.99},{"sku":"B-2077","qty":1,)"
+        R"("price":249.5}],"total":289.48,"currency":"EUR","tags":["priority","gift"]})",
+        here,
+        {}});
+
+    // german, russian, chinese, japanese and symbols, in utf-8
+    payloads.push_back(payload{"non_ascii",
+                               "Benutzer \xc3\xbc""berpr\xc3\xbc""ft: \xd0\x9f\xd1\x80\xd0\xb8"
+                               "\xd0\xb2\xd0\xb5\xd1\x82 \xe4\xb8\x96\xe7\x95\x8c, "
+                               "\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf "
+                               "\xe2\x82\xac 42,50 \xe2\x9c\x93",
+                               here,
+                               {}});
+
+#ifndef SPDLOG_NO_TLS
+    payload with_mdc{"mdc", "Handled the request in 12.5 ms", here, {}};
+    const char *keys[] = {"request_id", "trace_id",  "span_id", "user_id",
+                          "tenant",     "client_ip", "method",  "route"};
+    const char *values[] = {"42",    "4bf92f3577b34da6a3ce929d0e0e4736",
+                            "00f067aa0ba902b7", "84213", "acme",
+                            "203.0.113.7",      "GET",  "/api/v1/orders/{id}"};
+    for (size_t i = 0; i < 8; i++) {
+        with_mdc.mdc.emplace_back(keys[i], values[i]);
+    }
+    payloads.push_back(with_mdc);
+#endif
+    return payloads;
+}
 
-    spdlog::source_loc source_loc{"a/b/c/d/myfile.cpp", 123, "some_func()"};
-    spdlog::details::log_msg msg(source_loc, logger_name, spdlog::level::info, text);
+void bench_formatter(benchmark::State &state, std::string pattern, payload p) {
+    auto formatter = spdlog::details::make_unique<spdlog::pattern_formatter>(pattern);
+    spdlog::memory_buf_t dest;
+    std::string logger_name = "logger-name";
+    spdlog::details::log_msg msg(p.source, logger_name, spdlog::level::info, p.text);
+#ifndef SPDLOG_NO_TLS
+    for (auto &entry : p.mdc) {
+        spdlog::mdc::put(entry.first, entry.second);
+    }
+#endif
 
+    instrumentation::meter meter;
     for (auto _ : state) {
         dest.clear();
         formatter->format(msg, dest);
         benchmark::DoNotOptimize(dest);
     }
+    auto figures = meter.stop();
+    auto per_iteration = [](std::uint64_t value) {
+        return benchmark::Counter(static_cast<double>(value), benchmark::Counter::kAvgIterations);
+    };
+    state.counters["allocs"] = per_iteration(figures.allocations);
+    if (figures.has_hw) {
+        state.counters["cycles"] = per_iteration(figures.cycles);
+        state.counters["instructions"] = per_iteration(figures.instructions);
+        state.counters["llc_misses"] = per_iteration(figures.llc_misses);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(p.text.size()));
+#ifndef SPDLOG_NO_TLS
+    spdlog::mdc::clear();
+#endif
 }
 
 void bench_formatters() {
-    // basic patterns(single flag)
+    // basic patterns(single flag), then padded left, right and center, and truncated
     std::string all_flags = "+vtPnlLaAbBcCYDmdHIMSefFprRTXzEisg@luioO%";
-    std::vector<std::string> basic_patterns;
     for (auto &flag : all_flags) {
-        auto pattern = std::string("%") + flag;
-        benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern);
-
-        //        pattern = std::string("%16") + flag;
-        //        benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern);
-        //
-        //        // bench center padding
-        //        pattern = std::string("%=16") + flag;
-        //        benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern);
+        for (const char *padding : {"", "16", "-16", "=16", "8!"}) {
+            auto pattern = std::string("%") + padding + flag;
+            benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern,
+                                         short_payload());
+        }
     }
 
     // complex patterns
@@ -48,23 +129,44 @@ void bench_formatters() {
         "[%Y-%m-%d %H:%M:%S.%e] [%l] [%n] [%t] %v",
     };
     for (auto &pattern : patterns) {
-        benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern)
+        benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern, short_payload())
             ->Iterations(2500000);
     }
 }
 
+// the default pattern and typical custom ones, over each realistic payload
+void bench_realistic() {
+    std::vector<std::string> patterns = {
+        "%+",
+        "[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] [%s:%#] [%&] %v",
+        "%Y-%m-%dT%H:%M:%S.%f%z %-8l %12!n [%=24!@] [%t] %v",
+    };
+    for (auto &p : realistic_payloads()) {
+        for (auto &pattern : patterns) {
+            auto name = p.name + "/" + pattern;
+            benchmark::RegisterBenchmark(name.c_str(), &bench_formatter, pattern, p);
+        }
+    }
+}
+
 int main(int argc, char *argv[]) {
     spdlog::set_pattern("[%^%l%$] %v");
     if (argc != 2) {
-        spdlog::error("Usage: {} <pattern> (or \"all\" to bench all)", argv[0]);
+        spdlog::error(
+            "Usage: {} <pattern> (or \"all\" to bench all, or \"realistic\" to bench the "
+            "common patterns over realistic payloads)",
+            argv[0]);
         exit(1);
     }
 
     std::string pattern = argv[1];
     if (pattern == "all") {
         bench_formatters();
+        bench_realistic();
+    } else if (pattern == "realistic") {
+        bench_realistic();
     } else {
-        benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern);
+        benchmark::RegisterBenchmark(pattern.c_str(), &bench_formatter, pattern, short_payload());
     }
     benchmark::Initialize(&argc, argv);
     benchmark::RunSpecifiedBenchmarks();
@@ -0,0 +1,235 @@
+//
+// Copyright(c) 2015 Gabi Melman.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+//
+
+#pragma once
+
+//
+// instrumentation.h : allocations and hardware counters of the benchmarks
+//
+// The global operator new and delete are replaced by versions counting the allocations (so
+// this header must be included by a single translation unit of the benchmark). The hardware
+// counters (cycles, instructions, last level cache misses) are read with perf_event_open on
+// linux, if SPDLOG_BENCH_PERF=1 is set in the environment. They count the thread taking the
+// measure and the threads it starts meanwhile (e.g. not the workers of a thread pool made
+// before), in user space only.
+//
+// Usage example:
+// instrumentation::meter meter;
+// ... log n messages ...
+// auto figures = meter.stop();
+// spdlog::info("{}", instrumentation::per_message(figures, n));
+//
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <cstring>
+#endif
+
+#include "spdlog/fmt/fmt.h"
+
+namespace instrumentation {
+
+struct alloc_counters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+};
+
+inline alloc_counters &allocs() {
+    static alloc_counters counters;
+    return counters;
+}
+
+struct figures {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+    bool has_hw = false;  // the hardware counters could be read
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t llc_misses = 0;
+};
+
+// the hardware counters, from construction to read()
+class hw_counters {
+public:
+    hw_counters() {
+#if defined(__linux__)
+        const char *env = std::getenv("SPDLOG_BENCH_PERF");
+        if (env == nullptr || std::string(env) != "1") {
+            return;
+        }
+        const std::uint64_t configs[n] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                          PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < n; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds_[i] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds_[i] < 0) {
+                close_();
+                return;
+            }
+        }
+        for (int fd : fds_) {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    ~hw_counters() { close_(); }
+
+    hw_counters(const hw_counters &) = delete;
+    hw_counters &operator=(const hw_counters &) = delete;
+
+    // false if not enabled or not permitted
+    bool read(figures &result) {
+#if defined(__linux__)
+        if (fds_[0] < 0) {
+            return false;
+        }
+        std::uint64_t values[n] = {};
+        for (int i = 0; i < n; i++) {
+            ::ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (::read(fds_[i], &values[i], sizeof(values[i])) != sizeof(values[i])) {
+                return false;
+            }
+        }
+        result.has_hw = true;
+        result.cycles = values[0];
+        result.instructions = values[1];
+        result.llc_misses = values[2];
+        return true;
+#else
+        (void)result;
+        return false;
+#endif
+    }
+
+private:
+    static constexpr int n = 3;
+    int fds_[n] = {-1, -1, -1};
+
+    void close_() {
+#if defined(__linux__)
+        for (int &fd : fds_) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+#endif
+    }
+};
+
+// the allocations and hardware counters from construction to stop()
+class meter {
+public:
+    meter()
+        : start_allocations_(allocs().allocations.load(std::memory_order_relaxed)),
+          start_bytes_(allocs().bytes.load(std::memory_order_relaxed)) {}
+
+    figures stop() {
+        figures result;
+        hw_.read(result);
+        result.allocations = allocs().allocations.load(std::memory_order_relaxed) -
+                             start_allocations_;
+        result.bytes = allocs().bytes.load(std::memory_order_relaxed) - start_bytes_;
+        return result;
+    }
+
+private:
+    std::uint64_t start_allocations_;
+    std::uint64_t start_bytes_;
+    hw_counters hw_;
+};
+
+inline std::string per_message(const figures &f, std::uint64_t messages) {
+    auto per = [messages](std::uint64_t value) {
+        return messages == 0 ? 0.0 : static_cast<double>(value) / static_cast<double>(messages);
+    };
+    auto text = spdlog::fmt_lib::format("allocs/msg {:.2f} bytes/msg {:.1f}", per(f.allocations),
+                                        per(f.bytes));
+    if (f.has_hw) {
+        text += spdlog::fmt_lib::format(" cycles/msg {:.0f} instr/msg {:.0f} llc-miss/msg {:.3f}",
+                                        per(f.cycles), per(f.instructions), per(f.llc_misses));
+    }
+    return text;
+}
+
+}  // namespace instrumentation
+
+// counting replacements of the global allocation functions (the other forms call these)
+#if defined(__GNUC__) && !defined(__clang__)
+    // free() is the right match of the malloc() above, whatever operator new gcc inlined
+    #pragma GCC diagnostic ignored "-Wpragmas"
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void *operator new(std::size_t size) {
+    auto &counters = instrumentation::allocs();
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+#if defined(__cpp_aligned_new) && !defined(_WIN32)
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    auto &counters = instrumentation::allocs();
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    auto align = static_cast<std::size_t>(alignment);
+    if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
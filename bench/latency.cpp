@@ -39,6 +39,25 @@ void bench_logger(benchmark::State &state, std::shared_ptr<spdlog::logger> logge
         logger->info("Hello logger: msg number {}...............", ++i);
     }
 }
+// the producer side as bench_logger, and the time the messages waited in the queue
+void bench_queue_latency(benchmark::State &state,
+                         std::shared_ptr<spdlog::logger> logger,
+                         std::shared_ptr<spdlog::details::thread_pool> tp) {
+    if (state.thread_index() == 0) {
+        tp->reset_queue_latency();
+    }
+    int i = 0;
+    for (auto _ : state) {
+        logger->info("Hello logger: msg number {}...............", ++i);
+    }
+    if (state.thread_index() == 0) {
+        auto latency = tp->queue_latency();
+        state.counters["queue_p50_ns"] = static_cast<double>(latency.percentile(0.5).count());
+        state.counters["queue_p99_ns"] = static_cast<double>(latency.percentile(0.99).count());
+        state.counters["queue_max_ns"] = static_cast<double>(latency.percentile(1.0).count());
+    }
+}
+
 void bench_global_logger(benchmark::State &state, std::shared_ptr<spdlog::logger> logger) {
     spdlog::set_default_logger(std::move(logger));
     int i = 0;
@@ -215,6 +234,18 @@ int main(int argc, char *argv[]) {
         ->Threads(n_threads)
         ->UseRealTime();
 
+    spdlog::details::thread_pool_options queue_latency_options(queue_size, 1);
+    queue_latency_options.queue_latency = true;
+    auto queue_latency_tp =
+        std::make_shared<spdlog::details::thread_pool>(std::move(queue_latency_options));
+    auto async_logger_queue = std::make_shared<spdlog::async_logger>(
+        "async_logger_queue", std::make_shared<null_sink_mt>(), queue_latency_tp,
+        spdlog::async_overflow_policy::overrun_oldest);
+    benchmark::RegisterBenchmark("async_logger/queue_latency", bench_queue_latency,
+                                 async_logger_queue, queue_latency_tp)
+        ->Threads(n_threads)
+        ->UseRealTime();
+
     benchmark::Initialize(&argc, argv);
     benchmark::RunSpecifiedBenchmarks();
 }
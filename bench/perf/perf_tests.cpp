@@ -0,0 +1,210 @@
+//
+// Copyright(c) 2015 Gabi Melman.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+//
+
+//
+// perf_tests.cpp : performance regression tests of the hot paths
+//
+// Each scenario logs (or formats) a fixed number of messages a few times, after a warmup. The
+// best rate of the runs is compared with the scenario's rate in the baseline file, and the
+// allocations of the runs with the scenario's budget (zero where spdlog promises none). The
+// test fails if a scenario allocates more than its budget, or if its rate is below
+// (1 - tolerance) times its baseline. A scenario missing from the baseline only checks its
+// allocations.
+//
+// The rates depend on the machine and the build type: record the baseline of the machine
+// running the tests with --update (or the spdlog-perf-baseline target), in a release build.
+//
+// Usage: spdlog-perf-tests <baseline file> [--update] [--tolerance 0.3]
+//
+
+#include "spdlog/spdlog.h"
+#include "spdlog/async.h"
+#include "spdlog/json_formatter.h"
+#include "spdlog/pattern_formatter.h"
+#include "spdlog/sinks/null_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../instrumentation.h"
+
+using std::chrono::steady_clock;
+
+struct scenario {
+    std::string name;
+    int messages;                  // per run
+    std::uint64_t alloc_budget;    // allocations allowed per run
+    std::function<void(int)> run;  // logs or formats n messages
+    std::function<void()> finish;  // waits for the messages of a run to be processed
+};
+
+struct result {
+    double rate = 0;  // messages per second, the best run
+    std::uint64_t allocations = 0;
+};
+
+static constexpr int runs_n = 5;
+
+result measure(const scenario &s) {
+    s.run(s.messages / 10);  // warmup, e.g. the formatters' caches and the queue's slots
+    if (s.finish) {
+        s.finish();
+    }
+    result r;
+    instrumentation::meter meter;
+    for (int i = 0; i < runs_n; i++) {
+        auto start = steady_clock::now();
+        s.run(s.messages);
+        if (s.finish) {
+            s.finish();
+        }
+        auto seconds = std::chrono::duration<double>(steady_clock::now() - start).count();
+        r.rate = (std::max)(r.rate, s.messages / seconds);
+    }
+    r.allocations = meter.stop().allocations;
+    return r;
+}
+
+std::vector<scenario> make_scenarios() {
+    std::vector<scenario> scenarios;
+
+    auto sync_logger = std::make_shared<spdlog::logger>(
+        "perf-sync", std::make_shared<spdlog::sinks::null_sink_mt>());
+    scenarios.push_back(scenario{"sync_null_sink", 1000000, 0,
+                                 [sync_logger](int n) {
+                                     for (int i = 0; i < n; i++) {
+                                         sync_logger->info("Hello logger: msg number {}", i);
+                                     }
+                                 },
+                                 nullptr});
+
+    auto tp = std::make_shared<spdlog::details::thread_pool>(8192, 1);
+    auto async_logger = std::make_shared<spdlog::async_logger>(
+        "perf-async", std::make_shared<spdlog::sinks::null_sink_mt>(), tp,
+        spdlog::async_overflow_policy::block);
+    // drain_logger() allocates the ids of its barriers
+    scenarios.push_back(scenario{"async_null_sink", 1000000, 1,
+                                 [async_logger](int n) {
+                                     for (int i = 0; i < n; i++) {
+                                         async_logger->info("Hello logger: msg number {}", i);
+                                     }
+                                 },
+                                 [tp, async_logger] { tp->drain_logger(*async_logger); }});
+
+    // a message of the default pattern's fields, with a source location for the json one
+    auto msg = std::make_shared<spdlog::details::log_msg>(
+        spdlog::source_loc{"a/b/c/d/myfile.cpp", 123, "some_func()"}, "perf-formatter",
+        spdlog::level::info, "Hello. This is some message with length of 50......");
+    msg->time = spdlog::log_clock::now();
+    auto dest = std::make_shared<spdlog::memory_buf_t>();
+
+    std::shared_ptr<spdlog::formatter> pattern = std::make_shared<spdlog::pattern_formatter>();
+    scenarios.push_back(scenario{"default_pattern", 1000000, 0,
+                                 [pattern, msg, dest](int n) {
+                                     for (int i = 0; i < n; i++) {
+                                         dest->clear();
+                                         pattern->format(*msg, *dest);
+                                     }
+                                 },
+                                 nullptr});
+
+    std::shared_ptr<spdlog::formatter> json = std::make_shared<spdlog::json_formatter>();
+    scenarios.push_back(scenario{"json_formatter", 1000000, 0,
+                                 [json, msg, dest](int n) {
+                                     for (int i = 0; i < n; i++) {
+                                         dest->clear();
+                                         json->format(*msg, *dest);
+                                     }
+                                 },
+                                 nullptr});
+    return scenarios;
+}
+
+// "name rate" lines, '#' starting a comment
+std::map<std::string, double> load_baseline(const std::string &filename) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(filename);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string name;
+        double rate = 0;
+        if (fields >> name >> rate) {
+            baseline[name] = rate;
+        }
+    }
+    return baseline;
+}
+
+bool save_baseline(const std::string &filename, const std::vector<scenario> &scenarios,
+                   const std::vector<result> &results) {
+    std::ofstream out(filename);
+    out << "# messages per second of the spdlog-perf-tests scenarios, the best of " << runs_n
+        << " runs\n";
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        out << scenarios[i].name << ' ' << static_cast<std::uint64_t>(results[i].rate) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char *argv[]) {
+    std::string baseline_file;
+    bool update = false;
+    double tolerance = 0.3;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = std::atof(argv[++i]);
+        } else {
+            baseline_file = argv[i];
+        }
+    }
+    if (baseline_file.empty()) {
+        std::fprintf(stderr, "Usage: %s <baseline file> [--update] [--tolerance 0.3]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    auto scenarios = make_scenarios();
+    auto baseline = load_baseline(baseline_file);
+    std::vector<result> results;
+    int failures = 0;
+    for (auto &s : scenarios) {
+        auto r = measure(s);
+        results.push_back(r);
+        std::string verdict = "ok";
+        if (r.allocations > s.alloc_budget * runs_n) {
+            verdict = spdlog::fmt_lib::format("FAILED: {} allocations, budget {}", r.allocations,
+                                              s.alloc_budget * runs_n);
+        } else if (!update && baseline.count(s.name) &&
+                   r.rate < baseline[s.name] * (1 - tolerance)) {
+            verdict = spdlog::fmt_lib::format("FAILED: {:.0f}% of the baseline {:.0f} msg/sec",
+                                              100 * r.rate / baseline[s.name], baseline[s.name]);
+        }
+        failures += verdict == "ok" ? 0 : 1;
+        std::printf("%-16s %12.0f msg/sec %10llu allocs  %s\n", s.name.c_str(), r.rate,
+                    static_cast<unsigned long long>(r.allocations), verdict.c_str());
+    }
+
+    if (update) {
+        if (!save_baseline(baseline_file, scenarios, results)) {
+            std::fprintf(stderr, "Failed writing %s\n", baseline_file.c_str());
+            return 2;
+        }
+        std::printf("Baseline written to %s\n", baseline_file.c_str());
+    }
+    return failures == 0 ? 0 : 1;
+}
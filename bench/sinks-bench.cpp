@@ -0,0 +1,238 @@
+//
+// Copyright(c) 2015 Gabi Melman.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+//
+
+//
+// sinks-bench.cpp : benchmarks of each sink type, through a sync logger and an async one, from
+// 1 to N threads. the console sinks write to the null device, the tcp and udp sinks to a local
+// server discarding what it receives.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "spdlog/spdlog.h"
+#include "spdlog/async.h"
+#include "spdlog/sinks/ansicolor_sink.h"
+#include "spdlog/sinks/callback_sink.h"
+#include "spdlog/sinks/dist_sink.h"
+#include "spdlog/sinks/dup_filter_sink.h"
+#include "spdlog/sinks/null_sink.h"
+#include "spdlog/sinks/ringbuffer_sink.h"
+#include "spdlog/sinks/stdout_sinks.h"
+
+#ifndef _WIN32
+    #include "spdlog/sinks/tcp_sink.h"
+    #include "spdlog/sinks/udp_sink.h"
+
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+void bench_logger(benchmark::State &state, std::shared_ptr<spdlog::logger> logger) {
+    int i = 0;
+    for (auto _ : state) {
+        logger->info("Hello logger: msg number {}...............", ++i);
+    }
+}
+
+// the same message over and over (what dup_filter_sink skips)
+void bench_same_message(benchmark::State &state, std::shared_ptr<spdlog::logger> logger) {
+    for (auto _ : state) {
+        logger->info("Hello logger: the same message...............");
+    }
+}
+
+#ifndef _WIN32
+// local server reading and discarding the messages (a tcp connection per sink, or datagrams)
+class discard_server {
+public:
+    explicit discard_server(int type)
+        : fd_(::socket(AF_INET, type, 0)),
+          tcp_(type == SOCK_STREAM) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ::bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        if (tcp_) {
+            ::listen(fd_, 16);
+            threads_.emplace_back([this] { accept_loop_(); });
+        } else {
+            threads_.emplace_back([this] { read_loop_(fd_); });
+        }
+    }
+
+    // the threads are left running until the process exits
+    ~discard_server() {
+        for (auto &thread : threads_) {
+            thread.detach();
+        }
+    }
+
+    discard_server(const discard_server &) = delete;
+    discard_server &operator=(const discard_server &) = delete;
+
+    int port() const { return port_; }
+
+private:
+    int fd_;
+    bool tcp_;
+    int port_ = 0;
+    std::vector<std::thread> threads_;
+
+    void accept_loop_() {
+        for (;;) {
+            int client = ::accept(fd_, nullptr, nullptr);
+            if (client < 0) {
+                return;
+            }
+            std::thread([this, client] {
+                read_loop_(client);
+                ::close(client);
+            }).detach();
+        }
+    }
+
+    // until the connection is closed (tcp), or forever (udp)
+    void read_loop_(int fd) {
+        char buf[65536];
+        for (;;) {
+            auto n = ::recv(fd, buf, sizeof(buf), 0);
+            if (tcp_ && n <= 0) {
+                return;
+            }
+        }
+    }
+};
+#endif
+
+// register the benchmarks of the sink made by make_sink, through a sync logger and an async
+// one
+void register_sink(const std::string &name,
+                   const std::function<spdlog::sink_ptr()> &make_sink,
+                   const std::shared_ptr<spdlog::details::thread_pool> &tp,
+                   int n_threads,
+                   void (*bench)(benchmark::State &, std::shared_ptr<spdlog::logger>) =
+                       bench_logger) {
+    auto sync_logger = std::make_shared<spdlog::logger>(name, make_sink());
+    benchmark::RegisterBenchmark(name.c_str(), bench, sync_logger)
+        ->ThreadRange(1, n_threads)
+        ->UseRealTime();
+
+    auto async_logger = std::make_shared<spdlog::async_logger>(
+        name + "/async", make_sink(), tp, spdlog::async_overflow_policy::block);
+    benchmark::RegisterBenchmark((name + "/async").c_str(), bench, async_logger)
+        ->ThreadRange(1, n_threads)
+        ->UseRealTime();
+}
+
+int main(int argc, char *argv[]) {
+    using namespace spdlog::sinks;
+    int n_threads = benchmark::CPUInfo::Get().num_cpus;
+    auto tp = std::make_shared<spdlog::details::thread_pool>(8192, 1);
+
+#ifdef _WIN32
+    const char *null_device = "NUL";
+#else
+    const char *null_device = "/dev/null";
+#endif
+    // leaked: the sinks use it until the process exits
+    FILE *null_file = std::fopen(null_device, "w");
+    if (null_file == nullptr) {
+        std::perror("sinks-bench: null device");
+        return 1;
+    }
+
+    register_sink("null_sink", [] { return std::make_shared<null_sink_mt>(); }, tp, n_threads);
+
+    register_sink(
+        "ansicolor_sink",
+        [null_file] {
+            return std::make_shared<ansicolor_sink<spdlog::details::console_mutex>>(
+                null_file, spdlog::color_mode::always);
+        },
+        tp, n_threads);
+
+    register_sink(
+        "stdout_sink",
+        [null_file] {
+            return std::make_shared<stdout_sink_base<spdlog::details::console_mutex>>(null_file);
+        },
+        tp, n_threads);
+
+    register_sink(
+        "dup_filter_sink",
+        [] {
+            auto sink = std::make_shared<dup_filter_sink_mt>(std::chrono::seconds(5));
+            sink->add_sink(std::make_shared<null_sink_mt>());
+            return sink;
+        },
+        tp, n_threads);
+    register_sink(
+        "dup_filter_sink/same_message",
+        [] {
+            auto sink = std::make_shared<dup_filter_sink_mt>(std::chrono::seconds(5));
+            sink->add_sink(std::make_shared<null_sink_mt>());
+            return sink;
+        },
+        tp, n_threads, bench_same_message);
+
+    register_sink("ringbuffer_sink", [] { return std::make_shared<ringbuffer_sink_mt>(1024); },
+                  tp, n_threads);
+
+    register_sink(
+        "dist_sink",
+        [] {
+            return std::make_shared<dist_sink_mt>(std::vector<spdlog::sink_ptr>{
+                std::make_shared<null_sink_mt>(), std::make_shared<null_sink_mt>()});
+        },
+        tp, n_threads);
+
+    std::atomic<size_t> callback_bytes{0};
+    register_sink(
+        "callback_sink",
+        [&callback_bytes] {
+            return std::make_shared<callback_sink_mt>(
+                [&callback_bytes](const spdlog::details::log_msg &msg) {
+                    callback_bytes.fetch_add(msg.payload.size(), std::memory_order_relaxed);
+                });
+        },
+        tp, n_threads);
+
+#ifndef _WIN32
+    discard_server tcp_server(SOCK_STREAM);
+    register_sink(
+        "tcp_sink",
+        [&tcp_server] {
+            tcp_sink_config config("127.0.0.1", tcp_server.port());
+            return std::make_shared<tcp_sink_mt>(config);
+        },
+        tp, n_threads);
+
+    discard_server udp_server(SOCK_DGRAM);
+    register_sink(
+        "udp_sink",
+        [&udp_server] {
+            udp_sink_config config("127.0.0.1", static_cast<uint16_t>(udp_server.port()));
+            return std::make_shared<udp_sink_mt>(config);
+        },
+        tp, n_threads);
+#endif
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
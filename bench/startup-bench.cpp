@@ -0,0 +1,175 @@
+//
+// Copyright(c) 2015 Gabi Melman.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+//
+
+//
+// startup-bench.cpp : cost of creating the loggers at startup: the time to the first message of
+// a new logger, the creation of a logger from an already made sink, and the steps it is made of
+// (the formatter, the registration and the levels from the environment).
+//
+
+#include "benchmark/benchmark.h"
+
+#include "spdlog/spdlog.h"
+#include "spdlog/cfg/helpers.h"
+#include "spdlog/logger_ref.h"
+#include "spdlog/pattern_formatter.h"
+#include "spdlog/sinks/null_sink.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// names made before the benches, so that formatting them isn't measured
+std::vector<std::string> logger_names(size_t n) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < n; i++) {
+        names.push_back("app.module" + std::to_string(i % 16) + ".logger" + std::to_string(i));
+    }
+    return names;
+}
+
+// the loggers are dropped every names.size() iterations (not measured)
+template <typename Create>
+void run_creations(benchmark::State &state, Create create) {
+    auto names = logger_names(static_cast<size_t>(state.range(0)));
+    size_t i = 0;
+    for (auto _ : state) {
+        create(names[i]);
+        if (++i == names.size()) {
+            state.PauseTiming();
+            spdlog::drop_all();
+            i = 0;
+            state.ResumeTiming();
+        }
+    }
+    spdlog::drop_all();
+}
+
+// a new logger with its own sink, registered, and its first message
+void bench_time_to_first_log(benchmark::State &state) {
+    run_creations(state, [](const std::string &name) {
+        auto logger = spdlog::create<spdlog::sinks::null_sink_mt>(name);
+        logger->info("Hello logger: first message {}", 1);
+    });
+}
+
+// a logger of an already made sink, registered
+void bench_create_from_sink(benchmark::State &state) {
+    auto sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+    run_creations(state, [&sink](const std::string &name) {
+        spdlog::initialize_logger(std::make_shared<spdlog::logger>(name, sink));
+    });
+}
+
+// all the loggers of a sink at once, each iteration creating state.range(0) loggers
+void bench_create_many(benchmark::State &state) {
+    auto names = logger_names(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto loggers = spdlog::create_many<spdlog::sinks::null_sink_mt>(names);
+        benchmark::DoNotOptimize(loggers);
+        state.PauseTiming();
+        loggers.clear();
+        spdlog::drop_all();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// one by one, for comparison with create_many
+void bench_create_each(benchmark::State &state) {
+    auto names = logger_names(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+        for (const auto &name : names) {
+            spdlog::initialize_logger(std::make_shared<spdlog::logger>(name, sink));
+        }
+        state.PauseTiming();
+        spdlog::drop_all();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// registered (without the formatter and levels of initialize_logger)
+void bench_register(benchmark::State &state) {
+    auto sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+    run_creations(state, [&sink](const std::string &name) {
+        spdlog::register_logger(std::make_shared<spdlog::logger>(name, sink));
+    });
+}
+
+// looking up a logger by name among state.range(0) ones
+void bench_get(benchmark::State &state) {
+    auto names = logger_names(static_cast<size_t>(state.range(0)));
+    spdlog::create_many<spdlog::sinks::null_sink_mt>(names);
+    for (auto _ : state) {
+        auto logger = spdlog::get(names[0]);
+        benchmark::DoNotOptimize(logger);
+    }
+    spdlog::drop_all();
+}
+
+void bench_logger_ref(benchmark::State &state) {
+    auto names = logger_names(static_cast<size_t>(state.range(0)));
+    spdlog::create_many<spdlog::sinks::null_sink_mt>(names);
+    spdlog::logger_ref ref(names[0]);
+    for (auto _ : state) {
+        auto *logger = ref.get();
+        benchmark::DoNotOptimize(logger);
+    }
+    spdlog::drop_all();
+}
+
+void bench_default_formatter(benchmark::State &state) {
+    for (auto _ : state) {
+        auto formatter = spdlog::details::make_unique<spdlog::pattern_formatter>();
+        benchmark::DoNotOptimize(formatter);
+    }
+}
+
+void bench_formatter_clone(benchmark::State &state) {
+    spdlog::pattern_formatter formatter("[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] [%s:%#] %v");
+    for (auto _ : state) {
+        auto cloned = formatter.clone();
+        benchmark::DoNotOptimize(cloned);
+    }
+}
+
+void bench_pattern_compile(benchmark::State &state) {
+    for (auto _ : state) {
+        spdlog::pattern_formatter formatter("[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] [%s:%#] %v");
+        benchmark::DoNotOptimize(formatter);
+    }
+}
+
+// what SPDLOG_LEVEL typically holds
+void bench_load_levels(benchmark::State &state) {
+    const std::string levels = "warn,app.module1=debug,app.module2=trace,net=info,db=err";
+    for (auto _ : state) {
+        spdlog::cfg::helpers::load_levels(levels);
+    }
+    spdlog::set_level(spdlog::level::info);
+}
+
+int main(int argc, char *argv[]) {
+    spdlog::set_automatic_registration(true);
+    // up to the number of loggers registered at once
+    benchmark::RegisterBenchmark("time_to_first_log", bench_time_to_first_log)
+        ->Arg(16)
+        ->Arg(128);
+    benchmark::RegisterBenchmark("create_from_sink", bench_create_from_sink)->Arg(16)->Arg(128);
+    benchmark::RegisterBenchmark("register", bench_register)->Arg(16)->Arg(128);
+    benchmark::RegisterBenchmark("create_many", bench_create_many)->Arg(128)->Arg(10000);
+    benchmark::RegisterBenchmark("create_each", bench_create_each)->Arg(128)->Arg(10000);
+    benchmark::RegisterBenchmark("get", bench_get)->Arg(16)->Arg(10000);
+    benchmark::RegisterBenchmark("logger_ref", bench_logger_ref)->Arg(16)->Arg(10000);
+    benchmark::RegisterBenchmark("default_formatter", bench_default_formatter);
+    benchmark::RegisterBenchmark("formatter_clone", bench_formatter_clone);
+    benchmark::RegisterBenchmark("pattern_compile", bench_pattern_compile);
+    benchmark::RegisterBenchmark("load_levels", bench_load_levels);
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
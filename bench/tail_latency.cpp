@@ -0,0 +1,143 @@
+//
+// Copyright(c) 2015 Gabi Melman.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+//
+
+//
+// tail_latency.cpp : latency percentiles of the log calls at a fixed target rate
+//
+// Each thread logs at the given rate. A call is timed from when it was due (start time +
+// i * period), not from when it actually started: a stall then counts in the latency of all
+// the calls it delayed, instead of in a single sample (coordinated omission). The
+// uncorrected p99.9 is printed along for comparison.
+//
+// Usage: tail_latency [messages per second per thread] [seconds] [threads]
+//
+
+#include "spdlog/spdlog.h"
+#include "spdlog/async.h"
+#include "spdlog/details/latency_histogram.h"
+#include "spdlog/sinks/basic_file_sink.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::chrono::steady_clock;
+
+struct run_options {
+    long rate;  // per thread
+    std::chrono::milliseconds duration;
+    int threads;
+};
+
+struct run_result {
+    spdlog::latency_snapshot corrected;
+    spdlog::latency_snapshot raw;
+};
+
+run_result run(const std::shared_ptr<spdlog::logger> &logger, const run_options &options) {
+    spdlog::details::latency_histogram corrected;
+    spdlog::details::latency_histogram raw;
+    auto period = std::chrono::nanoseconds(1000000000 / options.rate);
+    auto calls = static_cast<long>(options.duration / period);
+    auto start = steady_clock::now() + std::chrono::milliseconds(10);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; t++) {
+        threads.emplace_back([&] {
+            for (long i = 0; i < calls; i++) {
+                auto due = start + i * period;
+                auto now = steady_clock::now();
+                while (now < due) {
+                    now = steady_clock::now();
+                }
+                logger->info("Hello logger: msg number {}...............", i);
+                auto end = steady_clock::now();
+                corrected.record(end - due);
+                raw.record(end - now);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    return run_result{corrected.snapshot(), raw.snapshot()};
+}
+
+void report(const std::string &name, const run_result &result, size_t dropped) {
+    auto us = [](std::chrono::nanoseconds d) { return static_cast<double>(d.count()) / 1000.0; };
+    auto &c = result.corrected;
+    spdlog::info(
+        "{:<36} p50 {:>9.1f}us  p99 {:>9.1f}us  p99.9 {:>9.1f}us  max {:>9.1f}us  "
+        "(uncorrected p99.9 {:>7.1f}us, dropped {})",
+        name, us(c.percentile(0.5)), us(c.percentile(0.99)), us(c.percentile(0.999)),
+        us(c.percentile(1.0)), us(result.raw.percentile(0.999)), dropped);
+}
+
+int main(int argc, char *argv[]) {
+    run_options options{100000, std::chrono::seconds(2), 2};
+    if (argc > 1) options.rate = std::atol(argv[1]);
+    if (argc > 2) options.duration = std::chrono::seconds(std::atol(argv[2]));
+    if (argc > 3) options.threads = std::atoi(argv[3]);
+    if (options.rate <= 0 || options.rate > 1000000000 || options.threads <= 0) {
+        spdlog::error("Usage: tail_latency [messages per second per thread] [seconds] [threads]");
+        return EXIT_FAILURE;
+    }
+
+    spdlog::info("{} threads, {} messages per second each, {} seconds per run", options.threads,
+                 options.rate, options.duration.count() / 1000);
+    spdlog::info("");
+    const char *filename = "logs/tail_latency.log";
+
+    {
+        auto logger = spdlog::basic_logger_mt("sync", filename, true);
+        report("sync", run(logger, options), 0);
+        spdlog::drop("sync");
+    }
+
+    struct queue_choice {
+        const char *name;
+        spdlog::async_queue_type type;
+    };
+    const queue_choice queues[] = {
+        {"blocking", spdlog::async_queue_type::blocking},
+        {"lock_free", spdlog::async_queue_type::lock_free},
+#ifndef SPDLOG_NO_TLS
+        {"per_thread", spdlog::async_queue_type::per_thread},
+#endif
+        {"priority_lanes", spdlog::async_queue_type::priority_lanes},
+    };
+    struct policy_choice {
+        const char *name;
+        spdlog::async_overflow_policy policy;
+    };
+    const policy_choice policies[] = {
+        {"block", spdlog::async_overflow_policy::block},
+        {"overrun_oldest", spdlog::async_overflow_policy::overrun_oldest},
+        {"discard_new", spdlog::async_overflow_policy::discard_new},
+        {"sample", spdlog::async_overflow_policy::sample},
+    };
+
+    for (auto &queue : queues) {
+        for (auto &policy : policies) {
+            spdlog::details::thread_pool_options pool_options(8192, 1);
+            pool_options.queue_type = queue.type;
+            auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(pool_options));
+            auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename, true);
+            auto logger =
+                std::make_shared<spdlog::async_logger>("async", sink, tp, policy.policy);
+            auto result = run(logger, options);
+            // wait for the queue to drain before the next run
+            logger.reset();
+            auto dropped =
+                tp->overrun_counter() + tp->discard_counter() + tp->sampled_out_counter();
+            tp.reset();
+            report(std::string("async/") + queue.name + "/" + policy.name, result, dropped);
+        }
+    }
+    return EXIT_SUCCESS;
+}
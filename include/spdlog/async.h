@@ -18,9 +18,13 @@
 #include <spdlog/details/registry.h>
 #include <spdlog/details/thread_pool.h>
 
+#include <chrono>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace spdlog {
 
@@ -47,12 +51,37 @@ struct async_factory_impl {
             registry_inst.set_tp(tp);
         }
 
-        auto sink = std::make_shared<Sink>(std::forward<SinkArgs>(args)...);
+        auto sink = registry_inst.make_sink<Sink>(std::forward<SinkArgs>(args)...);
         auto new_logger = std::make_shared<async_logger>(std::move(logger_name), std::move(sink),
                                                          std::move(tp), OverflowPolicy);
         registry_inst.initialize_logger(new_logger);
         return new_logger;
     }
+
+    // loggers of a single sink, registered at once
+    template <typename Sink, typename... SinkArgs>
+    static std::vector<std::shared_ptr<spdlog::logger>> create_many(
+        const std::vector<std::string> &logger_names, SinkArgs &&...args) {
+        auto &registry_inst = details::registry::instance();
+
+        auto &mutex = registry_inst.tp_mutex();
+        std::lock_guard<std::recursive_mutex> tp_lock(mutex);
+        auto tp = registry_inst.get_tp();
+        if (tp == nullptr) {
+            tp = std::make_shared<details::thread_pool>(details::default_async_q_size, 1U);
+            registry_inst.set_tp(tp);
+        }
+
+        auto sink = registry_inst.make_sink<Sink>(std::forward<SinkArgs>(args)...);
+        std::vector<std::shared_ptr<spdlog::logger>> new_loggers;
+        new_loggers.reserve(logger_names.size());
+        for (const auto &logger_name : logger_names) {
+            new_loggers.push_back(
+                std::make_shared<async_logger>(logger_name, sink, tp, OverflowPolicy));
+        }
+        registry_inst.initialize_loggers(new_loggers);
+        return new_loggers;
+    }
 };
 
 using async_factory = async_factory_impl<async_overflow_policy::block>;
@@ -93,8 +122,39 @@ inline void init_thread_pool(size_t q_size, size_t thread_count) {
         q_size, thread_count, [] {}, [] {});
 }
 
+// set global thread pool with the given options (e.g. to select the lock free queue).
+inline void init_thread_pool(details::thread_pool_options options) {
+    auto tp = std::make_shared<details::thread_pool>(std::move(options));
+    details::registry::instance().set_tp(std::move(tp));
+}
+
 // get the global thread pool.
 inline std::shared_ptr<spdlog::details::thread_pool> thread_pool() {
     return details::registry::instance().get_tp();
 }
+
+// process at most max_msgs messages of the global thread pool, if it was created with
+// thread_pool_options::polled (see thread_pool::poll()). return the number processed.
+inline size_t poll(size_t max_msgs = (std::numeric_limits<size_t>::max)()) {
+    auto tp = thread_pool();
+    return tp ? tp->poll(max_msgs) : 0;
+}
+
+// eventfd readable while the global polled thread pool has messages to process, -1 if none.
+inline int poll_fd() {
+    auto tp = thread_pool();
+    return tp ? tp->poll_fd() : -1;
+}
+
+// same as spdlog::shutdown(), but give the global thread pool at most timeout to process the
+// queued messages, skipping those below warn in the second half of it (see
+// thread_pool::shutdown()). return the number of messages abandoned.
+inline size_t shutdown(std::chrono::milliseconds timeout) {
+    size_t abandoned = 0;
+    if (auto tp = thread_pool()) {
+        abandoned = tp->shutdown(timeout);
+    }
+    details::registry::instance().shutdown();
+    return abandoned;
+}
 }  // namespace spdlog
@@ -30,22 +30,111 @@ SPDLOG_INLINE spdlog::async_logger::async_logger(std::string logger_name,
     : async_logger(
           std::move(logger_name), {std::move(single_sink)}, std::move(tp), overflow_policy) {}
 
+// the clone keeps the settings but starts with no queued message and zero counters
+SPDLOG_INLINE spdlog::async_logger::async_logger(const async_logger &other)
+    : std::enable_shared_from_this<async_logger>(),
+      logger(other),
+      thread_pool_(other.thread_pool_),
+      overflow_policy_(other.overflow_policy_),
+      queue_quota_(other.queue_quota_),
+      sync_level_(other.sync_level_.load(std::memory_order_relaxed)) {}
+
 // send the log message to the thread pool
-SPDLOG_INLINE void spdlog::async_logger::sink_it_(const details::log_msg &msg){
-    SPDLOG_TRY{if (auto pool_ptr = thread_pool_.lock()){
-        pool_ptr->post_log(shared_from_this(), msg, overflow_policy_);
+SPDLOG_INLINE void spdlog::async_logger::sink_it_(const details::log_msg &msg) {
+    if (sink_sync_(msg)) {
+        return;
+    }
+    SPDLOG_TRY {
+        if (auto pool_ptr = thread_pool_.lock()) {
+            pool_ptr->post_log(*this, msg, overflow_policy_);
+        } else {
+            throw_spdlog_ex("async log: thread pool doesn't exist anymore");
+        }
+    }
+    SPDLOG_LOGGER_CATCH(msg.source)
 }
-else {
-    throw_spdlog_ex("async log: thread pool doesn't exist anymore");
+
+SPDLOG_INLINE spdlog::async_logger::~async_logger() {
+    SPDLOG_TRY {
+        if (auto pool_ptr = thread_pool_.lock()) {
+            pool_ptr->drain_logger(*this);
+        }
+    }
+    SPDLOG_CATCH_STD
+}
+
+SPDLOG_INLINE void spdlog::async_logger::set_deferred_formatting(bool deferred) {
+    deferred_formatting_ = deferred;
+}
+
+SPDLOG_INLINE void spdlog::async_logger::set_queue_quota(size_t max_messages) {
+    queue_quota_ = max_messages;
+}
+
+SPDLOG_INLINE size_t spdlog::async_logger::queue_quota() const { return queue_quota_; }
+
+SPDLOG_INLINE size_t spdlog::async_logger::overrun_counter() const {
+    return overrun_counter_.load(std::memory_order_relaxed);
+}
+
+SPDLOG_INLINE void spdlog::async_logger::reset_overrun_counter() {
+    overrun_counter_.store(0, std::memory_order_relaxed);
+}
+
+SPDLOG_INLINE void spdlog::async_logger::set_sync_level(level::level_enum log_level) {
+    sync_level_.store(log_level, std::memory_order_relaxed);
+}
+
+SPDLOG_INLINE spdlog::level::level_enum spdlog::async_logger::sync_level() const {
+    return static_cast<level::level_enum>(sync_level_.load(std::memory_order_relaxed));
 }
+
+// the sinks lock against the worker, which may be logging the messages queued before
+SPDLOG_INLINE bool spdlog::async_logger::sink_sync_(const details::log_msg &msg) {
+    auto sync_level = sync_level_.load(std::memory_order_relaxed);
+    if (sync_level == level::off || msg.level < sync_level || msg.level == level::off) {
+        return false;
+    }
+    if (msg.tsc_time) {
+        details::log_msg resolved(msg);
+        resolved.resolve_time();
+        backend_sink_it_(resolved);
+    } else {
+        backend_sink_it_(msg);
+    }
+    if (!should_flush_(msg)) {
+        backend_flush_();
+    }
+    return true;
 }
-SPDLOG_LOGGER_CATCH(msg.source)
+
+// send the packed arguments to the thread pool, to be formatted there
+SPDLOG_INLINE void spdlog::async_logger::sink_deferred_(const details::log_msg &msg,
+                                                        details::deferred_format_fn format_fn) {
+    SPDLOG_TRY {
+        auto sync_level = sync_level_.load(std::memory_order_relaxed);
+        if (sync_level != level::off && msg.level >= sync_level) {
+            memory_buf_t formatted;
+            format_fn(msg.payload, formatted);
+            details::log_msg formatted_msg(msg);
+            formatted_msg.payload = string_view_t(formatted.data(), formatted.size());
+            formatted_msg.static_payload = false;
+            sink_sync_(formatted_msg);
+            return;
+        }
+        if (auto pool_ptr = thread_pool_.lock()) {
+            pool_ptr->post_log(*this, msg, overflow_policy_, format_fn);
+        } else {
+            throw_spdlog_ex("async log: thread pool doesn't exist anymore");
+        }
+    }
+    SPDLOG_LOGGER_CATCH(msg.source)
 }
 
 // send flush request to the thread pool
 SPDLOG_INLINE void spdlog::async_logger::flush_(){
     SPDLOG_TRY{if (auto pool_ptr = thread_pool_.lock()){
-        pool_ptr->post_flush(shared_from_this(), overflow_policy_);
+        pool_ptr->post_flush(*this, overflow_policy_);
 }
 else {
     throw_spdlog_ex("async flush: thread pool doesn't exist anymore");
@@ -58,10 +147,19 @@ SPDLOG_LOGGER_CATCH(source_loc())
 // backend functions - called from the thread pool to do the actual job
 //
 SPDLOG_INLINE void spdlog::async_logger::backend_sink_it_(const details::log_msg &msg) {
-    for (auto &sink : sinks_) {
-        if (sink->should_log(msg.level)) {
+    using details::logger_metrics;
+    auto *metrics = metrics_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < sinks_.size(); i++) {
+        auto &sink = sinks_[i];
+        if (sink->should_log(msg)) {
+            auto *write_time = metrics != nullptr ? metrics->write_time(i, sink.get()) : nullptr;
+            auto start = write_time != nullptr ? logger_metrics::clock::now()
+                                               : logger_metrics::clock::time_point{};
             SPDLOG_TRY { sink->log(msg); }
-            SPDLOG_LOGGER_CATCH(msg.source)
+            SPDLOG_SINK_CATCH(*sink, msg.source)
+            if (write_time != nullptr) {
+                write_time->record(logger_metrics::clock::now() - start);
+            }
         }
     }
 
@@ -70,10 +168,59 @@ SPDLOG_INLINE void spdlog::async_logger::backend_sink_it_(const details::log_msg
     }
 }
 
+// sink a batch of consecutive messages of this logger, so each sink is locked once.
+// flush once at the end if any of them should trigger a flush.
+// the metrics get the mean write time of the batch for each of its messages.
+SPDLOG_INLINE void spdlog::async_logger::backend_sink_batch_(const details::log_msg *msgs,
+                                                             size_t count) {
+    using details::logger_metrics;
+    auto *metrics = metrics_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < sinks_.size(); i++) {
+        auto &sink = sinks_[i];
+        auto *write_time = metrics != nullptr ? metrics->write_time(i, sink.get()) : nullptr;
+        auto start = write_time != nullptr ? logger_metrics::clock::now()
+                                           : logger_metrics::clock::time_point{};
+        SPDLOG_TRY { sink->log_batch(msgs, count); }
+        SPDLOG_SINK_CATCH(*sink, source_loc())
+        if (write_time != nullptr && count > 0) {
+            auto elapsed = logger_metrics::clock::now() - start;
+            write_time->record(elapsed / static_cast<logger_metrics::clock::rep>(count), count);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (should_flush_(msgs[i])) {
+            backend_flush_();
+            break;
+        }
+    }
+}
+
+SPDLOG_INLINE bool spdlog::async_logger::backend_format_(details::async_msg &msg) {
+    msg.resolve_time();
+    SPDLOG_TRY {
+        auto *metrics = metrics_.load(std::memory_order_acquire);
+        if (metrics == nullptr || msg.format_fn == nullptr) {
+            msg.format_deferred();
+            return true;
+        }
+        auto start = details::logger_metrics::clock::now();
+        msg.format_deferred();
+        metrics->record_format(details::logger_metrics::clock::now() - start);
+        metrics->add_bytes(msg.payload.size());
+        return true;
+    }
+    SPDLOG_LOGGER_CATCH(msg.source)
+    return false;
+}
+
 SPDLOG_INLINE void spdlog::async_logger::backend_flush_() {
     for (auto &sink : sinks_) {
+        if (sink->suspended()) {
+            continue;
+        }
         SPDLOG_TRY { sink->flush(); }
-        SPDLOG_LOGGER_CATCH(source_loc())
+        SPDLOG_SINK_CATCH(*sink, source_loc())
     }
 }
 
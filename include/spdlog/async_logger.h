@@ -16,6 +16,13 @@
 
 #include <spdlog/logger.h>
 
+#include <atomic>
+
+// C++20 coroutines: the async_log() family below
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+    #define SPDLOG_HAS_COROUTINES
+#endif
+
 namespace spdlog {
 
 // Async overflow policy - block by default.
@@ -23,16 +30,36 @@ enum class async_overflow_policy {
     block,           // Block until message can be enqueued
     overrun_oldest,  // Discard oldest message in the queue if full when trying to
                      // add new item.
-    discard_new      // Discard new message if the queue is full when trying to add new item.
+    discard_new,     // Discard new message if the queue is full when trying to add new item.
+    sample  // Once the queue is under pressure, admit a few messages per second and discard
+            // the others. A record with the number of discarded messages is logged when the
+            // pressure eases. Never blocks (see thread_pool_options::sample_rate).
+};
+
+// Queue implementation used by the thread pool - mutex based by default.
+enum class async_queue_type {
+    blocking,  // Circular queue protected by a mutex and condition variables
+    lock_free,  // Bounded ring with per slot sequence numbers. Producers never take a lock
+                // unless the queue is full and the policy is block.
+    per_thread,  // One lock free ring per producer thread, merged by the worker. The queue size
+                 // is the capacity of each ring. Requires thread local storage.
+    priority_lanes  // One lane per group of levels, each with its own capacity. The worker
+                    // drains the most severe lanes first and overflow only affects the lane
+                    // of the new message.
 };
 
 namespace details {
 class thread_pool;
-}
+struct async_msg;
+class log_awaiter;
+}  // namespace details
+
+class async_tee_logger;
 
 class SPDLOG_API async_logger final : public std::enable_shared_from_this<async_logger>,
                                       public logger {
     friend class details::thread_pool;
+    friend class async_tee_logger;
 
 public:
     template <typename It>
@@ -55,20 +82,102 @@ public:
                  std::weak_ptr<details::thread_pool> tp,
                  async_overflow_policy overflow_policy = async_overflow_policy::block);
 
+    async_logger(const async_logger &other);
+
+    // wait for the messages still queued by this logger to be processed
+    ~async_logger() override;
+
     std::shared_ptr<logger> clone(std::string new_name) override;
 
+    // format messages on the worker thread instead of the caller thread.
+    // only applies to log calls whose arguments are all arithmetic or strings (which are
+    // copied), others are still formatted by the caller. not thread safe - set it before
+    // logging.
+    void set_deferred_formatting(bool deferred);
+
+    // cap the number of messages of this logger waiting in the thread pool queue or being
+    // processed, so it can't take the whole queue from the other loggers. zero means no cap.
+    // once reached, new messages wait for room with the block policy, and are discarded and
+    // counted by overrun_counter() with the others. not thread safe - set it before logging.
+    void set_queue_quota(size_t max_messages);
+    size_t queue_quota() const;
+
+    // number of messages discarded because the queue quota was reached
+    size_t overrun_counter() const;
+    void reset_overrun_counter();
+
+    // log the messages of this level and above to the sinks on the calling thread, and flush
+    // them, instead of queuing them: the error explaining a crash reaches the sinks before it,
+    // without waiting for the messages queued before it, which are written after it (see also
+    // the priority_lanes queue type, processing the severe messages first). the sinks must
+    // not be claimed by the worker (see thread_pool::claim_exclusive()). level::off (the
+    // default) to queue all the messages.
+    void set_sync_level(level::level_enum log_level);
+    level::level_enum sync_level() const;
+
+#ifdef SPDLOG_HAS_COROUTINES
+    // co_await logger->async_info(...) logs like info(...) but never blocks the thread: if
+    // there is no room in the queue, the coroutine is suspended (whatever the overflow policy)
+    // and resumed once a worker made room and posted the message. it is resumed on the
+    // worker thread (where it must not block on the pool) unless the awaiter's resume_via()
+    // is given a scheduler. the message is formatted right away. the coroutine must not be
+    // destroyed while suspended.
+    template <typename... Args>
+    details::log_awaiter async_log(level::level_enum lvl,
+                                   format_string_t<Args...> fmt,
+                                   Args &&...args);
+
+    template <typename... Args>
+    details::log_awaiter async_trace(format_string_t<Args...> fmt, Args &&...args);
+
+    template <typename... Args>
+    details::log_awaiter async_debug(format_string_t<Args...> fmt, Args &&...args);
+
+    template <typename... Args>
+    details::log_awaiter async_info(format_string_t<Args...> fmt, Args &&...args);
+
+    template <typename... Args>
+    details::log_awaiter async_warn(format_string_t<Args...> fmt, Args &&...args);
+
+    template <typename... Args>
+    details::log_awaiter async_error(format_string_t<Args...> fmt, Args &&...args);
+
+    template <typename... Args>
+    details::log_awaiter async_critical(format_string_t<Args...> fmt, Args &&...args);
+#endif
+
 protected:
     void sink_it_(const details::log_msg &msg) override;
+    void sink_deferred_(const details::log_msg &msg,
+                        details::deferred_format_fn format_fn) override;
     void flush_() override;
     void backend_sink_it_(const details::log_msg &incoming_log_msg);
+    void backend_sink_batch_(const details::log_msg *msgs, size_t count);
     void backend_flush_();
+    // format a message whose formatting was deferred. return false (after reporting the
+    // error) if it failed.
+    bool backend_format_(details::async_msg &msg);
+    // log the message and flush the sinks on the calling thread, if it's of the sync level
+    bool sink_sync_(const details::log_msg &msg);
 
 private:
     std::weak_ptr<details::thread_pool> thread_pool_;
     async_overflow_policy overflow_policy_;
+    // messages discarded by the sample overflow policy and not reported yet
+    std::atomic<size_t> sampled_out_{0};
+    size_t queue_quota_{0};
+    // queued messages of the logger. in elastic pools, the top bits hold the index of the
+    // worker they were posted to (see thread_pool::attach_).
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<size_t> overrun_counter_{0};
+    level_t sync_level_{level::off};
 };
 }  // namespace spdlog
 
+#ifdef SPDLOG_HAS_COROUTINES
+    #include <spdlog/details/log_awaiter.h>
+#endif
+
 #ifdef SPDLOG_HEADER_ONLY
     #include "async_logger-inl.h"
 #endif
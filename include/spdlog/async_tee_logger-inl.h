@@ -0,0 +1,112 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/async_tee_logger.h>
+#endif
+
+#include <spdlog/details/thread_pool.h>
+#include <spdlog/sinks/sink.h>
+
+#include <memory>
+#include <string>
+
+SPDLOG_INLINE spdlog::async_tee_logger::async_tee_logger(std::string logger_name,
+                                                         std::vector<async_branch> branches)
+    : logger(std::move(logger_name)) {
+    branches_.reserve(branches.size());
+    for (auto &branch : branches) {
+        sinks_.insert(sinks_.end(), branch.sinks.begin(), branch.sinks.end());
+        auto branch_logger =
+            std::make_shared<async_logger>(name_, branch.sinks.begin(), branch.sinks.end(),
+                                           std::move(branch.pool), branch.overflow_policy);
+        branch_logger->set_level(level::trace);  // filtered by this logger
+        branches_.push_back(std::move(branch_logger));
+    }
+}
+
+SPDLOG_INLINE spdlog::async_tee_logger::async_tee_logger(const async_tee_logger &other)
+    : logger(other) {
+    branches_.reserve(other.branches_.size());
+    for (auto &branch : other.branches_) {
+        branches_.push_back(std::static_pointer_cast<async_logger>(branch->clone(branch->name())));
+    }
+}
+
+SPDLOG_INLINE std::shared_ptr<spdlog::logger> spdlog::async_tee_logger::clone(
+    std::string new_name) {
+    auto cloned = std::make_shared<spdlog::async_tee_logger>(*this);
+    cloned->name_ = std::move(new_name);
+    for (auto &branch : cloned->branches_) {
+        branch->name_ = cloned->name_;
+    }
+    return cloned;
+}
+
+SPDLOG_INLINE const std::vector<std::shared_ptr<spdlog::async_logger>>
+    &spdlog::async_tee_logger::branches() const {
+    return branches_;
+}
+
+SPDLOG_INLINE bool spdlog::async_tee_logger::wants_(const async_logger &branch,
+                                                    const details::log_msg &msg) {
+    if (!branch.should_log(msg.level)) {
+        return false;
+    }
+    for (const auto &sink : branch.sinks_) {
+        if (sink->should_log(msg.level)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// post the message to the branches with a sink logging it. if there are several, the payload
+// is copied once and shared by their queued messages.
+SPDLOG_INLINE void spdlog::async_tee_logger::sink_it_(const details::log_msg &msg) {
+    size_t wanted = 0;
+    for (const auto &branch : branches_) {
+        wanted += wants_(*branch, msg) ? 1 : 0;
+    }
+    details::log_msg shared_msg(msg);
+    std::shared_ptr<const void> payload_owner;
+    if (wanted > 1 && !msg.static_payload) {
+        auto payload = std::make_shared<const std::string>(msg.payload.data(), msg.payload.size());
+        shared_msg.payload = string_view_t(payload->data(), payload->size());
+        shared_msg.static_payload = true;
+        payload_owner = std::move(payload);
+    }
+    for (auto &branch : branches_) {
+        if (!wants_(*branch, msg)) {
+            continue;
+        }
+        shared_msg.logger_name = branch->name();  // not copied by the queued message
+        SPDLOG_TRY {
+            if (auto pool_ptr = branch->thread_pool_.lock()) {
+                pool_ptr->post_log(*branch, shared_msg, branch->overflow_policy_, nullptr,
+                                   payload_owner);
+            } else {
+                throw_spdlog_ex("async log: thread pool doesn't exist anymore");
+            }
+        }
+        SPDLOG_LOGGER_CATCH(msg.source)
+    }
+    if (should_flush_(msg)) {
+        flush_();
+    }
+}
+
+SPDLOG_INLINE void spdlog::async_tee_logger::flush_() {
+    for (auto &branch : branches_) {
+        SPDLOG_TRY {
+            if (auto pool_ptr = branch->thread_pool_.lock()) {
+                pool_ptr->post_flush(*branch, branch->overflow_policy_);
+            } else {
+                throw_spdlog_ex("async flush: thread pool doesn't exist anymore");
+            }
+        }
+        SPDLOG_LOGGER_CATCH(source_loc())
+    }
+}
@@ -0,0 +1,68 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Asynchronous logger whose sinks are partitioned across several thread pools, e.g. the local
+// files on one pool and the network sinks on another, so a slow sink can't hold back the
+// sinks of the other pools.
+//
+// Each branch (sinks + pool) is served by an async_logger of the same name. The payload of a
+// message is copied once and shared by the messages posted to the branches, which release it
+// when processed. The overflow policy applies to each branch on its own: a full queue only
+// blocks (or drops) for the branches posting to it.
+
+#include <spdlog/async_logger.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+
+struct async_branch {
+    async_branch() = default;
+    async_branch(std::vector<sink_ptr> branch_sinks,
+                 std::weak_ptr<details::thread_pool> branch_pool,
+                 async_overflow_policy policy = async_overflow_policy::block)
+        : sinks(std::move(branch_sinks)),
+          pool(std::move(branch_pool)),
+          overflow_policy(policy) {}
+
+    std::vector<sink_ptr> sinks;
+    std::weak_ptr<details::thread_pool> pool;
+    async_overflow_policy overflow_policy = async_overflow_policy::block;
+};
+
+class SPDLOG_API async_tee_logger final : public logger {
+public:
+    // the sinks of the branches are the sinks of the logger, e.g. set_pattern() applies to
+    // all of them. sinks added to sinks() later are not logged to.
+    async_tee_logger(std::string logger_name, std::vector<async_branch> branches);
+
+    // the clone gets clones of the branch loggers
+    async_tee_logger(const async_tee_logger &other);
+
+    std::shared_ptr<logger> clone(std::string new_name) override;
+
+    // the async logger serving each branch, in the order given to the ctor. their levels,
+    // error handlers and queue quotas may be set to tune a branch.
+    const std::vector<std::shared_ptr<async_logger>> &branches() const;
+
+protected:
+    void sink_it_(const details::log_msg &msg) override;
+    void flush_() override;
+
+private:
+    // whether the message would reach a sink of the branch
+    static bool wants_(const async_logger &branch, const details::log_msg &msg);
+
+    std::vector<std::shared_ptr<async_logger>> branches_;
+};
+
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "async_tee_logger-inl.h"
+#endif
@@ -0,0 +1,476 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/binary_formatter.h>
+#endif
+
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/fmt/args.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace spdlog {
+namespace details {
+
+static const char binary_log_magic_[] = {'S', 'P', 'D', 'B'};
+
+static void binary_append_varint_(std::uint64_t value, memory_buf_t &dest) {
+    char bytes[10];
+    size_t n = 0;
+    while (value >= 0x80) {
+        bytes[n++] = static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = static_cast<char>(value);
+    dest.append(bytes, bytes + n);
+}
+
+static void binary_append_string_(string_view_t value, memory_buf_t &dest) {
+    binary_append_varint_(value.size(), dest);
+    fmt_helper::append_string_view(value, dest);
+}
+
+static std::uint64_t binary_zigzag_(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+static std::int64_t binary_unzigzag_(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+static void binary_append_field_(const kv_field &field, memory_buf_t &dest) {
+    binary_append_string_(field.key, dest);
+    dest.push_back(static_cast<char>(field.type));
+    switch (field.type) {
+        case kv_type::string:
+            binary_append_string_(field.string_value, dest);
+            break;
+        case kv_type::int64:
+            binary_append_varint_(binary_zigzag_(field.int_value), dest);
+            break;
+        case kv_type::uint64:
+            binary_append_varint_(field.uint_value, dest);
+            break;
+        case kv_type::float64: {
+            std::uint64_t bits;
+            std::memcpy(&bits, &field.float_value, sizeof(bits));
+            for (int i = 0; i < 8; i++) {
+                dest.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+            }
+            break;
+        }
+        case kv_type::boolean:
+            dest.push_back(field.bool_value ? 1 : 0);
+            break;
+    }
+}
+
+}  // namespace details
+
+SPDLOG_INLINE std::unique_ptr<formatter> binary_formatter::clone() const {
+    return details::make_unique<binary_formatter>(catalog_);
+}
+
+SPDLOG_INLINE void binary_formatter::reset() {
+    header_written_ = false;
+    last_time_ = 0;
+    next_source_id_ = 1;
+    last_logger_name_.clear();
+    last_logger_id_ = 0;
+    logger_ids_.clear();
+    source_ids_.clear();
+    format_ids_.clear();
+}
+
+SPDLOG_INLINE void binary_formatter::format(const details::log_msg &msg, memory_buf_t &dest) {
+    if (!header_written_) {
+        dest.push_back('H');
+        dest.append(details::binary_log_magic_,
+                    details::binary_log_magic_ + sizeof(details::binary_log_magic_));
+        dest.push_back(static_cast<char>(version));
+        header_written_ = true;
+    }
+
+    auto logger_id = logger_id_(msg.logger_name, dest);
+    auto source_id = source_id_(msg.source, dest);
+    bool catalogued = catalog_ && msg.args != nullptr;
+    auto format_id = catalogued ? format_id_(msg.format, dest) : 0;
+    auto time = static_cast<std::int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch())
+            .count());
+
+    dest.push_back(catalogued ? 'P' : msg.kv_count > 0 ? 'F' : 'R');
+    details::binary_append_varint_(details::binary_zigzag_(time - last_time_), dest);
+    last_time_ = time;
+    dest.push_back(static_cast<char>(msg.level));
+    details::binary_append_varint_(logger_id, dest);
+    details::binary_append_varint_(source_id, dest);
+    details::binary_append_varint_(msg.thread_id, dest);
+    if (catalogued) {
+        details::binary_append_varint_(format_id, dest);
+        details::binary_append_varint_(msg.arg_count, dest);
+        for (size_t i = 0; i < msg.arg_count; i++) {
+            details::binary_append_field_(msg.args[i], dest);
+        }
+    } else {
+        details::binary_append_string_(msg.payload, dest);
+    }
+    if (catalogued || msg.kv_count > 0) {
+        details::binary_append_varint_(msg.kv_count, dest);
+        for (size_t i = 0; i < msg.kv_count; i++) {
+            details::binary_append_field_(msg.kv_fields[i], dest);
+        }
+    }
+}
+
+SPDLOG_INLINE std::uint64_t binary_formatter::logger_id_(string_view_t logger_name,
+                                                         memory_buf_t &dest) {
+    if (!logger_ids_.empty() && details::to_string_view(last_logger_name_) == logger_name) {
+        return last_logger_id_;
+    }
+    last_logger_name_.assign(logger_name.data(), logger_name.size());
+    auto it = logger_ids_.find(last_logger_name_);
+    if (it != logger_ids_.end()) {
+        last_logger_id_ = it->second;
+        return last_logger_id_;
+    }
+    last_logger_id_ = logger_ids_.size();
+    logger_ids_.emplace(last_logger_name_, last_logger_id_);
+    dest.push_back('L');
+    details::binary_append_varint_(last_logger_id_, dest);
+    details::binary_append_string_(logger_name, dest);
+    return last_logger_id_;
+}
+
+SPDLOG_INLINE std::uint64_t binary_formatter::source_id_(const source_loc &loc,
+                                                         memory_buf_t &dest) {
+    if (loc.empty()) {
+        return 0;
+    }
+    const char *funcname = loc.funcname ? loc.funcname : "";
+    auto &entry = source_ids_[source_key{loc.filename, loc.line}];
+    if (entry.id != 0 && entry.filename == loc.filename && entry.funcname == funcname) {
+        return entry.id;
+    }
+    entry.id = next_source_id_++;
+    entry.filename = loc.filename;
+    entry.funcname = funcname;
+    dest.push_back('S');
+    details::binary_append_varint_(entry.id, dest);
+    details::binary_append_varint_(static_cast<std::uint64_t>(loc.line), dest);
+    details::binary_append_string_(details::to_string_view(entry.filename), dest);
+    details::binary_append_string_(details::to_string_view(entry.funcname), dest);
+    return entry.id;
+}
+
+SPDLOG_INLINE std::uint64_t binary_formatter::format_id_(string_view_t format,
+                                                         memory_buf_t &dest) {
+    format_key_.assign(format.data(), format.size());
+    auto it = format_ids_.find(format_key_);
+    if (it != format_ids_.end()) {
+        return it->second;
+    }
+    auto id = static_cast<std::uint64_t>(format_ids_.size());
+    format_ids_.emplace(format_key_, id);
+    dest.push_back('M');
+    details::binary_append_varint_(id, dest);
+    details::binary_append_string_(format, dest);
+    return id;
+}
+
+SPDLOG_INLINE binary_log_reader::binary_log_reader(string_view_t data)
+    : begin_(data.data()),
+      pos_(data.data()),
+      consumed_(data.data()),
+      end_(data.data() + data.size()) {}
+
+SPDLOG_INLINE void binary_log_reader::feed(string_view_t data) {
+    begin_ = pos_ = consumed_ = data.data();
+    end_ = data.data() + data.size();
+}
+
+SPDLOG_INLINE bool binary_log_reader::next(details::log_msg &msg) {
+    while (pos_ != end_) {
+        auto entry_start = pos_;
+        auto tag = *pos_++;
+        bool complete = false;
+        switch (tag) {
+            case 'H':
+                complete = read_header_();
+                break;
+            case 'L':
+                complete = read_logger_();
+                break;
+            case 'S':
+                complete = read_source_();
+                break;
+            case 'M':
+                complete = read_format_();
+                break;
+            case 'R':
+            case 'F':
+            case 'P':
+                if (read_record_(msg, tag)) {
+                    consumed_ = pos_;
+                    return true;
+                }
+                break;
+            default:
+                throw_spdlog_ex("binary_log_reader: unknown entry at offset " +
+                                std::to_string(entry_start - begin_));
+        }
+        if (!complete) {
+            pos_ = end_;  // partial entry
+        } else {
+            consumed_ = pos_;
+        }
+    }
+    return false;
+}
+
+SPDLOG_INLINE void binary_log_reader::reset_() {
+    last_time_ = 0;
+    loggers_.clear();
+    sources_.clear();
+    id_strings_.clear();
+    formats_.clear();
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_varint_(std::uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; pos_ != end_ && shift < 64; shift += 7) {
+        auto byte = static_cast<unsigned char>(*pos_++);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_string_(string_view_t &value) {
+    std::uint64_t size;
+    if (!read_varint_(size) || size > static_cast<std::uint64_t>(end_ - pos_)) {
+        return false;
+    }
+    value = string_view_t(pos_, static_cast<size_t>(size));
+    pos_ += static_cast<size_t>(size);
+    return true;
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_header_() {
+    if (end_ - pos_ < static_cast<std::ptrdiff_t>(sizeof(details::binary_log_magic_) + 1)) {
+        return false;
+    }
+    if (std::memcmp(pos_, details::binary_log_magic_, sizeof(details::binary_log_magic_)) != 0) {
+        throw_spdlog_ex("binary_log_reader: bad header");
+    }
+    pos_ += sizeof(details::binary_log_magic_);
+    auto file_version = static_cast<unsigned char>(*pos_++);
+    if (file_version == 0 || file_version > binary_formatter::version) {
+        throw_spdlog_ex("binary_log_reader: unsupported version " + std::to_string(file_version));
+    }
+    reset_();
+    return true;
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_logger_() {
+    std::uint64_t id;
+    string_view_t name;
+    if (!read_varint_(id) || !read_string_(name)) {
+        return false;
+    }
+    if (id != loggers_.size()) {
+        throw_spdlog_ex("binary_log_reader: unexpected logger id " + std::to_string(id));
+    }
+    id_strings_.emplace_back(name.data(), name.size());
+    loggers_.emplace_back(id_strings_.back().data(), name.size());
+    return true;
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_source_() {
+    std::uint64_t id, line;
+    string_view_t filename, funcname;
+    if (!read_varint_(id) || !read_varint_(line) || !read_string_(filename) ||
+        !read_string_(funcname)) {
+        return false;
+    }
+    if (id == 0 || id > sources_.size() + 1) {
+        throw_spdlog_ex("binary_log_reader: unexpected source id " + std::to_string(id));
+    }
+    id_strings_.emplace_back(filename.data(), filename.size());
+    const char *file = id_strings_.back().c_str();
+    id_strings_.emplace_back(funcname.data(), funcname.size());
+    const char *func = id_strings_.back().c_str();
+    source_loc loc{file, static_cast<int>(line), func};
+    if (id == sources_.size() + 1) {
+        sources_.push_back(loc);
+    } else {
+        sources_[id - 1] = loc;  // redefined (the formatter saw another name at the same place)
+    }
+    return true;
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_format_() {
+    std::uint64_t id;
+    string_view_t format;
+    if (!read_varint_(id) || !read_string_(format)) {
+        return false;
+    }
+    if (id != formats_.size()) {
+        throw_spdlog_ex("binary_log_reader: unexpected format id " + std::to_string(id));
+    }
+    id_strings_.emplace_back(format.data(), format.size());
+    formats_.emplace_back(id_strings_.back().data(), format.size());
+    return true;
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_record_(details::log_msg &msg, char tag) {
+    std::uint64_t time_delta, logger_id, source_id, thread_id, format_id = 0;
+    string_view_t payload;
+    if (!read_varint_(time_delta) || pos_ == end_) {
+        return false;
+    }
+    auto lvl = static_cast<unsigned char>(*pos_++);
+    if (!read_varint_(logger_id) || !read_varint_(source_id) || !read_varint_(thread_id)) {
+        return false;
+    }
+    fields_.clear();
+    size_t arg_count = 0;  // the first fields_, before the kv fields
+    if (tag == 'P') {
+        if (!read_varint_(format_id) || !read_fields_()) {
+            return false;
+        }
+        arg_count = fields_.size();
+    } else if (!read_string_(payload)) {
+        return false;
+    }
+    if (tag != 'R' && !read_fields_()) {
+        return false;
+    }
+    if (logger_id >= loggers_.size() || source_id > sources_.size() ||
+        lvl >= static_cast<unsigned char>(level::n_levels) ||
+        (tag == 'P' && format_id >= formats_.size())) {
+        throw_spdlog_ex("binary_log_reader: bad record");
+    }
+    if (tag == 'P') {
+        format_payload_(formats_[static_cast<size_t>(format_id)], arg_count);
+        payload = string_view_t(payload_.data(), payload_.size());
+    }
+    last_time_ += details::binary_unzigzag_(time_delta);
+
+    msg = details::log_msg();
+    msg.time = log_clock::time_point(std::chrono::duration_cast<log_clock::duration>(
+        std::chrono::nanoseconds(last_time_)));
+    msg.level = static_cast<level::level_enum>(lvl);
+    msg.logger_name = loggers_[static_cast<size_t>(logger_id)];
+    if (source_id != 0) {
+        msg.source = sources_[static_cast<size_t>(source_id - 1)];
+    }
+    msg.thread_id = static_cast<size_t>(thread_id);
+    msg.payload = payload;
+    if (fields_.size() > arg_count) {
+        msg.kv_fields = fields_.data() + arg_count;
+        msg.kv_count = fields_.size() - arg_count;
+    }
+    if (tag == 'P') {
+        msg.format = formats_[static_cast<size_t>(format_id)];
+        msg.args = fields_.data();
+        msg.arg_count = arg_count;
+    }
+    return true;
+}
+
+SPDLOG_INLINE void binary_log_reader::format_payload_(string_view_t format, size_t arg_count) {
+#ifdef SPDLOG_USE_STD_FORMAT
+    (void)format;
+    (void)arg_count;
+    throw_spdlog_ex("binary_log_reader: message catalog records need fmt");
+#else
+    fmt::dynamic_format_arg_store<fmt::format_context> args;
+    for (size_t i = 0; i < arg_count; i++) {
+        const auto &arg = fields_[i];
+        switch (arg.type) {
+            case kv_type::string:
+                args.push_back(arg.string_value);
+                break;
+            case kv_type::int64:
+                args.push_back(arg.int_value);
+                break;
+            case kv_type::uint64:
+                args.push_back(arg.uint_value);
+                break;
+            case kv_type::float64:
+                args.push_back(arg.float_value);
+                break;
+            case kv_type::boolean:
+                args.push_back(arg.bool_value);
+                break;
+        }
+    }
+    payload_.clear();
+    fmt::vformat_to(fmt::appender(payload_), format, args);
+#endif
+}
+
+SPDLOG_INLINE bool binary_log_reader::read_fields_() {
+    std::uint64_t count;
+    if (!read_varint_(count)) {
+        return false;
+    }
+    for (std::uint64_t i = 0; i < count; i++) {
+        kv_field field;
+        if (!read_string_(field.key) || pos_ == end_) {
+            return false;
+        }
+        auto type = static_cast<unsigned char>(*pos_++);
+        field.type = static_cast<kv_type>(type);
+        std::uint64_t value = 0;
+        switch (field.type) {
+            case kv_type::string:
+                if (!read_string_(field.string_value)) {
+                    return false;
+                }
+                break;
+            case kv_type::int64:
+                if (!read_varint_(value)) {
+                    return false;
+                }
+                field.int_value = details::binary_unzigzag_(value);
+                break;
+            case kv_type::uint64:
+                if (!read_varint_(field.uint_value)) {
+                    return false;
+                }
+                break;
+            case kv_type::float64:
+                if (end_ - pos_ < 8) {
+                    return false;
+                }
+                for (int b = 0; b < 8; b++) {
+                    value |= static_cast<std::uint64_t>(static_cast<unsigned char>(*pos_++))
+                             << (8 * b);
+                }
+                std::memcpy(&field.float_value, &value, sizeof(value));
+                break;
+            case kv_type::boolean:
+                if (pos_ == end_) {
+                    return false;
+                }
+                field.bool_value = *pos_++ != 0;
+                break;
+            default:
+                throw_spdlog_ex("binary_log_reader: bad field type " + std::to_string(type));
+        }
+        fields_.push_back(field);
+    }
+    return true;
+}
+
+}  // namespace spdlog
@@ -0,0 +1,170 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Formatter writing each message as a compact binary record instead of text, and the reader
+// turning such a stream back into log messages (see tools/binary_decoder to print them with a
+// pattern_formatter pattern).
+//
+// The stream is a sequence of entries, each starting with a tag byte:
+//
+// 'H' "SPDB" version    - header. Starts the stream and resets the ids and the time base.
+// 'L' id name           - defines a logger id.
+// 'S' id line file func - defines a source location id (one per call site, so one per format
+//                         string). Id 0 stands for no source location.
+// 'R' time level logger source thread payload
+//                       - log record. The time is the zigzag encoded difference in nanoseconds
+//                         with the previous record (or with the epoch after a header).
+// 'F' time level logger source thread payload count (key type value)*
+//                       - log record with kv fields (see kv.h), since version 2. The type is a
+//                         kv_type byte, the value a string, a zigzag varint (int64), a varint
+//                         (uint64), the 8 little endian bytes of a double, or a byte (boolean).
+// 'M' id format         - defines a format string id (message catalog, since version 3).
+// 'P' time level logger source thread format count (key type value)* count (key type value)*
+//                       - log record with the id of its format string and its arguments (fields
+//                         without keys) instead of its text, then its kv fields.
+//
+// where the numbers are LEB128 varints and the strings are a varint size followed by the chars.
+// Ids are defined right before the first record using them.
+//
+// Usage example:
+// auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/app.bin");
+// sink->set_formatter(std::make_unique<spdlog::binary_formatter>());
+//
+// With the message catalog (binary_formatter(true)), the format strings are written once and
+// the records hold only their arguments, if these are integers, bools, doubles or strings
+// (the other messages are written as text). The loggers format the text anyway, for the other
+// sinks. Not with std::format, as the reader formats the text back with fmt.
+//
+// The records only refer to ids defined earlier in the same stream, so a sink starting a new
+// file (e.g. rotating) should call reset() on its formatter to write a new header first.
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/formatter.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spdlog {
+
+class SPDLOG_API binary_formatter final : public formatter {
+public:
+    static constexpr unsigned char version = 3;  // 2 without the catalog, 1 without 'F'
+
+    binary_formatter() = default;
+    explicit binary_formatter(bool message_catalog)
+        : catalog_(message_catalog) {}
+    binary_formatter(const binary_formatter &other) = delete;
+    binary_formatter &operator=(const binary_formatter &other) = delete;
+
+    // the clone starts its own stream (with its own header and ids)
+    std::unique_ptr<formatter> clone() const override;
+    void format(const details::log_msg &msg, memory_buf_t &dest) override;
+    unsigned needed_fields() const override {
+        return msg_field::time | msg_field::thread_id | msg_field::source |
+               (catalog_ ? msg_field::arguments : 0u);
+    }
+
+    // forget the ids and the time base: the next record starts with a new header
+    void reset();
+
+private:
+    struct source_key {
+        const char *filename;
+        int line;
+        bool operator==(const source_key &other) const {
+            return filename == other.filename && line == other.line;
+        }
+    };
+
+    struct source_key_hash {
+        size_t operator()(const source_key &key) const {
+            return std::hash<const void *>()(key.filename) ^
+                   (static_cast<size_t>(key.line) * 0x9e3779b9u);
+        }
+    };
+
+    // the call sites are looked up by their filename pointer, and their names compared in case
+    // the filename wasn't a literal.
+    struct source_entry {
+        std::uint64_t id;
+        std::string filename;
+        std::string funcname;
+    };
+
+    bool catalog_ = false;
+    bool header_written_ = false;
+    std::int64_t last_time_ = 0;
+    std::uint64_t next_source_id_ = 1;
+    std::string last_logger_name_;  // most messages come from the same logger as the previous one
+    std::uint64_t last_logger_id_ = 0;
+    std::unordered_map<std::string, std::uint64_t> logger_ids_;
+    std::unordered_map<source_key, source_entry, source_key_hash> source_ids_;
+    std::string format_key_;  // reused for the lookups
+    std::unordered_map<std::string, std::uint64_t> format_ids_;
+
+    std::uint64_t logger_id_(string_view_t logger_name, memory_buf_t &dest);
+    std::uint64_t source_id_(const source_loc &loc, memory_buf_t &dest);
+    std::uint64_t format_id_(string_view_t format, memory_buf_t &dest);
+};
+
+// read the messages of a binary_formatter stream, one by one:
+//
+// spdlog::binary_log_reader reader(data);
+// spdlog::details::log_msg msg;
+// while (reader.next(msg)) { ... }
+//
+// The data must outlive the reader, and msg refers to both until the next call.
+//
+// A stream received in chunks (e.g. from a tcp_sink) is read by feeding the reader each chunk,
+// preceded by the end of the previous one it didn't consume (a partial entry).
+class SPDLOG_API binary_log_reader {
+public:
+    explicit binary_log_reader(string_view_t data);
+
+    // return false at the end of the data. a trailing partial record (e.g. of a process which
+    // died while writing it) is ignored. throw spdlog_ex if the data is not a binary log.
+    bool next(details::log_msg &msg);
+
+    // the size of the data up to the end of the last complete entry read
+    size_t consumed() const { return static_cast<size_t>(consumed_ - begin_); }
+
+    // read the data following the consumed() part of the previous one, keeping the ids
+    void feed(string_view_t data);
+
+private:
+    const char *begin_;
+    const char *pos_;
+    const char *consumed_;
+    const char *end_;
+    std::int64_t last_time_ = 0;
+    std::vector<string_view_t> loggers_;
+    std::vector<source_loc> sources_;
+    // the names and formats of the ids (null terminated), kept when the data is fed in chunks
+    std::deque<std::string> id_strings_;
+    std::vector<string_view_t> formats_;
+    std::vector<kv_field> fields_;  // of the last record
+    memory_buf_t payload_;          // of the last 'P' record
+
+    void reset_();
+    bool read_varint_(std::uint64_t &value);
+    bool read_string_(string_view_t &value);
+    bool read_header_();
+    bool read_logger_();
+    bool read_source_();
+    bool read_format_();
+    bool read_record_(details::log_msg &msg, char tag);
+    bool read_fields_();
+    void format_payload_(string_view_t format, size_t arg_count);
+};
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "binary_formatter-inl.h"
+#endif
@@ -16,18 +16,24 @@
 
 // turn off all logging except for logger1 and logger2:
 // example.exe "SPDLOG_LEVEL=off,logger1=debug,logger2=info"
+//
+// and the levels per source file of the logging macros with "SPDLOG_VMODULE=":
+// example.exe "SPDLOG_VMODULE=net/*=trace"
 
 namespace spdlog {
 namespace cfg {
 
-// search for SPDLOG_LEVEL= in the args and use it to init the levels
+// search for SPDLOG_LEVEL= (and SPDLOG_VMODULE=) in the args and use it to init the levels
 inline void load_argv_levels(int argc, const char **argv) {
     const std::string spdlog_level_prefix = "SPDLOG_LEVEL=";
+    const std::string spdlog_vmodule_prefix = "SPDLOG_VMODULE=";
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         if (arg.find(spdlog_level_prefix) == 0) {
             auto levels_string = arg.substr(spdlog_level_prefix.size());
             helpers::load_levels(levels_string);
+        } else if (arg.find(spdlog_vmodule_prefix) == 0) {
+            helpers::load_vmodule(arg.substr(spdlog_vmodule_prefix.size()));
         }
     }
 }
@@ -22,6 +22,12 @@
 
 // turn off all logging except for logger1 and logger2:
 // export SPDLOG_LEVEL="off,logger1=debug,logger2=info"
+//
+// and the levels per source file of the logging macros from SPDLOG_VMODULE (see
+// helpers::load_vmodule):
+//
+// trace the files of the net directory:
+// export SPDLOG_VMODULE="net/*=trace"
 
 namespace spdlog {
 namespace cfg {
@@ -30,6 +36,10 @@ inline void load_env_levels() {
     if (!env_val.empty()) {
         helpers::load_levels(env_val);
     }
+    auto vmodule_val = details::os::getenv("SPDLOG_VMODULE");
+    if (!vmodule_val.empty()) {
+        helpers::load_vmodule(vmodule_val);
+    }
 }
 
 }  // namespace cfg
@@ -0,0 +1,98 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+#include <spdlog/cfg/helpers.h>
+#include <spdlog/details/periodic_worker.h>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+
+//
+// Init levels, patterns and flush level from a file of "key = value" lines (see
+// helpers::load_config), and apply it again each time it changes with a file_watcher, without
+// recreating the loggers: the levels are atomic, and the patterns are swapped under the sinks'
+// locks, which the logging threads take anyway.
+//
+// Example of file:
+//
+// # logger1 only
+// level = off,logger1=debug
+// pattern = [%H:%M:%S.%e] [%n] %v
+// flush_level = warn
+//
+// Usage:
+//
+// spdlog::cfg::file_watcher watcher("logging.cfg");  // loaded, then checked every second
+//
+
+namespace spdlog {
+namespace cfg {
+// apply the file's config. false if it couldn't be read
+inline bool load_file(const std::string &filename) {
+    std::ifstream ifs(filename, std::ios_base::binary);
+    if (!ifs) {
+        return false;
+    }
+    helpers::load_config(
+        std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>()));
+    return true;
+}
+
+// load the file, then reload it whenever its content changes, checked every interval on the
+// housekeeping thread (see details/scheduler.h)
+class file_watcher {
+public:
+    explicit file_watcher(std::string filename,
+                          std::chrono::milliseconds interval = std::chrono::seconds(1))
+        : filename_(std::move(filename)) {
+        check();
+        worker_ = details::make_unique<details::periodic_worker>([this] { check(); }, interval);
+    }
+
+    file_watcher(const file_watcher &) = delete;
+    file_watcher &operator=(const file_watcher &) = delete;
+
+    // reload the file now if it changed. false if it couldn't be read
+    bool check() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ifstream ifs(filename_, std::ios_base::binary);
+        if (!ifs) {
+            return false;
+        }
+        std::string content((std::istreambuf_iterator<char>(ifs)),
+                            std::istreambuf_iterator<char>());
+        if (loaded_ && content == content_) {
+            return true;
+        }
+        SPDLOG_TRY {
+            helpers::load_config(content);
+            content_ = std::move(content);
+            loaded_ = true;
+            reloads_++;
+        }
+        SPDLOG_CATCH_STD
+        return true;
+    }
+
+    // how many times the file was applied
+    size_t reloads() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reloads_;
+    }
+
+private:
+    std::string filename_;
+    mutable std::mutex mutex_;
+    std::string content_;
+    bool loaded_ = false;
+    size_t reloads_ = 0;
+    std::unique_ptr<details::periodic_worker> worker_;  // last, stopped first
+};
+
+}  // namespace cfg
+}  // namespace spdlog
@@ -9,12 +9,12 @@
 
 #include <spdlog/details/os.h>
 #include <spdlog/details/registry.h>
+#include <spdlog/pattern_formatter.h>
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
-#include <sstream>
 #include <string>
-#include <utility>
+#include <unordered_map>
 
 namespace spdlog {
 namespace cfg {
@@ -36,58 +36,54 @@ inline std::string &trim_(std::string &str) {
     return str;
 }
 
-// return (name,value) trimmed pair from given "name=value" string.
-// return empty string on missing parts
-// "key=val" => ("key", "val")
-// " key  =  val " => ("key", "val")
-// "key=" => ("key", "")
-// "val" => ("", "val")
-
-inline std::pair<std::string, std::string> extract_kv_(char sep, const std::string &str) {
-    auto n = str.find(sep);
-    std::string k, v;
-    if (n == std::string::npos) {
-        v = str;
-    } else {
-        k = str.substr(0, n);
-        v = str.substr(n + 1);
+// call fun(key, value) for each "key=value" of a sequence separated by sep, with the parts
+// trimmed, and key empty if there is no '='. the strings are reused from one call to the next,
+// and may be modified by fun.
+// "a=AAA, b = BBB,CCC" => fun("a", "AAA"), fun("b", "BBB"), fun("", "CCC")
+template <typename Fun>
+inline void for_each_kv_(const std::string &str, char sep, Fun fun) {
+    std::string key, value;
+    size_t start = 0;
+    while (start < str.size()) {
+        auto end = str.find(sep, start);
+        if (end == std::string::npos) {
+            end = str.size();
+        }
+        auto first = str.begin() + static_cast<std::ptrdiff_t>(start);
+        auto last = str.begin() + static_cast<std::ptrdiff_t>(end);
+        auto eq = std::find(first, last, '=');
+        if (eq == last) {
+            key.clear();
+            value.assign(first, last);
+        } else {
+            key.assign(first, eq);
+            value.assign(eq + 1, last);
+        }
+        fun(trim_(key), trim_(value));
+        start = end + 1;
     }
-    return std::make_pair(trim_(k), trim_(v));
 }
 
-// return vector of key/value pairs from sequence of "K1=V1,K2=V2,.."
-// "a=AAA,b=BBB,c=CCC,.." => {("a","AAA"),("b","BBB"),("c", "CCC"),...}
-inline std::unordered_map<std::string, std::string> extract_key_vals_(const std::string &str) {
-    std::string token;
-    std::istringstream token_stream(str);
-    std::unordered_map<std::string, std::string> rv{};
-    while (std::getline(token_stream, token, ',')) {
-        if (token.empty()) {
-            continue;
-        }
-        auto kv = extract_kv_('=', token);
-        rv[kv.first] = kv.second;
-    }
-    return rv;
+// the level named (in any case), or false if unrecognized
+inline bool parse_level_(std::string &name, level::level_enum &level) {
+    level = level::from_str(to_lower_(name));
+    return level != level::off || name == "off";
 }
 
 SPDLOG_INLINE void load_levels(const std::string &input) {
-    if (input.empty() || input.size() > 512) {
+    if (input.empty() || input.size() > SPDLOG_CFG_MAX_SIZE) {
         return;
     }
 
-    auto key_vals = extract_key_vals_(input);
     std::unordered_map<std::string, level::level_enum> levels;
     level::level_enum global_level = level::info;
     bool global_level_found = false;
 
-    for (auto &name_level : key_vals) {
-        auto &logger_name = name_level.first;
-        auto level_name = to_lower_(name_level.second);
-        auto level = level::from_str(level_name);
+    for_each_kv_(input, ',', [&](std::string &logger_name, std::string &level_name) {
+        level::level_enum level;
         // ignore unrecognized level names
-        if (level == level::off && level_name != "off") {
-            continue;
+        if (!parse_level_(level_name, level)) {
+            return;
         }
         if (logger_name.empty())  // no logger name indicate global level
         {
@@ -96,12 +92,53 @@ SPDLOG_INLINE void load_levels(const std::string &input) {
         } else {
             levels[logger_name] = level;
         }
-    }
+    });
 
     details::registry::instance().set_levels(std::move(levels),
                                              global_level_found ? &global_level : nullptr);
 }
 
+SPDLOG_INLINE void load_vmodule(const std::string &input) {
+    if (input.size() > SPDLOG_CFG_MAX_SIZE) {
+        return;
+    }
+
+    // in order, the first pattern matching applying
+    details::registry::vmodule_levels levels;
+    for_each_kv_(input, ',', [&](std::string &pattern, std::string &level_name) {
+        level::level_enum level;
+        // ignore unrecognized level names and missing patterns
+        if (pattern.empty() || !parse_level_(level_name, level)) {
+            return;
+        }
+        levels.emplace_back(pattern, level);
+    });
+
+    details::registry::instance().set_vmodule(std::move(levels));
+}
+
+SPDLOG_INLINE void load_config(const std::string &input) {
+    for_each_kv_(input, '\n', [](std::string &key, std::string &value) {
+        if (key.empty() || key[0] == '#') {
+            return;
+        }
+        to_lower_(key);
+        if (key == "level") {
+            load_levels(value);
+        } else if (key == "vmodule") {
+            load_vmodule(value);
+        } else if (key == "pattern") {
+            details::registry::instance().set_formatter(
+                details::make_unique<pattern_formatter>(value));
+        } else if (key == "flush_level") {
+            level::level_enum level;
+            if (parse_level_(value, level)) {
+                details::registry::instance().flush_on(level);
+            }
+        }
+    });
+}
+
 }  // namespace helpers
 }  // namespace cfg
 }  // namespace spdlog
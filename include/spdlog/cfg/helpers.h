@@ -6,6 +6,10 @@
 #include <spdlog/common.h>
 #include <unordered_map>
 
+#ifndef SPDLOG_CFG_MAX_SIZE
+    #define SPDLOG_CFG_MAX_SIZE 512
+#endif
+
 namespace spdlog {
 namespace cfg {
 namespace helpers {
@@ -19,6 +23,30 @@ namespace helpers {
 // turn off all logging except for logger1 and logger2: "off,logger1=debug,logger2=info"
 //
 SPDLOG_API void load_levels(const std::string &txt);
+
+//
+// Init the levels per source file of the logging macros (e.g. SPDLOG_TRACE) from given string
+// of "pattern=level": the level of the first glob pattern ('*' and '?') matching the path of a
+// file, or its end from a path separator, applies to the messages logged there, whatever the
+// logger's level. SPDLOG_ACTIVE_LEVEL still removes the macros below it.
+//
+// Examples:
+//
+// trace the files of the net directory: "net/*=trace"
+// silence a file, and debug the others of src/db: "db/pool.cpp=off,src/db/*=debug"
+//
+SPDLOG_API void load_vmodule(const std::string &txt);
+
+//
+// Apply the "key = value" lines of given string (see cfg/file.h), ignoring empty lines, the ones
+// starting with '#', and unknown keys:
+//
+// level = off,logger1=debug     (as load_levels)
+// vmodule = net/*=trace         (as load_vmodule)
+// pattern = [%H:%M:%S] %v       (the pattern of all the loggers)
+// flush_level = warn            (as spdlog::flush_on)
+//
+SPDLOG_API void load_config(const std::string &txt);
 }  // namespace helpers
 
 }  // namespace cfg
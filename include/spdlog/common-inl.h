@@ -29,6 +29,23 @@ SPDLOG_INLINE const char *to_short_c_str(spdlog::level::level_enum l) SPDLOG_NOE
 }
 
 SPDLOG_INLINE spdlog::level::level_enum from_str(const std::string &name) SPDLOG_NOEXCEPT {
+    // the default names differ by their first letter: compare with the one it could be first
+    auto candidate = n_levels;
+    switch (name.empty() ? '\0' : name[0]) {
+        case 't': candidate = trace; break;
+        case 'd': candidate = debug; break;
+        case 'i': candidate = info; break;
+        case 'w': candidate = warn; break;
+        case 'e': candidate = err; break;
+        case 'c': candidate = critical; break;
+        case 'o': candidate = off; break;
+        default: break;
+    }
+    if (candidate != n_levels && name == level_string_views[candidate]) {
+        return candidate;
+    }
+
+    // custom names (SPDLOG_LEVEL_NAMES)
     auto it = std::find(std::begin(level_string_views), std::end(level_string_views), name);
     if (it != std::end(level_string_views))
         return static_cast<level::level_enum>(std::distance(std::begin(level_string_views), it));
@@ -53,7 +70,7 @@ SPDLOG_INLINE spdlog_ex::spdlog_ex(const std::string &msg, int last_errno) {
 #else
     memory_buf_t outbuf;
     fmt::format_system_error(outbuf, last_errno, msg.c_str());
-    msg_ = fmt::to_string(outbuf);
+    msg_ = SPDLOG_BUF_TO_STRING(outbuf);
 #endif
 }
 
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <spdlog/details/level_enum.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/tweakme.h>
 
@@ -25,29 +26,10 @@
     #endif
 #endif
 
-#ifdef SPDLOG_COMPILED_LIB
-    #undef SPDLOG_HEADER_ONLY
-    #if defined(SPDLOG_SHARED_LIB)
-        #if defined(_WIN32)
-            #ifdef spdlog_EXPORTS
-                #define SPDLOG_API __declspec(dllexport)
-            #else  // !spdlog_EXPORTS
-                #define SPDLOG_API __declspec(dllimport)
-            #endif
-        #else  // !defined(_WIN32)
-            #define SPDLOG_API __attribute__((visibility("default")))
-        #endif
-    #else  // !defined(SPDLOG_SHARED_LIB)
-        #define SPDLOG_API
-    #endif
-    #define SPDLOG_INLINE
-#else  // !defined(SPDLOG_COMPILED_LIB)
-    #define SPDLOG_API
-    #define SPDLOG_HEADER_ONLY
-    #define SPDLOG_INLINE inline
-#endif  // #ifdef SPDLOG_COMPILED_LIB
+#include <spdlog/details/api.h>
 
 #include <spdlog/fmt/fmt.h>
+#include <spdlog/fmt/compile.h>
 
 #if !defined(SPDLOG_USE_STD_FORMAT) && \
     FMT_VERSION >= 80000  // backward compatibility with fmt versions older than 8
@@ -138,6 +120,15 @@ using filename_t = std::string;
     #define SPDLOG_FILENAME_T(s) s
 #endif
 
+// folder separator
+#if !defined(SPDLOG_FOLDER_SEPS)
+    #ifdef _WIN32
+        #define SPDLOG_FOLDER_SEPS "\\/"
+    #else
+        #define SPDLOG_FOLDER_SEPS "/"
+    #endif
+#endif
+
 using log_clock = std::chrono::system_clock;
 using sink_ptr = std::shared_ptr<sinks::sink>;
 using sinks_init_list = std::initializer_list<sink_ptr>;
@@ -159,6 +150,9 @@ template <class T, class Char = char>
 struct is_convertible_to_basic_format_string
     : std::integral_constant<bool, std::is_convertible<T, std::basic_string_view<Char>>::value> {};
 
+template <class T>
+struct is_compiled_format_string : std::false_type {};
+
     #if defined(SPDLOG_WCHAR_FILENAMES) || defined(SPDLOG_WCHAR_TO_UTF8_SUPPORT)
 using wstring_view_t = std::wstring_view;
 using wmemory_buf_t = std::wstring;
@@ -175,7 +169,11 @@ using wformat_string_t = std::wstring_view;
 namespace fmt_lib = fmt;
 
 using string_view_t = fmt::basic_string_view<char>;
+    #ifdef SPDLOG_BUFFER_ALLOCATOR
+using memory_buf_t = fmt::basic_memory_buffer<char, 250, SPDLOG_BUFFER_ALLOCATOR<char>>;
+    #else
 using memory_buf_t = fmt::basic_memory_buffer<char, 250>;
+    #endif
 
 template <typename... Args>
 using format_string_t = fmt::format_string<Args...>;
@@ -193,21 +191,36 @@ using fmt_runtime_string = fmt::basic_runtime<Char>;
 // clang doesn't like SFINAE disabled constructor in std::is_convertible<> so have to repeat the
 // condition from basic_format_string here, in addition, fmt::basic_runtime<Char> is only
 // convertible to basic_format_string<Char> but not basic_string_view<Char>
+// format strings made by FMT_COMPILE(), parsed at compile time (C++17 and up, FMT_COMPILE()
+// is FMT_STRING() otherwise)
+template <class T>
+struct is_compiled_format_string : fmt::detail::is_compiled_string<remove_cvref_t<T>> {};
+
 template <class T, class Char = char>
 struct is_convertible_to_basic_format_string
     : std::integral_constant<bool,
                              std::is_convertible<T, fmt::basic_string_view<Char>>::value ||
-                                 std::is_same<remove_cvref_t<T>, fmt_runtime_string<Char>>::value> {
+                                 std::is_same<remove_cvref_t<T>, fmt_runtime_string<Char>>::value ||
+                                 is_compiled_format_string<T>::value> {
 };
 
     #if defined(SPDLOG_WCHAR_FILENAMES) || defined(SPDLOG_WCHAR_TO_UTF8_SUPPORT)
 using wstring_view_t = fmt::basic_string_view<wchar_t>;
+        #ifdef SPDLOG_BUFFER_ALLOCATOR
+using wmemory_buf_t = fmt::basic_memory_buffer<wchar_t, 250, SPDLOG_BUFFER_ALLOCATOR<wchar_t>>;
+        #else
 using wmemory_buf_t = fmt::basic_memory_buffer<wchar_t, 250>;
+        #endif
 
 template <typename... Args>
 using wformat_string_t = fmt::wformat_string<Args...>;
     #endif
-    #define SPDLOG_BUF_TO_STRING(x) fmt::to_string(x)
+    #ifdef SPDLOG_BUFFER_ALLOCATOR
+        // fmt::to_string() only takes buffers with the default allocator
+        #define SPDLOG_BUF_TO_STRING(x) spdlog::details::buf_to_string(x)
+    #else
+        #define SPDLOG_BUF_TO_STRING(x) fmt::to_string(x)
+    #endif
 #endif
 
 #ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
@@ -228,31 +241,11 @@ using level_t = details::null_atomic_int;
 using level_t = std::atomic<int>;
 #endif
 
-#define SPDLOG_LEVEL_TRACE 0
-#define SPDLOG_LEVEL_DEBUG 1
-#define SPDLOG_LEVEL_INFO 2
-#define SPDLOG_LEVEL_WARN 3
-#define SPDLOG_LEVEL_ERROR 4
-#define SPDLOG_LEVEL_CRITICAL 5
-#define SPDLOG_LEVEL_OFF 6
-
 #if !defined(SPDLOG_ACTIVE_LEVEL)
     #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
 #endif
 
-// Log level enum
 namespace level {
-enum level_enum : int {
-    trace = SPDLOG_LEVEL_TRACE,
-    debug = SPDLOG_LEVEL_DEBUG,
-    info = SPDLOG_LEVEL_INFO,
-    warn = SPDLOG_LEVEL_WARN,
-    err = SPDLOG_LEVEL_ERROR,
-    critical = SPDLOG_LEVEL_CRITICAL,
-    off = SPDLOG_LEVEL_OFF,
-    n_levels
-};
-
 #define SPDLOG_LEVEL_NAME_TRACE spdlog::string_view_t("trace", 5)
 #define SPDLOG_LEVEL_NAME_DEBUG spdlog::string_view_t("debug", 5)
 #define SPDLOG_LEVEL_NAME_INFO spdlog::string_view_t("info", 4)
@@ -296,6 +289,40 @@ enum class pattern_time_type {
     utc     // log utc
 };
 
+// what pattern_formatter does with the control chars of the payloads (see
+// pattern_formatter::set_control_chars())
+enum class control_chars {
+    keep,
+    escape,  // "\n", "\r", "\t" and "\x1b" for the other ones
+    strip
+};
+
+// where the loggers take the message times from (see logger::set_clock())
+enum class clock_source {
+    standard,  // os::now(): log_clock, or the coarse clock if SPDLOG_CLOCK_COARSE is defined
+    coarse,    // CLOCK_REALTIME_COARSE on linux (a few ms resolution), log_clock elsewhere
+    tsc,       // the cpu time stamp counter (see details::tsc_clock)
+    // the raw counter, converted to time by the async loggers' worker instead of the caller
+    // (and by the sync loggers before their sinks). tsc until calibrated.
+    tsc_deferred
+};
+
+// the log_msg fields the loggers fill only if a sink needs them (see
+// formatter::needed_fields()). the logger name, level and payload are always filled.
+namespace msg_field {
+enum : unsigned {
+    none = 0,
+    time = 1 << 0,
+    thread_id = 1 << 1,
+    thread_name = 1 << 2,
+    source = 1 << 3,
+    all = time | thread_id | thread_name | source,
+    // the format string and the arguments (see binary_formatter's message catalog). not in
+    // all: only asked for explicitly.
+    arguments = 1 << 4
+};
+}  // namespace msg_field
+
 //
 // Log exception
 //
@@ -319,10 +346,106 @@ struct source_loc {
           line{line_in},
           funcname{funcname_in} {}
 
+    // short_filename_in: the filename without its folders (see SPDLOG_SHORT_FILENAME)
+    SPDLOG_CONSTEXPR source_loc(const char *filename_in,
+                                int line_in,
+                                const char *funcname_in,
+                                const char *short_filename_in)
+        : filename{filename_in},
+          line{line_in},
+          funcname{funcname_in},
+          short_filename{short_filename_in} {}
+
     SPDLOG_CONSTEXPR bool empty() const SPDLOG_NOEXCEPT { return line <= 0; }
     const char *filename{nullptr};
     int line{0};
     const char *funcname{nullptr};
+    const char *short_filename{nullptr};  // nullptr if not known (computed from filename then)
+};
+
+// A message in static storage (a string literal), logged as is: not formatted (so "{{" stays
+// "{{"), and not copied into the messages queued by the async loggers or kept by the backtrace.
+// The text must outlive the logging of the message, which a string literal always does.
+// logger->info(spdlog::static_msg("connection closed"));
+struct static_msg {
+    template <size_t N>
+    SPDLOG_CONSTEXPR explicit static_msg(const char (&literal)[N])
+        : text{literal, N - 1} {}
+    string_view_t text;
+};
+
+namespace details {
+SPDLOG_CONSTEXPR bool is_folder_sep(char c, const char *seps = SPDLOG_FOLDER_SEPS) {
+    return *seps != '\0' && (*seps == c || is_folder_sep(c, seps + 1));
+}
+
+// position past the last folder separator of path[begin, end), or 0 if it has none.
+// splits the range in halves so the recursion depth stays small for C++11.
+SPDLOG_CONSTEXPR size_t short_filename_offset(const char *path, size_t begin, size_t end);
+
+SPDLOG_CONSTEXPR size_t short_filename_offset_left_(size_t right_offset,
+                                                    const char *path,
+                                                    size_t begin,
+                                                    size_t mid) {
+    return right_offset != 0 ? right_offset : short_filename_offset(path, begin, mid);
+}
+
+SPDLOG_CONSTEXPR size_t short_filename_offset(const char *path, size_t begin, size_t end) {
+    return end - begin == 0   ? 0
+           : end - begin == 1 ? (is_folder_sep(path[begin]) ? end : 0)
+                              : short_filename_offset_left_(
+                                    short_filename_offset(path, begin + (end - begin) / 2, end),
+                                    path, begin, begin + (end - begin) / 2);
+}
+}  // namespace details
+
+// The filename without its folders, computed at compile time (file must be a string literal).
+#if defined(_MSC_VER) && (_MSC_VER < 1900)  // no constexpr
+    #define SPDLOG_SHORT_FILENAME(file) nullptr
+#else
+    #define SPDLOG_SHORT_FILENAME(file)                                                \
+        (file + std::integral_constant<size_t, spdlog::details::short_filename_offset( \
+                                                   file, 0, sizeof(file) - 1)>::value)
+#endif
+
+// How the file sinks make their data durable:
+// fsync        - data and metadata (os::fsync)
+// fdatasync    - data, and the metadata needed to read it back (e.g. not the modification time)
+// write_behind - only start writing the data back, without waiting for it (sync_file_range on
+//                linux, fdatasync elsewhere): no guarantee, but bounds the data lost on a crash
+//                without blocking the logging thread.
+enum class sync_method { fsync, fdatasync, write_behind };
+
+struct durability_policy {
+    durability_policy() = default;
+    durability_policy(sync_method sync_with,
+                      size_t every_bytes,
+                      std::chrono::milliseconds every_interval = std::chrono::milliseconds::zero())
+        : method(sync_with),
+          bytes(every_bytes),
+          interval(every_interval) {}
+
+    sync_method method = sync_method::fsync;  // also used by file_helper::sync()
+    // sync once this many bytes were written since the last sync (0 for never)
+    size_t bytes = 0;
+    // sync on the next write or flush this long after the last sync (0 for never)
+    std::chrono::milliseconds interval = std::chrono::milliseconds::zero();
+};
+
+// When the file sinks write a sidecar index of their files (see details::file_index), to find
+// the messages of a time range without reading the whole file (see log_file_offset()). No index
+// if both are 0.
+struct file_index_policy {
+    file_index_policy() = default;
+    file_index_policy(size_t every_messages,
+                      std::chrono::milliseconds every_interval = std::chrono::milliseconds::zero())
+        : messages(every_messages),
+          interval(every_interval) {}
+
+    // a record every this many messages (0 for none)
+    size_t messages = 0;
+    // a record for the first message this long after the last record (0 for none)
+    std::chrono::milliseconds interval = std::chrono::milliseconds::zero();
 };
 
 struct file_event_handlers {
@@ -336,6 +459,48 @@ struct file_event_handlers {
     std::function<void(const filename_t &filename, std::FILE *file_stream)> after_open;
     std::function<void(const filename_t &filename, std::FILE *file_stream)> before_close;
     std::function<void(const filename_t &filename)> after_close;
+
+    // if not 0, the file sinks buffer the messages in a buffer of this size and write it
+    // straight to the file descriptor (opened with O_APPEND), bypassing stdio and its lock.
+    // the streams given to the handlers above still work, and are flushed after them.
+    size_t write_buffer_size = 0;
+
+    // if true, the file sinks write each message (or batch of messages) with a single write()
+    // on the file descriptor (opened with O_APPEND), bypassing stdio which splits them at its
+    // buffer's size, so the messages of several processes writing to the same file don't
+    // interleave (a write to a local file isn't split, up to PIPE_BUF bytes over a pipe or on
+    // some network file systems). with write_buffer_size, the buffer only holds whole messages.
+    bool atomic_records = false;
+
+    // if not 0, the file sinks reserve the disk space of the file ahead of the writes, in chunks
+    // of this size (e.g. the max_size of a rotating_file_sink), so it doesn't get fragmented.
+    // the file size doesn't include the reserved space, which is given back when the file is
+    // closed. linux only.
+    size_t preallocate_size = 0;
+
+    durability_policy durability;
+
+    // the index of the file (the basic, rotating, daily and hourly file sinks; for the current
+    // file only with the rotating one)
+    file_index_policy index;
+};
+
+// Compression of the full files of the rotating and daily file sinks, done in the background
+// (gzip needs spdlog built with SPDLOG_ZLIB).
+enum class file_compression { none, gzip };
+
+struct compression_options {
+    compression_options() = default;
+    compression_options(file_compression compression_type,
+                        int compression_level = 6,
+                        size_t bytes_per_sec = 0)
+        : type(compression_type),
+          level(compression_level),
+          max_bytes_per_sec(bytes_per_sec) {}
+
+    file_compression type = file_compression::none;
+    int level = 6;                 // 1 (fastest) to 9 (smallest)
+    size_t max_bytes_per_sec = 0;  // read from the files being compressed. 0 for no limit.
 };
 
 namespace details {
@@ -352,6 +517,13 @@ SPDLOG_CONSTEXPR_FUNC spdlog::string_view_t to_string_view(spdlog::string_view_t
     return str;
 }
 
+#if !defined(SPDLOG_USE_STD_FORMAT) && defined(SPDLOG_BUFFER_ALLOCATOR)
+template <typename T, size_t SIZE, typename Allocator>
+std::basic_string<T> buf_to_string(const fmt::basic_memory_buffer<T, SIZE, Allocator> &buf) {
+    return std::basic_string<T>(buf.data(), buf.size());
+}
+#endif
+
 #if defined(SPDLOG_WCHAR_FILENAMES) || defined(SPDLOG_WCHAR_TO_UTF8_SUPPORT)
 SPDLOG_CONSTEXPR_FUNC spdlog::wstring_view_t to_string_view(const wmemory_buf_t &buf)
     SPDLOG_NOEXCEPT {
@@ -0,0 +1,214 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#if defined(SPDLOG_NO_TLS)
+    #error "This header requires thread local storage support, but SPDLOG_NO_TLS is defined."
+#endif
+
+// Child of a logger carrying a few context fields (e.g. the request id), a cheap alternative to
+// logger::clone(): it keeps a reference to the parent logger (its name, level, sinks and
+// formatter) and the fields inline, so creating one doesn't allocate.
+//
+// The fields are put in the thread's mdc while a message is logged, and printed by the
+// formatters like the other mdc entries (they replace the entries with the same key during the
+// call). As for the mdc, the async loggers don't get them.
+//
+// The parent logger and the strings of the fields must outlive the context logger.
+//
+// Usage example:
+// spdlog::context_logger request_logger(*logger, {{"request_id", request_id}});
+// request_logger.info("started");  // => [...] [info] [request_id:42] started
+// auto db_logger = request_logger.with("db", "users");
+
+#include <spdlog/logger.h>
+#include <spdlog/mdc.h>
+
+#include <array>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+namespace spdlog {
+
+class context_logger {
+public:
+    static constexpr size_t max_fields = 4;
+
+    using field = std::pair<string_view_t, string_view_t>;  // key, value
+
+    explicit context_logger(logger &parent, std::initializer_list<field> fields = {})
+        : parent_(&parent) {
+        for (const auto &f : fields) {
+            add_(f.first, f.second);
+        }
+    }
+
+    // a copy with one more field (replacing the field with the same key)
+    context_logger with(string_view_t key, string_view_t value) const {
+        context_logger child(*this);
+        child.add_(key, value);
+        return child;
+    }
+
+    logger &parent() const { return *parent_; }
+
+    size_t size() const { return size_; }
+
+    const field &operator[](size_t i) const { return fields_[i]; }
+
+    bool should_log(level::level_enum msg_level) const { return parent_->should_log(msg_level); }
+
+    template <typename... Args>
+    void log(source_loc loc, level::level_enum lvl, format_string_t<Args...> fmt, Args &&...args) {
+        if (!parent_->should_log(lvl)) {
+            return;
+        }
+        fields_scope scope(*this);
+        parent_->log(loc, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void log(level::level_enum lvl, format_string_t<Args...> fmt, Args &&...args) {
+        log(source_loc{}, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    void log(source_loc loc, level::level_enum lvl, string_view_t msg) {
+        if (!parent_->should_log(lvl)) {
+            return;
+        }
+        fields_scope scope(*this);
+        parent_->log(loc, lvl, msg);
+    }
+
+    void log(level::level_enum lvl, string_view_t msg) { log(source_loc{}, lvl, msg); }
+
+    template <typename T>
+    void log(level::level_enum lvl, const T &msg) {
+        log(source_loc{}, lvl, "{}", msg);
+    }
+
+    template <typename... Args>
+    void trace(format_string_t<Args...> fmt, Args &&...args) {
+        log(level::trace, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void debug(format_string_t<Args...> fmt, Args &&...args) {
+        log(level::debug, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void info(format_string_t<Args...> fmt, Args &&...args) {
+        log(level::info, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void warn(format_string_t<Args...> fmt, Args &&...args) {
+        log(level::warn, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void error(format_string_t<Args...> fmt, Args &&...args) {
+        log(level::err, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void critical(format_string_t<Args...> fmt, Args &&...args) {
+        log(level::critical, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void trace(const T &msg) {
+        log(level::trace, msg);
+    }
+
+    template <typename T>
+    void debug(const T &msg) {
+        log(level::debug, msg);
+    }
+
+    template <typename T>
+    void info(const T &msg) {
+        log(level::info, msg);
+    }
+
+    template <typename T>
+    void warn(const T &msg) {
+        log(level::warn, msg);
+    }
+
+    template <typename T>
+    void error(const T &msg) {
+        log(level::err, msg);
+    }
+
+    template <typename T>
+    void critical(const T &msg) {
+        log(level::critical, msg);
+    }
+
+private:
+    logger *parent_;
+    std::array<field, max_fields> fields_;
+    size_t size_ = 0;
+
+    void add_(string_view_t key, string_view_t value) {
+        for (size_t i = 0; i < size_; i++) {
+            if (fields_[i].first == key) {
+                fields_[i].second = value;
+                return;
+            }
+        }
+        if (size_ == max_fields) {
+            throw_spdlog_ex("context_logger: more than " + std::to_string(size_t{max_fields}) +
+                            " fields");
+        }
+        fields_[size_++] = field(key, value);
+    }
+
+    // the fields in the thread's mdc while alive, then the entries they replaced back
+    class fields_scope {
+    public:
+        explicit fields_scope(const context_logger &ctx)
+            : ctx_(ctx) {
+            auto &mdc_context = mdc::get_context();
+            for (size_t i = 0; i < ctx_.size_; i++) {
+                string_view_t old_value;
+                if (mdc_context.find(ctx_.fields_[i].first, old_value)) {
+                    old_starts_[i] = old_values_.size();
+                    old_values_.append(old_value.data(), old_value.data() + old_value.size());
+                    had_value_[i] = true;
+                }
+                mdc_context.put(ctx_.fields_[i].first, ctx_.fields_[i].second);
+            }
+        }
+
+        ~fields_scope() {
+            auto &mdc_context = mdc::get_context();
+            size_t end = old_values_.size();
+            for (size_t i = ctx_.size_; i-- > 0;) {
+                auto &key = ctx_.fields_[i].first;
+                if (had_value_[i]) {
+                    mdc_context.put(key, string_view_t(old_values_.data() + old_starts_[i],
+                                                       end - old_starts_[i]));
+                    end = old_starts_[i];
+                } else {
+                    mdc_context.remove(key);
+                }
+            }
+        }
+
+        fields_scope(const fields_scope &) = delete;
+        fields_scope &operator=(const fields_scope &) = delete;
+
+    private:
+        const context_logger &ctx_;
+        memory_buf_t old_values_;  // of the replaced entries, one after the other
+        std::array<size_t, max_fields> old_starts_{};
+        std::array<bool, max_fields> had_value_{};
+    };
+};
+
+}  // namespace spdlog
@@ -0,0 +1,324 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Emergency dump of the messages still waiting in the thread pool queues, and of the backtrace
+// messages of the loggers (see logger::enable_backtrace()), when the process gets a fatal
+// signal (SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT). Opt-in: nothing is installed until
+// enable() is called.
+//
+// The handler is async-signal-safe: it doesn't lock, allocate or format with fmt. It only
+// reads the queues and the backtrace rings in place and writes the lines to the file
+// descriptor given to enable() (opened beforehand) with write(). Then the previous handler is
+// restored and the signal raised again, so the process still dies (or dumps core) as before.
+// This is best effort: the messages taken by the workers already are not in the queues
+// anymore, and a message popped while the dump reads it may come out garbled. The payloads
+// whose formatting was deferred (async_logger::set_deferred_formatting(), and the backtrace
+// messages with arithmetic or string arguments) are written as their format string only.
+//
+// The lines are "[<seconds since epoch>.<millis>] [<logger>] [<level>] <payload>", after a
+// "*** spdlog crash dump" header naming the signal.
+//
+// Usage example:
+// int fd = ::open("crash.log", O_WRONLY | O_CREAT | O_APPEND, 0644);
+// spdlog::crash_dump::watch(spdlog::thread_pool());
+// spdlog::crash_dump::watch(logger);  // its backtrace
+// spdlog::crash_dump::enable(fd);
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/thread_pool.h>
+#include <spdlog/logger.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <cerrno>
+    #include <unistd.h>
+#endif
+
+namespace spdlog {
+
+class crash_dump {
+public:
+    static constexpr size_t max_watched = 64;
+
+    // install the handlers of the fatal signals, writing to fd (which must stay open). the
+    // previous handlers are called after the dump.
+    static void enable(int fd) {
+        auto &s = state_();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.fd.store(fd, std::memory_order_release);
+        if (s.installed) {
+            return;
+        }
+        for (size_t i = 0; i < signals_n; i++) {
+#ifdef _WIN32
+            s.previous[i] = std::signal(signals_()[i], on_signal_);
+#else
+            struct sigaction action;
+            std::memset(&action, 0, sizeof(action));
+            action.sa_handler = on_signal_;
+            sigemptyset(&action.sa_mask);
+            sigaction(signals_()[i], &action, &s.previous[i]);
+#endif
+        }
+        s.installed = true;
+    }
+
+    // restore the previous handlers, and release the watched pools and loggers
+    static void disable() {
+        auto &s = state_();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.installed) {
+            for (size_t i = 0; i < signals_n; i++) {
+#ifdef _WIN32
+                std::signal(signals_()[i], s.previous[i] != SIG_ERR ? s.previous[i] : SIG_DFL);
+#else
+                sigaction(signals_()[i], &s.previous[i], nullptr);
+#endif
+            }
+            s.installed = false;
+        }
+        s.fd.store(-1, std::memory_order_release);
+        s.pools_n.store(0, std::memory_order_release);
+        s.loggers_n.store(0, std::memory_order_release);
+        s.pool_owners.clear();
+        s.logger_owners.clear();
+    }
+
+    // dump the queued messages of the pool. it is kept alive until disable().
+    // throws if max_watched pools are watched already.
+    static void watch(std::shared_ptr<details::thread_pool> pool) {
+        auto &s = state_();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto n = s.pools_n.load(std::memory_order_relaxed);
+        if (n == max_watched) {
+            throw_spdlog_ex("crash_dump: too many thread pools watched");
+        }
+        s.pools[n].store(pool.get(), std::memory_order_relaxed);
+        s.pool_owners.push_back(std::move(pool));
+        s.pools_n.store(n + 1, std::memory_order_release);
+    }
+
+    // dump the backtrace messages of the logger. it is kept alive until disable().
+    // throws if max_watched loggers are watched already.
+    static void watch(std::shared_ptr<logger> watched_logger) {
+        auto &s = state_();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto n = s.loggers_n.load(std::memory_order_relaxed);
+        if (n == max_watched) {
+            throw_spdlog_ex("crash_dump: too many loggers watched");
+        }
+        s.loggers[n].store(watched_logger.get(), std::memory_order_relaxed);
+        s.logger_owners.push_back(std::move(watched_logger));
+        s.loggers_n.store(n + 1, std::memory_order_release);
+    }
+
+    // write the messages of the watched pools and loggers to fd now. async-signal-safe.
+    static void dump(int fd) {
+        auto &s = state_();
+        writer out(fd);
+        auto pools_n = s.pools_n.load(std::memory_order_acquire);
+        for (size_t i = 0; i < pools_n; i++) {
+            auto *pool = s.pools[i].load(std::memory_order_relaxed);
+            out.append("*** queued messages of thread pool #");
+            out.append_int(i);
+            out.append("\n");
+            pool->visit_queued_unsafe(write_queued_, &out);
+        }
+        auto loggers_n = s.loggers_n.load(std::memory_order_acquire);
+        for (size_t i = 0; i < loggers_n; i++) {
+            auto *watched = s.loggers[i].load(std::memory_order_relaxed);
+            out.append("*** backtrace of logger [");
+            out.append(watched->name());
+            out.append("]\n");
+            watched->visit_backtrace_unsafe(write_backtrace_, &out);
+        }
+        out.flush();
+    }
+
+private:
+#ifdef SIGBUS
+    static constexpr size_t signals_n = 5;
+#else
+    static constexpr size_t signals_n = 4;
+#endif
+
+    struct state {
+        std::mutex mutex;  // guards the fields but fd and the array sizes
+        std::atomic<int> fd{-1};
+        bool installed = false;
+        std::atomic<bool> dumped{false};
+        std::atomic<details::thread_pool *> pools[max_watched];
+        std::atomic<size_t> pools_n{0};
+        std::atomic<logger *> loggers[max_watched];
+        std::atomic<size_t> loggers_n{0};
+        std::vector<std::shared_ptr<details::thread_pool>> pool_owners;
+        std::vector<std::shared_ptr<logger>> logger_owners;
+#ifdef _WIN32
+        void (*previous[signals_n])(int) = {};
+#else
+        struct sigaction previous[signals_n];
+#endif
+    };
+
+    static state &state_() {
+        static state s;
+        return s;
+    }
+
+    static const int *signals_() {
+        static const int signals[signals_n] = {SIGSEGV, SIGFPE, SIGILL, SIGABRT,
+#ifdef SIGBUS
+                                               SIGBUS
+#endif
+        };
+        return signals;
+    }
+
+    // a fixed buffer written with write() when full
+    class writer {
+    public:
+        explicit writer(int fd)
+            : fd_(fd) {}
+
+        void append(string_view_t text) {
+            for (size_t i = 0; i < text.size(); i++) {
+                if (size_ == sizeof(buf_)) {
+                    flush();
+                }
+                buf_[size_++] = text.data()[i];
+            }
+        }
+
+        void append(const char *text) { append(string_view_t(text, std::strlen(text))); }
+
+        void append_int(std::uint64_t value, size_t min_digits = 1) {
+            char digits[20];
+            size_t n = 0;
+            do {
+                digits[n++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0 || n < min_digits);
+            while (n > 0) {
+                append(string_view_t(&digits[--n], 1));
+            }
+        }
+
+        void flush() {
+            const char *data = buf_;
+            while (size_ > 0) {
+#ifdef _WIN32
+                auto written = ::_write(fd_, data, static_cast<unsigned>(size_));
+#else
+                auto written = ::write(fd_, data, size_);
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+#endif
+                if (written <= 0) {
+                    break;
+                }
+                data += written;
+                size_ -= static_cast<size_t>(written);
+            }
+            size_ = 0;
+        }
+
+    private:
+        int fd_;
+        char buf_[1024];
+        size_t size_ = 0;
+    };
+
+    static void write_line_(writer &out,
+                            const details::log_msg &msg,
+                            details::deferred_format_fn format_fn) {
+        auto resolved = msg;  // with a raw counter time converted
+        resolved.resolve_time();
+        auto since_epoch = resolved.time.time_since_epoch();
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count();
+        if (millis < 0) {
+            millis = 0;
+        }
+        out.append("[");
+        out.append_int(static_cast<std::uint64_t>(millis) / 1000);
+        out.append(".");
+        out.append_int(static_cast<std::uint64_t>(millis) % 1000, 3);
+        out.append("] [");
+        out.append(msg.logger_name);
+        out.append("] [");
+        out.append(level::to_string_view(msg.level));
+        out.append("] ");
+        if (format_fn == nullptr) {
+            out.append(msg.payload);
+        } else {
+            // packed arguments: only the format string, which comes first (see
+            // deferred_args.h), can be written
+            const auto &packed = msg.payload;
+            size_t size = 0;
+            if (packed.size() >= sizeof(size)) {
+                std::memcpy(&size, packed.data(), sizeof(size));
+            }
+            if (packed.size() >= sizeof(size) && size <= packed.size() - sizeof(size)) {
+                out.append(string_view_t(packed.data() + sizeof(size), size));
+                if (sizeof(size) + size < packed.size()) {
+                    out.append(" (arguments not formatted)");
+                }
+            } else {
+                out.append("(arguments not formatted)");
+            }
+        }
+        out.append("\n");
+    }
+
+    static void write_queued_(const details::async_msg &msg, void *context) {
+        if (msg.msg_type != details::async_msg_type::log) {
+            return;
+        }
+        write_line_(*static_cast<writer *>(context), msg, msg.format_fn);
+    }
+
+    static void write_backtrace_(const details::log_msg &msg,
+                                 details::deferred_format_fn format_fn,
+                                 void *context) {
+        write_line_(*static_cast<writer *>(context), msg, format_fn);
+    }
+
+    static void on_signal_(int sig) {
+        auto &s = state_();
+        auto fd = s.fd.load(std::memory_order_acquire);
+        // once, even if several threads crash at the same time
+        if (fd >= 0 && !s.dumped.exchange(true, std::memory_order_acq_rel)) {
+            writer out(fd);
+            out.append("*** spdlog crash dump: signal ");
+            out.append_int(static_cast<std::uint64_t>(sig));
+            out.append("\n");
+            out.flush();
+            dump(fd);
+        }
+        for (size_t i = 0; i < signals_n; i++) {
+            if (signals_()[i] == sig) {
+#ifdef _WIN32
+                std::signal(sig, s.previous[i] != SIG_ERR ? s.previous[i] : SIG_DFL);
+#else
+                sigaction(sig, &s.previous[i], nullptr);
+#endif
+                break;
+            }
+        }
+        std::raise(sig);
+    }
+};
+
+}  // namespace spdlog
@@ -0,0 +1,486 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Encoding of log messages as Arrow IPC stream messages (see arrow_file_sink), without the Arrow
+// libraries: the schema and record batch metadata are encoded with a small flatbuffers builder,
+// and the columns are built as the Arrow buffers directly.
+//
+// The columns (the source ones being null for the messages without a source location):
+//   time             timestamp[ns, tz=UTC]
+//   level            utf8
+//   logger           utf8
+//   thread           uint64
+//   source_file      utf8, nullable
+//   source_line      int32, nullable
+//   source_function  utf8, nullable
+//   message          utf8
+//   fields           map<utf8, utf8>  (the kv fields, their values as text)
+
+#include <spdlog/common.h>
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/log_msg.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+namespace arrow {
+
+// Flatbuffers builder writing back to front like the flatbuffers library: the children of an
+// object (strings, vectors, tables) are created before it, and referred to by their offset from
+// the end of the buffer. The scalars are little endian, as flatbuffers requires.
+class flatbuffer_builder {
+public:
+    using offset = std::uint32_t;
+
+    void clear() {
+        size_ = 0;
+        max_align_ = 1;
+    }
+
+    offset create_string(string_view_t value) {
+        prep_(4, value.size() + 1);
+        push_zeros_(1);
+        push_bytes_(value.data(), value.size());
+        push_le_(static_cast<std::uint32_t>(value.size()), 4);
+        return static_cast<offset>(size_);
+    }
+
+    offset create_offsets(const std::vector<offset> &offsets) {
+        prep_(4, offsets.size() * 4);
+        for (auto it = offsets.rbegin(); it != offsets.rend(); ++it) {
+            push_le_(refer_(*it), 4);
+        }
+        push_le_(static_cast<std::uint32_t>(offsets.size()), 4);
+        return static_cast<offset>(size_);
+    }
+
+    // a vector of the given structs (of 64 bits integers, e.g. the FieldNodes and Buffers)
+    offset create_structs(const std::vector<std::int64_t> &values, size_t struct_size) {
+        auto bytes = values.size() * 8;
+        prep_(4, bytes);
+        prep_(8, bytes);
+        for (auto it = values.rbegin(); it != values.rend(); ++it) {
+            push_le_(static_cast<std::uint64_t>(*it), 8);
+        }
+        push_le_(static_cast<std::uint32_t>(bytes / struct_size), 4);
+        return static_cast<offset>(size_);
+    }
+
+    // the fields of a table are added between start_table() and end_table(), nothing else
+    void start_table() {
+        fields_.clear();
+        table_start_ = size_;
+    }
+
+    template <typename T>
+    void add_scalar(unsigned slot, T value) {
+        prep_(sizeof(T), 0);
+        push_le_(static_cast<std::uint64_t>(value), sizeof(T));
+        fields_.push_back(field_loc{slot, size_});
+    }
+
+    void add_offset(unsigned slot, offset target) {
+        prep_(4, 0);
+        push_le_(refer_(target), 4);
+        fields_.push_back(field_loc{slot, size_});
+    }
+
+    offset end_table() {
+        prep_(4, 0);
+        push_le_(0, 4);  // the offset of the vtable, set below
+        auto table = size_;
+        unsigned slots = 0;
+        for (const auto &field : fields_) {
+            slots = (std::max)(slots, field.slot + 1);
+        }
+        // the vtable: its size, the size of the table and the position of each field in it
+        for (auto slot = slots; slot-- > 0;) {
+            size_t position = 0;
+            for (const auto &field : fields_) {
+                if (field.slot == slot) {
+                    position = table - field.position;
+                }
+            }
+            push_le_(position, 2);
+        }
+        push_le_(table - table_start_, 2);
+        push_le_(4 + 2 * slots, 2);
+        store_le_(buf_.data() + buf_.size() - table, size_ - table, 4);
+        return static_cast<offset>(table);
+    }
+
+    // the buffer of the root table (at an offset multiple of 8 from its end)
+    string_view_t finish(offset root) {
+        prep_(max_align_, 4);
+        push_le_(refer_(root), 4);
+        return string_view_t(buf_.data() + buf_.size() - size_, size_);
+    }
+
+private:
+    struct field_loc {
+        unsigned slot;
+        size_t position;  // from the end of the buffer
+    };
+
+    std::vector<char> buf_ = std::vector<char>(1024);  // the data at the end
+    size_t size_ = 0;
+    size_t max_align_ = 1;
+    size_t table_start_ = 0;
+    std::vector<field_loc> fields_;
+
+    char *reserve_(size_t n) {
+        if (size_ + n > buf_.size()) {
+            std::vector<char> bigger((std::max)(buf_.size() * 2, size_ + n));
+            std::memcpy(bigger.data() + bigger.size() - size_, buf_.data() + buf_.size() - size_,
+                        size_);
+            buf_.swap(bigger);
+        }
+        size_ += n;
+        return buf_.data() + buf_.size() - size_;
+    }
+
+    // pad so that the buffer is aligned after the additional bytes
+    void prep_(size_t alignment, size_t additional) {
+        max_align_ = (std::max)(max_align_, alignment);
+        push_zeros_((alignment - (size_ + additional) % alignment) % alignment);
+    }
+
+    void push_zeros_(size_t n) { std::memset(reserve_(n), 0, n); }
+
+    void push_bytes_(const char *data, size_t n) {
+        if (n > 0) {
+            std::memcpy(reserve_(n), data, n);
+        }
+    }
+
+    void push_le_(std::uint64_t value, size_t n) { store_le_(reserve_(n), value, n); }
+
+    static void store_le_(char *dest, std::uint64_t value, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            dest[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    // the value of an offset to target stored next (aligned)
+    std::uint32_t refer_(offset target) const {
+        return static_cast<std::uint32_t>(size_ + 4 - target);
+    }
+};
+
+// The columns of the messages added since the last batch, encoded as Arrow IPC messages (the
+// columns in the byte order of the host, which the schema tells).
+class record_batch_builder {
+public:
+    record_batch_builder() { clear(); }
+
+    size_t rows() const { return times_.size(); }
+
+    // of the text columns, to bound the batches (their offsets being 32 bits)
+    size_t text_size() const {
+        return level_.data.size() + logger_.data.size() + file_.data.size() +
+               function_.data.size() + message_.data.size() + keys_.data.size() +
+               values_.data.size();
+    }
+
+    void add(const log_msg &msg) {
+        auto time =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch());
+        times_.push_back(static_cast<std::int64_t>(time.count()));
+        level_.add(level::to_string_view(msg.level));
+        logger_.add(msg.logger_name);
+        threads_.push_back(static_cast<std::uint64_t>(msg.thread_id));
+        bool has_source = !msg.source.empty();
+        source_valid_.push_back(has_source);
+        if (has_source) {
+            file_.add(msg.source.filename);
+            lines_.push_back(static_cast<std::int32_t>(msg.source.line));
+            function_.add(msg.source.funcname == nullptr ? "" : msg.source.funcname);
+        } else {
+            source_nulls_++;
+            file_.add(string_view_t{});
+            lines_.push_back(0);
+            function_.add(string_view_t{});
+        }
+        message_.add(msg.payload);
+        for (size_t i = 0; i < msg.kv_count; i++) {
+            keys_.add(msg.kv_fields[i].key);
+            value_buf_.clear();
+            fmt_helper::append_kv_value(msg.kv_fields[i], value_buf_);
+            values_.add(string_view_t(value_buf_.data(), value_buf_.size()));
+        }
+        field_offsets_.push_back(static_cast<std::int32_t>(keys_.offsets.size() - 1));
+    }
+
+    void clear() {
+        times_.clear();
+        level_.clear();
+        logger_.clear();
+        threads_.clear();
+        source_valid_.clear();
+        source_nulls_ = 0;
+        file_.clear();
+        lines_.clear();
+        function_.clear();
+        message_.clear();
+        field_offsets_.assign(1, 0);
+        keys_.clear();
+        values_.clear();
+    }
+
+    // the schema message, starting the stream
+    void append_schema(memory_buf_t &dest) {
+        auto &fb = builder_;
+        fb.clear();
+        std::vector<flatbuffer_builder::offset> fields;
+
+        auto utc = fb.create_string("UTC");
+        fb.start_table();
+        fb.add_scalar<std::int16_t>(0, 3);  // nanoseconds
+        fb.add_offset(1, utc);
+        fields.push_back(field_("time", false, type_timestamp, fb.end_table()));
+        fields.push_back(field_("level", false, type_utf8, empty_table_()));
+        fields.push_back(field_("logger", false, type_utf8, empty_table_()));
+        fields.push_back(field_("thread", false, type_int, int_type_(64, false)));
+        fields.push_back(field_("source_file", true, type_utf8, empty_table_()));
+        fields.push_back(field_("source_line", true, type_int, int_type_(32, true)));
+        fields.push_back(field_("source_function", true, type_utf8, empty_table_()));
+        fields.push_back(field_("message", false, type_utf8, empty_table_()));
+
+        std::vector<flatbuffer_builder::offset> entries{
+            field_("key", false, type_utf8, empty_table_()),
+            field_("value", true, type_utf8, empty_table_())};
+        auto entries_field = field_("entries", false, type_struct, empty_table_(),
+                                    fb.create_offsets(entries));
+        fb.start_table();
+        fb.add_scalar<std::uint8_t>(0, 0);  // the keys aren't sorted
+        auto map = fb.end_table();
+        fields.push_back(field_("fields", false, type_map, map,
+                                fb.create_offsets(std::vector<flatbuffer_builder::offset>{
+                                    entries_field})));
+
+        auto fields_vector = fb.create_offsets(fields);
+        fb.start_table();
+        fb.add_scalar<std::int16_t>(0, little_endian_() ? 0 : 1);
+        fb.add_offset(1, fields_vector);
+        auto schema = fb.end_table();
+        append_message_(dest, header_schema, schema, 0);
+    }
+
+    // the record batch message of the rows added, which are cleared
+    void append_batch(memory_buf_t &dest) {
+        body_.clear();
+        nodes_.clear();
+        buffers_.clear();
+        auto rows = static_cast<std::int64_t>(times_.size());
+        auto entries = static_cast<std::int64_t>(keys_.offsets.size() - 1);
+
+        add_node_(rows, 0);  // time
+        add_buffer_(nullptr, 0);
+        add_vector_(times_);
+        add_text_node_(level_, rows);
+        add_text_node_(logger_, rows);
+        add_node_(rows, 0);  // thread
+        add_buffer_(nullptr, 0);
+        add_vector_(threads_);
+        build_source_validity_();
+        add_text_node_(file_, rows, source_nulls_);
+        add_node_(rows, source_nulls_);  // source_line
+        add_validity_(source_nulls_);
+        add_vector_(lines_);
+        add_text_node_(function_, rows, source_nulls_);
+        add_text_node_(message_, rows);
+        add_node_(rows, 0);  // fields
+        add_buffer_(nullptr, 0);
+        add_vector_(field_offsets_);
+        add_node_(entries, 0);  // entries
+        add_buffer_(nullptr, 0);
+        add_text_node_(keys_, entries);
+        add_text_node_(values_, entries);
+
+        auto &fb = builder_;
+        fb.clear();
+        auto buffers = fb.create_structs(buffers_, 16);
+        auto nodes = fb.create_structs(nodes_, 16);
+        fb.start_table();
+        fb.add_scalar<std::int64_t>(0, rows);
+        fb.add_offset(1, nodes);
+        fb.add_offset(2, buffers);
+        auto batch = fb.end_table();
+        append_message_(dest, header_record_batch, batch, body_.size());
+        dest.append(body_.data(), body_.data() + body_.size());
+        clear();
+    }
+
+    // the end of the stream
+    static void append_end(memory_buf_t &dest) {
+        static const char end[8] = {'\xff', '\xff', '\xff', '\xff', 0, 0, 0, 0};
+        dest.append(end, end + sizeof(end));
+    }
+
+private:
+    struct text_column {
+        std::vector<std::int32_t> offsets;
+        std::string data;
+
+        void add(string_view_t value) {
+            data.append(value.data(), value.size());
+            offsets.push_back(static_cast<std::int32_t>(data.size()));
+        }
+
+        void clear() {
+            offsets.assign(1, 0);
+            data.clear();
+        }
+    };
+
+    enum : std::uint8_t {
+        type_int = 2,
+        type_utf8 = 5,
+        type_timestamp = 10,
+        type_struct = 13,
+        type_map = 17
+    };
+    enum : std::uint8_t { header_schema = 1, header_record_batch = 3 };
+
+    std::vector<std::int64_t> times_;
+    text_column level_;
+    text_column logger_;
+    std::vector<std::uint64_t> threads_;
+    std::vector<bool> source_valid_;
+    std::int64_t source_nulls_ = 0;
+    text_column file_;
+    std::vector<std::int32_t> lines_;
+    text_column function_;
+    text_column message_;
+    std::vector<std::int32_t> field_offsets_;
+    text_column keys_;
+    text_column values_;
+    memory_buf_t value_buf_;
+
+    flatbuffer_builder builder_;
+    std::string body_;
+    std::string source_validity_;
+    std::vector<std::int64_t> nodes_;    // length, null count
+    std::vector<std::int64_t> buffers_;  // offset, length
+
+    static bool little_endian_() {
+        const std::uint16_t one = 1;
+        char first;
+        std::memcpy(&first, &one, 1);
+        return first == 1;
+    }
+
+    flatbuffer_builder::offset empty_table_() {
+        builder_.start_table();
+        return builder_.end_table();
+    }
+
+    flatbuffer_builder::offset int_type_(std::int32_t bits, bool is_signed) {
+        builder_.start_table();
+        builder_.add_scalar<std::int32_t>(0, bits);
+        builder_.add_scalar<std::uint8_t>(1, is_signed ? 1 : 0);
+        return builder_.end_table();
+    }
+
+    // children is always set, arrow's reader requiring it
+    flatbuffer_builder::offset field_(string_view_t name,
+                                      bool nullable,
+                                      std::uint8_t type_type,
+                                      flatbuffer_builder::offset type,
+                                      flatbuffer_builder::offset children = 0) {
+        auto &fb = builder_;
+        auto name_offset = fb.create_string(name);
+        if (children == 0) {
+            children = fb.create_offsets(std::vector<flatbuffer_builder::offset>{});
+        }
+        fb.start_table();
+        fb.add_offset(0, name_offset);
+        fb.add_scalar<std::uint8_t>(1, nullable ? 1 : 0);
+        fb.add_scalar<std::uint8_t>(2, type_type);
+        fb.add_offset(3, type);
+        fb.add_offset(5, children);
+        return fb.end_table();
+    }
+
+    // the metadata (after its size, padded to 8 bytes), then the body
+    void append_message_(memory_buf_t &dest,
+                         std::uint8_t header_type,
+                         flatbuffer_builder::offset header,
+                         size_t body_length) {
+        auto &fb = builder_;
+        fb.start_table();
+        fb.add_scalar<std::int64_t>(3, static_cast<std::int64_t>(body_length));
+        fb.add_offset(2, header);
+        fb.add_scalar<std::int16_t>(0, 4);  // metadata version V5
+        fb.add_scalar<std::uint8_t>(1, header_type);
+        auto metadata = fb.finish(fb.end_table());
+        auto padded = (metadata.size() + 7) / 8 * 8;
+        char prefix[8] = {'\xff', '\xff', '\xff', '\xff'};
+        for (size_t i = 0; i < 4; i++) {
+            prefix[4 + i] = static_cast<char>((padded >> (8 * i)) & 0xff);
+        }
+        dest.append(prefix, prefix + sizeof(prefix));
+        dest.append(metadata.data(), metadata.data() + metadata.size());
+        static const char zeros[8] = {};
+        dest.append(zeros, zeros + (padded - metadata.size()));
+    }
+
+    void add_node_(std::int64_t length, std::int64_t null_count) {
+        nodes_.push_back(length);
+        nodes_.push_back(null_count);
+    }
+
+    // each buffer at an offset multiple of 8 in the body
+    void add_buffer_(const void *data, size_t size) {
+        buffers_.push_back(static_cast<std::int64_t>(body_.size()));
+        buffers_.push_back(static_cast<std::int64_t>(size));
+        if (size > 0) {
+            body_.append(static_cast<const char *>(data), size);
+        }
+        body_.append((8 - size % 8) % 8, '\0');
+    }
+
+    template <typename T>
+    void add_vector_(const std::vector<T> &values) {
+        add_buffer_(values.data(), values.size() * sizeof(T));
+    }
+
+    // the nulls being the messages without a source, the only nullable columns
+    void add_text_node_(const text_column &column, std::int64_t length, std::int64_t nulls = 0) {
+        add_node_(length, nulls);
+        add_validity_(nulls);
+        add_vector_(column.offsets);
+        add_buffer_(column.data.data(), column.data.size());
+    }
+
+    void build_source_validity_() {
+        source_validity_.assign((source_valid_.size() + 7) / 8, '\0');
+        for (size_t i = 0; i < source_valid_.size(); i++) {
+            if (source_valid_[i]) {
+                source_validity_[i / 8] =
+                    static_cast<char>(source_validity_[i / 8] | (1 << (i % 8)));
+            }
+        }
+    }
+
+    // none without nulls
+    void add_validity_(std::int64_t nulls) {
+        if (nulls > 0) {
+            add_buffer_(source_validity_.data(), source_validity_.size());
+        } else {
+            add_buffer_(nullptr, 0);
+        }
+    }
+};
+
+}  // namespace arrow
+}  // namespace details
+}  // namespace spdlog
@@ -6,58 +6,180 @@
 #ifndef SPDLOG_HEADER_ONLY
     #include <spdlog/details/backtracer.h>
 #endif
+
+#include <algorithm>
+#include <thread>
+
 namespace spdlog {
 namespace details {
 SPDLOG_INLINE backtracer::backtracer(const backtracer &other) {
-    std::lock_guard<std::mutex> lock(other.mutex_);
     enabled_ = other.enabled();
-    messages_ = other.messages_;
+    auto *other_state = other.state_.load(std::memory_order_acquire);
+    if (other_state == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(other_state->mutex);
+    auto *other_ring = other_state->current.load(std::memory_order_acquire);
+    if (other_ring == nullptr) {
+        return;
+    }
+    std::vector<entry> messages;
+    collect_(*other_ring, messages);
+    auto &s = state_or_create_();
+    s.rings.push_back(details::make_unique<ring>(other_ring->size));
+    s.current.store(s.rings.back().get(), std::memory_order_release);
+    for (auto &e : messages) {
+        push_back(e.msg, e.format_fn);
+    }
 }
 
 SPDLOG_INLINE backtracer::backtracer(backtracer &&other) SPDLOG_NOEXCEPT {
-    std::lock_guard<std::mutex> lock(other.mutex_);
     enabled_ = other.enabled();
-    messages_ = std::move(other.messages_);
+    state_.store(other.state_.exchange(nullptr), std::memory_order_release);
 }
 
 SPDLOG_INLINE backtracer &backtracer::operator=(backtracer other) {
-    std::lock_guard<std::mutex> lock(mutex_);
     enabled_ = other.enabled();
-    messages_ = std::move(other.messages_);
+    auto *other_state = other.state_.load(std::memory_order_relaxed);
+    auto *current = state_.load(std::memory_order_acquire);
+    if (other_state == nullptr && current == nullptr) {
+        return *this;
+    }
+    auto &s = state_or_create_();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (other_state == nullptr) {
+        s.current.store(nullptr, std::memory_order_release);
+        return *this;
+    }
+    // the current rings are kept, in case of a concurrent push_back()
+    for (auto &r : other_state->rings) {
+        s.rings.push_back(std::move(r));
+    }
+    s.current.store(other_state->current.load(std::memory_order_relaxed),
+                    std::memory_order_release);
     return *this;
 }
 
+SPDLOG_INLINE backtracer::~backtracer() { delete state_.load(std::memory_order_acquire); }
+
+SPDLOG_INLINE backtracer::state &backtracer::state_or_create_() {
+    auto *s = state_.load(std::memory_order_acquire);
+    if (s != nullptr) {
+        return *s;
+    }
+    auto created = details::make_unique<state>();
+    if (state_.compare_exchange_strong(s, created.get(), std::memory_order_acq_rel)) {
+        return *created.release();
+    }
+    return *s;  // set by a concurrent call
+}
+
+SPDLOG_INLINE backtracer::ring *backtracer::ring_() const {
+    auto *s = state_.load(std::memory_order_acquire);
+    return s == nullptr ? nullptr : s->current.load(std::memory_order_acquire);
+}
+
 SPDLOG_INLINE void backtracer::enable(size_t size) {
-    std::lock_guard<std::mutex> lock{mutex_};
+    auto &s = state_or_create_();
+    std::lock_guard<std::mutex> lock{s.mutex};
     enabled_.store(true, std::memory_order_relaxed);
-    messages_ = circular_q<log_msg_buffer>{size};
+    auto *current = s.current.load(std::memory_order_relaxed);
+    if (current != nullptr && current->size == size) {
+        current->popped = current->head.load(std::memory_order_acquire);  // cleared
+        return;
+    }
+    s.rings.push_back(details::make_unique<ring>(size));
+    s.current.store(s.rings.back().get(), std::memory_order_release);
 }
 
-SPDLOG_INLINE void backtracer::disable() {
-    std::lock_guard<std::mutex> lock{mutex_};
-    enabled_.store(false, std::memory_order_relaxed);
-}
+SPDLOG_INLINE void backtracer::disable() { enabled_.store(false, std::memory_order_relaxed); }
 
 SPDLOG_INLINE bool backtracer::enabled() const { return enabled_.load(std::memory_order_relaxed); }
 
-SPDLOG_INLINE void backtracer::push_back(const log_msg &msg) {
-    std::lock_guard<std::mutex> lock{mutex_};
-    messages_.push_back(log_msg_buffer{msg});
+SPDLOG_INLINE void backtracer::push_back(const log_msg &msg, deferred_format_fn format_fn) {
+    auto *r = ring_();
+    if (r == nullptr || r->size == 0) {
+        return;
+    }
+    auto ticket = r->head.fetch_add(1, std::memory_order_relaxed);
+    auto &s = r->at(ticket);
+    // only busy if another thread is writing the message one lap before or after, or if it
+    // is being dumped
+    while (s.busy.exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    if (s.seq <= ticket) {  // not overwritten by the next lap already
+        s.msg.assign(msg);
+        s.format_fn = format_fn;
+        s.seq = ticket + 1;
+    }
+    s.busy.store(false, std::memory_order_release);
 }
 
 SPDLOG_INLINE bool backtracer::empty() const {
-    std::lock_guard<std::mutex> lock{mutex_};
-    return messages_.empty();
+    auto *s = state_.load(std::memory_order_acquire);
+    if (s == nullptr) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock{s->mutex};
+    auto *r = s->current.load(std::memory_order_relaxed);
+    return r == nullptr || r->head.load(std::memory_order_acquire) == r->popped;
 }
 
 // pop all items in the q and apply the given fun on each of them.
-SPDLOG_INLINE void backtracer::foreach_pop(std::function<void(const details::log_msg &)> fun) {
-    std::lock_guard<std::mutex> lock{mutex_};
-    while (!messages_.empty()) {
-        auto &front_msg = messages_.front();
-        fun(front_msg);
-        messages_.pop_front();
+SPDLOG_INLINE void backtracer::foreach_pop(
+    std::function<void(const details::log_msg &, deferred_format_fn)> fun) {
+    auto *s = state_.load(std::memory_order_acquire);
+    if (s == nullptr) {
+        return;
+    }
+    std::vector<entry> messages;
+    {
+        std::lock_guard<std::mutex> lock{s->mutex};
+        auto *r = s->current.load(std::memory_order_relaxed);
+        if (r == nullptr) {
+            return;
+        }
+        r->popped = collect_(*r, messages);
+    }
+    for (auto &e : messages) {
+        fun(e.msg, e.format_fn);
+    }
+}
+
+SPDLOG_INLINE void backtracer::visit_unsafe(void (*fn)(const log_msg &, deferred_format_fn, void *),
+                                            void *context) const {
+    auto *r = ring_();
+    if (r == nullptr || r->size == 0) {
+        return;
+    }
+    auto head = r->head.load(std::memory_order_acquire);
+    auto first = head > r->size ? head - r->size : 0;
+    first = (std::max)(first, r->popped);
+    for (auto ticket = first; ticket < head; ticket++) {
+        auto &s = r->at(ticket);
+        if (!s.busy.load(std::memory_order_acquire) && s.seq == ticket + 1) {
+            fn(s.msg, s.format_fn, context);
+        }
+    }
+}
+
+SPDLOG_INLINE std::uint64_t backtracer::collect_(ring &r, std::vector<entry> &messages) {
+    auto head = r.head.load(std::memory_order_acquire);
+    auto first = head > r.size ? head - r.size : 0;
+    first = (std::max)(first, r.popped);
+    messages.reserve(static_cast<size_t>(head - first));
+    for (auto ticket = first; ticket < head; ticket++) {
+        auto &s = r.at(ticket);
+        while (s.busy.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        if (s.seq == ticket + 1) {
+            messages.push_back(entry{s.msg, s.format_fn});
+        }
+        s.busy.store(false, std::memory_order_release);
     }
+    return head;
 }
 }  // namespace details
 }  // namespace spdlog
@@ -3,22 +3,86 @@
 
 #pragma once
 
-#include <spdlog/details/circular_q.h>
+#include <spdlog/details/deferred_args.h>
 #include <spdlog/details/log_msg_buffer.h>
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 // Store log messages in circular buffer.
 // Useful for storing debug data in case of error/warning happens.
+//
+// push_back() doesn't lock: it takes a ticket, and copies the message into the preallocated
+// slot of the ticket, each slot being written by one thread at a time. the messages are
+// dumped in the order of their tickets, those being written at the time are skipped.
+// a message can hold packed arguments instead of its payload, formatted only when dumped.
+//
+// a backtracer never enabled is two words: its mutex and rings are allocated by the first
+// enable(), so loggers which don't use it don't pay for it.
 
 namespace spdlog {
 namespace details {
 class SPDLOG_API backtracer {
-    mutable std::mutex mutex_;
+    struct slot {
+        std::atomic<bool> busy{false};
+        std::uint64_t seq = 0;  // ticket of msg + 1, 0 if empty
+        log_msg_buffer msg;
+        deferred_format_fn format_fn = nullptr;
+    };
+
+    struct entry {
+        log_msg_buffer msg;
+        deferred_format_fn format_fn;
+    };
+
+    // the last "size" tickets are kept, in a power of two of slots indexed by masking the ticket
+    struct ring {
+        explicit ring(size_t n)
+            : size{n},
+              mask{slot_count_(n) - 1},
+              slots{new slot[mask + 1]} {}
+
+        size_t size;
+        size_t mask;
+        std::unique_ptr<slot[]> slots;
+        // the producers' head on a cache line of its own
+        char head_padding[64];
+        std::atomic<std::uint64_t> head{0};  // next ticket
+        char popped_padding[64];
+        std::uint64_t popped = 0;  // the tickets below were dumped (under mutex_)
+
+        slot &at(std::uint64_t ticket) { return slots[static_cast<size_t>(ticket & mask)]; }
+
+        static size_t slot_count_(size_t n) {
+            size_t count = 1;
+            while (count < n) {
+                count <<= 1;
+            }
+            return count;
+        }
+    };
+
+    struct state {
+        std::mutex mutex;  // guards all but push_back()
+        std::atomic<ring *> current{nullptr};
+        // the rings of all the enable() calls: a push_back() can still be writing to a previous
+        // one
+        std::vector<std::unique_ptr<ring>> rings;
+    };
+
     std::atomic<bool> enabled_{false};
-    circular_q<log_msg_buffer> messages_;
+    std::atomic<state *> state_{nullptr};  // set by the first enable(), then kept
+
+    // the state, allocated if not yet
+    state &state_or_create_();
+    // the current ring, null if never enabled
+    ring *ring_() const;
+    // copy the messages not dumped yet, in order. return the next ticket
+    static std::uint64_t collect_(ring &r, std::vector<entry> &messages);
 
 public:
     backtracer() = default;
@@ -26,15 +90,24 @@ public:
 
     backtracer(backtracer &&other) SPDLOG_NOEXCEPT;
     backtracer &operator=(backtracer other);
+    ~backtracer();
 
     void enable(size_t size);
     void disable();
     bool enabled() const;
-    void push_back(const log_msg &msg);
+    // format_fn is set if msg.payload holds packed arguments (see deferred_args.h)
+    void push_back(const log_msg &msg, deferred_format_fn format_fn = nullptr);
     bool empty() const;
 
-    // pop all items in the q and apply the given fun on each of them.
-    void foreach_pop(std::function<void(const details::log_msg &)> fun);
+    // pop all items in the q and apply the given fun on each of them, with the function
+    // formatting their payload if they were pushed with one.
+    void foreach_pop(std::function<void(const details::log_msg &, deferred_format_fn)> fun);
+
+    // call fn(msg, format_fn, context) on each message not dumped yet, in order, without
+    // locking, waiting nor allocating (for a crash handler). the messages being written are
+    // skipped.
+    void visit_unsafe(void (*fn)(const log_msg &, deferred_format_fn, void *),
+                      void *context) const;
 };
 
 }  // namespace details
@@ -0,0 +1,52 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Generation of the logging levels, for the callsites of the logging macros (e.g. SPDLOG_TRACE)
+// to cache whether they are enabled: bumped when a logger's level or backtrace changes, the
+// default logger is replaced, or the levels per source file are set, which makes all the
+// callsites check again.
+//
+// Disabled with windows dlls, each module having its own copy of the generation.
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(_WIN32) && defined(SPDLOG_SHARED_LIB)
+    #define SPDLOG_NO_CALLSITE_CACHE
+#endif
+
+namespace spdlog {
+namespace details {
+
+// a template for a single definition in the header
+template <typename T = void>
+struct level_generation_holder {
+    static std::atomic<std::uint32_t> value;
+};
+
+template <typename T>
+std::atomic<std::uint32_t> level_generation_holder<T>::value{1};
+
+// the callsites store the generation in 28 bits, above their state, and 0 means not cached yet
+constexpr std::uint32_t level_generation_mask = 0x0fffffff;
+constexpr int callsite_state_bits = 4;
+constexpr std::uint32_t callsite_state_mask = 0xf;
+
+inline std::uint32_t level_generation() {
+    return level_generation_holder<>::value.load(std::memory_order_acquire) &
+           level_generation_mask;
+}
+
+// after the change, so that a callsite seeing the new generation sees the change
+inline void bump_level_generation() {
+    auto &generation = level_generation_holder<>::value;
+    auto next = generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+    if ((next & level_generation_mask) == 0) {
+        generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+}  // namespace details
+}  // namespace spdlog
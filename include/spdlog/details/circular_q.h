@@ -2,22 +2,41 @@
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 
 // circular q view of std::vector.
+//
+// The storage is rounded up to a power of two, indexed by masking the head and tail, which only
+// increase (their difference is the size), instead of wrapping them with '%'. It still holds
+// max_items at most. The consumer's head and the producer's tail are on separate cache lines.
 #pragma once
 
 #include <cassert>
+#include <memory>
 #include <vector>
 
 #include "spdlog/common.h"
 
 namespace spdlog {
 namespace details {
-template <typename T>
+template <typename T, typename Alloc = std::allocator<T>>
 class circular_q {
+    static constexpr size_t cache_line_size = 64;
+
     size_t max_items_ = 0;
-    typename std::vector<T>::size_type head_ = 0;
-    typename std::vector<T>::size_type tail_ = 0;
+    size_t mask_ = 0;
+    std::vector<T, Alloc> v_;  // empty if disabled
+    char head_padding_[cache_line_size];
+    size_t head_ = 0;
+    char tail_padding_[cache_line_size];
+    size_t tail_ = 0;
     size_t overrun_counter_ = 0;
-    std::vector<T> v_;
+    char end_padding_[cache_line_size];
+
+    static size_t storage_size_(size_t max_items) {
+        size_t n = 1;
+        while (n < max_items) {
+            n <<= 1;
+        }
+        return n;
+    }
 
 public:
     using value_type = T;
@@ -25,10 +44,10 @@ public:
     // empty ctor - create a disabled queue with no elements allocated at all
     circular_q() = default;
 
-    explicit circular_q(size_t max_items)
-        : max_items_(max_items + 1)  // one item is reserved as marker for full q
-          ,
-          v_(max_items_) {}
+    explicit circular_q(size_t max_items, const Alloc &alloc = Alloc())
+        : max_items_(max_items),
+          mask_(storage_size_(max_items) - 1),
+          v_(mask_ + 1, alloc) {}
 
     circular_q(const circular_q &) = default;
     circular_q &operator=(const circular_q &) = default;
@@ -44,53 +63,47 @@ public:
 
     // push back, overrun (oldest) item if no room left
     void push_back(T &&item) {
-        if (max_items_ > 0) {
-            v_[tail_] = std::move(item);
-            tail_ = (tail_ + 1) % max_items_;
-
-            if (tail_ == head_)  // overrun last item if full
-            {
-                head_ = (head_ + 1) % max_items_;
-                ++overrun_counter_;
-            }
+        if (v_.empty()) {
+            return;
+        }
+        if (max_items_ == 0) {
+            ++overrun_counter_;
+            return;
         }
+        if (size() == max_items_)  // overrun last item if full
+        {
+            // release what the overrun item holds now, not when its slot is reused
+            v_[head_ & mask_] = T();
+            ++head_;
+            ++overrun_counter_;
+        }
+        v_[tail_ & mask_] = std::move(item);
+        ++tail_;
     }
 
     // Return reference to the front item.
     // If there are no elements in the container, the behavior is undefined.
-    const T &front() const { return v_[head_]; }
+    const T &front() const { return v_[head_ & mask_]; }
 
-    T &front() { return v_[head_]; }
+    T &front() { return v_[head_ & mask_]; }
 
     // Return number of elements actually stored
-    size_t size() const {
-        if (tail_ >= head_) {
-            return tail_ - head_;
-        } else {
-            return max_items_ - (head_ - tail_);
-        }
-    }
+    size_t size() const { return tail_ - head_; }
 
     // Return const reference to item by index.
     // If index is out of range 0…size()-1, the behavior is undefined.
     const T &at(size_t i) const {
         assert(i < size());
-        return v_[(head_ + i) % max_items_];
+        return v_[(head_ + i) & mask_];
     }
 
     // Pop item from front.
     // If there are no elements in the container, the behavior is undefined.
-    void pop_front() { head_ = (head_ + 1) % max_items_; }
+    void pop_front() { ++head_; }
 
     bool empty() const { return tail_ == head_; }
 
-    bool full() const {
-        // head is ahead of the tail by 1
-        if (max_items_ > 0) {
-            return ((tail_ + 1) % max_items_) == head_;
-        }
-        return false;
-    }
+    bool full() const { return !v_.empty() && size() == max_items_; }
 
     size_t overrun_counter() const { return overrun_counter_; }
 
@@ -100,6 +113,7 @@ private:
     // copy from other&& and reset it to disabled state
     void copy_moveable(circular_q &&other) SPDLOG_NOEXCEPT {
         max_items_ = other.max_items_;
+        mask_ = other.mask_;
         head_ = other.head_;
         tail_ = other.tail_;
         overrun_counter_ = other.overrun_counter_;
@@ -107,6 +121,8 @@ private:
 
         // put &&other in disabled, but valid state
         other.max_items_ = 0;
+        other.mask_ = 0;
+        other.v_.clear();
         other.head_ = other.tail_ = 0;
         other.overrun_counter_ = 0;
     }
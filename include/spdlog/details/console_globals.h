@@ -3,18 +3,29 @@
 
 #pragma once
 
+#include <cstdio>
 #include <mutex>
 #include <spdlog/details/null_mutex.h>
 
 namespace spdlog {
 namespace details {
 
+// the console sinks writing to the same stream share its lock: stdout's (mutex()) or stderr's,
+// so that a slow stdout doesn't hold the messages to stderr
 struct console_mutex {
     using mutex_t = std::mutex;
     static mutex_t &mutex() {
         static mutex_t s_mutex;
         return s_mutex;
     }
+
+    static mutex_t &mutex(FILE *file) {
+        if (file == stderr) {
+            static mutex_t s_stderr_mutex;
+            return s_stderr_mutex;
+        }
+        return mutex();
+    }
 };
 
 struct console_nullmutex {
@@ -23,6 +34,8 @@ struct console_nullmutex {
         static mutex_t s_mutex;
         return s_mutex;
     }
+
+    static mutex_t &mutex(FILE *) { return mutex(); }
 };
 }  // namespace details
 }  // namespace spdlog
@@ -0,0 +1,114 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Append a payload escaping or stripping its control chars (below 0x20, and 0x7f), so that a
+// message can't forge log lines (see pattern_formatter::set_control_chars()).
+// The payload is scanned 16 bytes at a time (SSE2) or 8 bytes at a time (elsewhere), and the
+// runs without any control char are appended as is.
+
+#include <spdlog/common.h>
+#include <spdlog/details/fmt_helper.h>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SPDLOG_CONTROL_CHARS_SSE2
+#endif
+
+namespace spdlog {
+namespace details {
+
+inline bool is_control_char(unsigned char ch) { return ch < 0x20 || ch == 0x7f; }
+
+// position of the first control char in [begin, end), or end
+inline const char *find_control_char(const char *begin, const char *end) {
+    auto *p = begin;
+#ifdef SPDLOG_CONTROL_CHARS_SSE2
+    const __m128i del = _mm_set1_epi8(0x7f);
+    // unsigned ch < 0x20 as a signed compare, with the sign bits flipped
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i control = _mm_set1_epi8(static_cast<char>(0x20 ^ 0x80));
+    for (; end - p >= 16; p += 16) {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chars, del),
+                                     _mm_cmplt_epi8(_mm_xor_si128(chars, sign), control));
+        if (_mm_movemask_epi8(found) != 0) {
+            for (; !is_control_char(static_cast<unsigned char>(*p)); ++p) {
+            }
+            return p;
+        }
+    }
+#else
+    const std::uint64_t ones = 0x0101010101010101ull;
+    const std::uint64_t highs = 0x8080808080808080ull;
+    for (; end - p >= 8; p += 8) {
+        std::uint64_t chars;
+        std::memcpy(&chars, p, sizeof(chars));
+        // a byte < 0x20, or equal to 0x7f
+        auto del = chars ^ (ones * 0x7f);
+        auto found = ((chars - ones * 0x20) & ~chars & highs) | ((del - ones) & ~del & highs);
+        if (found != 0) {
+            for (; !is_control_char(static_cast<unsigned char>(*p)); ++p) {
+            }
+            return p;
+        }
+    }
+#endif
+    for (; p != end && !is_control_char(static_cast<unsigned char>(*p)); ++p) {
+    }
+    return p;
+}
+
+// the size append_control_chars() appends
+inline size_t control_chars_size(string_view_t str, control_chars mode) {
+    auto size = str.size();
+    if (mode == control_chars::keep) {
+        return size;
+    }
+    auto *end = str.data() + str.size();
+    for (auto *p = find_control_char(str.data(), end); p != end;
+         p = find_control_char(p + 1, end)) {
+        if (mode == control_chars::strip) {
+            size--;
+        } else {
+            size += *p == '\n' || *p == '\r' || *p == '\t' ? 1 : 3;
+        }
+    }
+    return size;
+}
+
+// "\n", "\r" and "\t" when escaped, the other ones as "\x1b"
+inline void append_control_chars(string_view_t str, control_chars mode, memory_buf_t &dest) {
+    if (mode == control_chars::keep) {
+        fmt_helper::append_string_view(str, dest);
+        return;
+    }
+    auto *p = str.data();
+    auto *end = p + str.size();
+    for (;;) {
+        auto *run_end = find_control_char(p, end);
+        dest.append(p, run_end);
+        if (run_end == end) {
+            return;
+        }
+        if (mode == control_chars::escape) {
+            auto ch = static_cast<unsigned char>(*run_end);
+            const char *hex = "0123456789abcdef";
+            char escaped[4] = {'\\', 'x', hex[ch >> 4], hex[ch & 0xf]};
+            size_t size = 4;
+            if (ch == '\n' || ch == '\r' || ch == '\t') {
+                escaped[1] = ch == '\n' ? 'n' : ch == '\r' ? 'r' : 't';
+                size = 2;
+            }
+            dest.append(escaped, escaped + size);
+        }
+        p = run_end + 1;
+    }
+}
+
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,182 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Support for async loggers formatting on the worker thread instead of the caller thread.
+// The caller packs the format string and the arguments into a plain byte buffer, together
+// with a pointer to the function able to unpack and format them later.
+// Only arithmetic and string arguments can be packed (strings are copied). Calls with any
+// other argument type are formatted on the caller thread as usual.
+//
+// Packed layout: [format string][arg 1]...[arg n]
+// where strings are stored as their size followed by their chars, and arithmetic values
+// as their raw bytes.
+
+#include <spdlog/common.h>
+#include <spdlog/details/fmt_helper.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace spdlog {
+namespace details {
+
+// format the packed buffer into dest
+using deferred_format_fn = void (*)(string_view_t packed, memory_buf_t &dest);
+
+namespace deferred {
+
+template <typename T>
+struct is_string
+    : std::integral_constant<bool,
+                             std::is_same<T, char *>::value ||
+                                 std::is_same<T, const char *>::value ||
+                                 std::is_same<T, std::string>::value ||
+                                 std::is_same<T, string_view_t>::value> {};
+
+template <typename T>
+struct is_arithmetic
+    : std::integral_constant<bool,
+                             std::is_arithmetic<T>::value && !std::is_same<T, wchar_t>::value &&
+                                 !std::is_same<T, char16_t>::value &&
+                                 !std::is_same<T, char32_t>::value> {};
+
+template <typename T>
+struct is_packable
+    : std::integral_constant<bool, is_string<T>::value || is_arithmetic<T>::value> {};
+
+template <typename... Args>
+struct all_packable : std::true_type {};
+
+template <typename T, typename... Rest>
+struct all_packable<T, Rest...>
+    : std::integral_constant<bool,
+                             is_packable<typename std::decay<T>::type>::value &&
+                                 all_packable<Rest...>::value> {};
+
+// type an argument is unpacked to
+template <typename T, bool = is_string<T>::value>
+struct stored {
+    using type = T;
+};
+
+template <typename T>
+struct stored<T, true> {
+    using type = string_view_t;
+};
+
+template <typename T>
+using stored_t = typename stored<typename std::decay<T>::type>::type;
+
+inline void pack_string(memory_buf_t &dest, string_view_t s) {
+    size_t size = s.size();
+    auto size_bytes = reinterpret_cast<const char *>(&size);
+    dest.append(size_bytes, size_bytes + sizeof(size));
+    dest.append(s.data(), s.data() + s.size());
+}
+
+inline const char *unpack_string(const char *p, string_view_t &s) {
+    size_t size;
+    std::memcpy(&size, p, sizeof(size));
+    p += sizeof(size);
+    s = string_view_t(p, size);
+    return p + size;
+}
+
+inline bool pack_arg(memory_buf_t &dest, const char *s) {
+    if (s == nullptr) {
+        return false;
+    }
+    pack_string(dest, string_view_t(s, std::char_traits<char>::length(s)));
+    return true;
+}
+
+inline bool pack_arg(memory_buf_t &dest, const std::string &s) {
+    pack_string(dest, string_view_t(s.data(), s.size()));
+    return true;
+}
+
+inline bool pack_arg(memory_buf_t &dest, string_view_t s) {
+    pack_string(dest, s);
+    return true;
+}
+
+template <typename T, typename std::enable_if<is_arithmetic<T>::value, int>::type = 0>
+bool pack_arg(memory_buf_t &dest, T value) {
+    auto bytes = reinterpret_cast<const char *>(&value);
+    dest.append(bytes, bytes + sizeof(T));
+    return true;
+}
+
+inline bool pack_args(memory_buf_t &) { return true; }
+
+template <typename T, typename... Rest>
+bool pack_args(memory_buf_t &dest, const T &arg, const Rest &...rest) {
+    return pack_arg(dest, arg) && pack_args(dest, rest...);
+}
+
+template <typename T>
+const char *unpack_arg(const char *p, T &value) {
+    std::memcpy(&value, p, sizeof(T));
+    return p + sizeof(T);
+}
+
+inline const char *unpack_arg(const char *p, string_view_t &value) {
+    return unpack_string(p, value);
+}
+
+// unpack the remaining Rest arguments one by one, then format with all of them
+template <typename... Rest>
+struct unpacker;
+
+template <>
+struct unpacker<> {
+    template <typename... Done>
+    static void format(string_view_t fmt, const char *, memory_buf_t &dest, Done &...done) {
+#ifdef SPDLOG_USE_STD_FORMAT
+        fmt_helper::vformat_to(dest, fmt, fmt_lib::make_format_args(done...));
+#else
+        fmt::vformat_to(fmt::appender(dest), fmt, fmt::make_format_args(done...));
+#endif
+    }
+};
+
+template <typename T, typename... Rest>
+struct unpacker<T, Rest...> {
+    template <typename... Done>
+    static void format(string_view_t fmt, const char *p, memory_buf_t &dest, Done &...done) {
+        T value;
+        p = unpack_arg(p, value);
+        unpacker<Rest...>::format(fmt, p, dest, done..., value);
+    }
+};
+
+template <typename... Stored>
+void format_packed(string_view_t packed, memory_buf_t &dest) {
+    string_view_t fmt;
+    const char *p = unpack_string(packed.data(), fmt);
+    unpacker<Stored...>::format(fmt, p, dest);
+}
+}  // namespace deferred
+
+template <typename... Args>
+using is_deferrable = deferred::all_packable<Args...>;
+
+// pack the format string and the arguments into dest.
+// return false if they can't be deferred (null char pointer).
+template <typename... Args>
+bool pack_deferred(memory_buf_t &dest, string_view_t fmt, const Args &...args) {
+    deferred::pack_string(dest, fmt);
+    return deferred::pack_args(dest, args...);
+}
+
+// the function formatting what pack_deferred(dest, fmt, args...) produced
+template <typename... Args>
+deferred_format_fn deferred_formatter() {
+    return &deferred::format_packed<deferred::stored_t<Args>...>;
+}
+
+}  // namespace details
+}  // namespace spdlog
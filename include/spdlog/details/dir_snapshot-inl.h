@@ -0,0 +1,29 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/details/dir_snapshot.h>
+#endif
+
+#include <spdlog/details/os.h>
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE bool dir_snapshot::exists(const filename_t &path) {
+    auto dir = os::dir_name(path);
+    auto it = dirs_.find(dir);
+    if (it == dirs_.end()) {
+        auto names = os::list_dir(dir);
+        it = dirs_.emplace(dir, std::unordered_set<filename_t>(names.begin(), names.end())).first;
+    }
+    if (it->second.empty()) {
+        return os::path_exists(path);
+    }
+    return it->second.count(path.substr(dir.empty() ? 0 : dir.size() + 1)) > 0;
+}
+
+}  // namespace details
+}  // namespace spdlog
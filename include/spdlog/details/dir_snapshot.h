@@ -0,0 +1,33 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <spdlog/common.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace spdlog {
+namespace details {
+
+// Answers path_exists() questions from one listing of each dir, read on first use, so probing
+// many file names (e.g. when rebuilding the retention queue of a time based sink) costs a readdir
+// per dir instead of a stat per name. Doesn't see the changes made after the listing.
+class SPDLOG_API dir_snapshot {
+public:
+    bool exists(const filename_t &path);
+
+private:
+    // the names in each dir listed so far. an empty set falls back to path_exists(), as the
+    // listing might have failed.
+    std::unordered_map<filename_t, std::unordered_set<filename_t>> dirs_;
+};
+
+}  // namespace details
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "dir_snapshot-inl.h"
+#endif
@@ -13,13 +13,54 @@
 #include <cerrno>
 #include <chrono>
 #include <cstdio>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <tuple>
+#include <unordered_set>
 
 namespace spdlog {
 namespace details {
 
+struct file_helper::dir_cache {
+    static constexpr size_t max_size = 4096;  // cleared when reached
+    std::mutex mutex;
+    std::unordered_set<filename_t> dirs;
+};
+
+SPDLOG_INLINE file_helper::dir_cache &file_helper::dir_cache_() {
+    static dir_cache instance;
+    return instance;
+}
+
+SPDLOG_INLINE bool file_helper::create_dir_(const filename_t &dir) {
+    if (dir.empty()) {
+        return false;  // the current directory
+    }
+    auto &cache = dir_cache_();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if (cache.dirs.count(dir) != 0) {
+            return true;
+        }
+    }
+    if (!os::create_dir(dir)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.dirs.size() >= dir_cache::max_size) {
+        cache.dirs.clear();
+    }
+    cache.dirs.insert(dir);
+    return false;
+}
+
+SPDLOG_INLINE void file_helper::forget_dir_(const filename_t &dir) {
+    auto &cache = dir_cache_();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.dirs.erase(dir);
+}
+
 SPDLOG_INLINE file_helper::file_helper(const file_event_handlers &event_handlers)
     : event_handlers_(event_handlers) {}
 
@@ -35,9 +76,10 @@ SPDLOG_INLINE void file_helper::open(const filename_t &fname, bool truncate) {
     if (event_handlers_.before_open) {
         event_handlers_.before_open(filename_);
     }
+    auto dir = os::dir_name(fname);
     for (int tries = 0; tries < open_tries_; ++tries) {
         // create containing folder if not exists already.
-        os::create_dir(os::dir_name(fname));
+        bool known_dir = create_dir_(dir);
         if (truncate) {
             // Truncate by opening-and-closing a tmp file in "wb" mode, always
             // opening the actual log-we-write-to in "ab" mode, since that
@@ -45,6 +87,9 @@ SPDLOG_INLINE void file_helper::open(const filename_t &fname, bool truncate) {
             // rotate/truncate the file underneath us.
             std::FILE *tmp;
             if (os::fopen_s(&tmp, fname, trunc_mode)) {
+                if (known_dir) {
+                    forget_dir_(dir);  // may have been removed: create it again at once
+                }
                 continue;
             }
             std::fclose(tmp);
@@ -53,9 +98,32 @@ SPDLOG_INLINE void file_helper::open(const filename_t &fname, bool truncate) {
             if (event_handlers_.after_open) {
                 event_handlers_.after_open(filename_, fd_);
             }
+            if (direct_()) {
+                std::fflush(fd_);  // what the handler wrote goes first
+                buffer_.reserve(event_handlers_.write_buffer_size);
+            }
+            unsynced_ = 0;
+            last_sync_ = std::chrono::steady_clock::now();
+            if (event_handlers_.preallocate_size != 0) {
+                std::fflush(fd_);
+                written_ = os::filesize(fd_);
+                allocated_ = 0;
+                preallocate_(0);
+            }
+            if (indexed()) {
+                std::fflush(fd_);
+                offset_ = os::filesize(fd_);
+                unindexed_ = 0;
+                last_indexed_ = log_clock::time_point{};
+                index_.open(fname, truncate);
+            }
             return;
         }
 
+        if (known_dir) {
+            forget_dir_(dir);  // may have been removed: create it again at once
+            continue;
+        }
         details::os::sleep_for_millis(open_interval_);
     }
 
@@ -71,25 +139,43 @@ SPDLOG_INLINE void file_helper::reopen(bool truncate) {
 }
 
 SPDLOG_INLINE void file_helper::flush() {
-    if (std::fflush(fd_) != 0) {
+    index_.flush();
+    if (event_handlers_.write_buffer_size != 0) {
+        write_buffer_();
+    } else if (std::fflush(fd_) != 0) {
         throw_spdlog_ex("Failed flush to file " + os::filename_to_str(filename_), errno);
     }
+    if (unsynced_ > 0 && sync_due_()) {
+        sync_with_policy_();
+    }
 }
 
 SPDLOG_INLINE void file_helper::sync() {
-    if (!os::fsync(fd_)) {
-        throw_spdlog_ex("Failed to fsync file " + os::filename_to_str(filename_), errno);
+    write_buffer_();
+    if (event_handlers_.write_buffer_size == 0) {
+        std::fflush(fd_);
     }
+    sync_with_policy_();
 }
 
 SPDLOG_INLINE void file_helper::close() {
     if (fd_ != nullptr) {
+        if (!buffer_.empty()) {
+            os::write_fd(fd_, buffer_.data(), buffer_.size());  // closing anyway if it fails
+            buffer_.clear();
+        }
         if (event_handlers_.before_close) {
             event_handlers_.before_close(filename_, fd_);
         }
+        if (allocated_ > 0 && allocated_ != static_cast<size_t>(-1)) {
+            std::fflush(fd_);
+            (void)os::trim_preallocation(fd_);
+            allocated_ = 0;
+        }
 
         std::fclose(fd_);
         fd_ = nullptr;
+        index_.close();
 
         if (event_handlers_.after_close) {
             event_handlers_.after_close(filename_);
@@ -97,20 +183,114 @@ SPDLOG_INLINE void file_helper::close() {
     }
 }
 
-SPDLOG_INLINE void file_helper::write(const memory_buf_t &buf) {
+SPDLOG_INLINE void file_helper::write(const memory_buf_t &buf) { write(buf.data(), buf.size()); }
+
+SPDLOG_INLINE void file_helper::write(const char *data, size_t msg_size) {
     if (fd_ == nullptr) return;
-    size_t msg_size = buf.size();
-    auto data = buf.data();
-    if (std::fwrite(data, 1, msg_size, fd_) != msg_size) {
+    offset_ += msg_size;
+    if (event_handlers_.preallocate_size != 0) {
+        preallocate_(msg_size);
+    }
+    unsynced_ += msg_size;
+    if (direct_()) {
+        // the buffer is written before a message which doesn't fit, or the message at once
+        if (buffer_.size() + msg_size > event_handlers_.write_buffer_size) {
+            write_buffer_();
+            if (msg_size >= event_handlers_.write_buffer_size) {
+                if (!os::write_fd(fd_, data, msg_size)) {
+                    throw_spdlog_ex("Failed writing to file " + os::filename_to_str(filename_),
+                                    errno);
+                }
+            } else {
+                buffer_.insert(buffer_.end(), data, data + msg_size);
+            }
+        } else {
+            buffer_.insert(buffer_.end(), data, data + msg_size);
+        }
+    } else if (std::fwrite(data, 1, msg_size, fd_) != msg_size) {
+        throw_spdlog_ex("Failed writing to file " + os::filename_to_str(filename_), errno);
+    }
+    if (sync_due_()) {
+        flush();  // syncs
+    }
+}
+
+SPDLOG_INLINE void file_helper::note_time(log_clock::time_point time) {
+    if (fd_ == nullptr || !indexed()) {
+        return;
+    }
+    const auto &policy = event_handlers_.index;
+    bool due = last_indexed_ == log_clock::time_point{} ||
+               (policy.messages != 0 && unindexed_ + 1 >= policy.messages) ||
+               (policy.interval != std::chrono::milliseconds::zero() &&
+                time - last_indexed_ >= policy.interval);
+    if (!due) {
+        unindexed_++;
+        return;
+    }
+    index_.append(time, offset_);
+    unindexed_ = 0;
+    last_indexed_ = time;
+}
+
+SPDLOG_INLINE void file_helper::write_buffer_() {
+    if (buffer_.empty()) {
+        return;
+    }
+    bool ok = os::write_fd(fd_, buffer_.data(), buffer_.size());
+    buffer_.clear();  // not retried
+    if (!ok) {
         throw_spdlog_ex("Failed writing to file " + os::filename_to_str(filename_), errno);
     }
 }
 
+// reserve the next chunk if the message goes past the space reserved. not reserving anything
+// any more if it fails (e.g. not supported by the file system).
+SPDLOG_INLINE void file_helper::preallocate_(size_t msg_size) {
+    written_ += msg_size;
+    if (written_ < allocated_ || allocated_ == static_cast<size_t>(-1)) {
+        return;
+    }
+    auto chunk = event_handlers_.preallocate_size;
+    auto size = (written_ / chunk + 1) * chunk;
+    allocated_ = os::preallocate(fd_, size) ? size : static_cast<size_t>(-1);
+}
+
+SPDLOG_INLINE bool file_helper::sync_due_() const {
+    const auto &policy = event_handlers_.durability;
+    if (policy.bytes != 0 && unsynced_ >= policy.bytes) {
+        return true;
+    }
+    return policy.interval != std::chrono::milliseconds::zero() &&
+           std::chrono::steady_clock::now() - last_sync_ >= policy.interval;
+}
+
+// the data must have been written to the file descriptor
+SPDLOG_INLINE void file_helper::sync_with_policy_() {
+    bool ok = false;
+    switch (event_handlers_.durability.method) {
+        case sync_method::fsync:
+            ok = os::fsync(fd_);
+            break;
+        case sync_method::fdatasync:
+            ok = os::fdatasync(fd_);
+            break;
+        case sync_method::write_behind:
+            ok = os::start_writeback(fd_);
+            break;
+    }
+    unsynced_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+    if (!ok) {
+        throw_spdlog_ex("Failed to sync file " + os::filename_to_str(filename_), errno);
+    }
+}
+
 SPDLOG_INLINE size_t file_helper::size() const {
     if (fd_ == nullptr) {
         throw_spdlog_ex("Cannot use size() on closed file " + os::filename_to_str(filename_));
     }
-    return os::filesize(fd_);
+    return os::filesize(fd_) + buffer_.size();
 }
 
 SPDLOG_INLINE const filename_t &file_helper::filename() const { return filename_; }
@@ -4,7 +4,10 @@
 #pragma once
 
 #include <spdlog/common.h>
+#include <spdlog/details/file_index.h>
+#include <chrono>
 #include <tuple>
+#include <vector>
 
 namespace spdlog {
 namespace details {
@@ -12,6 +15,16 @@ namespace details {
 // Helper class for file sinks.
 // When failing to open a file, retry several times(5) with a delay interval(10 ms).
 // Throw spdlog_ex exception on errors.
+// With a write_buffer_size in the event handlers, the writes are buffered here and written
+// straight to the file descriptor, instead of going through the FILE* and its lock.
+// With atomic_records, each write() is a single write(2) on the file descriptor.
+// With a preallocate_size, the disk space is reserved ahead of the writes in chunks of that size.
+// With the bytes or interval of a durability policy, the file is synced by write() and flush()
+// as often as the policy says.
+// With the index policy, a sidecar index of the file is written (see file_index) from the times
+// given to note_time().
+// The directories of the files opened are created if missing, and remembered (process wide) so
+// the next opens in them don't check them again, until an open there fails.
 
 class SPDLOG_API file_helper {
 public:
@@ -28,9 +41,18 @@ public:
     void sync();
     void close();
     void write(const memory_buf_t &buf);
+    void write(const char *data, size_t size);
     size_t size() const;
     const filename_t &filename() const;
 
+    // true if the file is indexed: the sinks call note_time() before writing each message
+    bool indexed() const {
+        return event_handlers_.index.messages != 0 ||
+               event_handlers_.index.interval != std::chrono::milliseconds::zero();
+    }
+    // the next write starts a message logged at time (or a batch starting with it)
+    void note_time(log_clock::time_point time);
+
     //
     // return file path and its extension:
     //
@@ -52,6 +74,30 @@ private:
     std::FILE *fd_{nullptr};
     filename_t filename_;
     file_event_handlers event_handlers_;
+    std::vector<char> buffer_;  // pending writes (if event_handlers_.write_buffer_size != 0)
+    size_t written_ = 0;        // file size, if event_handlers_.preallocate_size != 0
+    size_t allocated_ = 0;      // disk space reserved for the file
+    size_t unsynced_ = 0;       // bytes written since the last sync
+    std::chrono::steady_clock::time_point last_sync_;
+    file_index index_;
+    size_t offset_ = 0;         // of the end of the file, if indexed()
+    size_t unindexed_ = 0;      // messages since the last index record
+    log_clock::time_point last_indexed_;
+
+    struct dir_cache;
+    static dir_cache &dir_cache_();
+    // create the directory unless it is known to exist, true if it was
+    static bool create_dir_(const filename_t &dir);
+    static void forget_dir_(const filename_t &dir);
+
+    // true if the writes bypass stdio
+    bool direct_() const {
+        return event_handlers_.write_buffer_size != 0 || event_handlers_.atomic_records;
+    }
+    void write_buffer_();
+    void preallocate_(size_t msg_size);
+    bool sync_due_() const;
+    void sync_with_policy_();
 };
 }  // namespace details
 }  // namespace spdlog
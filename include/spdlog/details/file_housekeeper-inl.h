@@ -0,0 +1,212 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/details/file_housekeeper.h>
+#endif
+
+#include <spdlog/details/os.h>
+
+#ifdef SPDLOG_ZLIB
+    #include <zlib.h>
+#endif
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE file_housekeeper::~file_housekeeper() {
+    // the thread exits once it ran the tasks left
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+SPDLOG_INLINE void file_housekeeper::post(task t) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(t));
+        if (!thread_running_) {
+            // the previous thread is done with the lock
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+            thread_running_ = true;
+            thread_ = std::thread([this] { loop_(); });
+        }
+    }
+    cv_.notify_all();
+}
+
+SPDLOG_INLINE std::string file_housekeeper::take_error() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string error;
+    std::swap(error, error_);
+    return error;
+}
+
+SPDLOG_INLINE void file_housekeeper::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return tasks_.empty() && !running_; });
+}
+
+SPDLOG_INLINE void file_housekeeper::loop_() {
+    (void)os::set_thread_nice(19);
+    for (;;) {
+        task t;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (tasks_.empty()) {
+                thread_running_ = false;
+                return;
+            }
+            t = std::move(tasks_.front());
+            tasks_.pop_front();
+            running_ = true;
+        }
+        std::string error;
+        SPDLOG_TRY { error = t(); }
+        SPDLOG_CATCH_STD
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+            if (!error.empty() && error_.empty()) {
+                error_ = std::move(error);
+            }
+        }
+        cv_.notify_all();
+    }
+}
+
+SPDLOG_INLINE filename_t compressed_filename(const filename_t &filename, file_compression type) {
+    return type == file_compression::gzip ? filename + SPDLOG_FILENAME_T(".gz") : filename;
+}
+
+#ifdef SPDLOG_ZLIB
+// gzip in into out, reading at most options.max_bytes_per_sec
+static SPDLOG_INLINE bool gzip_file_(std::FILE *in,
+                                     std::FILE *out,
+                                     const compression_options &options) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // 15 bits window, +16 for the gzip header and trailer
+    if (deflateInit2(&stream, options.level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) !=
+        Z_OK) {
+        return false;
+    }
+    std::vector<unsigned char> in_buf(64 * 1024);
+    std::vector<unsigned char> out_buf(64 * 1024);
+    auto start = std::chrono::steady_clock::now();
+    size_t total = 0;
+    bool ok = true;
+    int flush = Z_NO_FLUSH;
+    while (ok && flush != Z_FINISH) {
+        auto n = std::fread(in_buf.data(), 1, in_buf.size(), in);
+        if (std::ferror(in)) {
+            ok = false;
+            break;
+        }
+        flush = std::feof(in) ? Z_FINISH : Z_NO_FLUSH;
+        stream.next_in = in_buf.data();
+        stream.avail_in = static_cast<uInt>(n);
+        do {
+            stream.next_out = out_buf.data();
+            stream.avail_out = static_cast<uInt>(out_buf.size());
+            (void)deflate(&stream, flush);
+            auto size = out_buf.size() - stream.avail_out;
+            if (std::fwrite(out_buf.data(), 1, size, out) != size) {
+                ok = false;
+                break;
+            }
+        } while (stream.avail_out == 0);
+
+        total += n;
+        if (options.max_bytes_per_sec > 0) {
+            auto due = std::chrono::milliseconds(
+                static_cast<long long>(total * 1000 / options.max_bytes_per_sec));
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+            if (due > elapsed) {
+                os::sleep_for_millis(static_cast<unsigned int>((due - elapsed).count()));
+            }
+        }
+    }
+    (void)deflateEnd(&stream);
+    return ok;
+}
+#endif
+
+SPDLOG_INLINE void throw_if_unsupported(const compression_options &options) {
+#ifndef SPDLOG_ZLIB
+    if (options.type == file_compression::gzip) {
+        throw_spdlog_ex("gzip compression needs spdlog built with SPDLOG_ZLIB");
+    }
+#else
+    (void)options;
+#endif
+}
+
+SPDLOG_INLINE std::string compress_file(const filename_t &filename,
+                                       const compression_options &options) {
+    using os::filename_to_str;
+
+    if (options.type == file_compression::none) {
+        return {};
+    }
+#ifndef SPDLOG_ZLIB
+    return "Failed compressing " + filename_to_str(filename) +
+           ": spdlog was built without SPDLOG_ZLIB";
+#else
+    auto target = compressed_filename(filename, options.type);
+    auto tmp_filename = target + SPDLOG_FILENAME_T(".tmp");
+    #if defined(_WIN32) && defined(SPDLOG_WCHAR_FILENAMES)
+    std::FILE *in = ::_wfopen(filename.c_str(), L"rb");
+    #else
+    std::FILE *in = std::fopen(filename.c_str(), "rb");
+    #endif
+    if (in == nullptr) {
+        return spdlog_ex("Failed opening file " + filename_to_str(filename) + " for reading", errno)
+            .what();
+    }
+    std::FILE *out = nullptr;
+    if (os::fopen_s(&out, tmp_filename, SPDLOG_FILENAME_T("wb"))) {
+        auto err = errno;
+        std::fclose(in);
+        return spdlog_ex("Failed opening file " + filename_to_str(tmp_filename) + " for writing",
+                         err)
+            .what();
+    }
+    bool ok = gzip_file_(in, out, options);
+    auto err = errno;
+    std::fclose(in);
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        (void)os::remove(tmp_filename);
+        return spdlog_ex("Failed compressing " + filename_to_str(filename), err).what();
+    }
+    (void)os::remove(target);  // rename() doesn't replace it on windows
+    if (os::rename(tmp_filename, target) != 0) {
+        err = errno;
+        (void)os::remove(tmp_filename);
+        return spdlog_ex("Failed renaming " + filename_to_str(tmp_filename) + " to " +
+                             filename_to_str(target),
+                         err)
+            .what();
+    }
+    if (os::remove(filename) != 0) {
+        return spdlog_ex("Failed removing " + filename_to_str(filename), errno).what();
+    }
+    return {};
+#endif
+}
+
+}  // namespace details
+}  // namespace spdlog
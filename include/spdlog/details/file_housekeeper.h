@@ -0,0 +1,69 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <spdlog/common.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace spdlog {
+namespace details {
+
+// Background thread of a file sink running the work on its full files (renames, compression,
+// deletion) in the order it was posted, at the lowest priority so it doesn't compete with the
+// application. The thread is started by post(), and exits once there are no tasks left, so an
+// idle sink doesn't keep a thread. The destructor runs the tasks left before joining it.
+class SPDLOG_API file_housekeeper {
+public:
+    // a task returns the error message if it failed
+    using task = std::function<std::string()>;
+
+    file_housekeeper() = default;
+    file_housekeeper(const file_housekeeper &) = delete;
+    file_housekeeper &operator=(const file_housekeeper &) = delete;
+    ~file_housekeeper();
+
+    void post(task t);
+
+    // error message of the first task which failed since the last call, or empty string
+    std::string take_error();
+
+    // block until all the tasks posted are done
+    void wait();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<task> tasks_;
+    std::string error_;
+    bool running_ = false;  // a task is being run
+    bool thread_running_ = false;  // thread_ takes the tasks posted
+    std::thread thread_;
+
+    void loop_();
+};
+
+// The name of the compressed version of the file (e.g. "log.1.txt.gz").
+SPDLOG_API filename_t compressed_filename(const filename_t &filename, file_compression type);
+
+// Throw spdlog_ex if the compression type isn't available in this build.
+SPDLOG_API void throw_if_unsupported(const compression_options &options);
+
+// Compress the file into compressed_filename() and remove it (a ".tmp" file is written first,
+// so a compressed file is always complete).
+// Return the error message on failure, or empty string on success.
+SPDLOG_API std::string compress_file(const filename_t &filename,
+                                     const compression_options &options);
+
+}  // namespace details
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "file_housekeeper-inl.h"
+#endif
@@ -0,0 +1,102 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/details/file_index.h>
+#endif
+
+#include <spdlog/details/os.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+
+namespace spdlog {
+namespace details {
+
+struct file_index_record {
+    std::int64_t time_ns;
+    std::uint64_t offset;
+};
+
+SPDLOG_INLINE file_index::~file_index() { close(); }
+
+SPDLOG_INLINE void file_index::open(const filename_t &log_filename, bool truncate) {
+    close();
+    filename_ = index_filename(log_filename);
+    if (os::fopen_s(&fd_, filename_,
+                    truncate ? SPDLOG_FILENAME_T("wb") : SPDLOG_FILENAME_T("ab"))) {
+        fd_ = nullptr;
+        throw_spdlog_ex("Failed opening file " + os::filename_to_str(filename_) + " for writing",
+                        errno);
+    }
+}
+
+SPDLOG_INLINE void file_index::close() {
+    if (fd_ != nullptr) {
+        std::fclose(fd_);
+        fd_ = nullptr;
+    }
+}
+
+SPDLOG_INLINE void file_index::flush() {
+    if (fd_ != nullptr) {
+        std::fflush(fd_);
+    }
+}
+
+SPDLOG_INLINE void file_index::append(log_clock::time_point time, size_t offset) {
+    if (fd_ == nullptr) {
+        return;
+    }
+    file_index_record record;
+    record.time_ns = static_cast<std::int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+    record.offset = static_cast<std::uint64_t>(offset);
+    if (std::fwrite(&record, sizeof(record), 1, fd_) != 1) {
+        throw_spdlog_ex("Failed writing to file " + os::filename_to_str(filename_),
+                        errno);
+    }
+}
+
+SPDLOG_INLINE filename_t file_index::index_filename(const filename_t &log_filename) {
+    return log_filename + SPDLOG_FILENAME_T(".idx");
+}
+
+SPDLOG_INLINE size_t file_index::find_offset(const filename_t &log_filename,
+                                             log_clock::time_point time) {
+    std::FILE *fd;
+    if (os::fopen_s(&fd, index_filename(log_filename), SPDLOG_FILENAME_T("rb"))) {
+        return 0;
+    }
+    auto time_ns = static_cast<std::int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+    auto read = [fd](size_t i, file_index_record &record) {
+        return std::fseek(fd, static_cast<long>(i * sizeof(record)), SEEK_SET) == 0 &&
+               std::fread(&record, sizeof(record), 1, fd) == 1;
+    };
+    // the first record not older than time
+    size_t low = 0, high = os::filesize(fd) / sizeof(file_index_record);
+    file_index_record record;
+    while (low < high) {
+        auto mid = low + (high - low) / 2;
+        if (!read(mid, record)) {
+            high = mid;  // cut short
+        } else if (record.time_ns < time_ns) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    size_t offset = 0;
+    if (low > 0 && read(low - 1, record)) {
+        offset = static_cast<size_t>(record.offset);
+    }
+    std::fclose(fd);
+    return offset;
+}
+
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,56 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <spdlog/common.h>
+
+#include <cstdint>
+#include <cstdio>
+
+namespace spdlog {
+namespace details {
+
+// Sidecar index of a log file ("<filename>.idx"), written by file_helper as its
+// file_index_policy says: a record of the time of a message and the offset in the log file the
+// message starts at, every few messages. The records are 16 bytes (the time in nanoseconds since
+// the epoch, and the offset, as int64 and uint64 in the host's byte order), so find_offset()
+// can binary search them, reading a few records instead of scanning the log file.
+class SPDLOG_API file_index {
+public:
+    file_index() = default;
+    file_index(const file_index &) = delete;
+    file_index &operator=(const file_index &) = delete;
+    ~file_index();
+
+    // throw spdlog_ex on failure
+    void open(const filename_t &log_filename, bool truncate);
+    void close();
+    void flush();
+    void append(log_clock::time_point time, size_t offset);
+
+    static filename_t index_filename(const filename_t &log_filename);
+
+    // the offset in the log file to read from to find the messages logged at or after time:
+    // the one of the last record older than time (the message times are assumed increasing, as
+    // they are give or take the threads' scheduling). 0 if there is no index.
+    static size_t find_offset(const filename_t &log_filename, log_clock::time_point time);
+
+private:
+    std::FILE *fd_ = nullptr;
+    filename_t filename_;
+};
+
+}  // namespace details
+
+// the offset in the log file (written with a file_index_policy) of the first messages logged at
+// or after time, found in its index
+inline size_t log_file_offset(const filename_t &log_filename, log_clock::time_point time) {
+    return details::file_index::find_offset(log_filename, time);
+}
+
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "file_index-inl.h"
+#endif
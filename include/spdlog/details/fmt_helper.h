@@ -2,42 +2,131 @@
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iterator>
 #include <spdlog/common.h>
 #include <spdlog/fmt/fmt.h>
+#include <spdlog/kv.h>
 #include <type_traits>
 
 #ifdef SPDLOG_USE_STD_FORMAT
-    #include <charconv>
     #include <limits>
 #endif
 
+// appended to the payloads cut at a logger's max_payload_size()
+#ifndef SPDLOG_TRUNCATION_MARKER
+    #define SPDLOG_TRUNCATION_MARKER "...[truncated]"
+#endif
+
 // Some fmt helpers to efficiently format and pad ints and strings
 namespace spdlog {
 namespace details {
 namespace fmt_helper {
 
-inline void append_string_view(spdlog::string_view_t view, memory_buf_t &dest) {
-    auto *buf_ptr = view.data();
-    dest.append(buf_ptr, buf_ptr + view.size());
+// the two digits of 0-99, by pairs: "00" "01" ... "99"
+inline const char *digits2(size_t value) {
+    return &"0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899"[value * 2];
 }
 
 #ifdef SPDLOG_USE_STD_FORMAT
+// std::string::append(first, last) takes the generic iterator path of the standard library
+inline void append_string_view(spdlog::string_view_t view, memory_buf_t &dest) {
+    dest.append(view.data(), view.size());
+}
+
+// write the digits two at a time from the end of a stack buffer, then append them at once
+// (same as fmt::format_int, without std::to_chars' error path).
 template <typename T>
 inline void append_int(T n, memory_buf_t &dest) {
     // Buffer should be large enough to hold all digits (digits10 + 1) and a sign
     SPDLOG_CONSTEXPR const auto BUF_SIZE = std::numeric_limits<T>::digits10 + 2;
     char buf[BUF_SIZE];
-
-    auto [ptr, ec] = std::to_chars(buf, buf + BUF_SIZE, n, 10);
-    if (ec == std::errc()) {
-        dest.append(buf, ptr);
+    char *end = buf + BUF_SIZE;
+    char *p = end;
+    auto value = static_cast<std::make_unsigned_t<T>>(n);
+    bool negative = false;
+    if constexpr (std::is_signed_v<T>) {
+        if (n < 0) {
+            negative = true;
+            value = static_cast<std::make_unsigned_t<T>>(0 - value);
+        }
+    }
+    while (value >= 100) {
+        p -= 2;
+        std::memcpy(p, digits2(static_cast<size_t>(value % 100)), 2);
+        value /= 100;
+    }
+    if (value < 10) {
+        *--p = static_cast<char>('0' + value);
     } else {
-        throw_spdlog_ex("Failed to format int", static_cast<int>(ec));
+        p -= 2;
+        std::memcpy(p, digits2(static_cast<size_t>(value)), 2);
+    }
+    if (negative) {
+        *--p = '-';
+    }
+    dest.append(p, static_cast<size_t>(end - p));
+}
+
+// output iterator writing into room made ahead at the end of a string, and growing it when
+// full: each char costs a compare and a store, instead of a push_back updating the size and
+// the terminating null.
+class string_appender {
+public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    string_appender() = default;
+    string_appender(memory_buf_t &dest, size_t pos)
+        : dest_(&dest),
+          pos_(pos) {}
+
+    string_appender &operator=(char c) {
+        if (pos_ == dest_->size()) {
+            dest_->resize(dest_->size() * 2);
+        }
+        (*dest_)[pos_++] = c;
+        return *this;
     }
+    string_appender &operator*() { return *this; }
+    string_appender &operator++() { return *this; }
+    string_appender &operator++(int) { return *this; }  // the position lives in the iterator
+
+    size_t pos() const { return pos_; }
+
+private:
+    memory_buf_t *dest_ = nullptr;
+    size_t pos_ = 0;
+};
+
+// format into dest, like fmt::vformat_to(fmt::appender(dest), ...) does with fmt's buffer
+inline void vformat_to(memory_buf_t &dest, string_view_t fmt, std::format_args args) {
+    // drop the room left (or all of it if the formatting throws)
+    struct room_guard {
+        memory_buf_t &dest;
+        size_t size;
+        ~room_guard() { dest.resize(size); }
+    } guard{dest, dest.size()};
+
+    SPDLOG_CONSTEXPR const size_t initial_room = 250;  // inline size of fmt's memory_buf_t
+    dest.resize(guard.size + initial_room);
+    guard.size = std::vformat_to(string_appender(dest, guard.size), fmt, args).pos();
 }
 #else
+inline void append_string_view(spdlog::string_view_t view, memory_buf_t &dest) {
+    auto *buf_ptr = view.data();
+    dest.append(buf_ptr, buf_ptr + view.size());
+}
+
 template <typename T>
 inline void append_int(T n, memory_buf_t &dest) {
     fmt::format_int i(n);
@@ -81,11 +170,20 @@ inline unsigned int count_digits(T n) {
 #endif
 }
 
+// write the last 2 * pairs digits of n into out (n < 100^pairs)
+template <typename T>
+inline void write_pairs(T n, size_t pairs, char *out) {
+    for (size_t i = pairs; i > 0; i--) {
+        std::memcpy(out + (i - 1) * 2, digits2(static_cast<size_t>(n % 100)), 2);
+        n /= 100;
+    }
+}
+
 inline void pad2(int n, memory_buf_t &dest) {
     if (n >= 0 && n < 100)  // 0-99
     {
-        dest.push_back(static_cast<char>('0' + n / 10));
-        dest.push_back(static_cast<char>('0' + n % 10));
+        const char *digits = digits2(static_cast<size_t>(n));
+        dest.append(digits, digits + 2);
     } else  // unlikely, but just in case, let fmt deal with it
     {
         fmt_lib::format_to(std::back_inserter(dest), SPDLOG_FMT_STRING("{:02}"), n);
@@ -105,10 +203,10 @@ template <typename T>
 inline void pad3(T n, memory_buf_t &dest) {
     static_assert(std::is_unsigned<T>::value, "pad3 must get unsigned T");
     if (n < 1000) {
-        dest.push_back(static_cast<char>(n / 100 + '0'));
-        n = n % 100;
-        dest.push_back(static_cast<char>((n / 10) + '0'));
-        dest.push_back(static_cast<char>((n % 10) + '0'));
+        char buf[3];
+        buf[0] = static_cast<char>(n / 100 + '0');
+        write_pairs(n % 100, 1, buf + 1);
+        dest.append(buf, buf + 3);
     } else {
         append_int(n, dest);
     }
@@ -116,12 +214,27 @@ inline void pad3(T n, memory_buf_t &dest) {
 
 template <typename T>
 inline void pad6(T n, memory_buf_t &dest) {
-    pad_uint(n, 6, dest);
+    static_assert(std::is_unsigned<T>::value, "pad6 must get unsigned T");
+    if (n < 1000000) {
+        char buf[6];
+        write_pairs(n, 3, buf);
+        dest.append(buf, buf + 6);
+    } else {
+        append_int(n, dest);
+    }
 }
 
 template <typename T>
 inline void pad9(T n, memory_buf_t &dest) {
-    pad_uint(n, 9, dest);
+    static_assert(std::is_unsigned<T>::value, "pad9 must get unsigned T");
+    if (n < 1000000000) {
+        char buf[9];
+        buf[0] = static_cast<char>(n / 100000000 + '0');
+        write_pairs(n % 100000000, 4, buf + 1);
+        dest.append(buf, buf + 9);
+    } else {
+        append_int(n, dest);
+    }
 }
 
 // return fraction of a second of the given time_point.
@@ -136,6 +249,144 @@ inline ToDuration time_fraction(log_clock::time_point tp) {
     return duration_cast<ToDuration>(duration) - duration_cast<ToDuration>(secs);
 }
 
+// the value of a kv field as text (the shortest form reading back as the same double)
+inline void append_kv_value(const kv_field &field, memory_buf_t &dest) {
+    switch (field.type) {
+        case kv_type::string:
+            append_string_view(field.string_value, dest);
+            break;
+        case kv_type::int64:
+            append_int(field.int_value, dest);
+            break;
+        case kv_type::uint64:
+            append_int(field.uint_value, dest);
+            break;
+        case kv_type::float64:
+            fmt_lib::format_to(std::back_inserter(dest), SPDLOG_FMT_STRING("{}"),
+                               field.float_value);
+            break;
+        case kv_type::boolean:
+            append_string_view(field.bool_value ? "true" : "false", dest);
+            break;
+    }
+}
+
+// output iterator appending to dest up to limit (a position in dest), then dropping the rest of
+// the output: a message formatting megabytes (a huge container or string) doesn't grow the
+// buffer past its cap, the chars past it only cost a compare. like string_appender, it writes
+// into room made ahead, the position living in the iterator.
+class truncating_appender {
+public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    truncating_appender() = default;
+    truncating_appender(memory_buf_t &dest, size_t pos, size_t limit)
+        : dest_(&dest),
+          pos_(pos),
+          limit_(limit) {}
+
+    truncating_appender &operator=(char c) {
+        if (pos_ == dest_->size()) {
+            if (pos_ >= limit_) {
+                truncated_ = true;
+                return *this;
+            }
+            dest_->resize((std::min)(dest_->size() * 2, limit_));
+        }
+        (*dest_)[pos_++] = c;
+        return *this;
+    }
+    truncating_appender &operator*() { return *this; }
+    truncating_appender &operator++() { return *this; }
+    truncating_appender &operator++(int) { return *this; }
+
+    size_t pos() const { return pos_; }
+    bool truncated() const { return truncated_; }
+
+private:
+    memory_buf_t *dest_ = nullptr;
+    size_t pos_ = 0;
+    size_t limit_ = 0;
+    bool truncated_ = false;
+};
+
+// the size of text without the incomplete UTF-8 sequence it ends with, if any
+inline size_t utf8_complete_size(const char *text, size_t size) {
+    size_t continuations = 0;
+    while (continuations < 3 && continuations < size &&
+           (static_cast<unsigned char>(text[size - 1 - continuations]) & 0xc0) == 0x80) {
+        continuations++;
+    }
+    if (continuations == size) {
+        return size;
+    }
+    auto lead = static_cast<unsigned char>(text[size - 1 - continuations]);
+    size_t length = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 1;
+    return length > continuations + 1 ? size - 1 - continuations : size;
+}
+
+// cut the text from start at a UTF-8 boundary, and append SPDLOG_TRUNCATION_MARKER
+inline void append_truncation_marker(memory_buf_t &dest, size_t start) {
+    dest.resize(start + utf8_complete_size(dest.data() + start, dest.size() - start));
+    string_view_t marker = SPDLOG_TRUNCATION_MARKER;
+    dest.append(marker.data(), marker.data() + marker.size());
+}
+
+// append text to dest, keeping max_size chars of it at most (see format_capped)
+inline void append_capped(string_view_t text, size_t max_size, memory_buf_t &dest) {
+    auto start = dest.size();
+    dest.append(text.data(), text.data() + (std::min)(text.size(), max_size));
+    if (text.size() > max_size) {
+        append_truncation_marker(dest, start);
+    }
+}
+
+// append the output of format(truncating_appender) to dest, keeping max_size chars of it at
+// most. a truncated output is cut at a UTF-8 boundary and ends with SPDLOG_TRUNCATION_MARKER.
+// return true if truncated.
+template <typename Format>
+inline bool format_capped(memory_buf_t &dest, size_t max_size, Format format) {
+    // drop the room left (or all of it if the formatting throws)
+    struct room_guard {
+        memory_buf_t &dest;
+        size_t size;
+        ~room_guard() { dest.resize(size); }
+    } guard{dest, dest.size()};
+
+    auto start = guard.size;
+    SPDLOG_CONSTEXPR const size_t initial_room = 250;  // inline size of fmt's memory_buf_t
+    dest.resize(start + (std::min)(max_size, initial_room));
+    truncating_appender out = format(truncating_appender(dest, start, start + max_size));
+    guard.size = out.pos();
+    if (!out.truncated()) {
+        return false;
+    }
+    dest.resize(guard.size);
+    append_truncation_marker(dest, start);
+    guard.size = dest.size();
+    return true;
+}
+
+// format into dest like vformat_to(), keeping max_size chars of the output at most (see
+// format_capped)
+inline bool vformat_to_capped(memory_buf_t &dest,
+                              size_t max_size,
+                              string_view_t fmt,
+                              fmt_lib::format_args args) {
+    struct vformat {
+        string_view_t fmt;
+        fmt_lib::format_args args;
+        truncating_appender operator()(truncating_appender out) const {
+            return fmt_lib::vformat_to(out, fmt, args);
+        }
+    };
+    return format_capped(dest, max_size, vformat{fmt, args});
+}
+
 }  // namespace fmt_helper
 }  // namespace details
 }  // namespace spdlog
@@ -0,0 +1,76 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Allocator for the storage of the async queues. If enabled (linux only), the storage is
+// mapped on huge pages and pre-faulted, so a large queue costs few TLB entries and its first
+// fill does no page fault. Otherwise it is the same as std::allocator.
+
+#include <spdlog/details/os.h>
+
+#include <cerrno>
+#include <memory>
+#include <type_traits>
+
+namespace spdlog {
+namespace details {
+
+template <typename T>
+class huge_page_allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit huge_page_allocator(bool use_huge_pages = false) SPDLOG_NOEXCEPT
+#ifdef __linux__
+        : huge_pages_(use_huge_pages) {
+    }
+#else
+        : huge_pages_(false) {
+        (void)use_huge_pages;
+    }
+#endif
+
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U> &other) SPDLOG_NOEXCEPT
+        : huge_pages_(other.huge_pages()) {}
+
+    T *allocate(size_t n) {
+        if (!huge_pages_) {
+            return std::allocator<T>().allocate(n);
+        }
+        auto *p = os::huge_pages_alloc(n * sizeof(T));
+        if (p == nullptr) {
+            throw_spdlog_ex("huge_page_allocator: failed mapping memory", errno);
+        }
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, size_t n) SPDLOG_NOEXCEPT {
+        if (!huge_pages_) {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+        os::huge_pages_free(p, n * sizeof(T));
+    }
+
+    bool huge_pages() const SPDLOG_NOEXCEPT { return huge_pages_; }
+
+private:
+    bool huge_pages_;
+};
+
+template <typename T, typename U>
+bool operator==(const huge_page_allocator<T> &lhs, const huge_page_allocator<U> &rhs) {
+    return lhs.huge_pages() == rhs.huge_pages();
+}
+
+template <typename T, typename U>
+bool operator!=(const huge_page_allocator<T> &lhs, const huge_page_allocator<U> &rhs) {
+    return !(lhs == rhs);
+}
+
+}  // namespace details
+}  // namespace spdlog
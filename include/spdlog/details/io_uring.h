@@ -0,0 +1,181 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef __linux__
+    #error io_uring is only available on linux
+#endif
+
+// minimal io_uring submission/completion ring, used through the raw system calls so there is
+// no liburing dependency. not thread safe: one thread owns the ring.
+#include <spdlog/common.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef __NR_io_uring_setup
+    #define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+    #define __NR_io_uring_enter 426
+#endif
+
+namespace spdlog {
+namespace details {
+class io_uring {
+public:
+    // throw spdlog_ex if the kernel doesn't support (or allow) io_uring
+    explicit io_uring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd_ < 0) {
+            throw_spdlog_ex("io_uring_setup failed", errno);
+        }
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        single_mmap_ = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap_) {
+            sq_ring_size_ = cq_ring_size_ = (std::max)(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = map_(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap_ ? sq_ring_ : map_(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe *>(map_(sqes_size_, IORING_OFF_SQES));
+        if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+            auto err = errno;
+            release_();
+            throw_spdlog_ex("io_uring mmap failed", err);
+        }
+
+        auto *sq = static_cast<char *>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        sq_entries_ = params.sq_entries;
+        auto *cq = static_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        cq_entries_ = params.cq_entries;
+        local_tail_ = *sq_tail_;
+        submitted_tail_ = local_tail_;
+    }
+
+    io_uring(const io_uring &) = delete;
+    io_uring &operator=(const io_uring &) = delete;
+
+    ~io_uring() { release_(); }
+
+    unsigned cq_entries() const { return cq_entries_; }
+
+    // a zeroed submission entry, or nullptr if the submission queue is full (submit() first)
+    io_uring_sqe *get_sqe() {
+        auto head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (local_tail_ - head >= sq_entries_) {
+            return nullptr;
+        }
+        auto index = local_tail_ & sq_mask_;
+        sq_array_[index] = index;
+        local_tail_++;
+        auto *sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // submit the entries got since the last call, and wait until wait_nr completions are ready.
+    // return false (with errno set) on failure.
+    bool submit(unsigned wait_nr) {
+        __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+        auto to_submit = local_tail_ - submitted_tail_;
+        if (to_submit == 0 && wait_nr == 0) {
+            return true;
+        }
+        unsigned flags = wait_nr != 0 ? IORING_ENTER_GETEVENTS : 0;
+        for (;;) {
+            auto rv = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, flags,
+                                nullptr, 0);
+            if (rv >= 0) {
+                submitted_tail_ += static_cast<unsigned>(rv);
+                if (submitted_tail_ == local_tail_) {
+                    return true;
+                }
+                to_submit = local_tail_ - submitted_tail_;  // submitted partially: go on
+            } else if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    // call f(const io_uring_cqe &) for each completion ready, and return how many there were
+    template <typename F>
+    unsigned for_each_cqe(F &&f) {
+        auto head = *cq_head_;
+        auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        for (; head != tail; ++head, ++count) {
+            f(cqes_[head & cq_mask_]);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+private:
+    int ring_fd_ = -1;
+    bool single_mmap_ = false;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    size_t sqes_size_ = 0;
+    void *sq_ring_ = nullptr;
+    void *cq_ring_ = nullptr;
+    io_uring_sqe *sqes_ = nullptr;
+
+    unsigned *sq_head_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    io_uring_cqe *cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+    unsigned cq_entries_ = 0;
+    unsigned local_tail_ = 0;      // tail including the entries not submitted yet
+    unsigned submitted_tail_ = 0;  // tail up to the entries the kernel took
+
+    void *map_(size_t size, off_t offset) {
+        auto *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ring_fd_, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    void release_() {
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqes_size_);
+            sqes_ = nullptr;
+        }
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        cq_ring_ = nullptr;
+        if (sq_ring_ != nullptr) {
+            ::munmap(sq_ring_, sq_ring_size_);
+            sq_ring_ = nullptr;
+        }
+        if (ring_fd_ >= 0) {
+            ::close(ring_fd_);
+            ring_fd_ = -1;
+        }
+    }
+};
+}  // namespace details
+}  // namespace spdlog
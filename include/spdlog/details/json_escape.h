@@ -0,0 +1,111 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Append a string to a json document, escaping the quotes, backslashes and control chars.
+// The string is scanned 16 bytes at a time (SSE2) or 8 bytes at a time (elsewhere) for chars
+// to escape, and the runs without any are appended as is.
+
+#include <spdlog/common.h>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SPDLOG_JSON_ESCAPE_SSE2
+#endif
+
+namespace spdlog {
+namespace details {
+
+inline bool json_needs_escape(unsigned char ch) { return ch < 0x20 || ch == '"' || ch == '\\'; }
+
+// position of the first char to escape in [begin, end), or end
+inline const char *json_find_escape(const char *begin, const char *end) {
+    auto *p = begin;
+#ifdef SPDLOG_JSON_ESCAPE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    // unsigned ch < 0x20 as a signed compare, with the sign bits flipped
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i control = _mm_set1_epi8(static_cast<char>(0x20 ^ 0x80));
+    for (; end - p >= 16; p += 16) {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i found = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)),
+            _mm_cmplt_epi8(_mm_xor_si128(chars, sign), control));
+        int mask = _mm_movemask_epi8(found);
+        if (mask != 0) {
+            for (; !json_needs_escape(static_cast<unsigned char>(*p)); ++p) {
+            }
+            return p;
+        }
+    }
+#else
+    const std::uint64_t ones = 0x0101010101010101ull;
+    const std::uint64_t highs = 0x8080808080808080ull;
+    for (; end - p >= 8; p += 8) {
+        std::uint64_t chars;
+        std::memcpy(&chars, p, sizeof(chars));
+        auto has_zero = [&](std::uint64_t x) { return (x - ones) & ~x & highs; };
+        // a byte < 0x20, or equal to '"' or '\\'
+        auto found = ((chars - ones * 0x20) & ~chars & highs) | has_zero(chars ^ (ones * '"')) |
+                     has_zero(chars ^ (ones * '\\'));
+        if (found != 0) {
+            for (; !json_needs_escape(static_cast<unsigned char>(*p)); ++p) {
+            }
+            return p;
+        }
+    }
+#endif
+    for (; p != end && !json_needs_escape(static_cast<unsigned char>(*p)); ++p) {
+    }
+    return p;
+}
+
+inline void json_escape(string_view_t str, memory_buf_t &dest) {
+    auto *p = str.data();
+    auto *end = p + str.size();
+    for (;;) {
+        auto *run_end = json_find_escape(p, end);
+        dest.append(p, run_end);
+        if (run_end == end) {
+            return;
+        }
+        auto ch = static_cast<unsigned char>(*run_end);
+        dest.push_back('\\');
+        switch (ch) {
+            case '"':
+            case '\\':
+                dest.push_back(static_cast<char>(ch));
+                break;
+            case '\b':
+                dest.push_back('b');
+                break;
+            case '\f':
+                dest.push_back('f');
+                break;
+            case '\n':
+                dest.push_back('n');
+                break;
+            case '\r':
+                dest.push_back('r');
+                break;
+            case '\t':
+                dest.push_back('t');
+                break;
+            default: {
+                const char *hex = "0123456789abcdef";
+                const char escaped[] = {'u', '0', '0', hex[ch >> 4], hex[ch & 0xf]};
+                dest.append(escaped, escaped + sizeof(escaped));
+                break;
+            }
+        }
+        p = run_end + 1;
+    }
+}
+
+}  // namespace details
+}  // namespace spdlog
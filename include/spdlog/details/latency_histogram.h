@@ -0,0 +1,108 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Histogram of durations with HDR-style buckets: each power of 2 of nanoseconds is split in
+// sub_buckets_n linear buckets, so a percentile is known within 25% whatever its magnitude,
+// in a fixed array of counters recorded with relaxed atomic increments (no lock, no
+// allocation).
+
+#include <spdlog/common.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace spdlog {
+
+// the durations recorded, by bucket (see bucket_of() and upper_bound())
+struct latency_snapshot {
+    static constexpr size_t sub_buckets_n = 4;
+    // up to 2^41 ns (about 36 minutes), the last bucket holding the durations above
+    static constexpr size_t buckets_n = 160;
+
+    std::array<std::uint64_t, buckets_n> buckets{};
+    std::uint64_t count = 0;
+    std::uint64_t total_ns = 0;
+
+    // durations below sub_buckets_n ns have a bucket each. above, bucket
+    // sub_buckets_n * (e - 1) + s holds [(4 + s) * 2^(e-2), (5 + s) * 2^(e-2)) ns, e being the
+    // highest bit of the duration.
+    static size_t bucket_of(std::uint64_t ns) SPDLOG_NOEXCEPT {
+        if (ns < sub_buckets_n) {
+            return static_cast<size_t>(ns);
+        }
+        size_t e = 0;
+        for (auto n = ns; n > 1; n >>= 1) {
+            e++;
+        }
+        auto sub = static_cast<size_t>(ns >> (e - 2)) & (sub_buckets_n - 1);
+        auto bucket = sub_buckets_n * (e - 1) + sub;
+        return bucket < buckets_n ? bucket : buckets_n - 1;
+    }
+
+    // the end of the durations of the bucket
+    static std::chrono::nanoseconds upper_bound(size_t bucket) SPDLOG_NOEXCEPT {
+        if (bucket < sub_buckets_n) {
+            return std::chrono::nanoseconds(static_cast<std::int64_t>(bucket + 1));
+        }
+        auto e = bucket / sub_buckets_n + 1;
+        auto sub = bucket % sub_buckets_n;
+        return std::chrono::nanoseconds(static_cast<std::int64_t>(sub_buckets_n + 1 + sub)
+                                        << (e - 2));
+    }
+
+    std::chrono::nanoseconds mean() const {
+        return std::chrono::nanoseconds(count == 0 ? 0 : total_ns / count);
+    }
+
+    // the upper bound of the bucket holding the given ratio (0 to 1) of the durations
+    std::chrono::nanoseconds percentile(double ratio) const {
+        auto rank = static_cast<std::uint64_t>(ratio * static_cast<double>(count));
+        std::uint64_t seen = 0;
+        for (size_t i = 0; i < buckets_n; i++) {
+            seen += buckets[i];
+            if (seen > rank || (seen == count && seen > 0)) {
+                return upper_bound(i);
+            }
+        }
+        return std::chrono::nanoseconds(0);
+    }
+};
+
+namespace details {
+
+class latency_histogram {
+public:
+    void record(std::chrono::nanoseconds duration, std::uint64_t n = 1) SPDLOG_NOEXCEPT {
+        auto ns = static_cast<std::uint64_t>(duration.count() < 0 ? 0 : duration.count());
+        buckets_[latency_snapshot::bucket_of(ns)].fetch_add(n, std::memory_order_relaxed);
+        total_ns_.fetch_add(ns * n, std::memory_order_relaxed);
+    }
+
+    latency_snapshot snapshot() const SPDLOG_NOEXCEPT {
+        latency_snapshot result;
+        for (size_t i = 0; i < latency_snapshot::buckets_n; i++) {
+            result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            result.count += result.buckets[i];
+        }
+        result.total_ns = total_ns_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void reset() SPDLOG_NOEXCEPT {
+        for (auto &bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        total_ns_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, latency_snapshot::buckets_n> buckets_{};
+    std::atomic<std::uint64_t> total_ns_{0};
+};
+
+}  // namespace details
+}  // namespace spdlog
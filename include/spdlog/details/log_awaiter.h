@@ -0,0 +1,160 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Awaitable returned by async_logger::async_log() and the like (C++20).
+// Awaiting it posts the message if there is room in the queue. Otherwise the coroutine is
+// suspended, and the first worker making room posts the message and resumes it.
+
+#include <spdlog/async_logger.h>
+#include <spdlog/details/thread_pool.h>
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+
+namespace spdlog {
+namespace details {
+
+class log_awaiter {
+public:
+    using scheduler = std::function<void(std::coroutine_handle<>)>;
+
+    // nothing to post
+    log_awaiter() = default;
+
+    log_awaiter(std::shared_ptr<thread_pool> pool, async_msg &&msg)
+        : pool_(std::move(pool)) {
+        waiter_.msg = std::move(msg);
+    }
+
+    // may only be moved before being awaited
+    log_awaiter(log_awaiter &&) = default;
+    log_awaiter &operator=(log_awaiter &&) = delete;
+
+    ~log_awaiter() {
+        if (waiting_) {
+            pool_->cancel_wait(waiter_);
+        }
+    }
+
+    // resume the coroutine by passing it to schedule (e.g. to post it to its executor)
+    // instead of resuming it on the worker thread.
+    log_awaiter resume_via(scheduler schedule) && {
+        schedule_ = std::move(schedule);
+        return std::move(*this);
+    }
+
+    bool await_ready() { return pool_ == nullptr || pool_->try_post(waiter_.msg); }
+
+    // the coroutine may be resumed by a worker as soon as the waiter is registered, so it is
+    // not touched after post_or_wait() unless the message was posted right away.
+    bool await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        waiter_.wake = &log_awaiter::wake_;
+        waiter_.context = this;
+        waiting_ = true;
+        if (pool_->post_or_wait(waiter_)) {
+            waiting_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    void await_resume() const SPDLOG_NOEXCEPT {}
+
+private:
+    std::shared_ptr<thread_pool> pool_;
+    queue_waiter waiter_;
+    scheduler schedule_;
+    std::coroutine_handle<> handle_;
+    bool waiting_ = false;
+
+    // the awaiter may be destroyed by the resumed coroutine
+    static void wake_(queue_waiter *waiter) {
+        auto *self = static_cast<log_awaiter *>(waiter->context);
+        auto handle = self->handle_;
+        if (!self->schedule_) {
+            handle.resume();
+            return;
+        }
+        auto schedule = std::move(self->schedule_);
+        schedule(handle);
+    }
+};
+
+}  // namespace details
+
+template <typename... Args>
+details::log_awaiter async_logger::async_log(level::level_enum lvl,
+                                             format_string_t<Args...> fmt,
+                                             Args &&...args) {
+    bool log_enabled = should_log(lvl);
+    bool traceback_enabled = tracer_.enabled();
+    if (!log_enabled && !traceback_enabled) {
+        return {};
+    }
+    SPDLOG_TRY {
+        memory_buf_t buf;
+#ifdef SPDLOG_USE_STD_FORMAT
+        details::fmt_helper::vformat_to(buf, details::to_string_view(fmt),
+                                        fmt_lib::make_format_args(args...));
+#else
+        fmt::vformat_to(fmt::appender(buf), details::to_string_view(fmt),
+                        fmt::make_format_args(args...));
+#endif
+        details::log_msg msg(source_loc{}, name_, lvl, string_view_t(buf.data(), buf.size()),
+                             needed_fields_(lvl, traceback_enabled), clock_);
+        if (traceback_enabled) {
+            tracer_.push_back(msg);
+        }
+        if (!log_enabled) {
+            return {};
+        }
+        auto pool = thread_pool_.lock();
+        if (!pool) {
+            throw_spdlog_ex("async log: thread pool doesn't exist anymore");
+        }
+        auto async_m =
+            pool->holds_loggers()
+                ? details::async_msg(shared_from_this(), details::async_msg_type::log, msg)
+                : details::async_msg(this, details::async_msg_type::log, msg);
+        return details::log_awaiter(std::move(pool), std::move(async_m));
+    }
+    SPDLOG_LOGGER_CATCH(source_loc{})
+    return {};
+}
+
+template <typename... Args>
+details::log_awaiter async_logger::async_trace(format_string_t<Args...> fmt, Args &&...args) {
+    return async_log(level::trace, fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+details::log_awaiter async_logger::async_debug(format_string_t<Args...> fmt, Args &&...args) {
+    return async_log(level::debug, fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+details::log_awaiter async_logger::async_info(format_string_t<Args...> fmt, Args &&...args) {
+    return async_log(level::info, fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+details::log_awaiter async_logger::async_warn(format_string_t<Args...> fmt, Args &&...args) {
+    return async_log(level::warn, fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+details::log_awaiter async_logger::async_error(format_string_t<Args...> fmt, Args &&...args) {
+    return async_log(level::err, fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+details::log_awaiter async_logger::async_critical(format_string_t<Args...> fmt,
+                                                  Args &&...args) {
+    return async_log(level::critical, fmt, std::forward<Args>(args)...);
+}
+
+}  // namespace spdlog
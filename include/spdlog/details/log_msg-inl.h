@@ -8,6 +8,9 @@
 #endif
 
 #include <spdlog/details/os.h>
+#include <spdlog/details/tsc_clock.h>
+
+#include <cstdint>
 
 namespace spdlog {
 namespace details {
@@ -22,7 +25,8 @@ SPDLOG_INLINE log_msg::log_msg(spdlog::log_clock::time_point log_time,
       time(log_time)
 #ifndef SPDLOG_NO_THREAD_ID
       ,
-      thread_id(os::thread_id())
+      thread_id(os::thread_id()),
+      thread_name(os::thread_name())
 #endif
       ,
       source(loc),
@@ -40,5 +44,45 @@ SPDLOG_INLINE log_msg::log_msg(string_view_t a_logger_name,
                                spdlog::string_view_t msg)
     : log_msg(os::now(), source_loc{}, a_logger_name, lvl, msg) {}
 
+SPDLOG_INLINE log_msg::log_msg(spdlog::source_loc loc,
+                               string_view_t a_logger_name,
+                               spdlog::level::level_enum lvl,
+                               spdlog::string_view_t msg,
+                               unsigned fields,
+                               clock_source clock)
+    : logger_name(a_logger_name),
+      level(lvl),
+      payload(msg) {
+    if (fields & msg_field::time) {
+        std::uint64_t ticks =
+            clock == clock_source::tsc_deferred ? tsc_clock::calibrated_ticks() : 0;
+        if (ticks != 0) {
+            time = log_clock::time_point(log_clock::duration(static_cast<log_clock::rep>(ticks)));
+            tsc_time = true;
+        } else {
+            time = os::now(clock);
+        }
+    }
+#ifndef SPDLOG_NO_THREAD_ID
+    if (fields & msg_field::thread_id) {
+        thread_id = os::thread_id();
+    }
+    if (fields & msg_field::thread_name) {
+        thread_name = os::thread_name();
+    }
+#endif
+    if (fields & msg_field::source) {
+        source = loc;
+    }
+}
+
+SPDLOG_INLINE void log_msg::resolve_time() SPDLOG_NOEXCEPT {
+    if (tsc_time) {
+        auto ticks = static_cast<std::uint64_t>(time.time_since_epoch().count());
+        time = tsc_clock::to_time_point(ticks);
+        tsc_time = false;
+    }
+}
+
 }  // namespace details
 }  // namespace spdlog
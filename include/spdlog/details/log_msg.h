@@ -4,6 +4,7 @@
 #pragma once
 
 #include <spdlog/common.h>
+#include <spdlog/kv.h>
 #include <string>
 
 namespace spdlog {
@@ -17,13 +18,31 @@ struct SPDLOG_API log_msg {
             string_view_t msg);
     log_msg(source_loc loc, string_view_t logger_name, level::level_enum lvl, string_view_t msg);
     log_msg(string_view_t logger_name, level::level_enum lvl, string_view_t msg);
+    // fill only the given msg_field fields (the others keep their default value), reading the
+    // time from the given clock
+    log_msg(source_loc loc,
+            string_view_t logger_name,
+            level::level_enum lvl,
+            string_view_t msg,
+            unsigned fields,
+            clock_source clock = clock_source::standard);
     log_msg(const log_msg &other) = default;
     log_msg &operator=(const log_msg &other) = default;
 
+    // convert time if it holds the raw counter
+    void resolve_time() SPDLOG_NOEXCEPT;
+
     string_view_t logger_name;
     level::level_enum level{level::off};
+    // payload points to static storage (see static_msg): not copied by log_msg_buffer.
+    // declared here to fill the padding after level.
+    bool static_payload{false};
+    // time holds the raw tsc_clock counter, converted by resolve_time() (see
+    // clock_source::tsc_deferred)
+    bool tsc_time{false};
     log_clock::time_point time;
     size_t thread_id{0};
+    string_view_t thread_name;
 
     // wrapping the formatted text with color (updated by pattern_formatter).
     mutable size_t color_range_start{0};
@@ -31,6 +50,17 @@ struct SPDLOG_API log_msg {
 
     source_loc source;
     string_view_t payload;
+
+    // the typed fields logged after the payload (see kv.h)
+    const kv_field *kv_fields{nullptr};
+    size_t kv_count{0};
+
+    // the format string and the arguments of the payload, as kv fields without keys. set only
+    // if msg_field::arguments is needed and all the arguments are supported (see
+    // message_args.h), else args is null.
+    string_view_t format;
+    const kv_field *args{nullptr};
+    size_t arg_count{0};
 };
 }  // namespace details
 }  // namespace spdlog
@@ -12,28 +12,46 @@ namespace details {
 
 SPDLOG_INLINE log_msg_buffer::log_msg_buffer(const log_msg &orig_msg)
     : log_msg{orig_msg} {
-    buffer.append(logger_name.begin(), logger_name.end());
-    buffer.append(payload.begin(), payload.end());
+    append_strings(orig_msg);
+    update_string_views();
+}
+
+SPDLOG_INLINE log_msg_buffer::log_msg_buffer(const log_msg &orig_msg, bool borrow_logger_name)
+    : log_msg{orig_msg},
+      borrowed_logger_name{borrow_logger_name} {
+    append_strings(orig_msg);
     update_string_views();
 }
 
 SPDLOG_INLINE log_msg_buffer::log_msg_buffer(const log_msg_buffer &other)
     : log_msg{other} {
-    buffer.append(logger_name.begin(), logger_name.end());
-    buffer.append(payload.begin(), payload.end());
+    append_strings(other);
     update_string_views();
 }
 
 SPDLOG_INLINE log_msg_buffer::log_msg_buffer(log_msg_buffer &&other) SPDLOG_NOEXCEPT
     : log_msg{other},
+      kv_buffer{std::move(other.kv_buffer)},
+      borrowed_logger_name{other.borrowed_logger_name},
       buffer{std::move(other.buffer)} {
     update_string_views();
 }
 
 SPDLOG_INLINE log_msg_buffer &log_msg_buffer::operator=(const log_msg_buffer &other) {
+    if (other.borrowed_logger_name) {
+        if (this != &other) {
+            assign(other);
+        }
+        return *this;
+    }
     log_msg::operator=(other);
+    borrowed_logger_name = false;
     buffer.clear();
     buffer.append(other.buffer.data(), other.buffer.data() + other.buffer.size());
+    kv_buffer = other.kv_buffer;
+    if (args != nullptr) {
+        kv_buffer.reserve(kv_buffer.size() + 1);  // args not null if none
+    }
     update_string_views();
     return *this;
 }
@@ -41,13 +59,76 @@ SPDLOG_INLINE log_msg_buffer &log_msg_buffer::operator=(const log_msg_buffer &ot
 SPDLOG_INLINE log_msg_buffer &log_msg_buffer::operator=(log_msg_buffer &&other) SPDLOG_NOEXCEPT {
     log_msg::operator=(other);
     buffer = std::move(other.buffer);
+    kv_buffer = std::move(other.kv_buffer);
+    borrowed_logger_name = other.borrowed_logger_name;
     update_string_views();
     return *this;
 }
 
+SPDLOG_INLINE void log_msg_buffer::assign(const log_msg &orig_msg) {
+    log_msg::operator=(orig_msg);
+    borrowed_logger_name = false;
+    buffer.clear();
+    append_strings(orig_msg);
+    update_string_views();
+}
+
+SPDLOG_INLINE void log_msg_buffer::replace_payload(string_view_t new_payload) {
+    auto payload_start = (borrowed_logger_name ? 0 : logger_name.size()) + thread_name.size();
+    for (const auto &field : kv_buffer) {
+        payload_start += field.key.size() + field.string_value.size();
+    }
+    payload_start += format.size();
+    buffer.resize(payload_start);
+    buffer.append(new_payload.begin(), new_payload.end());
+    payload = string_view_t{buffer.data() + payload_start, new_payload.size()};
+    static_payload = false;
+}
+
+// in the order of update_string_views()
+SPDLOG_INLINE void log_msg_buffer::append_strings(const log_msg &orig_msg) {
+    if (!borrowed_logger_name) {
+        buffer.append(orig_msg.logger_name.begin(), orig_msg.logger_name.end());
+    }
+    buffer.append(orig_msg.thread_name.begin(), orig_msg.thread_name.end());
+    kv_buffer.assign(orig_msg.kv_fields, orig_msg.kv_fields + orig_msg.kv_count);
+    if (orig_msg.args != nullptr) {
+        kv_buffer.reserve(orig_msg.kv_count + orig_msg.arg_count + 1);  // args not null if none
+        kv_buffer.insert(kv_buffer.end(), orig_msg.args, orig_msg.args + orig_msg.arg_count);
+    }
+    for (const auto &field : kv_buffer) {
+        buffer.append(field.key.begin(), field.key.end());
+        buffer.append(field.string_value.begin(), field.string_value.end());
+    }
+    buffer.append(orig_msg.format.begin(), orig_msg.format.end());
+    if (!orig_msg.static_payload) {
+        buffer.append(orig_msg.payload.begin(), orig_msg.payload.end());
+    }
+}
+
 SPDLOG_INLINE void log_msg_buffer::update_string_views() {
-    logger_name = string_view_t{buffer.data(), logger_name.size()};
-    payload = string_view_t{buffer.data() + logger_name.size(), payload.size()};
+    auto *pos = buffer.data();
+    if (!borrowed_logger_name) {
+        logger_name = string_view_t{pos, logger_name.size()};
+        pos += logger_name.size();
+    }
+    thread_name = string_view_t{pos, thread_name.size()};
+    pos += thread_name.size();
+    for (auto &field : kv_buffer) {
+        field.key = string_view_t{pos, field.key.size()};
+        pos += field.key.size();
+        field.string_value = string_view_t{pos, field.string_value.size()};
+        pos += field.string_value.size();
+    }
+    kv_fields = kv_count == 0 ? nullptr : kv_buffer.data();
+    format = string_view_t{pos, format.size()};
+    pos += format.size();
+    if (args != nullptr) {
+        args = kv_buffer.data() + kv_count;  // after the kv fields
+    }
+    if (!static_payload) {
+        payload = string_view_t{pos, payload.size()};
+    }
 }
 
 }  // namespace details
@@ -4,15 +4,44 @@
 #pragma once
 
 #include <spdlog/details/log_msg.h>
+#include <spdlog/details/msg_pool.h>
+
+#include <vector>
+
+// Size of the buffer embedded in each message (logger name + thread name + kv strings +
+// format string + payload).
+// Bigger messages get their buffer from the msg_pool.
+#ifndef SPDLOG_MSG_BUFFER_INLINE_SIZE
+    #define SPDLOG_MSG_BUFFER_INLINE_SIZE 250
+#endif
 
 namespace spdlog {
 namespace details {
 
+// Allocator of the buffers of the messages too big for the inline buffer (see tweakme.h).
+#ifndef SPDLOG_MSG_BUFFER_ALLOCATOR
+    #define SPDLOG_MSG_BUFFER_ALLOCATOR spdlog::details::msg_pool_allocator
+#endif
+
+#ifdef SPDLOG_USE_STD_FORMAT
+using msg_buf_t = memory_buf_t;
+#else
+using msg_buf_t = fmt::basic_memory_buffer<char,
+                                           SPDLOG_MSG_BUFFER_INLINE_SIZE,
+                                           SPDLOG_MSG_BUFFER_ALLOCATOR<char>>;
+#endif
+
 // Extend log_msg with internal buffer to store its payload.
 // This is needed since log_msg holds string_views that points to stack data.
 
 class SPDLOG_API log_msg_buffer : public log_msg {
-    memory_buf_t buffer;
+    std::vector<kv_field> kv_buffer;  // the kv fields then the args, with their strings in buffer
+    // logger_name points to the logger's own name instead of a copy in buffer
+    bool borrowed_logger_name{false};
+    // last, so the fields above share cache lines with log_msg rather than with the
+    // end of the inline storage
+    msg_buf_t buffer;
+    void append_strings(const log_msg &orig_msg);
     void update_string_views();
 
 public:
@@ -22,6 +51,16 @@ public:
     log_msg_buffer(log_msg_buffer &&other) SPDLOG_NOEXCEPT;
     log_msg_buffer &operator=(const log_msg_buffer &other);
     log_msg_buffer &operator=(log_msg_buffer &&other) SPDLOG_NOEXCEPT;
+
+    // copy orig_msg (which must not point into this buffer), reusing the buffer
+    void assign(const log_msg &orig_msg);
+    // replace the payload with a copy of the given one (which must not point into this buffer)
+    void replace_payload(string_view_t new_payload);
+
+protected:
+    // same as log_msg_buffer(orig_msg), but if borrow_logger_name don't copy the logger name:
+    // it must outlive the message (see async_msg). copies of the message get their own.
+    log_msg_buffer(const log_msg &orig_msg, bool borrow_logger_name);
 };
 
 }  // namespace details
@@ -0,0 +1,61 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// The arguments of a message kept next to its format string as kv fields without keys (see
+// msg_field::arguments), for the binary_formatter's message catalog to ship them instead of
+// the formatted text.
+// Only the types a kv field holds exactly are kept: the integers but the characters, bool,
+// double and the strings. The calls with other arguments (or with std::format) keep only their
+// text.
+
+#include <spdlog/details/deferred_args.h>
+#include <spdlog/kv.h>
+
+#include <type_traits>
+
+namespace spdlog {
+namespace details {
+namespace message_args {
+
+template <typename T>
+struct is_char
+    : std::integral_constant<bool,
+                             std::is_same<T, char>::value || std::is_same<T, wchar_t>::value ||
+                                 std::is_same<T, char16_t>::value ||
+                                 std::is_same<T, char32_t>::value> {};
+
+template <typename T>
+struct is_supported
+    : std::integral_constant<bool,
+                             (std::is_integral<T>::value && !is_char<T>::value) ||
+                                 std::is_same<T, double>::value ||
+                                 deferred::is_string<T>::value> {};
+
+template <typename... Args>
+struct all_supported : std::true_type {};
+
+template <typename T, typename... Rest>
+struct all_supported<T, Rest...>
+    : std::integral_constant<bool,
+                             is_supported<typename std::decay<T>::type>::value &&
+                                 all_supported<Rest...>::value> {};
+
+}  // namespace message_args
+
+#ifdef SPDLOG_USE_STD_FORMAT
+template <typename... Args>
+using has_message_args = std::false_type;  // binary_log_reader can't format them back
+#else
+template <typename... Args>
+using has_message_args = message_args::all_supported<Args...>;
+#endif
+
+template <typename T>
+kv_field message_arg(const T &value) {
+    return kv(string_view_t(), value);
+}
+
+}  // namespace details
+}  // namespace spdlog
@@ -7,86 +7,156 @@
 // enqueue(..) - will block until room found to put the new message.
 // enqueue_nowait(..) - will return immediately with false if no room left in
 // the queue.
+// try_enqueue(..) - will return false if no room left, keeping the item.
 // dequeue_for(..) - will block until the queue is not empty or timeout have
 // passed.
+// dequeue_bulk(..) - will block until the queue is not empty, then pop as many items as
+// available (up to the given max).
+// size(), high_water_mark() and the counters don't take the queue mutex, so polling them
+// doesn't contend with the producers.
 
 #include <spdlog/details/circular_q.h>
+#include <spdlog/details/striped_counter.h>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 
 namespace spdlog {
 namespace details {
 
-template <typename T>
+template <typename T, typename Alloc = std::allocator<T>>
 class mpmc_blocking_queue {
 public:
     using item_type = T;
-    explicit mpmc_blocking_queue(size_t max_items)
-        : q_(max_items) {}
+    explicit mpmc_blocking_queue(size_t max_items, const Alloc &alloc = Alloc())
+        : q_(max_items, alloc) {}
 
 #ifndef __MINGW32__
     // try to enqueue and block if no room left
     void enqueue(T &&item) {
+        bool wake;
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
-            pop_cv_.wait(lock, [this] { return !this->q_.full(); });
+            wait_for_room_(lock);
             q_.push_back(std::move(item));
+            update_stats_();
+            wake = sleeping_consumers_ > 0;
+        }
+        if (wake) {
+            push_cv_.notify_one();
         }
-        push_cv_.notify_one();
     }
 
     // enqueue immediately. overrun oldest message in the queue if no room left.
     void enqueue_nowait(T &&item) {
+        bool wake;
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             q_.push_back(std::move(item));
+            update_stats_();
+            wake = sleeping_consumers_ > 0;
+        }
+        if (wake) {
+            push_cv_.notify_one();
         }
-        push_cv_.notify_one();
     }
 
-    void enqueue_if_have_room(T &&item) {
-        bool pushed = false;
+    // enqueue if there is room. return false (leaving the item untouched) otherwise.
+    bool try_enqueue(T &&item) {
+        bool wake;
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (!q_.full()) {
-                q_.push_back(std::move(item));
-                pushed = true;
+            if (q_.full()) {
+                return false;
             }
+            q_.push_back(std::move(item));
+            update_stats_();
+            wake = sleeping_consumers_ > 0;
         }
-
-        if (pushed) {
+        if (wake) {
             push_cv_.notify_one();
-        } else {
-            ++discard_counter_;
         }
+        return true;
     }
 
     // dequeue with a timeout.
     // Return true, if succeeded dequeue item, false otherwise
     bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) {
+        bool wake;
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (!push_cv_.wait_for(lock, wait_duration, [this] { return !this->q_.empty(); })) {
+            if (!wait_for_items_(lock, wait_duration)) {
                 return false;
             }
             popped_item = std::move(q_.front());
             q_.pop_front();
+            update_stats_();
+            wake = sleeping_producers_ > 0;
+        }
+        if (wake) {
+            pop_cv_.notify_one();
         }
-        pop_cv_.notify_one();
         return true;
     }
 
     // blocking dequeue without a timeout.
     void dequeue(T &popped_item) {
+        bool wake;
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
-            push_cv_.wait(lock, [this] { return !this->q_.empty(); });
+            wait_for_items_(lock);
             popped_item = std::move(q_.front());
             q_.pop_front();
+            update_stats_();
+            wake = sleeping_producers_ > 0;
+        }
+        if (wake) {
+            pop_cv_.notify_one();
+        }
+    }
+
+    // blocking dequeue of up to max_items at once.
+    // Return the number of items popped (at least one).
+    size_t dequeue_bulk(T *popped_items, size_t max_items) {
+        size_t n = 0;
+        bool wake;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            wait_for_items_(lock);
+            while (n < max_items && !q_.empty()) {
+                popped_items[n++] = std::move(q_.front());
+                q_.pop_front();
+            }
+            update_stats_();
+            wake = sleeping_producers_ > 0;
+        }
+        if (wake) {
+            pop_cv_.notify_all();
+        }
+        return n;
+    }
+
+    // non blocking dequeue of up to max_items at once.
+    // Return the number of items popped (zero if the queue is empty).
+    size_t try_dequeue_bulk(T *popped_items, size_t max_items) {
+        size_t n = 0;
+        bool wake;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            while (n < max_items && !q_.empty()) {
+                popped_items[n++] = std::move(q_.front());
+                q_.pop_front();
+            }
+            update_stats_();
+            wake = n > 0 && sleeping_producers_ > 0;
         }
-        pop_cv_.notify_one();
+        if (wake) {
+            pop_cv_.notify_all();
+        }
+        return n;
     }
 
 #else
@@ -96,82 +166,199 @@ public:
     // try to enqueue and block if no room left
     void enqueue(T &&item) {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        pop_cv_.wait(lock, [this] { return !this->q_.full(); });
+        wait_for_room_(lock);
         q_.push_back(std::move(item));
-        push_cv_.notify_one();
+        update_stats_();
+        if (sleeping_consumers_ > 0) {
+            push_cv_.notify_one();
+        }
     }
 
     // enqueue immediately. overrun oldest message in the queue if no room left.
     void enqueue_nowait(T &&item) {
         std::unique_lock<std::mutex> lock(queue_mutex_);
         q_.push_back(std::move(item));
-        push_cv_.notify_one();
+        update_stats_();
+        if (sleeping_consumers_ > 0) {
+            push_cv_.notify_one();
+        }
     }
 
-    void enqueue_if_have_room(T &&item) {
-        bool pushed = false;
+    // enqueue if there is room. return false (leaving the item untouched) otherwise.
+    bool try_enqueue(T &&item) {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        if (!q_.full()) {
-            q_.push_back(std::move(item));
-            pushed = true;
+        if (q_.full()) {
+            return false;
         }
-
-        if (pushed) {
+        q_.push_back(std::move(item));
+        update_stats_();
+        if (sleeping_consumers_ > 0) {
             push_cv_.notify_one();
-        } else {
-            ++discard_counter_;
         }
+        return true;
     }
 
     // dequeue with a timeout.
     // Return true, if succeeded dequeue item, false otherwise
     bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        if (!push_cv_.wait_for(lock, wait_duration, [this] { return !this->q_.empty(); })) {
+        if (!wait_for_items_(lock, wait_duration)) {
             return false;
         }
         popped_item = std::move(q_.front());
         q_.pop_front();
-        pop_cv_.notify_one();
+        update_stats_();
+        if (sleeping_producers_ > 0) {
+            pop_cv_.notify_one();
+        }
         return true;
     }
 
     // blocking dequeue without a timeout.
     void dequeue(T &popped_item) {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        push_cv_.wait(lock, [this] { return !this->q_.empty(); });
+        wait_for_items_(lock);
         popped_item = std::move(q_.front());
         q_.pop_front();
-        pop_cv_.notify_one();
+        update_stats_();
+        if (sleeping_producers_ > 0) {
+            pop_cv_.notify_one();
+        }
     }
 
-#endif
+    // blocking dequeue of up to max_items at once.
+    // Return the number of items popped (at least one).
+    size_t dequeue_bulk(T *popped_items, size_t max_items) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        wait_for_items_(lock);
+        size_t n = 0;
+        while (n < max_items && !q_.empty()) {
+            popped_items[n++] = std::move(q_.front());
+            q_.pop_front();
+        }
+        update_stats_();
+        if (sleeping_producers_ > 0) {
+            pop_cv_.notify_all();
+        }
+        return n;
+    }
 
-    size_t overrun_counter() {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        return q_.overrun_counter();
+    // non blocking dequeue of up to max_items at once.
+    // Return the number of items popped (zero if the queue is empty).
+    size_t try_dequeue_bulk(T *popped_items, size_t max_items) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        size_t n = 0;
+        while (n < max_items && !q_.empty()) {
+            popped_items[n++] = std::move(q_.front());
+            q_.pop_front();
+        }
+        update_stats_();
+        if (n > 0 && sleeping_producers_ > 0) {
+            pop_cv_.notify_all();
+        }
+        return n;
     }
 
-    size_t discard_counter() { return discard_counter_.load(std::memory_order_relaxed); }
+#endif
 
-    size_t size() {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        return q_.size();
+    void enqueue_if_have_room(T &&item) {
+        if (!try_enqueue(std::move(item))) {
+            ++discard_counter_;
+        }
     }
 
+    // the counters and the sizes are read without taking the queue mutex
+    size_t overrun_counter() { return overrun_counter_.load(std::memory_order_relaxed); }
+
+    size_t discard_counter() { return discard_counter_.load(); }
+
+    // number of items in the queue, as of the last push or pop
+    size_t size() { return size_.load(std::memory_order_relaxed); }
+
+    // highest size() since the queue was created or the mark was reset
+    size_t high_water_mark() { return high_water_mark_.load(std::memory_order_relaxed); }
+
     void reset_overrun_counter() {
         std::lock_guard<std::mutex> lock(queue_mutex_);
         q_.reset_overrun_counter();
+        overrun_counter_.store(0, std::memory_order_relaxed);
     }
 
-    void reset_discard_counter() { discard_counter_.store(0, std::memory_order_relaxed); }
+    void reset_discard_counter() { discard_counter_.reset(); }
+
+    // restart the high water mark from the current size
+    void reset_high_water_mark() {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        high_water_mark_.store(q_.size(), std::memory_order_relaxed);
+    }
+
+    // call fn on each queued item, oldest first, without taking the mutex (for a crash
+    // handler: the items may be changed meanwhile)
+    template <typename F>
+    void visit_unsafe(F &&fn) const {
+        auto n = q_.size();
+        for (size_t i = 0; i < n; i++) {
+            fn(q_.at(i));
+        }
+    }
 
 private:
     std::mutex queue_mutex_;
     std::condition_variable push_cv_;
     std::condition_variable pop_cv_;
-    spdlog::details::circular_q<T> q_;
-    std::atomic<size_t> discard_counter_{0};
+    spdlog::details::circular_q<T, Alloc> q_;
+    striped_counter discard_counter_;
+    // copies of the state of q_ for the lock free getters. written with queue_mutex_ held.
+    std::atomic<size_t> size_{0};
+    std::atomic<size_t> high_water_mark_{0};
+    std::atomic<size_t> overrun_counter_{0};
+    // threads waiting on push_cv_/pop_cv_. the other side only notifies them if non zero,
+    // so no notify call is made while the consumers keep up. guarded by queue_mutex_.
+    size_t sleeping_consumers_ = 0;
+    size_t sleeping_producers_ = 0;
+
+    // must be called with queue_mutex_ held, after each change of q_
+    void update_stats_() {
+        auto size = q_.size();
+        size_.store(size, std::memory_order_relaxed);
+        if (size > high_water_mark_.load(std::memory_order_relaxed)) {
+            high_water_mark_.store(size, std::memory_order_relaxed);
+        }
+        overrun_counter_.store(q_.overrun_counter(), std::memory_order_relaxed);
+    }
+
+    // must be called with queue_mutex_ held
+    void wait_for_items_(std::unique_lock<std::mutex> &lock) {
+        while (q_.empty()) {
+            sleeping_consumers_++;
+            push_cv_.wait(lock);
+            sleeping_consumers_--;
+        }
+    }
+
+    // same, with a timeout. return false if still empty once it has passed
+    bool wait_for_items_(std::unique_lock<std::mutex> &lock,
+                         std::chrono::milliseconds wait_duration) {
+        auto deadline = std::chrono::steady_clock::now() + wait_duration;
+        while (q_.empty()) {
+            sleeping_consumers_++;
+            auto status = push_cv_.wait_until(lock, deadline);
+            sleeping_consumers_--;
+            if (status == std::cv_status::timeout) {
+                return !q_.empty();
+            }
+        }
+        return true;
+    }
+
+    // must be called with queue_mutex_ held
+    void wait_for_room_(std::unique_lock<std::mutex> &lock) {
+        while (q_.full()) {
+            sleeping_producers_++;
+            pop_cv_.wait(lock);
+            sleeping_producers_--;
+        }
+    }
 };
 }  // namespace details
 }  // namespace spdlog
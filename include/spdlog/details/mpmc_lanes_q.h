@@ -0,0 +1,254 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// multi producer-multi consumer blocking queue made of several lanes, each with its own
+// capacity. Items are put in the lane returned by the lane_of function, and consumers always
+// pop from the highest (last) non empty lane first.
+// The overflow policies apply to the item's lane only, so a flood of items in one lane
+// never evicts or blocks items of the other lanes.
+//
+// enqueue(..) - will block until room found in the item's lane.
+// enqueue_nowait(..) - will overrun the oldest item of the lane if no room left.
+// enqueue_if_have_room(..) - will discard the new item if no room left in its lane.
+// dequeue_for(..) - will block until the queue is not empty or timeout have passed.
+// dequeue_bulk(..) - will block until the queue is not empty, then pop as many items as
+// available (up to the given max).
+
+#include <spdlog/details/circular_q.h>
+#include <spdlog/details/striped_counter.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+template <typename T>
+class mpmc_lanes_queue {
+public:
+    using item_type = T;
+    using lane_function = std::function<size_t(const T &)>;
+
+    // lane_of must return an index in lane_sizes
+    mpmc_lanes_queue(const std::vector<size_t> &lane_sizes, lane_function lane_of)
+        : lane_sizes_(lane_sizes),
+          lane_of_(std::move(lane_of)) {
+        lanes_.reserve(lane_sizes.size());
+        for (auto lane_size : lane_sizes) {
+            lanes_.emplace_back(lane_size);
+        }
+    }
+
+    // try to enqueue and block if no room left in the item's lane
+    void enqueue(T &&item) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            auto lane_index = lane_of_(item);
+            auto &lane = lanes_[lane_index];
+            if (lane_sizes_[lane_index] == 0) {
+                ++discard_counter_;
+                return;
+            }
+            if (lane.full()) {
+                blocked_producers_++;
+                pop_cv_.wait(lock, [&lane] { return !lane.full(); });
+                blocked_producers_--;
+            }
+            lane.push_back(std::move(item));
+            update_stats_();
+        }
+        push_cv_.notify_one();
+    }
+
+    // enqueue immediately. overrun oldest item of the lane if no room left.
+    void enqueue_nowait(T &&item) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            lanes_[lane_of_(item)].push_back(std::move(item));
+            update_stats_();
+        }
+        push_cv_.notify_one();
+    }
+
+    void enqueue_if_have_room(T &&item) {
+        if (!try_enqueue(std::move(item))) {
+            ++discard_counter_;
+        }
+    }
+
+    // enqueue if there is room in the item's lane. return false (leaving the item untouched)
+    // otherwise.
+    bool try_enqueue(T &&item) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            auto lane_index = lane_of_(item);
+            auto &lane = lanes_[lane_index];
+            if (lane_sizes_[lane_index] == 0 || lane.full()) {
+                return false;
+            }
+            lane.push_back(std::move(item));
+            update_stats_();
+        }
+        push_cv_.notify_one();
+        return true;
+    }
+
+    // dequeue with a timeout.
+    // Return true, if succeeded dequeue item, false otherwise
+    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (!push_cv_.wait_for(lock, wait_duration, [this] { return !this->empty_(); })) {
+            return false;
+        }
+        pop_(popped_item);
+        notify_producers_();
+        return true;
+    }
+
+    // blocking dequeue without a timeout.
+    void dequeue(T &popped_item) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        push_cv_.wait(lock, [this] { return !this->empty_(); });
+        pop_(popped_item);
+        notify_producers_();
+    }
+
+    // blocking dequeue of up to max_items at once, highest lanes first.
+    // Return the number of items popped (at least one).
+    size_t dequeue_bulk(T *popped_items, size_t max_items) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        push_cv_.wait(lock, [this] { return !this->empty_(); });
+        size_t n = 0;
+        while (n < max_items && pop_(popped_items[n])) {
+            n++;
+        }
+        notify_producers_();
+        return n;
+    }
+
+    // non blocking dequeue of up to max_items at once, highest lanes first.
+    // Return the number of items popped (zero if the queue is empty).
+    size_t try_dequeue_bulk(T *popped_items, size_t max_items) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        size_t n = 0;
+        while (n < max_items && pop_(popped_items[n])) {
+            n++;
+        }
+        if (n > 0) {
+            notify_producers_();
+        }
+        return n;
+    }
+
+    // the counters and the total size are read without taking the queue mutex
+    size_t overrun_counter() { return overrun_counter_.load(std::memory_order_relaxed); }
+
+    size_t discard_counter() { return discard_counter_.load(); }
+
+    // number of items in all lanes, as of the last push or pop
+    size_t size() { return size_.load(std::memory_order_relaxed); }
+
+    // highest size() since the queue was created or the mark was reset
+    size_t high_water_mark() { return high_water_mark_.load(std::memory_order_relaxed); }
+
+    // number of items in the given lane
+    size_t lane_size(size_t lane_index) {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        return lanes_[lane_index].size();
+    }
+
+    void reset_overrun_counter() {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        for (auto &lane : lanes_) {
+            lane.reset_overrun_counter();
+        }
+        overrun_counter_.store(0, std::memory_order_relaxed);
+    }
+
+    void reset_discard_counter() { discard_counter_.reset(); }
+
+    void reset_high_water_mark() {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        high_water_mark_.store(size_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    // call fn on each queued item, lane by lane, without taking the mutex (for a crash
+    // handler: the items may be changed meanwhile)
+    template <typename F>
+    void visit_unsafe(F &&fn) const {
+        for (auto &lane : lanes_) {
+            auto n = lane.size();
+            for (size_t i = 0; i < n; i++) {
+                fn(lane.at(i));
+            }
+        }
+    }
+
+private:
+    std::mutex queue_mutex_;
+    std::condition_variable push_cv_;
+    std::condition_variable pop_cv_;
+    std::vector<spdlog::details::circular_q<T>> lanes_;
+    std::vector<size_t> lane_sizes_;
+    lane_function lane_of_;
+    int blocked_producers_ = 0;
+    striped_counter discard_counter_;
+    // totals of the lanes for the lock free getters. written with queue_mutex_ held.
+    std::atomic<size_t> size_{0};
+    std::atomic<size_t> high_water_mark_{0};
+    std::atomic<size_t> overrun_counter_{0};
+
+    // must be called with queue_mutex_ held, after each change of the lanes
+    void update_stats_() {
+        size_t size = 0;
+        size_t overruns = 0;
+        for (auto &lane : lanes_) {
+            size += lane.size();
+            overruns += lane.overrun_counter();
+        }
+        size_.store(size, std::memory_order_relaxed);
+        if (size > high_water_mark_.load(std::memory_order_relaxed)) {
+            high_water_mark_.store(size, std::memory_order_relaxed);
+        }
+        overrun_counter_.store(overruns, std::memory_order_relaxed);
+    }
+
+    // must be called with queue_mutex_ held
+    bool empty_() const {
+        for (auto &lane : lanes_) {
+            if (!lane.empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // pop from the highest non empty lane. must be called with queue_mutex_ held
+    bool pop_(T &popped_item) {
+        for (auto it = lanes_.rbegin(); it != lanes_.rend(); ++it) {
+            if (!it->empty()) {
+                popped_item = std::move(it->front());
+                it->pop_front();
+                update_stats_();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // producers may wait on different lanes, so wake them all.
+    // must be called with queue_mutex_ held
+    void notify_producers_() {
+        if (blocked_producers_ > 0) {
+            pop_cv_.notify_all();
+        }
+    }
+};
+}  // namespace details
+}  // namespace spdlog
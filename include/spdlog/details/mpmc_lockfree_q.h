@@ -0,0 +1,399 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// multi producer-multi consumer bounded lock-free queue.
+// Based on Dmitry Vyukov's bounded queue: each slot holds a sequence number telling
+// producers and consumers whether it is free to write or ready to read, so push and pop
+// only cost a CAS on the enqueue/dequeue position and no mutex is taken on the fast path.
+//
+// enqueue(..) - will block until room found to put the new message.
+// enqueue_nowait(..) - will overrun the oldest message in the queue if no room left.
+// enqueue_if_have_room(..) - will discard the new message if no room left.
+// dequeue_for(..) - will block until the queue is not empty or timeout have passed.
+// dequeue_bulk(..) - will block until the queue is not empty, then pop as many items as
+// available (up to the given max).
+//
+// The mutex and condition variables are only used to park threads that found the queue
+// empty (consumers) or full (blocking producers). The other side touches them only when
+// some thread is actually parked.
+//
+// In C++20 (unless SPDLOG_NO_ATOMIC_WAIT is defined), the threads park without the mutex
+// instead, with std::atomic::wait() on a counter bumped by the other side when some thread
+// is parked, which the standard library maps to a futex (or WaitOnAddress) directly. Only
+// dequeue_for() still uses the mutex and a condition variable, since atomic waits can't time
+// out.
+
+#include <spdlog/details/striped_counter.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__cpp_lib_atomic_wait) && __cpp_lib_atomic_wait >= 201907L && \
+    !defined(SPDLOG_NO_ATOMIC_WAIT)
+    #define SPDLOG_QUEUE_ATOMIC_WAIT
+#endif
+
+namespace spdlog {
+namespace details {
+
+template <typename T, typename Alloc = std::allocator<T>>
+class mpmc_lockfree_queue {
+public:
+    using item_type = T;
+    explicit mpmc_lockfree_queue(size_t max_items, const Alloc &alloc = Alloc())
+        : max_items_(max_items),
+          cells_(max_items, cell_allocator(alloc)) {
+        for (size_t i = 0; i < max_items_; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_lockfree_queue(const mpmc_lockfree_queue &) = delete;
+    mpmc_lockfree_queue &operator=(const mpmc_lockfree_queue &) = delete;
+
+    // try to enqueue and block if no room left
+    void enqueue(T &&item) {
+        if (!try_push_(item)) {
+            park_producer_(item);
+        }
+        notify_consumers_();
+    }
+
+    // enqueue immediately. overrun oldest message in the queue if no room left.
+    void enqueue_nowait(T &&item) {
+        if (max_items_ == 0) {
+            overrun_counter_.add();
+            return;
+        }
+        while (!try_push_(item)) {
+            note_size_();
+            T oldest;
+            if (pop_(oldest)) {
+                overrun_counter_.add();
+            }
+        }
+        notify_consumers_();
+    }
+
+    void enqueue_if_have_room(T &&item) {
+        if (!try_enqueue(std::move(item))) {
+            discard_counter_.add();
+        }
+    }
+
+    // enqueue if there is room. return false (leaving the item untouched) otherwise.
+    bool try_enqueue(T &&item) {
+        if (!try_push_(item)) {
+            return false;
+        }
+        notify_consumers_();
+        return true;
+    }
+
+    // dequeue with a timeout.
+    // Return true, if succeeded dequeue item, false otherwise
+    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) {
+        note_size_();
+        if (pop_(popped_item)) {
+            return true;
+        }
+        auto deadline = std::chrono::steady_clock::now() + wait_duration;
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        timed_consumers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool popped = false;
+        while (!(popped = try_pop_(popped_item))) {
+            if (push_cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                popped = try_pop_(popped_item);
+                break;
+            }
+        }
+        timed_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        if (popped) {
+            lock.unlock();
+            notify_producers_();
+        }
+        return popped;
+    }
+
+    // blocking dequeue without a timeout.
+    void dequeue(T &popped_item) {
+        note_size_();
+        if (pop_(popped_item)) {
+            return;
+        }
+#ifdef SPDLOG_QUEUE_ATOMIC_WAIT
+        waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (;;) {
+            // read before trying, so a push after the try changes it
+            auto epoch = push_epoch_.load(std::memory_order_seq_cst);
+            if (try_pop_(popped_item)) {
+                break;
+            }
+            push_epoch_.wait(epoch, std::memory_order_seq_cst);
+        }
+        waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+#else
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!try_pop_(popped_item)) {
+            push_cv_.wait(lock);
+        }
+        waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        lock.unlock();
+#endif
+        notify_producers_();
+    }
+
+    // blocking dequeue of up to max_items at once.
+    // Return the number of items popped (at least one).
+    size_t dequeue_bulk(T *popped_items, size_t max_items) {
+        dequeue(popped_items[0]);
+        size_t n = 1;
+        while (n < max_items && try_pop_(popped_items[n])) {
+            n++;
+        }
+        if (n > 1) {
+            notify_all_producers_();
+        }
+        return n;
+    }
+
+    // non blocking dequeue of up to max_items at once.
+    // Return the number of items popped (zero if the queue is empty).
+    size_t try_dequeue_bulk(T *popped_items, size_t max_items) {
+        note_size_();
+        size_t n = 0;
+        while (n < max_items && try_pop_(popped_items[n])) {
+            n++;
+        }
+        if (n > 0) {
+            notify_all_producers_();
+        }
+        return n;
+    }
+
+    // non blocking push/pop without waking parked threads, for callers doing their own
+    // signaling. try_push leaves the item untouched if the queue is full.
+    bool try_push(T &&item) { return try_push_(item); }
+
+    bool try_pop(T &popped_item) { return try_pop_(popped_item); }
+
+    size_t overrun_counter() { return overrun_counter_.load(); }
+
+    size_t discard_counter() { return discard_counter_.load(); }
+
+    // approximate number of items in the queue (exact if no concurrent push/pop)
+    size_t size() {
+        auto head = dequeue_pos_.value.load(std::memory_order_relaxed);
+        auto tail = enqueue_pos_.value.load(std::memory_order_relaxed);
+        if (tail <= head) {
+            return 0;
+        }
+        return (tail - head) > max_items_ ? max_items_ : tail - head;
+    }
+
+    // approximate highest size(): sampled by the consumers before popping, and by the
+    // producers before overrunning the oldest message.
+    size_t high_water_mark() { return high_water_mark_.load(std::memory_order_relaxed); }
+
+    void reset_overrun_counter() { overrun_counter_.reset(); }
+
+    void reset_discard_counter() { discard_counter_.reset(); }
+
+    void reset_high_water_mark() { high_water_mark_.store(size(), std::memory_order_relaxed); }
+
+    // call fn on each item ready to be popped, oldest first, without popping it (for a crash
+    // handler: the items may be popped meanwhile)
+    template <typename F>
+    void visit_unsafe(F &&fn) const {
+        auto pos = dequeue_pos_.value.load(std::memory_order_acquire);
+        auto end = enqueue_pos_.value.load(std::memory_order_acquire);
+        for (size_t i = 0; i < max_items_ && pos + i < end; i++) {
+            const cell &c = cells_[(pos + i) % max_items_];
+            if (c.sequence.load(std::memory_order_acquire) == pos + i + 1) {
+                fn(c.data);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t cache_line_size = 64;
+
+    struct cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    // keep the producers' and the consumers' positions on separate cache lines
+    struct padded_pos {
+        std::atomic<size_t> value{0};
+        char padding[cache_line_size - sizeof(std::atomic<size_t>)];
+    };
+
+    using cell_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<cell>;
+
+    size_t max_items_;
+    std::vector<cell, cell_allocator> cells_;
+    padded_pos enqueue_pos_;
+    padded_pos dequeue_pos_;
+
+    striped_counter overrun_counter_;
+    striped_counter discard_counter_;
+    std::atomic<size_t> high_water_mark_{0};
+
+    std::mutex park_mutex_;
+    std::condition_variable push_cv_;
+    std::atomic<int> waiting_consumers_{0};  // parked in dequeue()
+    std::atomic<int> timed_consumers_{0};    // parked in dequeue_for(), on push_cv_
+    std::atomic<int> waiting_producers_{0};
+#ifdef SPDLOG_QUEUE_ATOMIC_WAIT
+    // bumped after a push (or a pop) while some consumer (or producer) is parked on it
+    std::atomic<std::uint32_t> push_epoch_{0};
+    std::atomic<std::uint32_t> pop_epoch_{0};
+#else
+    std::condition_variable pop_cv_;
+#endif
+
+    void note_size_() {
+        auto size = this->size();
+        auto mark = high_water_mark_.load(std::memory_order_relaxed);
+        while (size > mark &&
+               !high_water_mark_.compare_exchange_weak(mark, size, std::memory_order_relaxed)) {
+        }
+    }
+
+    // move the item into a free slot. item is left untouched if the queue is full.
+    bool try_push_(T &item) {
+        if (max_items_ == 0) {
+            return false;
+        }
+        auto pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &c = cells_[pos % max_items_];
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.value.compare_exchange_weak(pos, pos + 1,
+                                                             std::memory_order_relaxed)) {
+                    c.data = std::move(item);
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop_(T &popped_item) {
+        if (max_items_ == 0) {
+            return false;
+        }
+        auto pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &c = cells_[pos % max_items_];
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.value.compare_exchange_weak(pos, pos + 1,
+                                                             std::memory_order_relaxed)) {
+                    popped_item = std::move(c.data);
+                    c.sequence.store(pos + max_items_, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // pop and wake a parked producer (if any) since a slot was freed
+    bool pop_(T &popped_item) {
+        if (!try_pop_(popped_item)) {
+            return false;
+        }
+        notify_producers_();
+        return true;
+    }
+
+    void notify_producers_() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_producers_.load(std::memory_order_relaxed) > 0) {
+#ifdef SPDLOG_QUEUE_ATOMIC_WAIT
+            pop_epoch_.fetch_add(1, std::memory_order_seq_cst);
+            pop_epoch_.notify_one();
+#else
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            pop_cv_.notify_one();
+#endif
+        }
+    }
+
+    void notify_all_producers_() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_producers_.load(std::memory_order_relaxed) > 0) {
+#ifdef SPDLOG_QUEUE_ATOMIC_WAIT
+            pop_epoch_.fetch_add(1, std::memory_order_seq_cst);
+            pop_epoch_.notify_all();
+#else
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            pop_cv_.notify_all();
+#endif
+        }
+    }
+
+    void park_producer_(T &item) {
+#ifdef SPDLOG_QUEUE_ATOMIC_WAIT
+        waiting_producers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (;;) {
+            auto epoch = pop_epoch_.load(std::memory_order_seq_cst);
+            if (try_push_(item)) {
+                break;
+            }
+            pop_epoch_.wait(epoch, std::memory_order_seq_cst);
+        }
+#else
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        waiting_producers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!try_push_(item)) {
+            pop_cv_.wait(lock);
+        }
+#endif
+        waiting_producers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify_consumers_() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#ifdef SPDLOG_QUEUE_ATOMIC_WAIT
+        if (waiting_consumers_.load(std::memory_order_relaxed) > 0) {
+            push_epoch_.fetch_add(1, std::memory_order_seq_cst);
+            push_epoch_.notify_one();
+        }
+        if (timed_consumers_.load(std::memory_order_relaxed) > 0) {
+#else
+        if (waiting_consumers_.load(std::memory_order_relaxed) > 0 ||
+            timed_consumers_.load(std::memory_order_relaxed) > 0) {
+#endif
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            push_cv_.notify_one();
+        }
+    }
+};
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,74 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/details/msg_pool.h>
+#endif
+
+#include <new>
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE msg_pool &msg_pool::instance() {
+    // never destroyed: async workers may still free messages during static destruction
+    static msg_pool *s_instance = new msg_pool();
+    return *s_instance;
+}
+
+SPDLOG_INLINE void *msg_pool::allocate(size_t size) {
+    size_t index = class_index_(size);
+    if (index == classes_n) {
+        return ::operator new(size);
+    }
+    {
+        auto &c = classes_[index];
+        std::lock_guard<std::mutex> lock(c.mutex);
+        if (!c.blocks.empty()) {
+            void *p = c.blocks.back();
+            c.blocks.pop_back();
+            return p;
+        }
+    }
+    return ::operator new(min_block_size << index);
+}
+
+SPDLOG_INLINE void msg_pool::deallocate(void *p, size_t size) {
+    if (p == nullptr) {
+        return;
+    }
+    size_t index = class_index_(size);
+    if (index < classes_n) {
+        auto &c = classes_[index];
+        std::lock_guard<std::mutex> lock(c.mutex);
+        if (c.blocks.size() < max_free_blocks) {
+            c.blocks.push_back(p);
+            return;
+        }
+    }
+    ::operator delete(p);
+}
+
+SPDLOG_INLINE size_t msg_pool::free_blocks() {
+    size_t total = 0;
+    for (auto &c : classes_) {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        total += c.blocks.size();
+    }
+    return total;
+}
+
+SPDLOG_INLINE size_t msg_pool::class_index_(size_t size) {
+    size_t index = 0;
+    size_t block_size = min_block_size;
+    while (index < classes_n && block_size < size) {
+        block_size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,79 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Pool of heap blocks for messages too big for the inline buffer of log_msg_buffer.
+// Freed blocks are kept in free lists by size class (powers of two) and reused, so queueing
+// large messages does no heap allocation once the pool is warm.
+// Blocks bigger than the largest class go straight to the heap.
+
+#include <spdlog/common.h>
+
+#include <mutex>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+class SPDLOG_API msg_pool {
+public:
+    static msg_pool &instance();
+
+    msg_pool(const msg_pool &) = delete;
+    msg_pool &operator=(const msg_pool &) = delete;
+
+    void *allocate(size_t size);
+    void deallocate(void *p, size_t size);
+
+    // number of blocks currently kept for reuse
+    size_t free_blocks();
+
+private:
+    static constexpr size_t min_block_size = 512;
+    static constexpr size_t classes_n = 8;  // 512 bytes to 64KB
+    static constexpr size_t max_free_blocks = 64;  // kept per class
+
+    struct size_class {
+        std::mutex mutex;
+        std::vector<void *> blocks;
+    };
+    size_class classes_[classes_n];
+
+    msg_pool() = default;
+    ~msg_pool() = default;
+
+    // index of the smallest class that fits size, or classes_n if none
+    static size_t class_index_(size_t size);
+};
+
+// allocator for buffers backed by the pool
+template <typename T>
+struct msg_pool_allocator {
+    using value_type = T;
+
+    msg_pool_allocator() = default;
+    template <typename U>
+    msg_pool_allocator(const msg_pool_allocator<U> &) SPDLOG_NOEXCEPT {}
+
+    T *allocate(size_t n) { return static_cast<T *>(msg_pool::instance().allocate(n * sizeof(T))); }
+
+    void deallocate(T *p, size_t n) { msg_pool::instance().deallocate(p, n * sizeof(T)); }
+};
+
+template <typename T, typename U>
+bool operator==(const msg_pool_allocator<T> &, const msg_pool_allocator<U> &) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const msg_pool_allocator<T> &, const msg_pool_allocator<U> &) {
+    return false;
+}
+
+}  // namespace details
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "msg_pool-inl.h"
+#endif
@@ -8,10 +8,14 @@
 #endif
 
 #include <spdlog/common.h>
+#include <spdlog/details/tsc_clock.h>
 
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -32,6 +36,8 @@
     #endif
 
     #if defined(SPDLOG_WCHAR_TO_UTF8_SUPPORT) || defined(SPDLOG_WCHAR_FILENAMES)
+        #include <spdlog/details/utf8.h>
+
         #include <cassert>
         #include <limits>
     #endif
@@ -40,11 +46,16 @@
 
 #else  // unix
 
+    #include <dirent.h>  // for opendir, readdir
     #include <fcntl.h>
+    #include <pthread.h>  // for pthread_setschedparam, pthread_setname_np
     #include <unistd.h>
 
     #ifdef __linux__
-        #include <sys/syscall.h>  //Use gettid() syscall under linux to get thread id
+        #include <sched.h>         // for sched_getcpu, sched_setaffinity
+        #include <sys/mman.h>      // for mmap, madvise
+        #include <sys/resource.h>  // for setpriority
+        #include <sys/syscall.h>   //Use gettid() syscall under linux to get thread id
 
     #elif defined(_AIX)
         #include <pthread.h>  // for pthread_getthrds_np
@@ -85,6 +96,28 @@ SPDLOG_INLINE spdlog::log_clock::time_point now() SPDLOG_NOEXCEPT {
     return log_clock::now();
 #endif
 }
+
+SPDLOG_INLINE spdlog::log_clock::time_point now(clock_source source) SPDLOG_NOEXCEPT {
+    switch (source) {
+        case clock_source::coarse: {
+#ifdef __linux__
+            timespec ts;
+            ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+            return std::chrono::time_point<log_clock, typename log_clock::duration>(
+                std::chrono::duration_cast<typename log_clock::duration>(
+                    std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+#else
+            return log_clock::now();
+#endif
+        }
+        case clock_source::tsc:
+        case clock_source::tsc_deferred:
+            return tsc_clock::now();
+        default:
+            return now();
+    }
+}
+
 SPDLOG_INLINE std::tm localtime(const std::time_t &time_tt) SPDLOG_NOEXCEPT {
 #ifdef _WIN32
     std::tm tm;
@@ -117,6 +150,104 @@ SPDLOG_INLINE std::tm gmtime() SPDLOG_NOEXCEPT {
     return gmtime(now_t);
 }
 
+// Howard Hinnant's days_from_civil/civil_from_days: days since 1970-01-01 of a civil date
+// (month in [1, 12]), and the civil date (with tm_wday and tm_yday) of seconds since 1970-01-01.
+static std::int64_t days_from_civil_(std::int64_t year, std::int64_t month, std::int64_t day) {
+    year -= month <= 2 ? 1 : 0;
+    auto era = (year >= 0 ? year : year - 399) / 400;
+    auto yoe = year - era * 400;                                            // [0, 399]
+    auto doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365]
+    auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                       // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+static std::tm civil_from_secs_(std::int64_t secs) SPDLOG_NOEXCEPT {
+    auto days = (secs >= 0 ? secs : secs - 86399) / 86400;
+    auto secs_of_day = secs - days * 86400;
+
+    auto z = days + 719468;
+    auto era = (z >= 0 ? z : z - 146096) / 146097;
+    auto doe = z - era * 146097;                                       // [0, 146096]
+    auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
+    auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365], from March 1st
+    auto mp = (5 * doy + 2) / 153;                                     // [0, 11], from March
+    auto month = mp < 10 ? mp + 3 : mp - 9;                            // [1, 12]
+    auto year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    std::tm tm;
+    std::memset(&tm, 0, sizeof(tm));
+    tm.tm_sec = static_cast<int>(secs_of_day % 60);
+    tm.tm_min = static_cast<int>(secs_of_day / 60 % 60);
+    tm.tm_hour = static_cast<int>(secs_of_day / 3600);
+    tm.tm_mday = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    tm.tm_mon = static_cast<int>(month - 1);
+    tm.tm_year = static_cast<int>(year - 1900);
+    tm.tm_wday = static_cast<int>(((days + 4) % 7 + 7) % 7);  // 1970-01-01 was a Thursday
+    tm.tm_yday = static_cast<int>(days - days_from_civil_(year, 1, 1));
+    return tm;
+}
+
+SPDLOG_INLINE std::tm fast_gmtime(std::time_t time_tt) SPDLOG_NOEXCEPT {
+    return civil_from_secs_(static_cast<std::int64_t>(time_tt));
+}
+
+#if !defined(_WIN32) && !(defined(sun) || defined(__sun) || defined(_AIX) ||   \
+                          (defined(__NEWLIB__) && !defined(__TM_GMTOFF)) ||      \
+                          (!defined(_BSD_SOURCE) && !defined(_GNU_SOURCE)))
+    #define SPDLOG_TM_HAS_GMTOFF_
+#endif
+
+SPDLOG_INLINE std::tm fast_localtime(std::time_t time_tt) SPDLOG_NOEXCEPT {
+    // the utc offset of the current quarter of an hour, packed as
+    // quarter (32 bits) | offset in seconds + 2^29 (30 bits) | is dst | valid
+    static std::atomic<std::uint64_t> cached_offset{0};
+#ifdef SPDLOG_TM_HAS_GMTOFF_
+    static std::atomic<decltype(std::tm::tm_zone)> cached_zone{nullptr};
+#endif
+    const std::int64_t quarter_secs = 15 * 60;
+    const std::int64_t offset_bias = std::int64_t(1) << 29;
+
+    auto secs = static_cast<std::int64_t>(time_tt);
+    auto quarter =
+        static_cast<std::uint32_t>((secs >= 0 ? secs : secs - quarter_secs + 1) / quarter_secs);
+    auto packed = cached_offset.load(std::memory_order_acquire);
+    if ((packed & 1) == 0 || static_cast<std::uint32_t>(packed >> 32) != quarter) {
+        auto local_tm = localtime(time_tt);
+        auto local_secs =
+            days_from_civil_(local_tm.tm_year + 1900, local_tm.tm_mon + 1, local_tm.tm_mday) *
+                86400 +
+            local_tm.tm_hour * 3600 + local_tm.tm_min * 60 + local_tm.tm_sec;
+        auto offset = local_secs - secs;
+#ifdef SPDLOG_TM_HAS_GMTOFF_
+        cached_zone.store(local_tm.tm_zone, std::memory_order_relaxed);
+#endif
+        packed = (static_cast<std::uint64_t>(quarter) << 32) |
+                 (static_cast<std::uint64_t>(offset + offset_bias) << 2) |
+                 (local_tm.tm_isdst > 0 ? 2u : 0u) | 1u;
+        cached_offset.store(packed, std::memory_order_release);
+    }
+
+    auto offset = static_cast<std::int64_t>((packed >> 2) & 0x3fffffff) - offset_bias;
+    auto tm = civil_from_secs_(secs + offset);
+    tm.tm_isdst = (packed & 2) != 0 ? 1 : 0;
+#ifdef SPDLOG_TM_HAS_GMTOFF_
+    tm.tm_gmtoff = static_cast<long>(offset);
+    tm.tm_zone = cached_zone.load(std::memory_order_relaxed);
+#endif
+    return tm;
+}
+
+#undef SPDLOG_TM_HAS_GMTOFF_
+
+SPDLOG_INLINE std::int64_t utc_offset_seconds(std::time_t time_tt) SPDLOG_NOEXCEPT {
+    auto local_tm = localtime(time_tt);
+    auto local_secs =
+        days_from_civil_(local_tm.tm_year + 1900, local_tm.tm_mon + 1, local_tm.tm_mday) * 86400 +
+        local_tm.tm_hour * 3600 + local_tm.tm_min * 60 + local_tm.tm_sec;
+    return local_secs - static_cast<std::int64_t>(time_tt);
+}
+
+
 // fopen_s on non windows for writing
 SPDLOG_INLINE bool fopen_s(FILE **fp, const filename_t &filename, const filename_t &mode) {
 #ifdef _WIN32
@@ -189,6 +320,21 @@ SPDLOG_INLINE bool path_exists(const filename_t &filename) SPDLOG_NOEXCEPT {
 #endif
 }
 
+SPDLOG_INLINE size_t path_size(const filename_t &filename) SPDLOG_NOEXCEPT {
+#ifdef _WIN32
+    struct _stat64 buffer;
+    #ifdef SPDLOG_WCHAR_FILENAMES
+    auto ret = ::_wstat64(filename.c_str(), &buffer);
+    #else
+    auto ret = ::_stat64(filename.c_str(), &buffer);
+    #endif
+#else
+    struct stat buffer;
+    auto ret = ::stat(filename.c_str(), &buffer);
+#endif
+    return ret == 0 ? static_cast<size_t>(buffer.st_size) : 0;
+}
+
 #ifdef _MSC_VER
     // avoid warning about unreachable statement at the end of filesize()
     #pragma warning(push)
@@ -367,6 +513,51 @@ SPDLOG_INLINE size_t thread_id() SPDLOG_NOEXCEPT {
 #endif
 }
 
+SPDLOG_INLINE std::string _thread_name() {
+#if defined(__linux__) || defined(__APPLE__)
+    char buf[64] = {};
+    if (::pthread_getname_np(::pthread_self(), buf, sizeof(buf)) == 0) {
+        return buf;
+    }
+#endif
+    return std::string();
+}
+
+// bumped by invalidate_thread_names(): each thread fetches its name again when it changed.
+// not static, so that all the translation units share it in header only mode.
+SPDLOG_INLINE std::atomic<unsigned> &thread_names_generation_() {
+    static std::atomic<unsigned> generation{1};
+    return generation;
+}
+
+SPDLOG_INLINE string_view_t thread_name() SPDLOG_NOEXCEPT {
+#if defined(SPDLOG_NO_TLS)
+    return string_view_t();
+#else
+    struct cached_name {
+        unsigned generation = 0;
+        char name[64];
+        size_t size = 0;
+    };
+    static thread_local cached_name cached;
+    auto generation = thread_names_generation_().load(std::memory_order_relaxed);
+    if (cached.generation != generation) {
+        SPDLOG_TRY {
+            auto name = _thread_name();
+            cached.size = (std::min)(name.size(), sizeof(cached.name));
+            std::memcpy(cached.name, name.data(), cached.size);
+        }
+        SPDLOG_CATCH_STD
+        cached.generation = generation;
+    }
+    return string_view_t(cached.name, cached.size);
+#endif
+}
+
+SPDLOG_INLINE void invalidate_thread_names() SPDLOG_NOEXCEPT {
+    thread_names_generation_().fetch_add(1, std::memory_order_relaxed);
+}
+
 // This is avoid msvc issue in sleep_for that happens if the clock changes.
 // See https://github.com/gabime/spdlog/issues/609
 SPDLOG_INLINE void sleep_for_millis(unsigned int milliseconds) SPDLOG_NOEXCEPT {
@@ -442,32 +633,9 @@ SPDLOG_INLINE void wstr_to_utf8buf(wstring_view_t wstr, memory_buf_t &target) {
     if (wstr.size() > static_cast<size_t>((std::numeric_limits<int>::max)()) / 4 - 1) {
         throw_spdlog_ex("UTF-16 string is too big to be converted to UTF-8");
     }
-
-    int wstr_size = static_cast<int>(wstr.size());
-    if (wstr_size == 0) {
-        target.resize(0);
-        return;
-    }
-
-    int result_size = static_cast<int>(target.capacity());
-    if ((wstr_size + 1) * 4 > result_size) {
-        result_size =
-            ::WideCharToMultiByte(CP_UTF8, 0, wstr.data(), wstr_size, NULL, 0, NULL, NULL);
-    }
-
-    if (result_size > 0) {
-        target.resize(result_size);
-        result_size = ::WideCharToMultiByte(CP_UTF8, 0, wstr.data(), wstr_size, target.data(),
-                                            result_size, NULL, NULL);
-
-        if (result_size > 0) {
-            target.resize(result_size);
-            return;
-        }
-    }
-
-    throw_spdlog_ex(
-        fmt_lib::format("WideCharToMultiByte failed. Last error: {}", ::GetLastError()));
+    // in one pass, without asking WideCharToMultiByte for the size first
+    target.clear();
+    append_utf16_as_utf8(wstr.data(), wstr.size(), target);
 }
 
 SPDLOG_INLINE void utf8_to_wstrbuf(string_view_t str, wmemory_buf_t &target) {
@@ -563,6 +731,48 @@ SPDLOG_INLINE filename_t dir_name(const filename_t &path) {
     return pos != filename_t::npos ? path.substr(0, pos) : filename_t{};
 }
 
+SPDLOG_INLINE std::vector<filename_t> list_dir(const filename_t &path) {
+    std::vector<filename_t> names;
+#ifdef _WIN32
+    filename_t pattern = path.empty() ? filename_t(SPDLOG_FILENAME_T("*"))
+                                      : path + SPDLOG_FILENAME_T("\\*");
+    #ifdef SPDLOG_WCHAR_FILENAMES
+    WIN32_FIND_DATAW data;
+    HANDLE handle = ::FindFirstFileW(pattern.c_str(), &data);
+    #else
+    WIN32_FIND_DATAA data;
+    HANDLE handle = ::FindFirstFileA(pattern.c_str(), &data);
+    #endif
+    if (handle == INVALID_HANDLE_VALUE) {
+        return names;
+    }
+    do {
+        filename_t name = data.cFileName;
+        if (name != SPDLOG_FILENAME_T(".") && name != SPDLOG_FILENAME_T("..")) {
+            names.push_back(std::move(name));
+        }
+    #ifdef SPDLOG_WCHAR_FILENAMES
+    } while (::FindNextFileW(handle, &data));
+    #else
+    } while (::FindNextFileA(handle, &data));
+    #endif
+    ::FindClose(handle);
+#else
+    DIR *dir = ::opendir(path.empty() ? "." : path.c_str());
+    if (dir == nullptr) {
+        return names;
+    }
+    while (auto *entry = ::readdir(dir)) {
+        filename_t name = entry->d_name;
+        if (name != "." && name != "..") {
+            names.push_back(std::move(name));
+        }
+    }
+    ::closedir(dir);
+#endif
+    return names;
+}
+
 std::string SPDLOG_INLINE getenv(const char *field) {
 #if defined(_MSC_VER)
     #if defined(__cplusplus_winrt)
@@ -589,6 +799,293 @@ SPDLOG_INLINE bool fsync(FILE *fp) {
 #endif
 }
 
+SPDLOG_INLINE bool fdatasync(FILE *fp) {
+#if defined(_WIN32) || defined(__APPLE__)
+    return fsync(fp);
+#else
+    return ::fdatasync(fileno(fp)) == 0;
+#endif
+}
+
+SPDLOG_INLINE bool start_writeback(FILE *fp) {
+#ifdef __linux__
+    // offset 0 and size 0 for the whole file: only the dirty pages are written
+    return ::sync_file_range(fileno(fp), 0, 0, SYNC_FILE_RANGE_WRITE) == 0;
+#else
+    return fdatasync(fp);
+#endif
+}
+
+SPDLOG_INLINE bool write_fd(FILE *fp, const char *data, size_t size) {
+#ifdef _WIN32
+    int fd = ::_fileno(fp);
+    while (size > 0) {
+        const unsigned chunk = size > (1u << 30) ? (1u << 30) : static_cast<unsigned>(size);
+        int written = ::_write(fd, data, chunk);
+        if (written < 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+#else
+    int fd = fileno(fp);
+    while (size > 0) {
+        auto written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+#endif
+    return true;
+}
+
+SPDLOG_INLINE bool preallocate(FILE *fp, size_t size) {
+#ifdef __linux__
+    return ::fallocate(fileno(fp), FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)) == 0;
+#else
+    (void)fp;
+    (void)size;
+    return false;
+#endif
+}
+
+SPDLOG_INLINE bool trim_preallocation(FILE *fp) {
+#ifdef __linux__
+    struct stat st;
+    int fd = fileno(fp);
+    return ::fstat(fd, &st) == 0 && ::ftruncate(fd, st.st_size) == 0;
+#else
+    (void)fp;
+    return false;
+#endif
+}
+
+SPDLOG_INLINE std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    const char *p = list.c_str();
+    while (*p != '\0') {
+        char *end = nullptr;
+        long first = std::strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            break;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = std::strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                break;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if (*p != ',') {
+            break;
+        }
+        p++;
+    }
+    return cpus;
+}
+
+#ifdef __linux__
+// first line of the given file, or empty string if it can't be read
+static SPDLOG_INLINE std::string read_first_line_(const char *path) {
+    std::string line;
+    FILE *fp = std::fopen(path, "r");
+    if (fp == nullptr) {
+        return line;
+    }
+    char buf[1024];
+    if (std::fgets(buf, sizeof(buf), fp) != nullptr) {
+        line = buf;
+    }
+    std::fclose(fp);
+    while (!line.empty() && (line.back() == '\n' || line.back() == ' ')) {
+        line.pop_back();
+    }
+    return line;
+}
+#endif
+
+SPDLOG_INLINE std::vector<std::vector<int>> numa_node_cpus() {
+    std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+    auto online = parse_cpu_list(read_first_line_("/sys/devices/system/node/online"));
+    for (auto node : online) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        auto cpus = parse_cpu_list(read_first_line_(path));
+        if (!cpus.empty()) {  // skip memory only nodes
+            nodes.push_back(std::move(cpus));
+        }
+    }
+#endif
+    return nodes;
+}
+
+SPDLOG_INLINE int current_cpu() SPDLOG_NOEXCEPT {
+#ifdef __linux__
+    return ::sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+SPDLOG_INLINE std::vector<int> thread_affinity() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+SPDLOG_INLINE bool set_thread_affinity(const std::vector<int> &cpus) SPDLOG_NOEXCEPT {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0 && ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+SPDLOG_INLINE bool set_thread_sched_policy(sched_policy policy, int priority) SPDLOG_NOEXCEPT {
+    if (policy == sched_policy::inherit) {
+        return true;
+    }
+#ifdef _WIN32
+    (void)priority;
+    return false;
+#else
+    int native_policy = SCHED_OTHER;
+    switch (policy) {
+        case sched_policy::fifo:
+            native_policy = SCHED_FIFO;
+            break;
+        case sched_policy::round_robin:
+            native_policy = SCHED_RR;
+            break;
+    #ifdef __linux__
+        case sched_policy::batch:
+            native_policy = SCHED_BATCH;
+            break;
+        case sched_policy::idle:
+            native_policy = SCHED_IDLE;
+            break;
+    #else
+        case sched_policy::batch:
+        case sched_policy::idle:
+            return false;
+    #endif
+        default:
+            break;
+    }
+    sched_param param{};
+    param.sched_priority = native_policy == SCHED_FIFO || native_policy == SCHED_RR ? priority : 0;
+    return ::pthread_setschedparam(::pthread_self(), native_policy, &param) == 0;
+#endif
+}
+
+SPDLOG_INLINE bool set_thread_nice(int nice) SPDLOG_NOEXCEPT {
+#ifdef __linux__
+    // the nice value is per thread on linux
+    auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+    return ::setpriority(PRIO_PROCESS, tid, nice) == 0;
+#else
+    (void)nice;
+    return false;
+#endif
+}
+
+SPDLOG_INLINE bool set_thread_name(const std::string &name) SPDLOG_NOEXCEPT {
+#if defined(__linux__) || defined(__APPLE__)
+    #if defined(__linux__)
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%s", name.c_str());
+    bool ok = ::pthread_setname_np(::pthread_self(), buf) == 0;
+    #else
+    bool ok = ::pthread_setname_np(name.c_str()) == 0;
+    #endif
+    if (ok) {
+        invalidate_thread_names();
+    }
+    return ok;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+#ifdef __linux__
+static const size_t huge_page_size = 2 * 1024 * 1024;
+
+static SPDLOG_INLINE size_t huge_pages_round_(size_t bytes) {
+    return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+#endif
+
+SPDLOG_INLINE void *huge_pages_alloc(size_t bytes) SPDLOG_NOEXCEPT {
+#ifdef __linux__
+    auto size = huge_pages_round_(bytes > 0 ? bytes : 1);
+    void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+    if (p != MAP_FAILED) {
+        return p;
+    }
+    // no huge pages reserved: ask for transparent ones, then touch every page so they are
+    // faulted in now rather than on first use
+    p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    #ifdef MADV_HUGEPAGE
+    ::madvise(p, size, MADV_HUGEPAGE);
+    #endif
+    auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    auto *bytes_p = static_cast<volatile char *>(p);
+    for (size_t offset = 0; offset < size; offset += page_size) {
+        bytes_p[offset] = 0;
+    }
+    return p;
+#else
+    (void)bytes;
+    return nullptr;
+#endif
+}
+
+SPDLOG_INLINE void huge_pages_free(void *p, size_t bytes) SPDLOG_NOEXCEPT {
+#ifdef __linux__
+    if (p != nullptr) {
+        ::munmap(p, huge_pages_round_(bytes > 0 ? bytes : 1));
+    }
+#else
+    (void)p;
+    (void)bytes;
+#endif
+}
+
 }  // namespace os
 }  // namespace details
 }  // namespace spdlog
@@ -3,8 +3,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <ctime>  // std::time_t
 #include <spdlog/common.h>
+#include <vector>
 
 namespace spdlog {
 namespace details {
@@ -12,6 +14,8 @@ namespace os {
 
 SPDLOG_API spdlog::log_clock::time_point now() SPDLOG_NOEXCEPT;
 
+SPDLOG_API spdlog::log_clock::time_point now(clock_source source) SPDLOG_NOEXCEPT;
+
 SPDLOG_API std::tm localtime(const std::time_t &time_tt) SPDLOG_NOEXCEPT;
 
 SPDLOG_API std::tm localtime() SPDLOG_NOEXCEPT;
@@ -20,6 +24,17 @@ SPDLOG_API std::tm gmtime(const std::time_t &time_tt) SPDLOG_NOEXCEPT;
 
 SPDLOG_API std::tm gmtime() SPDLOG_NOEXCEPT;
 
+// Same as gmtime(), computed arithmetically from the epoch seconds.
+SPDLOG_API std::tm fast_gmtime(std::time_t time_tt) SPDLOG_NOEXCEPT;
+
+// Same as localtime(), computed arithmetically from the epoch seconds and the UTC offset.
+// The offset is shared by the whole process without locking, and is looked up again with
+// localtime() once per quarter of an hour (at most), which is when DST changes can happen.
+SPDLOG_API std::tm fast_localtime(std::time_t time_tt) SPDLOG_NOEXCEPT;
+
+// UTC offset of the local time zone at the given time, in seconds (without mktime()).
+SPDLOG_API std::int64_t utc_offset_seconds(std::time_t time_tt) SPDLOG_NOEXCEPT;
+
 // eol definition
 #if !defined(SPDLOG_EOL)
     #ifdef _WIN32
@@ -31,15 +46,6 @@ SPDLOG_API std::tm gmtime() SPDLOG_NOEXCEPT;
 
 SPDLOG_CONSTEXPR static const char *default_eol = SPDLOG_EOL;
 
-// folder separator
-#if !defined(SPDLOG_FOLDER_SEPS)
-    #ifdef _WIN32
-        #define SPDLOG_FOLDER_SEPS "\\/"
-    #else
-        #define SPDLOG_FOLDER_SEPS "/"
-    #endif
-#endif
-
 SPDLOG_CONSTEXPR static const char folder_seps[] = SPDLOG_FOLDER_SEPS;
 SPDLOG_CONSTEXPR static const filename_t::value_type folder_seps_filename[] =
     SPDLOG_FILENAME_T(SPDLOG_FOLDER_SEPS);
@@ -62,6 +68,9 @@ SPDLOG_API bool path_exists(const filename_t &filename) SPDLOG_NOEXCEPT;
 // Return file size according to open FILE* object
 SPDLOG_API size_t filesize(FILE *f);
 
+// Return the size of the file, 0 if it doesn't exist.
+SPDLOG_API size_t path_size(const filename_t &filename) SPDLOG_NOEXCEPT;
+
 // Return utc offset in minutes or throw spdlog_ex on failure
 SPDLOG_API int utc_minutes_offset(const std::tm &tm = details::os::localtime());
 
@@ -73,6 +82,16 @@ SPDLOG_API size_t _thread_id() SPDLOG_NOEXCEPT;
 // Return current thread id as size_t (from thread local storage)
 SPDLOG_API size_t thread_id() SPDLOG_NOEXCEPT;
 
+// Return the name of the current thread (linux and apple only, empty string otherwise)
+SPDLOG_API std::string _thread_name();
+
+// Return the name of the current thread, cached in thread local storage until the next
+// invalidate_thread_names(). Empty if SPDLOG_NO_TLS is defined.
+SPDLOG_API string_view_t thread_name() SPDLOG_NOEXCEPT;
+
+// Make all the threads fetch their name again on the next thread_name() call.
+SPDLOG_API void invalidate_thread_names() SPDLOG_NOEXCEPT;
+
 // This is avoid msvc issue in sleep_for that happens if the clock changes.
 // See https://github.com/gabime/spdlog/issues/609
 SPDLOG_API void sleep_for_millis(unsigned int milliseconds) SPDLOG_NOEXCEPT;
@@ -106,6 +125,10 @@ SPDLOG_API filename_t dir_name(const filename_t &path);
 // Return true if succeeded or if this dir already exists.
 SPDLOG_API bool create_dir(const filename_t &path);
 
+// Names of the entries of the given dir (the current dir if empty), without "." and "..".
+// Return empty vector if it can't be read.
+SPDLOG_API std::vector<filename_t> list_dir(const filename_t &path);
+
 // non thread safe, cross platform getenv/getenv_s
 // return empty string if field not found
 SPDLOG_API std::string getenv(const char *field);
@@ -114,6 +137,73 @@ SPDLOG_API std::string getenv(const char *field);
 // Return true on success.
 SPDLOG_API bool fsync(FILE *fp);
 
+// Do fdatasync by FILE objectpointer (fsync where not available).
+// Return true on success.
+SPDLOG_API bool fdatasync(FILE *fp);
+
+// Start writing back the dirty pages of the file without waiting for them (sync_file_range on
+// linux, fdatasync elsewhere).
+// Return true on success.
+SPDLOG_API bool start_writeback(FILE *fp);
+
+// Write size bytes straight to the file descriptor of fp (bypassing its stdio buffer, which
+// should be empty), retrying the partial and interrupted writes.
+// Return true on success.
+SPDLOG_API bool write_fd(FILE *fp, const char *data, size_t size);
+
+// Reserve the disk space of the first size bytes of the file, without changing its size
+// (linux only, with fallocate).
+// Return true on success.
+SPDLOG_API bool preallocate(FILE *fp, size_t size);
+
+// Give back the disk space reserved past the end of the file by preallocate() (linux only).
+// Return true on success.
+SPDLOG_API bool trim_preallocation(FILE *fp);
+
+// Parse a linux cpu list (e.g. "0-3,8,10-11") into the cpu numbers it contains.
+SPDLOG_API std::vector<int> parse_cpu_list(const std::string &list);
+
+// Cpus of each numa node, as listed in /sys/devices/system/node (linux only).
+// Return empty vector if not available.
+SPDLOG_API std::vector<std::vector<int>> numa_node_cpus();
+
+// Return the cpu the current thread is running on, or -1 if not available.
+SPDLOG_API int current_cpu() SPDLOG_NOEXCEPT;
+
+// Return the cpus the current thread is allowed to run on (linux only).
+// Return empty vector if not available.
+SPDLOG_API std::vector<int> thread_affinity();
+
+// Restrict the current thread to the given cpus (linux only).
+// Return true on success.
+SPDLOG_API bool set_thread_affinity(const std::vector<int> &cpus) SPDLOG_NOEXCEPT;
+
+// Scheduling policies of set_thread_sched_policy() (batch and idle are linux only).
+enum class sched_policy { inherit, other, batch, idle, fifo, round_robin };
+
+// Set the scheduling policy and priority of the current thread (posix only).
+// The priority is only used by fifo and round_robin.
+// Return true on success.
+SPDLOG_API bool set_thread_sched_policy(sched_policy policy, int priority) SPDLOG_NOEXCEPT;
+
+// Set the nice value of the current thread (linux only).
+// Return true on success.
+SPDLOG_API bool set_thread_nice(int nice) SPDLOG_NOEXCEPT;
+
+// Set the name of the current thread (truncated to 15 chars on linux), and invalidate the cached
+// thread names on success.
+// Return true on success.
+SPDLOG_API bool set_thread_name(const std::string &name) SPDLOG_NOEXCEPT;
+
+// Allocate memory backed by huge pages if possible (linux only): explicit huge pages if the
+// system reserved some, else transparent huge pages. The memory is zeroed and pre-faulted, and
+// the size is rounded up to a multiple of 2MB.
+// Return nullptr on failure.
+SPDLOG_API void *huge_pages_alloc(size_t bytes) SPDLOG_NOEXCEPT;
+
+// Free memory returned by huge_pages_alloc(bytes).
+SPDLOG_API void huge_pages_free(void *p, size_t bytes) SPDLOG_NOEXCEPT;
+
 }  // namespace os
 }  // namespace details
 }  // namespace spdlog
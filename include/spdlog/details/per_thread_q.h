@@ -0,0 +1,430 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#if defined(SPDLOG_NO_TLS)
+    #error "This header requires thread local storage support, but SPDLOG_NO_TLS is defined."
+#endif
+
+// multi producer queue made of one bounded ring per producer thread, merged by the consumer.
+// Each producer lazily gets its own ring (kept in thread local storage) on its first push, so
+// producers never write to a cache line shared with another producer.
+// The consumer pops the oldest message (by its "time" member) among the rings' fronts, or
+// takes the rings in turn if round robin order was requested.
+// max_items is the capacity of each ring.
+//
+// Consumers are serialized by a mutex. Rings of exited threads are dropped once drained.
+
+#include <spdlog/details/mpmc_lockfree_q.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+template <typename T>
+class per_thread_queue {
+public:
+    using item_type = T;
+    explicit per_thread_queue(size_t max_items, bool round_robin = false)
+        : max_items_(max_items),
+          round_robin_(round_robin),
+          id_(next_queue_id_()) {}
+
+    per_thread_queue(const per_thread_queue &) = delete;
+    per_thread_queue &operator=(const per_thread_queue &) = delete;
+
+    // try to enqueue and block if no room left in this thread's ring
+    void enqueue(T &&item) {
+        auto &r = local_ring_();
+        if (!r.q.try_push(std::move(item))) {
+            park_producer_(r, item);
+        }
+        notify_consumers_();
+    }
+
+    // enqueue immediately. overrun oldest message of this thread's ring if no room left.
+    void enqueue_nowait(T &&item) {
+        if (max_items_ == 0) {
+            overrun_counter_.add();
+            return;
+        }
+        auto &r = local_ring_();
+        while (!r.q.try_push(std::move(item))) {
+            T oldest;
+            if (r.q.try_pop(oldest)) {
+                overrun_counter_.add();
+            }
+        }
+        notify_consumers_();
+    }
+
+    void enqueue_if_have_room(T &&item) {
+        if (!try_enqueue(std::move(item))) {
+            discard_counter_.add();
+        }
+    }
+
+    // enqueue if there is room in this thread's ring. return false (leaving the item
+    // untouched) otherwise.
+    bool try_enqueue(T &&item) {
+        if (!local_ring_().q.try_push(std::move(item))) {
+            return false;
+        }
+        notify_consumers_();
+        return true;
+    }
+
+    // dequeue with a timeout.
+    // Return true, if succeeded dequeue item, false otherwise
+    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) {
+        auto deadline = std::chrono::steady_clock::now() + wait_duration;
+        for (;;) {
+            if (pop_next_(popped_item)) {
+                notify_producers_();
+                return true;
+            }
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto status = std::cv_status::no_timeout;
+            if (!has_items_()) {
+                status = push_cv_.wait_until(lock, deadline);
+            }
+            waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+            if (status == std::cv_status::timeout) {
+                lock.unlock();
+                if (pop_next_(popped_item)) {
+                    notify_producers_();
+                    return true;
+                }
+                return false;
+            }
+        }
+    }
+
+    // blocking dequeue without a timeout.
+    void dequeue(T &popped_item) {
+        while (!pop_next_(popped_item)) {
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!has_items_()) {
+                push_cv_.wait(lock);
+            }
+            waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        notify_producers_();
+    }
+
+    // blocking dequeue of up to max_items at once.
+    // Return the number of items popped (at least one).
+    size_t dequeue_bulk(T *popped_items, size_t max_items) {
+        size_t n = 0;
+        while ((n = pop_bulk_(popped_items, max_items)) == 0) {
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!has_items_()) {
+                push_cv_.wait(lock);
+            }
+            waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        notify_producers_();
+        return n;
+    }
+
+    // non blocking dequeue of up to max_items at once.
+    // Return the number of items popped (zero if all rings are empty).
+    size_t try_dequeue_bulk(T *popped_items, size_t max_items) {
+        size_t n = pop_bulk_(popped_items, max_items);
+        if (n > 0) {
+            notify_producers_();
+        }
+        return n;
+    }
+
+    size_t overrun_counter() { return overrun_counter_.load(); }
+
+    size_t discard_counter() { return discard_counter_.load(); }
+
+    // approximate number of items in all rings (exact if no concurrent push/pop)
+    size_t size() {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        size_t total = pending_count_.load(std::memory_order_relaxed);
+        for (auto &r : rings_) {
+            total += r->q.size();
+        }
+        return total;
+    }
+
+    // approximate highest size(), sampled by the consumer before popping
+    size_t high_water_mark() { return high_water_mark_.load(std::memory_order_relaxed); }
+
+    void reset_overrun_counter() { overrun_counter_.reset(); }
+
+    void reset_discard_counter() { discard_counter_.reset(); }
+
+    void reset_high_water_mark() { high_water_mark_.store(size(), std::memory_order_relaxed); }
+
+    // call fn on each queued item, ring by ring, without taking the mutexes (for a crash
+    // handler: the items and the rings may be changed meanwhile)
+    template <typename F>
+    void visit_unsafe(F &&fn) const {
+        for (auto &r : rings_) {
+            if (r->has_pending) {
+                fn(r->pending);
+            }
+            r->q.visit_unsafe(fn);
+        }
+    }
+
+    // number of producer rings currently registered
+    size_t rings_count() {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        return rings_.size();
+    }
+
+private:
+    struct ring {
+        explicit ring(size_t max_items)
+            : q(max_items) {}
+        mpmc_lockfree_queue<T> q;
+        std::atomic<bool> orphaned{false};
+
+        // owned by the consumer: front item already popped from q, waiting for its turn
+        T pending;
+        bool has_pending = false;
+    };
+
+    // rings of the calling thread, one per live queue it pushed to
+    struct thread_rings {
+        struct entry {
+            size_t queue_id;
+            ring *ring_ptr;
+            std::weak_ptr<ring> weak_ring;
+        };
+        std::vector<entry> entries;
+
+        ~thread_rings() {
+            for (auto &e : entries) {
+                if (auto r = e.weak_ring.lock()) {
+                    r->orphaned.store(true, std::memory_order_release);
+                }
+            }
+        }
+    };
+
+    size_t max_items_;
+    bool round_robin_;
+    size_t id_;
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<ring>> rings_;
+    std::atomic<size_t> rings_version_{0};
+
+    // consumer side
+    std::mutex consumer_mutex_;
+    std::vector<std::shared_ptr<ring>> consumer_rings_;
+    size_t consumer_version_ = 0;
+    size_t next_ring_ = 0;
+    std::atomic<size_t> pending_count_{0};
+
+    striped_counter overrun_counter_;
+    striped_counter discard_counter_;
+    std::atomic<size_t> high_water_mark_{0};
+
+    std::mutex park_mutex_;
+    std::condition_variable push_cv_;
+    std::condition_variable pop_cv_;
+    std::atomic<int> waiting_consumers_{0};
+    std::atomic<int> waiting_producers_{0};
+
+    static size_t next_queue_id_() {
+        static std::atomic<size_t> last_id{0};
+        return last_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    static thread_rings &thread_rings_() {
+        static thread_local thread_rings rings;
+        return rings;
+    }
+
+    // ring of the calling thread, created and registered on first use.
+    // the raw pointer is safe to use while this queue is alive (a ring is only dropped by the
+    // consumer after its thread exited) and queue ids are never reused.
+    ring &local_ring_() {
+        auto &entries = thread_rings_().entries;
+        for (auto &e : entries) {
+            if (e.queue_id == id_) {
+                return *e.ring_ptr;
+            }
+        }
+        return register_ring_();
+    }
+
+    ring &register_ring_() {
+        auto &entries = thread_rings_().entries;
+        // forget rings of queues that no longer exist
+        for (auto it = entries.begin(); it != entries.end();) {
+            it = it->weak_ring.expired() ? entries.erase(it) : it + 1;
+        }
+        auto new_ring = std::make_shared<ring>(max_items_);
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(new_ring);
+            rings_version_.fetch_add(1, std::memory_order_release);
+        }
+        entries.push_back({id_, new_ring.get(), new_ring});
+        return *new_ring;
+    }
+
+    void refresh_consumer_rings_() {
+        auto version = rings_version_.load(std::memory_order_acquire);
+        if (version != consumer_version_) {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            consumer_rings_ = rings_;
+            consumer_version_ = rings_version_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // drop the ring if its thread exited and nothing is left in it
+    void drop_if_orphaned_(const std::shared_ptr<ring> &r) {
+        if (r->has_pending || !r->orphaned.load(std::memory_order_acquire) || r->q.size() > 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto it = rings_.begin(); it != rings_.end(); ++it) {
+            if (*it == r) {
+                rings_.erase(it);
+                rings_version_.fetch_add(1, std::memory_order_release);
+                break;
+            }
+        }
+    }
+
+    bool take_pending_(ring &r, T &popped_item) {
+        popped_item = std::move(r.pending);
+        r.has_pending = false;
+        pending_count_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pop_next_(T &popped_item) {
+        std::lock_guard<std::mutex> lock(consumer_mutex_);
+        note_size_locked_();
+        return pop_next_locked_(popped_item);
+    }
+
+    size_t pop_bulk_(T *popped_items, size_t max_items) {
+        std::lock_guard<std::mutex> lock(consumer_mutex_);
+        note_size_locked_();
+        size_t n = 0;
+        while (n < max_items && pop_next_locked_(popped_items[n])) {
+            n++;
+        }
+        return n;
+    }
+
+    // must be called with consumer_mutex_ held
+    void note_size_locked_() {
+        refresh_consumer_rings_();
+        size_t size = pending_count_.load(std::memory_order_relaxed);
+        for (auto &r : consumer_rings_) {
+            size += r->q.size();
+        }
+        if (size > high_water_mark_.load(std::memory_order_relaxed)) {
+            high_water_mark_.store(size, std::memory_order_relaxed);
+        }
+    }
+
+    // must be called with consumer_mutex_ held
+    bool pop_next_locked_(T &popped_item) {
+        refresh_consumer_rings_();
+        auto n = consumer_rings_.size();
+        if (n == 0) {
+            return false;
+        }
+
+        if (round_robin_) {
+            for (size_t i = 0; i < n; i++) {
+                auto &r = consumer_rings_[(next_ring_ + i) % n];
+                if (r->has_pending) {
+                    next_ring_ = (next_ring_ + i + 1) % n;
+                    return take_pending_(*r, popped_item);
+                }
+                if (r->q.try_pop(popped_item)) {
+                    next_ring_ = (next_ring_ + i + 1) % n;
+                    return true;
+                }
+                drop_if_orphaned_(r);
+            }
+            return false;
+        }
+
+        // oldest message among the rings' fronts
+        ring *oldest = nullptr;
+        for (auto &r : consumer_rings_) {
+            if (!r->has_pending) {
+                if (!r->q.try_pop(r->pending)) {
+                    drop_if_orphaned_(r);
+                    continue;
+                }
+                r->has_pending = true;
+                pending_count_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (oldest == nullptr || r->pending.time < oldest->pending.time) {
+                oldest = r.get();
+            }
+        }
+        return oldest != nullptr && take_pending_(*oldest, popped_item);
+    }
+
+    bool has_items_() {
+        if (pending_count_.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto &r : rings_) {
+            if (r->q.size() > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void park_producer_(ring &r, T &item) {
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        waiting_producers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!r.q.try_push(std::move(item))) {
+            pop_cv_.wait(lock);
+        }
+        waiting_producers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // a slot was freed in one of the rings - wake the parked producers to let the owner retry
+    void notify_producers_() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_producers_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            pop_cv_.notify_all();
+        }
+    }
+
+    void notify_consumers_() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_consumers_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            push_cv_.notify_one();
+        }
+    }
+};
+}  // namespace details
+}  // namespace spdlog
@@ -10,15 +10,9 @@
 namespace spdlog {
 namespace details {
 
-// stop the worker thread and join it
 SPDLOG_INLINE periodic_worker::~periodic_worker() {
-    if (worker_thread_.joinable()) {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            active_ = false;
-        }
-        cv_.notify_one();
-        worker_thread_.join();
+    if (active_) {
+        scheduler::instance().cancel(task_id_);
     }
 }
 
@@ -3,18 +3,19 @@
 
 #pragma once
 
-// periodic worker thread - periodically executes the given callback function.
+// periodic worker - periodically executes the given callback function, on the thread of the
+// housekeeping scheduler shared by all the workers (see scheduler.h).
 //
-// RAII over the owned thread:
-//    creates the thread on construction.
-//    stops and joins the thread on destruction (if the thread is executing a callback, wait for it
-//    to finish first).
+// RAII over the scheduled task:
+//    schedules it on construction.
+//    cancels it on destruction (if the callback is executing, wait for it to finish first).
+
+#include <spdlog/details/scheduler.h>
 
 #include <chrono>
-#include <condition_variable>
+#include <cstdint>
 #include <functional>
-#include <mutex>
-#include <thread>
+
 namespace spdlog {
 namespace details {
 
@@ -27,28 +28,18 @@ public:
         if (!active_) {
             return;
         }
-
-        worker_thread_ = std::thread([this, callback_fun, interval]() {
-            for (;;) {
-                std::unique_lock<std::mutex> lock(this->mutex_);
-                if (this->cv_.wait_for(lock, interval, [this] { return !this->active_; })) {
-                    return;  // active_ == false, so exit this thread
-                }
-                callback_fun();
-            }
-        });
+        // constructed before the worker, so destroyed after it when both are static
+        task_id_ = scheduler::instance().schedule_every(callback_fun, interval);
     }
-    std::thread &get_thread() { return worker_thread_; }
+
     periodic_worker(const periodic_worker &) = delete;
     periodic_worker &operator=(const periodic_worker &) = delete;
-    // stop the worker thread and join it
+    // cancel the task
     ~periodic_worker();
 
 private:
     bool active_;
-    std::thread worker_thread_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
+    scheduler::task_id task_id_ = 0;
 };
 }  // namespace details
 }  // namespace spdlog
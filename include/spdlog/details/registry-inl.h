@@ -8,7 +8,9 @@
 #endif
 
 #include <spdlog/common.h>
+#include <spdlog/details/callsite.h>
 #include <spdlog/details/periodic_worker.h>
+#include <spdlog/details/scheduler.h>
 #include <spdlog/logger.h>
 #include <spdlog/pattern_formatter.h>
 
@@ -21,10 +23,13 @@
     #endif
 #endif  // SPDLOG_DISABLE_DEFAULT_LOGGER
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 namespace spdlog {
@@ -32,6 +37,10 @@ namespace details {
 
 SPDLOG_INLINE registry::registry()
     : formatter_(new pattern_formatter()) {
+    // constructed first, so that it outlives periodic_flusher_ at exit
+    (void)scheduler::instance();
+    // no rehash while the first dozens of loggers are created at startup
+    loggers_.reserve(64);
 #ifndef SPDLOG_DISABLE_DEFAULT_LOGGER
     // create default logger (ansicolor_stdout_sink_mt or wincolor_stdout_sink_mt in windows).
     #ifdef _WIN32
@@ -43,8 +52,10 @@ SPDLOG_INLINE registry::registry()
     const char *default_logger_name = "";
     default_logger_ = std::make_shared<spdlog::logger>(default_logger_name, std::move(color_sink));
     loggers_[default_logger_name] = default_logger_;
+    default_raw_.store(default_logger_.get());
 
 #endif  // SPDLOG_DISABLE_DEFAULT_LOGGER
+    publish_snapshot_();
 }
 
 SPDLOG_INLINE registry::~registry() = default;
@@ -56,32 +67,67 @@ SPDLOG_INLINE void registry::register_logger(std::shared_ptr<logger> new_logger)
 
 SPDLOG_INLINE void registry::initialize_logger(std::shared_ptr<logger> new_logger) {
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
-    new_logger->set_formatter(formatter_->clone());
-
-    if (err_handler_) {
-        new_logger->set_error_handler(err_handler_);
-    }
-
-    // set new level according to previously configured level or default level
-    auto it = log_levels_.find(new_logger->name());
-    auto new_level = it != log_levels_.end() ? it->second : global_log_level_;
-    new_logger->set_level(new_level);
-
-    new_logger->flush_on(flush_level_);
-
-    if (backtrace_n_messages_ > 0) {
-        new_logger->enable_backtrace(backtrace_n_messages_);
-    }
-
+    apply_settings_(*new_logger);
     if (automatic_registration_) {
         register_logger_(std::move(new_logger));
     }
 }
 
-SPDLOG_INLINE std::shared_ptr<logger> registry::get(const std::string &logger_name) {
+SPDLOG_INLINE void registry::initialize_loggers(
+    const std::vector<std::shared_ptr<logger>> &new_loggers) {
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
-    auto found = loggers_.find(logger_name);
-    return found == loggers_.end() ? nullptr : found->second;
+    if (automatic_registration_) {
+        std::vector<const std::string *> names;
+        names.reserve(new_loggers.size());
+        for (const auto &new_logger : new_loggers) {
+            throw_if_exists_(new_logger->name());
+            names.push_back(&new_logger->name());
+        }
+        std::sort(names.begin(), names.end(),
+                  [](const std::string *a, const std::string *b) { return *a < *b; });
+        auto duplicate = std::adjacent_find(
+            names.begin(), names.end(),
+            [](const std::string *a, const std::string *b) { return *a == *b; });
+        if (duplicate != names.end()) {
+            throw_spdlog_ex("logger with name '" + **duplicate + "' given twice");
+        }
+    }
+    for (const auto &new_logger : new_loggers) {
+        apply_settings_(*new_logger);
+    }
+    if (automatic_registration_ && !new_loggers.empty()) {
+        loggers_.reserve(loggers_.size() + new_loggers.size());
+        for (const auto &new_logger : new_loggers) {
+            insert_logger_(new_logger);
+        }
+        publish_snapshot_();
+    }
+}
+
+SPDLOG_INLINE std::shared_ptr<logger> registry::get(string_view_t logger_name) {
+#ifdef SPDLOG_NO_TLS
+    std::shared_ptr<const logger_snapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(logger_map_mutex_);
+        snapshot = snapshot_;
+    }
+    return find_(*snapshot, logger_name);
+#else
+    // each thread keeps the last snapshot it looked up, until a new one is published: the
+    // lookups only read the version, besides the reference count of the logger found
+    struct cached_snapshot {
+        std::uint64_t version = 0;
+        std::shared_ptr<const logger_snapshot> snapshot;
+    };
+    static thread_local cached_snapshot cached;
+    auto version = snapshot_version_.load(std::memory_order_acquire);
+    if (!cached.snapshot || cached.version != version) {
+        std::lock_guard<std::mutex> lock(logger_map_mutex_);
+        cached.snapshot = snapshot_;
+        cached.version = snapshot_version_.load(std::memory_order_relaxed);
+    }
+    return find_(*cached.snapshot, logger_name);
+#endif
 }
 
 SPDLOG_INLINE std::shared_ptr<logger> registry::default_logger() {
@@ -90,10 +136,10 @@ SPDLOG_INLINE std::shared_ptr<logger> registry::default_logger() {
 }
 
 // Return raw ptr to the default logger.
-// To be used directly by the spdlog default api (e.g. spdlog::info)
-// This make the default API faster, but cannot be used concurrently with set_default_logger().
-// e.g do not call set_default_logger() from one thread while calling spdlog::info() from another.
-SPDLOG_INLINE logger *registry::get_default_raw() { return default_logger_.get(); }
+// It cannot be used concurrently with set_default_logger().
+SPDLOG_INLINE logger *registry::get_default_raw() {
+    return default_raw_.load(std::memory_order_acquire);
+}
 
 // set default logger.
 // default logger is stored in default_logger_ (for faster retrieval) and in the loggers_ map.
@@ -101,8 +147,9 @@ SPDLOG_INLINE void registry::set_default_logger(std::shared_ptr<logger> new_defa
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
     if (new_default_logger != nullptr) {
         loggers_[new_default_logger->name()] = new_default_logger;
+        publish_snapshot_();
     }
-    default_logger_ = std::move(new_default_logger);
+    replace_default_(std::move(new_default_logger));
 }
 
 SPDLOG_INLINE void registry::set_tp(std::shared_ptr<thread_pool> tp) {
@@ -143,10 +190,39 @@ SPDLOG_INLINE void registry::disable_backtrace() {
 
 SPDLOG_INLINE void registry::set_level(level::level_enum log_level) {
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
+    // the loggers inheriting a level keep it, set too
+    for (auto &tree_level : tree_levels_) {
+        tree_level.second->store(log_level);
+    }
     for (auto &l : loggers_) {
-        l.second->set_level(log_level);
+        if (!l.second->inherits_level()) {
+            l.second->set_level(log_level);
+        }
     }
     global_log_level_ = log_level;
+    bump_level_generation();
+}
+
+SPDLOG_INLINE void registry::set_tree_level(const std::string &name,
+                                            level::level_enum log_level) {
+    std::lock_guard<std::mutex> lock(logger_map_mutex_);
+    auto &tree_level = tree_levels_[name];
+    if (tree_level) {
+        tree_level->store(log_level);
+        bump_level_generation();
+        return;
+    }
+    tree_level = std::make_shared<level_t>(log_level);
+    // the loggers of the tree now nearest to them
+    auto prefix = name + '.';
+    for (auto &l : loggers_) {
+        auto &logger_name = l.first;
+        if ((logger_name == name || logger_name.compare(0, prefix.size(), prefix) == 0) &&
+            nearest_tree_level_(logger_name) == tree_level) {
+            l.second->inherit_level(tree_level);
+        }
+    }
+    bump_level_generation();
 }
 
 SPDLOG_INLINE void registry::flush_on(level::level_enum log_level) {
@@ -159,40 +235,76 @@ SPDLOG_INLINE void registry::flush_on(level::level_enum log_level) {
 
 SPDLOG_INLINE void registry::set_error_handler(err_handler handler) {
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
+    err_handler_ = handler ? std::make_shared<const err_handler>(std::move(handler)) : nullptr;
     for (auto &l : loggers_) {
-        l.second->set_error_handler(handler);
+        l.second->custom_err_handler_ = err_handler_;
     }
-    err_handler_ = std::move(handler);
 }
 
 SPDLOG_INLINE void registry::apply_all(
     const std::function<void(const std::shared_ptr<logger>)> &fun) {
-    std::lock_guard<std::mutex> lock(logger_map_mutex_);
-    for (auto &l : loggers_) {
-        fun(l.second);
+    for (auto &l : copy_loggers_()) {
+        fun(l);
     }
 }
 
 SPDLOG_INLINE void registry::flush_all() {
-    std::lock_guard<std::mutex> lock(logger_map_mutex_);
-    for (auto &l : loggers_) {
-        l.second->flush();
+    for (auto &l : copy_loggers_()) {
+        l->flush();
+    }
+}
+
+SPDLOG_INLINE bool registry::flush_all(std::chrono::milliseconds timeout) {
+    // shared with the threads, which can outlive the call
+    struct flush_state {
+        std::vector<std::shared_ptr<logger>> loggers;
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t done = 0;
+    };
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto state = std::make_shared<flush_state>();
+    state->loggers = copy_loggers_();
+    const size_t max_threads = 8;
+    auto n_threads = (std::min)(state->loggers.size(), max_threads);
+    for (size_t i = 0; i < n_threads; i++) {
+        std::thread([state] {
+            for (;;) {
+                auto index = state->next.fetch_add(1, std::memory_order_relaxed);
+                if (index >= state->loggers.size()) {
+                    return;
+                }
+                state->loggers[index]->flush();
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->done++;
+                }
+                state->cv.notify_all();
+            }
+        }).detach();
     }
+    std::unique_lock<std::mutex> lock(state->mutex);
+    return state->cv.wait_until(lock, deadline,
+                                [&state] { return state->done == state->loggers.size(); });
 }
 
 SPDLOG_INLINE void registry::drop(const std::string &logger_name) {
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
     auto is_default_logger = default_logger_ && default_logger_->name() == logger_name;
-    loggers_.erase(logger_name);
+    if (loggers_.erase(logger_name) > 0) {
+        publish_snapshot_();
+    }
     if (is_default_logger) {
-        default_logger_.reset();
+        replace_default_(nullptr);
     }
 }
 
 SPDLOG_INLINE void registry::drop_all() {
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
     loggers_.clear();
-    default_logger_.reset();
+    publish_snapshot_();
+    replace_default_(nullptr);
 }
 
 // clean all resources and threads started by the registry
@@ -212,6 +324,20 @@ SPDLOG_INLINE void registry::shutdown() {
 
 SPDLOG_INLINE std::recursive_mutex &registry::tp_mutex() { return tp_mutex_; }
 
+SPDLOG_INLINE void registry::set_sink_sharing(bool sink_sharing) {
+    sink_sharing_.store(sink_sharing, std::memory_order_relaxed);
+}
+
+SPDLOG_INLINE void registry::remove_expired_sinks_() {
+    for (auto it = shared_sinks_.begin(); it != shared_sinks_.end();) {
+        if (it->second.expired()) {
+            it = shared_sinks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 SPDLOG_INLINE void registry::set_automatic_registration(bool automatic_registration) {
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
     automatic_registration_ = automatic_registration;
@@ -223,14 +349,38 @@ SPDLOG_INLINE void registry::set_levels(log_levels levels, level::level_enum *gl
     auto global_level_requested = global_level != nullptr;
     global_log_level_ = global_level_requested ? *global_level : global_log_level_;
 
+    if (global_level_requested) {
+        for (auto &tree_level : tree_levels_) {
+            tree_level.second->store(*global_level);
+        }
+    }
     for (auto &logger : loggers_) {
         auto logger_entry = log_levels_.find(logger.first);
         if (logger_entry != log_levels_.end()) {
             logger.second->set_level(logger_entry->second);
-        } else if (global_level_requested) {
+        } else if (global_level_requested && !logger.second->inherits_level()) {
             logger.second->set_level(*global_level);
         }
     }
+    bump_level_generation();
+}
+
+SPDLOG_INLINE void registry::set_vmodule(vmodule_levels levels) {
+    {
+        std::lock_guard<std::mutex> lock(logger_map_mutex_);
+        vmodule_levels_ = std::move(levels);
+    }
+    bump_level_generation();
+}
+
+SPDLOG_INLINE level::level_enum registry::file_level(const char *file) {
+    std::lock_guard<std::mutex> lock(logger_map_mutex_);
+    for (const auto &pattern_level : vmodule_levels_) {
+        if (path_matches_(pattern_level.first.c_str(), file)) {
+            return pattern_level.second;
+        }
+    }
+    return level::n_levels;
 }
 
 SPDLOG_INLINE registry &registry::instance() {
@@ -245,6 +395,73 @@ SPDLOG_INLINE void registry::apply_logger_env_levels(std::shared_ptr<logger> new
     new_logger->set_level(new_level);
 }
 
+SPDLOG_INLINE bool registry::path_matches_(const char *pattern, const char *path) {
+    auto is_separator = [](char ch) { return ch == '/' || ch == '\\'; };
+    for (;;) {
+        // '*' matches any characters and '?' one, a separator matching '/' or '\\'
+        const char *p = pattern, *text = path;
+        const char *star = nullptr, *star_text = nullptr;
+        bool matched = true;
+        while (*text != '\0') {
+            if (*p == '*') {
+                star = p++;
+                star_text = text;
+            } else if (*p == '?' || *p == *text || (is_separator(*p) && is_separator(*text))) {
+                p++;
+                text++;
+            } else if (star != nullptr) {
+                p = star + 1;
+                text = ++star_text;
+            } else {
+                matched = false;
+                break;
+            }
+        }
+        while (matched && *p == '*') {
+            p++;
+        }
+        if (matched && *p == '\0') {
+            return true;
+        }
+        while (*path != '\0' && !is_separator(*path)) {
+            path++;
+        }
+        if (*path == '\0') {
+            return false;
+        }
+        path++;
+    }
+}
+
+SPDLOG_INLINE std::shared_ptr<level_t> registry::nearest_tree_level_(
+    const std::string &logger_name) {
+    if (tree_levels_.empty()) {
+        return nullptr;
+    }
+    auto name = logger_name;
+    for (;;) {
+        auto it = tree_levels_.find(name);
+        if (it != tree_levels_.end()) {
+            return it->second;
+        }
+        auto dot = name.rfind('.');
+        if (dot == std::string::npos) {
+            return nullptr;
+        }
+        name.resize(dot);
+    }
+}
+
+SPDLOG_INLINE std::vector<std::shared_ptr<logger>> registry::copy_loggers_() {
+    std::lock_guard<std::mutex> lock(logger_map_mutex_);
+    std::vector<std::shared_ptr<logger>> loggers;
+    loggers.reserve(loggers_.size());
+    for (auto &l : loggers_) {
+        loggers.push_back(l.second);
+    }
+    return loggers;
+}
+
 SPDLOG_INLINE void registry::throw_if_exists_(const std::string &logger_name) {
     if (loggers_.find(logger_name) != loggers_.end()) {
         throw_spdlog_ex("logger with name '" + logger_name + "' already exists");
@@ -252,9 +469,165 @@ SPDLOG_INLINE void registry::throw_if_exists_(const std::string &logger_name) {
 }
 
 SPDLOG_INLINE void registry::register_logger_(std::shared_ptr<logger> new_logger) {
+    throw_if_exists_(new_logger->name());
+    publish_inserted_(new_logger);
+    insert_logger_(std::move(new_logger));
+}
+
+SPDLOG_INLINE void registry::apply_settings_(logger &new_logger) {
+    new_logger.set_formatter(formatter_->clone());
+
+    if (err_handler_) {
+        new_logger.custom_err_handler_ = err_handler_;
+    }
+
+    // set new level according to previously configured level or default level
+    auto it = log_levels_.find(new_logger.name());
+    auto new_level = it != log_levels_.end() ? it->second : global_log_level_;
+    new_logger.set_level(new_level);
+
+    new_logger.flush_on(flush_level_);
+
+    if (backtrace_n_messages_ > 0) {
+        new_logger.enable_backtrace(backtrace_n_messages_);
+    }
+}
+
+SPDLOG_INLINE void registry::insert_logger_(std::shared_ptr<logger> new_logger) {
     auto logger_name = new_logger->name();
-    throw_if_exists_(logger_name);
-    loggers_[logger_name] = std::move(new_logger);
+    // unless configured by name
+    if (log_levels_.find(logger_name) == log_levels_.end()) {
+        auto tree_level = nearest_tree_level_(logger_name);
+        if (tree_level) {
+            new_logger->inherit_level(std::move(tree_level));
+        }
+    }
+    loggers_.emplace(std::move(logger_name), std::move(new_logger));
+}
+
+SPDLOG_INLINE void registry::publish_snapshot_() {
+    auto snapshot = std::make_shared<logger_snapshot>(loggers_.begin(), loggers_.end());
+    std::sort(snapshot->begin(), snapshot->end(),
+              [](const logger_snapshot::value_type &a, const logger_snapshot::value_type &b) {
+                  return a.first < b.first;
+              });
+    snapshot_ = std::move(snapshot);
+    snapshot_version_.fetch_add(1, std::memory_order_release);
+}
+
+SPDLOG_INLINE void registry::publish_inserted_(const std::shared_ptr<logger> &new_logger) {
+    const auto &name = new_logger->name();
+    auto snapshot = std::make_shared<logger_snapshot>();
+    snapshot->reserve(snapshot_->size() + 1);
+    auto pos = std::lower_bound(
+        snapshot_->begin(), snapshot_->end(), name,
+        [](const logger_snapshot::value_type &entry, const std::string &logger_name) {
+            return entry.first < logger_name;
+        });
+    snapshot->insert(snapshot->end(), snapshot_->begin(), pos);
+    snapshot->emplace_back(name, new_logger);
+    snapshot->insert(snapshot->end(), pos, snapshot_->end());
+    snapshot_ = std::move(snapshot);
+    snapshot_version_.fetch_add(1, std::memory_order_release);
+}
+
+SPDLOG_INLINE std::shared_ptr<logger> registry::find_(const logger_snapshot &snapshot,
+                                                      string_view_t logger_name) {
+    auto found = std::lower_bound(
+        snapshot.begin(), snapshot.end(), logger_name,
+        [](const logger_snapshot::value_type &entry, string_view_t name) {
+            return string_view_t(entry.first) < name;
+        });
+    if (found == snapshot.end() || string_view_t(found->first) != logger_name) {
+        return nullptr;
+    }
+    return found->second.lock();
+}
+
+SPDLOG_INLINE std::atomic<logger *> *registry::default_hazard_() {
+#ifdef SPDLOG_NO_TLS
+    return nullptr;
+#else
+    // takes a free hazard pointer at the first use, gives it back when the thread exits
+    struct hazard_owner {
+        default_hazard *hazard = nullptr;
+        bool none_free = false;
+
+        ~hazard_owner() {
+            if (hazard != nullptr) {
+                hazard->taken.store(false, std::memory_order_release);
+            }
+        }
+    };
+    static thread_local hazard_owner owner;
+    if (owner.hazard == nullptr && !owner.none_free) {
+        for (auto &hazard : default_hazards_) {
+            bool expected = false;
+            if (!hazard.taken.load(std::memory_order_relaxed) &&
+                hazard.taken.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                owner.hazard = &hazard;
+                break;
+            }
+        }
+        owner.none_free = owner.hazard == nullptr;
+    }
+    return owner.hazard != nullptr ? &owner.hazard->ptr : nullptr;
+#endif
+}
+
+SPDLOG_INLINE logger *registry::protect_default_(std::atomic<logger *> &hazard) {
+    // published before checking the default logger is still the same: replace_default_()
+    // either sees the hazard or the check sees the new logger
+    auto *ptr = default_raw_.load(std::memory_order_acquire);
+    for (;;) {
+        hazard.store(ptr, std::memory_order_seq_cst);
+        auto *current = default_raw_.load(std::memory_order_seq_cst);
+        if (current == ptr) {
+            return ptr;
+        }
+        ptr = current;
+    }
+}
+
+SPDLOG_INLINE void registry::replace_default_(std::shared_ptr<logger> new_default_logger) {
+    default_raw_.store(new_default_logger.get(), std::memory_order_seq_cst);
+    if (default_logger_) {
+        retired_defaults_.push_back(std::move(default_logger_));
+    }
+    default_logger_ = std::move(new_default_logger);
+    bump_level_generation();
+    // release the previous ones no longer in use (the others at the next replacement)
+    auto in_use = [this](const std::shared_ptr<logger> &retired) {
+        for (auto &hazard : default_hazards_) {
+            if (hazard.ptr.load(std::memory_order_seq_cst) == retired.get()) {
+                return true;
+            }
+        }
+        return false;
+    };
+    retired_defaults_.erase(
+        std::remove_if(retired_defaults_.begin(), retired_defaults_.end(),
+                       [&](const std::shared_ptr<logger> &retired) { return !in_use(retired); }),
+        retired_defaults_.end());
+}
+
+SPDLOG_INLINE default_logger_ref::default_logger_ref() {
+    auto &reg = registry::instance();
+    auto *hazard = reg.default_hazard_();
+    // a nested use (e.g. from a sink of the default logger) keeps the hazard of the outer one
+    if (hazard != nullptr && hazard->load(std::memory_order_relaxed) == nullptr) {
+        hazard_ = hazard;
+        ptr_ = reg.protect_default_(*hazard);
+        return;
+    }
+    owned_ = reg.default_logger();
+    ptr_ = owned_.get();
+}
+
+SPDLOG_INLINE default_logger_ref::~default_logger_ref() {
+    if (hazard_ != nullptr) {
+        hazard_->store(nullptr, std::memory_order_release);
+    }
 }
 
 }  // namespace details
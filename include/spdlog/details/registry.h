@@ -10,19 +10,35 @@
 
 #include <spdlog/common.h>
 #include <spdlog/details/periodic_worker.h>
+#include <spdlog/sinks/sink.h>
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace spdlog {
 class logger;
 
 namespace details {
 class thread_pool;
+class default_logger_ref;
+
+// a key per sink type, for the shared sinks
+template <typename T>
+struct sink_type_key {
+    static const char value;
+};
+
+template <typename T>
+const char sink_type_key<T>::value = 0;
 
 class SPDLOG_API registry {
 public:
@@ -32,14 +48,20 @@ public:
 
     void register_logger(std::shared_ptr<logger> new_logger);
     void initialize_logger(std::shared_ptr<logger> new_logger);
-    std::shared_ptr<logger> get(const std::string &logger_name);
+    // initialize_logger() for each, under a single lock, the loggers snapshot being published
+    // once (instead of copied for each logger). if registering, throw spdlog_ex, initializing
+    // none of them, if a name is already registered or given twice.
+    void initialize_loggers(const std::vector<std::shared_ptr<logger>> &new_loggers);
+    // doesn't lock: looks up a snapshot of the loggers, copied when they change (so the
+    // registration and drop of loggers are slower, in proportion to their number)
+    std::shared_ptr<logger> get(string_view_t logger_name);
+    // incremented whenever loggers are registered or dropped (see logger_ref)
+    std::uint64_t version() const { return snapshot_version_.load(std::memory_order_acquire); }
     std::shared_ptr<logger> default_logger();
 
     // Return raw ptr to the default logger.
-    // To be used directly by the spdlog default api (e.g. spdlog::info)
-    // This make the default API faster, but cannot be used concurrently with set_default_logger().
-    // e.g do not call set_default_logger() from one thread while calling spdlog::info() from
-    // another.
+    // It cannot be used concurrently with set_default_logger(): the default api (e.g.
+    // spdlog::info) uses a default_logger_ref instead.
     logger *get_default_raw();
 
     // set default logger and add it to the registry if not registered already.
@@ -61,6 +83,12 @@ public:
 
     void set_level(level::level_enum log_level);
 
+    // set the level of the loggers in the tree named name: name itself and its dotted children
+    // (e.g. "db.pool.conn" for "db"), registered or to be, but those of a nearer tree with a
+    // level set. they inherit it through a shared level (see logger::inherit_level), so that
+    // setting it again is a single store, until set_level() is called on a logger.
+    void set_tree_level(const std::string &name, level::level_enum log_level);
+
     void flush_on(level::level_enum log_level);
 
     template <typename Rep, typename Period>
@@ -81,6 +109,10 @@ public:
 
     void flush_all();
 
+    // flush the loggers in parallel, waiting for them until the timeout. return false if some
+    // were still flushing then, which their threads finish later.
+    bool flush_all(std::chrono::milliseconds timeout);
+
     void drop(const std::string &logger_name);
 
     void drop_all();
@@ -92,35 +124,153 @@ public:
 
     void set_automatic_registration(bool automatic_registration);
 
+    // share a sink between the loggers created by the factory functions for the same file (see
+    // sinks::shares_file), instead of each one opening the file: the arguments of the first
+    // logger's sink apply to the next ones. the sinks aren't kept once their loggers are gone.
+    void set_sink_sharing(bool sink_sharing);
+
+    // the sink of a logger created by a factory function: the one already created for the same
+    // file and sink type when sharing, or a new Sink(args...)
+    template <typename Sink, typename... SinkArgs>
+    std::shared_ptr<Sink> make_sink(SinkArgs &&...args) {
+        return make_sink_<Sink>(sinks::shares_file<Sink>{}, std::forward<SinkArgs>(args)...);
+    }
+
     // set levels for all existing/future loggers. global_level can be null if should not set.
     void set_levels(log_levels levels, level::level_enum *global_level);
 
+    // levels per source file, for the logging macros (see cfg::helpers::load_vmodule): the
+    // level of the first glob pattern matching the file's path applies, whatever the logger.
+    using vmodule_levels = std::vector<std::pair<std::string, level::level_enum>>;
+    void set_vmodule(vmodule_levels levels);
+
+    // the level set for the source file, level::n_levels if none
+    level::level_enum file_level(const char *file);
+
     static registry &instance();
 
     void apply_logger_env_levels(std::shared_ptr<logger> new_logger);
 
 private:
+    friend class default_logger_ref;
+
+    // hazard pointer of a thread using the default logger: the logger it points to is not
+    // destroyed by set_default_logger() or drop() until the pointer is cleared
+    struct alignas(64) default_hazard {
+        std::atomic<logger *> ptr{nullptr};
+        std::atomic<bool> taken{false};
+    };
+    static constexpr size_t max_default_hazards = 128;
+
     registry();
     ~registry();
 
     void throw_if_exists_(const std::string &logger_name);
     void register_logger_(std::shared_ptr<logger> new_logger);
+    // the global settings of the loggers, under logger_map_mutex_
+    void apply_settings_(logger &new_logger);
+    // into loggers_, inheriting its tree level, without publishing it
+    void insert_logger_(std::shared_ptr<logger> new_logger);
     bool set_level_from_cfg_(logger *logger);
+    // the level of the nearest tree of logger_name with a level set, null if none
+    std::shared_ptr<level_t> nearest_tree_level_(const std::string &logger_name);
+    // the loggers registered, to be used without holding logger_map_mutex_
+    std::vector<std::shared_ptr<logger>> copy_loggers_();
+    // the hazard pointer of this thread, nullptr if all of them are taken (or without tls)
+    std::atomic<logger *> *default_hazard_();
+    // set hazard to the default logger, and return it
+    logger *protect_default_(std::atomic<logger *> &hazard);
+    // (under logger_map_mutex_) replace default_logger_, keeping the previous one alive
+    // while pointed to by a hazard pointer
+    void replace_default_(std::shared_ptr<logger> new_default_logger);
+    // sorted by name. the loggers stay owned by loggers_
+    using logger_snapshot = std::vector<std::pair<std::string, std::weak_ptr<logger>>>;
+    // copy loggers_ to a new snapshot (under logger_map_mutex_)
+    void publish_snapshot_();
+    // the current snapshot with new_logger added at its place (under logger_map_mutex_),
+    // without sorting all the loggers again
+    void publish_inserted_(const std::shared_ptr<logger> &new_logger);
+    static std::shared_ptr<logger> find_(const logger_snapshot &snapshot,
+                                         string_view_t logger_name);
+    template <typename Sink, typename... SinkArgs>
+    std::shared_ptr<Sink> make_sink_(std::false_type, SinkArgs &&...args) {
+        return std::make_shared<Sink>(std::forward<SinkArgs>(args)...);
+    }
+
+    template <typename Sink, typename Filename, typename... SinkArgs>
+    std::shared_ptr<Sink> make_sink_(std::true_type, Filename &&filename, SinkArgs &&...args) {
+        if (!sink_sharing_.load(std::memory_order_relaxed)) {
+            return std::make_shared<Sink>(std::forward<Filename>(filename),
+                                          std::forward<SinkArgs>(args)...);
+        }
+        auto key = std::make_pair(static_cast<const void *>(&sink_type_key<Sink>::value),
+                                  filename_t(filename));
+        std::lock_guard<std::mutex> lock(shared_sinks_mutex_);
+        auto it = shared_sinks_.find(key);
+        if (it != shared_sinks_.end()) {
+            auto shared = it->second.lock();
+            if (shared) {
+                return std::static_pointer_cast<Sink>(shared);
+            }
+        }
+        remove_expired_sinks_();
+        auto sink = std::make_shared<Sink>(std::forward<Filename>(filename),
+                                           std::forward<SinkArgs>(args)...);
+        shared_sinks_[std::move(key)] = sink;
+        return sink;
+    }
+
+    // (under shared_sinks_mutex_) forget the shared sinks of the loggers gone
+    void remove_expired_sinks_();
+    // whether pattern matches the path, or its end from a path separator
+    static bool path_matches_(const char *pattern, const char *path);
     std::mutex logger_map_mutex_, flusher_mutex_;
     std::recursive_mutex tp_mutex_;
     std::unordered_map<std::string, std::shared_ptr<logger>> loggers_;
+    std::shared_ptr<const logger_snapshot> snapshot_;  // guarded by logger_map_mutex_
+    std::atomic<std::uint64_t> snapshot_version_{0};   // incremented when snapshot_ changes
     log_levels log_levels_;
+    vmodule_levels vmodule_levels_;
+    // set by set_tree_level(), by tree name. kept, the loggers pointing to them
+    std::unordered_map<std::string, std::shared_ptr<level_t>> tree_levels_;
     std::unique_ptr<formatter> formatter_;
     spdlog::level::level_enum global_log_level_ = level::info;
     level::level_enum flush_level_ = level::off;
-    err_handler err_handler_;
+    std::shared_ptr<const err_handler> err_handler_;  // shared by the loggers
     std::shared_ptr<thread_pool> tp_;
     std::unique_ptr<periodic_worker> periodic_flusher_;
     std::shared_ptr<logger> default_logger_;
+    std::atomic<logger *> default_raw_{nullptr};  // default_logger_.get()
+    std::vector<std::shared_ptr<logger>> retired_defaults_;
+    default_hazard default_hazards_[max_default_hazards];
     bool automatic_registration_ = true;
+    std::atomic<bool> sink_sharing_{false};
+    std::mutex shared_sinks_mutex_;
+    // by sink type and filename
+    std::map<std::pair<const void *, filename_t>, std::weak_ptr<void>> shared_sinks_;
     size_t backtrace_n_messages_ = 0;
 };
 
+// the default logger, kept alive while the object lives even if set_default_logger() or drop()
+// is called concurrently: the default api (e.g. spdlog::info) logs through a temporary one.
+// without a refcount, by publishing a hazard pointer (falling back to a shared_ptr copy when
+// nested or if too many threads use the default api at once).
+class SPDLOG_API default_logger_ref {
+public:
+    default_logger_ref();
+    ~default_logger_ref();
+    default_logger_ref(const default_logger_ref &) = delete;
+    default_logger_ref &operator=(const default_logger_ref &) = delete;
+
+    logger *get() const { return ptr_; }
+    logger *operator->() const { return ptr_; }
+
+private:
+    std::atomic<logger *> *hazard_ = nullptr;
+    logger *ptr_ = nullptr;
+    std::shared_ptr<logger> owned_;
+};
+
 }  // namespace details
 }  // namespace spdlog
 
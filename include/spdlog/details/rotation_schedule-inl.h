@@ -0,0 +1,48 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/details/rotation_schedule.h>
+#endif
+
+#include <spdlog/details/os.h>
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE rotation_schedule::rotation_schedule(std::chrono::seconds period,
+                                                   std::chrono::seconds offset)
+    : period_(static_cast<std::int64_t>(period.count())),
+      offset_(static_cast<std::int64_t>(offset.count())) {
+    if (period_ <= 0 || 86400 % period_ != 0 || offset_ < 0 || offset_ >= period_) {
+        throw_spdlog_ex("rotation_schedule: invalid period or offset");
+    }
+}
+
+SPDLOG_INLINE log_clock::time_point rotation_schedule::next_after(log_clock::time_point tp) const {
+    auto secs = static_cast<std::int64_t>(log_clock::to_time_t(tp));
+    if (log_clock::from_time_t(static_cast<std::time_t>(secs)) > tp) {
+        secs--;  // to_time_t may round up
+    }
+    auto local = secs + os::utc_offset_seconds(static_cast<std::time_t>(secs));
+    auto since = local - offset_;
+    auto periods = (since >= 0 ? since : since - period_ + 1) / period_;
+    auto next_local = (periods + 1) * period_ + offset_;
+
+    // the offset of the rotation point itself, in case there is a DST change before it
+    auto next = next_local - (local - secs);
+    next = next_local - os::utc_offset_seconds(static_cast<std::time_t>(next));
+    if (next <= secs) {
+        next += period_;  // the clocks went back over the rotation point
+    }
+    return log_clock::from_time_t(static_cast<std::time_t>(next));
+}
+
+SPDLOG_INLINE std::tm rotation_schedule::local_tm(log_clock::time_point tp) {
+    return os::fast_localtime(log_clock::to_time_t(tp));
+}
+
+}  // namespace details
+}  // namespace spdlog
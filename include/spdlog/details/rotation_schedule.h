@@ -0,0 +1,41 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <spdlog/common.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+namespace spdlog {
+namespace details {
+
+// Rotation points of the time based file sinks: every period of local time, at the given offset
+// from midnight (every 24 hours at 02:30, every hour at minute 0, every 5 minutes..).
+// Computed arithmetically from the UTC offset, so rotating doesn't call mktime() (which reloads
+// the time zone on each call) and many sinks rotating at the same time stay cheap.
+class SPDLOG_API rotation_schedule {
+public:
+    // period must divide a day, and offset be less than the period.
+    // throw spdlog_ex otherwise.
+    rotation_schedule(std::chrono::seconds period, std::chrono::seconds offset);
+
+    // first rotation point after tp
+    log_clock::time_point next_after(log_clock::time_point tp) const;
+
+    // local time of tp, for the file names
+    static std::tm local_tm(log_clock::time_point tp);
+
+private:
+    std::int64_t period_;
+    std::int64_t offset_;
+};
+
+}  // namespace details
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "rotation_schedule-inl.h"
+#endif
@@ -0,0 +1,89 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/details/scheduler.h>
+#endif
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE scheduler::~scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+SPDLOG_INLINE scheduler &scheduler::instance() {
+    static scheduler s_instance;
+    return s_instance;
+}
+
+SPDLOG_INLINE void scheduler::cancel(task_id id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (running_ == id && thread_.get_id() == std::this_thread::get_id()) {
+        running_cancelled_ = true;
+        return;
+    }
+    cv_.wait(lock, [this, id] { return running_ != id; });
+    tasks_.erase(id);
+}
+
+SPDLOG_INLINE scheduler::task_id scheduler::schedule_every_(std::function<void()> task,
+                                                           clock::duration interval) {
+    task_id id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        tasks_.emplace(id, entry{std::move(task), interval});
+        due_.emplace(clock::now() + interval, id);
+        if (!thread_.joinable()) {
+            thread_ = std::thread([this] { loop_(); });
+        }
+    }
+    cv_.notify_all();
+    return id;
+}
+
+SPDLOG_INLINE void scheduler::loop_() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (due_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        auto next = due_.top();
+        if (next.first > clock::now()) {
+            cv_.wait_until(lock, next.first);
+            continue;
+        }
+        due_.pop();
+        auto it = tasks_.find(next.second);
+        if (it == tasks_.end()) {
+            continue;  // cancelled
+        }
+        running_ = next.second;
+        lock.unlock();
+        SPDLOG_TRY { it->second.task(); }
+        SPDLOG_CATCH_STD
+        lock.lock();
+        if (running_cancelled_) {
+            tasks_.erase(it);
+            running_cancelled_ = false;
+        } else {
+            due_.emplace(clock::now() + it->second.interval, next.second);
+        }
+        running_ = 0;
+        cv_.notify_all();
+    }
+}
+
+}  // namespace details
+}  // namespace spdlog
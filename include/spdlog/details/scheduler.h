@@ -0,0 +1,82 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Housekeeping scheduler: a single thread running the periodic tasks of spdlog (e.g. the
+// periodic flush) and of the sinks, instead of a thread per task. The thread is started by the
+// first task scheduled, and stopped when the process exits.
+//
+// The tasks run one after the other, so they should be short: a task which can block (e.g.
+// compressing a file, or connecting) should only post the work to its own thread.
+
+#include <spdlog/common.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+class SPDLOG_API scheduler {
+public:
+    using clock = std::chrono::steady_clock;
+    using task_id = std::uint64_t;
+
+    scheduler() = default;
+    scheduler(const scheduler &) = delete;
+    scheduler &operator=(const scheduler &) = delete;
+    // stop the thread and join it
+    ~scheduler();
+
+    static scheduler &instance();
+
+    // run task every interval (after the end of its previous run), until cancelled
+    template <typename Rep, typename Period>
+    task_id schedule_every(std::function<void()> task,
+                           std::chrono::duration<Rep, Period> interval) {
+        return schedule_every_(std::move(task),
+                               std::chrono::duration_cast<clock::duration>(interval));
+    }
+
+    // remove the task, waiting for its current run to end (unless called from the task)
+    void cancel(task_id id);
+
+private:
+    struct entry {
+        std::function<void()> task;
+        clock::duration interval;
+    };
+    // when the next run of the task is due
+    using due_task = std::pair<clock::time_point, task_id>;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // an entry isn't moved by the other insertions, so it can run outside the lock
+    std::unordered_map<task_id, entry> tasks_;
+    // the earliest first. the cancelled tasks are skipped when due
+    std::priority_queue<due_task, std::vector<due_task>, std::greater<due_task>> due_;
+    task_id next_id_ = 1;
+    task_id running_ = 0;             // the task being run, 0 if none
+    bool running_cancelled_ = false;  // cancelled by itself, removed once it returns
+    bool stop_ = false;
+    std::thread thread_;
+
+    task_id schedule_every_(std::function<void()> task, clock::duration interval);
+    void loop_();
+};
+
+}  // namespace details
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "scheduler-inl.h"
+#endif
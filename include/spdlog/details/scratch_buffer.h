@@ -0,0 +1,72 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// The buffer of the thread the loggers format their messages to, kept for its capacity so that
+// messages too big for the inline buffer don't allocate on each call.
+// A buffer which grew past SPDLOG_SCRATCH_BUFFER_MAX_SIZE is freed once the message is logged,
+// so one huge message doesn't pin its memory for the life of the thread.
+
+#include <spdlog/common.h>
+
+#include <new>
+
+#ifndef SPDLOG_SCRATCH_BUFFER_MAX_SIZE
+    #define SPDLOG_SCRATCH_BUFFER_MAX_SIZE (64 * 1024)
+#endif
+
+namespace spdlog {
+namespace details {
+
+// the buffer of the thread, or a local one if it's in use (an argument formatted logging too)
+template <typename Buffer>
+class scratch_buffer {
+public:
+    scratch_buffer() {
+#ifndef SPDLOG_NO_TLS
+        auto &state = thread_state_();
+        if (!state.in_use) {
+            state.in_use = true;
+            state.buf.clear();
+            buf_ = &state.buf;
+        }
+#endif
+    }
+
+    ~scratch_buffer() {
+#ifndef SPDLOG_NO_TLS
+        if (buf_ != &local_) {
+            auto &state = thread_state_();
+            if (state.buf.capacity() > SPDLOG_SCRATCH_BUFFER_MAX_SIZE) {
+                state.buf.~Buffer();
+                new (&state.buf) Buffer();
+            }
+            state.in_use = false;
+        }
+#endif
+    }
+
+    scratch_buffer(const scratch_buffer &) = delete;
+    scratch_buffer &operator=(const scratch_buffer &) = delete;
+
+    Buffer &buf() { return *buf_; }
+
+private:
+    Buffer local_;
+    Buffer *buf_ = &local_;
+
+#ifndef SPDLOG_NO_TLS
+    struct state {
+        Buffer buf;
+        bool in_use = false;
+    };
+    static state &thread_state_() {
+        static thread_local state thread_state;
+        return thread_state;
+    }
+#endif
+};
+
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,70 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef _WIN32
+    #error send_datagrams is not supported on windows
+#endif
+
+#include <spdlog/common.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace spdlog {
+namespace details {
+
+// send each of the given buffers as a datagram to addr (the connected peer if null), with one
+// sendmmsg(2) call per 64 datagrams on linux (one sendto(2) per datagram elsewhere).
+// return the number of datagrams sent: less than count on error, errno telling which.
+inline size_t send_datagrams(int fd,
+                             const sockaddr *addr,
+                             socklen_t addr_len,
+                             const string_view_t *datagrams,
+                             size_t count) {
+    size_t total = 0;
+#ifdef __linux__
+    constexpr size_t max_batch = 64;
+    struct mmsghdr msgs[max_batch];
+    struct iovec iovs[max_batch];
+    while (total < count) {
+        auto n = count - total < max_batch ? count - total : max_batch;
+        std::memset(msgs, 0, sizeof(msgs[0]) * n);
+        for (size_t i = 0; i < n; i++) {
+            iovs[i].iov_base = const_cast<char *>(datagrams[total + i].data());
+            iovs[i].iov_len = datagrams[total + i].size();
+            msgs[i].msg_hdr.msg_name = const_cast<sockaddr *>(addr);
+            msgs[i].msg_hdr.msg_namelen = addr == nullptr ? 0 : addr_len;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        auto sent = ::sendmmsg(fd, msgs, static_cast<unsigned>(n), 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        total += static_cast<size_t>(sent);
+    }
+#else
+    while (total < count) {
+        auto &datagram = datagrams[total];
+        if (::sendto(fd, datagram.data(), datagram.size(), 0, addr,
+                     addr == nullptr ? 0 : addr_len) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        total++;
+    }
+#endif
+    return total;
+}
+
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,85 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// While a logger (or a dist_sink) passes a message to several sinks, the first formatter
+// formatting it keeps the result in the shared_format of the thread, so the sinks with an
+// identical formatter copy it instead of formatting the message again.
+// Formatters opt in by checking shared_format::get(msg) (see pattern_formatter::format).
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+
+namespace spdlog {
+namespace details {
+
+struct shared_format {
+    const log_msg *msg = nullptr;
+    // the pattern_formatter which formatted msg into buf (null if none did yet)
+    const void *formatter = nullptr;
+    memory_buf_t buf;
+    // the color range set by the formatter, and where buf started in its destination
+    size_t color_range_start = 0;
+    size_t color_range_end = 0;
+    size_t buf_start = 0;
+
+    // the shared_format of the thread for the given message, or null
+    static shared_format *get(const log_msg &msg) {
+#ifndef SPDLOG_NO_TLS
+        auto *current = current_();
+        return current != nullptr && current->msg == &msg ? current : nullptr;
+#else
+        (void)msg;
+        return nullptr;
+#endif
+    }
+
+#ifndef SPDLOG_NO_TLS
+    static shared_format *&current_() {
+        static thread_local shared_format *current = nullptr;
+        return current;
+    }
+#endif
+};
+
+// make a shared_format current for the message while fanning it out to sinks (if enabled and
+// there is none for it already, e.g. in a dist_sink of a logger)
+class shared_format_scope {
+public:
+    shared_format_scope(const log_msg &msg, bool enabled) {
+#ifndef SPDLOG_NO_TLS
+        auto &current = shared_format::current_();
+        if (enabled && (current == nullptr || current->msg != &msg)) {
+            format_.msg = &msg;
+            prev_ = current;
+            current = &format_;
+            active_ = true;
+        }
+#else
+        (void)msg;
+        (void)enabled;
+#endif
+    }
+
+    ~shared_format_scope() {
+#ifndef SPDLOG_NO_TLS
+        if (active_) {
+            shared_format::current_() = prev_;
+        }
+#endif
+    }
+
+    shared_format_scope(const shared_format_scope &) = delete;
+    shared_format_scope &operator=(const shared_format_scope &) = delete;
+
+#ifndef SPDLOG_NO_TLS
+private:
+    shared_format format_;
+    shared_format *prev_ = nullptr;
+    bool active_ = false;
+#endif
+};
+
+}  // namespace details
+}  // namespace spdlog
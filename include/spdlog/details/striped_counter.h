@@ -0,0 +1,68 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Counter incremented by many threads at once: the count is split in stripes, each on its own
+// cache line, and each thread adds to the stripe of the cpu it runs on (or of its thread id
+// where the cpu is not known). Increments don't bounce a shared cache line between cores,
+// and reading the count sums up the stripes without any lock.
+
+#include <spdlog/details/os.h>
+
+#include <atomic>
+#include <cstddef>
+
+namespace spdlog {
+namespace details {
+
+class striped_counter {
+public:
+    striped_counter() = default;
+    striped_counter(const striped_counter &) = delete;
+    striped_counter &operator=(const striped_counter &) = delete;
+
+    void add(size_t n = 1) SPDLOG_NOEXCEPT {
+        stripes_[stripe_index_()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    striped_counter &operator++() SPDLOG_NOEXCEPT {
+        add();
+        return *this;
+    }
+
+    // sum of the stripes. exact if no concurrent add.
+    size_t load() const SPDLOG_NOEXCEPT {
+        size_t total = 0;
+        for (auto &stripe : stripes_) {
+            total += stripe.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void reset() SPDLOG_NOEXCEPT {
+        for (auto &stripe : stripes_) {
+            stripe.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static constexpr size_t stripes_n = 16;
+    static constexpr size_t cache_line_size = 64;
+
+    struct stripe {
+        std::atomic<size_t> value{0};
+        char padding[cache_line_size - sizeof(std::atomic<size_t>)];
+    };
+
+    stripe stripes_[stripes_n];
+
+    static size_t stripe_index_() SPDLOG_NOEXCEPT {
+        auto cpu = os::current_cpu();
+        auto index = cpu >= 0 ? static_cast<size_t>(cpu) : os::thread_id();
+        return index % stripes_n;
+    }
+};
+
+}  // namespace details
+}  // namespace spdlog
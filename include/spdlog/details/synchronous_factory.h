@@ -5,6 +5,9 @@
 
 #include "registry.h"
 
+#include <string>
+#include <vector>
+
 namespace spdlog {
 
 // Default logger factory-  creates synchronous loggers
@@ -13,10 +16,26 @@ class logger;
 struct synchronous_factory {
     template <typename Sink, typename... SinkArgs>
     static std::shared_ptr<spdlog::logger> create(std::string logger_name, SinkArgs &&...args) {
-        auto sink = std::make_shared<Sink>(std::forward<SinkArgs>(args)...);
+        auto sink =
+            details::registry::instance().make_sink<Sink>(std::forward<SinkArgs>(args)...);
         auto new_logger = std::make_shared<spdlog::logger>(std::move(logger_name), std::move(sink));
         details::registry::instance().initialize_logger(new_logger);
         return new_logger;
     }
+
+    // loggers of a single sink, registered at once
+    template <typename Sink, typename... SinkArgs>
+    static std::vector<std::shared_ptr<spdlog::logger>> create_many(
+        const std::vector<std::string> &logger_names, SinkArgs &&...args) {
+        auto sink =
+            details::registry::instance().make_sink<Sink>(std::forward<SinkArgs>(args)...);
+        std::vector<std::shared_ptr<spdlog::logger>> new_loggers;
+        new_loggers.reserve(logger_names.size());
+        for (const auto &logger_name : logger_names) {
+            new_loggers.push_back(std::make_shared<spdlog::logger>(logger_name, sink));
+        }
+        details::registry::instance().initialize_loggers(new_loggers);
+        return new_loggers;
+    }
 };
 }  // namespace spdlog
@@ -8,9 +8,12 @@
 #include <spdlog/common.h>
 #include <spdlog/details/os.h>
 
+#include <chrono>
+#include <cstring>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <vector>
 #include <windows.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -41,6 +44,59 @@ class tcp_client {
         throw_spdlog_ex(fmt_lib::format("tcp_sink - {}: {}", msg, buf));
     }
 
+    // the addresses of the last host resolved, reused by connect() for dns_ttl_
+    struct resolved_address {
+        sockaddr_storage addr;
+        int addr_len;
+        int family;
+        int socktype;
+        int protocol;
+    };
+    std::string resolved_host_;
+    int resolved_port_ = 0;
+    std::chrono::steady_clock::time_point resolved_time_;
+    std::vector<resolved_address> resolved_;
+    std::chrono::milliseconds dns_ttl_{60000};
+
+    void resolve_(const std::string &host, int port) {
+        auto now = std::chrono::steady_clock::now();
+        if (!resolved_.empty() && host == resolved_host_ && port == resolved_port_ &&
+            now - resolved_time_ < dns_ttl_) {
+            return;
+        }
+        resolved_.clear();
+        struct addrinfo hints {};
+        ZeroMemory(&hints, sizeof(hints));
+
+        hints.ai_family = AF_UNSPEC;      // To work with IPv4, IPv6, and so on
+        hints.ai_socktype = SOCK_STREAM;  // TCP
+        hints.ai_flags = AI_NUMERICSERV;  // port passed as as numeric value
+        hints.ai_protocol = 0;
+
+        auto port_str = std::to_string(port);
+        struct addrinfo *addrinfo_result;
+        auto rv = ::getaddrinfo(host.c_str(), port_str.c_str(), &hints, &addrinfo_result);
+        if (rv != 0) {
+            throw_winsock_error_("getaddrinfo failed", ::WSAGetLastError());
+        }
+        for (auto *rp = addrinfo_result; rp != nullptr; rp = rp->ai_next) {
+            if (rp->ai_addrlen > sizeof(sockaddr_storage)) {
+                continue;
+            }
+            resolved_address address{};
+            std::memcpy(&address.addr, rp->ai_addr, rp->ai_addrlen);
+            address.addr_len = static_cast<int>(rp->ai_addrlen);
+            address.family = rp->ai_family;
+            address.socktype = rp->ai_socktype;
+            address.protocol = rp->ai_protocol;
+            resolved_.push_back(address);
+        }
+        ::freeaddrinfo(addrinfo_result);
+        resolved_host_ = host;
+        resolved_port_ = port;
+        resolved_time_ = now;
+    }
+
 public:
     tcp_client() { init_winsock_(); }
 
@@ -58,48 +114,33 @@ public:
 
     SOCKET fd() const { return socket_; }
 
+    // how long connect() reuses the addresses it resolved for a host (0 to resolve each time)
+    void set_dns_ttl(std::chrono::milliseconds ttl) { dns_ttl_ = ttl; }
+
     // try to connect or throw on failure
     void connect(const std::string &host, int port) {
         if (is_connected()) {
             close();
         }
-        struct addrinfo hints {};
-        ZeroMemory(&hints, sizeof(hints));
-
-        hints.ai_family = AF_UNSPEC;      // To work with IPv4, IPv6, and so on
-        hints.ai_socktype = SOCK_STREAM;  // TCP
-        hints.ai_flags = AI_NUMERICSERV;  // port passed as as numeric value
-        hints.ai_protocol = 0;
-
-        auto port_str = std::to_string(port);
-        struct addrinfo *addrinfo_result;
-        auto rv = ::getaddrinfo(host.c_str(), port_str.c_str(), &hints, &addrinfo_result);
-        int last_error = 0;
-        if (rv != 0) {
-            last_error = ::WSAGetLastError();
-            WSACleanup();
-            throw_winsock_error_("getaddrinfo failed", last_error);
-        }
+        resolve_(host, port);
 
         // Try each address until we successfully connect(2).
-
-        for (auto *rp = addrinfo_result; rp != nullptr; rp = rp->ai_next) {
-            socket_ = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        int last_error = 0;
+        for (const auto &address : resolved_) {
+            socket_ = socket(address.family, address.socktype, address.protocol);
             if (socket_ == INVALID_SOCKET) {
                 last_error = ::WSAGetLastError();
-                WSACleanup();
                 continue;
             }
-            if (::connect(socket_, rp->ai_addr, (int)rp->ai_addrlen) == 0) {
+            if (::connect(socket_, reinterpret_cast<const sockaddr *>(&address.addr),
+                          address.addr_len) == 0) {
                 break;
             } else {
                 last_error = ::WSAGetLastError();
                 close();
             }
         }
-        ::freeaddrinfo(addrinfo_result);
         if (socket_ == INVALID_SOCKET) {
-            WSACleanup();
             throw_winsock_error_("connect failed", last_error);
         }
 
@@ -130,6 +171,18 @@ public:
             bytes_sent += static_cast<size_t>(write_result);
         }
     }
+
+    // Receive up to n_bytes, returning the number received (0 if the peer closed the connection).
+    // On error close the connection and throw.
+    size_t recv(char *data, size_t n_bytes) {
+        auto read_result = ::recv(socket_, data, (int)n_bytes, 0);
+        if (read_result == SOCKET_ERROR) {
+            int last_error = ::WSAGetLastError();
+            close();
+            throw_winsock_error_("recv failed", last_error);
+        }
+        return static_cast<size_t>(read_result);
+    }
 };
 }  // namespace details
 }  // namespace spdlog
@@ -18,13 +18,68 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <cstring>
 #include <string>
+#include <vector>
 
 namespace spdlog {
 namespace details {
 class tcp_client {
     int socket_ = -1;
 
+    // the addresses of the last host resolved, reused by connect() for dns_ttl_
+    struct resolved_address {
+        sockaddr_storage addr;
+        socklen_t addr_len;
+        int family;
+        int socktype;
+        int protocol;
+    };
+    std::string resolved_host_;
+    int resolved_port_ = 0;
+    std::chrono::steady_clock::time_point resolved_time_;
+    std::vector<resolved_address> resolved_;
+    std::chrono::milliseconds dns_ttl_{60000};
+
+    void resolve_(const std::string &host, int port) {
+        auto now = std::chrono::steady_clock::now();
+        if (!resolved_.empty() && host == resolved_host_ && port == resolved_port_ &&
+            now - resolved_time_ < dns_ttl_) {
+            return;
+        }
+        resolved_.clear();
+        struct addrinfo hints {};
+        memset(&hints, 0, sizeof(struct addrinfo));
+        hints.ai_family = AF_UNSPEC;      // To work with IPv4, IPv6, and so on
+        hints.ai_socktype = SOCK_STREAM;  // TCP
+        hints.ai_flags = AI_NUMERICSERV;  // port passed as as numeric value
+        hints.ai_protocol = 0;
+
+        auto port_str = std::to_string(port);
+        struct addrinfo *addrinfo_result;
+        auto rv = ::getaddrinfo(host.c_str(), port_str.c_str(), &hints, &addrinfo_result);
+        if (rv != 0) {
+            throw_spdlog_ex(fmt_lib::format("::getaddrinfo failed: {}", gai_strerror(rv)));
+        }
+        for (auto *rp = addrinfo_result; rp != nullptr; rp = rp->ai_next) {
+            if (rp->ai_addrlen > sizeof(sockaddr_storage)) {
+                continue;
+            }
+            resolved_address address{};
+            std::memcpy(&address.addr, rp->ai_addr, rp->ai_addrlen);
+            address.addr_len = rp->ai_addrlen;
+            address.family = rp->ai_family;
+            address.socktype = rp->ai_socktype;
+            address.protocol = rp->ai_protocol;
+            resolved_.push_back(address);
+        }
+        ::freeaddrinfo(addrinfo_result);
+        resolved_host_ = host;
+        resolved_port_ = port;
+        resolved_time_ = now;
+    }
+
 public:
     bool is_connected() const { return socket_ != -1; }
 
@@ -39,37 +94,29 @@ public:
 
     ~tcp_client() { close(); }
 
+    // how long connect() reuses the addresses it resolved for a host (0 to resolve each time)
+    void set_dns_ttl(std::chrono::milliseconds ttl) { dns_ttl_ = ttl; }
+
     // try to connect or throw on failure
     void connect(const std::string &host, int port) {
         close();
-        struct addrinfo hints {};
-        memset(&hints, 0, sizeof(struct addrinfo));
-        hints.ai_family = AF_UNSPEC;      // To work with IPv4, IPv6, and so on
-        hints.ai_socktype = SOCK_STREAM;  // TCP
-        hints.ai_flags = AI_NUMERICSERV;  // port passed as as numeric value
-        hints.ai_protocol = 0;
-
-        auto port_str = std::to_string(port);
-        struct addrinfo *addrinfo_result;
-        auto rv = ::getaddrinfo(host.c_str(), port_str.c_str(), &hints, &addrinfo_result);
-        if (rv != 0) {
-            throw_spdlog_ex(fmt_lib::format("::getaddrinfo failed: {}", gai_strerror(rv)));
-        }
+        resolve_(host, port);
 
         // Try each address until we successfully connect(2).
         int last_errno = 0;
-        for (auto *rp = addrinfo_result; rp != nullptr; rp = rp->ai_next) {
+        for (const auto &address : resolved_) {
 #if defined(SOCK_CLOEXEC)
             const int flags = SOCK_CLOEXEC;
 #else
             const int flags = 0;
 #endif
-            socket_ = ::socket(rp->ai_family, rp->ai_socktype | flags, rp->ai_protocol);
+            socket_ = ::socket(address.family, address.socktype | flags, address.protocol);
             if (socket_ == -1) {
                 last_errno = errno;
                 continue;
             }
-            rv = ::connect(socket_, rp->ai_addr, rp->ai_addrlen);
+            auto rv = ::connect(socket_, reinterpret_cast<const sockaddr *>(&address.addr),
+                                address.addr_len);
             if (rv == 0) {
                 break;
             }
@@ -77,7 +124,6 @@ public:
             ::close(socket_);
             socket_ = -1;
         }
-        ::freeaddrinfo(addrinfo_result);
         if (socket_ == -1) {
             throw_spdlog_ex("::connect failed", last_errno);
         }
@@ -122,6 +168,17 @@ public:
             bytes_sent += static_cast<size_t>(write_result);
         }
     }
+
+    // Receive up to n_bytes, returning the number received (0 if the peer closed the connection).
+    // On error close the connection and throw.
+    size_t recv(char *data, size_t n_bytes) {
+        auto read_result = ::recv(socket_, data, n_bytes, 0);
+        if (read_result < 0) {
+            close();
+            throw_spdlog_ex("read(2) failed", errno);
+        }
+        return static_cast<size_t>(read_result);
+    }
 };
 }  // namespace details
 }  // namespace spdlog
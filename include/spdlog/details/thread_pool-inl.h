@@ -7,31 +7,245 @@
     #include <spdlog/details/thread_pool.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
 #include <spdlog/common.h>
+#include <spdlog/sinks/sink.h>
+
+#ifdef __linux__
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#endif
 
 namespace spdlog {
 namespace details {
 
-SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items,
-                                       size_t threads_n,
-                                       std::function<void()> on_thread_start,
-                                       std::function<void()> on_thread_stop)
-    : q_(q_max_items) {
-    if (threads_n == 0 || threads_n > 1000) {
+SPDLOG_INLINE thread_pool::thread_pool(thread_pool_options options)
+    : batch_size_(options.batch_size == 0 ? 1 : options.batch_size),
+      spin_count_(options.spin_count),
+      yield_count_(options.yield_count),
+      flush_window_(options.flush_coalesce_window),
+      flush_bytes_(options.flush_coalesce_bytes),
+      sample_threshold_(options.sample_threshold > 0 ? options.sample_threshold
+                                                     : options.queue_size / 4 * 3),
+      sampler_(options.sample_rate, options.sample_burst),
+      queue_latency_enabled_(options.queue_latency),
+      polled_(options.polled) {
+    if (!polled_ && (options.threads_n == 0 || options.threads_n > 1000)) {
         throw_spdlog_ex(
             "spdlog::thread_pool(): invalid threads_n param (valid "
             "range is 1-1000)");
     }
+    elastic_ = !polled_ && options.max_threads_n > options.threads_n;
+    if (elastic_ && options.max_threads_n > 1000) {
+        throw_spdlog_ex(
+            "spdlog::thread_pool(): invalid max_threads_n param (valid "
+            "range is 1-1000)");
+    }
+    std::vector<std::vector<int>> nodes;
+    if (options.numa_aware && !elastic_ && !polled_) {
+        nodes = os::numa_node_cpus();
+    }
+    numa_ = nodes.size() > 1;
+    size_t threads_n = polled_ ? 0 : options.threads_n;
+    if (numa_) {
+        threads_n = nodes.size();
+        make_node_queues_(options, nodes);
+    } else if (elastic_) {
+        min_threads_ = threads_n;
+        grow_threshold_ =
+            options.grow_threshold > 0 ? options.grow_threshold : options.queue_size / 2;
+        idle_timeout_ = options.idle_timeout;
+        active_ = threads_n;
+        slot_in_flight_.reset(new std::atomic<size_t>[options.max_threads_n]);
+        slot_running_.assign(options.max_threads_n, false);
+        for (size_t i = 0; i < options.max_threads_n; i++) {
+            slot_in_flight_[i] = 0;
+            slot_running_[i] = i < threads_n;
+            queues_.push_back(make_queue_(options));
+        }
+        // the workers may add threads as soon as they start
+        threads_.resize(options.max_threads_n);
+    } else {
+        sharded_ = options.sharded && threads_n > 1;
+        size_t queues_n = sharded_ ? threads_n : 1;
+        for (size_t i = 0; i < queues_n; i++) {
+            queues_.push_back(make_queue_(options));
+        }
+    }
+    if (polled_) {
+        poll_ctx_.reset(new worker_context(*queues_[0], batch_size_));
+#ifdef __linux__
+        poll_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (poll_fd_ < 0) {
+            throw_spdlog_ex("spdlog::thread_pool(): eventfd failed", errno);
+        }
+#endif
+    }
+
+    on_thread_start_ = [] {};
+    on_thread_stop_ = [] {};
+    if (options.on_thread_start) {
+        on_thread_start_ = std::move(options.on_thread_start);
+    }
+    if (options.on_thread_stop) {
+        on_thread_stop_ = std::move(options.on_thread_stop);
+    }
+    worker_options_ = options.worker;
+    size_t names_n = elastic_ ? options.max_threads_n : threads_n;
+
+    // wait for the workers to be set up, to report the failures to the caller
+    std::mutex startup_mutex;
+    std::condition_variable startup_cv;
+    size_t pending_workers = threads_n;
+    std::string startup_error;
     for (size_t i = 0; i < threads_n; i++) {
-        threads_.emplace_back([this, on_thread_start, on_thread_stop] {
-            on_thread_start();
-            this->thread_pool::worker_loop_();
-            on_thread_stop();
+        auto *q = queues_[queues_.size() > 1 ? i : 0].get();
+        auto cpus = numa_ ? nodes[i] : options.worker.cpus;
+        std::thread t([&, this, q, cpus, i, names_n] {
+            auto error = setup_worker_(worker_options_, cpus, i, names_n);
+            {
+                // notify under the lock: the constructor may return as soon as it is released
+                std::lock_guard<std::mutex> lock(startup_mutex);
+                if (startup_error.empty()) {
+                    startup_error = std::move(error);
+                }
+                pending_workers--;
+                startup_cv.notify_one();
+            }
+            on_thread_start_();
+            this->thread_pool::worker_loop_(*q, i);
+            on_thread_stop_();
         });
+        if (elastic_) {
+            threads_[i] = std::move(t);
+        } else {
+            threads_.push_back(std::move(t));
+        }
+    }
+    std::unique_lock<std::mutex> lock(startup_mutex);
+    startup_cv.wait(lock, [&] { return pending_workers == 0; });
+    if (!startup_error.empty()) {
+        lock.unlock();
+        stop_workers_();
+        throw_spdlog_ex("spdlog::thread_pool(): " + startup_error);
+    }
+}
+
+// apply the worker options to the calling thread.
+// return a description of the first failed setting, or empty string on success.
+SPDLOG_INLINE std::string thread_pool::setup_worker_(const async_worker_options &options,
+                                                     const std::vector<int> &cpus,
+                                                     size_t index,
+                                                     size_t threads_n) {
+    if (!cpus.empty() && !os::set_thread_affinity(cpus)) {
+        return "failed setting the workers cpu affinity";
+    }
+    if (!os::set_thread_sched_policy(options.sched_policy, options.sched_priority)) {
+        return "failed setting the workers scheduling policy";
+    }
+    if (options.nice != 0 && !os::set_thread_nice(options.nice)) {
+        return "failed setting the workers nice value";
+    }
+    if (!options.name.empty()) {
+        auto name = threads_n > 1 ? options.name + std::to_string(index) : options.name;
+        if (!os::set_thread_name(name)) {
+            return "failed setting the workers name";
+        }
     }
+    return std::string();
 }
 
+// build one queue per numa node. the memory of a queue is placed on its node by the kernel
+// on first touch, so the constructing thread is moved to the node while building the queue.
+SPDLOG_INLINE void thread_pool::make_node_queues_(const thread_pool_options &options,
+                                                  const std::vector<std::vector<int>> &nodes) {
+    struct affinity_restorer {
+        std::vector<int> cpus = os::thread_affinity();
+        ~affinity_restorer() {
+            if (!cpus.empty()) {
+                os::set_thread_affinity(cpus);
+            }
+        }
+    } restorer;
+
+    for (size_t node = 0; node < nodes.size(); node++) {
+        for (auto cpu : nodes[node]) {
+            auto index = static_cast<size_t>(cpu);
+            if (index >= cpu_node_.size()) {
+                cpu_node_.resize(index + 1, 0);
+            }
+            cpu_node_[index] = node;
+        }
+        os::set_thread_affinity(nodes[node]);
+        queues_.push_back(make_queue_(options));
+    }
+}
+
+SPDLOG_INLINE std::unique_ptr<async_queue> thread_pool::make_queue_(
+    const thread_pool_options &options) {
+    switch (options.queue_type) {
+        case async_queue_type::priority_lanes:
+            return make_lanes_queue_(options);
+        case async_queue_type::per_thread:
+#ifndef SPDLOG_NO_TLS
+            return details::make_unique<async_queue_adapter<per_thread_q_type>>(
+                options.queue_size, options.round_robin);
+#endif
+            // without thread local storage, fall back to the single lock free queue
+        case async_queue_type::lock_free:
+            return details::make_unique<async_queue_adapter<lockfree_q_type>>(
+                options.queue_size, queue_allocator(options.huge_pages));
+        default:
+            return details::make_unique<async_queue_adapter<q_type>>(
+                options.queue_size, queue_allocator(options.huge_pages));
+    }
+}
+
+SPDLOG_INLINE std::unique_ptr<async_queue> thread_pool::make_lanes_queue_(
+    const thread_pool_options &options) {
+    auto lanes = options.lanes;
+    if (lanes.empty()) {
+        lanes = {{level::trace, options.queue_size},
+                 {level::info, options.queue_size},
+                 {level::err, options.queue_size}};
+    }
+    std::sort(lanes.begin(), lanes.end(), [](const async_lane &l, const async_lane &r) {
+        return l.min_level < r.min_level;
+    });
+
+    std::vector<size_t> lane_sizes;
+    std::vector<level::level_enum> min_levels;
+    for (auto &lane : lanes) {
+        if (lane.size == 0) {
+            throw_spdlog_ex("spdlog::thread_pool(): invalid lane size (must be above 0)");
+        }
+        lane_sizes.push_back(lane.size);
+        min_levels.push_back(lane.min_level);
+    }
+    // control messages go to the lowest lane, behind the messages logged before them
+    auto lane_of = [min_levels](const async_msg &msg) -> size_t {
+        if (msg.msg_type != async_msg_type::log) {
+            return 0;
+        }
+        size_t lane = 0;
+        while (lane + 1 < min_levels.size() && msg.level >= min_levels[lane + 1]) {
+            lane++;
+        }
+        return lane;
+    };
+    return details::make_unique<async_queue_adapter<lanes_q_type>>(lane_sizes, lane_of);
+}
+
+SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items,
+                                       size_t threads_n,
+                                       std::function<void()> on_thread_start,
+                                       std::function<void()> on_thread_stop)
+    : thread_pool(thread_pool_options(
+          q_max_items, threads_n, std::move(on_thread_start), std::move(on_thread_stop))) {}
+
 SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items,
                                        size_t threads_n,
                                        std::function<void()> on_thread_start)
@@ -41,24 +255,86 @@ SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items, size_t threads_n)
     : thread_pool(
           q_max_items, threads_n, [] {}, [] {}) {}
 
-// message all threads to terminate gracefully join them
 SPDLOG_INLINE thread_pool::~thread_pool() {
-    SPDLOG_TRY {
+    SPDLOG_TRY { stop_workers_(); }
+    SPDLOG_CATCH_STD
+#ifdef __linux__
+    if (poll_fd_ >= 0) {
+        ::close(poll_fd_);
+    }
+#endif
+}
+
+SPDLOG_INLINE size_t thread_pool::shutdown(std::chrono::milliseconds timeout,
+                                          level::level_enum skip_below) {
+    auto now = std::chrono::steady_clock::now();
+    skip_point_ = now + timeout / 2;
+    deadline_ = now + timeout;
+    skip_below_ = skip_below;
+    draining_.store(true, std::memory_order_release);
+    stopped_.store(true, std::memory_order_relaxed);
+    stop_workers_();
+    wake_waiters_();  // their messages are dropped
+
+    size_t left = 0;
+    for (auto &q : queues_) {
+        left += q->size();
+    }
+    return abandoned_.load(std::memory_order_relaxed) + left;
+}
+
+// level below which the workers skip log messages. none, unless shutting down.
+SPDLOG_INLINE level::level_enum thread_pool::skip_level_() const {
+    if (!draining_.load(std::memory_order_acquire)) {
+        return level::trace;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline_) {
+        return level::n_levels;
+    }
+    return now >= skip_point_ ? skip_below_ : level::trace;
+}
+
+// message all threads to terminate gracefully join them
+SPDLOG_INLINE void thread_pool::stop_workers_() {
+    if (polled_) {
+        // process what is left, as the workers would
+        std::lock_guard<std::mutex> lock(poll_mutex_);
+        poll_((std::numeric_limits<size_t>::max)());
+        flush_due_(*poll_ctx_, true);
+        return;
+    }
+    if (elastic_) {
+        // no worker is added or stops by itself from now on
+        std::lock_guard<std::mutex> lock(elastic_mutex_);
+        stopping_ = true;
+        for (size_t i = 0; i < slot_running_.size(); i++) {
+            if (slot_running_[i]) {
+                queues_[i]->enqueue(async_msg(async_msg_type::terminate),
+                                    async_overflow_policy::block);
+            }
+        }
+    } else {
         for (size_t i = 0; i < threads_.size(); i++) {
-            post_async_msg_(async_msg(async_msg_type::terminate), async_overflow_policy::block);
+            auto &q = *queues_[queues_.size() > 1 ? i : 0];
+            q.enqueue(async_msg(async_msg_type::terminate), async_overflow_policy::block);
         }
+    }
 
-        for (auto &t : threads_) {
+    for (auto &t : threads_) {
+        if (t.joinable()) {
             t.join();
         }
     }
-    SPDLOG_CATCH_STD
+    threads_.clear();
 }
 
 void SPDLOG_INLINE thread_pool::post_log(async_logger_ptr &&worker_ptr,
                                          const details::log_msg &msg,
-                                         async_overflow_policy overflow_policy) {
-    async_msg async_m(std::move(worker_ptr), async_msg_type::log, msg);
+                                         async_overflow_policy overflow_policy,
+                                         deferred_format_fn format_fn) {
+    bool own_name = msg.logger_name.data() == worker_ptr->name().data();
+    async_msg async_m(std::move(worker_ptr), async_msg_type::log, msg, format_fn, own_name);
     post_async_msg_(std::move(async_m), overflow_policy);
 }
 
@@ -67,60 +343,786 @@ void SPDLOG_INLINE thread_pool::post_flush(async_logger_ptr &&worker_ptr,
     post_async_msg_(async_msg(std::move(worker_ptr), async_msg_type::flush), overflow_policy);
 }
 
-size_t SPDLOG_INLINE thread_pool::overrun_counter() { return q_.overrun_counter(); }
+void SPDLOG_INLINE thread_pool::post_log(async_logger &logger,
+                                         const details::log_msg &msg,
+                                         async_overflow_policy overflow_policy,
+                                         deferred_format_fn format_fn,
+                                         std::shared_ptr<const void> payload_owner) {
+    if (polled_ && overflow_policy == async_overflow_policy::block) {
+        overflow_policy = async_overflow_policy::discard_new;
+    }
+    if (overflow_policy == async_overflow_policy::sample && !admit_sampled_(logger, msg)) {
+        return;
+    }
+    quota_ticket quota;
+    // elastic pools count every message, in attach_()
+    if (!elastic_ && logger.queue_quota_ > 0 && !acquire_quota_(logger, overflow_policy, quota)) {
+        return;
+    }
+    post_log_(logger, msg, overflow_policy, format_fn, std::move(quota), std::move(payload_owner));
+}
+
+// count a new message against the logger's quota. if the logger already reached it, wait
+// for room with the block policy, or count the message as overrun (and return false).
+bool SPDLOG_INLINE thread_pool::acquire_quota_(async_logger &logger,
+                                               async_overflow_policy overflow_policy,
+                                               quota_ticket &quota) {
+    auto in_flight = logger.in_flight_.load(std::memory_order_relaxed);
+    for (;;) {
+        if (in_flight < logger.queue_quota_) {
+            if (logger.in_flight_.compare_exchange_weak(in_flight, in_flight + 1,
+                                                        std::memory_order_relaxed)) {
+                quota = quota_ticket(&logger.in_flight_);
+                return true;
+            }
+        } else if (overflow_policy == async_overflow_policy::block) {
+            std::this_thread::yield();
+            in_flight = logger.in_flight_.load(std::memory_order_relaxed);
+        } else {
+            logger.overrun_counter_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+}
+
+// sample overflow policy: under pressure, admit the messages the token bucket allows.
+// once the pressure eased, report the messages dropped so far by the logger before its
+// next message.
+bool SPDLOG_INLINE thread_pool::admit_sampled_(async_logger &logger,
+                                               const details::log_msg &msg) {
+    if (queue_of_(&logger).size() < sample_threshold_) {
+        if (logger.sampled_out_.load(std::memory_order_relaxed) > 0) {
+            auto dropped = logger.sampled_out_.exchange(0, std::memory_order_relaxed);
+            auto text = std::to_string(dropped) + " messages dropped";
+            details::log_msg report(msg.time, source_loc{}, logger.name(), level::warn,
+                                    string_view_t(text.data(), text.size()));
+            report.tsc_time = msg.tsc_time;
+            post_log_(logger, report, async_overflow_policy::sample, nullptr, quota_ticket());
+        }
+        return true;
+    }
+    if (sampler_.try_acquire()) {
+        return true;
+    }
+    logger.sampled_out_.fetch_add(1, std::memory_order_relaxed);
+    sampled_out_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void SPDLOG_INLINE thread_pool::post_log_(async_logger &logger,
+                                          const details::log_msg &msg,
+                                          async_overflow_policy overflow_policy,
+                                          deferred_format_fn format_fn,
+                                          quota_ticket &&quota,
+                                          std::shared_ptr<const void> payload_owner) {
+    // the logger outlives its queued messages (kept alive by them, or draining them when
+    // destroyed), so they reference its name instead of copying it
+    bool own_name = msg.logger_name.data() == logger.name().data();
+    auto async_m = holds_loggers() ? async_msg(logger.shared_from_this(), async_msg_type::log,
+                                               msg, format_fn, own_name)
+                                   : async_msg(&logger, async_msg_type::log, msg, format_fn,
+                                               own_name);
+    async_m.quota = std::move(quota);
+    async_m.payload_owner = std::move(payload_owner);
+    post_async_msg_(std::move(async_m), overflow_policy);
+}
+
+void SPDLOG_INLINE thread_pool::post_flush(async_logger &logger,
+                                           async_overflow_policy overflow_policy) {
+    if (holds_loggers()) {
+        post_flush(logger.shared_from_this(), overflow_policy);
+        return;
+    }
+    post_async_msg_(async_msg(&logger, async_msg_type::flush), overflow_policy);
+}
+
+bool SPDLOG_INLINE thread_pool::try_post(async_msg &msg) {
+    if (stopped_.load(std::memory_order_relaxed)) {
+        abandoned_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    // the message is counted (and timestamped) on the first try, and keeps its count until it
+    // is posted
+    if (queue_latency_enabled_ && msg.msg_type == async_msg_type::log &&
+        msg.enqueue_time == std::chrono::steady_clock::time_point{}) {
+        msg.enqueue_time = std::chrono::steady_clock::now();
+    }
+    if (msg.worker != nullptr && !msg.quota.held()) {
+        auto &logger = *msg.worker;
+        if (elastic_) {
+            size_t slot = 0;
+            if (!attach_(msg, async_overflow_policy::discard_new, slot)) {
+                return true;
+            }
+        } else if (logger.queue_quota_ > 0 &&
+                   !acquire_quota_(logger, async_overflow_policy::discard_new, msg.quota)) {
+            return true;
+        }
+    }
+    if (!queue_of_(msg.worker).try_enqueue(std::move(msg))) {
+        return false;
+    }
+    if (polled_) {
+        signal_poll_();
+    }
+    msg.enqueue_time = std::chrono::steady_clock::time_point{};  // for the next message
+    return true;
+}
+
+// the waiter is counted before trying, so a worker making room right after the try sees it
+// (see wake_waiters_).
+bool SPDLOG_INLINE thread_pool::post_or_wait(queue_waiter &waiter) {
+    std::lock_guard<std::mutex> lock(waiters_mutex_);
+    waiters_n_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (try_post(waiter.msg)) {
+        waiters_n_.fetch_sub(1);
+        return true;
+    }
+    waiters_.push_back(&waiter);
+    return false;
+}
+
+void SPDLOG_INLINE thread_pool::cancel_wait(queue_waiter &waiter) {
+    std::lock_guard<std::mutex> lock(waiters_mutex_);
+    auto it = std::find(waiters_.begin(), waiters_.end(), &waiter);
+    if (it != waiters_.end()) {
+        waiters_.erase(it);
+        waiters_n_.fetch_sub(1);
+    }
+}
+
+// post the messages of the waiters which now fit in the queue, and wake them (after
+// releasing the lock: they may wait again right away).
+void SPDLOG_INLINE thread_pool::wake_waiters_() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_n_.load() == 0) {
+        return;
+    }
+    std::vector<queue_waiter *> woken;
+    {
+        std::lock_guard<std::mutex> lock(waiters_mutex_);
+        for (auto it = waiters_.begin(); it != waiters_.end();) {
+            if (try_post((*it)->msg)) {
+                woken.push_back(*it);
+                it = waiters_.erase(it);
+                waiters_n_.fetch_sub(1);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto *waiter : woken) {
+        waiter->wake(waiter);
+    }
+}
+
+bool SPDLOG_INLINE thread_pool::holds_loggers() const {
+    return !sharded_ && !elastic_ && threads_.size() > 1;
+}
+
+// post a barrier behind the logger's messages and wait until a worker reaches it.
+// the barrier is posted again if it takes too long, in case it was overrun by
+// other loggers' messages.
+void SPDLOG_INLINE thread_pool::drain_logger(async_logger &logger) {
+    if (holds_loggers()) {
+        return;
+    }
+    if (polled_) {
+        // process everything queued, and forget the logger's coalesced flush
+        std::lock_guard<std::mutex> lock(poll_mutex_);
+        poll_((std::numeric_limits<size_t>::max)());
+        auto &ctx = *poll_ctx_;
+        if (auto *state = find_flush_state_(ctx, &logger)) {
+            if (state->pending) {
+                logger.backend_flush_();
+            }
+            *state = std::move(ctx.flushes.back());
+            ctx.flushes.pop_back();
+        }
+        return;
+    }
+    std::vector<size_t> ids;
+    bool drained = false;
+    while (!drained && !stopped_.load(std::memory_order_relaxed)) {
+        async_msg barrier(&logger, async_msg_type::barrier);
+        {
+            std::lock_guard<std::mutex> lock(drain_mutex_);
+            barrier.barrier_id = ++last_barrier_id_;
+            pending_barriers_.push_back(barrier.barrier_id);
+            ids.push_back(barrier.barrier_id);
+        }
+        post_async_msg_(std::move(barrier), async_overflow_policy::block);
+
+        std::unique_lock<std::mutex> lock(drain_mutex_);
+        auto is_done = [this, &ids] {
+            return std::find_first_of(done_barriers_.begin(), done_barriers_.end(), ids.begin(),
+                                      ids.end()) != done_barriers_.end();
+        };
+        drained = drain_cv_.wait_for(lock, std::chrono::milliseconds(100), is_done);
+    }
+
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    auto is_mine = [&ids](size_t id) {
+        return std::find(ids.begin(), ids.end(), id) != ids.end();
+    };
+    pending_barriers_.erase(
+        std::remove_if(pending_barriers_.begin(), pending_barriers_.end(), is_mine),
+        pending_barriers_.end());
+    done_barriers_.erase(std::remove_if(done_barriers_.begin(), done_barriers_.end(), is_mine),
+                         done_barriers_.end());
+}
+
+size_t SPDLOG_INLINE thread_pool::overrun_counter() {
+    size_t total = 0;
+    for (auto &q : queues_) {
+        total += q->overrun_counter();
+    }
+    return total;
+}
 
-void SPDLOG_INLINE thread_pool::reset_overrun_counter() { q_.reset_overrun_counter(); }
+void SPDLOG_INLINE thread_pool::reset_overrun_counter() {
+    for (auto &q : queues_) {
+        q->reset_overrun_counter();
+    }
+}
 
-size_t SPDLOG_INLINE thread_pool::discard_counter() { return q_.discard_counter(); }
+size_t SPDLOG_INLINE thread_pool::discard_counter() {
+    size_t total = 0;
+    for (auto &q : queues_) {
+        total += q->discard_counter();
+    }
+    return total;
+}
 
-void SPDLOG_INLINE thread_pool::reset_discard_counter() { q_.reset_discard_counter(); }
+void SPDLOG_INLINE thread_pool::reset_discard_counter() {
+    for (auto &q : queues_) {
+        q->reset_discard_counter();
+    }
+}
 
-size_t SPDLOG_INLINE thread_pool::queue_size() { return q_.size(); }
+size_t SPDLOG_INLINE thread_pool::queue_size() {
+    size_t total = 0;
+    for (auto &q : queues_) {
+        total += q->size();
+    }
+    return total;
+}
+
+size_t SPDLOG_INLINE thread_pool::queue_high_water_mark() {
+    size_t total = 0;
+    for (auto &q : queues_) {
+        total += q->high_water_mark();
+    }
+    return total;
+}
+
+void SPDLOG_INLINE thread_pool::reset_queue_high_water_mark() {
+    for (auto &q : queues_) {
+        q->reset_high_water_mark();
+    }
+}
 
 void SPDLOG_INLINE thread_pool::post_async_msg_(async_msg &&new_msg,
                                                 async_overflow_policy overflow_policy) {
-    if (overflow_policy == async_overflow_policy::block) {
-        q_.enqueue(std::move(new_msg));
-    } else if (overflow_policy == async_overflow_policy::overrun_oldest) {
-        q_.enqueue_nowait(std::move(new_msg));
-    } else {
-        assert(overflow_policy == async_overflow_policy::discard_new);
-        q_.enqueue_if_have_room(std::move(new_msg));
+    if (stopped_.load(std::memory_order_relaxed)) {
+        if (new_msg.msg_type == async_msg_type::log) {
+            abandoned_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    if (queue_latency_enabled_ && new_msg.msg_type == async_msg_type::log) {
+        new_msg.enqueue_time = std::chrono::steady_clock::now();
+    }
+    if (elastic_ && new_msg.worker != nullptr) {
+        size_t slot = 0;
+        if (attach_(new_msg, overflow_policy, slot)) {
+            queues_[slot]->enqueue(std::move(new_msg), overflow_policy);
+        }
+        return;
+    }
+    if (polled_) {
+        // the poller may be this very thread
+        if (overflow_policy == async_overflow_policy::block) {
+            overflow_policy = async_overflow_policy::discard_new;
+        }
+        queues_[0]->enqueue(std::move(new_msg), overflow_policy);
+        signal_poll_();
+        return;
+    }
+    queue_of_(new_msg.worker).enqueue(std::move(new_msg), overflow_policy);
+}
+
+// elastic pool: count the message against its logger and the logger's worker, attaching the
+// logger to the next active worker if it has no message queued. a worker stops only once no
+// message is counted against it, so the count of the worker is taken first and the logger's
+// count only if the worker is still active (or still has messages of this logger).
+// return false if the logger has reached its queue quota and the message is dropped.
+bool SPDLOG_INLINE thread_pool::attach_(async_msg &msg,
+                                        async_overflow_policy overflow_policy,
+                                        size_t &slot) {
+    auto &logger = *msg.worker;
+    bool quota = msg.msg_type == async_msg_type::log && logger.queue_quota_ > 0;
+    auto in_flight = logger.in_flight_.load();
+    for (;;) {
+        auto count = in_flight & count_mask;
+        if (quota && count >= logger.queue_quota_) {
+            if (overflow_policy != async_overflow_policy::block) {
+                logger.overrun_counter_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            std::this_thread::yield();
+            in_flight = logger.in_flight_.load();
+            continue;
+        }
+        size_t next;
+        if (count == 0) {
+            auto active = active_.load();
+            slot = next_slot_.fetch_add(1, std::memory_order_relaxed) % active;
+            slot_in_flight_[slot].fetch_add(1);
+            if (slot >= active_.load()) {
+                // the worker is stopping
+                slot_in_flight_[slot].fetch_sub(1);
+                in_flight = logger.in_flight_.load();
+                continue;
+            }
+            next = (slot << slot_shift) | 1;
+        } else {
+            slot = in_flight >> slot_shift;
+            slot_in_flight_[slot].fetch_add(1);
+            next = in_flight + 1;
+        }
+        if (logger.in_flight_.compare_exchange_weak(in_flight, next)) {
+            msg.quota = quota_ticket(&logger.in_flight_, &slot_in_flight_[slot]);
+            return true;
+        }
+        slot_in_flight_[slot].fetch_sub(1);
     }
 }
 
-void SPDLOG_INLINE thread_pool::worker_loop_() {
-    while (process_next_msg_()) {
+// elastic pool: the queue of the worker the logger was last attached to.
+// numa aware pool: the queue of the node the caller is running on.
+// sharded pool: each logger always goes to the same worker. the pointer bits are mixed
+// since the low ones are the same for all loggers (alignment).
+SPDLOG_INLINE async_queue &thread_pool::queue_of_(const async_logger *logger) {
+    if (elastic_) {
+        return *queues_[logger != nullptr ? logger->in_flight_.load() >> slot_shift : 0];
+    }
+    if (numa_) {
+        auto cpu = static_cast<size_t>(os::current_cpu());
+        return *queues_[cpu < cpu_node_.size() ? cpu_node_[cpu] : 0];
     }
+    if (!sharded_) {
+        return *queues_[0];
+    }
+    auto h = reinterpret_cast<std::uintptr_t>(logger);
+    h ^= (h >> 7) ^ (h >> 17);
+    return *queues_[static_cast<size_t>(h % queues_.size())];
 }
 
-// process next message in the queue
+size_t SPDLOG_INLINE thread_pool::coalesced_flush_counter() {
+    return coalesced_flushes_.load(std::memory_order_relaxed);
+}
+
+void SPDLOG_INLINE thread_pool::reset_coalesced_flush_counter() {
+    coalesced_flushes_.store(0, std::memory_order_relaxed);
+}
+
+size_t SPDLOG_INLINE thread_pool::sampled_out_counter() {
+    return sampled_out_.load(std::memory_order_relaxed);
+}
+
+void SPDLOG_INLINE thread_pool::reset_sampled_out_counter() {
+    sampled_out_.store(0, std::memory_order_relaxed);
+}
+
+latency_snapshot SPDLOG_INLINE thread_pool::queue_latency() const {
+    return queue_latency_.snapshot();
+}
+
+void SPDLOG_INLINE thread_pool::reset_queue_latency() { queue_latency_.reset(); }
+
+void SPDLOG_INLINE thread_pool::worker_loop_(async_queue &q, size_t slot) {
+    worker_context ctx(q, batch_size_);
+    ctx.slot = slot;
+    ctx.may_retire = elastic_ && slot >= min_threads_;
+    ctx.last_active = std::chrono::steady_clock::now();
+    while (process_next_batch_(ctx)) {
+    }
+}
+
+size_t SPDLOG_INLINE thread_pool::workers_count() {
+    if (!elastic_) {
+        return threads_.size();
+    }
+    std::lock_guard<std::mutex> lock(elastic_mutex_);
+    return static_cast<size_t>(std::count(slot_running_.begin(), slot_running_.end(), true));
+}
+
+void SPDLOG_INLINE thread_pool::visit_queued_unsafe(void (*fn)(const async_msg &, void *),
+                                                    void *context) const {
+    for (auto &q : queues_) {
+        q->visit_unsafe(fn, context);
+    }
+}
+
+bool SPDLOG_INLINE thread_pool::claim_exclusive(sinks::sink &sink) {
+    if (elastic_ || threads_.size() != 1) {
+        return false;
+    }
+    return sink.claim_exclusive(threads_[0].get_id());
+}
+
+// elastic pool: start the worker of a slot that is not running
+void SPDLOG_INLINE thread_pool::start_worker_(size_t slot) {
+    if (threads_[slot].joinable()) {
+        threads_[slot].join();  // stopped by itself
+    }
+    threads_[slot] = std::thread([this, slot] {
+        // the setup failures can't be reported here. the worker runs anyway.
+        setup_worker_(worker_options_, worker_options_.cpus, slot, threads_.size());
+        on_thread_start_();
+        worker_loop_(*queues_[slot], slot);
+        on_thread_stop_();
+    });
+}
+
+// elastic pool: activate the next slot, starting its worker unless it is still running
+void SPDLOG_INLINE thread_pool::grow_() {
+    std::lock_guard<std::mutex> lock(elastic_mutex_);
+    auto slot = active_.load();
+    if (stopping_ || slot >= slot_running_.size()) {
+        return;
+    }
+    if (!slot_running_[slot]) {
+        SPDLOG_TRY { start_worker_(slot); }
+        SPDLOG_CATCH_STD
+        if (!threads_[slot].joinable()) {
+            return;  // failed creating the thread
+        }
+        slot_running_[slot] = true;
+    }
+    active_.store(slot + 1);
+}
+
+// elastic pool: called by an idle worker above min_threads_. only the last active worker
+// may stop: it stops taking new loggers first, and stops once it has no message left.
+// return true if the worker should stop.
+bool SPDLOG_INLINE thread_pool::try_retire_(size_t slot) {
+    std::lock_guard<std::mutex> lock(elastic_mutex_);
+    if (stopping_) {
+        return false;
+    }
+    auto active = active_.load();
+    if (active > slot + 1) {
+        return false;
+    }
+    if (active == slot + 1) {
+        active_.store(slot);
+    }
+    if (slot_in_flight_[slot].load() > 0) {
+        return false;
+    }
+    slot_running_[slot] = false;
+    return true;
+}
+
+size_t SPDLOG_INLINE thread_pool::dequeue_batch_(worker_context &ctx) {
+    auto &q = ctx.q;
+    auto &batch = ctx.batch;
+    // don't sleep past the end of the window of a pending flush
+    bool has_deadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    for (auto &state : ctx.flushes) {
+        if (state.pending && (!has_deadline || state.last_flush + flush_window_ < deadline)) {
+            deadline = state.last_flush + flush_window_;
+            has_deadline = true;
+        }
+    }
+    // nor past the idle timeout of an elastic worker that may stop
+    if (ctx.may_retire && (!has_deadline || ctx.last_active + idle_timeout_ < deadline)) {
+        deadline = ctx.last_active + idle_timeout_;
+        has_deadline = true;
+    }
+
+    for (size_t i = 0; i < spin_count_; i++) {
+        size_t n = q.try_dequeue_bulk(batch.data(), batch.size());
+        if (n > 0) {
+            return n;
+        }
+    }
+    for (size_t i = 0; i < yield_count_; i++) {
+        size_t n = q.try_dequeue_bulk(batch.data(), batch.size());
+        if (n > 0) {
+            return n;
+        }
+        std::this_thread::yield();
+    }
+    if (!has_deadline) {
+        return q.dequeue_bulk(batch.data(), batch.size());
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (deadline <= now) {
+        return q.try_dequeue_bulk(batch.data(), batch.size());
+    }
+    auto wait_duration = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now) +
+                         std::chrono::milliseconds(1);
+    if (!q.dequeue_for(batch[0], wait_duration)) {
+        return 0;
+    }
+    return 1 + q.try_dequeue_bulk(batch.data() + 1, batch.size() - 1);
+}
+
+// process next batch of messages in the queue
 // return true if this thread should still be active (while no terminate msg
 // was received)
-bool SPDLOG_INLINE thread_pool::process_next_msg_() {
-    async_msg incoming_async_msg;
-    q_.dequeue(incoming_async_msg);
+bool SPDLOG_INLINE thread_pool::process_next_batch_(worker_context &ctx) {
+    return process_batch_(ctx, dequeue_batch_(ctx));
+}
 
-    switch (incoming_async_msg.msg_type) {
-        case async_msg_type::log: {
-            incoming_async_msg.worker_ptr->backend_sink_it_(incoming_async_msg);
-            return true;
-        }
-        case async_msg_type::flush: {
-            incoming_async_msg.worker_ptr->backend_flush_();
-            return true;
+bool SPDLOG_INLINE thread_pool::process_batch_(worker_context &ctx, size_t n) {
+    auto &batch = ctx.batch;
+    auto &log_msgs = ctx.log_msgs;
+    if (n > 0) {
+        wake_waiters_();
+    }
+    size_t terminate_count = 0;
+
+    for (size_t i = 0; i < n;) {
+        auto &incoming_async_msg = batch[i];
+        switch (incoming_async_msg.msg_type) {
+            case async_msg_type::log: {
+                // sink the run of consecutive messages of this logger together
+                log_msgs.clear();
+                size_t end = i;
+                size_t bytes = 0;
+                auto skip_level = skip_level_();
+                auto sink_time = queue_latency_enabled_ ? std::chrono::steady_clock::now()
+                                                        : std::chrono::steady_clock::time_point{};
+                // while shutting down, sink the messages one by one to skip the late ones
+                size_t max_end = draining_.load(std::memory_order_relaxed) ? i + 1 : n;
+                while (end < max_end && batch[end].msg_type == async_msg_type::log &&
+                       batch[end].worker == incoming_async_msg.worker) {
+                    if (batch[end].level < skip_level) {
+                        abandoned_.fetch_add(1, std::memory_order_relaxed);
+                    } else if (incoming_async_msg.worker->backend_format_(batch[end])) {
+                        if (queue_latency_enabled_) {
+                            queue_latency_.record(sink_time - batch[end].enqueue_time);
+                        }
+                        log_msgs.push_back(batch[end]);
+                        bytes += batch[end].payload.size();
+                    }
+                    end++;
+                }
+                if (!log_msgs.empty()) {
+                    incoming_async_msg.worker->backend_sink_batch_(log_msgs.data(),
+                                                                   log_msgs.size());
+                }
+                for (size_t k = i; k < end; k++) {
+                    batch[k].quota.release();
+                }
+                if (auto *state = find_flush_state_(ctx, incoming_async_msg.worker)) {
+                    state->bytes += bytes;
+                }
+                i = end;
+                break;
+            }
+            case async_msg_type::flush: {
+                if (flush_window_.count() > 0) {
+                    request_flush_(ctx, incoming_async_msg);
+                } else {
+                    incoming_async_msg.worker->backend_flush_();
+                }
+                incoming_async_msg.quota.release();
+                i++;
+                break;
+            }
+
+            case async_msg_type::barrier: {
+                // the logger is going away: flush it now if it has a pending flush
+                if (auto *state = find_flush_state_(ctx, incoming_async_msg.worker)) {
+                    if (state->pending) {
+                        incoming_async_msg.worker->backend_flush_();
+                    }
+                    *state = std::move(ctx.flushes.back());
+                    ctx.flushes.pop_back();
+                }
+                // the logger may be destroyed as soon as it is notified
+                incoming_async_msg.quota.release();
+                std::lock_guard<std::mutex> lock(drain_mutex_);
+                auto id = incoming_async_msg.barrier_id;
+                if (std::find(pending_barriers_.begin(), pending_barriers_.end(), id) !=
+                    pending_barriers_.end()) {
+                    done_barriers_.push_back(id);
+                    drain_cv_.notify_all();
+                }
+                i++;
+                break;
+            }
+
+            case async_msg_type::terminate: {
+                terminate_count++;
+                i++;
+                break;
+            }
+
+            default: {
+                assert(false);
+                i++;
+            }
         }
+    }
 
-        case async_msg_type::terminate: {
-            return false;
+    // release the loggers now. the buffers are kept for reuse by the next batch.
+    for (size_t i = 0; i < n; i++) {
+        batch[i].worker = nullptr;
+        batch[i].worker_ptr.reset();
+        batch[i].payload_owner.reset();
+    }
+
+    flush_due_(ctx, terminate_count > 0);
+    if (terminate_count == 0) {
+        return !elastic_ || elastic_step_(ctx, n);
+    }
+    // this worker took more than its own terminate message, pass the others on
+    for (size_t i = 1; i < terminate_count; i++) {
+        ctx.q.enqueue(async_msg(async_msg_type::terminate), async_overflow_policy::block);
+    }
+    return false;
+}
+
+size_t SPDLOG_INLINE thread_pool::poll(size_t max_msgs) {
+    if (!polled_) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(poll_mutex_);
+    return poll_(max_msgs);
+}
+
+// the signal is cleared before dequeuing: a message posted meanwhile signals again.
+size_t SPDLOG_INLINE thread_pool::poll_(size_t max_msgs) {
+    if (poll_signaled_.exchange(false)) {
+#ifdef __linux__
+        std::uint64_t count;
+        auto rv = ::read(poll_fd_, &count, sizeof(count));
+        (void)rv;
+#endif
+    }
+    auto &ctx = *poll_ctx_;
+    size_t processed = 0;
+    while (processed < max_msgs) {
+        auto n = ctx.q.try_dequeue_bulk(ctx.batch.data(),
+                                        (std::min)(ctx.batch.size(), max_msgs - processed));
+        if (n == 0) {
+            break;
         }
+        process_batch_(ctx, n);
+        processed += n;
+    }
+    if (processed == 0) {
+        flush_due_(ctx, false);
+    } else if (processed == max_msgs) {
+        signal_poll_();  // there may be more
+    }
+    return processed;
+}
+
+void SPDLOG_INLINE thread_pool::signal_poll_() {
+    if (poll_signaled_.load(std::memory_order_relaxed) || poll_signaled_.exchange(true)) {
+        return;
+    }
+#ifdef __linux__
+    std::uint64_t one = 1;
+    auto rv = ::write(poll_fd_, &one, sizeof(one));
+    (void)rv;
+#endif
+}
 
-        default: {
-            assert(false);
+// elastic pool: after a batch of n messages, add a worker if this one can't keep up, or stop
+// this one if it has been idle for idle_timeout_.
+// return true if this thread should still be active.
+bool SPDLOG_INLINE thread_pool::elastic_step_(worker_context &ctx, size_t n) {
+    if (active_.load(std::memory_order_relaxed) < slot_running_.size() &&
+        ctx.q.size() >= grow_threshold_) {
+        grow_();
+    }
+    if (!ctx.may_retire) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (n > 0 || !ctx.flushes.empty()) {
+        ctx.last_active = now;
+        return true;
+    }
+    if (now - ctx.last_active < idle_timeout_) {
+        return true;
+    }
+    ctx.last_active = now;  // check again after another timeout if it can't stop yet
+    return !try_retire_(ctx.slot);
+}
+
+SPDLOG_INLINE thread_pool::flush_state *thread_pool::find_flush_state_(
+    worker_context &ctx, const async_logger *logger) {
+    for (auto &state : ctx.flushes) {
+        if (state.logger == logger) {
+            return &state;
         }
     }
+    return nullptr;
+}
 
-    return true;
+// flush the logger now unless it was flushed less than flush_window_ ago (and didn't write
+// more than flush_bytes_ since). in that case the flush is done at the end of the window.
+void SPDLOG_INLINE thread_pool::request_flush_(worker_context &ctx, async_msg &msg) {
+    auto now = std::chrono::steady_clock::now();
+    auto *state = find_flush_state_(ctx, msg.worker);
+    if (state == nullptr) {
+        msg.worker->backend_flush_();
+        ctx.flushes.push_back(flush_state{msg.worker, nullptr, now, 0, false, quota_ticket()});
+        return;
+    }
+    if (state->pending) {
+        coalesced_flushes_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    bool over_budget = flush_bytes_ > 0 && state->bytes >= flush_bytes_;
+    if (now - state->last_flush >= flush_window_ || over_budget) {
+        msg.worker->backend_flush_();
+        state->last_flush = now;
+        state->bytes = 0;
+        return;
+    }
+    state->pending = true;
+    state->logger_ref = std::move(msg.worker_ptr);
+    state->ticket = std::move(msg.quota);
+}
+
+// run the pending flushes whose window ended (or all of them), and forget loggers flushed
+// long enough ago.
+void SPDLOG_INLINE thread_pool::flush_due_(worker_context &ctx, bool flush_all) {
+    if (ctx.flushes.empty()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ctx.flushes.size();) {
+        auto &state = ctx.flushes[i];
+        bool window_ended = now - state.last_flush >= flush_window_;
+        bool over_budget = flush_bytes_ > 0 && state.bytes >= flush_bytes_;
+        if (state.pending && (window_ended || over_budget || flush_all)) {
+            state.logger->backend_flush_();
+            state.pending = false;
+            state.logger_ref.reset();
+            state.ticket.release();
+            state.last_flush = now;
+            state.bytes = 0;
+        } else if (!state.pending && window_ended) {
+            state = std::move(ctx.flushes.back());
+            ctx.flushes.pop_back();
+            continue;
+        }
+        i++;
+    }
 }
 
 }  // namespace details
@@ -3,31 +3,156 @@
 
 #pragma once
 
+#include <spdlog/details/deferred_args.h>
+#include <spdlog/details/huge_page_allocator.h>
+#include <spdlog/details/latency_histogram.h>
 #include <spdlog/details/log_msg_buffer.h>
 #include <spdlog/details/mpmc_blocking_q.h>
+#include <spdlog/details/mpmc_lanes_q.h>
+#include <spdlog/details/mpmc_lockfree_q.h>
+#ifndef SPDLOG_NO_TLS
+    #include <spdlog/details/per_thread_q.h>
+#endif
 #include <spdlog/details/os.h>
+#include <spdlog/details/token_bucket.h>
 
+#include <atomic>
+#include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
 namespace spdlog {
 class async_logger;
+namespace sinks {
+class sink;
+}
 
 namespace details {
 
 using async_logger_ptr = std::shared_ptr<spdlog::async_logger>;
 
-enum class async_msg_type { log, flush, terminate };
+enum class async_msg_type { log, flush, terminate, barrier };
 
-// Async msg to move to/from the queue
-// Movable only. should never be copied
-struct async_msg : log_msg_buffer {
+// counts a queued message against its logger's queue quota (and against its worker in
+// elastic pools) until released or destroyed
+class quota_ticket {
+public:
+    quota_ticket() = default;
+    explicit quota_ticket(std::atomic<size_t> *in_flight,
+                          std::atomic<size_t> *worker_in_flight = nullptr)
+        : in_flight_(in_flight),
+          worker_in_flight_(worker_in_flight) {}
+
+    quota_ticket(const quota_ticket &) = delete;
+    quota_ticket &operator=(const quota_ticket &) = delete;
+
+    quota_ticket(quota_ticket &&other) SPDLOG_NOEXCEPT
+        : in_flight_(other.in_flight_),
+          worker_in_flight_(other.worker_in_flight_) {
+        other.in_flight_ = nullptr;
+        other.worker_in_flight_ = nullptr;
+    }
+
+    quota_ticket &operator=(quota_ticket &&other) SPDLOG_NOEXCEPT {
+        if (this != &other) {
+            release();
+            in_flight_ = other.in_flight_;
+            worker_in_flight_ = other.worker_in_flight_;
+            other.in_flight_ = nullptr;
+            other.worker_in_flight_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~quota_ticket() { release(); }
+
+    bool held() const { return in_flight_ != nullptr || worker_in_flight_ != nullptr; }
+
+    // the logger's count is released first: a worker is idle once its own count is zero
+    void release() {
+        if (in_flight_ != nullptr) {
+            in_flight_->fetch_sub(1);
+            in_flight_ = nullptr;
+        }
+        if (worker_in_flight_ != nullptr) {
+            worker_in_flight_->fetch_sub(1);
+            worker_in_flight_ = nullptr;
+        }
+    }
+
+private:
+    std::atomic<size_t> *in_flight_{nullptr};
+    std::atomic<size_t> *worker_in_flight_{nullptr};
+};
+
+// The fields of async_msg the queues and the worker look at, laid out before the message
+// (whose inline buffer would put them a few cache lines away from the other fields)
+struct async_msg_header {
     async_msg_type msg_type{async_msg_type::log};
+    async_logger *worker{nullptr};
+    // set if the payload holds packed arguments still to be formatted
+    deferred_format_fn format_fn{nullptr};
+    // owning reference to the worker, only set if the pool needs messages to keep their logger
+    // alive (see thread_pool::holds_loggers())
     async_logger_ptr worker_ptr;
+    // set if the logger has a queue quota, or if the pool is elastic. released when the
+    // message is processed, or dropped from the queue.
+    quota_ticket quota;
+    // barrier messages only: id of the drain request
+    size_t barrier_id{0};
+    // when the message was posted, only set if the pool records the queue latency
+    std::chrono::steady_clock::time_point enqueue_time;
+    // keeps a static payload alive while queued, if shared by the messages of several pools
+    // (see async_tee_logger). released with the logger when the message is processed.
+    std::shared_ptr<const void> payload_owner;
 
+    async_msg_header() = default;
+    async_msg_header(async_msg_type the_type,
+                     async_logger *worker_logger,
+                     deferred_format_fn fn = nullptr)
+        : msg_type{the_type},
+          worker{worker_logger},
+          format_fn{fn} {}
+
+// support for vs2013 move
+#if defined(_MSC_VER) && _MSC_VER <= 1800
+    async_msg_header(async_msg_header &&other)
+        : msg_type(other.msg_type),
+          worker(other.worker),
+          format_fn(other.format_fn),
+          worker_ptr(std::move(other.worker_ptr)),
+          quota(std::move(other.quota)),
+          barrier_id(other.barrier_id),
+          enqueue_time(other.enqueue_time),
+          payload_owner(std::move(other.payload_owner)) {}
+
+    async_msg_header &operator=(async_msg_header &&other) {
+        msg_type = other.msg_type;
+        worker = other.worker;
+        format_fn = other.format_fn;
+        worker_ptr = std::move(other.worker_ptr);
+        quota = std::move(other.quota);
+        barrier_id = other.barrier_id;
+        enqueue_time = other.enqueue_time;
+        payload_owner = std::move(other.payload_owner);
+        return *this;
+    }
+#else  // (_MSC_VER) && _MSC_VER <= 1800
+    async_msg_header(async_msg_header &&) = default;
+    async_msg_header &operator=(async_msg_header &&) = default;
+#endif
+};
+
+// Async msg to move to/from the queue
+// Movable only. should never be copied
+struct async_msg : async_msg_header, log_msg_buffer {
     async_msg() = default;
     ~async_msg() = default;
 
@@ -37,14 +162,12 @@ struct async_msg : log_msg_buffer {
 // support for vs2013 move
 #if defined(_MSC_VER) && _MSC_VER <= 1800
     async_msg(async_msg &&other)
-        : log_msg_buffer(std::move(other)),
-          msg_type(other.msg_type),
-          worker_ptr(std::move(other.worker_ptr)) {}
+        : async_msg_header(std::move(other)),
+          log_msg_buffer(std::move(other)) {}
 
     async_msg &operator=(async_msg &&other) {
+        *static_cast<async_msg_header *>(this) = std::move(other);
         *static_cast<log_msg_buffer *>(this) = std::move(other);
-        msg_type = other.msg_type;
-        worker_ptr = std::move(other.worker_ptr);
         return *this;
     }
 #else  // (_MSC_VER) && _MSC_VER <= 1800
@@ -52,26 +175,248 @@ struct async_msg : log_msg_buffer {
     async_msg &operator=(async_msg &&) = default;
 #endif
 
-    // construct from log_msg with given type
-    async_msg(async_logger_ptr &&worker, async_msg_type the_type, const details::log_msg &m)
-        : log_msg_buffer{m},
-          msg_type{the_type},
-          worker_ptr{std::move(worker)} {}
+    // construct from log_msg with given type. if borrow_logger_name, m.logger_name is the
+    // logger's own name, which outlives its queued messages: it is not copied.
+    async_msg(async_logger_ptr &&worker_logger,
+              async_msg_type the_type,
+              const details::log_msg &m,
+              deferred_format_fn fn = nullptr,
+              bool borrow_logger_name = false)
+        : async_msg_header{the_type, worker_logger.get(), fn},
+          log_msg_buffer{m, borrow_logger_name} {
+        worker_ptr = std::move(worker_logger);
+    }
 
-    async_msg(async_logger_ptr &&worker, async_msg_type the_type)
-        : log_msg_buffer{},
-          msg_type{the_type},
-          worker_ptr{std::move(worker)} {}
+    // same, without keeping the logger alive
+    async_msg(async_logger *worker_logger,
+              async_msg_type the_type,
+              const details::log_msg &m,
+              deferred_format_fn fn = nullptr,
+              bool borrow_logger_name = false)
+        : async_msg_header{the_type, worker_logger, fn},
+          log_msg_buffer{m, borrow_logger_name} {}
+
+    async_msg(async_logger_ptr &&worker_logger, async_msg_type the_type)
+        : async_msg{worker_logger.get(), the_type} {
+        worker_ptr = std::move(worker_logger);
+    }
+
+    async_msg(async_logger *worker_logger, async_msg_type the_type)
+        : async_msg_header{the_type, worker_logger},
+          log_msg_buffer{} {
+        // timestamp control messages too, so queues merging by time keep a flush behind the
+        // messages logged before it, and a terminate behind everything still queued.
+        time = the_type == async_msg_type::terminate ? log_clock::time_point::max() : os::now();
+    }
 
     explicit async_msg(async_msg_type the_type)
-        : async_msg{nullptr, the_type} {}
+        : async_msg{static_cast<async_logger *>(nullptr), the_type} {}
+
+    // format the packed arguments if formatting was deferred to the worker
+    void format_deferred() {
+        if (format_fn == nullptr) {
+            return;
+        }
+        memory_buf_t formatted;
+        format_fn(payload, formatted);
+        format_fn = nullptr;
+        replace_payload(string_view_t(formatted.data(), formatted.size()));
+    }
+};
+
+// Interface of the queues the thread pool can be built with
+class async_queue {
+public:
+    virtual ~async_queue() = default;
+    virtual void enqueue(async_msg &&item, async_overflow_policy overflow_policy) = 0;
+    // enqueue if there is room. return false (leaving the item untouched) otherwise.
+    virtual bool try_enqueue(async_msg &&item) = 0;
+    virtual void dequeue(async_msg &popped_item) = 0;
+    virtual bool dequeue_for(async_msg &popped_item, std::chrono::milliseconds wait_duration) = 0;
+    virtual size_t dequeue_bulk(async_msg *popped_items, size_t max_items) = 0;
+    virtual size_t try_dequeue_bulk(async_msg *popped_items, size_t max_items) = 0;
+    virtual size_t overrun_counter() = 0;
+    virtual void reset_overrun_counter() = 0;
+    virtual size_t discard_counter() = 0;
+    virtual void reset_discard_counter() = 0;
+    virtual size_t size() = 0;
+    virtual size_t high_water_mark() = 0;
+    virtual void reset_high_water_mark() = 0;
+    // call fn(item, context) on each queued item, without locking (see crash_dump.h)
+    virtual void visit_unsafe(void (*fn)(const async_msg &, void *), void *context) const = 0;
+};
+
+// Adapt any queue with the mpmc_blocking_queue api to the async_queue interface
+template <typename Q>
+class async_queue_adapter final : public async_queue {
+public:
+    template <typename... Args>
+    explicit async_queue_adapter(Args &&...args)
+        : q_(std::forward<Args>(args)...) {}
+
+    void enqueue(async_msg &&item, async_overflow_policy overflow_policy) override {
+        if (overflow_policy == async_overflow_policy::block) {
+            q_.enqueue(std::move(item));
+        } else if (overflow_policy == async_overflow_policy::overrun_oldest) {
+            q_.enqueue_nowait(std::move(item));
+        } else {
+            // the sample policy already dropped what it had to, never block for the rest
+            assert(overflow_policy == async_overflow_policy::discard_new ||
+                   overflow_policy == async_overflow_policy::sample);
+            q_.enqueue_if_have_room(std::move(item));
+        }
+    }
+
+    bool try_enqueue(async_msg &&item) override { return q_.try_enqueue(std::move(item)); }
+
+    void dequeue(async_msg &popped_item) override { q_.dequeue(popped_item); }
+
+    bool dequeue_for(async_msg &popped_item, std::chrono::milliseconds wait_duration) override {
+        return q_.dequeue_for(popped_item, wait_duration);
+    }
+
+    size_t dequeue_bulk(async_msg *popped_items, size_t max_items) override {
+        return q_.dequeue_bulk(popped_items, max_items);
+    }
+
+    size_t try_dequeue_bulk(async_msg *popped_items, size_t max_items) override {
+        return q_.try_dequeue_bulk(popped_items, max_items);
+    }
+
+    size_t overrun_counter() override { return q_.overrun_counter(); }
+    void reset_overrun_counter() override { q_.reset_overrun_counter(); }
+    size_t discard_counter() override { return q_.discard_counter(); }
+    void reset_discard_counter() override { q_.reset_discard_counter(); }
+    size_t size() override { return q_.size(); }
+    size_t high_water_mark() override { return q_.high_water_mark(); }
+    void reset_high_water_mark() override { q_.reset_high_water_mark(); }
+    void visit_unsafe(void (*fn)(const async_msg &, void *), void *context) const override {
+        q_.visit_unsafe([fn, context](const async_msg &item) { fn(item, context); });
+    }
+
+private:
+    Q q_;
+};
+
+// A message waiting for room in the queue, posted by a worker as soon as it made room (see
+// thread_pool::post_or_wait). wake is then called with the waiter, from the worker thread.
+struct queue_waiter {
+    async_msg msg;
+    void (*wake)(queue_waiter *waiter){nullptr};
+    void *context{nullptr};
+};
+
+// Lane of the priority_lanes queue: messages of min_level and above (up to the next lane's
+// min_level).
+struct async_lane {
+    level::level_enum min_level;
+    size_t size;
+};
+
+// Setup of the worker threads, done by each worker when it starts (before on_thread_start).
+// The thread_pool constructor throws if any of it fails (e.g. not permitted or not supported).
+struct async_worker_options {
+    // cpus the workers are allowed to run on. empty: unchanged.
+    // ignored by numa aware pools, whose workers run on the cpus of their node.
+    std::vector<int> cpus;
+    os::sched_policy sched_policy{os::sched_policy::inherit};
+    // priority of the fifo and round_robin policies (1-99 on linux)
+    int sched_priority{0};
+    // nice value (linux only). zero: unchanged.
+    int nice{0};
+    // thread name. if the pool has several workers, each name is suffixed by the worker index.
+    std::string name;
+};
+
+// Thread pool construction options.
+// The positional constructors of thread_pool are shortcuts for the first four fields.
+struct thread_pool_options {
+    thread_pool_options() = default;
+    thread_pool_options(size_t q_max_items,
+                        size_t n_threads,
+                        std::function<void()> thread_start = nullptr,
+                        std::function<void()> thread_stop = nullptr)
+        : queue_size(q_max_items),
+          threads_n(n_threads),
+          on_thread_start(std::move(thread_start)),
+          on_thread_stop(std::move(thread_stop)) {}
+
+    size_t queue_size{8192};
+    size_t threads_n{1};
+    std::function<void()> on_thread_start;
+    std::function<void()> on_thread_stop;
+    async_queue_type queue_type{async_queue_type::blocking};
+    // per_thread queue only: take the producers' rings in turn instead of oldest message first
+    bool round_robin{false};
+    // priority_lanes queue only. if empty, three lanes of queue_size each are used:
+    // trace and debug, info and warn, error and critical.
+    std::vector<async_lane> lanes;
+    // max number of messages a worker takes from the queue at once.
+    // consecutive messages of the same logger in a batch are passed to its sinks together.
+    size_t batch_size{64};
+    // how a worker waits for messages when the queue is empty: poll it spin_count times,
+    // then yield_count times yielding its time slice in between, then sleep until notified.
+    // spinning saves the wake up latency after quiet periods at the cost of burning a core.
+    size_t spin_count{0};
+    size_t yield_count{0};
+    // give each worker its own queue and pin each logger to one of them: no contention
+    // between workers on the queue or on the sinks, and the messages of a logger are always
+    // processed in order. the queue size is the size of each worker's queue.
+    bool sharded{false};
+    // on machines with several numa nodes, run one worker per node, pinned to the node's
+    // cpus, with its own queue allocated on the node. the producers post to the queue of the
+    // node they are running on. threads_n and sharded are ignored in this case.
+    // falls back to the options above if a single node is found (or not on linux).
+    bool numa_aware{false};
+    async_worker_options worker;
+    // sample overflow policy: the queue is under pressure once queue_size() reaches
+    // sample_threshold (three quarters of queue_size if zero). messages are then admitted at
+    // sample_rate per second at most (up to sample_burst at once), shared by all loggers.
+    size_t sample_threshold{0};
+    size_t sample_rate{100};
+    size_t sample_burst{10};
+    // blocking and lock_free queues only: map the queue storage on huge pages and pre-fault
+    // it, to save TLB misses and page faults with large queues (linux only, ignored elsewhere).
+    bool huge_pages{false};
+    // merge the flush requests of a logger arriving less than flush_coalesce_window after
+    // its last flush: the sinks are flushed once, when the window ends. if
+    // flush_coalesce_bytes is set, a logger that wrote that many bytes since its last flush
+    // is flushed without waiting for the window to end. disabled if the window is zero.
+    std::chrono::milliseconds flush_coalesce_window{0};
+    size_t flush_coalesce_bytes{0};
+    // elastic pool: start threads_n workers, each with its own queue of queue_size messages,
+    // and add workers up to max_threads_n while the queue of a worker still holds
+    // grow_threshold messages after a batch (half of queue_size if zero). the added workers
+    // stop again after idle_timeout without messages.
+    // an idle logger is given to the active workers in turn, and stays with its worker while
+    // it has messages queued, so the messages of a logger are always processed in order.
+    // disabled if max_threads_n is not above threads_n. sharded and numa_aware are ignored
+    // otherwise.
+    size_t max_threads_n{0};
+    size_t grow_threshold{0};
+    std::chrono::milliseconds idle_timeout{std::chrono::seconds(10)};
+    // record the time the messages wait from their post to their sinks (see
+    // thread_pool::queue_latency()). costs two reads of the steady clock per message.
+    bool queue_latency{false};
+    // no worker thread: the messages are processed by the application calling
+    // thread_pool::poll() (e.g. from its event loop, when thread_pool::poll_fd() is readable).
+    // logging never blocks, the block overflow policy being handled like discard_new.
+    // threads_n, sharded, numa_aware and max_threads_n are ignored.
+    bool polled{false};
 };
 
 class SPDLOG_API thread_pool {
 public:
     using item_type = async_msg;
-    using q_type = details::mpmc_blocking_queue<item_type>;
+    using queue_allocator = details::huge_page_allocator<item_type>;
+    using q_type = details::mpmc_blocking_queue<item_type, queue_allocator>;
+    using lockfree_q_type = details::mpmc_lockfree_queue<item_type, queue_allocator>;
+    using lanes_q_type = details::mpmc_lanes_queue<item_type>;
+#ifndef SPDLOG_NO_TLS
+    using per_thread_q_type = details::per_thread_queue<item_type>;
+#endif
 
+    explicit thread_pool(thread_pool_options options);
     thread_pool(size_t q_max_items,
                 size_t threads_n,
                 std::function<void()> on_thread_start,
@@ -85,28 +430,239 @@ public:
     thread_pool(const thread_pool &) = delete;
     thread_pool &operator=(thread_pool &&) = delete;
 
+    // format_fn is set if msg.payload holds packed arguments to format on the worker
     void post_log(async_logger_ptr &&worker_ptr,
                   const details::log_msg &msg,
-                  async_overflow_policy overflow_policy);
+                  async_overflow_policy overflow_policy,
+                  deferred_format_fn format_fn = nullptr);
     void post_flush(async_logger_ptr &&worker_ptr, async_overflow_policy overflow_policy);
+
+    // same as above, but the messages only keep a reference to the logger if holds_loggers().
+    // payload_owner keeps msg's static payload alive until the message is processed.
+    void post_log(async_logger &logger,
+                  const details::log_msg &msg,
+                  async_overflow_policy overflow_policy,
+                  deferred_format_fn format_fn = nullptr,
+                  std::shared_ptr<const void> payload_owner = nullptr);
+    void post_flush(async_logger &logger, async_overflow_policy overflow_policy);
+
+    // post the message if there is room in its queue right now, without blocking or
+    // discarding. return false (leaving the message untouched) otherwise. the logger's queue
+    // quota still applies: a message over it is dropped and counted by the logger.
+    bool try_post(async_msg &msg);
+    // same as above, but if there is no room keep the waiter until a worker made room and
+    // posted its message, or the pool was shut down. return true if the message was posted
+    // right away (and the waiter won't be woken).
+    bool post_or_wait(queue_waiter &waiter);
+    // forget a waiter that was not woken yet
+    void cancel_wait(queue_waiter &waiter);
+
+    // true if the messages posted by reference keep their logger alive. this is the case when
+    // the messages of a logger may be processed by several workers at once (shared queue and
+    // more than one thread). otherwise no reference counting is done per message, and loggers
+    // call drain_logger() when destroyed.
+    bool holds_loggers() const;
+
+    // block until the messages posted by reference so far by this logger are processed.
+    // must not be called from a worker thread.
+    void drain_logger(async_logger &logger);
+
     size_t overrun_counter();
     void reset_overrun_counter();
     size_t discard_counter();
     void reset_discard_counter();
     size_t queue_size();
+    // highest queue_size() since the pool was created or the mark was reset. with several
+    // queues, the sum of their marks (so at most the sum of the queue sizes).
+    // the counters and sizes above are read without locking the queues.
+    size_t queue_high_water_mark();
+    void reset_queue_high_water_mark();
+    // number of flush requests merged into another one (see flush_coalesce_window)
+    size_t coalesced_flush_counter();
+    void reset_coalesced_flush_counter();
+    // number of messages discarded by the sample overflow policy
+    size_t sampled_out_counter();
+    void reset_sampled_out_counter();
+    // time from the post of the messages to the call of their sinks (with that of the messages
+    // waiting for room in the queue). all zero unless thread_pool_options::queue_latency is set.
+    latency_snapshot queue_latency() const;
+    void reset_queue_latency();
+
+    // stop the workers, giving them at most timeout to process the queued messages: once half
+    // of it passed, the messages below skip_below are skipped, and once it passed all of them.
+    // the messages posted after this call are dropped. return the number of messages skipped
+    // or left in the queue. must not be called from a worker thread.
+    size_t shutdown(std::chrono::milliseconds timeout,
+                    level::level_enum skip_below = level::warn);
+
+    // number of running worker threads (varies in elastic pools)
+    size_t workers_count();
+
+    // call fn(msg, context) on each message waiting in the queues, without locking nor
+    // allocating, for a crash handler (see crash_dump.h). best effort: the messages may be
+    // processed meanwhile, and those taken by the workers already are not visited.
+    void visit_queued_unsafe(void (*fn)(const async_msg &, void *), void *context) const;
+
+    // polled pools: process at most max_msgs of the queued messages on the calling thread,
+    // without waiting for more. return the number of messages processed. the pending
+    // coalesced flushes are done by the first call after their window ended.
+    // zero if the pool is not polled.
+    size_t poll(size_t max_msgs = (std::numeric_limits<size_t>::max)());
+
+    // polled pools on linux: an eventfd readable while poll() has messages to process (it
+    // stays readable after a poll() that processed max_msgs). to register in an epoll set.
+    // -1 otherwise.
+    int poll_fd() const { return poll_fd_; }
+
+    // let the only worker of the pool own the sink (see sink::claim_exclusive()), so it logs
+    // to it without locking. the sink must then be used by the async loggers of this pool
+    // only, and released (sink.release_exclusive()) before used otherwise, once they are
+    // drained. false if the pool has several (or elastic) workers, or the sink can't be owned.
+    bool claim_exclusive(sinks::sink &sink);
 
 private:
-    q_type q_;
+    // recent flush of a logger, when coalescing flushes
+    struct flush_state {
+        async_logger *logger;
+        async_logger_ptr logger_ref;  // keeps the logger alive while a flush is pending
+        std::chrono::steady_clock::time_point last_flush;
+        size_t bytes;  // written since the last flush
+        bool pending;
+        quota_ticket ticket;  // keeps an elastic pool's logger on this worker while pending
+    };
+
+    // state of a worker thread
+    struct worker_context {
+        worker_context(async_queue &queue, size_t batch_size)
+            : q(queue),
+              batch(batch_size) {
+            log_msgs.reserve(batch_size);
+        }
+        async_queue &q;
+        // elastic pools: index of the worker, and whether it may stop when idle
+        size_t slot{0};
+        bool may_retire{false};
+        std::chrono::steady_clock::time_point last_active;
+        std::vector<async_msg> batch;
+        std::vector<details::log_msg> log_msgs;
+        std::vector<flush_state> flushes;
+    };
+
+    // a single queue shared by all workers, or one per worker if sharded or numa aware
+    std::vector<std::unique_ptr<async_queue>> queues_;
+    bool sharded_ = false;
+    bool numa_ = false;
+    std::vector<size_t> cpu_node_;  // numa node of each cpu
+
+    // elastic pool: one queue per slot, up to max_threads_n. the workers of slots
+    // [0, active_) take the idle loggers. slots above min_threads_ stop when idle.
+    bool elastic_ = false;
+    size_t min_threads_ = 0;
+    size_t grow_threshold_ = 0;
+    std::chrono::milliseconds idle_timeout_{0};
+    std::atomic<size_t> active_{0};
+    std::atomic<size_t> next_slot_{0};
+    std::unique_ptr<std::atomic<size_t>[]> slot_in_flight_;  // queued messages of each slot
+    std::mutex elastic_mutex_;                              // guards the fields below
+    std::vector<bool> slot_running_;
+    bool stopping_ = false;
+    static constexpr size_t slot_shift = sizeof(size_t) * 8 - 10;  // up to 1024 slots
+    static constexpr size_t count_mask = (size_t(1) << slot_shift) - 1;
+
+    // pending drain_logger() requests
+    std::mutex drain_mutex_;
+    std::condition_variable drain_cv_;
+    size_t last_barrier_id_ = 0;
+    std::vector<size_t> pending_barriers_;
+    std::vector<size_t> done_barriers_;
 
     std::vector<std::thread> threads_;
+    size_t batch_size_;
+    size_t spin_count_;
+    size_t yield_count_;
+    std::chrono::milliseconds flush_window_;
+    size_t flush_bytes_;
+    std::atomic<size_t> coalesced_flushes_{0};
+    size_t sample_threshold_;
+    token_bucket sampler_;
+    std::atomic<size_t> sampled_out_{0};
+    bool queue_latency_enabled_;
+    latency_histogram queue_latency_;
+    async_worker_options worker_options_;
+    std::function<void()> on_thread_start_;
+    std::function<void()> on_thread_stop_;
+
+    // shutdown() state. the time points and level are set before draining_ is.
+    std::atomic<bool> stopped_{false};
+    std::atomic<bool> draining_{false};
+    std::chrono::steady_clock::time_point skip_point_;
+    std::chrono::steady_clock::time_point deadline_;
+    level::level_enum skip_below_{level::trace};
+    std::atomic<size_t> abandoned_{0};
+
+    // post_or_wait() waiters, oldest first
+    std::mutex waiters_mutex_;
+    std::vector<queue_waiter *> waiters_;
+    std::atomic<size_t> waiters_n_{0};
 
+    // polled pools: the worker state of the callers of poll(), one at a time
+    bool polled_ = false;
+    std::mutex poll_mutex_;
+    std::unique_ptr<worker_context> poll_ctx_;
+    int poll_fd_ = -1;
+    // the eventfd was written since the last poll()
+    std::atomic<bool> poll_signaled_{false};
+
+    void post_log_(async_logger &logger,
+                   const details::log_msg &msg,
+                   async_overflow_policy overflow_policy,
+                   deferred_format_fn format_fn,
+                   quota_ticket &&quota,
+                   std::shared_ptr<const void> payload_owner = nullptr);
+    bool admit_sampled_(async_logger &logger, const details::log_msg &msg);
+    static bool acquire_quota_(async_logger &logger,
+                               async_overflow_policy overflow_policy,
+                               quota_ticket &quota);
     void post_async_msg_(async_msg &&new_msg, async_overflow_policy overflow_policy);
-    void worker_loop_();
+    async_queue &queue_of_(const async_logger *logger);
+    bool attach_(async_msg &msg, async_overflow_policy overflow_policy, size_t &slot);
+    void worker_loop_(async_queue &q, size_t slot);
+    void start_worker_(size_t slot);
+    void grow_();
+    bool try_retire_(size_t slot);
+    bool elastic_step_(worker_context &ctx, size_t n);
+
+    void stop_workers_();
+    void wake_waiters_();
+    level::level_enum skip_level_() const;
+    static std::string setup_worker_(const async_worker_options &options,
+                                     const std::vector<int> &cpus,
+                                     size_t index,
+                                     size_t threads_n);
+    static std::unique_ptr<async_queue> make_queue_(const thread_pool_options &options);
+    void make_node_queues_(const thread_pool_options &options,
+                           const std::vector<std::vector<int>> &nodes);
+    static std::unique_ptr<async_queue> make_lanes_queue_(const thread_pool_options &options);
+
+    // wait for the next messages, according to the wait strategy.
+    // may return zero if a pending flush is due.
+    size_t dequeue_batch_(worker_context &ctx);
 
-    // process next message in the queue
+    // process next batch of messages in the queue
     // return true if this thread should still be active (while no terminate msg
     // was received)
-    bool process_next_msg_();
+    bool process_next_batch_(worker_context &ctx);
+    // process the n messages dequeued in ctx.batch. same return value.
+    bool process_batch_(worker_context &ctx, size_t n);
+
+    // polled pools, under poll_mutex_
+    size_t poll_(size_t max_msgs);
+    void signal_poll_();
+
+    // flush coalescing
+    flush_state *find_flush_state_(worker_context &ctx, const async_logger *logger);
+    void request_flush_(worker_context &ctx, async_msg &msg);
+    void flush_due_(worker_context &ctx, bool flush_all);
 };
 
 }  // namespace details
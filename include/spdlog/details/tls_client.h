@@ -0,0 +1,304 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// tcp client helper with TLS, over OpenSSL (or a library with its API, like BoringSSL).
+// The session of the last connection is kept and resumed by the next one, sparing a full handshake
+// when reconnecting. Without TLS enabled in its config, it's a plain tcp client.
+
+#ifndef SPDLOG_OPENSSL
+    #error tls_client needs OpenSSL (define SPDLOG_OPENSSL and link with it)
+#endif
+
+#include <spdlog/common.h>
+#include <spdlog/details/tls_config.h>
+#ifdef _WIN32
+    #include <spdlog/details/tcp_client-windows.h>
+#else
+    #include <poll.h>
+    #include <spdlog/details/tcp_client.h>
+    #include <sys/time.h>
+#endif
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <string>
+
+namespace spdlog {
+namespace details {
+class tls_client {
+    tcp_client tcp_;
+    tls_config config_;
+    std::chrono::milliseconds timeout_{5000};
+    SSL_CTX *ctx_ = nullptr;
+    SSL *ssl_ = nullptr;
+    SSL_SESSION *session_ = nullptr;  // of the last connection, to resume
+
+    static std::string error_string_() {
+        auto err = ::ERR_get_error();
+        ::ERR_clear_error();
+        if (err == 0) {
+            return "unknown error";
+        }
+        char buf[256];
+        ::ERR_error_string_n(err, buf, sizeof(buf));
+        return buf;
+    }
+
+    [[noreturn]] void fail_(const std::string &what) {
+        auto msg = what + ": " + error_string_();
+        if (ssl_ != nullptr) {
+            ::SSL_set_quiet_shutdown(ssl_, 1);  // no close_notify on a broken connection
+        }
+        close();
+        throw_spdlog_ex(msg);
+    }
+
+    // the sessions (TLS 1.3 sends them after the handshake) are kept by this callback
+    static int new_session_cb_(SSL *ssl, SSL_SESSION *session) {
+        auto *self = static_cast<tls_client *>(SSL_get_app_data(ssl));
+        if (self->session_ != nullptr) {
+            ::SSL_SESSION_free(self->session_);
+        }
+        self->session_ = session;
+        return 1;  // the reference is ours
+    }
+
+    void create_context_() {
+        ctx_ = ::SSL_CTX_new(::TLS_client_method());
+        if (ctx_ == nullptr) {
+            throw_spdlog_ex("tls_client: SSL_CTX_new failed: " + error_string_());
+        }
+        SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+        SSL_CTX_set_session_cache_mode(ctx_,
+                                         SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        ::SSL_CTX_sess_set_new_cb(ctx_, new_session_cb_);
+        if (config_.verify) {
+            ::SSL_CTX_set_verify(ctx_, SSL_VERIFY_PEER, nullptr);
+            int rv = config_.ca_file.empty()
+                         ? ::SSL_CTX_set_default_verify_paths(ctx_)
+                         : ::SSL_CTX_load_verify_locations(ctx_, config_.ca_file.c_str(), nullptr);
+            if (rv != 1) {
+                free_context_();
+                throw_spdlog_ex("tls_client: failed loading the CA certificates: " +
+                                error_string_());
+            }
+        }
+        if (!config_.cert_file.empty() &&
+            (::SSL_CTX_use_certificate_chain_file(ctx_, config_.cert_file.c_str()) != 1 ||
+             ::SSL_CTX_use_PrivateKey_file(ctx_, config_.key_file.c_str(), SSL_FILETYPE_PEM) !=
+                 1)) {
+            free_context_();
+            throw_spdlog_ex("tls_client: failed loading the client certificate: " +
+                            error_string_());
+        }
+    }
+
+    void free_context_() {
+        if (session_ != nullptr) {
+            ::SSL_SESSION_free(session_);
+            session_ = nullptr;
+        }
+        if (ctx_ != nullptr) {
+            ::SSL_CTX_free(ctx_);
+            ctx_ = nullptr;
+        }
+    }
+
+    void set_timeouts_() {
+        auto ms = timeout_.count();
+#ifdef _WIN32
+        DWORD timeout = static_cast<DWORD>(ms);
+#else
+        timeval timeout{};
+        timeout.tv_sec = static_cast<decltype(timeout.tv_sec)>(ms / 1000);
+        timeout.tv_usec = static_cast<decltype(timeout.tv_usec)>(ms % 1000 * 1000);
+#endif
+        ::setsockopt(tcp_.fd(), SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeout),
+                     sizeof(timeout));
+        ::setsockopt(tcp_.fd(), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout),
+                     sizeof(timeout));
+    }
+
+#ifndef _WIN32
+    // the socket BIO of OpenSSL would raise SIGPIPE where MSG_NOSIGNAL is needed to prevent it
+    static int bio_write_(BIO *bio, const char *data, int len) {
+    #if defined(MSG_NOSIGNAL)
+        const int send_flags = MSG_NOSIGNAL;
+    #else
+        const int send_flags = 0;
+    #endif
+        auto *self = static_cast<tls_client *>(::BIO_get_data(bio));
+        BIO_clear_retry_flags(bio);
+        auto rv = ::send(self->tcp_.fd(), data, static_cast<size_t>(len), send_flags);
+        if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            BIO_set_retry_write(bio);
+        }
+        return static_cast<int>(rv);
+    }
+
+    static int bio_read_(BIO *bio, char *data, int len) {
+        auto *self = static_cast<tls_client *>(::BIO_get_data(bio));
+        BIO_clear_retry_flags(bio);
+        auto rv = ::recv(self->tcp_.fd(), data, static_cast<size_t>(len), 0);
+        if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            BIO_set_retry_read(bio);
+        }
+        return static_cast<int>(rv);
+    }
+
+    static long bio_ctrl_(BIO *, int cmd, long, void *) { return cmd == BIO_CTRL_FLUSH ? 1 : 0; }
+
+    static BIO_METHOD *bio_method_() {
+        static BIO_METHOD *method = [] {
+            auto *m = ::BIO_meth_new(BIO_TYPE_SOURCE_SINK, "spdlog tcp_client");
+            ::BIO_meth_set_write(m, bio_write_);
+            ::BIO_meth_set_read(m, bio_read_);
+            ::BIO_meth_set_ctrl(m, bio_ctrl_);
+            return m;
+        }();
+        return method;
+    }
+#endif
+
+    // process what the server sent (the session tickets), without waiting for it
+    void read_pending_() {
+        for (;;) {
+#ifdef _WIN32
+            WSAPOLLFD pfd{tcp_.fd(), POLLIN, 0};
+            if (::WSAPoll(&pfd, 1, 0) <= 0) {
+                return;
+            }
+#else
+            pollfd pfd{tcp_.fd(), POLLIN, 0};
+            if (::poll(&pfd, 1, 0) <= 0) {
+                return;
+            }
+#endif
+            char buf[1024];
+            auto rv = ::SSL_read(ssl_, buf, sizeof(buf));
+            if (rv <= 0) {
+                auto err = ::SSL_get_error(ssl_, rv);
+                if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+                    return;
+                }
+                fail_("tls_client: connection closed by the server");
+            }
+        }
+    }
+
+public:
+    tls_client() = default;
+    tls_client(const tls_client &) = delete;
+    tls_client &operator=(const tls_client &) = delete;
+
+    ~tls_client() {
+        close();
+        free_context_();
+    }
+
+    // the settings of the next connections
+    void set_config(tls_config config) {
+        close();
+        free_context_();
+        config_ = std::move(config);
+    }
+
+    void set_dns_ttl(std::chrono::milliseconds ttl) { tcp_.set_dns_ttl(ttl); }
+
+    // how long the handshake, a send, or a read of the server's data may block
+    void set_timeout(std::chrono::milliseconds timeout) { timeout_ = timeout; }
+
+    bool is_connected() const { return tcp_.is_connected(); }
+
+    auto fd() const -> decltype(tcp_.fd()) { return tcp_.fd(); }
+
+    // whether the current connection resumed the session of the previous one
+    bool session_reused() const { return ssl_ != nullptr && ::SSL_session_reused(ssl_) == 1; }
+
+    void close() {
+        if (ssl_ != nullptr) {
+            ::SSL_shutdown(ssl_);
+            ::SSL_free(ssl_);
+            ssl_ = nullptr;
+        }
+        tcp_.close();
+    }
+
+    // try to connect and complete the handshake, or throw on failure
+    void connect(const std::string &host, int port) {
+        close();
+        if (config_.enabled && ctx_ == nullptr) {
+            create_context_();
+        }
+        tcp_.connect(host, port);
+        set_timeouts_();
+        if (!config_.enabled) {
+            return;
+        }
+        ssl_ = ::SSL_new(ctx_);
+        if (ssl_ == nullptr) {
+            fail_("tls_client: SSL_new failed");
+        }
+        SSL_set_app_data(ssl_, this);
+#ifdef _WIN32
+        ::SSL_set_fd(ssl_, static_cast<int>(tcp_.fd()));
+#else
+        auto *bio = ::BIO_new(bio_method_());
+        if (bio == nullptr) {
+            fail_("tls_client: BIO_new failed");
+        }
+        ::BIO_set_data(bio, this);
+        ::BIO_set_init(bio, 1);
+        ::SSL_set_bio(ssl_, bio, bio);
+#endif
+        const auto &name = config_.server_name.empty() ? host : config_.server_name;
+        auto *param = ::SSL_get0_param(ssl_);
+        if (::X509_VERIFY_PARAM_set1_ip_asc(param, name.c_str()) != 1) {
+            // a host name, not an address
+            SSL_set_tlsext_host_name(ssl_, name.c_str());
+            ::X509_VERIFY_PARAM_set1_host(param, name.c_str(), 0);
+        }
+        if (session_ != nullptr) {
+            ::SSL_set_session(ssl_, session_);
+        }
+        if (::SSL_connect(ssl_) != 1) {
+            auto verify_result = ::SSL_get_verify_result(ssl_);
+            if (verify_result != X509_V_OK) {
+                ::ERR_clear_error();
+                ::SSL_set_quiet_shutdown(ssl_, 1);
+                close();
+                throw_spdlog_ex(std::string("tls_client: server certificate rejected: ") +
+                                ::X509_verify_cert_error_string(verify_result));
+            }
+            fail_("tls_client: handshake failed");
+        }
+    }
+
+    // Send exactly n_bytes of the given data, in records as large as TLS allows.
+    // On error close the connection and throw.
+    void send(const char *data, size_t n_bytes) {
+        if (ssl_ == nullptr) {
+            tcp_.send(data, n_bytes);
+            return;
+        }
+        read_pending_();
+        size_t bytes_sent = 0;
+        while (bytes_sent < n_bytes) {
+            auto chunk = static_cast<int>((std::min)(n_bytes - bytes_sent, size_t{INT_MAX}));
+            auto written = ::SSL_write(ssl_, data + bytes_sent, chunk);
+            if (written <= 0) {
+                fail_("tls_client: SSL_write failed");
+            }
+            bytes_sent += static_cast<size_t>(written);
+        }
+    }
+};
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,22 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <string>
+
+namespace spdlog {
+namespace details {
+
+// TLS settings of the network sinks (see tls_client.h, needs SPDLOG_OPENSSL)
+struct tls_config {
+    bool enabled = false;
+    bool verify = true;       // verify the server's certificate and name
+    std::string ca_file;      // the certificates to verify the server with (the system's if empty)
+    std::string server_name;  // to verify and to send (SNI) instead of the host, if set
+    std::string cert_file;    // client certificate (PEM) and its key, if the server asks for one
+    std::string key_file;
+};
+
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,61 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Lock free token bucket: admits up to rate items per second on average, and up to burst
+// items at once after an idle period.
+// Implemented as a virtual scheduling rate limiter: a single atomic holds the time at which
+// the next item would be admitted if items came at exactly the rate, so acquiring a token
+// costs a CAS on it and nothing is refilled periodically.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace spdlog {
+namespace details {
+
+class token_bucket {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // a rate of zero admits nothing
+    token_bucket(size_t rate, size_t burst)
+        : interval_ns_(rate == 0 ? 0 : 1000000000 / static_cast<std::int64_t>(rate)),
+          tolerance_ns_(interval_ns_ * static_cast<std::int64_t>(burst > 0 ? burst - 1 : 0)),
+          rate_(rate) {}
+
+    token_bucket(const token_bucket &) = delete;
+    token_bucket &operator=(const token_bucket &) = delete;
+
+    // take a token if one is available at the given time.
+    // return false if the bucket is empty.
+    bool try_acquire(clock::time_point now = clock::now()) {
+        if (rate_ == 0) {
+            return false;
+        }
+        auto t = static_cast<std::int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
+        auto next = next_ns_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto start = next > t ? next : t;
+            if (start - t > tolerance_ns_) {
+                return false;
+            }
+            if (next_ns_.compare_exchange_weak(next, start + interval_ns_,
+                                               std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+private:
+    std::int64_t interval_ns_;   // time between two tokens
+    std::int64_t tolerance_ns_;  // how far ahead of the rate the burst may go
+    size_t rate_;
+    std::atomic<std::int64_t> next_ns_{std::numeric_limits<std::int64_t>::min()};
+};
+}  // namespace details
+}  // namespace spdlog
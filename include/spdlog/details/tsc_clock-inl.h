@@ -0,0 +1,226 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/details/tsc_clock.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+        #include <x86intrin.h>
+    #endif
+#endif
+
+namespace spdlog {
+namespace details {
+
+// published with a sequence lock: the writer makes seq odd while it updates the other fields,
+// and the readers retry if seq was odd or changed while they read them.
+struct tsc_clock::calibration {
+    std::atomic<std::uint32_t> seq{0};
+    std::atomic<std::uint64_t> base_ticks{0};
+    std::atomic<std::int64_t> base_ns{0};        // log_clock time of base_ticks
+    std::atomic<std::uint64_t> ns_per_tick{0};   // 32.32 fixed point, 0 until calibrated
+    std::atomic<std::uint64_t> resync_ticks{0};  // ticks after base_ticks to resync at
+    std::atomic<bool> resyncing{false};          // owned by the thread doing the resync
+
+    // previous sample, the rate is measured since then (guarded by resyncing)
+    std::uint64_t last_ticks = 0;
+    std::int64_t last_ns = 0;
+};
+
+// the calibration fields read together
+struct tsc_clock::snapshot {
+    std::uint64_t base_ticks;
+    std::int64_t base_ns;
+    std::uint64_t ns_per_tick;
+    std::uint64_t resync_ticks;
+
+    bool due(std::uint64_t ticks) const SPDLOG_NOEXCEPT {
+        return ns_per_tick == 0 || ticks < base_ticks || ticks - base_ticks >= resync_ticks;
+    }
+};
+
+#ifdef SPDLOG_HAS_TSC_CLOCK
+static std::uint64_t tsc_read_() SPDLOG_NOEXCEPT { return __rdtsc(); }
+
+static bool tsc_invariant_() SPDLOG_NOEXCEPT {
+    unsigned regs[4] = {0, 0, 0, 0};  // eax, ebx, ecx, edx
+    #ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, static_cast<int>(0x80000000));
+    if (static_cast<unsigned>(info[0]) < 0x80000007u) {
+        return false;
+    }
+    __cpuid(info, static_cast<int>(0x80000007));
+    regs[3] = static_cast<unsigned>(info[3]);
+    #else
+    if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u) {
+        return false;
+    }
+    __get_cpuid(0x80000007u, &regs[0], &regs[1], &regs[2], &regs[3]);
+    #endif
+    return (regs[3] & (1u << 8)) != 0;  // edx bit 8: invariant tsc
+}
+
+static std::int64_t tsc_ns_since_epoch_(log_clock::time_point tp) SPDLOG_NOEXCEPT {
+    return static_cast<std::int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count());
+}
+#endif
+
+SPDLOG_INLINE bool tsc_clock::available() SPDLOG_NOEXCEPT {
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    static const bool invariant = tsc_invariant_();
+    return invariant;
+#else
+    return false;
+#endif
+}
+
+SPDLOG_INLINE log_clock::time_point tsc_clock::now() SPDLOG_NOEXCEPT {
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    if (!available()) {
+        return log_clock::now();
+    }
+    auto s = load_();
+    auto ticks = tsc_read_();
+    if (s.due(ticks)) {
+        return resync_();
+    }
+    // below 2^32 ns * 2^32 since the resync interval is shorter than 4.29s
+    auto elapsed_ns = static_cast<std::int64_t>(((ticks - s.base_ticks) * s.ns_per_tick) >> 32);
+    return log_clock::time_point(std::chrono::duration_cast<log_clock::duration>(
+        std::chrono::nanoseconds(s.base_ns + elapsed_ns)));
+#else
+    return log_clock::now();
+#endif
+}
+
+SPDLOG_INLINE std::uint64_t tsc_clock::ticks() SPDLOG_NOEXCEPT {
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    return available() ? tsc_read_() : 0;
+#else
+    return 0;
+#endif
+}
+
+SPDLOG_INLINE double tsc_clock::ns_per_tick() SPDLOG_NOEXCEPT {
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    if (!available()) {
+        return 0;
+    }
+    auto ns_per_tick = calibration_().ns_per_tick.load(std::memory_order_relaxed);
+    return static_cast<double>(ns_per_tick) / 4294967296.0;
+#else
+    return 0;
+#endif
+}
+
+SPDLOG_INLINE std::uint64_t tsc_clock::calibrated_ticks() SPDLOG_NOEXCEPT {
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    if (!available() || calibration_().ns_per_tick.load(std::memory_order_relaxed) == 0) {
+        return 0;
+    }
+    return tsc_read_();
+#else
+    return 0;
+#endif
+}
+
+SPDLOG_INLINE log_clock::time_point tsc_clock::to_time_point(std::uint64_t ticks)
+    SPDLOG_NOEXCEPT {
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    auto s = load_();
+    if (s.due(tsc_read_())) {
+        resync_();
+        s = load_();
+        if (s.ns_per_tick == 0) {
+            return log_clock::now();
+        }
+    }
+    // the reading may be before the calibration base, or older than the resync interval
+    auto elapsed_ticks = ticks >= s.base_ticks ? static_cast<double>(ticks - s.base_ticks)
+                                               : -static_cast<double>(s.base_ticks - ticks);
+    auto elapsed_ns =
+        static_cast<std::int64_t>(elapsed_ticks * static_cast<double>(s.ns_per_tick) /
+                                  4294967296.0);
+    return log_clock::time_point(std::chrono::duration_cast<log_clock::duration>(
+        std::chrono::nanoseconds(s.base_ns + elapsed_ns)));
+#else
+    (void)ticks;
+    return log_clock::now();
+#endif
+}
+
+SPDLOG_INLINE tsc_clock::calibration &tsc_clock::calibration_() SPDLOG_NOEXCEPT {
+    static calibration instance;
+    return instance;
+}
+
+SPDLOG_INLINE tsc_clock::snapshot tsc_clock::load_() SPDLOG_NOEXCEPT {
+    auto &c = calibration_();
+    snapshot s;
+    std::uint32_t seq;
+    do {
+        seq = c.seq.load(std::memory_order_acquire);
+        s.base_ticks = c.base_ticks.load(std::memory_order_relaxed);
+        s.base_ns = c.base_ns.load(std::memory_order_relaxed);
+        s.ns_per_tick = c.ns_per_tick.load(std::memory_order_relaxed);
+        s.resync_ticks = c.resync_ticks.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != c.seq.load(std::memory_order_relaxed));
+    return s;
+}
+
+// sample log_clock, and let one of the threads getting here at the same time recalibrate
+SPDLOG_INLINE log_clock::time_point tsc_clock::resync_() SPDLOG_NOEXCEPT {
+    static_assert(resync_interval_ns < (std::int64_t{1} << 32), "tsc_clock: resync too seldom");
+    auto now = log_clock::now();
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    auto &c = calibration_();
+    bool expected = false;
+    if (!c.resyncing.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+        return now;
+    }
+    auto ticks = tsc_read_();
+    auto ns = tsc_ns_since_epoch_(now);
+    // measure the rate over at least 10ms (the first calls only take the first sample)
+    const std::int64_t min_window_ns = 10000000;
+    if (c.last_ticks != 0 && ticks > c.last_ticks && ns - c.last_ns >= min_window_ns) {
+        auto rate =
+            static_cast<double>(ns - c.last_ns) / static_cast<double>(ticks - c.last_ticks);
+        auto ns_per_tick = static_cast<std::uint64_t>(rate * 4294967296.0);
+        auto resync_ticks =
+            static_cast<std::uint64_t>(static_cast<double>(resync_interval_ns) / rate);
+        if (ns_per_tick != 0 && resync_ticks != 0) {
+            auto seq = c.seq.load(std::memory_order_relaxed);
+            c.seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            c.base_ticks.store(ticks, std::memory_order_relaxed);
+            c.base_ns.store(ns, std::memory_order_relaxed);
+            c.ns_per_tick.store(ns_per_tick, std::memory_order_relaxed);
+            c.resync_ticks.store(resync_ticks, std::memory_order_relaxed);
+            c.seq.store(seq + 2, std::memory_order_release);
+        }
+    }
+    if (c.last_ticks == 0 || ns - c.last_ns >= min_window_ns) {
+        c.last_ticks = ticks;
+        c.last_ns = ns;
+    }
+    c.resyncing.store(false, std::memory_order_release);
+#endif
+    return now;
+}
+
+}  // namespace details
+}  // namespace spdlog
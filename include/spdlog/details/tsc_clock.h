@@ -0,0 +1,65 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Clock reading the cpu time stamp counter, converted to log_clock time with a calibration
+// taken from log_clock::now() and redone every resync_interval_ns. A read costs a few cycles
+// instead of a clock_gettime()/GetSystemTimePreciseAsFileTime() call.
+//
+// The times stay within a few microseconds of log_clock between two resyncs, and may step back
+// by about as much at a resync. They follow the wall clock adjustments at the next resync only.
+// Only x86 cpus with an invariant counter (the same rate in all the power states and cores) are
+// supported; elsewhere (and until the first calibration) now() returns log_clock::now().
+
+#include <spdlog/common.h>
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SPDLOG_HAS_TSC_CLOCK
+#endif
+
+namespace spdlog {
+namespace details {
+
+class SPDLOG_API tsc_clock {
+public:
+    static constexpr std::int64_t resync_interval_ns = 1000000000;
+
+    // true if the cpu has an invariant time stamp counter
+    static bool available() SPDLOG_NOEXCEPT;
+
+    static log_clock::time_point now() SPDLOG_NOEXCEPT;
+
+    // the raw counter (0 if not available), for measuring intervals with ns_per_tick()
+    static std::uint64_t ticks() SPDLOG_NOEXCEPT;
+
+    // the length of a tick measured by the calibration, 0 until now() was called a few times
+    // at least 10ms apart (or if not available)
+    static double ns_per_tick() SPDLOG_NOEXCEPT;
+
+    // the raw counter once calibrated, else 0 (and now() is to be used): the reading is
+    // converted later by to_time_point(), e.g. by another thread (see
+    // clock_source::tsc_deferred)
+    static std::uint64_t calibrated_ticks() SPDLOG_NOEXCEPT;
+
+    // the time of a calibrated_ticks() reading, with the current calibration (resynced first if
+    // due). the readings of a few seconds before are converted as well.
+    static log_clock::time_point to_time_point(std::uint64_t ticks) SPDLOG_NOEXCEPT;
+
+private:
+    struct calibration;
+    struct snapshot;
+    static calibration &calibration_() SPDLOG_NOEXCEPT;
+    static snapshot load_() SPDLOG_NOEXCEPT;
+    static log_clock::time_point resync_() SPDLOG_NOEXCEPT;
+};
+
+}  // namespace details
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "tsc_clock-inl.h"
+#endif
@@ -93,6 +93,14 @@ public:
             throw_spdlog_ex("sendto(2) failed", errno);
         }
     }
+
+    // send each of the given buffers as a datagram. winsock has no call sending several
+    // datagrams at once, so one sendto per datagram.
+    void send_many(const string_view_t *datagrams, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            send(datagrams[i].data(), datagrams[i].size());
+        }
+    }
 };
 }  // namespace details
 }  // namespace spdlog
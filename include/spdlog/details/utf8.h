@@ -0,0 +1,103 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Append UTF-16 text (wchar_t on windows, or char16_t) to a buffer as UTF-8, in one pass: the
+// room for the worst case is made once, and the runs of ascii chars are narrowed 8 at a time
+// (SSE2) or 4 at a time (elsewhere). Unpaired surrogates become U+FFFD, as with
+// WideCharToMultiByte.
+
+#include <spdlog/common.h>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SPDLOG_UTF8_SSE2
+#endif
+
+namespace spdlog {
+namespace details {
+
+// the chars written, at most 3 per unit of src
+template <typename Char>
+inline size_t utf16_to_utf8(const Char *src, size_t size, char *dest) {
+    static_assert(sizeof(Char) == 2, "utf16_to_utf8 takes 16 bits code units");
+    auto *out = dest;
+    size_t i = 0;
+#ifdef SPDLOG_UTF8_SSE2
+    const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xff80));
+#endif
+    while (i < size) {
+#ifdef SPDLOG_UTF8_SSE2
+        while (i + 8 <= size) {
+            __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, non_ascii),
+                                                  _mm_setzero_si128())) != 0xffff) {
+                break;
+            }
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(units, units));
+            out += 8;
+            i += 8;
+        }
+#else
+        while (i + 4 <= size) {
+            std::uint64_t units;
+            std::memcpy(&units, src + i, sizeof(units));
+            if ((units & 0xff80ff80ff80ff80ull) != 0) {
+                break;
+            }
+            for (int k = 0; k < 4; k++) {
+                out[k] = static_cast<char>(src[i + static_cast<size_t>(k)]);
+            }
+            out += 4;
+            i += 4;
+        }
+#endif
+        if (i == size) {
+            break;
+        }
+        std::uint32_t cp = static_cast<std::uint16_t>(src[i++]);
+        if (cp < 0x80) {
+            *out++ = static_cast<char>(cp);
+            continue;
+        }
+        if (cp < 0x800) {
+            *out++ = static_cast<char>(0xc0 | (cp >> 6));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+            continue;
+        }
+        if (cp >= 0xd800 && cp <= 0xdfff) {
+            std::uint32_t low = i < size ? static_cast<std::uint16_t>(src[i]) : 0;
+            if (cp <= 0xdbff && low >= 0xdc00 && low <= 0xdfff) {
+                i++;
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                *out++ = static_cast<char>(0xf0 | (cp >> 18));
+                *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+                *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+                continue;
+            }
+            cp = 0xfffd;
+        }
+        *out++ = static_cast<char>(0xe0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    return static_cast<size_t>(out - dest);
+}
+
+template <typename Char>
+inline void append_utf16_as_utf8(const Char *src, size_t size, memory_buf_t &dest) {
+    if (size == 0) {
+        return;
+    }
+    auto start = dest.size();
+    dest.resize(start + size * 3);  // a surrogate pair (2 units) is 4 chars
+    dest.resize(start + utf16_to_utf8(src, size, &dest[start]));
+}
+
+}  // namespace details
+}  // namespace spdlog
@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <spdlog/common.h>
 
 #if defined(__has_include)
@@ -56,6 +58,24 @@ private:
     It begin_, end_;
     size_t size_per_line_;
 };
+
+// the two hex digits of each byte value, by pairs: "00" "01" ... "ff"
+inline const char *hex_pairs(bool upper) {
+    struct table {
+        char lower[512];
+        char upper[512];
+        table() {
+            for (size_t i = 0; i < 256; i++) {
+                lower[i * 2] = "0123456789abcdef"[i >> 4];
+                lower[i * 2 + 1] = "0123456789abcdef"[i & 0x0f];
+                upper[i * 2] = "0123456789ABCDEF"[i >> 4];
+                upper[i * 2 + 1] = "0123456789ABCDEF"[i & 0x0f];
+            }
+        }
+    };
+    static const table pairs;
+    return upper ? pairs.upper : pairs.lower;
+}
 }  // namespace details
 
 // create a dump_info that wraps the given container
@@ -140,13 +160,13 @@ struct formatter<spdlog::details::dump_info<T>, char> {
         return it;
     }
 
-    // format the given bytes range as hex
+    // format the given bytes range as hex.
+    // the lines are rendered into a stack buffer with a byte to hex digits table, and the
+    // buffer is written to the output at once whenever it is nearly full.
     template <typename FormatContext, typename Container>
     auto format(const spdlog::details::dump_info<Container> &the_range, FormatContext &ctx) const
         -> decltype(ctx.out()) {
-        SPDLOG_CONSTEXPR const char *hex_upper = "0123456789ABCDEF";
-        SPDLOG_CONSTEXPR const char *hex_lower = "0123456789abcdef";
-        const char *hex_chars = use_uppercase ? hex_upper : hex_lower;
+        const char *hex_pairs = spdlog::details::hex_pairs(use_uppercase);
 
 #if !defined(SPDLOG_USE_STD_FORMAT) && FMT_VERSION < 60000
         auto inserter = ctx.begin();
@@ -154,71 +174,140 @@ struct formatter<spdlog::details::dump_info<T>, char> {
         auto inserter = ctx.out();
 #endif
 
-        int size_per_line = static_cast<int>(the_range.size_per_line());
-        auto start_of_line = the_range.get_begin();
-        for (auto i = the_range.get_begin(); i != the_range.get_end(); i++) {
-            auto ch = static_cast<unsigned char>(*i);
-
-            if (put_newlines &&
-                (i == the_range.get_begin() || i - start_of_line >= size_per_line)) {
-                if (show_ascii && i != the_range.get_begin()) {
-                    *inserter++ = delimiter;
-                    *inserter++ = delimiter;
-                    for (auto j = start_of_line; j < i; j++) {
-                        auto pc = static_cast<unsigned char>(*j);
-                        *inserter++ = std::isprint(pc) ? static_cast<char>(*j) : '.';
-                    }
-                }
-
-                put_newline(inserter, static_cast<size_t>(i - the_range.get_begin()));
+        auto range_begin = the_range.get_begin();
+        auto range_end = the_range.get_end();
+        auto size = static_cast<size_t>(range_end - range_begin);
+        auto size_per_line = the_range.size_per_line();
+        size_t line_size = put_newlines ? (std::max)(size_per_line, size_t{1}) : size;
 
-                // put first byte without delimiter in front of it
-                *inserter++ = hex_chars[(ch >> 4) & 0x0f];
-                *inserter++ = hex_chars[ch & 0x0f];
-                start_of_line = i;
-                continue;
+        char buf[buf_size];
+        size_t n = 0;
+        for (size_t line_start = 0; line_start < size; line_start += line_size) {
+            auto line_end = (std::min)(size, line_start + line_size);
+            if (put_newlines) {
+                n = room_(inserter, buf, n, 32);
+                n = put_newline(buf, n, line_start);
             }
-
-            if (put_delimiters && i != the_range.get_begin()) {
-                *inserter++ = delimiter;
-            }
-
-            *inserter++ = hex_chars[(ch >> 4) & 0x0f];
-            *inserter++ = hex_chars[ch & 0x0f];
-        }
-        if (show_ascii)  // add ascii to last line
-        {
-            if (the_range.get_end() - the_range.get_begin() > size_per_line) {
-                auto blank_num = size_per_line - (the_range.get_end() - start_of_line);
-                while (blank_num-- > 0) {
-                    *inserter++ = delimiter;
-                    *inserter++ = delimiter;
-                    if (put_delimiters) {
-                        *inserter++ = delimiter;
+            for (auto chunk_start = line_start; chunk_start < line_end;) {
+                auto chunk_end = (std::min)(line_end, chunk_start + buf_size / 3);
+                n = room_(inserter, buf, n, (chunk_end - chunk_start) * 3);
+                auto i = chunk_start;
+                if (i == line_start) {  // first byte without delimiter in front of it
+                    std::memcpy(buf + n, hex_pairs + byte_at_(range_begin, i++) * 2, 2);
+                    n += 2;
+                }
+                if (put_delimiters) {
+                    for (; i < chunk_end; i++) {
+                        buf[n] = delimiter;
+                        std::memcpy(buf + n + 1, hex_pairs + byte_at_(range_begin, i) * 2, 2);
+                        n += 3;
+                    }
+                } else {
+                    for (; i < chunk_end; i++) {
+                        std::memcpy(buf + n, hex_pairs + byte_at_(range_begin, i) * 2, 2);
+                        n += 2;
                     }
                 }
+                chunk_start = chunk_end;
             }
-            *inserter++ = delimiter;
-            *inserter++ = delimiter;
-            for (auto j = start_of_line; j != the_range.get_end(); j++) {
-                auto pc = static_cast<unsigned char>(*j);
-                *inserter++ = std::isprint(pc) ? static_cast<char>(*j) : '.';
+            if (show_ascii) {
+                // pad the hex of the last line to the width of the others
+                auto line_bytes = line_end - line_start;
+                if (line_end == size && size > size_per_line && line_bytes < size_per_line) {
+                    auto blank_size = (size_per_line - line_bytes) * (put_delimiters ? 3u : 2u);
+                    n = put_blanks_(inserter, buf, n, blank_size);
+                }
+                n = put_ascii_(inserter, buf, n, range_begin, line_start, line_end);
             }
         }
-        return inserter;
+        if (size == 0 && show_ascii) {
+            n = put_ascii_(inserter, buf, n, range_begin, 0, 0);
+        }
+        return write_(inserter, buf, n);
     }
 
-    // put newline(and position header)
-    template <typename It>
-    void put_newline(It inserter, std::size_t pos) const {
+    // put newline(and position header) into buf
+    size_t put_newline(char *buf, size_t n, std::size_t pos) const {
 #ifdef _WIN32
-        *inserter++ = '\r';
+        buf[n++] = '\r';
 #endif
-        *inserter++ = '\n';
+        buf[n++] = '\n';
 
         if (put_positions) {
-            spdlog::fmt_lib::format_to(inserter, SPDLOG_FMT_STRING("{:04X}: "), pos);
+            // at least 4 upper case hex digits, like {:04X}
+            char digits[sizeof(size_t) * 2];
+            size_t count = 0;
+            do {
+                digits[count++] = "0123456789ABCDEF"[pos & 0x0f];
+                pos >>= 4;
+            } while (pos != 0);
+            for (; count < 4; count++) {
+                digits[count] = '0';
+            }
+            while (count > 0) {
+                buf[n++] = digits[--count];
+            }
+            buf[n++] = ':';
+            buf[n++] = ' ';
+        }
+        return n;
+    }
+
+private:
+    static constexpr size_t buf_size = 512;
+
+    template <typename RangeIt>
+    static unsigned char byte_at_(RangeIt range_begin, size_t i) {
+        return static_cast<unsigned char>(range_begin[static_cast<std::ptrdiff_t>(i)]);
+    }
+
+    template <typename It>
+    static It write_(It inserter, const char *buf, size_t n) {
+        return spdlog::fmt_lib::format_to(inserter, SPDLOG_FMT_STRING("{}"),
+                                          spdlog::string_view_t(buf, n));
+    }
+
+    // flush buf if there is not enough room left in it for the given count of chars
+    template <typename It>
+    static size_t room_(It &inserter, char *buf, size_t n, size_t count) {
+        if (n + count > buf_size) {
+            inserter = write_(inserter, buf, n);
+            return 0;
+        }
+        return n;
+    }
+
+    template <typename It>
+    size_t put_blanks_(It &inserter, char *buf, size_t n, size_t count) const {
+        while (count > 0) {
+            n = room_(inserter, buf, n, 1);
+            auto blanks = (std::min)(count, buf_size - n);
+            std::memset(buf + n, delimiter, blanks);
+            n += blanks;
+            count -= blanks;
+        }
+        return n;
+    }
+
+    // two delimiters, then the line's printable chars (or '.')
+    template <typename It, typename RangeIt>
+    size_t put_ascii_(It &inserter,
+                      char *buf,
+                      size_t n,
+                      RangeIt range_begin,
+                      size_t line_start,
+                      size_t line_end) const {
+        n = put_blanks_(inserter, buf, n, 2);
+        for (auto chunk_start = line_start; chunk_start < line_end;) {
+            auto chunk_end = (std::min)(line_end, chunk_start + buf_size);
+            n = room_(inserter, buf, n, chunk_end - chunk_start);
+            for (auto i = chunk_start; i < chunk_end; i++) {
+                auto pc = byte_at_(range_begin, i);
+                buf[n++] = std::isprint(pc) ? static_cast<char>(pc) : '.';
+            }
+            chunk_start = chunk_end;
         }
+        return n;
     }
 };
 }  // namespace std
@@ -0,0 +1,67 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <spdlog/common.h>
+
+#include <type_traits>
+#include <utility>
+
+//
+// Support for arguments evaluated only if the message is formatted, i.e. if its level is
+// enabled. the callable is invoked when the message is formatted, and its result formatted
+// with the format spec of the argument. it's invoked on the caller thread, also by async
+// loggers with deferred formatting (which don't defer such messages).
+//
+// Examples:
+//
+// logger->debug("state: {}", spdlog::lazy([&] { return dump_state(); }));
+// logger->debug("load: {:.2f}", spdlog::lazy([&] { return compute_load(); }));
+
+namespace spdlog {
+namespace details {
+
+template <typename F>
+class lazy_value {
+public:
+    explicit lazy_value(F fn)
+        : fn_(std::move(fn)) {}
+
+    auto operator()() const -> decltype(std::declval<const F &>()()) { return fn_(); }
+
+private:
+    F fn_;
+};
+
+template <typename F>
+using lazy_result_t = typename std::decay<decltype(std::declval<const F &>()())>::type;
+
+}  // namespace details
+
+// fn must be callable as const
+template <typename F>
+inline details::lazy_value<typename std::decay<F>::type> lazy(F &&fn) {
+    return details::lazy_value<typename std::decay<F>::type>(std::forward<F>(fn));
+}
+
+}  // namespace spdlog
+
+namespace
+#ifdef SPDLOG_USE_STD_FORMAT
+    std
+#else
+    fmt
+#endif
+{
+
+template <typename F, typename Char>
+struct formatter<spdlog::details::lazy_value<F>, Char>
+    : formatter<spdlog::details::lazy_result_t<F>, Char> {
+    template <typename FormatContext>
+    auto format(const spdlog::details::lazy_value<F> &value, FormatContext &ctx) const
+        -> decltype(ctx.out()) {
+        return formatter<spdlog::details::lazy_result_t<F>, Char>::format(value(), ctx);
+    }
+};
+}  // namespace std
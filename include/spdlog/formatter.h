@@ -13,5 +13,7 @@ public:
     virtual ~formatter() = default;
     virtual void format(const details::log_msg &msg, memory_buf_t &dest) = 0;
     virtual std::unique_ptr<formatter> clone() const = 0;
+    // the msg_field bits of the fields format() reads
+    virtual unsigned needed_fields() const { return msg_field::all; }
 };
 }  // namespace spdlog
@@ -0,0 +1,61 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Header-only build: to be included by exactly one translation unit of the program.
+// Instantiates the sinks which SPDLOG_EXTERN_TEMPLATES declares extern in the other ones, and
+// defines the functions of spdlog/logger_fwd.h. The compiled library does both already.
+
+#include <spdlog/details/api.h>
+
+#ifndef SPDLOG_HEADER_ONLY
+    #error spdlog/instantiate.h is for the header-only build, the compiled library has these
+#endif
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/logger_fwd-inl.h>
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/sinks/stdout_sinks.h>
+
+#include <mutex>
+
+template class spdlog::sinks::base_sink<std::mutex>;
+template class spdlog::sinks::base_sink<spdlog::details::null_mutex>;
+
+template class spdlog::sinks::basic_file_sink<std::mutex>;
+template class spdlog::sinks::basic_file_sink<spdlog::details::null_mutex>;
+template class spdlog::sinks::rotating_file_sink<std::mutex>;
+template class spdlog::sinks::rotating_file_sink<spdlog::details::null_mutex>;
+
+template class spdlog::sinks::stdout_sink_base<spdlog::details::console_mutex>;
+template class spdlog::sinks::stdout_sink_base<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::stdout_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::stdout_sink<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::stderr_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::stderr_sink<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_mutex>;
+template class spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::buffered_stdout_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::buffered_stdout_sink<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::buffered_stderr_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::buffered_stderr_sink<spdlog::details::console_nullmutex>;
+
+#ifdef _WIN32
+template class spdlog::sinks::wincolor_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::wincolor_sink<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::wincolor_stdout_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::wincolor_stdout_sink<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::wincolor_stderr_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::wincolor_stderr_sink<spdlog::details::console_nullmutex>;
+#else
+template class spdlog::sinks::ansicolor_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::ansicolor_sink<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::ansicolor_stdout_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::ansicolor_stdout_sink<spdlog::details::console_nullmutex>;
+template class spdlog::sinks::ansicolor_stderr_sink<spdlog::details::console_mutex>;
+template class spdlog::sinks::ansicolor_stderr_sink<spdlog::details::console_nullmutex>;
+#endif
@@ -0,0 +1,147 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/json_formatter.h>
+#endif
+
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/json_escape.h>
+#include <spdlog/details/os.h>
+
+#ifndef SPDLOG_NO_TLS
+    #include <spdlog/mdc.h>
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace spdlog {
+
+SPDLOG_INLINE json_formatter::json_formatter(pattern_time_type time_type, std::string eol)
+    : pattern_time_type_(time_type),
+      eol_(std::move(eol)) {}
+
+SPDLOG_INLINE std::unique_ptr<formatter> json_formatter::clone() const {
+    return details::make_unique<json_formatter>(pattern_time_type_, eol_);
+}
+
+SPDLOG_INLINE void json_formatter::format(const details::log_msg &msg, memory_buf_t &dest) {
+    using details::fmt_helper::append_string_view;
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+
+    // cache the date/time part for the next second.
+    auto duration = msg.time.time_since_epoch();
+    auto secs = duration_cast<seconds>(duration);
+    if (cache_timestamp_ != secs || cached_datetime_.size() == 0) {
+        auto time_tt = log_clock::to_time_t(msg.time);
+        auto tm_time = pattern_time_type_ == pattern_time_type::local
+                           ? details::os::fast_localtime(time_tt)
+                           : details::os::fast_gmtime(time_tt);
+        cached_datetime_.clear();
+        details::fmt_helper::append_int(tm_time.tm_year + 1900, cached_datetime_);
+        cached_datetime_.push_back('-');
+        details::fmt_helper::pad2(tm_time.tm_mon + 1, cached_datetime_);
+        cached_datetime_.push_back('-');
+        details::fmt_helper::pad2(tm_time.tm_mday, cached_datetime_);
+        cached_datetime_.push_back('T');
+        details::fmt_helper::pad2(tm_time.tm_hour, cached_datetime_);
+        cached_datetime_.push_back(':');
+        details::fmt_helper::pad2(tm_time.tm_min, cached_datetime_);
+        cached_datetime_.push_back(':');
+        details::fmt_helper::pad2(tm_time.tm_sec, cached_datetime_);
+
+        cached_offset_.clear();
+        if (pattern_time_type_ == pattern_time_type::utc) {
+            cached_offset_.push_back('Z');
+        } else {
+            auto total_minutes = details::os::utc_minutes_offset(tm_time);
+            cached_offset_.push_back(total_minutes < 0 ? '-' : '+');
+            total_minutes = total_minutes < 0 ? -total_minutes : total_minutes;
+            details::fmt_helper::pad2(total_minutes / 60, cached_offset_);
+            cached_offset_.push_back(':');
+            details::fmt_helper::pad2(total_minutes % 60, cached_offset_);
+        }
+        cache_timestamp_ = secs;
+    }
+
+    append_string_view("{\"time\":\"", dest);
+    dest.append(cached_datetime_.begin(), cached_datetime_.end());
+    dest.push_back('.');
+    auto millis = details::fmt_helper::time_fraction<milliseconds>(msg.time);
+    details::fmt_helper::pad3(static_cast<uint32_t>(millis.count()), dest);
+    dest.append(cached_offset_.begin(), cached_offset_.end());
+
+    append_string_view("\",\"level\":\"", dest);
+    append_string_view(level::to_string_view(msg.level), dest);
+
+    append_string_view("\",\"logger\":\"", dest);
+    details::json_escape(msg.logger_name, dest);
+
+    append_string_view("\",\"thread\":", dest);
+    details::fmt_helper::append_int(msg.thread_id, dest);
+
+    if (!msg.source.empty()) {
+        append_string_view(",\"source\":{\"file\":\"", dest);
+        details::json_escape(msg.source.filename, dest);
+        append_string_view("\",\"line\":", dest);
+        details::fmt_helper::append_int(msg.source.line, dest);
+        if (msg.source.funcname != nullptr) {
+            append_string_view(",\"function\":\"", dest);
+            details::json_escape(msg.source.funcname, dest);
+            dest.push_back('"');
+        }
+        dest.push_back('}');
+    }
+
+#ifndef SPDLOG_NO_TLS
+    auto &mdc_map = mdc::get_context();
+    if (!mdc_map.empty()) {
+        append_string_view(",\"mdc\":{", dest);
+        bool first = true;
+        for (auto item : mdc_map) {
+            append_string_view(first ? "\"" : ",\"", dest);
+            details::json_escape(item.first, dest);
+            append_string_view("\":\"", dest);
+            details::json_escape(item.second, dest);
+            dest.push_back('"');
+            first = false;
+        }
+        dest.push_back('}');
+    }
+#endif
+
+    if (msg.kv_count > 0) {
+        append_string_view(",\"fields\":{", dest);
+        for (size_t i = 0; i < msg.kv_count; ++i) {
+            const auto &field = msg.kv_fields[i];
+            append_string_view(i == 0 ? "\"" : ",\"", dest);
+            details::json_escape(field.key, dest);
+            append_string_view("\":", dest);
+            if (field.type == kv_type::string) {
+                dest.push_back('"');
+                details::json_escape(field.string_value, dest);
+                dest.push_back('"');
+            } else if (field.type == kv_type::float64 && !std::isfinite(field.float_value)) {
+                append_string_view("null", dest);  // not a json number
+            } else {
+                details::fmt_helper::append_kv_value(field, dest);
+            }
+        }
+        dest.push_back('}');
+    }
+
+    append_string_view(",\"message\":\"", dest);
+    details::json_escape(msg.payload, dest);
+    append_string_view("\"}", dest);
+    append_string_view(eol_, dest);
+}
+
+}  // namespace spdlog
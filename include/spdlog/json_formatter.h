@@ -0,0 +1,57 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Formatter writing each message as one json object:
+//
+// {"time":"2024-05-01T12:00:00.123+02:00","level":"info","logger":"app","thread":1234,
+//  "source":{"file":"main.cpp","line":42,"function":"main"},"mdc":{"key":"value"},
+//  "fields":{"status":200},"message":"some message"}
+//
+// "source" is there only if the message has a source location (SPDLOG_INFO(..) etc),
+// "mdc" only if the mdc of the thread is not empty, and "fields" only if the message has kv
+// fields (see kv.h), with their json type (null for the non finite doubles). All strings are
+// escaped.
+//
+// Usage example:
+// logger->set_formatter(std::make_unique<spdlog::json_formatter>());
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include <spdlog/formatter.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace spdlog {
+
+class SPDLOG_API json_formatter final : public formatter {
+public:
+    explicit json_formatter(pattern_time_type time_type = pattern_time_type::local,
+                            std::string eol = spdlog::details::os::default_eol);
+
+    json_formatter(const json_formatter &other) = delete;
+    json_formatter &operator=(const json_formatter &other) = delete;
+
+    std::unique_ptr<formatter> clone() const override;
+    void format(const details::log_msg &msg, memory_buf_t &dest) override;
+    unsigned needed_fields() const override {
+        return msg_field::time | msg_field::thread_id | msg_field::source;
+    }
+
+private:
+    pattern_time_type pattern_time_type_;
+    std::string eol_;
+    // "YYYY-MM-DDTHH:MM:SS" and the utc offset ("Z" or "+HH:MM") of the last second logged
+    std::chrono::seconds cache_timestamp_{0};
+    memory_buf_t cached_datetime_;
+    memory_buf_t cached_offset_;
+};
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "json_formatter-inl.h"
+#endif
@@ -0,0 +1,96 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Typed key/value fields of a message, logged after its text instead of being formatted into
+// it: the json and logfmt formatters, the binary formatter and the otlp and systemd sinks keep
+// their type, the pattern formatter prints them with the mdc ("%&" and the default pattern).
+//
+// Usage example:
+// logger->info("request done", spdlog::kv("latency_us", 42), spdlog::kv("status", 200));
+//
+// The keys and the string values are referred to, not copied, until the message is logged
+// (the async loggers and the backtrace copy them with the message).
+
+#include <spdlog/common.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace spdlog {
+
+enum class kv_type : unsigned char { string, int64, uint64, float64, boolean };
+
+struct kv_field {
+    string_view_t key;
+    kv_type type = kv_type::string;
+    union {
+        std::int64_t int_value;
+        std::uint64_t uint_value;
+        double float_value;
+        bool bool_value;
+    };
+    string_view_t string_value;
+
+    kv_field()
+        : int_value(0) {}
+};
+
+inline kv_field kv(string_view_t key, string_view_t value) {
+    kv_field field;
+    field.key = key;
+    field.string_value = value;
+    return field;
+}
+
+inline kv_field kv(string_view_t key, const char *value) {
+    return kv(key, value == nullptr ? string_view_t() : string_view_t(value));
+}
+
+inline kv_field kv(string_view_t key, const std::string &value) {
+    return kv(key, string_view_t(value.data(), value.size()));
+}
+
+inline kv_field kv(string_view_t key, bool value) {
+    kv_field field;
+    field.key = key;
+    field.type = kv_type::boolean;
+    field.bool_value = value;
+    return field;
+}
+
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value,
+                                  int>::type = 0>
+kv_field kv(string_view_t key, T value) {
+    kv_field field;
+    field.key = key;
+    field.type = kv_type::int64;
+    field.int_value = static_cast<std::int64_t>(value);
+    return field;
+}
+
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                                      !std::is_same<T, bool>::value,
+                                  int>::type = 0>
+kv_field kv(string_view_t key, T value) {
+    kv_field field;
+    field.key = key;
+    field.type = kv_type::uint64;
+    field.uint_value = static_cast<std::uint64_t>(value);
+    return field;
+}
+
+template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+kv_field kv(string_view_t key, T value) {
+    kv_field field;
+    field.key = key;
+    field.type = kv_type::float64;
+    field.float_value = static_cast<double>(value);
+    return field;
+}
+
+}  // namespace spdlog
@@ -0,0 +1,105 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Per callsite state of the rate limited and sampled logging (see logger::log_limited() and
+// the SPDLOG_*_EVERY_N, _FIRST_N, _EVERY_MS and _SAMPLED macros):
+// every_n: the 1st message, then one every n.
+// first_n: only the n first messages.
+// every_ms: at most one message every n milliseconds.
+// sampled: this ratio (0 to 1) of the messages, evenly spread.
+//
+// The messages suppressed are not formatted. Their number is reported with the next message
+// logged (except with first_n, which logs no more).
+// Constant initialized with constant arguments, so that a static limiter costs no guard.
+//
+// Usage example:
+// static spdlog::log_limiter limiter(spdlog::log_limiter::every_n, 100);
+// logger->log_limited(limiter, spdlog::source_loc{}, spdlog::level::info, "packet {}", id);
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace spdlog {
+
+class log_limiter {
+public:
+    // sampled is set by the ratio constructor
+    enum kind { every_n, first_n, every_ms, sampled };
+
+    // n: the number of messages, or the milliseconds with every_ms
+    constexpr log_limiter(kind limiter_kind, std::uint64_t n)
+        : kind_{limiter_kind},
+          param_{limiter_kind == every_ms  ? n * 1000000
+                 : limiter_kind == every_n ? (n == 0 ? 1 : n)
+                                           : n} {}
+
+    constexpr explicit log_limiter(double ratio)
+        : kind_{sampled},
+          param_{ratio <= 0 ? 0
+                 : ratio >= 1 ? full_step_
+                              : static_cast<std::uint64_t>(ratio * 4294967296.0 + 0.5)} {}
+
+    log_limiter(const log_limiter &) = delete;
+    log_limiter &operator=(const log_limiter &) = delete;
+
+    // true if the message is to be logged, suppressed being set to the number of messages
+    // suppressed since the previous one logged
+    bool allow(std::uint64_t &suppressed) {
+        suppressed = 0;
+        switch (kind_) {
+            case every_n: {
+                auto count = count_.fetch_add(1, std::memory_order_relaxed);
+                if (count % param_ != 0) {
+                    return false;
+                }
+                suppressed = count == 0 ? 0 : param_ - 1;
+                return true;
+            }
+            case first_n:
+                // stops counting once past n
+                return count_.load(std::memory_order_relaxed) < param_ &&
+                       count_.fetch_add(1, std::memory_order_relaxed) < param_;
+            case every_ms: {
+                auto now = static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+                auto next = count_.load(std::memory_order_relaxed);
+                if (now < next ||
+                    !count_.compare_exchange_strong(next, now + param_,
+                                                    std::memory_order_relaxed)) {
+                    suppressed_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                break;
+            }
+            case sampled: {
+                // logged when the accumulated ratio crosses an integer
+                auto before = count_.fetch_add(param_, std::memory_order_relaxed);
+                if (((before + param_) >> 32) == (before >> 32)) {
+                    suppressed_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                break;
+            }
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    static constexpr std::uint64_t full_step_ = std::uint64_t(1) << 32;
+
+    kind kind_;
+    // every_n, first_n: n. every_ms: the period in ns. sampled: the ratio out of 2^32
+    std::uint64_t param_;
+    // every_n, first_n: the messages counted. every_ms: the time (ns) of the next one
+    // logged. sampled: the accumulated ratio
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> suppressed_{0};
+};
+
+}  // namespace spdlog
@@ -0,0 +1,135 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/logfmt_formatter.h>
+#endif
+
+#include <spdlog/details/fmt_helper.h>
+
+#ifndef SPDLOG_NO_TLS
+    #include <spdlog/mdc.h>
+#endif
+
+#include <memory>
+#include <string>
+
+namespace spdlog {
+namespace details {
+
+static bool logfmt_needs_quotes_(unsigned char ch) {
+    return ch <= ' ' || ch == '=' || ch == '"' || ch == '\\' || ch == 0x7f;
+}
+
+// append the value as is, or quoted from the first char needing it, in one pass.
+static void logfmt_append_value_(string_view_t value, memory_buf_t &dest) {
+    auto *p = value.data();
+    auto *end = p + value.size();
+    auto *plain_end = p;
+    while (plain_end != end && !logfmt_needs_quotes_(static_cast<unsigned char>(*plain_end))) {
+        ++plain_end;
+    }
+    if (plain_end == end && p != end) {
+        dest.append(p, end);
+        return;
+    }
+
+    dest.push_back('"');
+    dest.append(p, plain_end);
+    for (p = plain_end; p != end; ++p) {
+        auto ch = static_cast<unsigned char>(*p);
+        if (ch >= ' ' && ch != '"' && ch != '\\' && ch != 0x7f) {
+            dest.push_back(static_cast<char>(ch));
+            continue;
+        }
+        dest.push_back('\\');
+        switch (ch) {
+            case '"':
+            case '\\':
+                dest.push_back(static_cast<char>(ch));
+                break;
+            case '\n':
+                dest.push_back('n');
+                break;
+            case '\r':
+                dest.push_back('r');
+                break;
+            case '\t':
+                dest.push_back('t');
+                break;
+            default: {
+                const char *hex = "0123456789abcdef";
+                const char escaped[] = {'u', '0', '0', hex[ch >> 4], hex[ch & 0xf]};
+                dest.append(escaped, escaped + sizeof(escaped));
+                break;
+            }
+        }
+    }
+    dest.push_back('"');
+}
+
+// keys can't be quoted: chars that would need it are replaced by '_'
+static void logfmt_append_key_(string_view_t key, memory_buf_t &dest) {
+    if (key.size() == 0) {
+        dest.push_back('_');
+        return;
+    }
+    for (auto *p = key.data(); p != key.data() + key.size(); ++p) {
+        dest.push_back(logfmt_needs_quotes_(static_cast<unsigned char>(*p)) ? '_' : *p);
+    }
+}
+
+}  // namespace details
+
+SPDLOG_INLINE logfmt_formatter::logfmt_formatter(pattern_time_type time_type, std::string eol)
+    : pattern_time_type_(time_type),
+      eol_(std::move(eol)),
+      time_formatter_(time_type == pattern_time_type::utc ? "%Y-%m-%dT%H:%M:%S.%eZ"
+                                                          : "%Y-%m-%dT%H:%M:%S.%e%z",
+                      time_type,
+                      "") {}
+
+SPDLOG_INLINE std::unique_ptr<formatter> logfmt_formatter::clone() const {
+    return details::make_unique<logfmt_formatter>(pattern_time_type_, eol_);
+}
+
+SPDLOG_INLINE void logfmt_formatter::format(const details::log_msg &msg, memory_buf_t &dest) {
+    using details::fmt_helper::append_string_view;
+
+    append_string_view("ts=", dest);
+    time_formatter_.format(msg, dest);
+
+    append_string_view(" level=", dest);
+    append_string_view(level::to_string_view(msg.level), dest);
+
+    append_string_view(" logger=", dest);
+    details::logfmt_append_value_(msg.logger_name, dest);
+
+    append_string_view(" msg=", dest);
+    details::logfmt_append_value_(msg.payload, dest);
+
+#ifndef SPDLOG_NO_TLS
+    for (auto item : mdc::get_context()) {
+        dest.push_back(' ');
+        details::logfmt_append_key_(item.first, dest);
+        dest.push_back('=');
+        details::logfmt_append_value_(item.second, dest);
+    }
+#endif
+    for (size_t i = 0; i < msg.kv_count; ++i) {
+        const auto &field = msg.kv_fields[i];
+        dest.push_back(' ');
+        details::logfmt_append_key_(field.key, dest);
+        dest.push_back('=');
+        if (field.type == kv_type::string) {
+            details::logfmt_append_value_(field.string_value, dest);
+        } else {
+            details::fmt_helper::append_kv_value(field, dest);  // never to be quoted
+        }
+    }
+    append_string_view(eol_, dest);
+}
+
+}  // namespace spdlog
@@ -0,0 +1,50 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Formatter writing each message as a logfmt line:
+//
+// ts=2024-05-01T12:00:00.123+02:00 level=info logger=app msg="some message" key=value
+//
+// followed by the mdc entries of the thread (if any) and the kv fields of the message (see
+// kv.h) as key=value pairs. Values are quoted (and escaped) only if they have to be: empty, or
+// containing spaces, '=', '"' or control chars.
+//
+// Usage example:
+// logger->set_formatter(std::make_unique<spdlog::logfmt_formatter>());
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include <spdlog/formatter.h>
+#include <spdlog/pattern_formatter.h>
+
+#include <memory>
+#include <string>
+
+namespace spdlog {
+
+class SPDLOG_API logfmt_formatter final : public formatter {
+public:
+    explicit logfmt_formatter(pattern_time_type time_type = pattern_time_type::local,
+                              std::string eol = spdlog::details::os::default_eol);
+
+    logfmt_formatter(const logfmt_formatter &other) = delete;
+    logfmt_formatter &operator=(const logfmt_formatter &other) = delete;
+
+    std::unique_ptr<formatter> clone() const override;
+    void format(const details::log_msg &msg, memory_buf_t &dest) override;
+    unsigned needed_fields() const override { return msg_field::time; }
+
+private:
+    pattern_time_type pattern_time_type_;
+    std::string eol_;
+    // renders the ts value, with the date/time cached for each second
+    pattern_formatter time_formatter_;
+};
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "logfmt_formatter-inl.h"
+#endif
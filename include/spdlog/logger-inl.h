@@ -8,6 +8,8 @@
 #endif
 
 #include <spdlog/details/backtracer.h>
+#include <spdlog/details/callsite.h>
+#include <spdlog/details/shared_format.h>
 #include <spdlog/pattern_formatter.h>
 #include <spdlog/sinks/sink.h>
 
@@ -20,17 +22,29 @@ SPDLOG_INLINE logger::logger(const logger &other)
     : name_(other.name_),
       sinks_(other.sinks_),
       level_(other.level_.load(std::memory_order_relaxed)),
+      inherited_level_(other.inherited_level_),
+      level_ref_(other.inherits_level() ? inherited_level_.get() : &level_),
       flush_level_(other.flush_level_.load(std::memory_order_relaxed)),
       custom_err_handler_(other.custom_err_handler_),
-      tracer_(other.tracer_) {}
+      tracer_(other.tracer_),
+      deferred_formatting_(other.deferred_formatting_),
+      clock_(other.clock_),
+      max_payload_size_(other.max_payload_size_) {}  // no metrics
 
 SPDLOG_INLINE logger::logger(logger &&other) SPDLOG_NOEXCEPT
     : name_(std::move(other.name_)),
       sinks_(std::move(other.sinks_)),
       level_(other.level_.load(std::memory_order_relaxed)),
+      inherited_level_(other.inherited_level_),
+      level_ref_(other.inherits_level() ? inherited_level_.get() : &level_),
       flush_level_(other.flush_level_.load(std::memory_order_relaxed)),
       custom_err_handler_(std::move(other.custom_err_handler_)),
-      tracer_(std::move(other.tracer_))
+      tracer_(std::move(other.tracer_)),
+      deferred_formatting_(other.deferred_formatting_),
+      clock_(other.clock_),
+      max_payload_size_(other.max_payload_size_),
+      metrics_owner_(std::move(other.metrics_owner_)),
+      metrics_(other.metrics_.exchange(nullptr))
 
 {}
 
@@ -47,6 +61,11 @@ SPDLOG_INLINE void logger::swap(spdlog::logger &other) SPDLOG_NOEXCEPT {
     auto other_level = other.level_.load();
     auto my_level = level_.exchange(other_level);
     other.level_.store(my_level);
+    auto inherits = inherits_level();
+    auto other_inherits = other.inherits_level();
+    inherited_level_.swap(other.inherited_level_);
+    level_ref_.store(other_inherits ? inherited_level_.get() : &level_);
+    other.level_ref_.store(inherits ? other.inherited_level_.get() : &other.level_);
 
     // swap flush level_
     other_level = other.flush_level_.load();
@@ -55,14 +74,40 @@ SPDLOG_INLINE void logger::swap(spdlog::logger &other) SPDLOG_NOEXCEPT {
 
     custom_err_handler_.swap(other.custom_err_handler_);
     std::swap(tracer_, other.tracer_);
+    std::swap(deferred_formatting_, other.deferred_formatting_);
+    std::swap(clock_, other.clock_);
+    std::swap(max_payload_size_, other.max_payload_size_);
+    metrics_owner_.swap(other.metrics_owner_);
+    metrics_.store(other.metrics_.exchange(metrics_.load()));
+    details::bump_level_generation();
 }
 
 SPDLOG_INLINE void swap(logger &a, logger &b) { a.swap(b); }
 
-SPDLOG_INLINE void logger::set_level(level::level_enum log_level) { level_.store(log_level); }
+SPDLOG_INLINE void logger::set_level(level::level_enum log_level) {
+    level_.store(log_level);
+    level_ref_.store(&level_, std::memory_order_release);
+    details::bump_level_generation();
+}
 
 SPDLOG_INLINE level::level_enum logger::level() const {
-    return static_cast<level::level_enum>(level_.load(std::memory_order_relaxed));
+    return static_cast<level::level_enum>(
+        level_ref_.load(std::memory_order_acquire)->load(std::memory_order_relaxed));
+}
+
+SPDLOG_INLINE void logger::inherit_level(std::shared_ptr<level_t> shared_level) {
+    if (!shared_level) {
+        level_ref_.store(&level_, std::memory_order_release);
+    } else {
+        // kept alive, the previous one being still used by the logging threads
+        inherited_level_ = std::move(shared_level);
+        level_ref_.store(inherited_level_.get(), std::memory_order_release);
+    }
+    details::bump_level_generation();
+}
+
+SPDLOG_INLINE bool logger::inherits_level() const {
+    return level_ref_.load(std::memory_order_relaxed) != &level_;
 }
 
 SPDLOG_INLINE const std::string &logger::name() const { return name_; }
@@ -86,14 +131,34 @@ SPDLOG_INLINE void logger::set_pattern(std::string pattern, pattern_time_type ti
     set_formatter(std::move(new_formatter));
 }
 
+SPDLOG_INLINE void logger::set_clock(clock_source source) { clock_ = source; }
+
+SPDLOG_INLINE clock_source logger::clock() const { return clock_; }
+
+SPDLOG_INLINE void logger::set_max_payload_size(size_t max_size) { max_payload_size_ = max_size; }
+
+SPDLOG_INLINE size_t logger::max_payload_size() const { return max_payload_size_; }
+
 // create new backtrace sink and move to it all our child sinks
-SPDLOG_INLINE void logger::enable_backtrace(size_t n_messages) { tracer_.enable(n_messages); }
+SPDLOG_INLINE void logger::enable_backtrace(size_t n_messages) {
+    tracer_.enable(n_messages);
+    details::bump_level_generation();
+}
 
 // restore orig sinks and level and delete the backtrace sink
-SPDLOG_INLINE void logger::disable_backtrace() { tracer_.disable(); }
+SPDLOG_INLINE void logger::disable_backtrace() {
+    tracer_.disable();
+    details::bump_level_generation();
+}
 
 SPDLOG_INLINE void logger::dump_backtrace() { dump_backtrace_(); }
 
+SPDLOG_INLINE void logger::visit_backtrace_unsafe(
+    void (*fn)(const details::log_msg &, details::deferred_format_fn, void *),
+    void *context) const {
+    tracer_.visit_unsafe(fn, context);
+}
+
 // flush functions
 SPDLOG_INLINE void logger::flush() { flush_(); }
 
@@ -110,7 +175,34 @@ SPDLOG_INLINE std::vector<sink_ptr> &logger::sinks() { return sinks_; }
 
 // error handler
 SPDLOG_INLINE void logger::set_error_handler(err_handler handler) {
-    custom_err_handler_ = std::move(handler);
+    custom_err_handler_ =
+        handler ? std::make_shared<const err_handler>(std::move(handler)) : nullptr;
+}
+
+SPDLOG_INLINE void logger::enable_metrics() {
+    if (metrics_.load(std::memory_order_acquire) != nullptr) {
+        return;
+    }
+    auto metrics = details::make_unique<details::logger_metrics>(sinks_);
+    details::logger_metrics *expected = nullptr;
+    if (metrics_.compare_exchange_strong(expected, metrics.get(), std::memory_order_acq_rel)) {
+        metrics_owner_ = std::move(metrics);
+    }
+}
+
+SPDLOG_INLINE bool logger::metrics_enabled() const {
+    return metrics_.load(std::memory_order_relaxed) != nullptr;
+}
+
+SPDLOG_INLINE logger_metrics_snapshot logger::metrics_snapshot() const {
+    auto *metrics = metrics_.load(std::memory_order_acquire);
+    return metrics != nullptr ? metrics->snapshot() : logger_metrics_snapshot{};
+}
+
+SPDLOG_INLINE void logger::reset_metrics() {
+    if (auto *metrics = metrics_.load(std::memory_order_acquire)) {
+        metrics->reset();
+    }
 }
 
 // create new logger with same sinks and configuration.
@@ -121,10 +213,30 @@ SPDLOG_INLINE std::shared_ptr<logger> logger::clone(std::string logger_name) {
 }
 
 // protected methods
+SPDLOG_INLINE void logger::log_kv_(source_loc loc,
+                                   level::level_enum lvl,
+                                   string_view_t msg,
+                                   const kv_field *fields,
+                                   size_t count) {
+    bool log_enabled = should_log(lvl);
+    bool traceback_enabled = tracer_.enabled();
+    if (!log_enabled && !traceback_enabled) {
+        return;
+    }
+    details::log_msg log_msg(loc, name_, lvl, msg, needed_fields_(lvl, traceback_enabled),
+                             clock_);
+    log_msg.kv_fields = fields;
+    log_msg.kv_count = count;
+    log_it_(log_msg, log_enabled, traceback_enabled);
+}
+
 SPDLOG_INLINE void logger::log_it_(const spdlog::details::log_msg &log_msg,
                                    bool log_enabled,
                                    bool traceback_enabled) {
     if (log_enabled) {
+        if (auto *metrics = metrics_.load(std::memory_order_acquire)) {
+            metrics->count(log_msg.level, log_msg.payload.size());
+        }
         sink_it_(log_msg);
     }
     if (traceback_enabled) {
@@ -132,11 +244,51 @@ SPDLOG_INLINE void logger::log_it_(const spdlog::details::log_msg &log_msg,
     }
 }
 
-SPDLOG_INLINE void logger::sink_it_(const details::log_msg &msg) {
+SPDLOG_INLINE void logger::log_truncated_(details::log_msg &log_msg,
+                                         bool log_enabled,
+                                         bool traceback_enabled) {
+    details::scratch_buffer<memory_buf_t> scratch;
+    auto &buf = scratch.buf();
+    details::fmt_helper::append_capped(log_msg.payload, max_payload_size_, buf);
+    log_msg.payload = string_view_t(buf.data(), buf.size());
+    log_it_(log_msg, log_enabled, traceback_enabled);
+}
+
+SPDLOG_INLINE unsigned logger::needed_fields_(level::level_enum lvl,
+                                              bool traceback_enabled) const {
+    if (traceback_enabled) {
+        return msg_field::all;
+    }
+    unsigned fields = msg_field::none;
     for (auto &sink : sinks_) {
-        if (sink->should_log(msg.level)) {
+        if (sink->should_log(lvl)) {
+            fields |= sink->needed_fields();
+        }
+    }
+    return fields;
+}
+
+SPDLOG_INLINE void logger::sink_it_(const details::log_msg &msg) {
+    if (msg.tsc_time) {
+        details::log_msg resolved(msg);
+        resolved.resolve_time();
+        logger::sink_it_(resolved);
+        return;
+    }
+    // sinks with identical formatters share the formatted message
+    details::shared_format_scope shared_format(msg, sinks_.size() > 1);
+    auto *metrics = metrics_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < sinks_.size(); i++) {
+        auto &sink = sinks_[i];
+        if (sink->should_log(msg)) {
+            auto *write_time = metrics != nullptr ? metrics->write_time(i, sink.get()) : nullptr;
+            auto start = write_time != nullptr ? details::logger_metrics::clock::now()
+                                               : details::logger_metrics::clock::time_point{};
             SPDLOG_TRY { sink->log(msg); }
-            SPDLOG_LOGGER_CATCH(msg.source)
+            SPDLOG_SINK_CATCH(*sink, msg.source)
+            if (write_time != nullptr) {
+                write_time->record(details::logger_metrics::clock::now() - start);
+            }
         }
     }
 
@@ -145,10 +297,23 @@ SPDLOG_INLINE void logger::sink_it_(const details::log_msg &msg) {
     }
 }
 
+SPDLOG_INLINE void logger::sink_deferred_(const details::log_msg &msg,
+                                          details::deferred_format_fn format_fn) {
+    memory_buf_t buf;
+    format_fn(msg.payload, buf);
+    details::log_msg formatted_msg(msg);
+    formatted_msg.payload = string_view_t(buf.data(), buf.size());
+    formatted_msg.static_payload = false;
+    sink_it_(formatted_msg);
+}
+
 SPDLOG_INLINE void logger::flush_() {
     for (auto &sink : sinks_) {
+        if (sink->suspended()) {
+            continue;
+        }
         SPDLOG_TRY { sink->flush(); }
-        SPDLOG_LOGGER_CATCH(source_loc())
+        SPDLOG_SINK_CATCH(*sink, source_loc())
     }
 }
 
@@ -157,7 +322,14 @@ SPDLOG_INLINE void logger::dump_backtrace_() {
     if (tracer_.enabled() && !tracer_.empty()) {
         sink_it_(
             log_msg{name(), level::info, "****************** Backtrace Start ******************"});
-        tracer_.foreach_pop([this](const log_msg &msg) { this->sink_it_(msg); });
+        tracer_.foreach_pop([this](const log_msg &msg, details::deferred_format_fn format_fn) {
+            if (format_fn == nullptr) {
+                this->sink_it_(msg);
+                return;
+            }
+            SPDLOG_TRY { this->sink_deferred_(msg, format_fn); }
+            SPDLOG_LOGGER_CATCH(msg.source)
+        });
         sink_it_(
             log_msg{name(), level::info, "****************** Backtrace End ********************"});
     }
@@ -170,27 +342,30 @@ SPDLOG_INLINE bool logger::should_flush_(const details::log_msg &msg) {
 
 SPDLOG_INLINE void logger::err_handler_(const std::string &msg) {
     if (custom_err_handler_) {
-        custom_err_handler_(msg);
+        (*custom_err_handler_)(msg);
     } else {
         using std::chrono::system_clock;
-        static std::mutex mutex;
-        static std::chrono::system_clock::time_point last_report_time;
-        static size_t err_counter = 0;
-        std::lock_guard<std::mutex> lk{mutex};
+        // lock free: the thread which moves the report time forward reports the error
+        static std::atomic<system_clock::rep> last_report_time{0};
+        static std::atomic<size_t> err_counter{0};
         auto now = system_clock::now();
-        err_counter++;
-        if (now - last_report_time < std::chrono::seconds(1)) {
+        auto err_count = err_counter.fetch_add(1, std::memory_order_relaxed) + 1;
+        auto last_report = last_report_time.load(std::memory_order_relaxed);
+        if (now - system_clock::time_point(system_clock::duration(last_report)) <
+                std::chrono::seconds(1) ||
+            !last_report_time.compare_exchange_strong(last_report,
+                                                      now.time_since_epoch().count(),
+                                                      std::memory_order_relaxed)) {
             return;
         }
-        last_report_time = now;
         auto tm_time = details::os::localtime(system_clock::to_time_t(now));
         char date_buf[64];
         std::strftime(date_buf, sizeof(date_buf), "%Y-%m-%d %H:%M:%S", &tm_time);
 #if defined(USING_R) && defined(R_R_H)  // if in R environment
-        REprintf("[*** LOG ERROR #%04zu ***] [%s] [%s] %s\n", err_counter, date_buf, name().c_str(),
+        REprintf("[*** LOG ERROR #%04zu ***] [%s] [%s] %s\n", err_count, date_buf, name().c_str(),
                  msg.c_str());
 #else
-        std::fprintf(stderr, "[*** LOG ERROR #%04zu ***] [%s] [%s] %s\n", err_counter, date_buf,
+        std::fprintf(stderr, "[*** LOG ERROR #%04zu ***] [%s] [%s] %s\n", err_count, date_buf,
                      name().c_str(), msg.c_str());
 #endif
     }
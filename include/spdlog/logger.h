@@ -16,13 +16,20 @@
 
 #include <spdlog/common.h>
 #include <spdlog/details/backtracer.h>
+#include <spdlog/details/deferred_args.h>
+#include <spdlog/details/fmt_helper.h>
 #include <spdlog/details/log_msg.h>
+#include <spdlog/details/message_args.h>
+#include <spdlog/details/scratch_buffer.h>
+#include <spdlog/log_limiter.h>
+#include <spdlog/logger_metrics.h>
 
 #ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
     #ifndef _WIN32
         #error SPDLOG_WCHAR_TO_UTF8_SUPPORT only supported on windows
     #endif
     #include <spdlog/details/os.h>
+    #include <spdlog/details/utf8.h>
 #endif
 
 #include <vector>
@@ -41,13 +48,26 @@
             err_handler_("Rethrowing unknown exception in logger");                       \
             throw;                                                                        \
         }
+    // same, for a failure of the given sink, which is suspended if it retries later
+    #define SPDLOG_SINK_CATCH(sink, location) \
+        catch (...) {                          \
+            (sink).on_error();                 \
+            SPDLOG_TRY { throw; }              \
+            SPDLOG_LOGGER_CATCH(location)      \
+        }
 #else
     #define SPDLOG_LOGGER_CATCH(location)
+    #define SPDLOG_SINK_CATCH(sink, location)
 #endif
 
 namespace spdlog {
+namespace details {
+class registry;
+}
 
 class SPDLOG_API logger {
+    friend class details::registry;  // shares its error handler
+
 public:
     // Empty logger
     explicit logger(std::string name)
@@ -85,6 +105,23 @@ public:
         log(source_loc{}, lvl, fmt, std::forward<Args>(args)...);
     }
 
+#ifndef SPDLOG_USE_STD_FORMAT
+    // format string made by FMT_COMPILE(): parsed at compile time instead of on each call
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void log(source_loc loc, level::level_enum lvl, const S &fmt, Args &&...args) {
+        log_compiled_(loc, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void log(level::level_enum lvl, const S &fmt, Args &&...args) {
+        log(source_loc{}, lvl, fmt, std::forward<Args>(args)...);
+    }
+#endif
+
     template <typename T>
     void log(level::level_enum lvl, const T &msg) {
         log(source_loc{}, lvl, msg);
@@ -109,6 +146,10 @@ public:
         }
 
         details::log_msg log_msg(log_time, loc, name_, lvl, msg);
+        if (max_payload_size_ != 0 && msg.size() > max_payload_size_) {
+            log_truncated_(log_msg, log_enabled, traceback_enabled);
+            return;
+        }
         log_it_(log_msg, log_enabled, traceback_enabled);
     }
 
@@ -119,12 +160,82 @@ public:
             return;
         }
 
-        details::log_msg log_msg(loc, name_, lvl, msg);
+        details::log_msg log_msg(loc, name_, lvl, msg,
+                                 needed_fields_(lvl, traceback_enabled), clock_);
+        if (max_payload_size_ != 0 && msg.size() > max_payload_size_) {
+            log_truncated_(log_msg, log_enabled, traceback_enabled);
+            return;
+        }
         log_it_(log_msg, log_enabled, traceback_enabled);
     }
 
     void log(level::level_enum lvl, string_view_t msg) { log(source_loc{}, lvl, msg); }
 
+    // a string literal, neither formatted nor copied into the queued messages (see static_msg)
+    void log(source_loc loc, level::level_enum lvl, static_msg msg) {
+        bool log_enabled = should_log(lvl);
+        bool traceback_enabled = tracer_.enabled();
+        if (!log_enabled && !traceback_enabled) {
+            return;
+        }
+
+        details::log_msg log_msg(loc, name_, lvl, msg.text,
+                                 needed_fields_(lvl, traceback_enabled), clock_);
+        log_msg.static_payload = true;
+        log_it_(log_msg, log_enabled, traceback_enabled);
+    }
+
+    void log(level::level_enum lvl, static_msg msg) { log(source_loc{}, lvl, msg); }
+
+    // message with typed fields (see kv.h), not formatted into the text:
+    // logger->info("request done", spdlog::kv("latency_us", 42), spdlog::kv("status", 200));
+    // the fields are taken by value so that these overloads are preferred to the format
+    // string ones, which would need the fields to be formattable.
+    template <typename... Fields>
+    void log(source_loc loc,
+             level::level_enum lvl,
+             const char *msg,
+             kv_field field,
+             Fields... fields) {
+        const kv_field all_fields[] = {field, fields...};
+        log_kv_(loc, lvl, msg, all_fields, 1 + sizeof...(fields));
+    }
+
+    template <typename... Fields>
+    void log(level::level_enum lvl, const char *msg, kv_field field, Fields... fields) {
+        log(source_loc{}, lvl, msg, field, fields...);
+    }
+
+    template <typename... Fields>
+    void trace(const char *msg, kv_field field, Fields... fields) {
+        log(level::trace, msg, field, fields...);
+    }
+
+    template <typename... Fields>
+    void debug(const char *msg, kv_field field, Fields... fields) {
+        log(level::debug, msg, field, fields...);
+    }
+
+    template <typename... Fields>
+    void info(const char *msg, kv_field field, Fields... fields) {
+        log(level::info, msg, field, fields...);
+    }
+
+    template <typename... Fields>
+    void warn(const char *msg, kv_field field, Fields... fields) {
+        log(level::warn, msg, field, fields...);
+    }
+
+    template <typename... Fields>
+    void error(const char *msg, kv_field field, Fields... fields) {
+        log(level::err, msg, field, fields...);
+    }
+
+    template <typename... Fields>
+    void critical(const char *msg, kv_field field, Fields... fields) {
+        log(level::critical, msg, field, fields...);
+    }
+
     template <typename... Args>
     void trace(format_string_t<Args...> fmt, Args &&...args) {
         log(level::trace, fmt, std::forward<Args>(args)...);
@@ -177,7 +288,7 @@ public:
         }
 
         memory_buf_t buf;
-        details::os::wstr_to_utf8buf(wstring_view_t(msg.data(), msg.size()), buf);
+        details::append_utf16_as_utf8(msg.data(), msg.size(), buf);
         details::log_msg log_msg(log_time, loc, name_, lvl, string_view_t(buf.data(), buf.size()));
         log_it_(log_msg, log_enabled, traceback_enabled);
     }
@@ -190,8 +301,9 @@ public:
         }
 
         memory_buf_t buf;
-        details::os::wstr_to_utf8buf(wstring_view_t(msg.data(), msg.size()), buf);
-        details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
+        details::append_utf16_as_utf8(msg.data(), msg.size(), buf);
+        details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()),
+                                 needed_fields_(lvl, traceback_enabled), clock_);
         log_it_(log_msg, log_enabled, traceback_enabled);
     }
 
@@ -228,6 +340,50 @@ public:
     }
 #endif
 
+#ifndef SPDLOG_USE_STD_FORMAT
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void trace(const S &fmt, Args &&...args) {
+        log(level::trace, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void debug(const S &fmt, Args &&...args) {
+        log(level::debug, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void info(const S &fmt, Args &&...args) {
+        log(level::info, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void warn(const S &fmt, Args &&...args) {
+        log(level::warn, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void error(const S &fmt, Args &&...args) {
+        log(level::err, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void critical(const S &fmt, Args &&...args) {
+        log(level::critical, fmt, std::forward<Args>(args)...);
+    }
+#endif
+
     template <typename T>
     void trace(const T &msg) {
         log(level::trace, msg);
@@ -258,18 +414,115 @@ public:
         log(level::critical, msg);
     }
 
+    // log only if the limiter allows it (see log_limiter), the number of messages suppressed
+    // since the previous one being appended to the message. the messages below the level are
+    // not counted, nor kept for the backtrace.
+    template <typename... Args>
+    void log_limited(log_limiter &limiter,
+                     source_loc loc,
+                     level::level_enum lvl,
+                     format_string_t<Args...> fmt,
+                     Args &&...args) {
+        if (!should_log(lvl)) {
+            return;
+        }
+        std::uint64_t suppressed;
+        if (!limiter.allow(suppressed)) {
+            return;
+        }
+        if (suppressed == 0) {
+            log_(loc, lvl, details::to_string_view(fmt), std::forward<Args>(args)...);
+            return;
+        }
+        log_suppressed_(loc, lvl, suppressed, details::to_string_view(fmt),
+                        std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void log_limited(log_limiter &limiter,
+                     level::level_enum lvl,
+                     format_string_t<Args...> fmt,
+                     Args &&...args) {
+        log_limited(limiter, source_loc{}, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    // log regardless of the logger's level, the sinks' levels still applying: for the levels
+    // set per source file (see cfg::helpers::load_vmodule), checked by the logging macros.
+    template <typename... Args>
+    void log_forced(source_loc loc,
+                    level::level_enum lvl,
+                    format_string_t<Args...> fmt,
+                    Args &&...args) {
+        SPDLOG_TRY {
+            details::scratch_buffer<memory_buf_t> scratch;
+            auto &buf = scratch.buf();
+            format_payload_(buf, details::to_string_view(fmt), args...);
+            log_forced(loc, lvl, string_view_t(buf.data(), buf.size()));
+        }
+        SPDLOG_LOGGER_CATCH(loc)
+    }
+
+#ifndef SPDLOG_USE_STD_FORMAT
+    template <typename S,
+              typename... Args,
+              typename std::enable_if<is_compiled_format_string<S>::value, int>::type = 0>
+    void log_forced(source_loc loc, level::level_enum lvl, const S &fmt, Args &&...args) {
+        SPDLOG_TRY {
+            details::scratch_buffer<memory_buf_t> scratch;
+            auto &buf = scratch.buf();
+            auto *metrics = metrics_.load(std::memory_order_acquire);
+            auto format_start = metrics != nullptr ? details::logger_metrics::clock::now()
+                                                   : details::logger_metrics::clock::time_point{};
+            format_compiled_payload_(buf, fmt, std::forward<Args>(args)...);
+            if (metrics != nullptr) {
+                metrics->record_format(details::logger_metrics::clock::now() - format_start);
+            }
+            log_forced(loc, lvl, string_view_t(buf.data(), buf.size()));
+        }
+        SPDLOG_LOGGER_CATCH(loc)
+    }
+#endif
+
+    template <class T,
+              typename std::enable_if<!is_convertible_to_any_format_string<const T &>::value,
+                                      int>::type = 0>
+    void log_forced(source_loc loc, level::level_enum lvl, const T &msg) {
+        log_forced(loc, lvl, "{}", msg);
+    }
+
+    void log_forced(source_loc loc, level::level_enum lvl, string_view_t msg) {
+        bool traceback_enabled = tracer_.enabled();
+        details::log_msg log_msg(loc, name_, lvl, msg, needed_fields_(lvl, traceback_enabled),
+                                 clock_);
+        if (max_payload_size_ != 0 && msg.size() > max_payload_size_) {
+            log_truncated_(log_msg, true, traceback_enabled);
+            return;
+        }
+        log_it_(log_msg, true, traceback_enabled);
+    }
+
     // return true logging is enabled for the given level.
     bool should_log(level::level_enum msg_level) const {
-        return msg_level >= level_.load(std::memory_order_relaxed);
+        // the level of its own, or inherited
+        auto level_ref = level_ref_.load(std::memory_order_acquire);
+        return msg_level >= level_ref->load(std::memory_order_relaxed);
     }
 
     // return true if backtrace logging is enabled.
     bool should_backtrace() const { return tracer_.enabled(); }
 
+    // set the level of its own, no longer following the level inherited by inherit_level()
     void set_level(level::level_enum log_level);
 
     level::level_enum level() const;
 
+    // follow the level shared by a tree of loggers (see spdlog::set_tree_level) instead of its
+    // own, until set_level() is called. shared_level must outlive its use by the logging
+    // threads (the registry keeps its levels).
+    void inherit_level(std::shared_ptr<level_t> shared_level);
+
+    bool inherits_level() const;
+
     const std::string &name() const;
 
     // set formatting for the sinks in this logger.
@@ -282,11 +535,29 @@ public:
     // Note: each sink will get a new instance of a formatter object, replacing the old one.
     void set_pattern(std::string pattern, pattern_time_type time_type = pattern_time_type::local);
 
+    // clock the message times are read from (the log calls given a time point don't use it).
+    // not thread safe: set it before logging.
+    void set_clock(clock_source source);
+    clock_source clock() const;
+
+    // cap the payloads at max_size bytes (0, the default, for no cap): formatting stops storing
+    // its output there, so a huge container or string doesn't format megabytes into the buffers
+    // and the queues. a payload cut is cut at a UTF-8 boundary and ends with
+    // SPDLOG_TRUNCATION_MARKER. the cap applies to the plain strings logged too.
+    // not thread safe: set it before logging.
+    void set_max_payload_size(size_t max_size);
+    size_t max_payload_size() const;
+
     // backtrace support.
     // efficiently store all debug/trace messages in a circular buffer until needed for debugging.
     void enable_backtrace(size_t n_messages);
     void disable_backtrace();
     void dump_backtrace();
+    // call fn(msg, format_fn, context) on each message dump_backtrace() would log, without
+    // locking nor allocating, for a crash handler (see crash_dump.h)
+    void visit_backtrace_unsafe(
+        void (*fn)(const details::log_msg &, details::deferred_format_fn, void *),
+        void *context) const;
 
     // flush functions
     void flush();
@@ -301,6 +572,15 @@ public:
     // error handler
     void set_error_handler(err_handler);
 
+    // metrics (see logger_metrics.h): off by default, then a relaxed load per message.
+    // enable_metrics() starts them for the current sinks and does nothing if already enabled;
+    // copies and clones of the logger start without metrics.
+    void enable_metrics();
+    bool metrics_enabled() const;
+    // all zero (and no sink) if not enabled
+    logger_metrics_snapshot metrics_snapshot() const;
+    void reset_metrics();
+
     // create new logger with same sinks and configuration.
     virtual std::shared_ptr<logger> clone(std::string logger_name);
 
@@ -308,9 +588,18 @@ protected:
     std::string name_;
     std::vector<sink_ptr> sinks_;
     spdlog::level_t level_{level::info};
+    std::shared_ptr<level_t> inherited_level_;  // the last one inherited
+    std::atomic<level_t *> level_ref_{&level_};  // &level_ or inherited_level_.get()
     spdlog::level_t flush_level_{level::off};
-    err_handler custom_err_handler_{nullptr};
-    details::backtracer tracer_;
+    // shared by the copies and clones, and by the loggers given the registry's handler
+    std::shared_ptr<const err_handler> custom_err_handler_;
+    details::backtracer tracer_;  // allocates nothing until enabled
+    // pack the arguments and let sink_deferred_() format them (see async_logger)
+    bool deferred_formatting_{false};
+    clock_source clock_{clock_source::standard};
+    size_t max_payload_size_{0};
+    std::unique_ptr<details::logger_metrics> metrics_owner_;
+    std::atomic<details::logger_metrics *> metrics_{nullptr};  // metrics_owner_.get() once set
 
     // common implementation for after templated public api has been resolved
     template <typename... Args>
@@ -321,18 +610,189 @@ protected:
             return;
         }
         SPDLOG_TRY {
-            memory_buf_t buf;
+            if (!log_enabled && trace_deferred_(loc, lvl, fmt, args...)) {
+                return;
+            }
+            if (deferred_formatting_ && !traceback_enabled && max_payload_size_ == 0 &&
+                log_deferred_(loc, lvl, fmt, args...)) {
+                return;
+            }
+            details::scratch_buffer<memory_buf_t> scratch;
+            auto &buf = scratch.buf();
+            auto *metrics = metrics_.load(std::memory_order_acquire);
+            auto format_start = metrics != nullptr ? details::logger_metrics::clock::now()
+                                                   : details::logger_metrics::clock::time_point{};
+            format_payload_(buf, fmt, args...);
+            if (metrics != nullptr) {
+                metrics->record_format(details::logger_metrics::clock::now() - format_start);
+            }
+
+            auto fields = needed_fields_(lvl, traceback_enabled);
+            details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()),
+                                     fields, clock_);
+            if (fields & msg_field::arguments) {
+                log_with_args_(log_msg, log_enabled, traceback_enabled, fmt, args...);
+            } else {
+                log_it_(log_msg, log_enabled, traceback_enabled);
+            }
+        }
+        SPDLOG_LOGGER_CATCH(loc)
+    }
+
+    // format the payload into buf, up to max_payload_size_ if set
+    template <typename... Args>
+    void format_payload_(memory_buf_t &buf, string_view_t fmt, Args &...args) {
+        if (max_payload_size_ != 0) {
+            details::fmt_helper::vformat_to_capped(buf, max_payload_size_, fmt,
+                                                   fmt_lib::make_format_args(args...));
+            return;
+        }
 #ifdef SPDLOG_USE_STD_FORMAT
-            fmt_lib::vformat_to(std::back_inserter(buf), fmt, fmt_lib::make_format_args(args...));
+        details::fmt_helper::vformat_to(buf, fmt, fmt_lib::make_format_args(args...));
 #else
-            fmt::vformat_to(fmt::appender(buf), fmt, fmt::make_format_args(args...));
+        fmt::vformat_to(fmt::appender(buf), fmt, fmt::make_format_args(args...));
+#endif
+    }
+
+#ifndef SPDLOG_USE_STD_FORMAT
+    template <typename S, typename... Args>
+    void format_compiled_payload_(memory_buf_t &buf, const S &fmt, Args &&...args) {
+        using details::fmt_helper::truncating_appender;
+        if (max_payload_size_ != 0) {
+            details::fmt_helper::format_capped(
+                buf, max_payload_size_, [&](truncating_appender out) {
+                    return fmt::format_to(out, fmt, std::forward<Args>(args)...);
+                });
+            return;
+        }
+        fmt::format_to(fmt::appender(buf), fmt, std::forward<Args>(args)...);
+    }
 #endif
 
-            details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
+    // log_it_() with the payload cut at max_payload_size_
+    void log_truncated_(details::log_msg &log_msg, bool log_enabled, bool traceback_enabled);
+
+    // log_it_() with the format string and the arguments attached (see msg_field::arguments)
+    template <typename... Args,
+              typename std::enable_if<details::has_message_args<Args...>::value, int>::type = 0>
+    void log_with_args_(details::log_msg &log_msg,
+                        bool log_enabled,
+                        bool traceback_enabled,
+                        string_view_t fmt,
+                        const Args &...args) {
+        kv_field arg_fields[] = {details::message_arg(args)..., kv_field()};  // not empty
+        log_msg.format = fmt;
+        log_msg.args = arg_fields;
+        log_msg.arg_count = sizeof...(Args);
+        log_it_(log_msg, log_enabled, traceback_enabled);
+    }
+
+    template <typename... Args,
+              typename std::enable_if<!details::has_message_args<Args...>::value, int>::type = 0>
+    void log_with_args_(details::log_msg &log_msg,
+                        bool log_enabled,
+                        bool traceback_enabled,
+                        string_view_t,
+                        const Args &...) {
+        log_it_(log_msg, log_enabled, traceback_enabled);
+    }
+
+#ifndef SPDLOG_USE_STD_FORMAT
+    template <typename S, typename... Args>
+    void log_compiled_(source_loc loc, level::level_enum lvl, const S &fmt, Args &&...args) {
+        bool log_enabled = should_log(lvl);
+        bool traceback_enabled = tracer_.enabled();
+        if (!log_enabled && !traceback_enabled) {
+            return;
+        }
+        SPDLOG_TRY {
+            if (!log_enabled && trace_deferred_(loc, lvl, string_view_t(fmt), args...)) {
+                return;
+            }
+            if (deferred_formatting_ && !traceback_enabled && max_payload_size_ == 0 &&
+                log_deferred_(loc, lvl, string_view_t(fmt), args...)) {
+                return;
+            }
+            details::scratch_buffer<memory_buf_t> scratch;
+            auto &buf = scratch.buf();
+            format_compiled_payload_(buf, fmt, std::forward<Args>(args)...);
+            details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()),
+                                     needed_fields_(lvl, traceback_enabled), clock_);
             log_it_(log_msg, log_enabled, traceback_enabled);
         }
         SPDLOG_LOGGER_CATCH(loc)
     }
+#endif
+
+    // pack the arguments instead of formatting them.
+    // return false if they can't be packed, to format them right away instead.
+    template <typename... Args,
+              typename std::enable_if<details::is_deferrable<Args...>::value, int>::type = 0>
+    bool log_deferred_(source_loc loc,
+                       level::level_enum lvl,
+                       string_view_t fmt,
+                       const Args &...args) {
+        memory_buf_t packed;
+        if (!details::pack_deferred(packed, fmt, args...)) {
+            return false;
+        }
+        details::log_msg log_msg(loc, name_, lvl, string_view_t(packed.data(), packed.size()),
+                                 needed_fields_(lvl, false), clock_);
+        if (auto *metrics = metrics_.load(std::memory_order_acquire)) {
+            metrics->count(lvl, 0);  // the formatted bytes are added by the async logger
+        }
+        sink_deferred_(log_msg, details::deferred_formatter<Args...>());
+        return true;
+    }
+
+    template <typename... Args,
+              typename std::enable_if<!details::is_deferrable<Args...>::value, int>::type = 0>
+    bool log_deferred_(source_loc, level::level_enum, string_view_t, const Args &...) {
+        return false;
+    }
+
+    // the message followed by " (<suppressed> suppressed)"
+    template <typename... Args>
+    void log_suppressed_(source_loc loc,
+                         level::level_enum lvl,
+                         std::uint64_t suppressed,
+                         string_view_t fmt,
+                         Args &&...args) {
+        SPDLOG_TRY {
+            details::scratch_buffer<memory_buf_t> scratch;
+            auto &buf = scratch.buf();
+            format_payload_(buf, fmt, args...);
+            details::fmt_helper::append_string_view(" (", buf);
+            details::fmt_helper::append_int(suppressed, buf);
+            details::fmt_helper::append_string_view(" suppressed)", buf);
+            log(loc, lvl, string_view_t(buf.data(), buf.size()));
+        }
+        SPDLOG_LOGGER_CATCH(loc)
+    }
+
+    // only for the backtrace: pack the arguments, formatted only if the backtrace is dumped.
+    // return false if they can't be packed.
+    template <typename... Args,
+              typename std::enable_if<details::is_deferrable<Args...>::value, int>::type = 0>
+    bool trace_deferred_(source_loc loc,
+                         level::level_enum lvl,
+                         string_view_t fmt,
+                         const Args &...args) {
+        memory_buf_t packed;
+        if (!details::pack_deferred(packed, fmt, args...)) {
+            return false;
+        }
+        details::log_msg log_msg(loc, name_, lvl, string_view_t(packed.data(), packed.size()),
+                                 needed_fields_(lvl, true), clock_);
+        tracer_.push_back(log_msg, details::deferred_formatter<Args...>());
+        return true;
+    }
+
+    template <typename... Args,
+              typename std::enable_if<!details::is_deferrable<Args...>::value, int>::type = 0>
+    bool trace_deferred_(source_loc, level::level_enum, string_view_t, const Args &...) {
+        return false;
+    }
 
 #ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
     template <typename... Args>
@@ -343,24 +803,40 @@ protected:
             return;
         }
         SPDLOG_TRY {
-            // format to wmemory_buffer and convert to utf8
-            wmemory_buf_t wbuf;
+            // format to the wide buffer of the thread (kept for its capacity), and convert it
+            // in one pass to utf8
+            details::scratch_buffer<wmemory_buf_t> wide_scratch;
+            auto &wbuf = wide_scratch.buf();
             fmt_lib::vformat_to(std::back_inserter(wbuf), fmt,
                                 fmt_lib::make_format_args<fmt_lib::wformat_context>(args...));
 
-            memory_buf_t buf;
-            details::os::wstr_to_utf8buf(wstring_view_t(wbuf.data(), wbuf.size()), buf);
-            details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
+            details::scratch_buffer<memory_buf_t> scratch;
+            auto &buf = scratch.buf();
+            details::append_utf16_as_utf8(wbuf.data(), wbuf.size(), buf);
+            details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()),
+                                     needed_fields_(lvl, traceback_enabled), clock_);
             log_it_(log_msg, log_enabled, traceback_enabled);
         }
         SPDLOG_LOGGER_CATCH(loc)
     }
+
 #endif  // SPDLOG_WCHAR_TO_UTF8_SUPPORT
 
     // log the given message (if the given log level is high enough),
     // and save backtrace (if backtrace is enabled).
     void log_it_(const details::log_msg &log_msg, bool log_enabled, bool traceback_enabled);
+    void log_kv_(source_loc loc,
+                 level::level_enum lvl,
+                 string_view_t msg,
+                 const kv_field *fields,
+                 size_t count);
+    // the msg_field bits of the fields read by the sinks logging lvl (all the fields if the
+    // message goes to the backtrace, which may be dumped to other sinks).
+    unsigned needed_fields_(level::level_enum lvl, bool traceback_enabled) const;
     virtual void sink_it_(const details::log_msg &msg);
+    // sink a message whose payload holds packed arguments, formatted by format_fn.
+    // the default formats it right away.
+    virtual void sink_deferred_(const details::log_msg &msg, details::deferred_format_fn format_fn);
     virtual void flush_();
     void dump_backtrace_();
     bool should_flush_(const details::log_msg &msg);
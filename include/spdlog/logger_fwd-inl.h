@@ -0,0 +1,28 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Definitions of the functions of logger_fwd.h. Not inline: included by one translation unit
+// only (src/spdlog.cpp or spdlog/instantiate.h).
+
+#include <spdlog/logger_fwd.h>
+#include <spdlog/spdlog.h>
+
+namespace spdlog {
+namespace fwd {
+
+std::shared_ptr<logger> get(const std::string &name) { return spdlog::get(name); }
+
+std::shared_ptr<logger> default_logger() { return spdlog::default_logger(); }
+
+bool should_log(const logger &logger, level::level_enum lvl) { return logger.should_log(lvl); }
+
+void log(logger &logger, level::level_enum lvl, const char *msg, size_t size) {
+    logger.log(lvl, string_view_t(msg, size));
+}
+
+void flush(logger &logger) { logger.flush(); }
+
+}  // namespace fwd
+}  // namespace spdlog
@@ -0,0 +1,40 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Logging through a logger without including spdlog.h, i.e. without fmt and the formatters,
+// for translation units which only pass ready strings on.
+// e.g. spdlog::fwd::log(*spdlog::fwd::get("net"), spdlog::level::warn, "connection lost");
+//
+// The functions are compiled in the library, or in the translation unit including
+// spdlog/instantiate.h in a header-only build.
+
+#include <spdlog/details/api.h>
+#include <spdlog/details/level_enum.h>
+#include <spdlog/fwd.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace spdlog {
+namespace fwd {
+
+// the logger registered with this name or null
+SPDLOG_API std::shared_ptr<logger> get(const std::string &name);
+
+SPDLOG_API std::shared_ptr<logger> default_logger();
+
+SPDLOG_API bool should_log(const logger &logger, level::level_enum lvl);
+
+SPDLOG_API void log(logger &logger, level::level_enum lvl, const char *msg, size_t size);
+
+inline void log(logger &logger, level::level_enum lvl, const std::string &msg) {
+    log(logger, lvl, msg.data(), msg.size());
+}
+
+SPDLOG_API void flush(logger &logger);
+
+}  // namespace fwd
+}  // namespace spdlog
@@ -0,0 +1,104 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Metrics of a logger, once enabled with logger::enable_metrics(): the messages logged by
+// level, the bytes of their formatted payloads, and histograms of the time spent formatting
+// the payloads and writing to each sink (in the worker thread for the async loggers).
+//
+// The counters are striped (see striped_counter) and the histogram buckets are relaxed atomic
+// increments, so the logging threads don't wait for each other or for a snapshot, which is
+// taken without any lock (and so is not an exact instant of all the metrics).
+//
+// Usage example:
+// logger->enable_metrics();
+// ...
+// auto metrics = logger->metrics_snapshot();
+// auto p99 = metrics.sinks[0].write_time.percentile(0.99);
+
+#include <spdlog/common.h>
+#include <spdlog/details/latency_histogram.h>
+#include <spdlog/details/striped_counter.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace spdlog {
+
+struct sink_metrics_snapshot {
+    sink_ptr sink;
+    latency_snapshot write_time;  // of each message to the sink
+};
+
+struct logger_metrics_snapshot {
+    std::array<std::uint64_t, level::n_levels> messages{};  // by level
+    std::uint64_t formatted_bytes = 0;                       // of the payloads
+    latency_snapshot format_time;                            // of the payloads
+    std::vector<sink_metrics_snapshot> sinks;                // those of enable_metrics()
+};
+
+namespace details {
+
+class logger_metrics {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit logger_metrics(const std::vector<sink_ptr> &sinks)
+        : sinks_(sinks.begin(), sinks.end()),
+          write_times_(new latency_histogram[sinks.size()]) {}
+
+    void count(level::level_enum lvl, size_t payload_size) SPDLOG_NOEXCEPT {
+        messages_[static_cast<size_t>(lvl)].add();
+        formatted_bytes_.add(payload_size);
+    }
+
+    void add_bytes(size_t payload_size) SPDLOG_NOEXCEPT { formatted_bytes_.add(payload_size); }
+
+    void record_format(std::chrono::nanoseconds duration) SPDLOG_NOEXCEPT {
+        format_time_.record(duration);
+    }
+
+    // the histogram of the sink at index i of the logger, if it's still the one it had when
+    // the metrics were enabled
+    latency_histogram *write_time(size_t i, const sinks::sink *sink) SPDLOG_NOEXCEPT {
+        return i < sinks_.size() && sinks_[i].get() == sink ? &write_times_[i] : nullptr;
+    }
+
+    logger_metrics_snapshot snapshot() const {
+        logger_metrics_snapshot result;
+        for (size_t i = 0; i < result.messages.size(); i++) {
+            result.messages[i] = messages_[i].load();
+        }
+        result.formatted_bytes = formatted_bytes_.load();
+        result.format_time = format_time_.snapshot();
+        for (size_t i = 0; i < sinks_.size(); i++) {
+            result.sinks.push_back(sink_metrics_snapshot{sinks_[i], write_times_[i].snapshot()});
+        }
+        return result;
+    }
+
+    void reset() SPDLOG_NOEXCEPT {
+        for (auto &counter : messages_) {
+            counter.reset();
+        }
+        formatted_bytes_.reset();
+        format_time_.reset();
+        for (size_t i = 0; i < sinks_.size(); i++) {
+            write_times_[i].reset();
+        }
+    }
+
+private:
+    striped_counter messages_[level::n_levels];
+    striped_counter formatted_bytes_;
+    latency_histogram format_time_;
+    std::vector<sink_ptr> sinks_;
+    std::unique_ptr<latency_histogram[]> write_times_;
+};
+
+}  // namespace details
+}  // namespace spdlog
@@ -0,0 +1,60 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// A logger looked up by name once, instead of at each use like spdlog::get(): the logger found
+// is kept with the registry version (see registry::version()), and looked up again only after
+// loggers were registered or dropped since. Using it then costs a compare, without hashing the
+// name nor copying a shared_ptr.
+//
+// Not thread safe: each thread is to use its own (e.g. a thread_local one at the callsite).
+// A logger dropped stays alive until the next use of the refs holding it.
+//
+// Usage example:
+// static thread_local spdlog::logger_ref net_logger("net");
+// if (net_logger) {
+//     net_logger->info("connected to {}", host);
+// }
+
+#include <spdlog/details/registry.h>
+#include <spdlog/logger.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace spdlog {
+
+class logger_ref {
+public:
+    explicit logger_ref(std::string logger_name)
+        : name_(std::move(logger_name)) {}
+
+    // the logger registered with the name, nullptr if none
+    logger *get() const {
+        auto &registry = details::registry::instance();
+        auto version = registry.version();
+        if (!resolved_ || version != version_) {
+            logger_ = registry.get(name_);
+            version_ = version;
+            resolved_ = true;
+        }
+        return logger_.get();
+    }
+
+    logger *operator->() const { return get(); }
+    explicit operator bool() const { return get() != nullptr; }
+
+    const std::string &name() const { return name_; }
+
+private:
+    std::string name_;
+    // the lookup cache
+    mutable bool resolved_ = false;
+    mutable std::uint64_t version_ = 0;
+    mutable std::shared_ptr<logger> logger_;
+};
+
+}  // namespace spdlog
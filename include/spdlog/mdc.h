@@ -7,8 +7,10 @@
     #error "This header requires thread local storage support, but SPDLOG_NO_TLS is defined."
 #endif
 
-#include <map>
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include <spdlog/common.h>
 
@@ -18,26 +20,221 @@
 // Usage example:
 // spdlog::mdc::put("mdc_key_1", "mdc_value_1");
 // spdlog::info("Hello, {}", "World!");  // => [2024-04-26 02:08:05.040] [info] [mdc_key_1:mdc_value_1] Hello, World!
+//
+// {
+//     spdlog::mdc::scoped_put request("request_id", "42");  // until the end of the scope
+//     ...
+// }
+//
+// The entries are kept sorted by key in a flat array, with the keys and values in one char
+// buffer of the thread, so once the buffers grew to the size needed, put/remove don't allocate
+// and the formatters walk the entries in order without any lookup.
 
 namespace spdlog {
 class SPDLOG_API mdc {
 public:
-    using mdc_map_t = std::map<std::string, std::string>;
+    struct entry {
+        string_view_t first;   // key
+        string_view_t second;  // value
+    };
+
+    class context {
+    public:
+        size_t size() const { return entries_.size(); }
+        bool empty() const { return entries_.empty(); }
+
+        entry operator[](size_t i) const {
+            const auto &e = entries_[i];
+            return entry{string_view_t(chars_.data() + e.key, e.key_size),
+                         string_view_t(chars_.data() + e.value, e.value_size)};
+        }
+
+        class iterator {
+        public:
+            iterator(const context *ctx, size_t i)
+                : ctx_(ctx),
+                  i_(i) {}
+            entry operator*() const { return (*ctx_)[i_]; }
+            iterator &operator++() {
+                ++i_;
+                return *this;
+            }
+            bool operator==(const iterator &other) const { return i_ == other.i_; }
+            bool operator!=(const iterator &other) const { return i_ != other.i_; }
+
+        private:
+            const context *ctx_;
+            size_t i_;
+        };
+
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, entries_.size()); }
+
+        void put(string_view_t key, string_view_t value) {
+            if (aliases_(key) || aliases_(value)) {  // e.g. a value got from this context
+                std::string key_copy(key.data(), key.size());
+                std::string value_copy(value.data(), value.size());
+                put(key_copy, value_copy);
+                return;
+            }
+            auto it = lower_bound_(key);
+            auto index = static_cast<size_t>(it - entries_.begin());
+            if (it != entries_.end() && key_of_(*it) == key) {
+                if (value.size() <= it->value_size) {  // reuse the old value's chars
+                    std::memmove(&chars_[it->value], value.data(), value.size());
+                    unused_ += it->value_size - value.size();
+                    it->value_size = value.size();
+                } else {
+                    unused_ += it->value_size;
+                    maybe_compact_();
+                    entries_[index].value = chars_.size();
+                    entries_[index].value_size = value.size();
+                    chars_.append(value.data(), value.size());
+                }
+                return;
+            }
+            maybe_compact_();
+            item new_item;
+            new_item.key = chars_.size();
+            new_item.key_size = key.size();
+            new_item.value = chars_.size() + key.size();
+            new_item.value_size = value.size();
+            chars_.append(key.data(), key.size());
+            chars_.append(value.data(), value.size());
+            entries_.insert(entries_.begin() + static_cast<std::ptrdiff_t>(index), new_item);
+        }
+
+        // return false if not found
+        bool find(string_view_t key, string_view_t &value) const {
+            auto it = lower_bound_(key);
+            if (it == entries_.end() || key_of_(*it) != key) {
+                return false;
+            }
+            value = string_view_t(chars_.data() + it->value, it->value_size);
+            return true;
+        }
+
+        void remove(string_view_t key) {
+            auto it = lower_bound_(key);
+            if (it != entries_.end() && key_of_(*it) == key) {
+                unused_ += it->key_size + it->value_size;
+                entries_.erase(it);
+            }
+        }
+
+        void clear() {
+            entries_.clear();
+            chars_.clear();
+            spare_.clear();
+            unused_ = 0;
+        }
+
+    private:
+        struct item {
+            size_t key;
+            size_t key_size;
+            size_t value;
+            size_t value_size;
+        };
+
+        std::vector<item> entries_;
+        std::string chars_;
+        std::string spare_;  // compaction buffer, kept for its capacity
+        size_t unused_ = 0;  // chars of removed or replaced entries
+
+        string_view_t key_of_(const item &e) const {
+            return string_view_t(chars_.data() + e.key, e.key_size);
+        }
+
+        static bool less_(string_view_t lhs, string_view_t rhs) {
+            auto n = (std::min)(lhs.size(), rhs.size());
+            auto cmp = n == 0 ? 0 : std::memcmp(lhs.data(), rhs.data(), n);
+            return cmp < 0 || (cmp == 0 && lhs.size() < rhs.size());
+        }
+
+        std::vector<item>::iterator lower_bound_(string_view_t key) {
+            return std::lower_bound(
+                entries_.begin(), entries_.end(), key,
+                [this](const item &e, string_view_t k) { return less_(key_of_(e), k); });
+        }
+
+        std::vector<item>::const_iterator lower_bound_(string_view_t key) const {
+            return std::lower_bound(
+                entries_.begin(), entries_.end(), key,
+                [this](const item &e, string_view_t k) { return less_(key_of_(e), k); });
+        }
+
+        bool aliases_(string_view_t str) const {
+            return str.size() > 0 && str.data() >= chars_.data() &&
+                   str.data() < chars_.data() + chars_.size();
+        }
+
+        // once most chars are unused, copy the used ones to spare_ and swap it with chars_
+        void maybe_compact_() {
+            if (unused_ <= 64 || unused_ <= chars_.size() / 2) {
+                return;
+            }
+            spare_.clear();
+            for (auto &e : entries_) {
+                auto key_pos = spare_.size();
+                spare_.append(chars_, e.key, e.key_size);
+                e.key = key_pos;
+                auto value_pos = spare_.size();
+                spare_.append(chars_, e.value, e.value_size);
+                e.value = value_pos;
+            }
+            chars_.swap(spare_);
+            unused_ = 0;
+        }
+    };
+
+    using mdc_map_t = context;
+
+    // set the value of the key until the end of the scope, then restore the previous value
+    // (or remove the key if it had none).
+    class scoped_put {
+    public:
+        scoped_put(string_view_t key, string_view_t value) {
+            key_.append(key.data(), key.data() + key.size());
+            string_view_t old_value;
+            had_value_ = get_context().find(key, old_value);
+            if (had_value_) {
+                old_value_.append(old_value.data(), old_value.data() + old_value.size());
+            }
+            get_context().put(key, value);
+        }
+
+        ~scoped_put() {
+            auto key = details::to_string_view(key_);
+            if (had_value_) {
+                get_context().put(key, details::to_string_view(old_value_));
+            } else {
+                get_context().remove(key);
+            }
+        }
+
+        scoped_put(const scoped_put &) = delete;
+        scoped_put &operator=(const scoped_put &) = delete;
+
+    private:
+        memory_buf_t key_;
+        memory_buf_t old_value_;
+        bool had_value_ = false;
+    };
 
     static void put(const std::string &key, const std::string &value) {
-        get_context()[key] = value;
+        get_context().put(key, value);
     }
 
     static std::string get(const std::string &key) {
-        auto &context = get_context();
-        auto it = context.find(key);
-        if (it != context.end()) {
-            return it->second;
+        string_view_t value;
+        if (get_context().find(key, value)) {
+            return std::string(value.data(), value.size());
         }
         return "";
     }
 
-    static void remove(const std::string &key) { get_context().erase(key); }
+    static void remove(const std::string &key) { get_context().remove(key); }
 
     static void clear() { get_context().clear(); }
 
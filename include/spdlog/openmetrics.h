@@ -0,0 +1,427 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Exposition of the internal stats of spdlog in the OpenMetrics text format (as scraped by
+// Prometheus), so they don't need glue code each:
+// - of the thread pools added: the overrun, discarded, sampled out and coalesced flush
+//   counters, the queue size and its high water mark, the workers and the queue latency
+//   (if enabled in the pool options).
+// - of the loggers added, or of all the registered ones: the messages by level, the formatted
+//   bytes and the format and sink write time histograms (of the loggers with metrics
+//   enabled, see logger::enable_metrics()), and the overrun counter of the async loggers.
+//
+// The text can be taken with text(), or exported periodically from the housekeeping thread
+// (see details/scheduler.h) to a callback or to a file, replaced at once (e.g. for the
+// textfile collector of the node exporter).
+//
+// Usage example:
+// spdlog::openmetrics_exporter exporter;
+// exporter.add_thread_pool("default", spdlog::thread_pool());
+// exporter.add_registered_loggers();
+// exporter.export_every(std::chrono::seconds(15), "/var/lib/node_exporter/spdlog.prom");
+
+#include <spdlog/async_logger.h>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/os.h>
+#include <spdlog/details/periodic_worker.h>
+#include <spdlog/details/registry.h>
+#include <spdlog/details/thread_pool.h>
+#include <spdlog/logger_metrics.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+
+class openmetrics_exporter {
+public:
+    openmetrics_exporter() = default;
+    openmetrics_exporter(const openmetrics_exporter &) = delete;
+    openmetrics_exporter &operator=(const openmetrics_exporter &) = delete;
+    // stop the export, waiting for a running one
+    ~openmetrics_exporter() { stop_export(); }
+
+    // the pools and loggers are weakly referenced: dropped from the text once destroyed.
+    // the name is the value of the pool label.
+    void add_thread_pool(std::string name, const std::shared_ptr<details::thread_pool> &pool) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pools_.push_back(pool_source{std::move(name), pool});
+    }
+
+    void add_logger(const std::shared_ptr<logger> &new_logger) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loggers_.push_back(new_logger);
+    }
+
+    // also expose the loggers in the registry at the time of each export
+    void add_registered_loggers() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        registered_loggers_ = true;
+    }
+
+    std::string text() {
+        memory_buf_t buf;
+        format(buf);
+        return std::string(buf.data(), buf.size());
+    }
+
+    // append the exposition of the current stats, ending with "# EOF"
+    void format(memory_buf_t &dest) {
+        std::vector<pool_stats> pools;
+        std::vector<logger_stats> loggers;
+        collect_(pools, loggers);
+        format_pools_(pools, dest);
+        format_loggers_(loggers, dest);
+        details::fmt_helper::append_string_view("# EOF\n", dest);
+    }
+
+    // call write with the text every interval, from the housekeeping thread (replacing the
+    // previous export, if any). zero interval: stop.
+    template <typename Rep, typename Period>
+    void export_every(std::chrono::duration<Rep, Period> interval,
+                      std::function<void(string_view_t)> write) {
+        stop_export();
+        auto task = [this, write]() {
+            memory_buf_t buf;
+            format(buf);
+            write(string_view_t(buf.data(), buf.size()));
+        };
+        std::lock_guard<std::mutex> lock(export_mutex_);
+        exporter_ = details::make_unique<details::periodic_worker>(task, interval);
+    }
+
+    // same, writing the text to the file: to a temporary file next to it, renamed over it
+    template <typename Rep, typename Period>
+    void export_every(std::chrono::duration<Rep, Period> interval, const filename_t &filename) {
+        export_every(interval, [filename](string_view_t text) {
+            SPDLOG_TRY { write_file(filename, text); }
+            SPDLOG_CATCH_STD
+        });
+    }
+
+    void stop_export() {
+        std::unique_ptr<details::periodic_worker> exporter;
+        {
+            std::lock_guard<std::mutex> lock(export_mutex_);
+            exporter = std::move(exporter_);
+        }
+        exporter.reset();  // outside the lock: waits for a running export
+    }
+
+    // replace the content of the file at once (readers see the old or the new text)
+    static void write_file(const filename_t &filename, string_view_t text) {
+        auto temp_name = filename + SPDLOG_FILENAME_T(".tmp");
+        details::file_helper file;
+        file.open(temp_name, true);
+        file.write(text.data(), text.size());
+        file.close();
+        if (details::os::rename(temp_name, filename) != 0) {
+            throw_spdlog_ex("openmetrics_exporter: failed renaming " +
+                                details::os::filename_to_str(temp_name) + " to " +
+                                details::os::filename_to_str(filename),
+                            errno);
+        }
+    }
+
+private:
+    struct pool_source {
+        std::string name;
+        std::weak_ptr<details::thread_pool> pool;
+    };
+
+    struct pool_stats {
+        std::string name;
+        size_t overruns;
+        size_t discards;
+        size_t sampled_out;
+        size_t coalesced_flushes;
+        size_t queue_size;
+        size_t high_water_mark;
+        size_t workers;
+        latency_snapshot queue_latency;
+    };
+
+    struct logger_stats {
+        std::string name;
+        bool is_async;
+        size_t overruns;
+        bool has_metrics;
+        logger_metrics_snapshot metrics;
+    };
+
+    std::mutex mutex_;  // guards the sources
+    std::vector<pool_source> pools_;
+    std::vector<std::weak_ptr<logger>> loggers_;
+    bool registered_loggers_ = false;
+
+    std::mutex export_mutex_;
+    std::unique_ptr<details::periodic_worker> exporter_;
+
+    void collect_(std::vector<pool_stats> &pools, std::vector<logger_stats> &loggers) {
+        std::vector<std::shared_ptr<logger>> live_loggers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto &source : pools_) {
+                if (auto pool = source.pool.lock()) {
+                    pools.push_back(pool_stats{
+                        source.name, pool->overrun_counter(), pool->discard_counter(),
+                        pool->sampled_out_counter(), pool->coalesced_flush_counter(),
+                        pool->queue_size(), pool->queue_high_water_mark(),
+                        pool->workers_count(), pool->queue_latency()});
+                }
+            }
+            for (auto &weak_logger : loggers_) {
+                if (auto live_logger = weak_logger.lock()) {
+                    live_loggers.push_back(std::move(live_logger));
+                }
+            }
+            if (registered_loggers_) {
+                details::registry::instance().apply_all(
+                    [&live_loggers](const std::shared_ptr<logger> registered) {
+                        for (auto &live_logger : live_loggers) {
+                            if (live_logger == registered) {
+                                return;
+                            }
+                        }
+                        live_loggers.push_back(registered);
+                    });
+            }
+        }
+        for (auto &live_logger : live_loggers) {
+            auto *async = dynamic_cast<async_logger *>(live_logger.get());
+            loggers.push_back(logger_stats{live_logger->name(), async != nullptr,
+                                           async != nullptr ? async->overrun_counter() : 0,
+                                           live_logger->metrics_enabled(),
+                                           live_logger->metrics_snapshot()});
+        }
+    }
+
+    static void format_pools_(const std::vector<pool_stats> &pools, memory_buf_t &dest) {
+        if (pools.empty()) {
+            return;
+        }
+        struct family {
+            const char *name;
+            const char *type;
+            const char *help;
+            size_t pool_stats::*value;
+        };
+        static const family families[] = {
+            {"spdlog_queue_overruns", "counter",
+             "Messages dropped from the full queue by the overrun_oldest policy.",
+             &pool_stats::overruns},
+            {"spdlog_queue_discards", "counter",
+             "Messages dropped by the discard_new policy as the queue was full.",
+             &pool_stats::discards},
+            {"spdlog_queue_sampled_out", "counter",
+             "Messages dropped by the sample policy under pressure.", &pool_stats::sampled_out},
+            {"spdlog_coalesced_flushes", "counter",
+             "Flush requests merged into another one.", &pool_stats::coalesced_flushes},
+            {"spdlog_queue_size", "gauge", "Messages in the queue.", &pool_stats::queue_size},
+            {"spdlog_queue_high_water_mark", "gauge",
+             "Highest number of messages in the queue since the last reset.",
+             &pool_stats::high_water_mark},
+            {"spdlog_workers", "gauge", "Running worker threads.", &pool_stats::workers},
+        };
+        for (auto &f : families) {
+            append_header_(f.name, f.type, f.help, dest);
+            for (auto &pool : pools) {
+                append_sample_(f.name, f.type[0] == 'c' ? "_total" : "",
+                               label_("pool", pool.name), pool.*f.value, dest);
+            }
+        }
+
+        append_header_("spdlog_queue_latency_seconds", "histogram",
+                       "Time from the post of the messages to the call of their sinks.", dest);
+        for (auto &pool : pools) {
+            append_histogram_("spdlog_queue_latency_seconds", label_("pool", pool.name),
+                              pool.queue_latency, dest);
+        }
+    }
+
+    static void format_loggers_(const std::vector<logger_stats> &loggers, memory_buf_t &dest) {
+        bool any_async = false;
+        bool any_metrics = false;
+        for (auto &l : loggers) {
+            any_async = any_async || l.is_async;
+            any_metrics = any_metrics || l.has_metrics;
+        }
+        if (any_async) {
+            append_header_("spdlog_logger_overruns", "counter",
+                           "Messages dropped over the queue quota of the async logger.", dest);
+            for (auto &l : loggers) {
+                if (l.is_async) {
+                    append_sample_("spdlog_logger_overruns", "_total", label_("logger", l.name),
+                                   l.overruns, dest);
+                }
+            }
+        }
+        if (!any_metrics) {
+            return;
+        }
+
+        append_header_("spdlog_logger_messages", "counter", "Messages logged, by level.", dest);
+        for (auto &l : loggers) {
+            if (!l.has_metrics) {
+                continue;
+            }
+            for (size_t i = 0; i < level::n_levels; i++) {
+                if (i == static_cast<size_t>(level::off)) {
+                    continue;
+                }
+                auto view = level::to_string_view(static_cast<level::level_enum>(i));
+                auto labels = label_("logger", l.name) + ',' +
+                              label_("level", std::string(view.data(), view.size()));
+                append_sample_("spdlog_logger_messages", "_total", labels, l.metrics.messages[i],
+                               dest);
+            }
+        }
+
+        append_header_("spdlog_logger_formatted_bytes", "counter",
+                       "Bytes of the formatted payloads of the messages.", dest);
+        for (auto &l : loggers) {
+            if (l.has_metrics) {
+                append_sample_("spdlog_logger_formatted_bytes", "_total",
+                               label_("logger", l.name), l.metrics.formatted_bytes, dest);
+            }
+        }
+
+        append_header_("spdlog_logger_format_seconds", "histogram",
+                       "Time formatting the payloads of the messages.", dest);
+        for (auto &l : loggers) {
+            if (l.has_metrics) {
+                append_histogram_("spdlog_logger_format_seconds", label_("logger", l.name),
+                                  l.metrics.format_time, dest);
+            }
+        }
+
+        append_header_("spdlog_sink_write_seconds", "histogram",
+                       "Time writing each message to a sink, by index in the logger.", dest);
+        for (auto &l : loggers) {
+            for (size_t i = 0; l.has_metrics && i < l.metrics.sinks.size(); i++) {
+                auto labels =
+                    label_("logger", l.name) + ',' + label_("sink", std::to_string(i));
+                append_histogram_("spdlog_sink_write_seconds", labels,
+                                  l.metrics.sinks[i].write_time, dest);
+            }
+        }
+    }
+
+    static void append_header_(const char *name,
+                               const char *type,
+                               const char *help,
+                               memory_buf_t &dest) {
+        using details::fmt_helper::append_string_view;
+        append_string_view("# TYPE ", dest);
+        append_string_view(name, dest);
+        dest.push_back(' ');
+        append_string_view(type, dest);
+        append_string_view("\n# HELP ", dest);
+        append_string_view(name, dest);
+        dest.push_back(' ');
+        append_string_view(help, dest);
+        dest.push_back('\n');
+    }
+
+    static void append_sample_(const char *name,
+                               const char *suffix,
+                               const std::string &labels,
+                               std::uint64_t value,
+                               memory_buf_t &dest) {
+        using details::fmt_helper::append_string_view;
+        append_string_view(name, dest);
+        append_string_view(suffix, dest);
+        dest.push_back('{');
+        append_string_view(labels, dest);
+        append_string_view("} ", dest);
+        details::fmt_helper::append_int(value, dest);
+        dest.push_back('\n');
+    }
+
+    // the buckets ending at the powers of 2 of nanoseconds, up to the last one not empty
+    static void append_histogram_(const char *name,
+                                  const std::string &labels,
+                                  const latency_snapshot &snapshot,
+                                  memory_buf_t &dest) {
+        using details::fmt_helper::append_string_view;
+        size_t last = 0;
+        for (size_t i = 0; i < latency_snapshot::buckets_n; i++) {
+            if (snapshot.buckets[i] > 0) {
+                last = i;
+            }
+        }
+        std::uint64_t cumulative = 0;
+        for (size_t i = 0; i < latency_snapshot::buckets_n - 1; i++) {
+            cumulative += snapshot.buckets[i];
+            auto bound = latency_snapshot::upper_bound(i).count();
+            if ((bound & (bound - 1)) != 0) {
+                continue;
+            }
+            auto le = fmt_lib::format("{}", static_cast<double>(bound) / 1e9);
+            append_bucket_(name, labels, le, cumulative, dest);
+            if (i >= last) {
+                break;
+            }
+        }
+        append_bucket_(name, labels, "+Inf", snapshot.count, dest);
+        append_string_view(name, dest);
+        append_string_view("_count{", dest);
+        append_string_view(labels, dest);
+        append_string_view("} ", dest);
+        details::fmt_helper::append_int(snapshot.count, dest);
+        dest.push_back('\n');
+        append_string_view(name, dest);
+        append_string_view("_sum{", dest);
+        append_string_view(labels, dest);
+        append_string_view("} ", dest);
+        fmt_lib::format_to(std::back_inserter(dest), "{}",
+                           static_cast<double>(snapshot.total_ns) / 1e9);
+        dest.push_back('\n');
+    }
+
+    static void append_bucket_(const char *name,
+                               const std::string &labels,
+                               const std::string &le,
+                               std::uint64_t cumulative,
+                               memory_buf_t &dest) {
+        using details::fmt_helper::append_string_view;
+        append_string_view(name, dest);
+        append_string_view("_bucket{", dest);
+        append_string_view(labels, dest);
+        append_string_view(",le=\"", dest);
+        append_string_view(le, dest);
+        append_string_view("\"} ", dest);
+        details::fmt_helper::append_int(cumulative, dest);
+        dest.push_back('\n');
+    }
+
+    // name="value", the value escaped
+    static std::string label_(const char *name, const std::string &value) {
+        std::string label(name);
+        label += "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                label += '\\';
+                label += c;
+            } else if (c == '\n') {
+                label += "\\n";
+            } else {
+                label += c;
+            }
+        }
+        label += '"';
+        return label;
+    }
+};
+
+}  // namespace spdlog
@@ -7,14 +7,11 @@
     #include <spdlog/pattern_formatter.h>
 #endif
 
+#include <spdlog/details/flag_formatters.h>
 #include <spdlog/details/fmt_helper.h>
 #include <spdlog/details/log_msg.h>
 #include <spdlog/details/os.h>
-
-#ifndef SPDLOG_NO_TLS
-    #include <spdlog/mdc.h>
-#endif
-
+#include <spdlog/details/shared_format.h>
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/formatter.h>
 
@@ -33,905 +30,6 @@
 #include <vector>
 
 namespace spdlog {
-namespace details {
-
-///////////////////////////////////////////////////////////////////////
-// name & level pattern appender
-///////////////////////////////////////////////////////////////////////
-
-class scoped_padder {
-public:
-    scoped_padder(size_t wrapped_size, const padding_info &padinfo, memory_buf_t &dest)
-        : padinfo_(padinfo),
-          dest_(dest) {
-        remaining_pad_ = static_cast<long>(padinfo.width_) - static_cast<long>(wrapped_size);
-        if (remaining_pad_ <= 0) {
-            return;
-        }
-
-        if (padinfo_.side_ == padding_info::pad_side::left) {
-            pad_it(remaining_pad_);
-            remaining_pad_ = 0;
-        } else if (padinfo_.side_ == padding_info::pad_side::center) {
-            auto half_pad = remaining_pad_ / 2;
-            auto reminder = remaining_pad_ & 1;
-            pad_it(half_pad);
-            remaining_pad_ = half_pad + reminder;  // for the right side
-        }
-    }
-
-    template <typename T>
-    static unsigned int count_digits(T n) {
-        return fmt_helper::count_digits(n);
-    }
-
-    ~scoped_padder() {
-        if (remaining_pad_ >= 0) {
-            pad_it(remaining_pad_);
-        } else if (padinfo_.truncate_) {
-            long new_size = static_cast<long>(dest_.size()) + remaining_pad_;
-            dest_.resize(static_cast<size_t>(new_size));
-        }
-    }
-
-private:
-    void pad_it(long count) {
-        fmt_helper::append_string_view(string_view_t(spaces_.data(), static_cast<size_t>(count)),
-                                       dest_);
-    }
-
-    const padding_info &padinfo_;
-    memory_buf_t &dest_;
-    long remaining_pad_;
-    string_view_t spaces_{"                                                                ", 64};
-};
-
-struct null_scoped_padder {
-    null_scoped_padder(size_t /*wrapped_size*/,
-                       const padding_info & /*padinfo*/,
-                       memory_buf_t & /*dest*/) {}
-
-    template <typename T>
-    static unsigned int count_digits(T /* number */) {
-        return 0;
-    }
-};
-
-template <typename ScopedPadder>
-class name_formatter final : public flag_formatter {
-public:
-    explicit name_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        ScopedPadder p(msg.logger_name.size(), padinfo_, dest);
-        fmt_helper::append_string_view(msg.logger_name, dest);
-    }
-};
-
-// log level appender
-template <typename ScopedPadder>
-class level_formatter final : public flag_formatter {
-public:
-    explicit level_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        const string_view_t &level_name = level::to_string_view(msg.level);
-        ScopedPadder p(level_name.size(), padinfo_, dest);
-        fmt_helper::append_string_view(level_name, dest);
-    }
-};
-
-// short log level appender
-template <typename ScopedPadder>
-class short_level_formatter final : public flag_formatter {
-public:
-    explicit short_level_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        string_view_t level_name{level::to_short_c_str(msg.level)};
-        ScopedPadder p(level_name.size(), padinfo_, dest);
-        fmt_helper::append_string_view(level_name, dest);
-    }
-};
-
-///////////////////////////////////////////////////////////////////////
-// Date time pattern appenders
-///////////////////////////////////////////////////////////////////////
-
-static const char *ampm(const tm &t) { return t.tm_hour >= 12 ? "PM" : "AM"; }
-
-static int to12h(const tm &t) { return t.tm_hour > 12 ? t.tm_hour - 12 : t.tm_hour; }
-
-// Abbreviated weekday name
-static std::array<const char *, 7> days{{"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"}};
-
-template <typename ScopedPadder>
-class a_formatter final : public flag_formatter {
-public:
-    explicit a_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        string_view_t field_value{days[static_cast<size_t>(tm_time.tm_wday)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
-        fmt_helper::append_string_view(field_value, dest);
-    }
-};
-
-// Full weekday name
-static std::array<const char *, 7> full_days{
-    {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"}};
-
-template <typename ScopedPadder>
-class A_formatter : public flag_formatter {
-public:
-    explicit A_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        string_view_t field_value{full_days[static_cast<size_t>(tm_time.tm_wday)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
-        fmt_helper::append_string_view(field_value, dest);
-    }
-};
-
-// Abbreviated month
-static const std::array<const char *, 12> months{
-    {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"}};
-
-template <typename ScopedPadder>
-class b_formatter final : public flag_formatter {
-public:
-    explicit b_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        string_view_t field_value{months[static_cast<size_t>(tm_time.tm_mon)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
-        fmt_helper::append_string_view(field_value, dest);
-    }
-};
-
-// Full month name
-static const std::array<const char *, 12> full_months{{"January", "February", "March", "April",
-                                                       "May", "June", "July", "August", "September",
-                                                       "October", "November", "December"}};
-
-template <typename ScopedPadder>
-class B_formatter final : public flag_formatter {
-public:
-    explicit B_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        string_view_t field_value{full_months[static_cast<size_t>(tm_time.tm_mon)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
-        fmt_helper::append_string_view(field_value, dest);
-    }
-};
-
-// Date and time representation (Thu Aug 23 15:35:46 2014)
-template <typename ScopedPadder>
-class c_formatter final : public flag_formatter {
-public:
-    explicit c_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 24;
-        ScopedPadder p(field_size, padinfo_, dest);
-
-        fmt_helper::append_string_view(days[static_cast<size_t>(tm_time.tm_wday)], dest);
-        dest.push_back(' ');
-        fmt_helper::append_string_view(months[static_cast<size_t>(tm_time.tm_mon)], dest);
-        dest.push_back(' ');
-        fmt_helper::append_int(tm_time.tm_mday, dest);
-        dest.push_back(' ');
-        // time
-
-        fmt_helper::pad2(tm_time.tm_hour, dest);
-        dest.push_back(':');
-        fmt_helper::pad2(tm_time.tm_min, dest);
-        dest.push_back(':');
-        fmt_helper::pad2(tm_time.tm_sec, dest);
-        dest.push_back(' ');
-        fmt_helper::append_int(tm_time.tm_year + 1900, dest);
-    }
-};
-
-// year - 2 digit
-template <typename ScopedPadder>
-class C_formatter final : public flag_formatter {
-public:
-    explicit C_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(tm_time.tm_year % 100, dest);
-    }
-};
-
-// Short MM/DD/YY date, equivalent to %m/%d/%y 08/23/01
-template <typename ScopedPadder>
-class D_formatter final : public flag_formatter {
-public:
-    explicit D_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 10;
-        ScopedPadder p(field_size, padinfo_, dest);
-
-        fmt_helper::pad2(tm_time.tm_mon + 1, dest);
-        dest.push_back('/');
-        fmt_helper::pad2(tm_time.tm_mday, dest);
-        dest.push_back('/');
-        fmt_helper::pad2(tm_time.tm_year % 100, dest);
-    }
-};
-
-// year - 4 digit
-template <typename ScopedPadder>
-class Y_formatter final : public flag_formatter {
-public:
-    explicit Y_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 4;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(tm_time.tm_year + 1900, dest);
-    }
-};
-
-// month 1-12
-template <typename ScopedPadder>
-class m_formatter final : public flag_formatter {
-public:
-    explicit m_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(tm_time.tm_mon + 1, dest);
-    }
-};
-
-// day of month 1-31
-template <typename ScopedPadder>
-class d_formatter final : public flag_formatter {
-public:
-    explicit d_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(tm_time.tm_mday, dest);
-    }
-};
-
-// hours in 24 format 0-23
-template <typename ScopedPadder>
-class H_formatter final : public flag_formatter {
-public:
-    explicit H_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(tm_time.tm_hour, dest);
-    }
-};
-
-// hours in 12 format 1-12
-template <typename ScopedPadder>
-class I_formatter final : public flag_formatter {
-public:
-    explicit I_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(to12h(tm_time), dest);
-    }
-};
-
-// minutes 0-59
-template <typename ScopedPadder>
-class M_formatter final : public flag_formatter {
-public:
-    explicit M_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(tm_time.tm_min, dest);
-    }
-};
-
-// seconds 0-59
-template <typename ScopedPadder>
-class S_formatter final : public flag_formatter {
-public:
-    explicit S_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(tm_time.tm_sec, dest);
-    }
-};
-
-// milliseconds
-template <typename ScopedPadder>
-class e_formatter final : public flag_formatter {
-public:
-    explicit e_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        auto millis = fmt_helper::time_fraction<std::chrono::milliseconds>(msg.time);
-        const size_t field_size = 3;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad3(static_cast<uint32_t>(millis.count()), dest);
-    }
-};
-
-// microseconds
-template <typename ScopedPadder>
-class f_formatter final : public flag_formatter {
-public:
-    explicit f_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        auto micros = fmt_helper::time_fraction<std::chrono::microseconds>(msg.time);
-
-        const size_t field_size = 6;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad6(static_cast<size_t>(micros.count()), dest);
-    }
-};
-
-// nanoseconds
-template <typename ScopedPadder>
-class F_formatter final : public flag_formatter {
-public:
-    explicit F_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        auto ns = fmt_helper::time_fraction<std::chrono::nanoseconds>(msg.time);
-        const size_t field_size = 9;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad9(static_cast<size_t>(ns.count()), dest);
-    }
-};
-
-// seconds since epoch
-template <typename ScopedPadder>
-class E_formatter final : public flag_formatter {
-public:
-    explicit E_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        const size_t field_size = 10;
-        ScopedPadder p(field_size, padinfo_, dest);
-        auto duration = msg.time.time_since_epoch();
-        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
-        fmt_helper::append_int(seconds, dest);
-    }
-};
-
-// AM/PM
-template <typename ScopedPadder>
-class p_formatter final : public flag_formatter {
-public:
-    explicit p_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_string_view(ampm(tm_time), dest);
-    }
-};
-
-// 12 hour clock 02:55:02 pm
-template <typename ScopedPadder>
-class r_formatter final : public flag_formatter {
-public:
-    explicit r_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 11;
-        ScopedPadder p(field_size, padinfo_, dest);
-
-        fmt_helper::pad2(to12h(tm_time), dest);
-        dest.push_back(':');
-        fmt_helper::pad2(tm_time.tm_min, dest);
-        dest.push_back(':');
-        fmt_helper::pad2(tm_time.tm_sec, dest);
-        dest.push_back(' ');
-        fmt_helper::append_string_view(ampm(tm_time), dest);
-    }
-};
-
-// 24-hour HH:MM time, equivalent to %H:%M
-template <typename ScopedPadder>
-class R_formatter final : public flag_formatter {
-public:
-    explicit R_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 5;
-        ScopedPadder p(field_size, padinfo_, dest);
-
-        fmt_helper::pad2(tm_time.tm_hour, dest);
-        dest.push_back(':');
-        fmt_helper::pad2(tm_time.tm_min, dest);
-    }
-};
-
-// ISO 8601 time format (HH:MM:SS), equivalent to %H:%M:%S
-template <typename ScopedPadder>
-class T_formatter final : public flag_formatter {
-public:
-    explicit T_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 8;
-        ScopedPadder p(field_size, padinfo_, dest);
-
-        fmt_helper::pad2(tm_time.tm_hour, dest);
-        dest.push_back(':');
-        fmt_helper::pad2(tm_time.tm_min, dest);
-        dest.push_back(':');
-        fmt_helper::pad2(tm_time.tm_sec, dest);
-    }
-};
-
-// ISO 8601 offset from UTC in timezone (+-HH:MM)
-template <typename ScopedPadder>
-class z_formatter final : public flag_formatter {
-public:
-    explicit z_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    z_formatter() = default;
-    z_formatter(const z_formatter &) = delete;
-    z_formatter &operator=(const z_formatter &) = delete;
-
-    void format(const details::log_msg &msg, const std::tm &tm_time, memory_buf_t &dest) override {
-        const size_t field_size = 6;
-        ScopedPadder p(field_size, padinfo_, dest);
-
-        auto total_minutes = get_cached_offset(msg, tm_time);
-        bool is_negative = total_minutes < 0;
-        if (is_negative) {
-            total_minutes = -total_minutes;
-            dest.push_back('-');
-        } else {
-            dest.push_back('+');
-        }
-
-        fmt_helper::pad2(total_minutes / 60, dest);  // hours
-        dest.push_back(':');
-        fmt_helper::pad2(total_minutes % 60, dest);  // minutes
-    }
-
-private:
-    log_clock::time_point last_update_{std::chrono::seconds(0)};
-    int offset_minutes_{0};
-
-    int get_cached_offset(const log_msg &msg, const std::tm &tm_time) {
-        // refresh every 10 seconds
-        if (msg.time - last_update_ >= std::chrono::seconds(10)) {
-            offset_minutes_ = os::utc_minutes_offset(tm_time);
-            last_update_ = msg.time;
-        }
-        return offset_minutes_;
-    }
-};
-
-// Thread id
-template <typename ScopedPadder>
-class t_formatter final : public flag_formatter {
-public:
-    explicit t_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        const auto field_size = ScopedPadder::count_digits(msg.thread_id);
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(msg.thread_id, dest);
-    }
-};
-
-// Current pid
-template <typename ScopedPadder>
-class pid_formatter final : public flag_formatter {
-public:
-    explicit pid_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &, memory_buf_t &dest) override {
-        const auto pid = static_cast<uint32_t>(details::os::pid());
-        auto field_size = ScopedPadder::count_digits(pid);
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(pid, dest);
-    }
-};
-
-template <typename ScopedPadder>
-class v_formatter final : public flag_formatter {
-public:
-    explicit v_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        ScopedPadder p(msg.payload.size(), padinfo_, dest);
-        fmt_helper::append_string_view(msg.payload, dest);
-    }
-};
-
-class ch_formatter final : public flag_formatter {
-public:
-    explicit ch_formatter(char ch)
-        : ch_(ch) {}
-
-    void format(const details::log_msg &, const std::tm &, memory_buf_t &dest) override {
-        dest.push_back(ch_);
-    }
-
-private:
-    char ch_;
-};
-
-// aggregate user chars to display as is
-class aggregate_formatter final : public flag_formatter {
-public:
-    aggregate_formatter() = default;
-
-    void add_ch(char ch) { str_ += ch; }
-    void format(const details::log_msg &, const std::tm &, memory_buf_t &dest) override {
-        fmt_helper::append_string_view(str_, dest);
-    }
-
-private:
-    std::string str_;
-};
-
-// mark the color range. expect it to be in the form of "%^colored text%$"
-class color_start_formatter final : public flag_formatter {
-public:
-    explicit color_start_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        msg.color_range_start = dest.size();
-    }
-};
-
-class color_stop_formatter final : public flag_formatter {
-public:
-    explicit color_stop_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        msg.color_range_end = dest.size();
-    }
-};
-
-// print source location
-template <typename ScopedPadder>
-class source_location_formatter final : public flag_formatter {
-public:
-    explicit source_location_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        if (msg.source.empty()) {
-            ScopedPadder p(0, padinfo_, dest);
-            return;
-        }
-
-        size_t text_size;
-        if (padinfo_.enabled()) {
-            // calc text size for padding based on "filename:line"
-            text_size = std::char_traits<char>::length(msg.source.filename) +
-                        ScopedPadder::count_digits(msg.source.line) + 1;
-        } else {
-            text_size = 0;
-        }
-
-        ScopedPadder p(text_size, padinfo_, dest);
-        fmt_helper::append_string_view(msg.source.filename, dest);
-        dest.push_back(':');
-        fmt_helper::append_int(msg.source.line, dest);
-    }
-};
-
-// print source filename
-template <typename ScopedPadder>
-class source_filename_formatter final : public flag_formatter {
-public:
-    explicit source_filename_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        if (msg.source.empty()) {
-            ScopedPadder p(0, padinfo_, dest);
-            return;
-        }
-        size_t text_size =
-            padinfo_.enabled() ? std::char_traits<char>::length(msg.source.filename) : 0;
-        ScopedPadder p(text_size, padinfo_, dest);
-        fmt_helper::append_string_view(msg.source.filename, dest);
-    }
-};
-
-template <typename ScopedPadder>
-class short_filename_formatter final : public flag_formatter {
-public:
-    explicit short_filename_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-#ifdef _MSC_VER
-    #pragma warning(push)
-    #pragma warning(disable : 4127)  // consider using 'if constexpr' instead
-#endif                               // _MSC_VER
-    static const char *basename(const char *filename) {
-        // if the size is 2 (1 character + null terminator) we can use the more efficient strrchr
-        // the branch will be elided by optimizations
-        if (sizeof(os::folder_seps) == 2) {
-            const char *rv = std::strrchr(filename, os::folder_seps[0]);
-            return rv != nullptr ? rv + 1 : filename;
-        } else {
-            const std::reverse_iterator<const char *> begin(filename + std::strlen(filename));
-            const std::reverse_iterator<const char *> end(filename);
-
-            const auto it = std::find_first_of(begin, end, std::begin(os::folder_seps),
-                                               std::end(os::folder_seps) - 1);
-            return it != end ? it.base() : filename;
-        }
-    }
-#ifdef _MSC_VER
-    #pragma warning(pop)
-#endif  // _MSC_VER
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        if (msg.source.empty()) {
-            ScopedPadder p(0, padinfo_, dest);
-            return;
-        }
-        auto filename = basename(msg.source.filename);
-        size_t text_size = padinfo_.enabled() ? std::char_traits<char>::length(filename) : 0;
-        ScopedPadder p(text_size, padinfo_, dest);
-        fmt_helper::append_string_view(filename, dest);
-    }
-};
-
-template <typename ScopedPadder>
-class source_linenum_formatter final : public flag_formatter {
-public:
-    explicit source_linenum_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        if (msg.source.empty()) {
-            ScopedPadder p(0, padinfo_, dest);
-            return;
-        }
-
-        auto field_size = ScopedPadder::count_digits(msg.source.line);
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(msg.source.line, dest);
-    }
-};
-
-// print source funcname
-template <typename ScopedPadder>
-class source_funcname_formatter final : public flag_formatter {
-public:
-    explicit source_funcname_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        if (msg.source.empty()) {
-            ScopedPadder p(0, padinfo_, dest);
-            return;
-        }
-        size_t text_size =
-            padinfo_.enabled() ? std::char_traits<char>::length(msg.source.funcname) : 0;
-        ScopedPadder p(text_size, padinfo_, dest);
-        fmt_helper::append_string_view(msg.source.funcname, dest);
-    }
-};
-
-// print elapsed time since last message
-template <typename ScopedPadder, typename Units>
-class elapsed_formatter final : public flag_formatter {
-public:
-    using DurationUnits = Units;
-
-    explicit elapsed_formatter(padding_info padinfo)
-        : flag_formatter(padinfo),
-          last_message_time_(log_clock::now()) {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override {
-        auto delta = (std::max)(msg.time - last_message_time_, log_clock::duration::zero());
-        auto delta_units = std::chrono::duration_cast<DurationUnits>(delta);
-        last_message_time_ = msg.time;
-        auto delta_count = static_cast<size_t>(delta_units.count());
-        auto n_digits = static_cast<size_t>(ScopedPadder::count_digits(delta_count));
-        ScopedPadder p(n_digits, padinfo_, dest);
-        fmt_helper::append_int(delta_count, dest);
-    }
-
-private:
-    log_clock::time_point last_message_time_;
-};
-
-// Class for formatting Mapped Diagnostic Context (MDC) in log messages.
-// Example: [logger-name] [info] [mdc_key_1:mdc_value_1 mdc_key_2:mdc_value_2] some message
-#ifndef SPDLOG_NO_TLS
-template <typename ScopedPadder>
-class mdc_formatter : public flag_formatter {
-public:
-    explicit mdc_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &, const std::tm &, memory_buf_t &dest) override {
-        auto &mdc_map = mdc::get_context();
-        if (mdc_map.empty()) {
-            ScopedPadder p(0, padinfo_, dest);
-            return;
-        } else {
-            format_mdc(mdc_map, dest);
-        }
-    }
-
-    void format_mdc(const mdc::mdc_map_t &mdc_map, memory_buf_t &dest) {
-        auto last_element = --mdc_map.end();
-        for (auto it = mdc_map.begin(); it != mdc_map.end(); ++it) {
-            auto &pair = *it;
-            const auto &key = pair.first;
-            const auto &value = pair.second;
-            size_t content_size = key.size() + value.size() + 1;  // 1 for ':'
-
-            if (it != last_element) {
-                content_size++;  // 1 for ' '
-            }
-
-            ScopedPadder p(content_size, padinfo_, dest);
-            fmt_helper::append_string_view(key, dest);
-            fmt_helper::append_string_view(":", dest);
-            fmt_helper::append_string_view(value, dest);
-            if (it != last_element) {
-                fmt_helper::append_string_view(" ", dest);
-            }
-        }
-    }
-};
-#endif
-
-// Full info formatter
-// pattern: [%Y-%m-%d %H:%M:%S.%e] [%n] [%l] [%s:%#] %v
-class full_formatter final : public flag_formatter {
-public:
-    explicit full_formatter(padding_info padinfo)
-        : flag_formatter(padinfo) {}
-
-    void format(const details::log_msg &msg, const std::tm &tm_time, memory_buf_t &dest) override {
-        using std::chrono::duration_cast;
-        using std::chrono::milliseconds;
-        using std::chrono::seconds;
-
-        // cache the date/time part for the next second.
-        auto duration = msg.time.time_since_epoch();
-        auto secs = duration_cast<seconds>(duration);
-
-        if (cache_timestamp_ != secs || cached_datetime_.size() == 0) {
-            cached_datetime_.clear();
-            cached_datetime_.push_back('[');
-            fmt_helper::append_int(tm_time.tm_year + 1900, cached_datetime_);
-            cached_datetime_.push_back('-');
-
-            fmt_helper::pad2(tm_time.tm_mon + 1, cached_datetime_);
-            cached_datetime_.push_back('-');
-
-            fmt_helper::pad2(tm_time.tm_mday, cached_datetime_);
-            cached_datetime_.push_back(' ');
-
-            fmt_helper::pad2(tm_time.tm_hour, cached_datetime_);
-            cached_datetime_.push_back(':');
-
-            fmt_helper::pad2(tm_time.tm_min, cached_datetime_);
-            cached_datetime_.push_back(':');
-
-            fmt_helper::pad2(tm_time.tm_sec, cached_datetime_);
-            cached_datetime_.push_back('.');
-
-            cache_timestamp_ = secs;
-        }
-        dest.append(cached_datetime_.begin(), cached_datetime_.end());
-
-        auto millis = fmt_helper::time_fraction<milliseconds>(msg.time);
-        fmt_helper::pad3(static_cast<uint32_t>(millis.count()), dest);
-        dest.push_back(']');
-        dest.push_back(' ');
-
-        // append logger name if exists
-        if (msg.logger_name.size() > 0) {
-            dest.push_back('[');
-            fmt_helper::append_string_view(msg.logger_name, dest);
-            dest.push_back(']');
-            dest.push_back(' ');
-        }
-
-        dest.push_back('[');
-        // wrap the level name with color
-        msg.color_range_start = dest.size();
-        // fmt_helper::append_string_view(level::to_c_str(msg.level), dest);
-        fmt_helper::append_string_view(level::to_string_view(msg.level), dest);
-        msg.color_range_end = dest.size();
-        dest.push_back(']');
-        dest.push_back(' ');
-
-        // add source location if present
-        if (!msg.source.empty()) {
-            dest.push_back('[');
-            const char *filename =
-                details::short_filename_formatter<details::null_scoped_padder>::basename(
-                    msg.source.filename);
-            fmt_helper::append_string_view(filename, dest);
-            dest.push_back(':');
-            fmt_helper::append_int(msg.source.line, dest);
-            dest.push_back(']');
-            dest.push_back(' ');
-        }
-
-#ifndef SPDLOG_NO_TLS
-        // add mdc if present
-        auto &mdc_map = mdc::get_context();
-        if (!mdc_map.empty()) {
-            dest.push_back('[');
-            mdc_formatter_.format_mdc(mdc_map, dest);
-            dest.push_back(']');
-            dest.push_back(' ');
-        }
-#endif
-        // fmt_helper::append_string_view(msg.msg(), dest);
-        fmt_helper::append_string_view(msg.payload, dest);
-    }
-
-private:
-    std::chrono::seconds cache_timestamp_{0};
-    memory_buf_t cached_datetime_;
-
-#ifndef SPDLOG_NO_TLS
-    mdc_formatter<null_scoped_padder> mdc_formatter_{padding_info{}};
-#endif
-
-};
-
-}  // namespace details
 
 SPDLOG_INLINE pattern_formatter::pattern_formatter(std::string pattern,
                                                    pattern_time_type time_type,
@@ -953,9 +51,25 @@ SPDLOG_INLINE pattern_formatter::pattern_formatter(pattern_time_type time_type,
       eol_(std::move(eol)),
       pattern_time_type_(time_type),
       need_localtime_(true),
-      last_log_secs_(0) {
+      last_log_secs_(0),
+      compiled_(default_compiled_()) {
+    std::memset(&cached_tm_, 0, sizeof(cached_tm_));
+    make_formatters_();
+}
+
+// share the compiled pattern of other, only making the objects keeping a state
+SPDLOG_INLINE pattern_formatter::pattern_formatter(const pattern_formatter &other,
+                                                   custom_flags custom_user_flags)
+    : pattern_(other.pattern_),
+      eol_(other.eol_),
+      pattern_time_type_(other.pattern_time_type_),
+      need_localtime_(other.need_localtime_),
+      control_chars_(other.control_chars_),
+      last_log_secs_(0),
+      compiled_(other.compiled_),
+      custom_handlers_(std::move(custom_user_flags)) {
     std::memset(&cached_tm_, 0, sizeof(cached_tm_));
-    formatters_.push_back(details::make_unique<details::full_formatter>(details::padding_info{}));
+    make_formatters_();
 }
 
 SPDLOG_INLINE std::unique_ptr<formatter> pattern_formatter::clone() const {
@@ -963,8 +77,15 @@ SPDLOG_INLINE std::unique_ptr<formatter> pattern_formatter::clone() const {
     for (auto &it : custom_handlers_) {
         cloned_custom_formatters[it.first] = it.second->clone();
     }
-    auto cloned = details::make_unique<pattern_formatter>(pattern_, pattern_time_type_, eol_,
-                                                          std::move(cloned_custom_formatters));
+    std::unique_ptr<pattern_formatter> cloned;
+    if (custom_flags_changed_) {
+        // flags added since the pattern was compiled may change its meaning: compile it again
+        cloned = details::make_unique<pattern_formatter>(pattern_, pattern_time_type_, eol_,
+                                                         std::move(cloned_custom_formatters));
+        cloned->set_control_chars(control_chars_);
+    } else {
+        cloned.reset(new pattern_formatter(*this, std::move(cloned_custom_formatters)));
+    }
     cloned->need_localtime(need_localtime_);
 #if defined(__GNUC__) && __GNUC__ < 5
     return std::move(cloned);
@@ -974,6 +95,22 @@ SPDLOG_INLINE std::unique_ptr<formatter> pattern_formatter::clone() const {
 }
 
 SPDLOG_INLINE void pattern_formatter::format(const details::log_msg &msg, memory_buf_t &dest) {
+    // copy the message as formatted by an identical formatter of another sink (if any)
+    auto *shared = compiled_->shareable ? details::shared_format::get(msg) : nullptr;
+    if (shared != nullptr && shared->formatter != nullptr &&
+        static_cast<const pattern_formatter *>(shared->formatter)->same_format_(*this)) {
+        if (compiled_->sets_color_range) {
+            auto rebase = [&](size_t pos) {
+                return pos >= shared->buf_start ? pos - shared->buf_start + dest.size() : pos;
+            };
+            msg.color_range_start = rebase(shared->color_range_start);
+            msg.color_range_end = rebase(shared->color_range_end);
+        }
+        dest.append(shared->buf.data(), shared->buf.data() + shared->buf.size());
+        return;
+    }
+    const auto start = dest.size();
+
     if (need_localtime_) {
         const auto secs =
             std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
@@ -983,11 +120,72 @@ SPDLOG_INLINE void pattern_formatter::format(const details::log_msg &msg, memory
         }
     }
 
-    for (auto &f : formatters_) {
-        f->format(msg, cached_tm_, dest);
-    }
+    const auto &ops = compiled_->ops;
+    run_ops_(ops.data(), ops.data() + ops.size(), msg, dest);
     // write eol
     details::fmt_helper::append_string_view(eol_, dest);
+
+    if (shared != nullptr && shared->formatter == nullptr) {
+        shared->buf.append(dest.data() + start, dest.data() + dest.size());
+        shared->color_range_start = msg.color_range_start;
+        shared->color_range_end = msg.color_range_end;
+        shared->buf_start = start;
+        shared->formatter = this;
+    }
+}
+
+SPDLOG_INLINE bool pattern_formatter::same_format_(const pattern_formatter &other) const {
+    return compiled_->shareable && other.compiled_->shareable &&
+           need_localtime_ == other.need_localtime_ && control_chars_ == other.control_chars_ &&
+           pattern_time_type_ == other.pattern_time_type_ &&
+           (compiled_ == other.compiled_ || pattern_ == other.pattern_) && eol_ == other.eol_;
+}
+
+SPDLOG_INLINE void pattern_formatter::run_ops_(const details::pattern_op *first,
+                                               const details::pattern_op *last,
+                                               const details::log_msg &msg,
+                                               memory_buf_t &dest) {
+    for (auto op = first; op != last; ++op) {
+        switch (op->code) {
+            case details::pattern_op::text:
+                dest.append(compiled_->literals.data() + op->arg,
+                            compiled_->literals.data() + op->arg + op->size);
+                break;
+            case details::pattern_op::call:
+                formatters_[op->arg]->format(msg, cached_tm_, dest);
+                break;
+            case details::pattern_op::cached_time: {
+                auto &cache = time_caches_[op->arg];
+                const auto secs =
+                    std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
+                if (secs != cache.secs) {
+                    const auto start = dest.size();
+                    run_ops_(op + 1, op + 1 + op->size, msg, dest);
+                    cache.text.assign(dest.data() + start, dest.size() - start);
+                    cache.secs = secs;
+                } else {
+                    details::fmt_helper::append_string_view(cache.text, dest);
+                }
+                op += op->size;
+                break;
+            }
+            case details::pattern_op::cached_name:
+                run_cached_name_(op, msg, dest);
+                op += op->size;
+                break;
+            default:
+                if ((op->pad_flags & details::pattern_op::padded) == 0) {
+                    run_op_<details::null_scoped_padder>(*op, msg, dest);
+                } else if (op->pad_flags & details::pattern_op::scoped) {
+                    run_op_<details::scoped_padder>(*op, msg, dest);
+                } else {
+                    const auto start = dest.size();
+                    run_op_<details::null_scoped_padder>(*op, msg, dest);
+                    pad_field_(start, *op, dest);
+                }
+                break;
+        }
+    }
 }
 
 SPDLOG_INLINE void pattern_formatter::set_pattern(std::string pattern) {
@@ -998,256 +196,638 @@ SPDLOG_INLINE void pattern_formatter::set_pattern(std::string pattern) {
 
 SPDLOG_INLINE void pattern_formatter::need_localtime(bool need) { need_localtime_ = need; }
 
+SPDLOG_INLINE void pattern_formatter::set_control_chars(control_chars chars) {
+    control_chars_ = chars;
+    make_formatters_();  // the %+ formatter
+}
+
 SPDLOG_INLINE std::tm pattern_formatter::get_time_(const details::log_msg &msg) {
     if (pattern_time_type_ == pattern_time_type::local) {
-        return details::os::localtime(log_clock::to_time_t(msg.time));
+        return details::os::fast_localtime(log_clock::to_time_t(msg.time));
     }
-    return details::os::gmtime(log_clock::to_time_t(msg.time));
+    return details::os::fast_gmtime(log_clock::to_time_t(msg.time));
 }
 
-template <typename Padder>
-SPDLOG_INLINE void pattern_formatter::handle_flag_(char flag, details::padding_info padding) {
+SPDLOG_INLINE unsigned pattern_formatter::needed_fields() const {
+    return compiled_->fields | (need_localtime_ ? msg_field::time : msg_field::none);
+}
+
+namespace details {
+// the log_msg fields read by a built-in flag
+static unsigned pattern_flag_fields_(char flag) {
+    switch (flag) {
+        case ('t'):
+            return msg_field::thread_id;
+        case ('N'):
+            return msg_field::thread_name;
+        case ('@'):
+        case ('s'):
+        case ('g'):
+        case ('#'):
+        case ('!'):
+            return msg_field::source;
+        case ('+'):
+            return msg_field::time | msg_field::source;
+        default:
+            break;
+    }
+    static const char time_flags[] = "aAbhBcCYDxmdHIMSprRTXzefFEuioO";
+    return std::strchr(time_flags, flag) != nullptr && flag != '\0' ? msg_field::time
+                                                                     : msg_field::none;
+}
+}  // namespace details
+
+SPDLOG_INLINE void pattern_formatter::handle_flag_(details::compiled_pattern &compiled,
+                                                  char flag,
+                                                  details::padding_info padding) {
     // process custom flags
-    auto it = custom_handlers_.find(flag);
-    if (it != custom_handlers_.end()) {
-        auto custom_handler = it->second->clone();
-        custom_handler->set_padding_info(padding);
-        formatters_.push_back(std::move(custom_handler));
+    if (custom_handlers_.find(flag) != custom_handlers_.end()) {
+        add_call_(compiled, flag, padding);
+        compiled.shareable = false;
+        compiled.fields = msg_field::all;
         return;
     }
+    compiled.fields |= details::pattern_flag_fields_(flag);
+    if (flag == '+' || flag == '^' || flag == '$') {
+        compiled.sets_color_range = true;
+    }
 
-    // process built-in flags
+    // process built-in flags. the stateless ones are run by run_op_(), the others
+    // (which cache something or keep the time of the previous message) are objects made by
+    // make_formatter_().
     switch (flag) {
         case ('+'):  // default formatter
-            formatters_.push_back(details::make_unique<details::full_formatter>(padding));
-            need_localtime_ = true;
-            break;
-
-        case 'n':  // logger name
-            formatters_.push_back(details::make_unique<details::name_formatter<Padder>>(padding));
-            break;
-
-        case 'l':  // level
-            formatters_.push_back(details::make_unique<details::level_formatter<Padder>>(padding));
-            break;
-
-        case 'L':  // short level
-            formatters_.push_back(
-                details::make_unique<details::short_level_formatter<Padder>>(padding));
+            add_call_(compiled, flag, padding);
+            compiled.need_localtime = true;
             break;
 
+        case ('n'):  // logger name
+        case ('l'):  // level
+        case ('L'):  // short level
         case ('t'):  // thread id
-            formatters_.push_back(details::make_unique<details::t_formatter<Padder>>(padding));
-            break;
-
+        case ('N'):  // thread name
         case ('v'):  // the message text
-            formatters_.push_back(details::make_unique<details::v_formatter<Padder>>(padding));
+        case ('e'):  // milliseconds
+        case ('f'):  // microseconds
+        case ('F'):  // nanoseconds
+        case ('E'):  // seconds since epoch
+        case ('P'):  // pid
+        case ('^'):  // color range start
+        case ('$'):  // color range end
+        case ('@'):  // source location (filename:filenumber)
+        case ('s'):  // short source filename - without directory name
+        case ('g'):  // full source filename
+        case ('#'):  // source line number
+        case ('!'):  // source funcname
+#ifndef SPDLOG_NO_TLS  // mdc formatter requires TLS support
+        case ('&'):
+#endif
+            add_flag_op_(compiled, flag, padding);
             break;
 
         case ('a'):  // weekday
-            formatters_.push_back(details::make_unique<details::a_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('A'):  // short weekday
-            formatters_.push_back(details::make_unique<details::A_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('b'):
         case ('h'):  // month
-            formatters_.push_back(details::make_unique<details::b_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('B'):  // short month
-            formatters_.push_back(details::make_unique<details::B_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('c'):  // datetime
-            formatters_.push_back(details::make_unique<details::c_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('C'):  // year 2 digits
-            formatters_.push_back(details::make_unique<details::C_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('Y'):  // year 4 digits
-            formatters_.push_back(details::make_unique<details::Y_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('D'):
         case ('x'):  // datetime MM/DD/YY
-            formatters_.push_back(details::make_unique<details::D_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('m'):  // month 1-12
-            formatters_.push_back(details::make_unique<details::m_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('d'):  // day of month 1-31
-            formatters_.push_back(details::make_unique<details::d_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('H'):  // hours 24
-            formatters_.push_back(details::make_unique<details::H_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('I'):  // hours 12
-            formatters_.push_back(details::make_unique<details::I_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('M'):  // minutes
-            formatters_.push_back(details::make_unique<details::M_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
-
         case ('S'):  // seconds
-            formatters_.push_back(details::make_unique<details::S_formatter<Padder>>(padding));
-            need_localtime_ = true;
+        case ('p'):  // am/pm
+        case ('r'):  // 12 hour clock 02:55:02 pm
+        case ('R'):  // 24-hour HH:MM time
+        case ('T'):
+        case ('X'):  // ISO 8601 time format (HH:MM:SS)
+            add_flag_op_(compiled, flag, padding);
+            compiled.need_localtime = true;
             break;
 
-        case ('e'):  // milliseconds
-            formatters_.push_back(details::make_unique<details::e_formatter<Padder>>(padding));
+        case ('z'):  // timezone
+            add_call_(compiled, flag, padding);
+            compiled.need_localtime = true;
             break;
 
-        case ('f'):  // microseconds
-            formatters_.push_back(details::make_unique<details::f_formatter<Padder>>(padding));
+        case ('%'):  // % char
+            add_text_(compiled, "%", 1);
             break;
 
-        case ('F'):  // nanoseconds
-            formatters_.push_back(details::make_unique<details::F_formatter<Padder>>(padding));
+        case ('u'):  // elapsed time since last log message in nanos
+        case ('i'):  // elapsed time since last log message in micros
+        case ('o'):  // elapsed time since last log message in millis
+        case ('O'):  // elapsed time since last log message in seconds
+            add_call_(compiled, flag, padding);
+            compiled.shareable = false;
             break;
 
-        case ('E'):  // seconds since epoch
-            formatters_.push_back(details::make_unique<details::E_formatter<Padder>>(padding));
-            break;
+        default:  // Unknown flag appears as is
+            if (!padding.truncate_) {
+                add_text_(compiled, "%", 1);
+                add_text_(compiled, &flag, 1);
+            }
+            // fix issue #1617 (prev char was '!' and should have been treated as funcname flag
+            // instead of truncating flag) spdlog::set_pattern("[%10!] %v") => "[      main] some
+            // message" spdlog::set_pattern("[%3!!] %v") => "[mai] some message"
+            else {
+                padding.truncate_ = false;
+                add_flag_op_(compiled, '!', padding);
+                compiled.fields |= msg_field::source;
+                add_text_(compiled, &flag, 1);
+            }
 
-        case ('p'):  // am/pm
-            formatters_.push_back(details::make_unique<details::p_formatter<Padder>>(padding));
-            need_localtime_ = true;
             break;
+    }
+}
 
-        case ('r'):  // 12 hour clock 02:55:02 pm
-            formatters_.push_back(details::make_unique<details::r_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
+SPDLOG_INLINE details::pattern_op pattern_formatter::make_op_(char code,
+                                                            details::padding_info padding,
+                                                            size_t arg,
+                                                            size_t size) {
+    details::pattern_op op;
+    op.code = code;
+    op.pad_width = static_cast<std::uint8_t>(padding.width_);
+    op.pad_side = static_cast<std::uint8_t>(padding.side_);
+    op.pad_flags = 0;
+    if (padding.enabled()) {
+        op.pad_flags |= details::pattern_op::padded;
+    }
+    if (padding.truncate_) {
+        op.pad_flags |= details::pattern_op::truncate;
+    }
+    op.arg = static_cast<std::uint32_t>(arg);
+    op.size = static_cast<std::uint32_t>(size);
+    return op;
+}
 
-        case ('R'):  // 24-hour HH:MM time
-            formatters_.push_back(details::make_unique<details::R_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
+SPDLOG_INLINE void pattern_formatter::add_op_(details::compiled_pattern &compiled,
+                                              char code,
+                                              details::padding_info padding,
+                                              size_t arg,
+                                              size_t size) {
+    compiled.ops.push_back(make_op_(code, padding, arg, size));
+}
+
+// chars following the previous text op are appended to it
+SPDLOG_INLINE void pattern_formatter::add_text_(details::compiled_pattern &compiled,
+                                                const char *chars,
+                                                size_t size) {
+    auto &ops = compiled.ops;
+    if (!ops.empty() && ops.back().code == details::pattern_op::text) {
+        ops.back().size += static_cast<std::uint32_t>(size);
+    } else {
+        add_op_(compiled, details::pattern_op::text, details::padding_info{},
+                compiled.literals.size(), size);
+    }
+    compiled.literals.append(chars, size);
+}
 
+namespace details {
+// the width the flag formatter pads its field as, or -1 if it depends on the message
+static long pattern_flag_width_(char flag) {
+    switch (flag) {
+        case ('a'):
+        case ('b'):
+        case ('h'):
+            return 3;
+        case ('c'):
+            return 24;
+        case ('C'):
+        case ('m'):
+        case ('d'):
+        case ('H'):
+        case ('I'):
+        case ('M'):
+        case ('S'):
+        case ('p'):
+            return 2;
+        case ('D'):
+        case ('x'):
+        case ('E'):
+            return 10;
+        case ('Y'):
+            return 4;
+        case ('e'):
+            return 3;
+        case ('f'):
+            return 6;
+        case ('F'):
+            return 9;
+        case ('r'):
+            return 11;
+        case ('R'):
+            return 5;
         case ('T'):
-        case ('X'):  // ISO 8601 time format (HH:MM:SS)
-            formatters_.push_back(details::make_unique<details::T_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
+        case ('X'):
+            return 8;
+        default:
+            return -1;
+    }
+}
+}  // namespace details
 
-        case ('z'):  // timezone
-            formatters_.push_back(details::make_unique<details::z_formatter<Padder>>(padding));
-            need_localtime_ = true;
-            break;
+// the padding of the fixed width flags is resolved here: dropped if the field fits, or turned
+// into literal spaces around the flag. the other padded flags are padded by pad_field_() once
+// rendered.
+SPDLOG_INLINE void pattern_formatter::add_flag_op_(details::compiled_pattern &compiled,
+                                                   char flag,
+                                                   details::padding_info padding) {
+    if (flag == '^' || flag == '$') {  // the color range marks ignore the padding
+        padding = details::padding_info{};
+    }
+    const auto field_width = details::pattern_flag_width_(flag);
+    if (!padding.enabled() || field_width < 0) {
+        add_op_(compiled, flag, padding);
+        if (padding.enabled() && flag == '&') {  // pads each entry
+            compiled.ops.back().pad_flags |= details::pattern_op::scoped;
+        }
+        return;
+    }
+    const auto width = static_cast<long>(padding.width_);
+    if (field_width >= width) {
+        if (padding.truncate_ && field_width > width) {
+            // truncated by the field width the formatter declares (which isn't the rendered
+            // size for all of them)
+            add_op_(compiled, flag, padding);
+            compiled.ops.back().pad_flags |= details::pattern_op::scoped;
+        } else {
+            add_op_(compiled, flag, details::padding_info{});
+        }
+        return;
+    }
+    static const char spaces[] = "                                                                ";
+    const auto pad = static_cast<size_t>(width - field_width);
+    size_t left_pad = 0;
+    if (padding.side_ == details::padding_info::pad_side::left) {
+        left_pad = pad;
+    } else if (padding.side_ == details::padding_info::pad_side::center) {
+        left_pad = pad / 2;
+    }
+    if (left_pad != 0) {
+        add_text_(compiled, spaces, left_pad);
+    }
+    add_op_(compiled, flag, details::padding_info{});
+    if (pad != left_pad) {
+        add_text_(compiled, spaces, pad - left_pad);
+    }
+}
 
-        case ('P'):  // pid
-            formatters_.push_back(details::make_unique<details::pid_formatter<Padder>>(padding));
-            break;
+SPDLOG_INLINE void pattern_formatter::add_call_(details::compiled_pattern &compiled,
+                                                char flag,
+                                                details::padding_info padding) {
+    add_op_(compiled, details::pattern_op::call, details::padding_info{}, compiled.calls.size());
+    compiled.calls.push_back(make_op_(flag, padding));
+}
 
-        case ('^'):  // color range start
-            formatters_.push_back(details::make_unique<details::color_start_formatter>(padding));
-            break;
+// pad (or truncate) the field rendered since start to the width of the op, as scoped_padder
+// would have. a field already of the width costs one comparison.
+SPDLOG_INLINE void pattern_formatter::pad_field_(size_t start,
+                                                 const details::pattern_op &op,
+                                                 memory_buf_t &dest) {
+    const auto size = dest.size() - start;
+    const size_t width = op.pad_width;
+    if (size >= width) {
+        if (size > width && (op.pad_flags & details::pattern_op::truncate) != 0) {
+            dest.resize(start + width);
+        }
+        return;
+    }
+    const auto pad = width - size;
+    size_t left_pad = 0;
+    if (op.pad_side == static_cast<std::uint8_t>(details::padding_info::pad_side::left)) {
+        left_pad = pad;
+    } else if (op.pad_side == static_cast<std::uint8_t>(details::padding_info::pad_side::center)) {
+        left_pad = pad / 2;
+    }
+    dest.resize(start + width);
+    auto field = dest.data() + start;
+    if (left_pad != 0) {
+        std::memmove(field + left_pad, field, size);
+        std::memset(field, ' ', left_pad);
+    }
+    std::memset(field + left_pad + size, ' ', pad - left_pad);
+}
 
-        case ('$'):  // color range end
-            formatters_.push_back(details::make_unique<details::color_stop_formatter>(padding));
-            break;
+SPDLOG_INLINE void pattern_formatter::make_formatters_() {
+    formatters_.clear();
+    for (auto &call : compiled_->calls) {
+        if (call.pad_flags & details::pattern_op::padded) {
+            formatters_.push_back(make_formatter_<details::scoped_padder>(call));
+        } else {
+            formatters_.push_back(make_formatter_<details::null_scoped_padder>(call));
+        }
+    }
+    time_caches_.assign(compiled_->time_caches, details::pattern_time_cache{});
+    name_caches_.clear();
+    name_caches_.resize(compiled_->name_caches);
+}
 
-        case ('@'):  // source location (filename:filenumber)
-            formatters_.push_back(
-                details::make_unique<details::source_location_formatter<Padder>>(padding));
-            break;
+template <typename Padder>
+SPDLOG_INLINE std::unique_ptr<details::flag_formatter> pattern_formatter::make_formatter_(
+    const details::pattern_op &call) const {
+    const auto padding = call.padding();
+    auto it = custom_handlers_.find(call.code);
+    if (it != custom_handlers_.end()) {
+        auto custom_handler = it->second->clone();
+        custom_handler->set_padding_info(padding);
+#if defined(__GNUC__) && __GNUC__ < 5
+        return std::move(custom_handler);
+#else
+        return custom_handler;
+#endif
+    }
+    switch (call.code) {
+        case ('+'):
+            return details::make_unique<details::full_formatter>(padding, control_chars_);
+        case ('z'):
+            return details::make_unique<details::z_formatter<Padder>>(padding);
+        case ('u'):
+            return details::make_unique<
+                details::elapsed_formatter<Padder, std::chrono::nanoseconds>>(padding);
+        case ('i'):
+            return details::make_unique<
+                details::elapsed_formatter<Padder, std::chrono::microseconds>>(padding);
+        case ('o'):
+            return details::make_unique<
+                details::elapsed_formatter<Padder, std::chrono::milliseconds>>(padding);
+        default:  // 'O'
+            return details::make_unique<details::elapsed_formatter<Padder, std::chrono::seconds>>(
+                padding);
+    }
+}
 
-        case ('s'):  // short source filename - without directory name
-            formatters_.push_back(
-                details::make_unique<details::short_filename_formatter<Padder>>(padding));
-            break;
+// each run of ops rendering the same for a whole second (time flags down to the second, and the
+// text between them) with at least two time flags is preceded by a cached_time op, so it
+// is rendered once per second and only the other flags (e.g. the milliseconds) for each message.
+SPDLOG_INLINE void pattern_formatter::cache_time_ops_(details::compiled_pattern &compiled) {
+    auto is_time_op = [](const details::pattern_op &op) {
+        return std::strchr("aAbhBcCYDxmdHIMSEprRTX", op.code) != nullptr && op.code != '\0';
+    };
+    const auto &ops = compiled.ops;
+    std::vector<details::pattern_op> result;
+    result.reserve(ops.size());
+    compiled.time_caches = 0;
+    size_t i = 0;
+    while (i < ops.size()) {
+        // the run: time ops and text, starting and ending with a time op
+        size_t time_ops = 0;
+        size_t run_end = i;
+        for (size_t j = i; j < ops.size(); ++j) {
+            if (is_time_op(ops[j])) {
+                time_ops++;
+                run_end = j + 1;
+            } else if (ops[j].code != details::pattern_op::text) {
+                break;
+            }
+        }
+        if (!is_time_op(ops[i]) || time_ops < 2) {
+            result.push_back(ops[i++]);
+            continue;
+        }
+        details::pattern_op cached = ops[i];
+        cached.code = details::pattern_op::cached_time;
+        cached.pad_flags = 0;
+        cached.arg = static_cast<std::uint32_t>(compiled.time_caches);
+        cached.size = static_cast<std::uint32_t>(run_end - i);
+        result.push_back(cached);
+        result.insert(result.end(), ops.begin() + static_cast<std::ptrdiff_t>(i),
+                      ops.begin() + static_cast<std::ptrdiff_t>(run_end));
+        compiled.time_caches++;
+        i = run_end;
+    }
+    compiled.ops = std::move(result);
+}
 
-        case ('g'):  // full source filename
-            formatters_.push_back(
-                details::make_unique<details::source_filename_formatter<Padder>>(padding));
-            break;
+// each run of ops rendering the same for a logger name and level (the name, level and color
+// range flags, and the text between them) with at least two name or level flags is preceded by
+// a cached_name op, so it is rendered once per logger name and level, then copied at once.
+SPDLOG_INLINE void pattern_formatter::cache_name_ops_(details::compiled_pattern &compiled) {
+    auto is_name_op = [](const details::pattern_op &op) {
+        return op.code == 'n' || op.code == 'l' || op.code == 'L' || op.code == '^' ||
+               op.code == '$';
+    };
+    const auto &ops = compiled.ops;
+    std::vector<details::pattern_op> result;
+    result.reserve(ops.size());
+    compiled.name_caches = 0;
+    size_t i = 0;
+    while (i < ops.size()) {
+        if (ops[i].code == details::pattern_op::cached_time) {  // copied with its run
+            auto run_end = i + 1 + ops[i].size;
+            result.insert(result.end(), ops.begin() + static_cast<std::ptrdiff_t>(i),
+                          ops.begin() + static_cast<std::ptrdiff_t>(run_end));
+            i = run_end;
+            continue;
+        }
+        // the run: name, level and color range ops and text, starting and ending with one
+        size_t name_ops = 0;
+        size_t run_end = i;
+        std::uint8_t color_flags = 0;
+        for (size_t j = i; j < ops.size(); ++j) {
+            if (is_name_op(ops[j])) {
+                if (ops[j].code == '^') {
+                    color_flags |= details::pattern_op::color_start;
+                } else if (ops[j].code == '$') {
+                    color_flags |= details::pattern_op::color_end;
+                } else {
+                    name_ops++;
+                }
+                run_end = j + 1;
+            } else if (ops[j].code != details::pattern_op::text) {
+                break;
+            }
+        }
+        if (!is_name_op(ops[i]) || name_ops < 2) {
+            result.push_back(ops[i++]);
+            continue;
+        }
+        details::pattern_op cached = ops[i];
+        cached.code = details::pattern_op::cached_name;
+        cached.pad_flags = color_flags;
+        cached.arg = static_cast<std::uint32_t>(compiled.name_caches);
+        cached.size = static_cast<std::uint32_t>(run_end - i);
+        result.push_back(cached);
+        result.insert(result.end(), ops.begin() + static_cast<std::ptrdiff_t>(i),
+                      ops.begin() + static_cast<std::ptrdiff_t>(run_end));
+        compiled.name_caches++;
+        i = run_end;
+    }
+    compiled.ops = std::move(result);
+}
 
-        case ('#'):  // source line number
-            formatters_.push_back(
-                details::make_unique<details::source_linenum_formatter<Padder>>(padding));
+SPDLOG_INLINE void pattern_formatter::run_cached_name_(const details::pattern_op *op,
+                                                       const details::log_msg &msg,
+                                                       memory_buf_t &dest) {
+    const auto level_index = static_cast<size_t>(msg.level);
+    if (level_index >= level::n_levels) {
+        run_ops_(op + 1, op + 1 + op->size, msg, dest);
+        return;
+    }
+    auto &cache = name_caches_[op->arg];
+    auto *entries = cache.entries[level_index];
+    const auto start = dest.size();
+    const details::pattern_name_cache::entry *hit = nullptr;
+    for (size_t i = 0; i < details::pattern_name_cache::ways; ++i) {
+        const auto &entry = entries[i];
+        if (entry.used && entry.name.size() == msg.logger_name.size() &&
+            std::memcmp(entry.name.data(), msg.logger_name.data(), entry.name.size()) == 0) {
+            hit = &entry;
             break;
+        }
+    }
+    if (hit == nullptr) {
+        run_ops_(op + 1, op + 1 + op->size, msg, dest);
+        auto &entry = entries[cache.next[level_index]];
+        cache.next[level_index] = static_cast<std::uint8_t>((cache.next[level_index] + 1) %
+                                                            details::pattern_name_cache::ways);
+        entry.used = true;
+        entry.name.assign(msg.logger_name.data(), msg.logger_name.size());
+        entry.text.assign(dest.data() + start, dest.size() - start);
+        entry.color_range_start = msg.color_range_start - start;
+        entry.color_range_end = msg.color_range_end - start;
+        return;
+    }
+    details::fmt_helper::append_string_view(hit->text, dest);
+    if (op->pad_flags & details::pattern_op::color_start) {
+        msg.color_range_start = start + hit->color_range_start;
+    }
+    if (op->pad_flags & details::pattern_op::color_end) {
+        msg.color_range_end = start + hit->color_range_end;
+    }
+}
 
-        case ('!'):  // source funcname
-            formatters_.push_back(
-                details::make_unique<details::source_funcname_formatter<Padder>>(padding));
+// the flag formatters are built on the stack and their format() is called directly, so the
+// calls are not virtual and get inlined.
+template <typename Padder>
+SPDLOG_INLINE void pattern_formatter::run_op_(const details::pattern_op &op,
+                                              const details::log_msg &msg,
+                                              memory_buf_t &dest) {
+    using namespace details;
+    const auto padding = op.padding();
+    switch (op.code) {
+        case ('n'):
+            name_formatter<Padder>(padding).format(msg, cached_tm_, dest);
             break;
-
-        case ('%'):  // % char
-            formatters_.push_back(details::make_unique<details::ch_formatter>('%'));
+        case ('l'):
+            level_formatter<Padder>(padding).format(msg, cached_tm_, dest);
             break;
-
-        case ('u'):  // elapsed time since last log message in nanos
-            formatters_.push_back(
-                details::make_unique<details::elapsed_formatter<Padder, std::chrono::nanoseconds>>(
-                    padding));
+        case ('L'):
+            short_level_formatter<Padder>(padding).format(msg, cached_tm_, dest);
             break;
-
-        case ('i'):  // elapsed time since last log message in micros
-            formatters_.push_back(
-                details::make_unique<details::elapsed_formatter<Padder, std::chrono::microseconds>>(
-                    padding));
+        case ('t'):
+            t_formatter<Padder>(padding).format(msg, cached_tm_, dest);
             break;
-
-        case ('o'):  // elapsed time since last log message in millis
-            formatters_.push_back(
-                details::make_unique<details::elapsed_formatter<Padder, std::chrono::milliseconds>>(
-                    padding));
+        case ('N'):
+            thread_name_formatter<Padder>(padding).format(msg, cached_tm_, dest);
             break;
-
-        case ('O'):  // elapsed time since last log message in seconds
-            formatters_.push_back(
-                details::make_unique<details::elapsed_formatter<Padder, std::chrono::seconds>>(
-                    padding));
+        case ('v'):
+            v_formatter<Padder>(padding, control_chars_).format(msg, cached_tm_, dest);
             break;
-
-#ifndef SPDLOG_NO_TLS  // mdc formatter requires TLS support
+        case ('a'):
+            a_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('A'):
+            A_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('b'):
+        case ('h'):
+            b_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('B'):
+            B_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('c'):
+            c_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('C'):
+            C_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('Y'):
+            Y_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('D'):
+        case ('x'):
+            D_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('m'):
+            m_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('d'):
+            d_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('H'):
+            H_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('I'):
+            I_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('M'):
+            M_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('S'):
+            S_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('e'):
+            e_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('f'):
+            f_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('F'):
+            F_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('E'):
+            E_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('p'):
+            p_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('r'):
+            r_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('R'):
+            R_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('T'):
+        case ('X'):
+            T_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('P'):
+            pid_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('^'):
+            color_start_formatter(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('$'):
+            color_stop_formatter(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('@'):
+            source_location_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('s'):
+            short_filename_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('g'):
+            source_filename_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('#'):
+            source_linenum_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+        case ('!'):
+            source_funcname_formatter<Padder>(padding).format(msg, cached_tm_, dest);
+            break;
+#ifndef SPDLOG_NO_TLS
         case ('&'):
-            formatters_.push_back(details::make_unique<details::mdc_formatter<Padder>>(padding));
+            mdc_formatter<Padder>(padding).format(msg, cached_tm_, dest);
             break;
 #endif
-
-        default:  // Unknown flag appears as is
-            auto unknown_flag = details::make_unique<details::aggregate_formatter>();
-
-            if (!padding.truncate_) {
-                unknown_flag->add_ch('%');
-                unknown_flag->add_ch(flag);
-                formatters_.push_back((std::move(unknown_flag)));
-            }
-            // fix issue #1617 (prev char was '!' and should have been treated as funcname flag
-            // instead of truncating flag) spdlog::set_pattern("[%10!] %v") => "[      main] some
-            // message" spdlog::set_pattern("[%3!!] %v") => "[mai] some message"
-            else {
-                padding.truncate_ = false;
-                formatters_.push_back(
-                    details::make_unique<details::source_funcname_formatter<Padder>>(padding));
-                unknown_flag->add_ch(flag);
-                formatters_.push_back((std::move(unknown_flag)));
-            }
-
+        default:
             break;
     }
 }
@@ -1302,37 +882,43 @@ SPDLOG_INLINE details::padding_info pattern_formatter::handle_padspec_(
 
 SPDLOG_INLINE void pattern_formatter::compile_pattern_(const std::string &pattern) {
     auto end = pattern.end();
-    std::unique_ptr<details::aggregate_formatter> user_chars;
-    formatters_.clear();
+    auto user_chars = pattern.begin();
+    auto compiled = std::make_shared<details::compiled_pattern>();
     for (auto it = pattern.begin(); it != end; ++it) {
         if (*it == '%') {
-            if (user_chars)  // append user chars found so far
+            if (user_chars != it)  // append user chars found so far
             {
-                formatters_.push_back(std::move(user_chars));
+                add_text_(*compiled, &*user_chars, static_cast<size_t>(it - user_chars));
             }
 
             auto padding = handle_padspec_(++it, end);
 
             if (it != end) {
-                if (padding.enabled()) {
-                    handle_flag_<details::scoped_padder>(*it, padding);
-                } else {
-                    handle_flag_<details::null_scoped_padder>(*it, padding);
-                }
+                handle_flag_(*compiled, *it, padding);
+                user_chars = it + 1;
             } else {
+                user_chars = end;
                 break;
             }
-        } else  // chars not following the % sign should be displayed as is
-        {
-            if (!user_chars) {
-                user_chars = details::make_unique<details::aggregate_formatter>();
-            }
-            user_chars->add_ch(*it);
         }
+        // chars not following the % sign are displayed as is
     }
-    if (user_chars)  // append raw chars found so far
+    if (user_chars != end)  // append raw chars found so far
     {
-        formatters_.push_back(std::move(user_chars));
-    }
+        add_text_(*compiled, &*user_chars, static_cast<size_t>(end - user_chars));
+    }
+    cache_time_ops_(*compiled);
+    cache_name_ops_(*compiled);
+    need_localtime_ = need_localtime_ || compiled->need_localtime;
+    compiled_ = std::move(compiled);
+    custom_flags_changed_ = false;
+    make_formatters_();
+}
+
+SPDLOG_INLINE std::shared_ptr<const details::compiled_pattern>
+pattern_formatter::default_compiled_() {
+    static const std::shared_ptr<const details::compiled_pattern> compiled =
+        pattern_formatter("%+").compiled_;
+    return compiled;
 }
 }  // namespace spdlog
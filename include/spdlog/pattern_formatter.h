@@ -9,6 +9,7 @@
 #include <spdlog/formatter.h>
 
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <memory>
 
@@ -37,6 +38,78 @@ struct padding_info {
     bool enabled_ = false;
 };
 
+// one step of a compiled pattern: a built-in flag (its char) with the padding inline,
+// a run of literal chars, or a call to a flag formatter object (custom or stateful flags).
+struct pattern_op {
+    static constexpr char text = 0;  // append literals[arg, arg + size)
+    static constexpr char call = 1;  // call formatters[arg]
+    // the next size ops render the same for a whole second: use time_caches[arg]
+    static constexpr char cached_time = 2;
+    // the next size ops render the same for a logger name and level: use name_caches[arg]
+    static constexpr char cached_name = 3;
+
+    char code;
+    std::uint8_t pad_width;
+    std::uint8_t pad_side;
+    std::uint8_t pad_flags;
+    std::uint32_t arg;
+    std::uint32_t size;
+
+    static constexpr std::uint8_t padded = 1;
+    static constexpr std::uint8_t truncate = 2;
+    // padded by a scoped_padder while rendering, not by pattern_formatter::pad_field_() after
+    static constexpr std::uint8_t scoped = 4;
+    // the ops of a cached_name op set the start or the end of the color range
+    static constexpr std::uint8_t color_start = 8;
+    static constexpr std::uint8_t color_end = 16;
+
+    padding_info padding() const {
+        if ((pad_flags & padded) == 0) {
+            return padding_info{};
+        }
+        return padding_info{pad_width, static_cast<padding_info::pad_side>(pad_side),
+                            (pad_flags & truncate) != 0};
+    }
+};
+
+// the rendered text of a run of time flags (e.g. "%Y-%m-%d %H:%M:%S") for a given second
+struct pattern_time_cache {
+    std::chrono::seconds secs{(std::chrono::seconds::min)()};
+    std::string text;
+};
+
+// the rendered text of a run of logger name and level flags (e.g. "[%n] [%^%l%$]") for the
+// last logger names seen at each level
+struct pattern_name_cache {
+    struct entry {
+        bool used = false;
+        std::string name;
+        std::string text;
+        size_t color_range_start = 0;  // in text
+        size_t color_range_end = 0;
+    };
+    static constexpr size_t ways = 4;  // names per level
+    entry entries[level::n_levels][ways];
+    std::uint8_t next[level::n_levels] = {};  // the entry replaced on a miss, in turn
+};
+
+// a compiled pattern, shared by a pattern_formatter and its clones: the ops run in order, with
+// the literal chars in literals. the flags keeping a state (custom, '+', 'z' and the elapsed
+// times) are objects of each formatter, made from calls (their flag and padding).
+struct compiled_pattern {
+    std::vector<pattern_op> ops;
+    std::string literals;
+    std::vector<pattern_op> calls;
+    size_t time_caches = 0;  // number of cached_time ops
+    size_t name_caches = 0;  // number of cached_name ops
+    bool need_localtime = false;
+    // the output only depends on the message (no custom or elapsed time flags), so it can
+    // be shared with identical formatters (see details::shared_format)
+    bool shareable = true;
+    bool sets_color_range = false;
+    unsigned fields = msg_field::none;  // the log_msg fields the ops read
+};
+
 class SPDLOG_API flag_formatter {
 public:
     explicit flag_formatter(padding_info padinfo)
@@ -80,28 +153,77 @@ public:
 
     std::unique_ptr<formatter> clone() const override;
     void format(const details::log_msg &msg, memory_buf_t &dest) override;
+    unsigned needed_fields() const override;
 
     template <typename T, typename... Args>
     pattern_formatter &add_flag(char flag, Args &&...args) {
         custom_handlers_[flag] = details::make_unique<T>(std::forward<Args>(args)...);
+        custom_flags_changed_ = true;
         return *this;
     }
     void set_pattern(std::string pattern);
     void need_localtime(bool need = true);
+    // escape or strip the control chars of the payloads (%v and %+), e.g. for the messages
+    // not to forge log lines. the payloads without any are copied as is.
+    void set_control_chars(control_chars chars);
 
 private:
     std::string pattern_;
     std::string eol_;
     pattern_time_type pattern_time_type_;
     bool need_localtime_;
+    control_chars control_chars_ = control_chars::keep;
     std::tm cached_tm_;
     std::chrono::seconds last_log_secs_;
+    // the compiled pattern (shared with the clones), and the state of this formatter: the
+    // objects called by the ops and the last renderings of the runs of time flags, and of
+    // logger name and level flags
+    std::shared_ptr<const details::compiled_pattern> compiled_;
     std::vector<std::unique_ptr<details::flag_formatter>> formatters_;
+    std::vector<details::pattern_time_cache> time_caches_;
+    std::vector<details::pattern_name_cache> name_caches_;
     custom_flags custom_handlers_;
+    bool custom_flags_changed_ = false;  // since the pattern was compiled
+
+    pattern_formatter(const pattern_formatter &other, custom_flags custom_user_flags);
 
     std::tm get_time_(const details::log_msg &msg);
+    void handle_flag_(details::compiled_pattern &compiled,
+                      char flag,
+                      details::padding_info padding);
+    static details::pattern_op make_op_(char code,
+                                        details::padding_info padding,
+                                        size_t arg = 0,
+                                        size_t size = 0);
+    static void add_op_(details::compiled_pattern &compiled,
+                        char code,
+                        details::padding_info padding,
+                        size_t arg = 0,
+                        size_t size = 0);
+    static void add_text_(details::compiled_pattern &compiled, const char *chars, size_t size);
+    static void add_flag_op_(details::compiled_pattern &compiled,
+                             char flag,
+                             details::padding_info padding);
+    static void add_call_(details::compiled_pattern &compiled,
+                          char flag,
+                          details::padding_info padding);
+    void make_formatters_();
+    template <typename Padder>
+    std::unique_ptr<details::flag_formatter> make_formatter_(
+        const details::pattern_op &call) const;
+    bool same_format_(const pattern_formatter &other) const;
+    static void cache_time_ops_(details::compiled_pattern &compiled);
+    static void cache_name_ops_(details::compiled_pattern &compiled);
+    void run_cached_name_(const details::pattern_op *op,
+                          const details::log_msg &msg,
+                          memory_buf_t &dest);
+    void run_ops_(const details::pattern_op *first,
+                  const details::pattern_op *last,
+                  const details::log_msg &msg,
+                  memory_buf_t &dest);
     template <typename Padder>
-    void handle_flag_(char flag, details::padding_info padding);
+    void run_op_(const details::pattern_op &op, const details::log_msg &msg, memory_buf_t &dest);
+    static void pad_field_(size_t start, const details::pattern_op &op, memory_buf_t &dest);
 
     // Extract given pad spec (e.g. %8X)
     // Advance the given it pass the end of the padding spec found (if any)
@@ -110,6 +232,8 @@ private:
                                                  std::string::const_iterator end);
 
     void compile_pattern_(const std::string &pattern);
+    // the default pattern, compiled at the first use and shared by all the formatters using it
+    static std::shared_ptr<const details::compiled_pattern> default_compiled_();
 };
 }  // namespace spdlog
 
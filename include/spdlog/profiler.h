@@ -0,0 +1,287 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#if defined(SPDLOG_NO_TLS)
+    #error "This header requires thread local storage support, but SPDLOG_NO_TLS is defined."
+#endif
+
+// Profiling of scopes: SPDLOG_PROFILE_SCOPE(name) records the time until the end of the scope
+// in a histogram of the calling thread (see latency_snapshot), without formatting anything.
+// The scopes of the same name share their histograms. A profile_reporter merges the histograms
+// of all the threads every interval, and logs the percentiles of the durations recorded since
+// its previous report through the given logger.
+//
+// The scopes are timed with a tsc_stopwatch (a few cycles to read, steady_clock until it is
+// calibrated), and each thread writes its own histograms with plain relaxed stores, so a scope
+// costs a few ns. The histograms of the threads which exit are kept.
+//
+// Usage example:
+// spdlog::profile_reporter reporter(spdlog::default_logger(), std::chrono::seconds(10));
+// ...
+// void parse(const char *data) {
+//     SPDLOG_PROFILE_SCOPE("parse");
+//     ...
+// }
+// => [info] profile parse: 48213 calls, mean 1.2us, p50 1.0us, p90 2.0us, p99 6.0us, max 80.0us
+
+#include <spdlog/details/latency_histogram.h>
+#include <spdlog/details/periodic_worker.h>
+#include <spdlog/logger.h>
+#include <spdlog/stopwatch.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spdlog {
+
+// the durations recorded by the scopes of a name, all threads together
+struct profile_snapshot {
+    std::string name;
+    latency_snapshot durations;
+};
+
+namespace details {
+
+// the durations of a name recorded by one thread, which is the only one writing them: the
+// counters are updated with relaxed loads and stores, not atomic increments
+class profile_histogram {
+public:
+    void record(std::uint64_t ns) SPDLOG_NOEXCEPT {
+        auto &bucket = buckets_[latency_snapshot::bucket_of(ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total_ns_.store(total_ns_.load(std::memory_order_relaxed) + ns,
+                        std::memory_order_relaxed);
+    }
+
+    void add_to(latency_snapshot &snapshot) const SPDLOG_NOEXCEPT {
+        for (size_t i = 0; i < latency_snapshot::buckets_n; i++) {
+            auto n = buckets_[i].load(std::memory_order_relaxed);
+            snapshot.buckets[i] += n;
+            snapshot.count += n;
+        }
+        snapshot.total_ns += total_ns_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, latency_snapshot::buckets_n> buckets_{};
+    std::atomic<std::uint64_t> total_ns_{0};
+};
+
+// the names profiled, and the histograms of each thread
+class profiler {
+public:
+    static profiler &instance() {
+        static profiler s_instance;
+        return s_instance;
+    }
+
+    // the index of the name, the same for all the scopes of that name
+    size_t site(const char *name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(names_.begin(), names_.end(), name);
+        if (it != names_.end()) {
+            return static_cast<size_t>(it - names_.begin());
+        }
+        names_.emplace_back(name);
+        retired_.emplace_back();
+        return names_.size() - 1;
+    }
+
+    // the histogram of the site for the calling thread
+    profile_histogram &histogram(size_t site) {
+        auto &data = thread_data_();
+        if (site < data.histograms.size() && data.histograms[site]) {
+            return *data.histograms[site];
+        }
+        std::lock_guard<std::mutex> lock(data.mutex);
+        if (site >= data.histograms.size()) {
+            data.histograms.resize(site + 1);
+        }
+        data.histograms[site].reset(new profile_histogram());
+        return *data.histograms[site];
+    }
+
+    // the durations recorded so far, by site
+    std::vector<profile_snapshot> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<profile_snapshot> result(names_.size());
+        for (size_t i = 0; i < names_.size(); i++) {
+            result[i].name = names_[i];
+            result[i].durations = retired_[i];
+        }
+        for (auto *data : threads_) {
+            std::lock_guard<std::mutex> data_lock(data->mutex);
+            add_histograms_(*data, result);
+        }
+        return result;
+    }
+
+private:
+    struct thread_data {
+        std::mutex mutex;  // while the histograms grow, or are read by another thread
+        std::vector<std::unique_ptr<profile_histogram>> histograms;  // by site
+
+        thread_data() { profiler::instance().add_thread_(this); }
+        ~thread_data() { profiler::instance().remove_thread_(this); }
+    };
+
+    std::mutex mutex_;
+    std::vector<std::string> names_;         // by site
+    std::vector<latency_snapshot> retired_;  // of the threads which exited, by site
+    std::vector<thread_data *> threads_;     // the threads which profiled some scopes
+
+    static thread_data &thread_data_() {
+        static thread_local thread_data data;
+        return data;
+    }
+
+    void add_thread_(thread_data *data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(data);
+    }
+
+    void remove_thread_(thread_data *data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < data->histograms.size(); i++) {
+            if (data->histograms[i]) {
+                data->histograms[i]->add_to(retired_[i]);
+            }
+        }
+        threads_.erase(std::remove(threads_.begin(), threads_.end(), data), threads_.end());
+    }
+
+    static void add_histograms_(const thread_data &data, std::vector<profile_snapshot> &result) {
+        for (size_t i = 0; i < data.histograms.size(); i++) {
+            if (data.histograms[i]) {
+                data.histograms[i]->add_to(result[i].durations);
+            }
+        }
+    }
+};
+
+}  // namespace details
+
+// a name profiled, registered once by each SPDLOG_PROFILE_SCOPE
+class profile_site {
+public:
+    explicit profile_site(const char *name)
+        : index_(details::profiler::instance().site(name)) {}
+
+    size_t index() const { return index_; }
+
+private:
+    size_t index_;
+};
+
+// records its lifetime in the calling thread's histogram of the site
+class profile_scope {
+public:
+    explicit profile_scope(const profile_site &site)
+        : site_(site.index()) {}
+
+    profile_scope(const profile_scope &) = delete;
+    profile_scope &operator=(const profile_scope &) = delete;
+
+    ~profile_scope() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stopwatch_.elapsed());
+        details::profiler::instance().histogram(site_).record(
+            static_cast<std::uint64_t>(ns.count() < 0 ? 0 : ns.count()));
+    }
+
+private:
+    size_t site_;
+    tsc_stopwatch stopwatch_;
+};
+
+// the durations recorded so far by the scopes of each name
+inline std::vector<profile_snapshot> profile_snapshots() {
+    return details::profiler::instance().snapshot();
+}
+
+// logs the durations of each name profiled since the previous report, every interval (on the
+// housekeeping scheduler's thread) and on report()
+class profile_reporter {
+public:
+    profile_reporter(std::shared_ptr<logger> logger,
+                     std::chrono::milliseconds interval,
+                     level::level_enum lvl = level::info)
+        : logger_(std::move(logger)),
+          level_(lvl) {
+        if (!logger_) {
+            throw_spdlog_ex("profile_reporter: logger cannot be null");
+        }
+        timer_ = details::make_unique<details::periodic_worker>(
+            [this] {
+                SPDLOG_TRY { report(); }
+                SPDLOG_CATCH_STD
+            },
+            interval);
+    }
+
+    profile_reporter(const profile_reporter &) = delete;
+    profile_reporter &operator=(const profile_reporter &) = delete;
+
+    ~profile_reporter() { timer_.reset(); }
+
+    void report() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto snapshots = profile_snapshots();
+        previous_.resize(snapshots.size());
+        for (size_t i = 0; i < snapshots.size(); i++) {
+            auto interval = snapshots[i].durations;
+            const auto &previous = previous_[i];
+            for (size_t b = 0; b < latency_snapshot::buckets_n; b++) {
+                interval.buckets[b] -= previous.buckets[b];
+            }
+            interval.count -= previous.count;
+            interval.total_ns -= previous.total_ns;
+            previous_[i] = snapshots[i].durations;
+            if (interval.count == 0) {
+                continue;
+            }
+            logger_->log(level_, "profile {}: {} calls, mean {}, p50 {}, p90 {}, p99 {}, max {}",
+                         snapshots[i].name, interval.count, duration_(interval.mean()),
+                         duration_(interval.percentile(0.5)), duration_(interval.percentile(0.9)),
+                         duration_(interval.percentile(0.99)), duration_(interval.percentile(1)));
+        }
+    }
+
+private:
+    std::shared_ptr<logger> logger_;
+    level::level_enum level_;
+    std::mutex mutex_;                        // one report at a time
+    std::vector<latency_snapshot> previous_;  // the snapshots of the previous report, by site
+    std::unique_ptr<details::periodic_worker> timer_;
+
+    static std::string duration_(std::chrono::nanoseconds duration) {
+        auto ns = static_cast<double>(duration.count());
+        if (ns < 1e3) {
+            return fmt_lib::format("{}ns", duration.count());
+        }
+        if (ns < 1e6) {
+            return fmt_lib::format("{:.1f}us", ns / 1e3);
+        }
+        if (ns < 1e9) {
+            return fmt_lib::format("{:.1f}ms", ns / 1e6);
+        }
+        return fmt_lib::format("{:.1f}s", ns / 1e9);
+    }
+};
+
+}  // namespace spdlog
+
+#define SPDLOG_PROFILE_CONCAT_(a, b) a##b
+#define SPDLOG_PROFILE_NAME_(prefix, line) SPDLOG_PROFILE_CONCAT_(prefix, line)
+#define SPDLOG_PROFILE_SCOPE(name)                                                         \
+    static const spdlog::profile_site SPDLOG_PROFILE_NAME_(spdlog_profile_site_, __LINE__)(name); \
+    spdlog::profile_scope SPDLOG_PROFILE_NAME_(spdlog_profile_scope_, __LINE__)(           \
+        SPDLOG_PROFILE_NAME_(spdlog_profile_site_, __LINE__))
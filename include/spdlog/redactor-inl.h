@@ -0,0 +1,358 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+    #include <spdlog/redactor.h>
+#endif
+
+#include <algorithm>
+#include <bitset>
+#include <limits>
+#include <map>
+#include <utility>
+
+namespace spdlog {
+namespace details {
+namespace redaction {
+
+using char_set = std::bitset<256>;
+
+static const size_t unbounded = std::numeric_limits<size_t>::max();
+static const size_t max_repeat = 1000;
+static const size_t max_dfa_states = 4096;
+
+struct atom {
+    char_set chars;
+    size_t min;
+    size_t max;
+};
+
+struct nfa_state {
+    std::vector<std::pair<char_set, size_t>> edges;
+    std::vector<size_t> epsilons;
+    bool accepting = false;
+};
+
+SPDLOG_INLINE void add_range(char_set &chars, unsigned char first, unsigned char last) {
+    for (unsigned c = first; c <= last; c++) {
+        chars.set(c);
+    }
+}
+
+SPDLOG_INLINE bool add_class(char_set &chars, char c) {
+    switch (c) {
+        case 'd':
+            add_range(chars, '0', '9');
+            return true;
+        case 'w':
+            add_range(chars, '0', '9');
+            add_range(chars, 'a', 'z');
+            add_range(chars, 'A', 'Z');
+            chars.set('_');
+            return true;
+        case 's':
+            for (char space : {' ', '\t', '\n', '\r', '\f', '\v'}) {
+                chars.set(static_cast<unsigned char>(space));
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+[[noreturn]] SPDLOG_INLINE void invalid(const std::string &pattern, const char *what) {
+    throw_spdlog_ex("redactor: " + std::string(what) + " in pattern \"" + pattern + "\"");
+}
+
+// [...] after the '['. pos is left after the ']'.
+SPDLOG_INLINE char_set parse_bracket(const std::string &pattern, size_t &pos) {
+    char_set chars;
+    bool negated = pos < pattern.size() && pattern[pos] == '^';
+    if (negated) {
+        pos++;
+    }
+    bool first = true;
+    while (pos < pattern.size() && (pattern[pos] != ']' || first)) {
+        first = false;
+        auto c = static_cast<unsigned char>(pattern[pos++]);
+        if (c == '\\') {
+            if (pos == pattern.size()) {
+                invalid(pattern, "trailing \\");
+            }
+            if (add_class(chars, pattern[pos])) {
+                pos++;
+                continue;
+            }
+            c = static_cast<unsigned char>(pattern[pos++]);
+        }
+        if (pos + 1 < pattern.size() && pattern[pos] == '-' && pattern[pos + 1] != ']') {
+            auto last = static_cast<unsigned char>(pattern[pos + 1]);
+            if (last < c) {
+                invalid(pattern, "invalid range");
+            }
+            add_range(chars, c, last);
+            pos += 2;
+        } else {
+            chars.set(c);
+        }
+    }
+    if (pos == pattern.size()) {
+        invalid(pattern, "missing ]");
+    }
+    pos++;
+    return negated ? ~chars : chars;
+}
+
+SPDLOG_INLINE size_t parse_count(const std::string &pattern, size_t &pos) {
+    size_t n = 0;
+    size_t digits = 0;
+    while (pos < pattern.size() && pattern[pos] >= '0' && pattern[pos] <= '9') {
+        n = n * 10 + static_cast<size_t>(pattern[pos++] - '0');
+        if (++digits > 4) {
+            invalid(pattern, "repetition too large");
+        }
+    }
+    if (digits == 0) {
+        invalid(pattern, "invalid repetition");
+    }
+    return n;
+}
+
+SPDLOG_INLINE std::vector<atom> parse(const std::string &pattern) {
+    std::vector<atom> atoms;
+    size_t pos = 0;
+    while (pos < pattern.size()) {
+        atom a{char_set(), 1, 1};
+        char c = pattern[pos++];
+        switch (c) {
+            case '.':
+                a.chars.set();
+                break;
+            case '[':
+                a.chars = parse_bracket(pattern, pos);
+                break;
+            case '\\':
+                if (pos == pattern.size()) {
+                    invalid(pattern, "trailing \\");
+                }
+                if (!add_class(a.chars, pattern[pos])) {
+                    a.chars.set(static_cast<unsigned char>(pattern[pos]));
+                }
+                pos++;
+                break;
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+            case '}':
+            case ']':
+                invalid(pattern, "unexpected special char");
+            default:
+                a.chars.set(static_cast<unsigned char>(c));
+        }
+        if (pos < pattern.size()) {
+            switch (pattern[pos]) {
+                case '*':
+                    a.min = 0;
+                    a.max = unbounded;
+                    pos++;
+                    break;
+                case '+':
+                    a.max = unbounded;
+                    pos++;
+                    break;
+                case '?':
+                    a.min = 0;
+                    pos++;
+                    break;
+                case '{':
+                    pos++;
+                    a.min = parse_count(pattern, pos);
+                    a.max = a.min;
+                    if (pos < pattern.size() && pattern[pos] == ',') {
+                        pos++;
+                        a.max = pos < pattern.size() && pattern[pos] == '}'
+                                    ? unbounded
+                                    : parse_count(pattern, pos);
+                    }
+                    if (pos == pattern.size() || pattern[pos] != '}') {
+                        invalid(pattern, "missing }");
+                    }
+                    pos++;
+                    if (a.max < a.min || a.min > max_repeat ||
+                        (a.max != unbounded && a.max > max_repeat)) {
+                        invalid(pattern, "invalid repetition");
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        atoms.push_back(a);
+    }
+    return atoms;
+}
+
+// add the chain of states of the pattern, from the start state (0)
+SPDLOG_INLINE void add_pattern(std::vector<nfa_state> &nfa, const std::vector<atom> &atoms) {
+    auto new_state = [&nfa] {
+        nfa.emplace_back();
+        return nfa.size() - 1;
+    };
+    auto state = new_state();
+    nfa[0].epsilons.push_back(state);
+    for (const auto &a : atoms) {
+        for (size_t i = 0; i < a.min; i++) {
+            auto next = new_state();
+            nfa[state].edges.emplace_back(a.chars, next);
+            state = next;
+        }
+        if (a.max == unbounded) {
+            // a state of its own, so that the loop doesn't mix with the previous atom's
+            auto loop = new_state();
+            nfa[state].epsilons.push_back(loop);
+            nfa[loop].edges.emplace_back(a.chars, loop);
+            state = loop;
+            continue;
+        }
+        std::vector<size_t> skipping;
+        for (size_t i = a.min; i < a.max; i++) {
+            auto next = new_state();
+            nfa[state].edges.emplace_back(a.chars, next);
+            skipping.push_back(state);
+            state = next;
+        }
+        for (auto skip : skipping) {
+            nfa[skip].epsilons.push_back(state);
+        }
+    }
+    nfa[state].accepting = true;
+}
+
+// without duplicates
+SPDLOG_INLINE void add_closure(const std::vector<nfa_state> &nfa,
+                               size_t state,
+                               std::vector<bool> &seen,
+                               std::vector<size_t> &closure) {
+    if (seen[state]) {
+        return;
+    }
+    seen[state] = true;
+    closure.push_back(state);
+    for (auto next : nfa[state].epsilons) {
+        add_closure(nfa, next, seen, closure);
+    }
+}
+
+}  // namespace redaction
+}  // namespace details
+
+SPDLOG_INLINE redactor::redactor(const std::vector<std::string> &patterns, char mask)
+    : mask_(mask) {
+    using namespace details::redaction;
+    std::vector<nfa_state> nfa(1);
+    for (const auto &pattern : patterns) {
+        add_pattern(nfa, parse(pattern));
+    }
+
+    // subset construction: a DFA state per set of NFA states, the dead state first
+    std::map<std::vector<size_t>, std::uint32_t> ids;
+    std::vector<std::vector<size_t>> sets(1);
+    ids[sets[0]] = dead_state;
+    std::vector<bool> seen(nfa.size());
+    std::vector<size_t> start;
+    add_closure(nfa, 0, seen, start);
+    std::sort(start.begin(), start.end());
+    ids[start] = start_state;
+    sets.push_back(std::move(start));
+
+    std::vector<size_t> targets;
+    for (size_t id = 0; id < sets.size(); id++) {
+        bool accepting = false;
+        for (auto state : sets[id]) {
+            accepting = accepting || nfa[state].accepting;
+        }
+        accepting_.push_back(accepting ? 1 : 0);
+        transitions_.resize(sets.size() * 256);
+        for (unsigned c = 0; c < 256; c++) {
+            targets.clear();
+            std::fill(seen.begin(), seen.end(), false);
+            for (auto state : sets[id]) {
+                for (const auto &edge : nfa[state].edges) {
+                    if (edge.first.test(c)) {
+                        add_closure(nfa, edge.second, seen, targets);
+                    }
+                }
+            }
+            std::sort(targets.begin(), targets.end());
+            auto it = ids.find(targets);
+            if (it == ids.end()) {
+                if (sets.size() == max_dfa_states) {
+                    throw_spdlog_ex("redactor: the patterns need too many DFA states");
+                }
+                it = ids.emplace(targets, static_cast<std::uint32_t>(sets.size())).first;
+                sets.push_back(targets);
+            }
+            transitions_[id * 256 + c] = it->second;
+        }
+    }
+    transitions_.resize(sets.size() * 256);
+    for (unsigned c = 0; c < 256; c++) {
+        starts_[c] = transitions_[start_state * 256 + c] != dead_state;
+    }
+}
+
+SPDLOG_INLINE size_t redactor::match_at(const char *data, size_t size, size_t pos) const {
+    std::uint32_t state = start_state;
+    size_t longest = 0;
+    for (size_t i = pos; i < size; i++) {
+        state = transitions_[state * 256 + static_cast<unsigned char>(data[i])];
+        if (state == dead_state) {
+            break;
+        }
+        if (accepting_[state] != 0) {
+            longest = i + 1 - pos;
+        }
+    }
+    return longest;
+}
+
+SPDLOG_INLINE size_t redactor::redact(char *data, size_t size) const {
+    size_t matches = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        if (!starts_[static_cast<unsigned char>(data[pos])]) {
+            pos++;
+            continue;
+        }
+        auto n = match_at(data, size, pos);
+        if (n == 0) {
+            pos++;
+            continue;
+        }
+        std::fill(data + pos, data + pos + n, mask_);
+        matches++;
+        pos += n;
+    }
+    return matches;
+}
+
+SPDLOG_INLINE bool redactor::pre_format(details::log_msg &msg) {
+    const auto *data = msg.payload.data();
+    auto size = msg.payload.size();
+    for (size_t pos = 0; pos < size; pos++) {
+        if (starts_[static_cast<unsigned char>(data[pos])] && match_at(data, size, pos) > 0) {
+            payload_.clear();
+            payload_.append(data, data + size);
+            redact(payload_.data() + pos, size - pos);
+            msg.payload = string_view_t(payload_.data(), payload_.size());
+            msg.static_payload = false;
+            return true;
+        }
+    }
+    return true;
+}
+
+}  // namespace spdlog
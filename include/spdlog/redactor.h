@@ -0,0 +1,68 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Masks the matches of a set of patterns in the payloads (e.g. card numbers or tokens).
+// The patterns are compiled into a single DFA, run at each position where a match may start:
+// the longest match there is replaced in place by as many mask chars, and the scan goes on
+// after it. It's a pre_format stage of a staged sink (see sinks/staged_sink.h), which copies
+// the payload only if something is masked.
+//
+// The patterns are a subset of the regex syntax, without groups nor alternatives (give
+// several patterns instead):
+//   c            the char c (\c for the special chars: \ . [ ] { } * + ?)
+//   .            any char
+//   \d \w \s     a digit, a word char ([A-Za-z0-9_]), a space char
+//   [a-z_] [^0]  one of (or none of) the chars and ranges
+//   x* x+ x?     x repeated zero or more, one or more, zero or one times
+//   x{n} x{n,m} x{n,}
+//
+// Usage example:
+// auto redactor = spdlog::redactor({"\\d{4}[ -]?\\d{4}[ -]?\\d{4}[ -]?\\d{1,7}", "tok_\\w{16,}"});
+// auto sink = spdlog::sinks::make_staged_sink<std::mutex>(file_sink, std::move(redactor));
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace spdlog {
+
+class SPDLOG_API redactor {
+public:
+    // throw spdlog_ex if a pattern is invalid, or the DFA too large
+    explicit redactor(const std::vector<std::string> &patterns, char mask = '*');
+
+    // mask the matches in place. return the number of matches.
+    size_t redact(char *data, size_t size) const;
+    size_t redact(memory_buf_t &buf) const { return redact(buf.data(), buf.size()); }
+
+    // the length of the longest match at data[pos], 0 if none
+    size_t match_at(const char *data, size_t size, size_t pos) const;
+
+    // staged sink stage: points the payload to a masked copy if there is a match
+    bool pre_format(details::log_msg &msg);
+    unsigned needed_fields() const { return msg_field::none; }
+
+    size_t dfa_states() const { return accepting_.size(); }
+
+private:
+    enum : std::uint32_t { dead_state = 0, start_state = 1 };
+
+    char mask_;
+    // transitions_[state * 256 + byte]
+    std::vector<std::uint32_t> transitions_;
+    std::vector<std::uint8_t> accepting_;
+    // the bytes a match may start with
+    bool starts_[256] = {};
+    memory_buf_t payload_;
+};
+
+}  // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+    #include "redactor-inl.h"
+#endif
@@ -0,0 +1,144 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Formatter writing each message as an RFC 5424 syslog frame:
+// <PRI>1 2024-05-12T10:01:02.123456Z HOSTNAME APP-NAME PROCID MSGID - MSG
+//
+// MSG is the payload, or the output of msg_formatter if given (give it an empty eol, as the
+// unix_syslog_sink does for set_pattern()). The header fields left empty are written as "-".
+//
+// Used by the unix_syslog_sink, and with the udp sinks (one frame per datagram, so without
+// max_datagram_size) or the tcp sinks (with octet_counting) for remote syslog servers:
+// spdlog::rfc5424_options options;
+// options.app_name = "myapp";
+// options.octet_counting = true;
+// auto msg_formatter = spdlog::details::make_unique<spdlog::pattern_formatter>(
+//     "[%n] %v", spdlog::pattern_time_type::local, "");
+// tcp_sink->set_formatter(spdlog::details::make_unique<spdlog::rfc5424_formatter>(
+//     options, std::move(msg_formatter)));
+
+#include <spdlog/common.h>
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include <spdlog/formatter.h>
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <string>
+
+namespace spdlog {
+
+struct rfc5424_options {
+    int facility = 1;  // 0 to 23: 1 is user, 16 to 23 are local0 to local7
+    std::string hostname;
+    std::string app_name;
+    std::string msgid;
+    // prefix each frame with its length and a space (RFC 6587), as needed over tcp
+    bool octet_counting = false;
+};
+
+class rfc5424_formatter final : public formatter {
+public:
+    explicit rfc5424_formatter(rfc5424_options options = {},
+                               std::unique_ptr<formatter> msg_formatter = nullptr)
+        : options_(std::move(options)),
+          msg_formatter_(std::move(msg_formatter)) {
+        if (options_.facility < 0 || options_.facility > 23) {
+            throw_spdlog_ex("rfc5424_formatter: invalid facility " +
+                            std::to_string(options_.facility));
+        }
+        // the fields after the timestamp, the same for all the messages
+        fields_ += ' ';
+        append_field_(options_.hostname, 255);
+        fields_ += ' ';
+        append_field_(options_.app_name, 48);
+        fields_ += ' ';
+        fields_ += std::to_string(details::os::pid());
+        fields_ += ' ';
+        append_field_(options_.msgid, 32);
+        fields_ += " - ";  // no structured data
+    }
+
+    std::unique_ptr<formatter> clone() const override {
+        return details::make_unique<rfc5424_formatter>(
+            options_, msg_formatter_ ? msg_formatter_->clone() : nullptr);
+    }
+
+    void format(const details::log_msg &msg, memory_buf_t &dest) override {
+        if (!options_.octet_counting) {
+            format_frame_(msg, dest);
+            return;
+        }
+        frame_.clear();
+        format_frame_(msg, frame_);
+        details::fmt_helper::append_int(frame_.size(), dest);
+        dest.push_back(' ');
+        details::fmt_helper::append_string_view(string_view_t(frame_.data(), frame_.size()),
+                                                dest);
+    }
+
+    unsigned needed_fields() const override {
+        return msg_field::time | (msg_formatter_ ? msg_formatter_->needed_fields() : 0);
+    }
+
+    // the severities of the spdlog levels: trace and debug are debug (7), off is info (6)
+    static int severity(level::level_enum lvl) {
+        static const int severities[] = {7, 7, 6, 4, 3, 2, 6};
+        return severities[static_cast<size_t>(lvl)];
+    }
+
+private:
+    rfc5424_options options_;
+    std::unique_ptr<formatter> msg_formatter_;
+    std::string fields_;
+    memory_buf_t frame_;         // when octet counting
+    std::time_t cached_secs_ = -1;
+    char cached_time_[20] = {};  // "YYYY-MM-DDThh:mm:ss" of cached_secs_
+
+    // the printable ascii chars of value (other than space), "-" if none
+    void append_field_(const std::string &value, size_t max_size) {
+        auto start = fields_.size();
+        for (auto c : value) {
+            if (c > ' ' && c < 127 && fields_.size() - start < max_size) {
+                fields_ += c;
+            }
+        }
+        if (fields_.size() == start) {
+            fields_ += '-';
+        }
+    }
+
+    void format_frame_(const details::log_msg &msg, memory_buf_t &dest) {
+        using details::fmt_helper::append_string_view;
+
+        dest.push_back('<');
+        details::fmt_helper::append_int(options_.facility * 8 + severity(msg.level), dest);
+        append_string_view(">1 ", dest);
+
+        auto secs = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
+        auto tt = static_cast<std::time_t>(secs.count());
+        if (tt != cached_secs_) {
+            auto tm = details::os::fast_gmtime(tt);
+            std::strftime(cached_time_, sizeof(cached_time_), "%Y-%m-%dT%H:%M:%S", &tm);
+            cached_secs_ = tt;
+        }
+        append_string_view(string_view_t(cached_time_, 19), dest);
+        dest.push_back('.');
+        auto micros = details::fmt_helper::time_fraction<std::chrono::microseconds>(msg.time);
+        details::fmt_helper::pad6(static_cast<size_t>(micros.count()), dest);
+        dest.push_back('Z');
+        append_string_view(fields_, dest);
+
+        if (msg_formatter_) {
+            msg_formatter_->format(msg, dest);
+        } else {
+            append_string_view(msg.payload, dest);
+        }
+    }
+};
+
+}  // namespace spdlog
@@ -0,0 +1,277 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef _WIN32
+    #error shm_ring is not supported on windows
+#endif
+
+// Single producer, single consumer ring of records in POSIX shared memory, written by the
+// shm_ring_sink and read by another process (e.g. a log shipper) with the shm_ring_reader,
+// without any system call or copy through the kernel. The writer never blocks: a record not
+// fitting in the free space is dropped (and counted).
+//
+// Layout of the shared memory object (little or big endian as the machine, which the two
+// processes share):
+//   offset 0    uint32   magic, "SPLR" (0x524c5053 read as a little endian uint32)
+//   offset 4    uint32   version (1)
+//   offset 8    uint64   capacity: size of the data area, a power of 2
+//   offset 64   uint64   write position: bytes written since the ring was created (atomic)
+//   offset 128  uint64   read position: bytes consumed by the reader (atomic)
+//   offset 192  uint64   number of records dropped because the ring was full (atomic)
+//   offset 256  data area, of capacity bytes
+//
+// The positions only grow, the offset in the data area being position % capacity. Records are
+// 8 bytes aligned:
+//   uint32   size of the data (0xffffffff: padding, the rest of the data area is skipped)
+//   uint32   reserved (0)
+//   data, followed by zeros up to the next multiple of 8
+// A record never wraps around the end of the data area: it starts at offset 0 after a padding.
+//
+// The writer publishes records with a release store of the write position, after writing them,
+// and the reader frees them with a release store of the read position, after reading them.
+//
+// Usage example (reader side):
+// spdlog::shm_ring_reader reader("/myapp_logs");
+// reader.poll([](spdlog::string_view_t record) { ship(record); });
+
+#include <spdlog/common.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace spdlog {
+
+namespace details {
+struct shm_ring_header {
+    static constexpr std::uint32_t magic_value = 0x524c5053;  // "SPLR"
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t padding_size = 0xffffffff;
+    static constexpr size_t data_offset = 256;
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t capacity;
+    alignas(64) std::atomic<std::uint64_t> write_pos;
+    alignas(64) std::atomic<std::uint64_t> read_pos;
+    alignas(64) std::atomic<std::uint64_t> dropped;
+};
+
+static_assert(sizeof(shm_ring_header) <= shm_ring_header::data_offset,
+              "shm_ring_header doesn't fit before the data");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shm_ring needs lock free 64 bits atomics");
+
+// the shared memory object mapped
+class shm_ring_mapping {
+public:
+    // open (create = false) or create the shared memory object name. when creating, an existing
+    // ring with the same capacity is kept, with the records it holds.
+    shm_ring_mapping(const std::string &name, bool create, size_t capacity = 0) {
+        int fd = ::shm_open(name.c_str(), O_RDWR | (create ? O_CREAT : 0), 0600);
+        if (fd < 0) {
+            throw_spdlog_ex("shm_ring: failed opening " + name, errno);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            fail_(fd, "shm_ring: failed reading the size of " + name);
+        }
+        auto current_size = static_cast<size_t>(st.st_size);
+        if (create) {
+            size_ = shm_ring_header::data_offset + capacity;
+            if (current_size != size_ && ::ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+                fail_(fd, "shm_ring: failed sizing " + name);
+            }
+        } else {
+            size_ = current_size;
+            if (size_ < shm_ring_header::data_offset) {
+                ::close(fd);
+                throw_spdlog_ex("shm_ring: " + name + " is not initialized");
+            }
+        }
+        auto *ptr = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            fail_(fd, "shm_ring: failed mapping " + name);
+        }
+        ::close(fd);
+        base_ = static_cast<char *>(ptr);
+
+        auto &hdr = header();
+        if (create && (hdr.magic != shm_ring_header::magic_value ||
+                       hdr.version != shm_ring_header::current_version ||
+                       hdr.capacity != capacity ||
+                       hdr.write_pos.load(std::memory_order_relaxed) <
+                           hdr.read_pos.load(std::memory_order_relaxed))) {
+            hdr.magic = 0;
+            hdr.version = shm_ring_header::current_version;
+            hdr.capacity = capacity;
+            hdr.write_pos.store(0, std::memory_order_relaxed);
+            hdr.read_pos.store(0, std::memory_order_relaxed);
+            hdr.dropped.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            hdr.magic = shm_ring_header::magic_value;
+        }
+        if (hdr.magic != shm_ring_header::magic_value ||
+            hdr.version != shm_ring_header::current_version ||
+            hdr.capacity + shm_ring_header::data_offset > size_) {
+            unmap_();
+            throw_spdlog_ex("shm_ring: " + name + " is not a ring of version " +
+                            std::to_string(shm_ring_header::current_version));
+        }
+        capacity_ = static_cast<size_t>(hdr.capacity);
+    }
+
+    ~shm_ring_mapping() { unmap_(); }
+
+    shm_ring_mapping(const shm_ring_mapping &) = delete;
+    shm_ring_mapping &operator=(const shm_ring_mapping &) = delete;
+
+    shm_ring_header &header() { return *reinterpret_cast<shm_ring_header *>(base_); }
+    char *data() { return base_ + shm_ring_header::data_offset; }
+    size_t capacity() const { return capacity_; }
+
+    static size_t aligned_size(size_t data_size) { return 8 + (data_size + 7) / 8 * 8; }
+
+private:
+    char *base_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+
+    [[noreturn]] static void fail_(int fd, const std::string &msg) {
+        auto err = errno;
+        ::close(fd);
+        throw_spdlog_ex(msg, err);
+    }
+
+    void unmap_() {
+        if (base_ != nullptr) {
+            ::munmap(base_, size_);
+            base_ = nullptr;
+        }
+    }
+};
+}  // namespace details
+
+// the writing side, used by the shm_ring_sink. not thread safe.
+class shm_ring_writer {
+public:
+    // capacity is rounded up to a power of 2, at least 4096
+    shm_ring_writer(const std::string &name, size_t capacity)
+        : mapping_(name, true, round_capacity_(capacity)),
+          write_pos_(mapping_.header().write_pos.load(std::memory_order_relaxed)),
+          published_pos_(write_pos_) {}
+
+    // copy a record in the ring, visible to the reader once published. false if dropped.
+    bool append(const char *data, size_t size) {
+        auto &hdr = mapping_.header();
+        auto capacity = mapping_.capacity();
+        auto record_size = details::shm_ring_mapping::aligned_size(size);
+        auto offset = static_cast<size_t>(write_pos_ % capacity);
+        auto padding = record_size <= capacity - offset ? 0 : capacity - offset;
+        auto used = write_pos_ - hdr.read_pos.load(std::memory_order_acquire);
+        if (size >= details::shm_ring_header::padding_size ||
+            used + padding + record_size > capacity) {
+            hdr.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        auto *ring = mapping_.data();
+        if (padding > 0) {
+            write_u32_(ring + offset, details::shm_ring_header::padding_size);
+            write_pos_ += padding;
+            offset = 0;
+        }
+        write_u32_(ring + offset, static_cast<std::uint32_t>(size));
+        write_u32_(ring + offset + 4, 0);
+        std::memcpy(ring + offset + 8, data, size);
+        std::memset(ring + offset + 8 + size, 0, record_size - 8 - size);
+        write_pos_ += record_size;
+        return true;
+    }
+
+    // make the records appended visible to the reader
+    void publish() {
+        if (write_pos_ != published_pos_) {
+            mapping_.header().write_pos.store(write_pos_, std::memory_order_release);
+            published_pos_ = write_pos_;
+        }
+    }
+
+    size_t dropped() {
+        return static_cast<size_t>(mapping_.header().dropped.load(std::memory_order_relaxed));
+    }
+
+    size_t capacity() const { return mapping_.capacity(); }
+
+private:
+    details::shm_ring_mapping mapping_;
+    std::uint64_t write_pos_;
+    std::uint64_t published_pos_;
+
+    static size_t round_capacity_(size_t capacity) {
+        size_t rounded = 4096;
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        return rounded;
+    }
+
+    static void write_u32_(char *dest, std::uint32_t value) {
+        std::memcpy(dest, &value, sizeof(value));
+    }
+};
+
+// the reading side, for the process shipping the records. not thread safe.
+class shm_ring_reader {
+public:
+    // the ring must have been created by a writer
+    explicit shm_ring_reader(const std::string &name)
+        : mapping_(name, false) {}
+
+    // call f(string_view_t record) for each record published (up to max_records), oldest first,
+    // then free them for the writer. the record's data is only valid during the call.
+    // return the number of records read.
+    template <typename F>
+    size_t poll(F f, size_t max_records = static_cast<size_t>(-1)) {
+        auto &hdr = mapping_.header();
+        auto capacity = mapping_.capacity();
+        auto *ring = mapping_.data();
+        auto write_pos = hdr.write_pos.load(std::memory_order_acquire);
+        auto read_pos = hdr.read_pos.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (read_pos < write_pos && count < max_records) {
+            auto offset = static_cast<size_t>(read_pos % capacity);
+            std::uint32_t size;
+            std::memcpy(&size, ring + offset, sizeof(size));
+            if (size == details::shm_ring_header::padding_size) {
+                read_pos += capacity - offset;
+                continue;
+            }
+            f(string_view_t(ring + offset + 8, size));
+            read_pos += details::shm_ring_mapping::aligned_size(size);
+            count++;
+        }
+        hdr.read_pos.store(read_pos, std::memory_order_release);
+        return count;
+    }
+
+    // number of records the writer dropped because the ring was full
+    size_t dropped() {
+        return static_cast<size_t>(mapping_.header().dropped.load(std::memory_order_relaxed));
+    }
+
+    // remove the shared memory object (the mappings stay valid until closed)
+    static void remove(const std::string &name) { (void)::shm_unlink(name.c_str()); }
+
+private:
+    details::shm_ring_mapping mapping_;
+};
+
+}  // namespace spdlog
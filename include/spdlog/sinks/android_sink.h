@@ -12,11 +12,14 @@
     #include <spdlog/sinks/base_sink.h>
 
     #include <android/log.h>
+    #include <atomic>
     #include <chrono>
+    #include <condition_variable>
     #include <mutex>
     #include <string>
     #include <thread>
     #include <type_traits>
+    #include <vector>
 
     #if !defined(SPDLOG_ANDROID_RETRIES)
         #define SPDLOG_ANDROID_RETRIES 2
@@ -25,6 +28,16 @@
 namespace spdlog {
 namespace sinks {
 
+// With background set, the messages are written by a thread of the sink, so that the logging
+// threads never wait on logd: up to max_pending bytes of messages wait for it, those beyond are
+// dropped (see dropped()). When logd is busy (-EAGAIN) that thread retries up to
+// SPDLOG_ANDROID_RETRIES times, sleeping 5ms then twice as long each time, and drops the message
+// if it is still busy. flush() waits for the messages to be written.
+struct android_sink_options {
+    bool background = false;
+    size_t max_pending = 256 * 1024;
+};
+
 /*
  * Android sink
  * (logging using __android_log_write or __android_log_buf_write depending on the specified
@@ -33,21 +46,60 @@ namespace sinks {
 template <typename Mutex, int BufferID = log_id::LOG_ID_MAIN>
 class android_sink final : public base_sink<Mutex> {
 public:
-    explicit android_sink(std::string tag = "spdlog", bool use_raw_msg = false)
+    explicit android_sink(std::string tag = "spdlog",
+                          bool use_raw_msg = false,
+                          android_sink_options options = {})
         : tag_(std::move(tag)),
-          use_raw_msg_(use_raw_msg) {}
+          use_raw_msg_(use_raw_msg),
+          options_(options) {
+        if (options_.background) {
+            writer_ = std::thread([this] { writer_loop_(); });
+        }
+    }
+
+    // the messages waiting are written first
+    ~android_sink() override {
+        if (writer_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                stop_ = true;
+            }
+            pending_cv_.notify_all();
+            writer_.join();
+        }
+    }
+
+    // number of messages dropped because the background writer was too far behind, or logd
+    // stayed busy
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
 
 protected:
     void sink_it_(const details::log_msg &msg) override {
         const android_LogPriority priority = convert_to_android_(msg.level);
-        memory_buf_t formatted;
+        formatted_.clear();
         if (use_raw_msg_) {
-            details::fmt_helper::append_string_view(msg.payload, formatted);
+            details::fmt_helper::append_string_view(msg.payload, formatted_);
         } else {
-            base_sink<Mutex>::formatter_->format(msg, formatted);
+            base_sink<Mutex>::formatter_->format(msg, formatted_);
         }
-        formatted.push_back('\0');
-        const char *msg_output = formatted.data();
+        formatted_.push_back('\0');
+
+        if (options_.background) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                if (!pending_text_.empty() &&
+                    pending_text_.size() + formatted_.size() > options_.max_pending) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                pending_text_.append(formatted_.data(), formatted_.size());
+                pending_events_.push_back(pending_event{priority, formatted_.size()});
+            }
+            pending_cv_.notify_all();
+            return;
+        }
+
+        const char *msg_output = formatted_.data();
 
         // See system/core/liblog/logger_write.c for explanation of return value
         int ret = android_log(priority, tag_.c_str(), msg_output);
@@ -66,9 +118,61 @@ protected:
         }
     }
 
-    void flush_() override {}
+    // waits for the background writer to write the messages given to it
+    void flush_() override {
+        if (!options_.background) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        pending_cv_.wait(lock, [this] { return pending_events_.empty() && !writing_; });
+    }
 
 private:
+    struct pending_event {
+        android_LogPriority priority;
+        size_t size;  // of the text, null included
+    };
+
+    void writer_loop_() {
+        std::string text;
+        std::vector<pending_event> events;
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        for (;;) {
+            pending_cv_.wait(lock, [this] { return stop_ || !pending_events_.empty(); });
+            if (pending_events_.empty()) {
+                return;  // stopped
+            }
+            text.swap(pending_text_);
+            events.swap(pending_events_);
+            writing_ = true;
+            lock.unlock();
+            size_t offset = 0;
+            for (const auto &event : events) {
+                write_pending_(event.priority, text.data() + offset);
+                offset += event.size;
+            }
+            text.clear();
+            events.clear();
+            lock.lock();
+            writing_ = false;
+            pending_cv_.notify_all();
+        }
+    }
+
+    void write_pending_(android_LogPriority priority, const char *text) {
+        int ret = android_log(priority, tag_.c_str(), text);
+        unsigned int delay_ms = 5;
+        for (int retry_count = 0; ret == -11 /*EAGAIN*/ && retry_count < SPDLOG_ANDROID_RETRIES;
+             retry_count++) {
+            details::os::sleep_for_millis(delay_ms);
+            delay_ms *= 2;
+            ret = android_log(priority, tag_.c_str(), text);
+        }
+        if (ret < 0 && ret != -EPERM) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
     // There might be liblog versions used, that do not support __android_log_buf_write. So we only
     // compile and link against
     // __android_log_buf_write, if user explicitly provides a non-default log buffer. Otherwise,
@@ -106,6 +210,18 @@ private:
 
     std::string tag_;
     bool use_raw_msg_;
+    android_sink_options options_;
+    memory_buf_t formatted_;  // reused from one message to the next (under the sink's lock)
+
+    // the background writer's: the messages (null terminated, back to back) and their priorities
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::string pending_text_;
+    std::vector<pending_event> pending_events_;
+    bool writing_ = false;
+    bool stop_ = false;
+    std::atomic<size_t> dropped_{0};
+    std::thread writer_;
 };
 
 using android_sink_mt = android_sink<std::mutex>;
@@ -10,16 +10,19 @@
 #include <spdlog/details/os.h>
 #include <spdlog/pattern_formatter.h>
 
+#include <cstring>
+
 namespace spdlog {
 namespace sinks {
 
 template <typename ConsoleMutex>
 SPDLOG_INLINE ansicolor_sink<ConsoleMutex>::ansicolor_sink(FILE *target_file, color_mode mode)
     : target_file_(target_file),
-      mutex_(ConsoleMutex::mutex()),
+      mutex_(ConsoleMutex::mutex(target_file)),
       formatter_(details::make_unique<spdlog::pattern_formatter>())
 
 {
+    needed_fields_.store(formatter_->needed_fields(), std::memory_order_relaxed);
     set_color_mode(mode);
     colors_.at(level::trace) = to_string_(white);
     colors_.at(level::debug) = to_string_(cyan);
@@ -47,18 +50,11 @@ SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::log(const details::log_msg &msg
     memory_buf_t formatted;
     formatter_->format(msg, formatted);
     if (should_do_colors_ && msg.color_range_end > msg.color_range_start) {
-        // before color range
-        print_range_(formatted, 0, msg.color_range_start);
-        // in color range
-        print_ccode_(colors_.at(static_cast<size_t>(msg.level)));
-        print_range_(formatted, msg.color_range_start, msg.color_range_end);
-        print_ccode_(reset);
-        // after color range
-        print_range_(formatted, msg.color_range_end, formatted.size());
-    } else  // no color
-    {
-        print_range_(formatted, 0, formatted.size());
+        insert_color_codes_(formatted, msg.color_range_start, msg.color_range_end,
+                            colors_.at(static_cast<size_t>(msg.level)));
     }
+    // a single write, even if the target is unbuffered (e.g. stderr)
+    print_range_(formatted, 0, formatted.size());
     fflush(target_file_);
 }
 
@@ -72,6 +68,7 @@ template <typename ConsoleMutex>
 SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::set_pattern(const std::string &pattern) {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::unique_ptr<spdlog::formatter>(new pattern_formatter(pattern));
+    needed_fields_.store(formatter_->needed_fields(), std::memory_order_relaxed);
 }
 
 template <typename ConsoleMutex>
@@ -79,6 +76,7 @@ SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::set_formatter(
     std::unique_ptr<spdlog::formatter> sink_formatter) {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::move(sink_formatter);
+    needed_fields_.store(formatter_->needed_fields(), std::memory_order_relaxed);
 }
 
 template <typename ConsoleMutex>
@@ -105,8 +103,18 @@ SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::set_color_mode(color_mode mode)
 }
 
 template <typename ConsoleMutex>
-SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::print_ccode_(const string_view_t &color_code) {
-    fwrite(color_code.data(), sizeof(char), color_code.size(), target_file_);
+SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::insert_color_codes_(memory_buf_t &formatted,
+                                                                     size_t start,
+                                                                     size_t end,
+                                                                     const std::string &color) {
+    // shift the color range and what follows it, then fill the gaps with the codes
+    auto size = formatted.size();
+    formatted.resize(size + color.size() + reset.size());
+    char *data = &formatted[0];
+    std::memmove(data + end + color.size() + reset.size(), data + end, size - end);
+    std::memcpy(data + end + color.size(), reset.data(), reset.size());
+    std::memmove(data + start + color.size(), data + start, end - start);
+    std::memcpy(data + start, color.data(), color.size());
 }
 
 template <typename ConsoleMutex>
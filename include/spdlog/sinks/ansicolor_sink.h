@@ -84,8 +84,12 @@ private:
     bool should_do_colors_;
     std::unique_ptr<spdlog::formatter> formatter_;
     std::array<std::string, level::n_levels> colors_;
-    void print_ccode_(const string_view_t &color_code);
     void print_range_(const memory_buf_t &formatted, size_t start, size_t end);
+    // wrap formatted[start, end) with the color codes in place
+    void insert_color_codes_(memory_buf_t &formatted,
+                             size_t start,
+                             size_t end,
+                             const std::string &color);
     static std::string to_string_(const string_view_t &sv);
 };
 
@@ -112,4 +116,12 @@ using ansicolor_stderr_sink_st = ansicolor_stderr_sink<details::console_nullmute
 
 #ifdef SPDLOG_HEADER_ONLY
     #include "ansicolor_sink-inl.h"
+    #ifdef SPDLOG_EXTERN_TEMPLATES  // defined in spdlog/instantiate.h
+extern template class spdlog::sinks::ansicolor_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::ansicolor_sink<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::ansicolor_stdout_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::ansicolor_stdout_sink<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::ansicolor_stderr_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::ansicolor_stderr_sink<spdlog::details::console_nullmutex>;
+    #endif
 #endif
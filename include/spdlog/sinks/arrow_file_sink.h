@@ -0,0 +1,207 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// File sink writing the messages as columns in the Arrow IPC stream format (read by e.g.
+// pyarrow.ipc.open_stream(), polars.read_ipc_stream() or duckdb), so they are loaded into
+// analytics tools without parsing text. The columns are the time, level, logger, thread, source
+// location, message and kv fields (see details/arrow_ipc.h). The formatter isn't used.
+//
+// The messages are held until batch_rows of them make a record batch, whose columns are written
+// at once, or until flush(). The file is rotated like the rotating_file_sink once a batch takes
+// it past max_size:
+// log.arrows -> log.1.arrows
+// log.1.arrows -> log.2.arrows
+// ..
+// Each file is a stream of its own, starting with the schema and ending with the end of stream
+// marker when rotated or when the sink is destroyed. A file left by a process which died ends
+// after its last complete batch. An existing file is rotated when the sink is created, since a
+// stream can't be continued.
+//
+// Usage example:
+// auto logger = spdlog::arrow_logger_mt("arrow_logger", "logs/log.arrows", 256 * 1024 * 1024, 10);
+
+#include <spdlog/common.h>
+#include <spdlog/details/arrow_ipc.h>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+
+#include <cerrno>
+#include <mutex>
+#include <string>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class arrow_file_sink final : public base_sink<Mutex> {
+public:
+    arrow_file_sink(filename_t base_filename,
+                    size_t max_size,
+                    size_t max_files,
+                    size_t batch_rows = 4096,
+                    const file_event_handlers &event_handlers = {})
+        : base_filename_(std::move(base_filename)),
+          max_size_(max_size),
+          max_files_(max_files),
+          batch_rows_(batch_rows == 0 ? 1 : batch_rows),
+          file_helper_{event_handlers} {
+        if (max_size == 0) {
+            throw_spdlog_ex("arrow_file_sink: max_size cannot be zero");
+        }
+        if (max_files > 200000) {
+            throw_spdlog_ex("arrow_file_sink: max_files cannot exceed 200000");
+        }
+        file_helper_.open(base_filename_);
+        if (file_helper_.size() > 0) {
+            rotate_();
+        } else {
+            start_stream_();
+        }
+        base_sink<Mutex>::set_own_fields_(
+            msg_field::time | msg_field::thread_id | msg_field::source, false);
+    }
+
+    arrow_file_sink(const arrow_file_sink &) = delete;
+    arrow_file_sink &operator=(const arrow_file_sink &) = delete;
+
+    // write the messages held and end the stream
+    ~arrow_file_sink() override {
+        SPDLOG_TRY {
+            std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+            write_batch_();
+            end_stream_();
+        }
+        SPDLOG_CATCH_STD
+    }
+
+    filename_t filename() {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        return file_helper_.filename();
+    }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        batch_.add(msg);
+        if (batch_.rows() >= batch_rows_ || batch_.text_size() >= max_batch_text_size) {
+            write_batch_();
+        }
+    }
+
+    void flush_() override {
+        write_batch_();
+        file_helper_.flush();
+    }
+
+private:
+    // well within the 32 bits offsets of the text columns
+    static constexpr size_t max_batch_text_size = 256 * 1024 * 1024;
+
+    filename_t base_filename_;
+    size_t max_size_;
+    size_t max_files_;
+    size_t batch_rows_;
+    details::file_helper file_helper_;
+    details::arrow::record_batch_builder batch_;
+    memory_buf_t buffer_;
+    size_t current_size_ = 0;
+    bool stream_started_ = false;
+
+    void start_stream_() {
+        buffer_.clear();
+        batch_.append_schema(buffer_);
+        file_helper_.write(buffer_);
+        current_size_ = buffer_.size();
+        stream_started_ = true;
+    }
+
+    void end_stream_() {
+        if (!stream_started_) {
+            return;
+        }
+        buffer_.clear();
+        details::arrow::record_batch_builder::append_end(buffer_);
+        file_helper_.write(buffer_);
+        stream_started_ = false;
+    }
+
+    void write_batch_() {
+        if (batch_.rows() == 0) {
+            return;
+        }
+        buffer_.clear();
+        batch_.append_batch(buffer_);
+        file_helper_.write(buffer_);
+        current_size_ += buffer_.size();
+        if (current_size_ >= max_size_) {
+            rotate_();
+        }
+    }
+
+    void rotate_() {
+        using details::os::filename_to_str;
+        using rotating = rotating_file_sink<details::null_mutex>;
+
+        end_stream_();
+        file_helper_.close();
+        for (auto i = max_files_; i > 0; --i) {
+            filename_t src = rotating::calc_filename(base_filename_, i - 1);
+            if (!details::os::path_exists(src)) {
+                continue;
+            }
+            filename_t target = rotating::calc_filename(base_filename_, i);
+            (void)details::os::remove(target);
+            if (details::os::rename(src, target) != 0) {
+                auto err = errno;
+                // truncate the file anyway so it doesn't grow past its limit
+                file_helper_.reopen(true);
+                start_stream_();
+                throw_spdlog_ex("arrow_file_sink: failed renaming " + filename_to_str(src) +
+                                    " to " + filename_to_str(target),
+                                err);
+            }
+        }
+        file_helper_.reopen(true);
+        start_stream_();
+    }
+};
+
+using arrow_file_sink_mt = arrow_file_sink<std::mutex>;
+using arrow_file_sink_st = arrow_file_sink<details::null_mutex>;
+
+template <typename Mutex>
+struct shares_file<arrow_file_sink<Mutex>> : std::true_type {};
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> arrow_logger_mt(const std::string &logger_name,
+                                               const filename_t &filename,
+                                               size_t max_file_size,
+                                               size_t max_files,
+                                               size_t batch_rows = 4096) {
+    return Factory::template create<sinks::arrow_file_sink_mt>(logger_name, filename,
+                                                               max_file_size, max_files,
+                                                               batch_rows);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> arrow_logger_st(const std::string &logger_name,
+                                               const filename_t &filename,
+                                               size_t max_file_size,
+                                               size_t max_files,
+                                               size_t batch_rows = 4096) {
+    return Factory::template create<sinks::arrow_file_sink_st>(logger_name, filename,
+                                                               max_file_size, max_files,
+                                                               batch_rows);
+}
+
+}  // namespace spdlog
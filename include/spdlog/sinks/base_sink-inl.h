@@ -10,6 +10,7 @@
 #include <spdlog/common.h>
 #include <spdlog/pattern_formatter.h>
 
+#include <exception>
 #include <memory>
 #include <mutex>
 
@@ -24,27 +25,87 @@ SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::base_sink(
 
 template <typename Mutex>
 void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::log(const details::log_msg &msg) {
+    if (exclusive_call_()) {
+        sink_it_(msg);
+        return;
+    }
     std::lock_guard<Mutex> lock(mutex_);
     sink_it_(msg);
 }
 
+template <typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::log_batch(const details::log_msg *msgs,
+                                                              size_t count) {
+    if (exclusive_call_()) {
+        sink_batch_(msgs, count);
+        return;
+    }
+    std::lock_guard<Mutex> lock(mutex_);
+    sink_batch_(msgs, count);
+}
+
+template <typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::sink_batch_(const details::log_msg *msgs,
+                                                                size_t count) {
+#ifdef SPDLOG_NO_EXCEPTIONS
+    for (size_t i = 0; i < count; i++) {
+        if (should_log(msgs[i])) {
+            sink_it_(msgs[i]);
+        }
+    }
+#else
+    std::exception_ptr first_error;
+    for (size_t i = 0; i < count; i++) {
+        if (!should_log(msgs[i])) {
+            continue;
+        }
+        try {
+            sink_it_(msgs[i]);
+        } catch (...) {
+            if (!first_error) {
+                first_error = std::current_exception();
+            }
+        }
+    }
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+#endif
+}
+
 template <typename Mutex>
 void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::flush() {
+    if (exclusive_call_()) {
+        flush_();
+        return;
+    }
     std::lock_guard<Mutex> lock(mutex_);
     flush_();
 }
 
 template <typename Mutex>
 void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::set_pattern(const std::string &pattern) {
+    if (exclusive_call_()) {
+        set_pattern_(pattern);
+        update_needed_fields_();
+        return;
+    }
     std::lock_guard<Mutex> lock(mutex_);
     set_pattern_(pattern);
+    update_needed_fields_();
 }
 
 template <typename Mutex>
 void SPDLOG_INLINE
 spdlog::sinks::base_sink<Mutex>::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) {
+    if (exclusive_call_()) {
+        set_formatter_(std::move(sink_formatter));
+        update_needed_fields_();
+        return;
+    }
     std::lock_guard<Mutex> lock(mutex_);
     set_formatter_(std::move(sink_formatter));
+    update_needed_fields_();
 }
 
 template <typename Mutex>
@@ -57,3 +118,48 @@ void SPDLOG_INLINE
 spdlog::sinks::base_sink<Mutex>::set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) {
     formatter_ = std::move(sink_formatter);
 }
+
+template <typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::set_own_fields_(unsigned fields,
+                                                                   bool uses_formatter) {
+    std::lock_guard<Mutex> lock(mutex_);
+    own_fields_ = fields;
+    uses_formatter_ = uses_formatter;
+    update_needed_fields_();
+}
+
+template <typename Mutex>
+bool SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::claim_exclusive(std::thread::id owner) {
+    std::lock_guard<Mutex> lock(mutex_);
+    owner_ = owner;
+    exclusive_.store(true, std::memory_order_release);
+    return true;
+}
+
+template <typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::release_exclusive() {
+    std::lock_guard<Mutex> lock(mutex_);
+    exclusive_.store(false, std::memory_order_release);
+}
+
+template <typename Mutex>
+bool SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::exclusive_call_() const {
+    if (!exclusive_.load(std::memory_order_acquire)) {
+        return false;
+    }
+#ifndef NDEBUG
+    if (std::this_thread::get_id() != owner_) {
+        throw_spdlog_ex("base_sink: used from another thread than the one owning it");
+    }
+#endif
+    return true;
+}
+
+template <typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::update_needed_fields_() {
+    auto fields = own_fields_;
+    if (uses_formatter_) {
+        fields |= formatter_ ? formatter_->needed_fields() : msg_field::all;
+    }
+    needed_fields_.store(fields, std::memory_order_relaxed);
+}
@@ -13,6 +13,11 @@
 #include <spdlog/details/log_msg.h>
 #include <spdlog/sinks/sink.h>
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 namespace spdlog {
 namespace sinks {
 template <typename Mutex>
@@ -29,9 +34,16 @@ public:
     base_sink &operator=(base_sink &&) = delete;
 
     void log(const details::log_msg &msg) final override;
+    // lock once for the whole batch. if some messages fail, the others are still
+    // logged and the first error is rethrown at the end.
+    void log_batch(const details::log_msg *msgs, size_t count) final override;
     void flush() final override;
     void set_pattern(const std::string &pattern) final override;
     void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) final override;
+    // while claimed, log(), log_batch(), flush(), set_pattern() and set_formatter() don't lock
+    // mutex_. in debug builds (without NDEBUG) they throw if called from another thread.
+    bool claim_exclusive(std::thread::id owner) override;
+    void release_exclusive() override;
 
 protected:
     // sink formatter
@@ -39,13 +51,79 @@ protected:
     Mutex mutex_;
 
     virtual void sink_it_(const details::log_msg &msg) = 0;
+    // log the messages of a batch passing should_log(): sink_it_() for each by default.
+    virtual void sink_batch_(const details::log_msg *msgs, size_t count);
     virtual void flush_() = 0;
     virtual void set_pattern_(const std::string &pattern);
     virtual void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter);
+
+    // the msg_field bits of the fields sink_it_() reads itself, besides those formatter_
+    // reads (if uses_formatter). all by default: sinks only writing the formatted message
+    // set msg_field::none, so the loggers fill only the fields of their pattern.
+    void set_own_fields_(unsigned fields, bool uses_formatter = true);
+
+    // for sink_batch_() overrides writing the whole batch at once: format the messages passing
+    // should_log() back to back into dest, calling formatted(start) after each one (its text
+    // being dest[start, dest.size())) and written() at the end. a message failing is dropped,
+    // the others are still formatted and the first error is rethrown after written().
+    template <typename Formatted, typename Written>
+    void format_batch_(const details::log_msg *msgs,
+                       size_t count,
+                       memory_buf_t &dest,
+                       Formatted formatted,
+                       Written written) {
+#ifdef SPDLOG_NO_EXCEPTIONS
+        for (size_t i = 0; i < count; i++) {
+            if (should_log(msgs[i])) {
+                auto start = dest.size();
+                formatter_->format(msgs[i], dest);
+                formatted(start);
+            }
+        }
+        written();
+#else
+        std::exception_ptr first_error;
+        for (size_t i = 0; i < count; i++) {
+            if (!should_log(msgs[i])) {
+                continue;
+            }
+            auto start = dest.size();
+            try {
+                formatter_->format(msgs[i], dest);
+                formatted(start);
+            } catch (...) {
+                if (dest.size() > start) {
+                    dest.resize(start);
+                }
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+            }
+        }
+        written();
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+#endif
+    }
+
+private:
+    unsigned own_fields_ = msg_field::all;
+    bool uses_formatter_ = true;
+    std::atomic<bool> exclusive_{false};
+    std::thread::id owner_;
+
+    void update_needed_fields_();
+    // true if claimed: the caller doesn't lock
+    bool exclusive_call_() const;
 };
 }  // namespace sinks
 }  // namespace spdlog
 
 #ifdef SPDLOG_HEADER_ONLY
     #include "base_sink-inl.h"
+    #ifdef SPDLOG_EXTERN_TEMPLATES  // defined in spdlog/instantiate.h
+extern template class spdlog::sinks::base_sink<std::mutex>;
+extern template class spdlog::sinks::base_sink<spdlog::details::null_mutex>;
+    #endif
 #endif
@@ -19,6 +19,7 @@ SPDLOG_INLINE basic_file_sink<Mutex>::basic_file_sink(const filename_t &filename
                                                       const file_event_handlers &event_handlers)
     : file_helper_{event_handlers} {
     file_helper_.open(filename, truncate);
+    base_sink<Mutex>::set_own_fields_(file_helper_.indexed() ? msg_field::time : msg_field::none);
 }
 
 template <typename Mutex>
@@ -30,9 +31,22 @@ template <typename Mutex>
 SPDLOG_INLINE void basic_file_sink<Mutex>::sink_it_(const details::log_msg &msg) {
     memory_buf_t formatted;
     base_sink<Mutex>::formatter_->format(msg, formatted);
+    file_helper_.note_time(msg.time);
     file_helper_.write(formatted);
 }
 
+// the whole batch is formatted into one buffer and written at once
+template <typename Mutex>
+SPDLOG_INLINE void basic_file_sink<Mutex>::sink_batch_(const details::log_msg *msgs,
+                                                       size_t count) {
+    if (count > 0) {
+        file_helper_.note_time(msgs[0].time);
+    }
+    memory_buf_t formatted;
+    base_sink<Mutex>::format_batch_(
+        msgs, count, formatted, [](size_t) {}, [&] { file_helper_.write(formatted); });
+}
+
 template <typename Mutex>
 SPDLOG_INLINE void basic_file_sink<Mutex>::flush_() {
     file_helper_.flush();
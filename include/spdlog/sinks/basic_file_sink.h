@@ -26,6 +26,7 @@ public:
 
 protected:
     void sink_it_(const details::log_msg &msg) override;
+    void sink_batch_(const details::log_msg *msgs, size_t count) override;
     void flush_() override;
 
 private:
@@ -35,6 +36,9 @@ private:
 using basic_file_sink_mt = basic_file_sink<std::mutex>;
 using basic_file_sink_st = basic_file_sink<details::null_mutex>;
 
+template <typename Mutex>
+struct shares_file<basic_file_sink<Mutex>> : std::true_type {};
+
 }  // namespace sinks
 
 //
@@ -62,4 +66,8 @@ inline std::shared_ptr<logger> basic_logger_st(const std::string &logger_name,
 
 #ifdef SPDLOG_HEADER_ONLY
     #include "basic_file_sink-inl.h"
+    #ifdef SPDLOG_EXTERN_TEMPLATES  // defined in spdlog/instantiate.h
+extern template class spdlog::sinks::basic_file_sink<std::mutex>;
+extern template class spdlog::sinks::basic_file_sink<spdlog::details::null_mutex>;
+    #endif
 #endif
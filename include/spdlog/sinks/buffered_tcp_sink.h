@@ -0,0 +1,463 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Tcp client sink which never blocks the logging threads on the network: the formatted records
+// are appended to a bounded buffer, and a background thread connects, sends everything buffered
+// in one go, and reconnects with exponential backoff when the connection drops.
+//
+// When the buffer is full (the server being slow or down), the records are dropped (see
+// dropped()), or appended to the spill file if there is one. The spill file is sent after the
+// records buffered before it, and is left on disk, to be sent by the next sink using it, if it
+// couldn't be sent before the sink was destroyed. Records are sent at least once: the ones in
+// flight when the connection drops are sent again.
+//
+// Usage example:
+// spdlog::sinks::buffered_tcp_sink_config cfg("localhost", 5170);
+// cfg.spill_filename = "logs/tcp_spill.txt";
+// auto sink = std::make_shared<spdlog::sinks::buffered_tcp_sink_mt>(cfg);
+//
+// With TLS (cfg.tls.enabled, needs SPDLOG_OPENSSL), the handshakes and the encryption happen on the
+// background thread too. The buffered records are sent in records as large as TLS allows, and the
+// session is resumed when reconnecting.
+//
+// With compression (cfg.compression_level, needs SPDLOG_ZLIB), the records are compressed on the
+// background thread in a zlib stream of its own for each connection, flushed at the end of each
+// send so that the receiver gets every record sent. A preset dictionary trained on typical
+// records (see train_compression_dictionary()) helps the first records of each connection, and
+// must be given to the receiver too (e.g. tools/log_receiver -z -d dictionary_file).
+
+#include <spdlog/common.h>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/details/tls_config.h>
+#include <spdlog/sinks/base_sink.h>
+#ifdef SPDLOG_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef SPDLOG_OPENSSL
+    #include <spdlog/details/tls_client.h>
+#endif
+#ifdef _WIN32
+    #include <spdlog/details/tcp_client-windows.h>
+#else
+    #include <spdlog/details/tcp_client.h>
+    #include <sys/time.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+struct buffered_tcp_sink_config {
+    std::string server_host;
+    int server_port;
+    size_t max_buffer_size = 1024 * 1024;  // of the records waiting to be sent
+    std::chrono::milliseconds reconnect_min_delay{100};
+    std::chrono::milliseconds reconnect_max_delay{30000};
+    std::chrono::milliseconds send_timeout{5000};  // a send taking longer drops the connection
+    filename_t spill_filename;  // records not fitting in the buffer go there instead of dropped
+    details::tls_config tls;
+    // zlib compression level of the stream (needs SPDLOG_ZLIB), from 1 (fastest) to 9 (smallest),
+    // 0 for no compression
+    int compression_level = 0;
+    std::string compression_dictionary;  // preset dictionary of the compression, if not empty
+
+    buffered_tcp_sink_config(std::string host, int port)
+        : server_host{std::move(host)},
+          server_port{port} {}
+};
+
+template <typename Mutex>
+class buffered_tcp_sink final : public base_sink<Mutex> {
+public:
+    explicit buffered_tcp_sink(buffered_tcp_sink_config sink_config)
+        : config_{std::move(sink_config)} {
+#ifdef SPDLOG_OPENSSL
+        client_.set_config(config_.tls);
+        client_.set_timeout(config_.send_timeout);
+#else
+        if (config_.tls.enabled) {
+            throw_spdlog_ex("buffered_tcp_sink: TLS needs OpenSSL (define SPDLOG_OPENSSL)");
+        }
+#endif
+        if (config_.compression_level != 0) {
+#ifdef SPDLOG_ZLIB
+            if (deflateInit(&zstream_, config_.compression_level) != Z_OK) {
+                throw_spdlog_ex("buffered_tcp_sink: invalid compression level " +
+                                std::to_string(config_.compression_level));
+            }
+            compressing_ = true;
+#else
+            throw_spdlog_ex(
+                "buffered_tcp_sink: compression needs zlib (define SPDLOG_ZLIB and link with it)");
+#endif
+        }
+        if (!config_.spill_filename.empty()) {
+            // left by a previous sink
+            sending_file_ = config_.spill_filename + SPDLOG_FILENAME_T(".sending");
+            if (!details::os::path_exists(sending_file_)) {
+                sending_file_.clear();
+            }
+            spill_.open(config_.spill_filename);
+            spill_open_ = true;
+            spill_size_ = spill_.size();
+        }
+        base_sink<Mutex>::set_own_fields_(msg_field::none);
+        worker_ = std::thread([this] { worker_loop_(); });
+    }
+
+    buffered_tcp_sink(const buffered_tcp_sink &) = delete;
+    buffered_tcp_sink &operator=(const buffered_tcp_sink &) = delete;
+
+    // try to send what is left (unless the last attempt failed), and spill the rest if there is
+    // a spill file
+    ~buffered_tcp_sink() override {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        worker_.join();
+#ifdef SPDLOG_ZLIB
+        if (compressing_) {
+            (void)deflateEnd(&zstream_);
+        }
+#endif
+    }
+
+    // number of records dropped because the buffer was full
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    bool connected() const { return connected_.load(std::memory_order_relaxed); }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        memory_buf_t formatted;
+        base_sink<Mutex>::formatter_->format(msg, formatted);
+        enqueue_(formatted.data(), formatted.size());
+    }
+
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        memory_buf_t formatted;
+        base_sink<Mutex>::format_batch_(msgs, count, formatted, [](size_t) {},
+                                        [&] { enqueue_(formatted.data(), formatted.size()); });
+    }
+
+    // the records are sent as soon as possible anyway
+    void flush_() override { cv_.notify_one(); }
+
+private:
+    buffered_tcp_sink_config config_;
+#ifdef SPDLOG_OPENSSL
+    details::tls_client client_;  // used by the worker only
+#else
+    details::tcp_client client_;  // used by the worker only
+#endif
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    std::string pending_;       // records waiting to be sent
+    details::file_helper spill_;  // records not fitting in pending_, sent after them
+    bool spill_open_ = false;
+    size_t spill_size_ = 0;
+    bool stop_ = false;
+    std::atomic<size_t> dropped_{0};
+    std::atomic<bool> connected_{false};
+
+    // owned by the worker: taken from pending_ and the spill file, sent in this order
+    std::string sending_;
+    filename_t sending_file_;
+    long sending_offset_ = 0;
+    bool failed_ = false;  // the last attempt to send failed
+#ifdef SPDLOG_ZLIB
+    z_stream zstream_{};
+    bool compressing_ = false;
+    std::string compressed_;
+#endif
+    std::thread worker_;
+
+    void enqueue_(const char *data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            // once spilling, everything goes to the spill file until it's taken, for the order
+            if (spill_size_ == 0 && pending_.size() + size <= config_.max_buffer_size) {
+                pending_.append(data, size);
+            } else if (!spill_open_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                spill_.write(data, size);
+                spill_size_ += size;
+            }
+        }
+        cv_.notify_one();
+    }
+
+    bool has_work_() const {
+        return !pending_.empty() || spill_size_ > 0 || !sending_.empty() || !sending_file_.empty();
+    }
+
+    // move the records waiting to the worker's side, once it sent the previous ones
+    void take_() {
+        if (!sending_.empty() || !sending_file_.empty()) {
+            return;
+        }
+        sending_.swap(pending_);
+        if (spill_size_ == 0) {
+            return;
+        }
+        SPDLOG_TRY {
+            spill_open_ = false;
+            spill_.close();
+            sending_file_ = config_.spill_filename + SPDLOG_FILENAME_T(".sending");
+            sending_offset_ = 0;
+            bool renamed = details::os::rename(config_.spill_filename, sending_file_) == 0;
+            if (!renamed) {
+                sending_file_.clear();  // taken once the rename works
+            }
+            spill_.open(config_.spill_filename, renamed);
+            spill_open_ = true;
+            spill_size_ = renamed ? 0 : spill_.size();
+        }
+        SPDLOG_CATCH_STD
+    }
+
+    void worker_loop_() {
+        auto delay = config_.reconnect_min_delay;
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || has_work_(); });
+            if (!has_work_()) {
+                return;  // stopped
+            }
+            take_();
+            auto stopping = stop_;
+            if (sending_.empty() && sending_file_.empty()) {
+                // the spill file couldn't be taken yet
+                if (stopping) {
+                    return;
+                }
+                cv_.wait_for(lock, delay, [this] { return stop_; });
+                continue;
+            }
+            lock.unlock();
+            // no more reconnection attempt when stopping, the destructor shouldn't wait for them
+            bool sent = (!stopping || !failed_) && send_all_();
+            failed_ = !sent;
+            lock.lock();
+            if (sent) {
+                delay = config_.reconnect_min_delay;
+                continue;
+            }
+            if (stopping) {
+                spill_rest_();
+                return;
+            }
+            cv_.wait_for(lock, delay, [this] { return stop_; });
+            delay = (std::min)(delay * 2, config_.reconnect_max_delay);
+        }
+    }
+
+    // connect if needed and send the records taken. false (with the connection closed) on failure
+    bool send_all_() {
+        SPDLOG_TRY {
+            if (!client_.is_connected()) {
+                client_.connect(config_.server_host, config_.server_port);
+#ifndef SPDLOG_OPENSSL
+                set_send_timeout_();  // tls_client sets it, the handshake included
+#endif
+                start_compression_();
+                connected_.store(true, std::memory_order_relaxed);
+            }
+            if (!sending_.empty()) {
+                send_(sending_.data(), sending_.size());
+                sending_.clear();
+            }
+            if (!sending_file_.empty()) {
+                send_file_();
+            }
+            return true;
+        }
+        SPDLOG_CATCH_STD
+        client_.close();
+        connected_.store(false, std::memory_order_relaxed);
+        return false;
+    }
+
+    // a new stream for each connection: the records in flight when the previous one dropped are
+    // sent again, compressed again
+    void start_compression_() {
+#ifdef SPDLOG_ZLIB
+        if (!compressing_) {
+            return;
+        }
+        (void)deflateReset(&zstream_);
+        if (!config_.compression_dictionary.empty() &&
+            deflateSetDictionary(
+                &zstream_,
+                reinterpret_cast<const Bytef *>(config_.compression_dictionary.data()),
+                static_cast<uInt>(config_.compression_dictionary.size())) != Z_OK) {
+            throw_spdlog_ex("buffered_tcp_sink: invalid compression dictionary");
+        }
+#endif
+    }
+
+    // compressed and flushed if compressing
+    void send_(const char *data, size_t size) {
+#ifdef SPDLOG_ZLIB
+        if (compressing_) {
+            compressed_.clear();
+            zstream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+            zstream_.avail_in = static_cast<uInt>(size);
+            do {
+                auto used = compressed_.size();
+                compressed_.resize(used + size / 2 + 1024);
+                zstream_.next_out = reinterpret_cast<Bytef *>(&compressed_[used]);
+                zstream_.avail_out = static_cast<uInt>(compressed_.size() - used);
+                if (deflate(&zstream_, Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+                    throw_spdlog_ex("buffered_tcp_sink: compression failed");
+                }
+                compressed_.resize(compressed_.size() - zstream_.avail_out);
+            } while (zstream_.avail_out == 0);
+            client_.send(compressed_.data(), compressed_.size());
+            return;
+        }
+#endif
+        client_.send(data, size);
+    }
+
+    void send_file_() {
+        std::FILE *fd = nullptr;
+        if (details::os::fopen_s(&fd, sending_file_, SPDLOG_FILENAME_T("rb"))) {
+            sending_file_.clear();  // gone
+            return;
+        }
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(fd, std::fclose);
+        if (std::fseek(fd, sending_offset_, SEEK_SET) != 0) {
+            throw_spdlog_ex("buffered_tcp_sink: failed reading the spill file", errno);
+        }
+        char chunk[64 * 1024];
+        size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), fd)) > 0) {
+            send_(chunk, n);
+            sending_offset_ += static_cast<long>(n);
+        }
+        file.reset();
+        (void)details::os::remove(sending_file_);
+        sending_file_.clear();
+        sending_offset_ = 0;
+    }
+
+    // when stopping without a connection: keep what wasn't sent for the next sink, in the order
+    // it would have been sent (sending_, the file being sent, pending_), before the spill file
+    void spill_rest_() {
+        if (config_.spill_filename.empty() ||
+            (sending_.empty() && pending_.empty() && sending_offset_ == 0)) {
+            return;
+        }
+        auto rest_filename = config_.spill_filename + SPDLOG_FILENAME_T(".sending");
+        auto tmp_filename = rest_filename + SPDLOG_FILENAME_T(".tmp");
+        SPDLOG_TRY {
+            details::file_helper rest;
+            rest.open(tmp_filename, true);
+            rest.write(sending_.data(), sending_.size());
+            std::FILE *fd = nullptr;
+            if (!sending_file_.empty() &&
+                !details::os::fopen_s(&fd, sending_file_, SPDLOG_FILENAME_T("rb"))) {
+                std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(fd, std::fclose);
+                if (std::fseek(fd, sending_offset_, SEEK_SET) == 0) {
+                    char chunk[64 * 1024];
+                    size_t n;
+                    while ((n = std::fread(chunk, 1, sizeof(chunk), fd)) > 0) {
+                        rest.write(chunk, n);
+                    }
+                }
+            }
+            rest.write(pending_.data(), pending_.size());
+            rest.close();
+            (void)details::os::remove(rest_filename);
+            (void)details::os::rename(tmp_filename, rest_filename);
+        }
+        SPDLOG_CATCH_STD
+    }
+
+#ifndef SPDLOG_OPENSSL
+    void set_send_timeout_() {
+        auto ms = config_.send_timeout.count();
+#ifdef _WIN32
+        DWORD timeout = static_cast<DWORD>(ms);
+#else
+        timeval timeout{};
+        timeout.tv_sec = static_cast<decltype(timeout.tv_sec)>(ms / 1000);
+        timeout.tv_usec = static_cast<decltype(timeout.tv_usec)>(ms % 1000 * 1000);
+#endif
+        ::setsockopt(client_.fd(), SOL_SOCKET, SO_SNDTIMEO,
+                     reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+    }
+#endif
+};
+
+// A preset dictionary for the compression of records like the samples: their most frequent words
+// (the ones saving the most), the best last, where they are the cheapest to refer to.
+inline std::string train_compression_dictionary(const std::vector<std::string> &samples,
+                                                size_t max_size = 32 * 1024) {
+    std::unordered_map<std::string, size_t> counts;
+    for (const auto &sample : samples) {
+        size_t pos = 0;
+        while (pos < sample.size()) {
+            auto end = sample.find_first_of(" \t\r\n", pos);
+            if (end == std::string::npos) {
+                end = sample.size();
+            }
+            if (end - pos >= 3) {
+                counts[sample.substr(pos, end - pos)]++;
+            }
+            pos = end + 1;
+        }
+    }
+    std::vector<std::pair<size_t, std::string>> words;
+    for (auto &count : counts) {
+        if (count.second > 1) {
+            words.emplace_back(count.second * count.first.size(), count.first);
+        }
+    }
+    std::sort(words.begin(), words.end(),
+              [](const std::pair<size_t, std::string> &a, const std::pair<size_t, std::string> &b) {
+                  return a.first != b.first ? a.first > b.first : a.second < b.second;
+              });
+    size_t size = 0;
+    size_t kept = 0;
+    while (kept < words.size() && size + words[kept].second.size() + 1 <= max_size) {
+        size += words[kept++].second.size() + 1;
+    }
+    std::string dictionary;
+    dictionary.reserve(size);
+    while (kept > 0) {
+        dictionary += words[--kept].second;
+        dictionary += ' ';
+    }
+    return dictionary;
+}
+
+using buffered_tcp_sink_mt = buffered_tcp_sink<std::mutex>;
+using buffered_tcp_sink_st = buffered_tcp_sink<details::null_mutex>;
+
+}  // namespace sinks
+}  // namespace spdlog
@@ -9,11 +9,15 @@
 
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace spdlog {
 
 // callbacks type
 typedef std::function<void(const details::log_msg &msg)> custom_log_callback;
+// msgs[0] to msgs[count - 1]
+typedef std::function<void(const details::log_msg *msgs, size_t count)>
+    custom_log_batch_callback;
 
 namespace sinks {
 /*
@@ -33,8 +37,53 @@ private:
     custom_log_callback callback_;
 };
 
+/*
+ * Callback sink getting the messages in batches: all the messages of a batch of the async
+ * loggers (those passing the sink's level) in one call, or one message for the other loggers.
+ * The messages are only valid during the call.
+ */
+template <typename Mutex>
+class batch_callback_sink final : public base_sink<Mutex> {
+public:
+    explicit batch_callback_sink(const custom_log_batch_callback &callback)
+        : callback_{callback} {}
+
+protected:
+    void sink_it_(const details::log_msg &msg) override { callback_(&msg, 1); }
+
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        size_t passing = 0;
+        while (passing < count && base_sink<Mutex>::should_log(msgs[passing])) {
+            passing++;
+        }
+        if (passing == count) {
+            callback_(msgs, count);
+            return;
+        }
+        // some are filtered out: the others are copied to be contiguous
+        filtered_.assign(msgs, msgs + passing);
+        for (size_t i = passing + 1; i < count; i++) {
+            if (base_sink<Mutex>::should_log(msgs[i])) {
+                filtered_.push_back(msgs[i]);
+            }
+        }
+        if (!filtered_.empty()) {
+            callback_(filtered_.data(), filtered_.size());
+        }
+        filtered_.clear();
+    }
+
+    void flush_() override {}
+
+private:
+    custom_log_batch_callback callback_;
+    std::vector<details::log_msg> filtered_;
+};
+
 using callback_sink_mt = callback_sink<std::mutex>;
 using callback_sink_st = callback_sink<details::null_mutex>;
+using batch_callback_sink_mt = batch_callback_sink<std::mutex>;
+using batch_callback_sink_st = batch_callback_sink<details::null_mutex>;
 
 }  // namespace sinks
 
@@ -53,4 +102,16 @@ inline std::shared_ptr<logger> callback_logger_st(const std::string &logger_name
     return Factory::template create<sinks::callback_sink_st>(logger_name, callback);
 }
 
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> batch_callback_logger_mt(const std::string &logger_name,
+                                                        const custom_log_batch_callback &callback) {
+    return Factory::template create<sinks::batch_callback_sink_mt>(logger_name, callback);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> batch_callback_logger_st(const std::string &logger_name,
+                                                        const custom_log_batch_callback &callback) {
+    return Factory::template create<sinks::batch_callback_sink_st>(logger_name, callback);
+}
+
 }  // namespace spdlog
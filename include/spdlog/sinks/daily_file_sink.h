@@ -5,9 +5,12 @@
 
 #include <spdlog/common.h>
 #include <spdlog/details/circular_q.h>
+#include <spdlog/details/dir_snapshot.h>
 #include <spdlog/details/file_helper.h>
+#include <spdlog/details/file_housekeeper.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/details/os.h>
+#include <spdlog/details/rotation_schedule.h>
 #include <spdlog/details/synchronous_factory.h>
 #include <spdlog/fmt/chrono.h>
 #include <spdlog/fmt/fmt.h>
@@ -15,9 +18,10 @@
 
 #include <chrono>
 #include <cstdio>
-#include <iomanip>
+#include <ctime>
+#include <cwchar>
+#include <memory>
 #include <mutex>
-#include <sstream>
 #include <string>
 
 namespace spdlog {
@@ -48,13 +52,22 @@ struct daily_filename_calculator {
  */
 struct daily_filename_format_calculator {
     static filename_t calc_filename(const filename_t &file_path, const tm &now_tm) {
+        // strftime into a buffer grown until the result fits. it returns 0 for an empty result
+        // too, hence the limit.
+        filename_t filename;
+        for (size_t size = file_path.size() * 2 + 64; size <= file_path.size() * 256; size *= 2) {
+            filename.resize(size);
 #if defined(_WIN32) && defined(SPDLOG_WCHAR_FILENAMES)
-        std::wstringstream stream;
+            auto n = std::wcsftime(&filename[0], size, file_path.c_str(), &now_tm);
 #else
-        std::stringstream stream;
+            auto n = std::strftime(&filename[0], size, file_path.c_str(), &now_tm);
 #endif
-        stream << std::put_time(&now_tm, file_path.c_str());
-        return stream.str();
+            if (n > 0) {
+                filename.resize(n);
+                return filename;
+            }
+        }
+        return filename_t{};
     }
 };
 
@@ -65,6 +78,8 @@ struct daily_filename_format_calculator {
  * If max_files > 0, retain only the last max_files and delete previous.
  * Note that old log files from previous executions will not be deleted by this class,
  * rotation and deletion is only applied while the program is running.
+ * With set_compression(), the previous file is compressed in the background after rotation,
+ * and its deletion is done in the background too.
  */
 template <typename Mutex, typename FileNameCalc = daily_filename_calculator>
 class daily_file_sink final : public base_sink<Mutex> {
@@ -77,17 +92,11 @@ public:
                     uint16_t max_files = 0,
                     const file_event_handlers &event_handlers = {})
         : base_filename_(std::move(base_filename)),
-          rotation_h_(rotation_hour),
-          rotation_m_(rotation_minute),
+          schedule_(std::chrono::hours(24), rotation_offset_(rotation_hour, rotation_minute)),
           file_helper_{event_handlers},
           truncate_(truncate),
           max_files_(max_files),
           filenames_q_() {
-        if (rotation_hour < 0 || rotation_hour > 23 || rotation_minute < 0 ||
-            rotation_minute > 59) {
-            throw_spdlog_ex("daily_file_sink: Invalid rotation time in ctor");
-        }
-
         auto now = log_clock::now();
         auto filename = FileNameCalc::calc_filename(base_filename_, now_tm(now));
         file_helper_.open(filename, truncate_);
@@ -103,37 +112,62 @@ public:
         return file_helper_.filename();
     }
 
+    // compress the files from now on. throw spdlog_ex if the compression isn't available.
+    void set_compression(const compression_options &options) {
+        details::throw_if_unsupported(options);
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        compression_ = options;
+        if (!housekeeper_) {
+            housekeeper_ = details::make_unique<details::file_housekeeper>();
+        }
+    }
+
 protected:
     void sink_it_(const details::log_msg &msg) override {
         auto time = msg.time;
         bool should_rotate = time >= rotation_tp_;
+        filename_t previous;
         if (should_rotate) {
+            previous = file_helper_.filename();
             auto filename = FileNameCalc::calc_filename(base_filename_, now_tm(time));
             file_helper_.open(filename, truncate_);
             rotation_tp_ = next_rotation_tp_();
         }
         memory_buf_t formatted;
         base_sink<Mutex>::formatter_->format(msg, formatted);
+        file_helper_.note_time(msg.time);
         file_helper_.write(formatted);
 
         // Do the cleaning only at the end because it might throw on failure.
+        if (should_rotate && housekeeper_ && previous != file_helper_.filename()) {
+            auto compression = compression_;
+            housekeeper_->post([previous, compression] {
+                return details::compress_file(previous, compression);
+            });
+        }
         if (should_rotate && max_files_ > 0) {
             delete_old_();
         }
+        if (should_rotate && housekeeper_) {
+            auto error = housekeeper_->take_error();
+            if (!error.empty()) {
+                throw_spdlog_ex(error);
+            }
+        }
     }
 
     void flush_() override { file_helper_.flush(); }
 
 private:
     void init_filenames_q_() {
-        using details::os::path_exists;
-
         filenames_q_ = details::circular_q<filename_t>(static_cast<size_t>(max_files_));
         std::vector<filename_t> filenames;
+        details::dir_snapshot files;  // one listing instead of a stat per file
         auto now = log_clock::now();
         while (filenames.size() < max_files_) {
             auto filename = FileNameCalc::calc_filename(base_filename_, now_tm(now));
-            if (!path_exists(filename)) {
+            if (!files.exists(filename) &&
+                !files.exists(details::compressed_filename(filename, file_compression::gzip))) {
                 break;
             }
             filenames.emplace_back(filename);
@@ -144,24 +178,18 @@ private:
         }
     }
 
-    tm now_tm(log_clock::time_point tp) {
-        time_t tnow = log_clock::to_time_t(tp);
-        return spdlog::details::os::localtime(tnow);
-    }
+    tm now_tm(log_clock::time_point tp) { return details::rotation_schedule::local_tm(tp); }
 
-    log_clock::time_point next_rotation_tp_() {
-        auto now = log_clock::now();
-        tm date = now_tm(now);
-        date.tm_hour = rotation_h_;
-        date.tm_min = rotation_m_;
-        date.tm_sec = 0;
-        auto rotation_time = log_clock::from_time_t(std::mktime(&date));
-        if (rotation_time > now) {
-            return rotation_time;
+    static std::chrono::minutes rotation_offset_(int rotation_hour, int rotation_minute) {
+        if (rotation_hour < 0 || rotation_hour > 23 || rotation_minute < 0 ||
+            rotation_minute > 59) {
+            throw_spdlog_ex("daily_file_sink: Invalid rotation time in ctor");
         }
-        return {rotation_time + std::chrono::hours(24)};
+        return std::chrono::minutes(rotation_hour * 60 + rotation_minute);
     }
 
+    log_clock::time_point next_rotation_tp_() { return schedule_.next_after(log_clock::now()); }
+
     // Delete the file N rotations ago.
     // Throw spdlog_ex on failure to delete the old file.
     void delete_old_() {
@@ -172,7 +200,20 @@ private:
         if (filenames_q_.full()) {
             auto old_filename = std::move(filenames_q_.front());
             filenames_q_.pop_front();
+            if (housekeeper_) {
+                // after its compression
+                housekeeper_->post([old_filename] {
+                    (void)remove_if_exists(old_filename);
+                    (void)remove_if_exists(
+                        details::compressed_filename(old_filename, file_compression::gzip));
+                    (void)remove_if_exists(details::file_index::index_filename(old_filename));
+                    return std::string{};
+                });
+                filenames_q_.push_back(std::move(current_file));
+                return;
+            }
             bool ok = remove_if_exists(old_filename) == 0;
+            (void)remove_if_exists(details::file_index::index_filename(old_filename));
             if (!ok) {
                 filenames_q_.push_back(std::move(current_file));
                 throw_spdlog_ex("Failed removing daily file " + filename_to_str(old_filename),
@@ -183,13 +224,14 @@ private:
     }
 
     filename_t base_filename_;
-    int rotation_h_;
-    int rotation_m_;
+    details::rotation_schedule schedule_;
     log_clock::time_point rotation_tp_;
     details::file_helper file_helper_;
     bool truncate_;
     uint16_t max_files_;
     details::circular_q<filename_t> filenames_q_;
+    compression_options compression_;
+    std::unique_ptr<details::file_housekeeper> housekeeper_;  // with compression
 };
 
 using daily_file_sink_mt = daily_file_sink<std::mutex>;
@@ -198,6 +240,9 @@ using daily_file_format_sink_mt = daily_file_sink<std::mutex, daily_filename_for
 using daily_file_format_sink_st =
     daily_file_sink<details::null_mutex, daily_filename_format_calculator>;
 
+template <typename Mutex, typename FileNameCalc>
+struct shares_file<daily_file_sink<Mutex, FileNameCalc>> : std::true_type {};
+
 }  // namespace sinks
 
 //
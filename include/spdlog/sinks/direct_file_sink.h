@@ -0,0 +1,201 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef __linux__
+    #error direct_file_sink is only available on linux
+#endif
+
+// File sink writing with O_DIRECT, so the log data doesn't go through (and doesn't evict the
+// pages of the other processes from) the page cache. The messages are copied into a page aligned
+// buffer, written when full. flush() writes the last partial block padded with zeros, then
+// truncates the file to the data; the block is written again with the next messages.
+//
+// The file system must support O_DIRECT (tmpfs doesn't), and the file shouldn't be written by
+// anything else while the sink is open.
+//
+// Usage example:
+// auto logger = spdlog::direct_logger_mt("direct_logger", "logs/direct.txt");
+
+#include <spdlog/common.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class direct_file_sink final : public base_sink<Mutex> {
+public:
+    static constexpr size_t alignment = 4096;  // of the file offsets, sizes and buffer
+
+    // buffer_size is rounded up to a multiple of the alignment
+    explicit direct_file_sink(filename_t filename,
+                              bool truncate = false,
+                              size_t buffer_size = 1024 * 1024)
+        : filename_(std::move(filename)),
+          buffer_size_((std::max)(round_up_(buffer_size), alignment)) {
+        details::os::create_dir(details::os::dir_name(filename_));
+        int flags = O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT | (truncate ? O_TRUNC : 0);
+        fd_ = ::open(filename_.c_str(), flags, 0644);
+        struct stat st;
+        if (fd_ < 0 || ::fstat(fd_, &st) != 0) {
+            auto err = errno;
+            close_();
+            throw_spdlog_ex("Failed opening file " + filename_ + " for direct writing", err);
+        }
+        void *buffer = nullptr;
+        if (::posix_memalign(&buffer, alignment, buffer_size_) != 0) {
+            close_();
+            throw_spdlog_ex("direct_file_sink: failed allocating the buffer");
+        }
+        buffer_ = static_cast<char *>(buffer);
+
+        // the last partial block is rewritten with the next messages
+        auto size = static_cast<size_t>(st.st_size);
+        offset_ = size / alignment * alignment;
+        used_ = size - offset_;
+        if (used_ > 0 && ::pread(fd_, buffer_, alignment, static_cast<off_t>(offset_)) !=
+                             static_cast<ssize_t>(used_)) {
+            auto err = errno;
+            close_();
+            throw_spdlog_ex("Failed reading file " + filename_, err);
+        }
+    }
+
+    direct_file_sink(const direct_file_sink &) = delete;
+    direct_file_sink &operator=(const direct_file_sink &) = delete;
+
+    ~direct_file_sink() override {
+        SPDLOG_TRY {
+            std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+            flush_();
+        }
+        SPDLOG_CATCH_STD
+        close_();
+    }
+
+    const filename_t &filename() const { return filename_; }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        memory_buf_t formatted;
+        base_sink<Mutex>::formatter_->format(msg, formatted);
+        auto data = formatted.data();
+        auto size = formatted.size();
+        while (size > 0) {
+            auto n = (std::min)(size, buffer_size_ - used_);
+            std::memcpy(buffer_ + used_, data, n);
+            used_ += n;
+            data += n;
+            size -= n;
+            if (used_ == buffer_size_) {
+                write_(buffer_size_);
+                offset_ += buffer_size_;
+                used_ = 0;
+            }
+        }
+    }
+
+    void flush_() override {
+        if (used_ == 0 || fd_ < 0) {
+            return;
+        }
+        auto padded = round_up_(used_);
+        std::memset(buffer_ + used_, 0, padded - used_);
+        write_(padded);
+        if (::ftruncate(fd_, static_cast<off_t>(offset_ + used_)) != 0) {
+            throw_spdlog_ex("Failed truncating file " + filename_, errno);
+        }
+        // keep the last partial block at the start of the buffer
+        auto full = used_ / alignment * alignment;
+        if (full > 0) {
+            std::memmove(buffer_, buffer_ + full, used_ - full);
+            offset_ += full;
+            used_ -= full;
+        }
+    }
+
+private:
+    filename_t filename_;
+    size_t buffer_size_;
+    int fd_ = -1;
+    char *buffer_ = nullptr;
+    size_t offset_ = 0;  // in the file, of the buffer start
+    size_t used_ = 0;    // in the buffer
+
+    static size_t round_up_(size_t size) { return (size + alignment - 1) / alignment * alignment; }
+
+    // write the first size bytes of the buffer at offset_
+    void write_(size_t size) {
+        size_t written = 0;
+        while (written < size) {
+            auto rv = ::pwrite(fd_, buffer_ + written, size - written,
+                               static_cast<off_t>(offset_ + written));
+            if (rv < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw_spdlog_ex("Failed writing to file " + filename_, errno);
+            }
+            written += static_cast<size_t>(rv);
+        }
+    }
+
+    void close_() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        std::free(buffer_);
+        buffer_ = nullptr;
+    }
+};
+
+template <typename Mutex>
+constexpr size_t direct_file_sink<Mutex>::alignment;
+
+using direct_file_sink_mt = direct_file_sink<std::mutex>;
+using direct_file_sink_st = direct_file_sink<details::null_mutex>;
+
+template <typename Mutex>
+struct shares_file<direct_file_sink<Mutex>> : std::true_type {};
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> direct_logger_mt(const std::string &logger_name,
+                                                const filename_t &filename,
+                                                bool truncate = false,
+                                                size_t buffer_size = 1024 * 1024) {
+    return Factory::template create<sinks::direct_file_sink_mt>(logger_name, filename, truncate,
+                                                                buffer_size);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> direct_logger_st(const std::string &logger_name,
+                                                const filename_t &filename,
+                                                bool truncate = false,
+                                                size_t buffer_size = 1024 * 1024) {
+    return Factory::template create<sinks::direct_file_sink_st>(logger_name, filename, truncate,
+                                                                buffer_size);
+}
+
+}  // namespace spdlog
@@ -4,21 +4,137 @@
 #pragma once
 
 #include "base_sink.h"
+#include <spdlog/async_logger.h>
 #include <spdlog/details/log_msg.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/mpmc_blocking_q.h>
 #include <spdlog/details/null_mutex.h>
+#include <spdlog/details/shared_format.h>
 #include <spdlog/pattern_formatter.h>
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 // Distribution sink (mux). Stores a vector of sinks which get called when log
 // is called
+//
+// With dist_sink_parallel, each sub sink gets its own queue and thread: the messages are copied
+// once, queued for each sub sink, and logged by its thread, so a slow sub sink (e.g. on the
+// network) doesn't delay the others. flush() is then asynchronous, like the async loggers' one,
+// the sub sinks being flushed by their threads after the messages queued before. The sub sinks
+// must be changed with add_sink(), remove_sink() and set_sinks(), not through sinks().
 
 namespace spdlog {
 namespace sinks {
 
+struct dist_sink_parallel {
+    size_t queue_size = 8192;  // messages per sub sink
+    // when a sub sink's queue is full. sample is handled like discard_new.
+    async_overflow_policy overflow_policy = async_overflow_policy::block;
+};
+
+namespace details_dist {
+// the queue and thread of a sub sink of a parallel dist_sink
+class sub_sink_worker {
+public:
+    sub_sink_worker(std::shared_ptr<sink> sub_sink, const dist_sink_parallel &parallel)
+        : sink_(std::move(sub_sink)),
+          policy_(parallel.overflow_policy),
+          queue_(parallel.queue_size) {
+        thread_ = std::thread([this] { worker_loop_(); });
+    }
+
+    // log what was queued before stopping
+    ~sub_sink_worker() {
+        queue_.enqueue(item{item::stop, nullptr});
+        thread_.join();
+    }
+
+    sub_sink_worker(const sub_sink_worker &) = delete;
+    sub_sink_worker &operator=(const sub_sink_worker &) = delete;
+
+    const std::shared_ptr<sink> &sub_sink() const { return sink_; }
+
+    void post(const std::shared_ptr<const details::log_msg_buffer> &msg) {
+        item it{item::log, msg};
+        switch (policy_) {
+            case async_overflow_policy::block:
+                queue_.enqueue(std::move(it));
+                break;
+            case async_overflow_policy::overrun_oldest:
+                queue_.enqueue_nowait(std::move(it));
+                break;
+            default:
+                queue_.enqueue_if_have_room(std::move(it));
+                break;
+        }
+    }
+
+    // flushed by the thread, never dropped
+    void post_flush() { queue_.enqueue(item{item::flush, nullptr}); }
+
+    size_t dropped() { return queue_.overrun_counter() + queue_.discard_counter(); }
+
+private:
+    struct item {
+        enum kind_t { log, flush, stop };
+        item() = default;
+        item(kind_t item_kind, std::shared_ptr<const details::log_msg_buffer> item_msg)
+            : kind(item_kind),
+              msg(std::move(item_msg)) {}
+        kind_t kind = log;
+        std::shared_ptr<const details::log_msg_buffer> msg;
+    };
+
+    std::shared_ptr<sink> sink_;
+    async_overflow_policy policy_;
+    details::mpmc_blocking_queue<item> queue_;
+    std::thread thread_;
+
+    // log the messages popped together with one log_batch() call
+    void worker_loop_() {
+        static constexpr size_t max_batch = 64;
+        std::vector<item> items(max_batch);
+        std::vector<details::log_msg> msgs;
+        msgs.reserve(max_batch);
+        for (;;) {
+            auto n = queue_.dequeue_bulk(items.data(), max_batch);
+            for (size_t i = 0; i < n; i++) {
+                auto &it = items[i];
+                if (it.kind == item::log) {
+                    msgs.push_back(*it.msg);
+                    continue;
+                }
+                log_(msgs);
+                if (it.kind == item::stop) {
+                    return;
+                }
+                SPDLOG_TRY { sink_->flush(); }
+                SPDLOG_CATCH_STD
+            }
+            log_(msgs);
+            for (size_t i = 0; i < n; i++) {
+                items[i].msg.reset();
+            }
+        }
+    }
+
+    void log_(std::vector<details::log_msg> &msgs) {
+        if (msgs.empty()) {
+            return;
+        }
+        SPDLOG_TRY { sink_->log_batch(msgs.data(), msgs.size()); }
+        SPDLOG_CATCH_STD
+        msgs.clear();
+    }
+};
+}  // namespace details_dist
+
 template <typename Mutex>
 class dist_sink : public base_sink<Mutex> {
 public:
@@ -26,36 +142,113 @@ public:
     explicit dist_sink(std::vector<std::shared_ptr<sink>> sinks)
         : sinks_(sinks) {}
 
+    dist_sink(std::vector<std::shared_ptr<sink>> sinks, dist_sink_parallel parallel)
+        : parallel_(new dist_sink_parallel(parallel)) {
+        set_sinks(std::move(sinks));
+    }
+
     dist_sink(const dist_sink &) = delete;
     dist_sink &operator=(const dist_sink &) = delete;
 
     void add_sink(std::shared_ptr<sink> sub_sink) {
         std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
         sinks_.push_back(sub_sink);
+        if (parallel_) {
+            workers_.emplace_back(new details_dist::sub_sink_worker(sub_sink, *parallel_));
+        }
     }
 
     void remove_sink(std::shared_ptr<sink> sub_sink) {
         std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
         sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sub_sink), sinks_.end());
+        // the worker logs what was queued for the sub sink before stopping
+        workers_.erase(std::remove_if(workers_.begin(), workers_.end(),
+                                      [&sub_sink](const worker_ptr &worker) {
+                                          return worker->sub_sink() == sub_sink;
+                                      }),
+                       workers_.end());
     }
 
     void set_sinks(std::vector<std::shared_ptr<sink>> sinks) {
         std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
         sinks_ = std::move(sinks);
+        if (parallel_) {
+            workers_.clear();
+            for (auto &sub_sink : sinks_) {
+                workers_.emplace_back(new details_dist::sub_sink_worker(sub_sink, *parallel_));
+            }
+        }
     }
 
     std::vector<std::shared_ptr<sink>> &sinks() { return sinks_; }
 
+    // with dist_sink_parallel: the number of messages dropped because a sub sink's queue was
+    // full, for all the sub sinks
+    size_t dropped() {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        size_t count = 0;
+        for (auto &worker : workers_) {
+            count += worker->dropped();
+        }
+        return count;
+    }
+
 protected:
     void sink_it_(const details::log_msg &msg) override {
+        if (parallel_) {
+            post_(msg);
+            return;
+        }
+        // sub sinks with identical formatters share the formatted message
+        details::shared_format_scope shared_format(msg, sinks_.size() > 1);
         for (auto &sub_sink : sinks_) {
-            if (sub_sink->should_log(msg.level)) {
+            if (sub_sink->should_log(msg)) {
                 sub_sink->log(msg);
             }
         }
     }
 
+    // the sub sinks get the whole batch, each locking once for it and filtering it, unless the
+    // dist_sink's own level or filter drops some of its messages. subclasses overriding
+    // sink_it_() must override this too (e.g. with base_sink::sink_batch_()).
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        bool all_pass = true;
+        for (size_t i = 0; i < count && all_pass; i++) {
+            all_pass = base_sink<Mutex>::should_log(msgs[i]);
+        }
+        if (parallel_ || !all_pass) {
+            base_sink<Mutex>::sink_batch_(msgs, count);
+            return;
+        }
+#ifdef SPDLOG_NO_EXCEPTIONS
+        for (auto &sub_sink : sinks_) {
+            sub_sink->log_batch(msgs, count);
+        }
+#else
+        // the other sub sinks still get the batch, the first error is rethrown at the end
+        std::exception_ptr first_error;
+        for (auto &sub_sink : sinks_) {
+            try {
+                sub_sink->log_batch(msgs, count);
+            } catch (...) {
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+            }
+        }
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+#endif
+    }
+
     void flush_() override {
+        if (parallel_) {
+            for (auto &worker : workers_) {
+                worker->post_flush();
+            }
+            return;
+        }
         for (auto &sub_sink : sinks_) {
             sub_sink->flush();
         }
@@ -72,6 +265,26 @@ protected:
         }
     }
     std::vector<std::shared_ptr<sink>> sinks_;
+
+private:
+    using worker_ptr = std::unique_ptr<details_dist::sub_sink_worker>;
+    std::unique_ptr<dist_sink_parallel> parallel_;  // null if not parallel
+    std::vector<worker_ptr> workers_;               // one per sub sink, if parallel
+
+    // copy the message once for all the sub sinks logging it. their filters are checked by
+    // their log_batch(), on their worker.
+    void post_(const details::log_msg &msg) {
+        std::shared_ptr<const details::log_msg_buffer> copy;
+        for (auto &worker : workers_) {
+            if (!worker->sub_sink()->should_log(msg.level)) {
+                continue;
+            }
+            if (!copy) {
+                copy = std::make_shared<const details::log_msg_buffer>(msg);
+            }
+            worker->post(copy);
+        }
+    }
 };
 
 using dist_sink_mt = dist_sink<std::mutex>;
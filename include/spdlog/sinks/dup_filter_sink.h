@@ -8,12 +8,17 @@
 #include <spdlog/details/null_mutex.h>
 
 #include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <mutex>
 #include <string>
+#include <vector>
 
 // Duplicate message removal sink.
 // Skip the message if previous one is identical and less than "max_skip_duration" have passed
+// since it was logged. With window > 1, the message is compared with the last "window" distinct
+// messages logged instead, so repeats interleaved with other messages (e.g. from several
+// threads) are skipped too. Only a 64 bit hash of each payload is kept.
 //
 // Example:
 //
@@ -41,16 +46,26 @@ class dup_filter_sink : public dist_sink<Mutex> {
 public:
     template <class Rep, class Period>
     explicit dup_filter_sink(std::chrono::duration<Rep, Period> max_skip_duration,
-                             level::level_enum notification_level = level::info)
+                             level::level_enum notification_level = level::info,
+                             size_t window = 1)
         : max_skip_duration_{max_skip_duration},
-          log_level_{notification_level} {}
+          log_level_{notification_level},
+          window_{window == 0 ? 1 : window} {
+        recent_.reserve(window_);
+    }
 
 protected:
+    struct recent_msg {
+        std::uint64_t hash;
+        log_clock::time_point time;  // when it was last logged
+    };
+
     std::chrono::microseconds max_skip_duration_;
-    log_clock::time_point last_msg_time_;
-    std::string last_msg_payload_;
     size_t skip_counter_ = 0;
     level::level_enum log_level_;
+    size_t window_;
+    std::vector<recent_msg> recent_;  // the last distinct messages logged
+    size_t oldest_ = 0;               // replaced by the next distinct message once full
 
     void sink_it_(const details::log_msg &msg) override {
         bool filtered = filter_(msg);
@@ -73,15 +88,43 @@ protected:
 
         // log current message
         dist_sink<Mutex>::sink_it_(msg);
-        last_msg_time_ = msg.time;
         skip_counter_ = 0;
-        last_msg_payload_.assign(msg.payload.data(), msg.payload.data() + msg.payload.size());
+    }
+
+    // one message at a time, to compare each with the previous ones
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        base_sink<Mutex>::sink_batch_(msgs, count);
     }
 
     // return whether the log msg should be displayed (true) or skipped (false)
     bool filter_(const details::log_msg &msg) {
-        auto filter_duration = msg.time - last_msg_time_;
-        return (filter_duration > max_skip_duration_) || (msg.payload != last_msg_payload_);
+        auto hash = hash_(msg.payload);
+        for (auto &recent : recent_) {
+            if (recent.hash == hash) {
+                if (msg.time - recent.time > max_skip_duration_) {
+                    recent.time = msg.time;
+                    return true;
+                }
+                return false;
+            }
+        }
+        if (recent_.size() < window_) {
+            recent_.push_back(recent_msg{hash, msg.time});
+        } else {
+            recent_[oldest_] = recent_msg{hash, msg.time};
+            oldest_ = (oldest_ + 1) % window_;
+        }
+        return true;
+    }
+
+    // 64 bit FNV-1a
+    static std::uint64_t hash_(string_view_t payload) {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (auto c : payload) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
     }
 };
 
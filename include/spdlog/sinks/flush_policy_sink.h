@@ -0,0 +1,122 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Distribution sink flushing its sub sinks on a policy combining the level of the messages, the
+// size logged since the last flush, and the delay since then: buffered sinks can keep large
+// buffers while the recent messages still get to their destination soon.
+//
+// The delay is checked by the housekeeping scheduler's thread (see details/scheduler.h), which
+// flushes concurrently with the logging threads: use flush_policy_sink_mt with max_delay.
+//
+// Usage example, for all the sinks of a logger:
+// spdlog::sinks::flush_policy policy;
+// policy.max_pending_bytes = 1024 * 1024;
+// policy.max_delay = std::chrono::milliseconds(500);
+// auto sink = std::make_shared<spdlog::sinks::flush_policy_sink_mt>(logger->sinks(), policy);
+// logger->sinks() = {sink};
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/periodic_worker.h>
+#include <spdlog/sinks/dist_sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+// flush once any of the conditions set is met
+struct flush_policy {
+    // after a message of this level or above
+    level::level_enum flush_level = level::off;
+    // once the payloads of the messages logged since the last flush reach it (0 for no limit)
+    size_t max_pending_bytes = 0;
+    // at most this long after a message was logged (0 for no limit)
+    std::chrono::milliseconds max_delay{0};
+};
+
+template <typename Mutex>
+class flush_policy_sink final : public dist_sink<Mutex> {
+public:
+    flush_policy_sink(std::vector<std::shared_ptr<sink>> sinks, flush_policy policy)
+        : dist_sink<Mutex>(std::move(sinks)),
+          policy_(policy) {
+        if (policy_.max_delay > std::chrono::milliseconds::zero()) {
+            timer_ = details::make_unique<details::periodic_worker>(
+                [this] { flush_if_pending_(); }, policy_.max_delay);
+        }
+    }
+
+    flush_policy_sink(std::shared_ptr<sink> sub_sink, flush_policy policy)
+        : flush_policy_sink(std::vector<std::shared_ptr<sink>>{std::move(sub_sink)}, policy) {}
+
+    // the timer is stopped before the sub sinks are released
+    ~flush_policy_sink() override { timer_.reset(); }
+
+    // not with max_delay, flushing from the scheduler's thread
+    bool claim_exclusive(std::thread::id owner) override {
+        return !timer_ && dist_sink<Mutex>::claim_exclusive(owner);
+    }
+
+    const flush_policy &policy() const { return policy_; }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        dist_sink<Mutex>::sink_it_(msg);
+        pending_bytes_ += msg.payload.size();
+        pending_.store(true, std::memory_order_relaxed);
+        if ((msg.level >= policy_.flush_level && msg.level != level::off) ||
+            (policy_.max_pending_bytes > 0 && pending_bytes_ >= policy_.max_pending_bytes)) {
+            flush_();
+        }
+    }
+
+    // the sub sinks get the batch at once, and are flushed after it if needed
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        dist_sink<Mutex>::sink_batch_(msgs, count);
+        bool flush = false;
+        for (size_t i = 0; i < count; i++) {
+            if (!base_sink<Mutex>::should_log(msgs[i])) {
+                continue;
+            }
+            pending_bytes_ += msgs[i].payload.size();
+            pending_.store(true, std::memory_order_relaxed);
+            flush = flush || (msgs[i].level >= policy_.flush_level && msgs[i].level != level::off);
+        }
+        if (flush || (policy_.max_pending_bytes > 0 && pending_bytes_ >= policy_.max_pending_bytes)) {
+            flush_();
+        }
+    }
+
+    void flush_() override {
+        dist_sink<Mutex>::flush_();
+        pending_bytes_ = 0;
+        pending_.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    flush_policy policy_;
+    size_t pending_bytes_ = 0;                         // since the last flush, under the mutex
+    std::atomic<bool> pending_{false};                 // a message was logged since the last flush
+    std::unique_ptr<details::periodic_worker> timer_;  // with max_delay
+
+    // on the scheduler's thread, every max_delay
+    void flush_if_pending_() {
+        if (pending_.load(std::memory_order_relaxed)) {
+            SPDLOG_TRY { this->flush(); }
+            SPDLOG_CATCH_STD
+        }
+    }
+};
+
+using flush_policy_sink_mt = flush_policy_sink<std::mutex>;
+using flush_policy_sink_st = flush_policy_sink<details::null_mutex>;
+
+}  // namespace sinks
+}  // namespace spdlog
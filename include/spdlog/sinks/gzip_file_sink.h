@@ -0,0 +1,154 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_ZLIB
+    #error gzip_file_sink needs zlib (define SPDLOG_ZLIB and link with it)
+#endif
+
+// File sink writing a gzip compressed stream. Each flush() ends a gzip member, and the next
+// messages start a new one: the members are concatenated in the file, which is a valid gzip file
+// (zcat and gunzip read all of them), and each one can be decompressed without the previous ones.
+// A process dying only loses the messages since the last flush.
+//
+// The data is compressed as it's logged, so a flush costs an end of member (around 20 bytes of
+// header and trailer and the reset of the dictionary): flushing on every message spoils the
+// compression ratio.
+//
+// Usage example:
+// auto logger = spdlog::gzip_logger_mt("gzip_logger", "logs/app.log.gz");
+
+#include <spdlog/common.h>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <zlib.h>
+
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class gzip_file_sink final : public base_sink<Mutex> {
+public:
+    // level from 1 (fastest) to 9 (smallest)
+    explicit gzip_file_sink(const filename_t &filename,
+                            bool truncate = false,
+                            int level = 6,
+                            const file_event_handlers &event_handlers = {})
+        : file_helper_{event_handlers} {
+        file_helper_.open(filename, truncate);
+        std::memset(&stream_, 0, sizeof(stream_));
+        // 15 bits window, +16 for the gzip header and trailer
+        if (deflateInit2(&stream_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw_spdlog_ex("gzip_file_sink: invalid compression level " +
+                            std::to_string(level));
+        }
+    }
+
+    gzip_file_sink(const gzip_file_sink &) = delete;
+    gzip_file_sink &operator=(const gzip_file_sink &) = delete;
+
+    ~gzip_file_sink() override {
+        SPDLOG_TRY {
+            std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+            end_member_();
+        }
+        SPDLOG_CATCH_STD
+        (void)deflateEnd(&stream_);
+    }
+
+    const filename_t &filename() const { return file_helper_.filename(); }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        memory_buf_t formatted;
+        base_sink<Mutex>::formatter_->format(msg, formatted);
+        deflate_(formatted.data(), formatted.size(), Z_NO_FLUSH);
+    }
+
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        memory_buf_t formatted;
+        base_sink<Mutex>::format_batch_(msgs, count, formatted, [](size_t) {}, [&] {
+            deflate_(formatted.data(), formatted.size(), Z_NO_FLUSH);
+        });
+    }
+
+    void flush_() override {
+        end_member_();
+        file_helper_.flush();
+    }
+
+private:
+    details::file_helper file_helper_;
+    z_stream stream_;
+    bool member_started_ = false;
+    char out_[16 * 1024];
+
+    // compress the data, writing the output as it comes
+    void deflate_(const char *data, size_t size, int flush) {
+        if (size == 0 && flush == Z_NO_FLUSH) {
+            return;
+        }
+        member_started_ = true;
+        stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream_.avail_in = static_cast<uInt>(size);
+        do {
+            stream_.next_out = reinterpret_cast<Bytef *>(out_);
+            stream_.avail_out = static_cast<uInt>(sizeof(out_));
+            if (deflate(&stream_, flush) == Z_STREAM_ERROR) {
+                throw_spdlog_ex("gzip_file_sink: compression failed");
+            }
+            file_helper_.write(out_, sizeof(out_) - stream_.avail_out);
+        } while (stream_.avail_out == 0);
+    }
+
+    // write the rest of the current member and its trailer. the next data starts a new one.
+    void end_member_() {
+        if (!member_started_) {
+            return;
+        }
+        deflate_(nullptr, 0, Z_FINISH);
+        (void)deflateReset(&stream_);
+        member_started_ = false;
+    }
+};
+
+using gzip_file_sink_mt = gzip_file_sink<std::mutex>;
+using gzip_file_sink_st = gzip_file_sink<details::null_mutex>;
+
+template <typename Mutex>
+struct shares_file<gzip_file_sink<Mutex>> : std::true_type {};
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> gzip_logger_mt(const std::string &logger_name,
+                                              const filename_t &filename,
+                                              bool truncate = false,
+                                              int level = 6,
+                                              const file_event_handlers &event_handlers = {}) {
+    return Factory::template create<sinks::gzip_file_sink_mt>(logger_name, filename, truncate,
+                                                              level, event_handlers);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> gzip_logger_st(const std::string &logger_name,
+                                              const filename_t &filename,
+                                              bool truncate = false,
+                                              int level = 6,
+                                              const file_event_handlers &event_handlers = {}) {
+    return Factory::template create<sinks::gzip_file_sink_st>(logger_name, filename, truncate,
+                                                              level, event_handlers);
+}
+
+}  // namespace spdlog
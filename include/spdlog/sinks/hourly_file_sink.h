@@ -5,9 +5,11 @@
 
 #include <spdlog/common.h>
 #include <spdlog/details/circular_q.h>
+#include <spdlog/details/dir_snapshot.h>
 #include <spdlog/details/file_helper.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/details/os.h>
+#include <spdlog/details/rotation_schedule.h>
 #include <spdlog/details/synchronous_factory.h>
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/sinks/base_sink.h>
@@ -51,6 +53,7 @@ public:
                      uint16_t max_files = 0,
                      const file_event_handlers &event_handlers = {})
         : base_filename_(std::move(base_filename)),
+          schedule_(std::chrono::hours(1), std::chrono::seconds(0)),
           file_helper_{event_handlers},
           truncate_(truncate),
           max_files_(max_files),
@@ -79,6 +82,8 @@ protected:
             if (remove_init_file_) {
                 file_helper_.close();
                 details::os::remove(file_helper_.filename());
+                (void)details::os::remove_if_exists(
+                    details::file_index::index_filename(file_helper_.filename()));
             }
             auto filename = FileNameCalc::calc_filename(base_filename_, now_tm(time));
             file_helper_.open(filename, truncate_);
@@ -87,6 +92,7 @@ protected:
         remove_init_file_ = false;
         memory_buf_t formatted;
         base_sink<Mutex>::formatter_->format(msg, formatted);
+        file_helper_.note_time(msg.time);
         file_helper_.write(formatted);
 
         // Do the cleaning only at the end because it might throw on failure.
@@ -99,14 +105,13 @@ protected:
 
 private:
     void init_filenames_q_() {
-        using details::os::path_exists;
-
         filenames_q_ = details::circular_q<filename_t>(static_cast<size_t>(max_files_));
         std::vector<filename_t> filenames;
+        details::dir_snapshot files;  // one listing instead of a stat per file
         auto now = log_clock::now();
         while (filenames.size() < max_files_) {
             auto filename = FileNameCalc::calc_filename(base_filename_, now_tm(now));
-            if (!path_exists(filename)) {
+            if (!files.exists(filename)) {
                 break;
             }
             filenames.emplace_back(filename);
@@ -117,22 +122,9 @@ private:
         }
     }
 
-    tm now_tm(log_clock::time_point tp) {
-        time_t tnow = log_clock::to_time_t(tp);
-        return spdlog::details::os::localtime(tnow);
-    }
+    tm now_tm(log_clock::time_point tp) { return details::rotation_schedule::local_tm(tp); }
 
-    log_clock::time_point next_rotation_tp_() {
-        auto now = log_clock::now();
-        tm date = now_tm(now);
-        date.tm_min = 0;
-        date.tm_sec = 0;
-        auto rotation_time = log_clock::from_time_t(std::mktime(&date));
-        if (rotation_time > now) {
-            return rotation_time;
-        }
-        return {rotation_time + std::chrono::hours(1)};
-    }
+    log_clock::time_point next_rotation_tp_() { return schedule_.next_after(log_clock::now()); }
 
     // Delete the file N rotations ago.
     // Throw spdlog_ex on failure to delete the old file.
@@ -145,6 +137,7 @@ private:
             auto old_filename = std::move(filenames_q_.front());
             filenames_q_.pop_front();
             bool ok = remove_if_exists(old_filename) == 0;
+            (void)remove_if_exists(details::file_index::index_filename(old_filename));
             if (!ok) {
                 filenames_q_.push_back(std::move(current_file));
                 SPDLOG_THROW(spdlog_ex(
@@ -155,6 +148,7 @@ private:
     }
 
     filename_t base_filename_;
+    details::rotation_schedule schedule_;
     log_clock::time_point rotation_tp_;
     details::file_helper file_helper_;
     bool truncate_;
@@ -166,6 +160,9 @@ private:
 using hourly_file_sink_mt = hourly_file_sink<std::mutex>;
 using hourly_file_sink_st = hourly_file_sink<details::null_mutex>;
 
+template <typename Mutex, typename FileNameCalc>
+struct shares_file<hourly_file_sink<Mutex, FileNameCalc>> : std::true_type {};
+
 }  // namespace sinks
 
 //
@@ -0,0 +1,420 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef _WIN32
+    #error journal_sink is not supported on windows
+#endif
+
+// Sink decorating a downstream sink with a persistent queue, for at-least-once delivery (e.g.
+// audit logs): the messages are appended to a journal file, a shared memory mapping used as a
+// ring buffer, and a background thread logs them to the downstream sink. Once a group of
+// messages is logged and the downstream sink flushed, the worker commits the offset of the
+// group in the journal, so that a sink reopening the journal after a crash (or after the
+// downstream sink failed) logs the messages not committed first.
+//
+// The messages are in the page cache as soon as they are appended, so they survive the
+// process. With sync (the default), the worker also writes each group and its commit back to
+// the disk with msync before and after logging it, so they survive the machine too; the
+// groups being all the messages appended since the previous one, the cost of msync is shared
+// by more messages as the load grows.
+//
+// A message may be logged more than once: the last group logged before a crash, or the group
+// the downstream sink threw on (logged again with exponential backoff). Logging blocks while
+// the journal is full of messages not committed, and messages bigger than half the journal
+// throw spdlog_ex. flush() waits until the messages logged before are committed, or the
+// downstream sink threw.
+//
+// Each record is a binary_formatter stream of its own, with a 16 bytes header (the offset of
+// the record, the size of the stream and their checksum), records from a previous turn of the
+// ring or written partially having a wrong offset or checksum.
+//
+// Usage example:
+// auto file = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/audit.log");
+// spdlog::sinks::journal_sink_config cfg("logs/audit.journal");
+// auto sink = std::make_shared<spdlog::sinks::journal_sink_mt>(file, cfg);
+
+#include <spdlog/binary_formatter.h>
+#include <spdlog/common.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace spdlog {
+namespace sinks {
+
+struct journal_sink_config {
+    filename_t filename;
+    // of the ring buffer, rounded up to a multiple of 8. an existing journal keeps its own.
+    size_t capacity = 64 * 1024 * 1024;
+    bool sync = true;  // msync the groups and their commits
+    std::chrono::milliseconds retry_min_delay{100};
+    std::chrono::milliseconds retry_max_delay{30000};
+
+    explicit journal_sink_config(filename_t journal_filename)
+        : filename{std::move(journal_filename)} {}
+};
+
+namespace details_journal {
+static const char magic[8] = {'S', 'P', 'D', 'J', 'R', 'N', 'L', '1'};
+static const size_t file_header_size = 4096;  // the records start on a page of their own
+
+struct file_header {
+    char magic[8];
+    std::uint64_t capacity;   // of the ring buffer, after the header
+    std::uint64_t committed;  // offset of the first message not logged downstream
+};
+
+// followed by the binary_formatter stream, and zeros up to a multiple of 8. a record with size
+// 0 pads the end of the ring buffer, as does the end of the ring buffer too small for a header.
+struct record_header {
+    std::uint64_t offset;  // of the record, since the journal was created
+    std::uint32_t size;    // of the stream
+    std::uint32_t checksum;
+};
+
+// 32 bit FNV-1a
+inline std::uint32_t checksum(const record_header &header, const char *data) {
+    std::uint32_t hash = 2166136261u;
+    auto add = [&hash](const char *bytes, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(bytes[i]);
+            hash *= 16777619u;
+        }
+    };
+    add(reinterpret_cast<const char *>(&header.offset), sizeof(header.offset));
+    add(reinterpret_cast<const char *>(&header.size), sizeof(header.size));
+    add(data, header.size);
+    return hash;
+}
+
+inline size_t align8(size_t size) { return (size + 7) & ~size_t(7); }
+}  // namespace details_journal
+
+template <typename Mutex>
+class journal_sink final : public base_sink<Mutex> {
+public:
+    // throw spdlog_ex if the file can't be opened, or is not a journal
+    journal_sink(std::shared_ptr<sink> downstream, journal_sink_config sink_config)
+        : downstream_{std::move(downstream)},
+          config_{std::move(sink_config)} {
+        if (!downstream_) {
+            throw_spdlog_ex("journal_sink: the downstream sink cannot be null");
+        }
+        open_();
+        // the journal keeps all the fields, the downstream sink formats
+        base_sink<Mutex>::set_own_fields_(msg_field::all, false);
+        worker_ = std::thread([this] { worker_loop_(); });
+    }
+
+    journal_sink(const journal_sink &) = delete;
+    journal_sink &operator=(const journal_sink &) = delete;
+
+    // log what is left to the downstream sink, unless it was failing (the next sink opening
+    // the journal will)
+    ~journal_sink() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        worker_.join();
+        ::munmap(base_, map_size_);
+        ::close(fd_);
+    }
+
+    std::shared_ptr<sink> downstream() const { return downstream_; }
+
+    // bytes of the journal used by the messages not committed yet
+    size_t pending_bytes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<size_t>(tail_ - committed_);
+    }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        using details_journal::record_header;
+        buf_.clear();
+        formatter_.reset();  // each record is a stream of its own
+        formatter_.format(msg, buf_);
+        auto length = details_journal::align8(sizeof(record_header) + buf_.size());
+        if (length > capacity_ / 2) {
+            throw_spdlog_ex("journal_sink: message too big for the journal");
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto room = static_cast<size_t>(capacity_ - tail_ % capacity_);
+            auto padding = room < length ? room : 0;
+            committed_cv_.wait(lock,
+                               [&] { return tail_ + padding + length - committed_ <= capacity_; });
+            if (padding > 0) {
+                if (padding >= sizeof(record_header)) {
+                    write_record_(tail_, nullptr, 0);
+                }
+                tail_ += padding;
+            }
+            write_record_(tail_, buf_.data(), buf_.size());
+            tail_ += length;
+        }
+        cv_.notify_one();
+    }
+
+    // wait for the worker to commit the messages logged so far, unless the downstream sink is
+    // failing
+    void flush_() override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto target = tail_;
+        committed_cv_.wait(lock, [&] { return committed_ >= target || failed_; });
+    }
+
+    void set_pattern_(const std::string &pattern) override { downstream_->set_pattern(pattern); }
+
+    void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        downstream_->set_formatter(std::move(sink_formatter));
+    }
+
+private:
+    using record_header = details_journal::record_header;
+
+    std::shared_ptr<sink> downstream_;
+    journal_sink_config config_;
+    int fd_ = -1;
+    char *base_ = nullptr;
+    size_t map_size_ = 0;
+    details_journal::file_header *header_ = nullptr;
+    char *data_ = nullptr;  // the ring buffer
+    std::uint64_t capacity_ = 0;
+    binary_formatter formatter_;
+    memory_buf_t buf_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;            // records appended, or stop_
+    std::condition_variable committed_cv_;  // records committed, or failed_
+    std::uint64_t tail_ = 0;                // offset of the next record
+    std::uint64_t committed_ = 0;
+    bool failed_ = false;  // the downstream sink threw at the last attempt
+    bool stop_ = false;
+    std::thread worker_;
+
+    void open_() {
+        using details_journal::file_header_size;
+        details::os::create_dir(details::os::dir_name(config_.filename));
+        fd_ = ::open(config_.filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        struct stat st;
+        if (fd_ < 0 || ::fstat(fd_, &st) != 0) {
+            fail_("failed opening journal file ");
+        }
+        bool created = st.st_size == 0;
+        if (created) {
+            capacity_ = details_journal::align8((std::max)(config_.capacity, size_t(4096)));
+            // allocated up front, so running out of disk space fails here and not with a SIGBUS
+            auto size = static_cast<off_t>(file_header_size + capacity_);
+            int rv = -1;
+#ifdef __linux__
+            rv = ::fallocate(fd_, 0, 0, size);
+#endif
+            if (rv != 0 && ::ftruncate(fd_, size) != 0) {
+                fail_("failed allocating journal file ");
+            }
+        } else if (static_cast<size_t>(st.st_size) <= file_header_size) {
+            fail_("not a journal file: ", false);
+        } else {
+            capacity_ = static_cast<std::uint64_t>(st.st_size) - file_header_size;
+        }
+        map_size_ = static_cast<size_t>(file_header_size + capacity_);
+        auto *ptr = ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (ptr == MAP_FAILED) {
+            fail_("failed mapping journal file ");
+        }
+        base_ = static_cast<char *>(ptr);
+        header_ = reinterpret_cast<details_journal::file_header *>(base_);
+        data_ = base_ + file_header_size;
+        if (created) {
+            std::memcpy(header_->magic, details_journal::magic, sizeof(header_->magic));
+            header_->capacity = capacity_;
+            header_->committed = 0;
+            sync_(base_, sizeof(details_journal::file_header));
+        } else if (std::memcmp(header_->magic, details_journal::magic, sizeof(header_->magic)) !=
+                       0 ||
+                   header_->capacity != capacity_) {
+            ::munmap(base_, map_size_);
+            fail_("not a journal file: ", false);
+        }
+        committed_ = header_->committed;
+        tail_ = recover_tail_();
+    }
+
+    [[noreturn]] void fail_(const char *what, bool with_errno = true) {
+        auto err = errno;
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        auto msg = "journal_sink: " + std::string(what) +
+                   details::os::filename_to_str(config_.filename);
+        if (with_errno) {
+            throw_spdlog_ex(msg, err);
+        }
+        throw_spdlog_ex(msg);
+    }
+
+    // after the last valid record following the commit
+    std::uint64_t recover_tail_() const {
+        auto tail = committed_;
+        auto pos = committed_;
+        string_view_t stream;
+        while (pos - committed_ < capacity_) {
+            auto length = record_at_(pos, stream);
+            if (length == 0 || pos + length - committed_ > capacity_) {
+                break;
+            }
+            pos += length;
+            if (stream.data() != nullptr) {
+                tail = pos;
+            }
+        }
+        return tail;
+    }
+
+    // the length of the record at pos, 0 if there is no valid record there. stream is null
+    // for the padding.
+    size_t record_at_(std::uint64_t pos, string_view_t &stream) const {
+        auto at = static_cast<size_t>(pos % capacity_);
+        auto room = static_cast<size_t>(capacity_) - at;
+        stream = string_view_t();
+        if (room < sizeof(record_header)) {
+            return room;
+        }
+        record_header header;
+        std::memcpy(&header, data_ + at, sizeof(header));
+        const char *data = data_ + at + sizeof(header);
+        if (header.offset != pos || header.size > room - sizeof(header) ||
+            header.checksum != details_journal::checksum(header, data)) {
+            return 0;
+        }
+        if (header.size == 0) {
+            return room;
+        }
+        stream = string_view_t(data, header.size);
+        return details_journal::align8(sizeof(header) + header.size);
+    }
+
+    // under mutex_. size 0 writes a padding record.
+    void write_record_(std::uint64_t pos, const char *data, size_t size) {
+        auto *dest = data_ + pos % capacity_;
+        record_header header{pos, static_cast<std::uint32_t>(size), 0};
+        if (size > 0) {
+            std::memcpy(dest + sizeof(header), data, size);
+            auto end = details_journal::align8(sizeof(header) + size);
+            std::memset(dest + sizeof(header) + size, 0, end - sizeof(header) - size);
+        }
+        header.checksum = details_journal::checksum(header, dest + sizeof(header));
+        std::memcpy(dest, &header, sizeof(header));
+    }
+
+    void sync_(const char *data, size_t size) {
+        if (!config_.sync || size == 0) {
+            return;
+        }
+        static const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        auto offset = static_cast<size_t>(data - base_);
+        auto start = offset / page_size * page_size;
+        ::msync(base_ + start, offset + size - start, MS_SYNC);
+    }
+
+    // the records from begin to end, written back in at most two ranges
+    void sync_records_(std::uint64_t begin, std::uint64_t end) {
+        auto at = static_cast<size_t>(begin % capacity_);
+        auto size = static_cast<size_t>(end - begin);
+        auto first = (std::min)(size, static_cast<size_t>(capacity_) - at);
+        sync_(data_ + at, first);
+        sync_(data_, size - first);
+    }
+
+    void worker_loop_() {
+        auto delay = config_.retry_min_delay;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || tail_ != committed_; });
+            if (tail_ == committed_) {
+                return;  // stopped
+            }
+            auto begin = committed_;
+            auto end = tail_;
+            auto stopping = stop_;
+            auto failed = failed_;
+            lock.unlock();
+            // no more attempts when stopping after a failure, the destructor shouldn't wait
+            bool logged = (!stopping || !failed) && log_group_(begin, end);
+            if (logged) {
+                header_->committed = end;
+                sync_(base_, sizeof(details_journal::file_header));
+            }
+            lock.lock();
+            if (logged) {
+                committed_ = end;
+                failed_ = false;
+                delay = config_.retry_min_delay;
+                committed_cv_.notify_all();
+                continue;
+            }
+            failed_ = true;
+            committed_cv_.notify_all();
+            if (stopping) {
+                return;
+            }
+            cv_.wait_for(lock, delay, [this] { return stop_; });
+            delay = (std::min)(delay * 2, config_.retry_max_delay);
+        }
+    }
+
+    // log the records from begin to end to the downstream sink, and flush it. false if it threw.
+    bool log_group_(std::uint64_t begin, std::uint64_t end) {
+        sync_records_(begin, end);
+        SPDLOG_TRY {
+            details::log_msg msg;
+            string_view_t stream;
+            for (auto pos = begin; pos < end;) {
+                auto length = record_at_(pos, stream);
+                if (length == 0) {
+                    break;  // changed by another process
+                }
+                pos += length;
+                if (stream.data() == nullptr) {
+                    continue;
+                }
+                binary_log_reader reader(stream);
+                if (reader.next(msg) && downstream_->should_log(msg)) {
+                    downstream_->log(msg);
+                }
+            }
+            downstream_->flush();
+            return true;
+        }
+        SPDLOG_CATCH_STD
+        return false;
+    }
+};
+
+using journal_sink_mt = journal_sink<std::mutex>;
+using journal_sink_st = journal_sink<details::null_mutex>;
+
+}  // namespace sinks
+}  // namespace spdlog
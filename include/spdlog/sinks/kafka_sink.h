@@ -9,14 +9,28 @@
 // For building librdkafka library check the url below
 // https://github.com/confluentinc/librdkafka
 //
+// The messages are queued by librdkafka, which sends them in batches (see linger_ms, batch_size
+// and compression in kafka_sink_config). The delivery reports are polled by a thread of the sink,
+// flush() only polls them without waiting, and the destructor waits up to flush_timeout_ms for
+// the messages queued to be delivered.
+//
 
 #include "spdlog/async.h"
 #include "spdlog/details/log_msg.h"
 #include "spdlog/details/null_mutex.h"
 #include "spdlog/details/synchronous_factory.h"
 #include "spdlog/sinks/base_sink.h"
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <spdlog/common.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifndef SPDLOG_NO_TLS
+    #include "spdlog/mdc.h"
+#endif
 
 // kafka header
 #include <librdkafka/rdkafkacpp.h>
@@ -24,10 +38,27 @@
 namespace spdlog {
 namespace sinks {
 
+// the partition key of the messages
+enum class kafka_key {
+    none,         // spread over the partitions by librdkafka
+    logger_name,  // the messages of each logger in the same partition
+    mdc           // the mdc value of key_mdc_name (of the logging thread: not with async loggers)
+};
+
 struct kafka_sink_config {
     std::string server_addr;
     std::string produce_topic;
     int32_t flush_timeout_ms = 1000;
+    kafka_key key = kafka_key::none;
+    std::string key_mdc_name;
+    // librdkafka batching, its default if not set
+    int linger_ms = -1;       // linger.ms: how long to wait for more messages to send a batch
+    int batch_size = -1;      // batch.size: max size of a batch, in bytes
+    std::string compression;  // compression.codec: none, gzip, snappy, lz4 or zstd
+    // other librdkafka global settings, set last
+    std::vector<std::pair<std::string, std::string>> properties;
+    // when the librdkafka queue is full, how long to poll for room before failing
+    int32_t queue_full_timeout_ms = 1000;
 
     kafka_sink_config(std::string addr, std::string topic, int flush_timeout_ms = 1000)
         : server_addr{std::move(addr)},
@@ -43,11 +74,21 @@ public:
         try {
             std::string errstr;
             conf_.reset(RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL));
-            RdKafka::Conf::ConfResult confRes =
-                conf_->set("bootstrap.servers", config_.server_addr, errstr);
-            if (confRes != RdKafka::Conf::CONF_OK) {
-                throw_spdlog_ex(
-                    fmt_lib::format("conf set bootstrap.servers failed err:{}", errstr));
+            set_(conf_.get(), "bootstrap.servers", config_.server_addr);
+            if (config_.linger_ms >= 0) {
+                set_(conf_.get(), "linger.ms", std::to_string(config_.linger_ms));
+            }
+            if (config_.batch_size >= 0) {
+                set_(conf_.get(), "batch.size", std::to_string(config_.batch_size));
+            }
+            if (!config_.compression.empty()) {
+                set_(conf_.get(), "compression.codec", config_.compression);
+            }
+            for (const auto &property : config_.properties) {
+                set_(conf_.get(), property.first, property.second);
+            }
+            if (conf_->set("dr_cb", &delivery_reports_, errstr) != RdKafka::Conf::CONF_OK) {
+                throw_spdlog_ex(fmt_lib::format("conf set dr_cb failed err:{}", errstr));
             }
 
             tconf_.reset(RdKafka::Conf::create(RdKafka::Conf::CONF_TOPIC));
@@ -67,24 +108,86 @@ public:
         } catch (const std::exception &e) {
             throw_spdlog_ex(fmt_lib::format("error create kafka instance: {}", e.what()));
         }
+        poller_ = std::thread([this] {
+            while (!stop_.load(std::memory_order_relaxed)) {
+                producer_->poll(100);
+            }
+        });
+    }
+
+    ~kafka_sink() {
+        stop_.store(true, std::memory_order_relaxed);
+        poller_.join();
+        producer_->flush(config_.flush_timeout_ms);
     }
 
-    ~kafka_sink() { producer_->flush(config_.flush_timeout_ms); }
+    // number of messages librdkafka failed to deliver
+    size_t delivery_failures() const { return delivery_reports_.failures.load(); }
 
 protected:
     void sink_it_(const details::log_msg &msg) override {
-        producer_->produce(topic_.get(), 0, RdKafka::Producer::RK_MSG_COPY,
-                           (void *)msg.payload.data(), msg.payload.size(), NULL, NULL);
+        auto key = key_(msg);
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(config_.queue_full_timeout_ms);
+        for (;;) {
+            auto err = producer_->produce(
+                topic_.get(), RdKafka::Topic::PARTITION_UA, RdKafka::Producer::RK_MSG_COPY,
+                const_cast<char *>(msg.payload.data()), msg.payload.size(),
+                key.size() > 0 ? key.data() : nullptr, key.size(), nullptr);
+            if (err == RdKafka::ERR_NO_ERROR) {
+                return;
+            }
+            if (err != RdKafka::ERR__QUEUE_FULL || std::chrono::steady_clock::now() >= deadline) {
+                throw_spdlog_ex(fmt_lib::format("kafka produce failed: {}", RdKafka::err2str(err)));
+            }
+            producer_->poll(10);  // room is made as the delivery reports are served
+        }
     }
 
-    void flush_() override { producer_->flush(config_.flush_timeout_ms); }
+    // the delivery reports are polled by the sink's thread: don't block here
+    void flush_() override { producer_->poll(0); }
 
 private:
+    struct delivery_report_counter : public RdKafka::DeliveryReportCb {
+        std::atomic<size_t> failures{0};
+        void dr_cb(RdKafka::Message &message) override {
+            if (message.err() != RdKafka::ERR_NO_ERROR) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    static void set_(RdKafka::Conf *conf, const std::string &name, const std::string &value) {
+        std::string errstr;
+        if (conf->set(name, value, errstr) != RdKafka::Conf::CONF_OK) {
+            throw_spdlog_ex(fmt_lib::format("conf set {} failed err:{}", name, errstr));
+        }
+    }
+
+    string_view_t key_(const details::log_msg &msg) const {
+        switch (config_.key) {
+            case kafka_key::logger_name:
+                return msg.logger_name;
+#ifndef SPDLOG_NO_TLS
+            case kafka_key::mdc: {
+                string_view_t value;
+                mdc::get_context().find(config_.key_mdc_name, value);
+                return value;
+            }
+#endif
+            default:
+                return string_view_t{};
+        }
+    }
+
     kafka_sink_config config_;
+    delivery_report_counter delivery_reports_;  // used by the producer: declared before it
     std::unique_ptr<RdKafka::Producer> producer_ = nullptr;
     std::unique_ptr<RdKafka::Conf> conf_ = nullptr;
     std::unique_ptr<RdKafka::Conf> tconf_ = nullptr;
     std::unique_ptr<RdKafka::Topic> topic_ = nullptr;
+    std::atomic<bool> stop_{false};
+    std::thread poller_;
 };
 
 using kafka_sink_mt = kafka_sink<std::mutex>;
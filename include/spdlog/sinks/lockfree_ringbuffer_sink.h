@@ -0,0 +1,180 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Ring buffer sink keeping the last n_items messages for post-mortem dumps, without locking and
+// without allocating: each message is copied into the next of the slots allocated up front
+// (the oldest one), its text (logger name, payload and thread name) cut to slot_size bytes.
+// Many threads can log concurrently: each one takes its slot with an atomic increment, and
+// the slot's sequence number tells the readers whether it was read while being written.
+//
+// last_raw() and last_formatted() return the last messages in the order they were logged,
+// each of them complete: a message overwritten while being read is left out. The formatting
+// is done there, so logging only costs the copy.
+//
+// Usage example:
+// auto ring = std::make_shared<spdlog::sinks::lockfree_ringbuffer_sink>(1024);
+// logger->sinks().push_back(ring);
+// ..
+// for (auto &line : ring->last_formatted()) { .. }
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+class lockfree_ringbuffer_sink final : public base_sink<details::null_mutex> {
+public:
+    explicit lockfree_ringbuffer_sink(size_t n_items, size_t slot_size = 256)
+        : n_items_(n_items),
+          slot_size_(slot_size),
+          seqs_(new std::atomic<std::uint64_t>[n_items == 0 ? 1 : n_items]),
+          headers_(n_items),
+          text_(n_items * slot_size) {
+        if (n_items == 0) {
+            throw_spdlog_ex("lockfree_ringbuffer_sink: n_items cannot be zero");
+        }
+        for (size_t i = 0; i < n_items_; i++) {
+            seqs_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<details::log_msg_buffer> last_raw(size_t lim = 0) {
+        std::vector<details::log_msg_buffer> ret;
+        read_(lim, [&ret](const details::log_msg &msg) { ret.emplace_back(msg); });
+        return ret;
+    }
+
+    std::vector<std::string> last_formatted(size_t lim = 0) {
+        std::vector<std::string> ret;
+        std::lock_guard<std::mutex> lock(formatter_mutex_);
+        read_(lim, [this, &ret](const details::log_msg &msg) {
+            memory_buf_t formatted;
+            formatter_->format(msg, formatted);
+            ret.push_back(SPDLOG_BUF_TO_STRING(formatted));
+        });
+        return ret;
+    }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        auto index = next_.fetch_add(1, std::memory_order_relaxed);
+        auto slot = static_cast<size_t>(index % n_items_);
+        auto &seq = seqs_[slot];
+
+        // odd while being written, 2 * index + 2 once written. two writers of the same slot
+        // (n_items messages apart) don't wait for each other: the second one drops its message.
+        auto writing = 2 * index + 1;
+        auto current = seq.load(std::memory_order_relaxed);
+        do {
+            if ((current & 1) != 0 || current >= writing) {
+                return;
+            }
+        } while (!seq.compare_exchange_weak(current, writing, std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto &header = headers_[slot];
+        auto *text = &text_[slot * slot_size_];
+        header.level = msg.level;
+        header.time = msg.time;
+        header.thread_id = msg.thread_id;
+        header.source = msg.source;
+        header.name_size = copy_(text, 0, msg.logger_name);
+        header.payload_size = copy_(text, header.name_size, msg.payload);
+        header.thread_name_size =
+            copy_(text, header.name_size + header.payload_size, msg.thread_name);
+
+        seq.store(writing + 1, std::memory_order_release);
+    }
+
+    void flush_() override {}
+
+    void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        std::lock_guard<std::mutex> lock(formatter_mutex_);
+        formatter_ = std::move(sink_formatter);
+    }
+
+private:
+    struct slot_header {
+        level::level_enum level{level::off};
+        log_clock::time_point time;
+        size_t thread_id{0};
+        source_loc source;
+        size_t name_size{0};
+        size_t thread_name_size{0};
+        size_t payload_size{0};
+    };
+
+    size_t n_items_;
+    size_t slot_size_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> seqs_;
+    std::vector<slot_header> headers_;
+    std::vector<char> text_;  // slot_size bytes for each slot
+    std::atomic<std::uint64_t> next_{0};
+    std::mutex formatter_mutex_;  // the readers format, and can race with set_formatter()
+
+    // copy what fits of src at text + offset
+    size_t copy_(char *text, size_t offset, string_view_t src) const {
+        auto n = (std::min)(src.size(), slot_size_ - offset);
+        if (n > 0) {
+            std::memcpy(text + offset, src.data(), n);
+        }
+        return n;
+    }
+
+    // call f(const log_msg &) for each of the last lim (all if 0) messages completely written,
+    // oldest first
+    template <typename F>
+    void read_(size_t lim, F f) {
+        auto end = next_.load(std::memory_order_acquire);
+        auto count = (std::min)(end, static_cast<std::uint64_t>(n_items_));
+        if (lim > 0) {
+            count = (std::min)(count, static_cast<std::uint64_t>(lim));
+        }
+        std::vector<char> text(slot_size_);
+        for (auto index = end - count; index < end; index++) {
+            auto slot = static_cast<size_t>(index % n_items_);
+            auto &seq = seqs_[slot];
+            auto written = 2 * index + 2;
+            if (seq.load(std::memory_order_acquire) != written) {
+                continue;  // not written yet, or overwritten by a newer one
+            }
+            auto header = headers_[slot];
+            auto size = (std::min)(header.name_size + header.thread_name_size +
+                                       header.payload_size,
+                                   slot_size_);
+            std::memcpy(text.data(), &text_[slot * slot_size_], size);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) != written) {
+                continue;  // overwritten while being copied
+            }
+
+            details::log_msg msg;
+            msg.level = header.level;
+            msg.time = header.time;
+            msg.thread_id = header.thread_id;
+            msg.source = header.source;
+            msg.logger_name = string_view_t{text.data(), header.name_size};
+            msg.payload = string_view_t{text.data() + header.name_size, header.payload_size};
+            msg.thread_name = string_view_t{text.data() + header.name_size + header.payload_size,
+                                            header.thread_name_size};
+            f(msg);
+        }
+    }
+};
+
+}  // namespace sinks
+}  // namespace spdlog
@@ -0,0 +1,279 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef _WIN32
+    #error mmap_file_sink is not supported on windows
+#endif
+
+// File sink copying the formatted messages straight into a shared memory mapping of the file,
+// so logging does no system call except when moving to the next window of the file. The file
+// is allocated max_size bytes up front (with fallocate on linux, so running out of disk space
+// fails when opening the file and not with a SIGBUS later) and is rotated like the
+// rotating_file_sink when full:
+// log.txt -> log.1.txt
+// log.1.txt -> log.2.txt
+// ..
+//
+// The data is in the page cache as soon as it's copied, so the kernel writes it back even if
+// the process crashes, and readers see it without flush(). The file is truncated to the data
+// when rotated or closed. If the process dies before that, the file ends with zeros up to
+// max_size; the sink skips them when reopening the file and appends after the last message.
+//
+// Usage example:
+// auto logger = spdlog::mmap_logger_mt("mmap_logger", "logs/mmap.txt", 64 * 1024 * 1024, 3);
+
+#include <spdlog/common.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class mmap_file_sink final : public base_sink<Mutex> {
+public:
+    // max_size is rounded up to a multiple of window_size, itself rounded up to the page size
+    mmap_file_sink(filename_t base_filename,
+                   size_t max_size,
+                   size_t max_files,
+                   size_t window_size = 1024 * 1024)
+        : base_filename_(std::move(base_filename)),
+          max_files_(max_files) {
+        if (max_size == 0) {
+            throw_spdlog_ex("mmap sink constructor: max_size arg cannot be zero");
+        }
+        if (max_files > 200000) {
+            throw_spdlog_ex("mmap sink constructor: max_files arg cannot exceed 200000");
+        }
+        auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        window_size_ = round_up_((std::max)(window_size, page_size), page_size);
+        max_size_ = round_up_(max_size, window_size_);
+        open_(false);
+        base_sink<Mutex>::set_own_fields_(msg_field::none);
+    }
+
+    mmap_file_sink(const mmap_file_sink &) = delete;
+    mmap_file_sink &operator=(const mmap_file_sink &) = delete;
+
+    ~mmap_file_sink() override {
+        SPDLOG_TRY { close_(); }
+        SPDLOG_CATCH_STD
+    }
+
+    filename_t filename() {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        return rotating_file_sink<details::null_mutex>::calc_filename(base_filename_, 0);
+    }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        memory_buf_t formatted;
+        base_sink<Mutex>::formatter_->format(msg, formatted);
+        auto data = formatted.data();
+        auto size = formatted.size();
+        if (used_ + size > max_size_ && used_ > 0) {
+            rotate_();
+        }
+        // a message bigger than max_size goes alone in a file growing as needed
+        while (size > 0) {
+            if (window_ == nullptr || used_ == window_offset_ + window_size_) {
+                map_window_();
+            }
+            auto pos = static_cast<size_t>(used_ - window_offset_);
+            auto n = (std::min)(size, window_size_ - pos);
+            std::memcpy(window_ + pos, data, n);
+            data += n;
+            size -= n;
+            used_ += n;
+        }
+    }
+
+    // nothing to do for the data to be visible to readers and written back by the kernel
+    void flush_() override {}
+
+private:
+    filename_t base_filename_;
+    size_t max_files_;
+    size_t window_size_ = 0;
+    size_t max_size_ = 0;
+    int fd_ = -1;
+    char *window_ = nullptr;
+    size_t window_offset_ = 0;  // in the file
+    size_t used_ = 0;           // size of the data written in the file
+    size_t allocated_ = 0;      // size of the file
+
+    static size_t round_up_(size_t value, size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    filename_t current_filename_() const {
+        return rotating_file_sink<details::null_mutex>::calc_filename(base_filename_, 0);
+    }
+
+    void open_(bool truncate) {
+        auto filename = current_filename_();
+        details::os::create_dir(details::os::dir_name(filename));
+        int flags = O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0);
+        fd_ = ::open(filename.c_str(), flags, 0644);
+        struct stat st;
+        if (fd_ < 0 || ::fstat(fd_, &st) != 0) {
+            auto err = errno;
+            if (fd_ >= 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+            throw_spdlog_ex("Failed opening file " + filename + " for writing", err);
+        }
+        allocated_ = static_cast<size_t>(st.st_size);
+        used_ = data_size_();
+        window_offset_ = 0;
+        if (used_ < max_size_) {
+            allocate_(max_size_);
+        }
+    }
+
+    // size of the file without the zeros left after the data if it wasn't closed properly
+    size_t data_size_() {
+        char chunk[4096];
+        auto end = allocated_;
+        while (end > 0) {
+            auto n = (std::min)(end, sizeof(chunk));
+            auto offset = end - n;
+            if (::pread(fd_, chunk, n, static_cast<off_t>(offset)) != static_cast<ssize_t>(n)) {
+                throw_spdlog_ex("Failed reading file " + current_filename_(), errno);
+            }
+            while (n > 0 && chunk[n - 1] == '\0') {
+                n--;
+            }
+            if (n > 0) {
+                return offset + n;
+            }
+            end = offset;
+        }
+        return 0;
+    }
+
+    void allocate_(size_t size) {
+        if (size <= allocated_) {
+            return;
+        }
+        int rv = -1;
+#ifdef __linux__
+        rv = ::fallocate(fd_, 0, 0, static_cast<off_t>(size));
+#endif
+        if (rv != 0 && ::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            throw_spdlog_ex("Failed allocating file " + current_filename_(), errno);
+        }
+        allocated_ = size;
+    }
+
+    void unmap_window_() {
+        if (window_ != nullptr) {
+            ::munmap(window_, window_size_);
+            window_ = nullptr;
+        }
+    }
+
+    // map the window containing used_
+    void map_window_() {
+        unmap_window_();
+        window_offset_ = used_ / window_size_ * window_size_;
+        allocate_(window_offset_ + window_size_);
+        auto *ptr = ::mmap(nullptr, window_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                           static_cast<off_t>(window_offset_));
+        if (ptr == MAP_FAILED) {
+            throw_spdlog_ex("Failed mapping file " + current_filename_(), errno);
+        }
+        window_ = static_cast<char *>(ptr);
+    }
+
+    // unmap the file and cut the allocated space after the data
+    void close_() {
+        if (fd_ < 0) {
+            return;
+        }
+        unmap_window_();
+        auto rv = allocated_ > used_ ? ::ftruncate(fd_, static_cast<off_t>(used_)) : 0;
+        auto err = errno;
+        ::close(fd_);
+        fd_ = -1;
+        if (rv != 0) {
+            throw_spdlog_ex("Failed truncating file " + current_filename_(), err);
+        }
+    }
+
+    void rotate_() {
+        using details::os::filename_to_str;
+        using rotating = rotating_file_sink<details::null_mutex>;
+
+        close_();
+        for (auto i = max_files_; i > 0; --i) {
+            filename_t src = rotating::calc_filename(base_filename_, i - 1);
+            if (!details::os::path_exists(src)) {
+                continue;
+            }
+            filename_t target = rotating::calc_filename(base_filename_, i);
+            (void)details::os::remove(target);
+            if (details::os::rename(src, target) != 0) {
+                auto err = errno;
+                open_(true);  // truncate the log file anyway so it doesn't grow past its limit
+                throw_spdlog_ex(
+                    "mmap_file_sink: failed renaming " + filename_to_str(src) + " to " +
+                        filename_to_str(target),
+                    err);
+            }
+        }
+        open_(true);
+    }
+};
+
+using mmap_file_sink_mt = mmap_file_sink<std::mutex>;
+using mmap_file_sink_st = mmap_file_sink<details::null_mutex>;
+
+template <typename Mutex>
+struct shares_file<mmap_file_sink<Mutex>> : std::true_type {};
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> mmap_logger_mt(const std::string &logger_name,
+                                              const filename_t &filename,
+                                              size_t max_file_size,
+                                              size_t max_files,
+                                              size_t window_size = 1024 * 1024) {
+    return Factory::template create<sinks::mmap_file_sink_mt>(logger_name, filename,
+                                                              max_file_size, max_files,
+                                                              window_size);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> mmap_logger_st(const std::string &logger_name,
+                                              const filename_t &filename,
+                                              size_t max_file_size,
+                                              size_t max_files,
+                                              size_t window_size = 1024 * 1024) {
+    return Factory::template create<sinks::mmap_file_sink_st>(logger_name, filename,
+                                                              max_file_size, max_files,
+                                                              window_size);
+}
+
+}  // namespace spdlog
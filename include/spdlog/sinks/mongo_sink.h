@@ -9,29 +9,47 @@
 // For building mongocxx library check the url below
 // http://mongocxx.org/mongocxx-v3/installation/
 //
+// With mongo_batch_options, the documents are buffered and inserted with one unordered
+// insert_many() once max_documents or max_bytes are reached, on flush(), or when the oldest
+// one waited max_delay (checked when logging: use spdlog::flush_every() for a bound when idle).
+//
 
 #include "spdlog/common.h"
 #include "spdlog/details/log_msg.h"
 #include "spdlog/sinks/base_sink.h"
 #include <spdlog/details/synchronous_factory.h>
 
-#include <bsoncxx/builder/stream/document.hpp>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
 #include <bsoncxx/types.hpp>
 #include <bsoncxx/view_or_value.hpp>
 
 #include <mongocxx/client.hpp>
+#include <mongocxx/collection.hpp>
 #include <mongocxx/instance.hpp>
+#include <mongocxx/options/insert.hpp>
 #include <mongocxx/uri.hpp>
 
+#include <chrono>
+#include <vector>
+
 namespace spdlog {
 namespace sinks {
+
+struct mongo_batch_options {
+    size_t max_documents = 1;                  // 1: insert each document when logged
+    size_t max_bytes = 8 * 1024 * 1024;        // of the documents buffered
+    std::chrono::milliseconds max_delay{1000};  // for the oldest document buffered
+};
+
 template <typename Mutex>
 class mongo_sink : public base_sink<Mutex> {
 public:
     mongo_sink(const std::string &db_name,
                const std::string &collection_name,
-               const std::string &uri = "mongodb://localhost:27017") try
-        : mongo_sink(std::make_shared<mongocxx::instance>(), db_name, collection_name, uri) {
+               const std::string &uri = "mongodb://localhost:27017",
+               mongo_batch_options batch = {}) try
+        : mongo_sink(std::make_shared<mongocxx::instance>(), db_name, collection_name, uri, batch) {
     } catch (const std::exception &e) {
         throw_spdlog_ex(fmt_lib::format("Error opening database: {}", e.what()));
     }
@@ -39,43 +57,83 @@ public:
     mongo_sink(std::shared_ptr<mongocxx::instance> instance,
                const std::string &db_name,
                const std::string &collection_name,
-               const std::string &uri = "mongodb://localhost:27017")
+               const std::string &uri = "mongodb://localhost:27017",
+               mongo_batch_options batch = {})
         : instance_(std::move(instance)),
           db_name_(db_name),
-          coll_name_(collection_name) {
+          coll_name_(collection_name),
+          batch_(batch) {
         try {
             client_ = spdlog::details::make_unique<mongocxx::client>(mongocxx::uri{uri});
+            coll_ = client_->database(db_name_).collection(coll_name_);
         } catch (const std::exception &e) {
             throw_spdlog_ex(fmt_lib::format("Error opening database: {}", e.what()));
         }
+        docs_.reserve(batch_.max_documents);
+        insert_options_.ordered(false);
     }
 
-    ~mongo_sink() { flush_(); }
+    ~mongo_sink() {
+        SPDLOG_TRY { flush_(); }
+        SPDLOG_CATCH_STD
+    }
 
 protected:
     void sink_it_(const details::log_msg &msg) override {
-        using bsoncxx::builder::stream::document;
-        using bsoncxx::builder::stream::finalize;
-
-        if (client_ != nullptr) {
-            auto doc = document{} << "timestamp" << bsoncxx::types::b_date(msg.time) << "level"
-                                  << level::to_string_view(msg.level).data() << "level_num"
-                                  << msg.level << "message"
-                                  << std::string(msg.payload.begin(), msg.payload.end())
-                                  << "logger_name"
-                                  << std::string(msg.logger_name.begin(), msg.logger_name.end())
-                                  << "thread_id" << static_cast<int>(msg.thread_id) << finalize;
-            client_->database(db_name_).collection(coll_name_).insert_one(doc.view());
+        using bsoncxx::builder::basic::kvp;
+
+        if (client_ == nullptr) {
+            return;
+        }
+        builder_.append(kvp("timestamp", bsoncxx::types::b_date(msg.time)),
+                        kvp("level", bsoncxx::stdx::string_view(
+                                         level::to_string_view(msg.level).data(),
+                                         level::to_string_view(msg.level).size())),
+                        kvp("level_num", static_cast<int>(msg.level)),
+                        kvp("message", bsoncxx::stdx::string_view(msg.payload.data(),
+                                                                  msg.payload.size())),
+                        kvp("logger_name", bsoncxx::stdx::string_view(msg.logger_name.data(),
+                                                                      msg.logger_name.size())),
+                        kvp("thread_id", static_cast<int>(msg.thread_id)));
+        if (docs_.empty()) {
+            oldest_ = msg.time;
+        }
+        docs_.push_back(builder_.extract());  // the builder starts over, for the next message
+        bytes_ += docs_.back().view().length();
+        if (docs_.size() >= batch_.max_documents || bytes_ >= batch_.max_bytes ||
+            msg.time - oldest_ >= batch_.max_delay) {
+            flush_();
         }
     }
 
-    void flush_() override {}
+    void flush_() override {
+        if (docs_.empty()) {
+            return;
+        }
+        // dropped even if the insertion fails, so a failing server doesn't grow the buffer
+        std::vector<bsoncxx::document::value> docs;
+        docs.swap(docs_);
+        docs_.reserve(batch_.max_documents);
+        bytes_ = 0;
+        if (docs.size() == 1) {
+            coll_.insert_one(docs.front().view());
+        } else {
+            coll_.insert_many(docs, insert_options_);
+        }
+    }
 
 private:
     std::shared_ptr<mongocxx::instance> instance_;
     std::string db_name_;
     std::string coll_name_;
+    mongo_batch_options batch_;
     std::unique_ptr<mongocxx::client> client_ = nullptr;
+    mongocxx::collection coll_;
+    mongocxx::options::insert insert_options_;
+    bsoncxx::builder::basic::document builder_;
+    std::vector<bsoncxx::document::value> docs_;  // waiting to be inserted
+    size_t bytes_ = 0;
+    log_clock::time_point oldest_;
 };
 
 #include "spdlog/details/null_mutex.h"
@@ -90,9 +148,10 @@ inline std::shared_ptr<logger> mongo_logger_mt(
     const std::string &logger_name,
     const std::string &db_name,
     const std::string &collection_name,
-    const std::string &uri = "mongodb://localhost:27017") {
+    const std::string &uri = "mongodb://localhost:27017",
+    sinks::mongo_batch_options batch = {}) {
     return Factory::template create<sinks::mongo_sink_mt>(logger_name, db_name, collection_name,
-                                                          uri);
+                                                          uri, batch);
 }
 
 template <typename Factory = spdlog::synchronous_factory>
@@ -100,9 +159,10 @@ inline std::shared_ptr<logger> mongo_logger_st(
     const std::string &logger_name,
     const std::string &db_name,
     const std::string &collection_name,
-    const std::string &uri = "mongodb://localhost:27017") {
+    const std::string &uri = "mongodb://localhost:27017",
+    sinks::mongo_batch_options batch = {}) {
     return Factory::template create<sinks::mongo_sink_st>(logger_name, db_name, collection_name,
-                                                          uri);
+                                                          uri, batch);
 }
 
 }  // namespace spdlog
@@ -26,10 +26,16 @@ namespace spdlog {
 namespace sinks {
 /*
  * MSVC sink (logging using OutputDebugStringA)
+ *
+ * A batch of messages (e.g. from an async logger) is output with as few OutputDebugString calls as
+ * possible, each a round trip to the debugger: up to max_chunk_size bytes of messages per call
+ * (the size a DBWIN listener such as DebugView takes at once).
  */
 template <typename Mutex>
 class msvc_sink : public base_sink<Mutex> {
 public:
+    static constexpr size_t max_chunk_size = 4095;
+
     msvc_sink() = default;
     msvc_sink(bool check_debugger_present)
         : check_debugger_present_{check_debugger_present} {}
@@ -42,12 +48,44 @@ protected:
         memory_buf_t formatted;
         base_sink<Mutex>::formatter_->format(msg, formatted);
         formatted.push_back('\0');  // add a null terminator for OutputDebugString
+        output_(formatted.data(), formatted.size() - 1);
+    }
+
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        if (check_debugger_present_ && !IsDebuggerPresent()) {
+            return;
+        }
+        memory_buf_t formatted;
+        size_t chunk_start = 0;
+        base_sink<Mutex>::format_batch_(
+            msgs, count, formatted,
+            [&](size_t start) {
+                // output the messages before this one if it makes the chunk too big
+                if (start > chunk_start && formatted.size() - chunk_start > max_chunk_size) {
+                    auto saved = formatted[start];
+                    formatted[start] = '\0';
+                    output_(formatted.data() + chunk_start, start - chunk_start);
+                    formatted[start] = saved;
+                    chunk_start = start;
+                }
+            },
+            [&] {
+                if (formatted.size() > chunk_start) {
+                    formatted.push_back('\0');
+                    output_(formatted.data() + chunk_start, formatted.size() - 1 - chunk_start);
+                }
+            });
+    }
+
+    // data[size] must be '\0'
+    void output_(const char *data, size_t size) {
     #if defined(SPDLOG_WCHAR_TO_UTF8_SUPPORT)
         wmemory_buf_t wformatted;
-        details::os::utf8_to_wstrbuf(string_view_t(formatted.data(), formatted.size()), wformatted);
+        details::os::utf8_to_wstrbuf(string_view_t(data, size + 1), wformatted);
         OutputDebugStringW(wformatted.data());
     #else
-        OutputDebugStringA(formatted.data());
+        (void)size;
+        OutputDebugStringA(data);
     #endif
     }
 
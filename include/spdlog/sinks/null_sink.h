@@ -14,6 +14,9 @@ namespace sinks {
 
 template <typename Mutex>
 class null_sink : public base_sink<Mutex> {
+public:
+    null_sink() { this->set_own_fields_(msg_field::none, false); }
+
 protected:
     void sink_it_(const details::log_msg &) override {}
     void flush_() override {}
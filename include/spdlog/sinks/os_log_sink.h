@@ -0,0 +1,119 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef __APPLE__
+
+    #include <spdlog/details/fmt_helper.h>
+    #include <spdlog/details/null_mutex.h>
+    #include <spdlog/details/synchronous_factory.h>
+    #include <spdlog/sinks/base_sink.h>
+
+    #include <os/log.h>
+
+    #include <mutex>
+    #include <string>
+    #include <unordered_map>
+
+namespace spdlog {
+namespace sinks {
+
+/*
+ * Sink writing to Apple's unified logging system (Console.app, `log stream`) with os_log.
+ *
+ * The messages are logged under the given subsystem, with the name of their logger as the
+ * category: the os_log_t of each logger is created on its first message and kept (the system
+ * never frees them either). Unified logging records the time, the process and the thread
+ * itself, so only the payload is passed by default (enable_formatting to pass the formatted
+ * message instead), with the static "%{public}s" format so that it isn't redacted.
+ * The levels map to the os_log types: trace and debug to debug, info to info, warn to default,
+ * err to error and critical to fault. A message of a type the system doesn't record (e.g. debug
+ * by default) isn't formatted.
+ */
+template <typename Mutex>
+class os_log_sink final : public base_sink<Mutex> {
+public:
+    explicit os_log_sink(std::string subsystem = "spdlog", bool enable_formatting = false)
+        : subsystem_(std::move(subsystem)),
+          enable_formatting_(enable_formatting) {
+        base_sink<Mutex>::set_own_fields_(msg_field::none, enable_formatting_);
+    }
+
+    os_log_sink(const os_log_sink &) = delete;
+    os_log_sink &operator=(const os_log_sink &) = delete;
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        os_log_t log = log_of_(msg.logger_name);
+        os_log_type_t type = convert_to_os_log_(msg.level);
+        if (!os_log_type_enabled(log, type)) {
+            return;
+        }
+        formatted_.clear();
+        if (enable_formatting_) {
+            base_sink<Mutex>::formatter_->format(msg, formatted_);
+        } else {
+            details::fmt_helper::append_string_view(msg.payload, formatted_);
+        }
+        formatted_.push_back('\0');
+        os_log_with_type(log, type, "%{public}s", formatted_.data());
+    }
+
+    void flush_() override {}
+
+private:
+    os_log_t log_of_(string_view_t logger_name) {
+        name_.assign(logger_name.data(), logger_name.size());  // keeps its capacity
+        auto it = logs_.find(name_);
+        if (it == logs_.end()) {
+            it = logs_.emplace(name_, os_log_create(subsystem_.c_str(), name_.c_str())).first;
+        }
+        return it->second;
+    }
+
+    static os_log_type_t convert_to_os_log_(spdlog::level::level_enum level) {
+        switch (level) {
+            case spdlog::level::trace:
+            case spdlog::level::debug:
+                return OS_LOG_TYPE_DEBUG;
+            case spdlog::level::info:
+                return OS_LOG_TYPE_INFO;
+            case spdlog::level::err:
+                return OS_LOG_TYPE_ERROR;
+            case spdlog::level::critical:
+                return OS_LOG_TYPE_FAULT;
+            default:
+                return OS_LOG_TYPE_DEFAULT;
+        }
+    }
+
+    std::string subsystem_;
+    bool enable_formatting_;
+    std::unordered_map<std::string, os_log_t> logs_;  // by logger name
+    std::string name_;                                // the lookup key
+    memory_buf_t formatted_;  // reused from one message to the next (under the sink's lock)
+};
+
+using os_log_sink_mt = os_log_sink<std::mutex>;
+using os_log_sink_st = os_log_sink<details::null_mutex>;
+
+}  // namespace sinks
+
+// Create and register os_log logger
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> os_log_logger_mt(const std::string &logger_name,
+                                                const std::string &subsystem = "spdlog") {
+    return Factory::template create<sinks::os_log_sink_mt>(logger_name, subsystem);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> os_log_logger_st(const std::string &logger_name,
+                                                const std::string &subsystem = "spdlog") {
+    return Factory::template create<sinks::os_log_sink_st>(logger_name, subsystem);
+}
+
+}  // namespace spdlog
+
+#endif  // __APPLE__
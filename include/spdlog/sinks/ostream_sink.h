@@ -16,7 +16,9 @@ class ostream_sink final : public base_sink<Mutex> {
 public:
     explicit ostream_sink(std::ostream &os, bool force_flush = false)
         : ostream_(os),
-          force_flush_(force_flush) {}
+          force_flush_(force_flush) {
+        base_sink<Mutex>::set_own_fields_(msg_field::none);
+    }
     ostream_sink(const ostream_sink &) = delete;
     ostream_sink &operator=(const ostream_sink &) = delete;
 
@@ -0,0 +1,811 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Sink exporting the messages to an OpenTelemetry collector with OTLP/HTTP (POST /v1/logs), in
+// protobuf or json. The messages are encoded as OTLP log records when logged, and batched: a
+// background thread sends a batch once it reaches max_batch_records or max_batch_bytes, or
+// max_delay after its first record, over a kept alive connection, optionally gzip compressed.
+//
+// Each logger is an instrumentation scope. The records hold the time (as the time and the
+// observed time), the severity, the payload as body (or the output of set_pattern() /
+// set_formatter()), and the attributes thread.id, thread.name, code.filepath, code.lineno,
+// code.function, the mdc entries of the thread (as strings) and the kv fields of the message
+// (see kv.h, with their type).
+//
+// Batches the collector couldn't take (connection errors, 429, 502, 503 and 504 responses) are
+// sent again with exponential backoff, the others are dropped. When max_queued_records are
+// waiting, the new records are dropped (see dropped()). Only plain http is supported: use a
+// collector (or proxy) on the local host or network for tls.
+//
+// Usage example:
+// spdlog::sinks::otlp_http_sink_config cfg("localhost");
+// cfg.service_name = "myapp";
+// cfg.gzip = true;  // needs SPDLOG_ZLIB
+// auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+
+#include <spdlog/common.h>
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/json_escape.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/mdc.h>
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/sinks/base_sink.h>
+#ifdef _WIN32
+    #include <spdlog/details/tcp_client-windows.h>
+#else
+    #include <spdlog/details/tcp_client.h>
+    #include <sys/time.h>
+#endif
+#ifdef SPDLOG_ZLIB
+    #include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+enum class otlp_encoding { protobuf, json };
+
+struct otlp_http_sink_config {
+    std::string host;
+    int port;
+    std::string path = "/v1/logs";
+    otlp_encoding encoding = otlp_encoding::protobuf;
+    bool gzip = false;         // compress the requests (needs SPDLOG_ZLIB)
+    std::string service_name;  // the service.name resource attribute, if not empty
+    std::vector<std::pair<std::string, std::string>> headers;  // added to the requests
+    size_t max_batch_records = 512;
+    size_t max_batch_bytes = 1024 * 1024;  // of the encoded records
+    std::chrono::milliseconds max_delay{1000};  // before sending a batch not full
+    size_t max_queued_records = 16384;          // waiting to be sent, the others are dropped
+    std::chrono::milliseconds reconnect_min_delay{100};
+    std::chrono::milliseconds reconnect_max_delay{30000};
+    std::chrono::milliseconds timeout{10000};  // of the sends and of the responses
+
+    explicit otlp_http_sink_config(std::string collector_host, int collector_port = 4318)
+        : host{std::move(collector_host)},
+          port{collector_port} {}
+};
+
+namespace details_otlp {
+// OTLP severity numbers and texts of the spdlog levels
+inline int severity_number(level::level_enum lvl) {
+    static const int numbers[] = {1, 5, 9, 13, 17, 21, 0};
+    return numbers[static_cast<size_t>(lvl)];
+}
+
+inline string_view_t severity_text(level::level_enum lvl) {
+    static const string_view_t texts[] = {"TRACE", "DEBUG", "INFO", "WARN",
+                                          "ERROR", "FATAL", ""};
+    return texts[static_cast<size_t>(lvl)];
+}
+
+//
+// protobuf encoding
+//
+enum : unsigned { wire_varint = 0, wire_fixed64 = 1, wire_len = 2 };
+
+inline size_t varint_size(std::uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+inline void append_varint(std::uint64_t value, std::string &dest) {
+    while (value >= 0x80) {
+        dest.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    dest.push_back(static_cast<char>(value));
+}
+
+inline void append_tag(unsigned field, unsigned wire_type, std::string &dest) {
+    append_varint((field << 3) | wire_type, dest);
+}
+
+inline void append_fixed64(unsigned field, std::uint64_t value, std::string &dest) {
+    append_tag(field, wire_fixed64, dest);
+    for (int i = 0; i < 8; i++) {
+        dest.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+// tag and size of a length delimited field (string or message) of field < 16
+inline size_t len_field_size(size_t size) { return 1 + varint_size(size) + size; }
+
+inline void append_len(unsigned field, size_t size, std::string &dest) {
+    append_tag(field, wire_len, dest);
+    append_varint(size, dest);
+}
+
+inline void append_bytes(unsigned field, string_view_t value, std::string &dest) {
+    append_len(field, value.size(), dest);
+    dest.append(value.data(), value.size());
+}
+
+// KeyValue{key = 1, value = 2: AnyValue{string_value = 1}} as field
+inline void append_string_attribute(unsigned field,
+                                    string_view_t key,
+                                    string_view_t value,
+                                    std::string &dest) {
+    append_len(field, len_field_size(key.size()) + len_field_size(len_field_size(value.size())),
+               dest);
+    append_bytes(1, key, dest);
+    append_len(2, len_field_size(value.size()), dest);
+    append_bytes(1, value, dest);
+}
+
+// KeyValue{key = 1, value = 2: AnyValue{int_value = 3}} as field
+inline void append_int_attribute(unsigned field,
+                                 string_view_t key,
+                                 std::int64_t value,
+                                 std::string &dest) {
+    auto bits = static_cast<std::uint64_t>(value);
+    append_len(field, len_field_size(key.size()) + len_field_size(1 + varint_size(bits)), dest);
+    append_bytes(1, key, dest);
+    append_len(2, 1 + varint_size(bits), dest);
+    append_tag(3, wire_varint, dest);
+    append_varint(bits, dest);
+}
+
+// KeyValue{key = 1, value = 2: AnyValue{bool_value = 2 | double_value = 4}} as field
+inline void append_bool_attribute(unsigned field,
+                                  string_view_t key,
+                                  bool value,
+                                  std::string &dest) {
+    append_len(field, len_field_size(key.size()) + len_field_size(2), dest);
+    append_bytes(1, key, dest);
+    append_len(2, 2, dest);
+    append_tag(2, wire_varint, dest);
+    append_varint(value ? 1 : 0, dest);
+}
+
+inline void append_double_attribute(unsigned field,
+                                    string_view_t key,
+                                    double value,
+                                    std::string &dest) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    append_len(field, len_field_size(key.size()) + len_field_size(9), dest);
+    append_bytes(1, key, dest);
+    append_len(2, 9, dest);
+    append_fixed64(4, bits, dest);
+}
+
+// a kv field (see kv.h) with its type. the uint64 too big for int_value are strings
+inline void append_kv_attribute(unsigned field, const kv_field &kv, std::string &dest) {
+    switch (kv.type) {
+        case kv_type::string:
+            append_string_attribute(field, kv.key, kv.string_value, dest);
+            break;
+        case kv_type::int64:
+            append_int_attribute(field, kv.key, kv.int_value, dest);
+            break;
+        case kv_type::uint64:
+            if (kv.uint_value <= static_cast<std::uint64_t>(INT64_MAX)) {
+                append_int_attribute(field, kv.key, static_cast<std::int64_t>(kv.uint_value),
+                                     dest);
+            } else {
+                append_string_attribute(field, kv.key, std::to_string(kv.uint_value), dest);
+            }
+            break;
+        case kv_type::float64:
+            append_double_attribute(field, kv.key, kv.float_value, dest);
+            break;
+        case kv_type::boolean:
+            append_bool_attribute(field, kv.key, kv.bool_value, dest);
+            break;
+    }
+}
+
+//
+// json encoding
+//
+inline void append_json_string(string_view_t value, std::string &dest) {
+    memory_buf_t escaped;
+    details::json_escape(value, escaped);
+    dest.push_back('"');
+    dest.append(escaped.data(), escaped.size());
+    dest.push_back('"');
+}
+
+inline void append_json_string_attribute(string_view_t key,
+                                         string_view_t value,
+                                         std::string &dest) {
+    dest += ",{\"key\":";
+    append_json_string(key, dest);
+    dest += ",\"value\":{\"stringValue\":";
+    append_json_string(value, dest);
+    dest += "}}";
+}
+
+// int64 are strings in the json mapping of protobuf
+inline void append_json_int_attribute(string_view_t key, std::int64_t value, std::string &dest) {
+    dest += ",{\"key\":";
+    append_json_string(key, dest);
+    dest += ",\"value\":{\"intValue\":\"";
+    dest += std::to_string(value);
+    dest += "\"}}";
+}
+
+// a kv field (see kv.h) with its type, as append_kv_attribute(). the non finite doubles are
+// strings, as in the json mapping of protobuf
+inline void append_json_kv_attribute(const kv_field &kv, std::string &dest) {
+    if (kv.type == kv_type::string) {
+        append_json_string_attribute(kv.key, kv.string_value, dest);
+        return;
+    }
+    if (kv.type == kv_type::uint64 && kv.uint_value > static_cast<std::uint64_t>(INT64_MAX)) {
+        append_json_string_attribute(kv.key, std::to_string(kv.uint_value), dest);
+        return;
+    }
+    dest += ",{\"key\":";
+    append_json_string(kv.key, dest);
+    memory_buf_t value;
+    details::fmt_helper::append_kv_value(kv, value);
+    switch (kv.type) {
+        case kv_type::int64:
+        case kv_type::uint64:
+            dest += ",\"value\":{\"intValue\":\"";
+            dest.append(value.data(), value.size());
+            dest += '"';
+            break;
+        case kv_type::boolean:
+            dest += ",\"value\":{\"boolValue\":";
+            dest.append(value.data(), value.size());
+            break;
+        default:
+            dest += ",\"value\":{\"doubleValue\":";
+            if (std::isfinite(kv.float_value)) {
+                dest.append(value.data(), value.size());
+            } else {
+                dest += std::isnan(kv.float_value) ? "\"NaN\""
+                        : kv.float_value > 0       ? "\"Infinity\""
+                                                   : "\"-Infinity\"";
+            }
+            break;
+    }
+    dest += "}}";
+}
+
+// records of a batch, and their loggers
+struct batch {
+    // encoded records: ScopeLogs.log_records fields in protobuf, or json objects each preceded
+    // by a comma
+    std::string records;
+    std::vector<std::pair<std::string, size_t>> scopes;  // logger name, end of its records
+    size_t count = 0;
+    std::chrono::steady_clock::time_point started;  // first record
+};
+}  // namespace details_otlp
+
+template <typename Mutex>
+class otlp_http_sink final : public base_sink<Mutex> {
+public:
+    explicit otlp_http_sink(otlp_http_sink_config sink_config)
+        : base_sink<Mutex>(details::make_unique<pattern_formatter>(
+              "%v", pattern_time_type::local, std::string())),
+          config_{std::move(sink_config)} {
+#ifndef SPDLOG_ZLIB
+        if (config_.gzip) {
+            throw_spdlog_ex(
+                "otlp_http_sink: gzip needs zlib (define SPDLOG_ZLIB and link with it)");
+        }
+#endif
+        if (config_.max_batch_records == 0) {
+            throw_spdlog_ex("otlp_http_sink: max_batch_records cannot be zero");
+        }
+        build_request_head_();
+        base_sink<Mutex>::set_own_fields_(msg_field::all);
+        worker_ = std::thread([this] { worker_loop_(); });
+    }
+
+    otlp_http_sink(const otlp_http_sink &) = delete;
+    otlp_http_sink &operator=(const otlp_http_sink &) = delete;
+
+    // send what is left, unless the last attempt failed
+    ~otlp_http_sink() override {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        worker_.join();
+#ifdef SPDLOG_ZLIB
+        if (zstream_init_) {
+            (void)deflateEnd(&zstream_);
+        }
+#endif
+    }
+
+    // number of records dropped: because max_queued_records were waiting, or rejected by the
+    // collector
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        body_.clear();
+        base_sink<Mutex>::formatter_->format(msg, body_);
+        record_.clear();
+        if (config_.encoding == otlp_encoding::protobuf) {
+            encode_protobuf_(msg);
+        } else {
+            encode_json_(msg);
+        }
+        enqueue_(msg.logger_name);
+    }
+
+    // send the batch being filled now
+    void flush_() override {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            flush_requested_ = true;
+        }
+        cv_.notify_one();
+    }
+
+    // the pattern of the body
+    void set_pattern_(const std::string &pattern) override {
+        base_sink<Mutex>::set_formatter_(
+            details::make_unique<pattern_formatter>(pattern, pattern_time_type::local,
+                                                    std::string()));
+    }
+
+private:
+    otlp_http_sink_config config_;
+    std::string request_head_;  // request line and headers, but the content length
+    memory_buf_t body_;         // of the record being encoded
+    std::string record_;        // being encoded
+
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    details_otlp::batch current_;            // being filled
+    std::deque<details_otlp::batch> ready_;  // to send
+    size_t queued_records_ = 0;              // in current_ and ready_
+    bool flush_requested_ = false;
+    bool stop_ = false;
+    std::atomic<size_t> dropped_{0};
+
+    // owned by the worker
+    details::tcp_client client_;
+    std::string request_;
+    std::string content_;
+    std::string response_;
+    bool failed_ = false;  // the last attempt to send failed
+#ifdef SPDLOG_ZLIB
+    z_stream zstream_{};
+    bool zstream_init_ = false;
+#endif
+    std::thread worker_;
+
+    static std::uint64_t nanos_(log_clock::time_point time) {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch())
+                .count());
+    }
+
+    // LogRecord
+    void encode_protobuf_(const details::log_msg &msg) {
+        using namespace details_otlp;
+        auto nanos = nanos_(msg.time);
+        append_fixed64(1, nanos, record_);   // time_unix_nano
+        append_fixed64(11, nanos, record_);  // observed_time_unix_nano
+        append_tag(2, wire_varint, record_);
+        append_varint(static_cast<std::uint64_t>(severity_number(msg.level)), record_);
+        append_bytes(3, severity_text(msg.level), record_);
+        // body = 5: AnyValue{string_value = 1}
+        string_view_t body(body_.data(), body_.size());
+        append_len(5, len_field_size(body.size()), record_);
+        append_bytes(1, body, record_);
+        // attributes = 6
+        append_int_attribute(6, "thread.id", static_cast<std::int64_t>(msg.thread_id), record_);
+        if (msg.thread_name.size() > 0) {
+            append_string_attribute(6, "thread.name", msg.thread_name, record_);
+        }
+        if (!msg.source.empty()) {
+            append_string_attribute(6, "code.filepath", msg.source.filename, record_);
+            append_int_attribute(6, "code.lineno", msg.source.line, record_);
+            if (msg.source.funcname != nullptr) {
+                append_string_attribute(6, "code.function", msg.source.funcname, record_);
+            }
+        }
+#ifndef SPDLOG_NO_TLS
+        for (auto item : mdc::get_context()) {
+            append_string_attribute(6, item.first, item.second, record_);
+        }
+#endif
+        for (size_t i = 0; i < msg.kv_count; i++) {
+            append_kv_attribute(6, msg.kv_fields[i], record_);
+        }
+    }
+
+    void encode_json_(const details::log_msg &msg) {
+        using namespace details_otlp;
+        auto nanos = std::to_string(nanos_(msg.time));
+        record_ += ",{\"timeUnixNano\":\"";
+        record_ += nanos;
+        record_ += "\",\"observedTimeUnixNano\":\"";
+        record_ += nanos;
+        record_ += "\",\"severityNumber\":";
+        record_ += std::to_string(severity_number(msg.level));
+        record_ += ",\"severityText\":";
+        append_json_string(severity_text(msg.level), record_);
+        record_ += ",\"body\":{\"stringValue\":";
+        append_json_string(string_view_t(body_.data(), body_.size()), record_);
+        // the first attribute, preceded by a comma as the others
+        record_ += "},\"attributes\":[";
+        auto first = record_.size();
+        append_json_int_attribute("thread.id", static_cast<std::int64_t>(msg.thread_id),
+                                  record_);
+        record_.erase(first, 1);
+        if (msg.thread_name.size() > 0) {
+            append_json_string_attribute("thread.name", msg.thread_name, record_);
+        }
+        if (!msg.source.empty()) {
+            append_json_string_attribute("code.filepath", msg.source.filename, record_);
+            append_json_int_attribute("code.lineno", msg.source.line, record_);
+            if (msg.source.funcname != nullptr) {
+                append_json_string_attribute("code.function", msg.source.funcname, record_);
+            }
+        }
+#ifndef SPDLOG_NO_TLS
+        for (auto item : mdc::get_context()) {
+            append_json_string_attribute(item.first, item.second, record_);
+        }
+#endif
+        for (size_t i = 0; i < msg.kv_count; i++) {
+            append_json_kv_attribute(msg.kv_fields[i], record_);
+        }
+        record_ += "]}";
+    }
+
+    void enqueue_(string_view_t logger_name) {
+        bool notify = false;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            if (queued_records_ >= config_.max_queued_records) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (current_.count == 0) {
+                current_.started = std::chrono::steady_clock::now();
+                notify = true;  // to start the timer
+            }
+            if (config_.encoding == otlp_encoding::protobuf) {
+                // ScopeLogs.log_records = 2
+                details_otlp::append_len(2, record_.size(), current_.records);
+            }
+            current_.records += record_;
+            auto &scopes = current_.scopes;
+            if (scopes.empty() || scopes.back().first != logger_name) {
+                scopes.emplace_back(std::string(logger_name.data(), logger_name.size()), 0);
+            }
+            scopes.back().second = current_.records.size();
+            current_.count++;
+            queued_records_++;
+            if (current_.count >= config_.max_batch_records ||
+                current_.records.size() >= config_.max_batch_bytes) {
+                ready_.push_back(std::move(current_));
+                current_ = details_otlp::batch();
+                notify = true;
+            }
+        }
+        if (notify) {
+            cv_.notify_one();
+        }
+    }
+
+    void worker_loop_() {
+        auto delay = config_.reconnect_min_delay;
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        for (;;) {
+            if (ready_.empty()) {
+                auto due = current_.count > 0 &&
+                           (stop_ || flush_requested_ ||
+                            std::chrono::steady_clock::now() - current_.started >=
+                                config_.max_delay);
+                if (!due && stop_) {
+                    return;
+                }
+                if (!due) {
+                    flush_requested_ = false;
+                    auto woken = [this] {
+                        return stop_ || flush_requested_ || !ready_.empty() || current_.count > 0;
+                    };
+                    if (current_.count == 0) {
+                        cv_.wait(lock, woken);
+                    } else {
+                        cv_.wait_until(lock, current_.started + config_.max_delay, [this] {
+                            return stop_ || flush_requested_ || !ready_.empty();
+                        });
+                    }
+                    continue;
+                }
+                flush_requested_ = false;
+                ready_.push_back(std::move(current_));
+                current_ = details_otlp::batch();
+            }
+            auto sending = std::move(ready_.front());
+            ready_.pop_front();
+            auto stopping = stop_;
+            lock.unlock();
+
+            build_request_(sending);
+            for (;;) {
+                // no more attempts when stopping after a failure, the destructor shouldn't wait
+                bool sent = (!stopping || !failed_) && send_request_(sending.count);
+                failed_ = !sent;
+                if (sent) {
+                    delay = config_.reconnect_min_delay;
+                    break;
+                }
+                if (stopping) {
+                    break;
+                }
+                lock.lock();
+                cv_.wait_for(lock, delay, [this] { return stop_; });
+                stopping = stop_;
+                lock.unlock();
+                delay = (std::min)(delay * 2, config_.reconnect_max_delay);
+            }
+
+            lock.lock();
+            queued_records_ -= sending.count;
+            if (failed_) {
+                dropped_.fetch_add(sending.count, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void build_request_head_() {
+        request_head_ = "POST " + config_.path + " HTTP/1.1\r\nHost: " + config_.host + ':' +
+                        std::to_string(config_.port) + "\r\nContent-Type: ";
+        request_head_ += config_.encoding == otlp_encoding::protobuf ? "application/x-protobuf"
+                                                                     : "application/json";
+        request_head_ += "\r\n";
+        if (config_.gzip) {
+            request_head_ += "Content-Encoding: gzip\r\n";
+        }
+        for (const auto &header : config_.headers) {
+            request_head_ += header.first + ": " + header.second + "\r\n";
+        }
+        request_head_ += "Content-Length: ";
+    }
+
+    // ExportLogsServiceRequest{resource_logs = 1: ResourceLogs{resource = 1, scope_logs = 2}}
+    void build_request_(const details_otlp::batch &sending) {
+        using namespace details_otlp;
+        content_.clear();
+        if (config_.encoding == otlp_encoding::protobuf) {
+            // Resource{attributes = 1}
+            std::string resource;
+            if (!config_.service_name.empty()) {
+                append_string_attribute(1, "service.name", config_.service_name, resource);
+            }
+            // ScopeLogs{scope = 1: InstrumentationScope{name = 1}, log_records = 2}
+            size_t resource_logs_size = len_field_size(resource.size());
+            size_t start = 0;
+            for (const auto &scope : sending.scopes) {
+                resource_logs_size += len_field_size(len_field_size(
+                                          len_field_size(scope.first.size())) +
+                                      scope.second - start);
+                start = scope.second;
+            }
+            append_len(1, resource_logs_size, content_);
+            append_bytes(1, resource, content_);
+            start = 0;
+            for (const auto &scope : sending.scopes) {
+                auto scope_size = len_field_size(scope.first.size());
+                append_len(2, len_field_size(scope_size) + scope.second - start, content_);
+                append_len(1, scope_size, content_);
+                append_bytes(1, scope.first, content_);
+                content_.append(sending.records, start, scope.second - start);
+                start = scope.second;
+            }
+        } else {
+            content_ += "{\"resourceLogs\":[{\"resource\":{\"attributes\":[";
+            if (!config_.service_name.empty()) {
+                auto first = content_.size();
+                append_json_string_attribute("service.name", config_.service_name, content_);
+                content_.erase(first, 1);  // the comma
+            }
+            content_ += "]},\"scopeLogs\":[";
+            size_t start = 0;
+            for (const auto &scope : sending.scopes) {
+                content_ += start == 0 ? "{\"scope\":{\"name\":" : ",{\"scope\":{\"name\":";
+                append_json_string(scope.first, content_);
+                content_ += "},\"logRecords\":[";
+                // without the comma before the first record
+                content_.append(sending.records, start + 1, scope.second - start - 1);
+                content_ += "]}";
+                start = scope.second;
+            }
+            content_ += "]}]}";
+        }
+        if (config_.gzip) {
+            compress_();
+        }
+        request_ = request_head_;
+        request_ += std::to_string(content_.size());
+        request_ += "\r\n\r\n";
+        request_ += content_;
+    }
+
+    void compress_() {
+#ifdef SPDLOG_ZLIB
+        if (!zstream_init_) {
+            // 15 bits window, +16 for the gzip header and trailer
+            if (deflateInit2(&zstream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                             Z_DEFAULT_STRATEGY) != Z_OK) {
+                return;  // sent uncompressed
+            }
+            zstream_init_ = true;
+        } else {
+            (void)deflateReset(&zstream_);
+        }
+        std::string compressed(deflateBound(&zstream_, static_cast<uLong>(content_.size())),
+                               '\0');
+        zstream_.next_in = reinterpret_cast<Bytef *>(&content_[0]);
+        zstream_.avail_in = static_cast<uInt>(content_.size());
+        zstream_.next_out = reinterpret_cast<Bytef *>(&compressed[0]);
+        zstream_.avail_out = static_cast<uInt>(compressed.size());
+        if (deflate(&zstream_, Z_FINISH) == Z_STREAM_END) {
+            compressed.resize(static_cast<size_t>(zstream_.total_out));
+            content_.swap(compressed);
+        }
+#endif
+    }
+
+    // connect if needed and send request_. false (with the connection closed) if it should be
+    // sent again, true if sent or rejected by the collector
+    bool send_request_(size_t count) {
+        SPDLOG_TRY {
+            if (!client_.is_connected()) {
+                client_.connect(config_.host, config_.port);
+                set_timeouts_();
+            }
+            client_.send(request_.data(), request_.size());
+            bool keep_alive = true;
+            auto status = read_response_(keep_alive);
+            if (!keep_alive) {
+                client_.close();
+            }
+            if (status >= 200 && status < 300) {
+                return true;
+            }
+            if (status == 429 || status == 502 || status == 503 || status == 504) {
+                client_.close();
+                return false;
+            }
+            dropped_.fetch_add(count, std::memory_order_relaxed);
+            return true;
+        }
+        SPDLOG_CATCH_STD
+        client_.close();
+        return false;
+    }
+
+    // read more of the response, throw if the connection was closed
+    void receive_() {
+        char chunk[4096];
+        auto n = client_.recv(chunk, sizeof(chunk));
+        if (n == 0) {
+            client_.close();
+            throw_spdlog_ex("otlp_http_sink: connection closed by the collector");
+        }
+        response_.append(chunk, n);
+    }
+
+    // find header (lower case) in the headers
+    static bool header_value_(const std::string &headers,
+                              const char *header,
+                              std::string &value) {
+        std::string lower(headers);
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](char c) { return static_cast<char>(std::tolower(c)); });
+        auto pos = lower.find(std::string("\r\n") + header + ':');
+        if (pos == std::string::npos) {
+            return false;
+        }
+        pos += std::strlen(header) + 3;
+        auto end = lower.find("\r\n", pos);
+        value = lower.substr(pos, end - pos);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t") + 1);
+        return true;
+    }
+
+    // the status of the response, its body read and discarded
+    int read_response_(bool &keep_alive) {
+        response_.clear();
+        size_t headers_end;
+        while ((headers_end = response_.find("\r\n\r\n")) == std::string::npos) {
+            receive_();
+        }
+        if (response_.compare(0, 5, "HTTP/") != 0 || response_.size() < 12) {
+            throw_spdlog_ex("otlp_http_sink: invalid response from the collector");
+        }
+        int status = std::atoi(response_.c_str() + response_.find(' ') + 1);
+        auto headers = response_.substr(0, headers_end + 2);
+        response_.erase(0, headers_end + 4);
+
+        std::string value;
+        keep_alive = !(header_value_(headers, "connection", value) && value == "close") &&
+                     headers.compare(0, 8, "HTTP/1.0") != 0;
+        if (header_value_(headers, "content-length", value)) {
+            auto length = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+            while (response_.size() < length) {
+                receive_();
+            }
+        } else if (header_value_(headers, "transfer-encoding", value) && value == "chunked") {
+            read_chunks_();
+        } else {
+            keep_alive = false;  // the body ends with the connection
+        }
+        return status;
+    }
+
+    void read_chunks_() {
+        size_t pos = 0;
+        for (;;) {
+            size_t line_end;
+            while ((line_end = response_.find("\r\n", pos)) == std::string::npos) {
+                receive_();
+            }
+            auto size = static_cast<size_t>(std::strtoull(response_.c_str() + pos, nullptr, 16));
+            if (size == 0) {
+                // the trailers, until an empty line
+                while (response_.find("\r\n\r\n", line_end) == std::string::npos) {
+                    receive_();
+                }
+                return;
+            }
+            pos = line_end + 2 + size + 2;
+            while (response_.size() < pos) {
+                receive_();
+            }
+        }
+    }
+
+    void set_timeouts_() {
+        auto ms = config_.timeout.count();
+#ifdef _WIN32
+        DWORD timeout = static_cast<DWORD>(ms);
+#else
+        timeval timeout{};
+        timeout.tv_sec = static_cast<decltype(timeout.tv_sec)>(ms / 1000);
+        timeout.tv_usec = static_cast<decltype(timeout.tv_usec)>(ms % 1000 * 1000);
+#endif
+        ::setsockopt(client_.fd(), SOL_SOCKET, SO_SNDTIMEO,
+                     reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+        ::setsockopt(client_.fd(), SOL_SOCKET, SO_RCVTIMEO,
+                     reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+    }
+};
+
+using otlp_http_sink_mt = otlp_http_sink<std::mutex>;
+using otlp_http_sink_st = otlp_http_sink<details::null_mutex>;
+
+}  // namespace sinks
+}  // namespace spdlog
@@ -0,0 +1,293 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// File sink writing with overlapped I/O instead of fwrite() in the logging thread, the windows
+// counterpart of uring_file_sink. The messages are formatted into one of several buffers, and
+// a full buffer (or the current one on flush) is written in the background while the next ones
+// fill up, the completions being read from an I/O completion port: the logging thread only
+// waits when all the buffers are still in flight, and flush() doesn't wait for the disk.
+// With write_through (FILE_FLAG_WRITE_THROUGH), a write completes once it reached the disk.
+//
+// Windows only. The writes are done at explicit offsets tracked by the sink, so the file
+// shouldn't be written by anything else while the sink is open.
+//
+// Usage example:
+// auto logger = spdlog::overlapped_logger_mt("overlapped_logger", "logs/overlapped.txt");
+// or
+// auto sink = std::make_shared<spdlog::sinks::overlapped_file_sink_mt>("logs/overlapped.txt");
+
+#ifdef _WIN32
+
+    #include <spdlog/common.h>
+    #include <spdlog/details/null_mutex.h>
+    #include <spdlog/details/os.h>
+    #include <spdlog/details/synchronous_factory.h>
+    #include <spdlog/details/windows_include.h>
+    #include <spdlog/sinks/base_sink.h>
+
+    #include <algorithm>
+    #include <cstdint>
+    #include <mutex>
+    #include <string>
+    #include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class overlapped_file_sink final : public base_sink<Mutex> {
+public:
+    explicit overlapped_file_sink(filename_t filename,
+                                  bool truncate = false,
+                                  size_t buffer_size = 64 * 1024,
+                                  size_t buffers = 4,
+                                  bool write_through = false)
+        : filename_(std::move(filename)),
+          buffer_size_(buffer_size == 0 ? 1 : (std::min)(buffer_size, max_write_size)),
+          buffers_(buffers == 0 ? 1 : buffers) {
+        details::os::create_dir(details::os::dir_name(filename_));
+        DWORD disposition = truncate ? CREATE_ALWAYS : OPEN_ALWAYS;
+        DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED |
+                      (write_through ? FILE_FLAG_WRITE_THROUGH : 0);
+    #ifdef SPDLOG_WCHAR_FILENAMES
+        file_ = ::CreateFileW(filename_.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, disposition, flags, nullptr);
+    #else
+        file_ = ::CreateFileA(filename_.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, disposition, flags, nullptr);
+    #endif
+        LARGE_INTEGER size;
+        if (file_ == INVALID_HANDLE_VALUE || !::GetFileSizeEx(file_, &size)) {
+            auto err = ::GetLastError();
+            close_();
+            throw_spdlog_ex(fmt_lib::format("Failed opening file {} for writing. Last error: {}",
+                                            details::os::filename_to_str(filename_), err));
+        }
+        offset_ = static_cast<std::uint64_t>(size.QuadPart);
+        port_ = ::CreateIoCompletionPort(file_, nullptr, 0, 1);
+        if (port_ == nullptr) {
+            auto err = ::GetLastError();
+            close_();
+            throw_spdlog_ex(fmt_lib::format("CreateIoCompletionPort failed. Last error: {}", err));
+        }
+        for (auto &buffer : buffers_) {
+            buffer.data.reserve(buffer_size_);
+        }
+    }
+
+    overlapped_file_sink(const overlapped_file_sink &) = delete;
+    overlapped_file_sink &operator=(const overlapped_file_sink &) = delete;
+
+    ~overlapped_file_sink() override {
+        SPDLOG_TRY {
+            std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+            submit_current_();
+            while (in_flight_ > 0 && reap_(INFINITE)) {
+            }
+        }
+        SPDLOG_CATCH_STD
+        close_();
+    }
+
+    const filename_t &filename() const { return filename_; }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        throw_if_failed_();
+        memory_buf_t formatted;
+        base_sink<Mutex>::formatter_->format(msg, formatted);
+        auto data = formatted.data();
+        auto size = formatted.size();
+        while (size > 0) {
+            auto &buffer = buffers_[current_].data;
+            auto n = (std::min)(size, buffer_size_ - buffer.size());
+            buffer.insert(buffer.end(), data, data + n);
+            data += n;
+            size -= n;
+            if (buffer.size() == buffer_size_) {
+                submit_current_();
+            }
+        }
+        reap_(0);
+    }
+
+    void flush_() override {
+        throw_if_failed_();
+        submit_current_();
+        reap_(0);
+        throw_if_failed_();
+    }
+
+private:
+    struct buffer {
+        OVERLAPPED overlapped{};  // of the write in flight
+        std::vector<char> data;
+        std::uint64_t offset = 0;  // in the file
+        size_t written = 0;        // completed so far, if in flight
+        bool in_flight = false;
+    };
+
+    // a WriteFile() takes a DWORD size
+    static constexpr size_t max_write_size = 1024 * 1024 * 1024;
+
+    filename_t filename_;
+    size_t buffer_size_;
+    std::vector<buffer> buffers_;  // not resized: the OVERLAPPED must stay in place
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE port_ = nullptr;
+    std::uint64_t offset_ = 0;  // where the next buffer goes
+    size_t current_ = 0;        // the buffer being filled
+    size_t in_flight_ = 0;      // writes not completed yet
+    DWORD error_ = 0;           // of the first failed write
+
+    void submit_write_(size_t index) {
+        auto &b = buffers_[index];
+        auto offset = b.offset + b.written;
+        b.overlapped = OVERLAPPED{};
+        b.overlapped.Offset = static_cast<DWORD>(offset & 0xffffffff);
+        b.overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        // completed or pending, the completion is queued to the port
+        if (::WriteFile(file_, b.data.data() + b.written,
+                        static_cast<DWORD>(b.data.size() - b.written), nullptr, &b.overlapped)) {
+            in_flight_++;
+            return;
+        }
+        auto err = ::GetLastError();
+        if (err == ERROR_IO_PENDING) {
+            in_flight_++;
+            return;
+        }
+        if (error_ == 0) {
+            error_ = err;
+        }
+        b.data.clear();
+        b.in_flight = false;
+    }
+
+    // write the current buffer in the background and move to a free one, waiting for one of
+    // the writes in flight if there is none
+    void submit_current_() {
+        auto &b = buffers_[current_];
+        if (b.data.empty()) {
+            return;
+        }
+        b.offset = offset_;
+        b.written = 0;
+        b.in_flight = true;
+        offset_ += b.data.size();
+        submit_write_(current_);
+        for (;;) {
+            for (size_t i = 0; i < buffers_.size(); i++) {
+                if (!buffers_[i].in_flight) {
+                    current_ = i;
+                    return;
+                }
+            }
+            if (!reap_(INFINITE)) {
+                throw_spdlog_ex(fmt_lib::format("Failed waiting for the writes to file {}. Last "
+                                                "error: {}",
+                                                details::os::filename_to_str(filename_),
+                                                ::GetLastError()));
+            }
+        }
+    }
+
+    // handle the completed writes, waiting up to timeout_ms for one. return false if none
+    // completed
+    bool reap_(DWORD timeout_ms) {
+        if (in_flight_ == 0) {
+            return false;
+        }
+        OVERLAPPED_ENTRY entries[16];
+        ULONG count = 0;
+        if (!::GetQueuedCompletionStatusEx(port_, entries, 16, &count, timeout_ms, FALSE)) {
+            return false;  // timed out
+        }
+        for (ULONG i = 0; i < count; i++) {
+            complete_(entries[i].lpOverlapped);
+        }
+        return count > 0;
+    }
+
+    void complete_(OVERLAPPED *overlapped) {
+        in_flight_--;
+        size_t index = 0;
+        while (&buffers_[index].overlapped != overlapped) {
+            index++;
+        }
+        auto &b = buffers_[index];
+        DWORD transferred = 0;
+        if (!::GetOverlappedResult(file_, overlapped, &transferred, FALSE)) {
+            if (error_ == 0) {
+                error_ = ::GetLastError();
+            }
+        } else if (transferred > 0 && b.written + transferred < b.data.size()) {
+            b.written += transferred;
+            submit_write_(index);
+            return;
+        } else if (transferred == 0 && error_ == 0) {
+            error_ = ERROR_WRITE_FAULT;
+        }
+        b.data.clear();
+        b.in_flight = false;
+    }
+
+    void throw_if_failed_() {
+        if (error_ != 0) {
+            auto err = error_;
+            error_ = 0;
+            throw_spdlog_ex(fmt_lib::format("Failed writing to file {}. Last error: {}",
+                                            details::os::filename_to_str(filename_), err));
+        }
+    }
+
+    void close_() {
+        if (port_ != nullptr) {
+            ::CloseHandle(port_);
+            port_ = nullptr;
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            ::CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+    }
+};
+
+using overlapped_file_sink_mt = overlapped_file_sink<std::mutex>;
+using overlapped_file_sink_st = overlapped_file_sink<details::null_mutex>;
+
+template <typename Mutex>
+struct shares_file<overlapped_file_sink<Mutex>> : std::true_type {};
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> overlapped_logger_mt(const std::string &logger_name,
+                                                    const filename_t &filename,
+                                                    bool truncate = false,
+                                                    size_t buffer_size = 64 * 1024,
+                                                    size_t buffers = 4,
+                                                    bool write_through = false) {
+    return Factory::template create<sinks::overlapped_file_sink_mt>(
+        logger_name, filename, truncate, buffer_size, buffers, write_through);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> overlapped_logger_st(const std::string &logger_name,
+                                                    const filename_t &filename,
+                                                    bool truncate = false,
+                                                    size_t buffer_size = 64 * 1024,
+                                                    size_t buffers = 4,
+                                                    bool write_through = false) {
+    return Factory::template create<sinks::overlapped_file_sink_st>(
+        logger_name, filename, truncate, buffer_size, buffers, write_through);
+}
+
+}  // namespace spdlog
+
+#endif  // _WIN32
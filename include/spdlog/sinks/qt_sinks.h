@@ -11,27 +11,91 @@
 // If the widget's lifetime can be shorter than the logger's one, you should provide some permanent
 // QObject, and then use a standard signal/slot.
 //
+// The messages are gathered and handed to the GUI thread in batches: a message logged while
+// none is waiting posts one event, which appends all the messages logged until the GUI thread
+// handles it (with update_interval_ms, after waiting that long for more of them). So a burst
+// of messages costs a few appends, and not one event per message. The qt_sink calls the meta
+// method once per batch, with the lines of its messages joined by '\n'.
+//
 
 #include "spdlog/common.h"
 #include "spdlog/details/log_msg.h"
 #include "spdlog/details/synchronous_factory.h"
 #include "spdlog/sinks/base_sink.h"
+#include <algorithm>
 #include <array>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <QPlainTextEdit>
+#include <QStringList>
 #include <QTextEdit>
+#include <QTimer>
 
 //
 // qt_sink class
 //
 namespace spdlog {
 namespace sinks {
+namespace details_qt {
+// the items logged and not handed to the GUI thread yet. shared with the events posted, which
+// can be handled after the sink is destroyed.
+template <typename Item>
+struct pending_items {
+    std::mutex mutex;
+    std::deque<Item> items;
+    bool scheduled = false;  // an event is posted, which will take the items
+
+    // add the item, and return true if an event must be posted for it. keep the last max_items.
+    bool add(Item item, size_t max_items) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(std::move(item));
+        if (items.size() > max_items) {
+            items.pop_front();
+        }
+        if (scheduled) {
+            return false;
+        }
+        scheduled = true;
+        return true;
+    }
+
+    std::deque<Item> take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        scheduled = false;
+        std::deque<Item> taken;
+        taken.swap(items);
+        return taken;
+    }
+};
+
+// post an event calling apply() in the thread of context, right away or update_interval_ms
+// later
+template <typename Apply>
+void schedule(QObject *context, int update_interval_ms, Apply apply) {
+    QMetaObject::invokeMethod(
+        context,
+        [context, update_interval_ms, apply]() {
+            if (update_interval_ms <= 0) {
+                apply();
+            } else {
+                QTimer::singleShot(update_interval_ms, context, apply);
+            }
+        },
+        Qt::QueuedConnection);
+}
+}  // namespace details_qt
+
 template <typename Mutex>
 class qt_sink : public base_sink<Mutex> {
 public:
-    qt_sink(QObject *qt_object, std::string meta_method)
+    qt_sink(QObject *qt_object, std::string meta_method, int update_interval_ms = 0)
         : qt_object_(qt_object),
-          meta_method_(std::move(meta_method)) {
+          meta_method_(std::move(meta_method)),
+          update_interval_ms_(update_interval_ms),
+          pending_(std::make_shared<details_qt::pending_items<QString>>()) {
         if (!qt_object_) {
             throw_spdlog_ex("qt_sink: qt_object is null");
         }
@@ -44,23 +108,46 @@ protected:
         memory_buf_t formatted;
         base_sink<Mutex>::formatter_->format(msg, formatted);
         const string_view_t str = string_view_t(formatted.data(), formatted.size());
-        QMetaObject::invokeMethod(
-            qt_object_, meta_method_.c_str(), Qt::AutoConnection,
-            Q_ARG(QString, QString::fromUtf8(str.data(), static_cast<int>(str.size())).trimmed()));
+        auto line = QString::fromUtf8(str.data(), static_cast<int>(str.size())).trimmed();
+        if (!pending_->add(std::move(line), max_pending_lines)) {
+            return;
+        }
+        auto pending = pending_;
+        auto *qt_object = qt_object_;
+        auto meta_method = meta_method_;
+        details_qt::schedule(qt_object_, update_interval_ms_, [pending, qt_object, meta_method]() {
+            QStringList lines;
+            for (auto &line : pending->take()) {
+                lines.append(std::move(line));
+            }
+            if (!lines.isEmpty()) {
+                QMetaObject::invokeMethod(qt_object, meta_method.c_str(), Qt::DirectConnection,
+                                          Q_ARG(QString, lines.join(QLatin1Char('\n'))));
+            }
+        });
     }
 
     void flush_() override {}
 
 private:
+    // the oldest messages waiting are dropped past this number (the GUI thread being blocked)
+    static constexpr size_t max_pending_lines = 100000;
+
     QObject *qt_object_ = nullptr;
     std::string meta_method_;
+    int update_interval_ms_;
+    std::shared_ptr<details_qt::pending_items<QString>> pending_;
 };
 
+template <typename Mutex>
+constexpr size_t qt_sink<Mutex>::max_pending_lines;
+
 // Qt color sink to QTextEdit.
 // Color location is determined by the sink log pattern like in the rest of spdlog sinks.
 // Colors can be modified if needed using sink->set_color(level, qtTextCharFormat).
 // max_lines is the maximum number of lines that the sink will hold before removing the oldest
-// lines. By default, only ascii (latin1) is supported by this sink. Set is_utf8 to true if utf8
+// lines, once per batch of messages (the messages of a batch past max_lines aren't inserted at
+// all). By default, only ascii (latin1) is supported by this sink. Set is_utf8 to true if utf8
 // support is needed.
 template <typename Mutex>
 class qt_color_sink : public base_sink<Mutex> {
@@ -68,10 +155,13 @@ public:
     qt_color_sink(QTextEdit *qt_text_edit,
                   int max_lines,
                   bool dark_colors = false,
-                  bool is_utf8 = false)
+                  bool is_utf8 = false,
+                  int update_interval_ms = 0)
         : qt_text_edit_(qt_text_edit),
           max_lines_(max_lines),
-          is_utf8_(is_utf8) {
+          is_utf8_(is_utf8),
+          update_interval_ms_(update_interval_ms),
+          pending_(std::make_shared<details_qt::pending_items<invoke_params>>()) {
         if (!qt_text_edit_) {
             throw_spdlog_ex("qt_color_text_sink: text_edit is null");
         }
@@ -175,27 +265,50 @@ protected:
                              color_range_start,      // color range start
                              color_range_end};       // color range end
 
-        QMetaObject::invokeMethod(
-            qt_text_edit_, [params]() { invoke_method_(params); }, Qt::AutoConnection);
+        if (!pending_->add(std::move(params), static_cast<size_t>((std::max)(max_lines_, 1)))) {
+            return;
+        }
+        auto pending = pending_;
+        details_qt::schedule(qt_text_edit_, update_interval_ms_,
+                             [pending]() { invoke_batch_(pending->take()); });
     }
 
     void flush_() override {}
 
-    // Add colored text to the text edit widget. This method is invoked in the GUI thread.
+    // Add the colored text of a batch of messages to the text edit widget, and remove the first
+    // lines past max_lines. This method is invoked in the GUI thread.
     // It is a static method to ensure that it is handled correctly even if the sink is destroyed
     // prematurely before it is invoked.
-
-    static void invoke_method_(invoke_params params) {
-        auto *document = params.q_text_edit->document();
+    static void invoke_batch_(std::deque<invoke_params> batch) {
+        if (batch.empty()) {
+            return;
+        }
+        auto *document = batch.front().q_text_edit->document();
+        auto max_lines = batch.back().max_lines;
         QTextCursor cursor(document);
+        cursor.beginEditBlock();
+        for (auto &params : batch) {
+            insert_(cursor, params);
+        }
 
         // remove first blocks if number of blocks exceeds max_lines
-        while (document->blockCount() > params.max_lines) {
-            cursor.select(QTextCursor::BlockUnderCursor);
+        auto excess = document->blockCount() - max_lines;
+        if (excess > 0) {
+            cursor.movePosition(QTextCursor::Start);
+            cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor, excess);
             cursor.removeSelectedText();
-            cursor.deleteChar();  // delete the newline after the block
         }
+        cursor.endEditBlock();
+    }
+
+    // kept for the subclasses: add the colored text of one message
+    static void invoke_method_(invoke_params params) {
+        std::deque<invoke_params> batch;
+        batch.push_back(std::move(params));
+        invoke_batch_(std::move(batch));
+    }
 
+    static void insert_(QTextCursor &cursor, const invoke_params &params) {
         cursor.movePosition(QTextCursor::End);
         cursor.setCharFormat(params.default_color);
 
@@ -221,6 +334,8 @@ protected:
     QTextEdit *qt_text_edit_;
     int max_lines_;
     bool is_utf8_;
+    int update_interval_ms_;
+    std::shared_ptr<details_qt::pending_items<invoke_params>> pending_;
     QTextCharFormat default_color_;
     std::array<QTextCharFormat, level::n_levels> colors_;
 };
@@ -242,44 +357,56 @@ using qt_color_sink_st = qt_color_sink<details::null_mutex>;
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_logger_mt(const std::string &logger_name,
                                             QTextEdit *qt_object,
-                                            const std::string &meta_method = "append") {
-    return Factory::template create<sinks::qt_sink_mt>(logger_name, qt_object, meta_method);
+                                            const std::string &meta_method = "append",
+                                            int update_interval_ms = 0) {
+    return Factory::template create<sinks::qt_sink_mt>(logger_name, qt_object, meta_method,
+                                                       update_interval_ms);
 }
 
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_logger_st(const std::string &logger_name,
                                             QTextEdit *qt_object,
-                                            const std::string &meta_method = "append") {
-    return Factory::template create<sinks::qt_sink_st>(logger_name, qt_object, meta_method);
+                                            const std::string &meta_method = "append",
+                                            int update_interval_ms = 0) {
+    return Factory::template create<sinks::qt_sink_st>(logger_name, qt_object, meta_method,
+                                                       update_interval_ms);
 }
 
 // log to QPlainTextEdit
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_logger_mt(const std::string &logger_name,
                                             QPlainTextEdit *qt_object,
-                                            const std::string &meta_method = "appendPlainText") {
-    return Factory::template create<sinks::qt_sink_mt>(logger_name, qt_object, meta_method);
+                                            const std::string &meta_method = "appendPlainText",
+                                            int update_interval_ms = 0) {
+    return Factory::template create<sinks::qt_sink_mt>(logger_name, qt_object, meta_method,
+                                                       update_interval_ms);
 }
 
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_logger_st(const std::string &logger_name,
                                             QPlainTextEdit *qt_object,
-                                            const std::string &meta_method = "appendPlainText") {
-    return Factory::template create<sinks::qt_sink_st>(logger_name, qt_object, meta_method);
+                                            const std::string &meta_method = "appendPlainText",
+                                            int update_interval_ms = 0) {
+    return Factory::template create<sinks::qt_sink_st>(logger_name, qt_object, meta_method,
+                                                       update_interval_ms);
 }
 // log to QObject
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_logger_mt(const std::string &logger_name,
                                             QObject *qt_object,
-                                            const std::string &meta_method) {
-    return Factory::template create<sinks::qt_sink_mt>(logger_name, qt_object, meta_method);
+                                            const std::string &meta_method,
+                                            int update_interval_ms = 0) {
+    return Factory::template create<sinks::qt_sink_mt>(logger_name, qt_object, meta_method,
+                                                       update_interval_ms);
 }
 
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_logger_st(const std::string &logger_name,
                                             QObject *qt_object,
-                                            const std::string &meta_method) {
-    return Factory::template create<sinks::qt_sink_st>(logger_name, qt_object, meta_method);
+                                            const std::string &meta_method,
+                                            int update_interval_ms = 0) {
+    return Factory::template create<sinks::qt_sink_st>(logger_name, qt_object, meta_method,
+                                                       update_interval_ms);
 }
 
 // log to QTextEdit with colorized output
@@ -287,18 +414,20 @@ template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_color_logger_mt(const std::string &logger_name,
                                                   QTextEdit *qt_text_edit,
                                                   int max_lines,
-                                                  bool is_utf8 = false) {
+                                                  bool is_utf8 = false,
+                                                  int update_interval_ms = 0) {
     return Factory::template create<sinks::qt_color_sink_mt>(logger_name, qt_text_edit, max_lines,
-                                                             false, is_utf8);
+                                                             false, is_utf8, update_interval_ms);
 }
 
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> qt_color_logger_st(const std::string &logger_name,
                                                   QTextEdit *qt_text_edit,
                                                   int max_lines,
-                                                  bool is_utf8 = false) {
+                                                  bool is_utf8 = false,
+                                                  int update_interval_ms = 0) {
     return Factory::template create<sinks::qt_color_sink_st>(logger_name, qt_text_edit, max_lines,
-                                                             false, is_utf8);
+                                                             false, is_utf8, update_interval_ms);
 }
 
 }  // namespace spdlog
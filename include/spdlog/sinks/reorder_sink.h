@@ -0,0 +1,151 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "dist_sink.h"
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/null_mutex.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Timestamp ordering sink.
+// With several thread pool workers (or threads logging to the same sink), the messages reach
+// the sink a little out of order. This sink holds each message for "window" (measured from
+// its time), and passes the messages held to its sub sinks in time order, so that messages
+// reaching it less than "window" late are in order. Messages later than that are passed as
+// soon as they arrive, and counted by late_messages().
+//
+// At most "max_messages" are held: the oldest one is passed early to make room. The messages
+// held are only checked when a message is logged, and all passed by flush(): with a quiet
+// logger, use flush_every() to bound how long they are held.
+//
+// Example:
+//
+//     auto file = std::make_shared<spdlog::sinks::basic_file_sink_st>("logs/ordered.log");
+//     auto ordered = std::make_shared<spdlog::sinks::reorder_sink_mt>(
+//         std::chrono::milliseconds(5));
+//     ordered->add_sink(file);
+//     spdlog::init_thread_pool(8192, 4);
+//     auto logger = std::make_shared<spdlog::async_logger>("ordered", ordered,
+//                                                           spdlog::thread_pool());
+
+namespace spdlog {
+namespace sinks {
+template <typename Mutex>
+class reorder_sink : public dist_sink<Mutex> {
+public:
+    template <class Rep, class Period>
+    explicit reorder_sink(std::chrono::duration<Rep, Period> window, size_t max_messages = 1024)
+        : window_{std::chrono::duration_cast<log_clock::duration>(window)},
+          max_messages_{max_messages == 0 ? 1 : max_messages} {}
+
+    // pass the messages still held
+    ~reorder_sink() override {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        SPDLOG_TRY { pass_(log_clock::time_point::max()); }
+        SPDLOG_CATCH_STD
+    }
+
+    // the number of messages older than a message already passed to the sub sinks
+    size_t late_messages() {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        return late_counter_;
+    }
+
+    size_t held_messages() {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        return held_.size();
+    }
+
+protected:
+    struct held_msg {
+        log_clock::time_point time;
+        std::uint64_t seq;  // arrival order, for the messages with the same time
+        size_t slot;
+    };
+
+    // the earliest message first
+    struct later {
+        bool operator()(const held_msg &a, const held_msg &b) const {
+            return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+        }
+    };
+
+    log_clock::duration window_;
+    size_t max_messages_;
+    size_t late_counter_ = 0;
+    std::uint64_t seq_ = 0;
+    bool passed_any_ = false;
+    log_clock::time_point last_passed_;
+    // heap of the messages held, whose copies are in slots_ (reused, not moved by the heap)
+    std::vector<held_msg> held_;
+    std::vector<details::log_msg_buffer> slots_;
+    std::vector<size_t> free_slots_;
+
+    void sink_it_(const details::log_msg &msg) override {
+        if (passed_any_ && msg.time < last_passed_) {
+            late_counter_++;
+            dist_sink<Mutex>::sink_it_(msg);
+            return;
+        }
+        if (held_.size() == max_messages_) {
+            pass_oldest_();
+        }
+        hold_(msg);
+        pass_(log_clock::now() - window_);
+    }
+
+    // one message at a time, each being held
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        base_sink<Mutex>::sink_batch_(msgs, count);
+    }
+
+    void flush_() override {
+        pass_(log_clock::time_point::max());
+        dist_sink<Mutex>::flush_();
+    }
+
+    void hold_(const details::log_msg &msg) {
+        size_t slot;
+        if (free_slots_.empty()) {
+            slot = slots_.size();
+            slots_.emplace_back(msg);
+        } else {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            slots_[slot].assign(msg);
+        }
+        held_.push_back(held_msg{msg.time, seq_++, slot});
+        std::push_heap(held_.begin(), held_.end(), later{});
+    }
+
+    // the messages held with a time up to "until"
+    void pass_(log_clock::time_point until) {
+        while (!held_.empty() && held_.front().time <= until) {
+            pass_oldest_();
+        }
+    }
+
+    // the slot is freed first, so that a sub sink throwing doesn't leave it held
+    void pass_oldest_() {
+        std::pop_heap(held_.begin(), held_.end(), later{});
+        auto oldest = held_.back();
+        held_.pop_back();
+        free_slots_.push_back(oldest.slot);
+        passed_any_ = true;
+        last_passed_ = oldest.time;
+        dist_sink<Mutex>::sink_it_(slots_[oldest.slot]);
+    }
+};
+
+using reorder_sink_mt = reorder_sink<std::mutex>;
+using reorder_sink_st = reorder_sink<details::null_mutex>;
+
+}  // namespace sinks
+}  // namespace spdlog
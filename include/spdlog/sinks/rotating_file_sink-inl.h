@@ -13,12 +13,16 @@
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/fmt/fmt.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <ctime>
 #include <mutex>
 #include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace spdlog {
 namespace sinks {
@@ -29,11 +33,14 @@ SPDLOG_INLINE rotating_file_sink<Mutex>::rotating_file_sink(
     std::size_t max_size,
     std::size_t max_files,
     bool rotate_on_open,
-    const file_event_handlers &event_handlers)
+    const file_event_handlers &event_handlers,
+    bool background_rotation,
+    rotation_naming naming)
     : base_filename_(std::move(base_filename)),
       max_size_(max_size),
       max_files_(max_files),
-      file_helper_{event_handlers} {
+      file_helper_{event_handlers},
+      naming_(naming) {
     if (max_size == 0) {
         throw_spdlog_ex("rotating sink constructor: max_size arg cannot be zero");
     }
@@ -41,12 +48,25 @@ SPDLOG_INLINE rotating_file_sink<Mutex>::rotating_file_sink(
     if (max_files > 200000) {
         throw_spdlog_ex("rotating sink constructor: max_files arg cannot exceed 200000");
     }
+    if (background_rotation) {
+        housekeeper_ = details::make_unique<details::file_housekeeper>();
+    }
+    if (naming_ == rotation_naming::increasing) {
+        last_index_ = scan_last_index_();
+    }
     file_helper_.open(calc_filename(base_filename_, 0));
     current_size_ = file_helper_.size();  // expensive. called only once
     if (rotate_on_open && current_size_ > 0) {
         rotate_();
         current_size_ = 0;
     }
+    base_sink<Mutex>::set_own_fields_(own_fields_());
+}
+
+// finish the pending housekeeping while the members its tasks use are still there
+template <typename Mutex>
+SPDLOG_INLINE rotating_file_sink<Mutex>::~rotating_file_sink() {
+    housekeeper_.reset();
 }
 
 // calc filename according to index and file extension if exists.
@@ -69,8 +89,71 @@ SPDLOG_INLINE filename_t rotating_file_sink<Mutex>::filename() {
     return file_helper_.filename();
 }
 
+template <typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::set_compression(
+    const compression_options &options) {
+    details::throw_if_unsupported(options);
+    std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+    compression_ = options;
+    if (!housekeeper_) {
+        housekeeper_ = details::make_unique<details::file_housekeeper>();
+    }
+}
+
+template <typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::set_size_check_interval(
+    std::chrono::seconds interval) {
+    {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        size_check_interval_ = interval;
+        next_size_check_ = log_clock::time_point{};
+    }
+    base_sink<Mutex>::set_own_fields_(own_fields_());
+}
+
+template <typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::set_rotation_interval(std::chrono::seconds interval) {
+    {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        rotation_interval_ = interval;
+        if (interval.count() > 0) {
+            next_rotation_ = next_rotation_time_(log_clock::now());
+        }
+    }
+    base_sink<Mutex>::set_own_fields_(own_fields_());
+}
+
+template <typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::set_max_total_size(std::size_t max_total_size) {
+    std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+    max_total_size_ = max_total_size;
+    if (max_total_size_ > 0 && !housekeeper_) {
+        housekeeper_ = details::make_unique<details::file_housekeeper>();
+    }
+}
+
+template <typename Mutex>
+SPDLOG_INLINE log_clock::time_point rotating_file_sink<Mutex>::next_rotation_time_(
+    log_clock::time_point now) const {
+    auto since_epoch = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch());
+    auto intervals = since_epoch.count() / rotation_interval_.count();
+    return log_clock::time_point(std::chrono::duration_cast<log_clock::duration>(
+        rotation_interval_ * (intervals + 1)));
+}
+
+template <typename Mutex>
+SPDLOG_INLINE unsigned rotating_file_sink<Mutex>::own_fields_() {
+    std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+    return size_check_interval_.count() > 0 || rotation_interval_.count() > 0 ||
+                   file_helper_.indexed()
+               ? msg_field::time
+               : msg_field::none;
+}
+
 template <typename Mutex>
 SPDLOG_INLINE void rotating_file_sink<Mutex>::sink_it_(const details::log_msg &msg) {
+    check_size_(msg.time);
+    rotate_on_time_(msg.time);
     memory_buf_t formatted;
     base_sink<Mutex>::formatter_->format(msg, formatted);
     auto new_size = current_size_ + formatted.size();
@@ -85,10 +168,45 @@ SPDLOG_INLINE void rotating_file_sink<Mutex>::sink_it_(const details::log_msg &m
             new_size = formatted.size();
         }
     }
+    file_helper_.note_time(msg.time);
     file_helper_.write(formatted);
     current_size_ = new_size;
 }
 
+// the batch is formatted into one buffer, written at once unless the file has to be rotated
+// in between.
+template <typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::sink_batch_(const details::log_msg *msgs,
+                                                          size_t count) {
+    if (rotation_interval_.count() > 0) {
+        base_sink<Mutex>::sink_batch_(msgs, count);  // the rotation needs each message's time
+        return;
+    }
+    if (count > 0) {
+        check_size_(msgs[0].time);
+        file_helper_.note_time(msgs[0].time);
+    }
+    memory_buf_t formatted;
+    auto rotate_if_needed = [&](size_t start) {
+        auto msg_size = formatted.size() - start;
+        auto new_size = current_size_ + msg_size;
+        if (new_size > max_size_) {
+            file_helper_.write(formatted.data(), start);
+            file_helper_.flush();
+            if (file_helper_.size() > 0) {
+                rotate_();
+                new_size = msg_size;
+            }
+            // this message starts the rest of the batch
+            std::memmove(formatted.data(), formatted.data() + start, msg_size);
+            formatted.resize(msg_size);
+        }
+        current_size_ = new_size;
+    };
+    base_sink<Mutex>::format_batch_(msgs, count, formatted, rotate_if_needed,
+                                    [&] { file_helper_.write(formatted); });
+}
+
 template <typename Mutex>
 SPDLOG_INLINE void rotating_file_sink<Mutex>::flush_() {
     file_helper_.flush();
@@ -104,6 +222,14 @@ SPDLOG_INLINE void rotating_file_sink<Mutex>::rotate_() {
     using details::os::filename_to_str;
     using details::os::path_exists;
 
+    if (naming_ == rotation_naming::increasing && max_files_ > 0) {
+        rotate_increasing_();
+        return;
+    }
+    if (housekeeper_ && max_files_ > 0) {
+        rotate_in_background_();
+        return;
+    }
     file_helper_.close();
     for (auto i = max_files_; i > 0; --i) {
         filename_t src = calc_filename(base_filename_, i - 1);
@@ -130,6 +256,201 @@ SPDLOG_INLINE void rotating_file_sink<Mutex>::rotate_() {
     file_helper_.reopen(true);
 }
 
+template <typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::rotate_increasing_() {
+    using details::os::filename_to_str;
+
+    file_helper_.close();
+    filename_t target = calc_filename(base_filename_, last_index_ + 1);
+    if (!rename_file_(base_filename_, target)) {
+        details::os::sleep_for_millis(100);
+        if (!rename_file_(base_filename_, target)) {
+            file_helper_.reopen(true);
+            current_size_ = 0;
+            throw_spdlog_ex("rotating_file_sink: failed renaming " +
+                                filename_to_str(base_filename_) + " to " +
+                                filename_to_str(target),
+                            errno);
+        }
+    }
+    last_index_++;
+    file_helper_.reopen(true);
+    filename_t oldest;
+    if (last_index_ > max_files_) {
+        oldest = calc_filename(base_filename_, last_index_ - max_files_);
+    }
+    if (!housekeeper_) {
+        if (!oldest.empty()) {
+            (void)details::os::remove(oldest);
+        }
+        return;
+    }
+    auto error = housekeeper_->take_error();
+    auto compression = compression_;
+    housekeeper_->post([target, oldest, compression] {
+        auto error = details::compress_file(target, compression);
+        if (!oldest.empty()) {
+            (void)details::os::remove(oldest);
+            (void)details::os::remove(
+                details::compressed_filename(oldest, file_compression::gzip));
+        }
+        return error;
+    });
+    if (max_total_size_ > 0) {
+        auto newest_index = last_index_;
+        auto budget = full_files_budget_();
+        housekeeper_->post(
+            [this, newest_index, budget] { return trim_to_budget_(newest_index, budget); });
+    }
+    if (!error.empty()) {
+        throw_spdlog_ex(error);
+    }
+}
+
+template <typename Mutex>
+SPDLOG_INLINE std::size_t rotating_file_sink<Mutex>::scan_last_index_() {
+    auto dir = details::os::dir_name(base_filename_);
+    filename_t basename, ext;
+    std::tie(basename, ext) = details::file_helper::split_by_extension(base_filename_);
+    auto prefix = basename.substr(dir.empty() ? 0 : dir.size() + 1);
+    prefix += SPDLOG_FILENAME_T('.');
+
+    const filename_t gz_ext = SPDLOG_FILENAME_T(".gz");
+    std::vector<std::size_t> indices;
+    for (auto name : details::os::list_dir(dir)) {
+        if (name.size() > gz_ext.size() &&
+            name.compare(name.size() - gz_ext.size(), gz_ext.size(), gz_ext) == 0) {
+            name.resize(name.size() - gz_ext.size());  // compressed
+        }
+        if (name.size() <= prefix.size() + ext.size() ||
+            name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - ext.size(), ext.size(), ext) != 0) {
+            continue;
+        }
+        auto digits = name.substr(prefix.size(), name.size() - prefix.size() - ext.size());
+        if (digits.size() > 18 ||
+            digits.find_first_not_of(SPDLOG_FILENAME_T("0123456789")) != filename_t::npos) {
+            continue;
+        }
+        std::size_t index = 0;
+        for (auto c : digits) {
+            index = index * 10 + static_cast<std::size_t>(c - SPDLOG_FILENAME_T('0'));
+        }
+        indices.push_back(index);
+    }
+    if (indices.empty()) {
+        return 0;
+    }
+    auto last = *std::max_element(indices.begin(), indices.end());
+    for (auto index : indices) {
+        if (index + max_files_ <= last) {
+            auto filename = calc_filename(base_filename_, index);
+            (void)details::os::remove(filename);
+            (void)details::os::remove(
+                details::compressed_filename(filename, file_compression::gzip));
+        }
+    }
+    return last;
+}
+
+template <typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::rotate_in_background_() {
+    using details::os::filename_to_str;
+
+    auto error = housekeeper_->take_error();
+    file_helper_.close();
+    filename_t basename, ext;
+    std::tie(basename, ext) = details::file_helper::split_by_extension(base_filename_);
+    auto pending = fmt_lib::format(SPDLOG_FMT_STRING(SPDLOG_FILENAME_T("{}.rotating{}{}")),
+                                   basename, pending_count_++, ext);
+    if (!rename_file_(base_filename_, pending)) {
+        file_helper_.reopen(true);
+        current_size_ = 0;
+        throw_spdlog_ex("rotating_file_sink: failed renaming " + filename_to_str(base_filename_) +
+                            " to " + filename_to_str(pending),
+                        errno);
+    }
+    file_helper_.reopen(true);
+    auto compression = compression_;
+    housekeeper_->post([this, pending, compression] { return shift_files_(pending, compression); });
+    if (max_total_size_ > 0) {
+        auto budget = full_files_budget_();
+        housekeeper_->post([this, budget] { return trim_to_budget_(1, budget); });
+    }
+    if (!error.empty()) {
+        throw_spdlog_ex(error);
+    }
+}
+
+template <typename Mutex>
+SPDLOG_INLINE std::string rotating_file_sink<Mutex>::shift_files_(
+    const filename_t &pending_filename, const compression_options &compression) {
+    using details::os::filename_to_str;
+
+    // log.1.txt -> log.2.txt .. as in rotate_(), then the pending file -> log.1.txt
+    auto rename = [&](const filename_t &src, const filename_t &target) {
+        if (!details::os::path_exists(src) || rename_file_(src, target)) {
+            return std::string{};
+        }
+        details::os::sleep_for_millis(100);
+        if (rename_file_(src, target)) {
+            return std::string{};
+        }
+        auto err = errno;
+        (void)details::os::remove(pending_filename);
+        return std::string(spdlog_ex("rotating_file_sink: failed renaming " +
+                                         filename_to_str(src) + " to " + filename_to_str(target),
+                                     err)
+                               .what());
+    };
+    auto type = compression.type;
+    for (auto i = max_files_; i > 1; --i) {
+        auto src = calc_filename(base_filename_, i - 1);
+        auto target = calc_filename(base_filename_, i);
+        auto error = rename(src, target);
+        if (error.empty() && type != file_compression::none) {
+            error = rename(details::compressed_filename(src, type),
+                           details::compressed_filename(target, type));
+        }
+        if (!error.empty()) {
+            return error;
+        }
+    }
+    auto first = calc_filename(base_filename_, 1);
+    auto error = rename(pending_filename, first);
+    if (!error.empty()) {
+        return error;
+    }
+    return details::compress_file(first, compression);
+}
+
+template <typename Mutex>
+SPDLOG_INLINE std::string rotating_file_sink<Mutex>::trim_to_budget_(std::size_t newest_index,
+                                                                    std::size_t budget) {
+    // the full files from the newest: 1, 2.. with rotation_naming::shift, last, last - 1.. with
+    // rotation_naming::increasing
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < max_files_; i++) {
+        std::size_t index;
+        if (naming_ == rotation_naming::increasing) {
+            if (i >= newest_index) {
+                break;
+            }
+            index = newest_index - i;
+        } else {
+            index = newest_index + i;
+        }
+        auto filename = calc_filename(base_filename_, index);
+        auto compressed = details::compressed_filename(filename, file_compression::gzip);
+        total += details::os::path_size(filename) + details::os::path_size(compressed);
+        if (total > budget) {
+            (void)details::os::remove_if_exists(filename);
+            (void)details::os::remove_if_exists(compressed);
+        }
+    }
+    return std::string{};
+}
+
 // delete the target if exists, and rename the src file  to target
 // return true on success, false otherwise.
 template <typename Mutex>
@@ -4,20 +4,52 @@
 #pragma once
 
 #include <spdlog/details/file_helper.h>
+#include <spdlog/details/file_housekeeper.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/details/synchronous_factory.h>
 #include <spdlog/sinks/base_sink.h>
 
 #include <chrono>
+#include <memory>
 #include <mutex>
 #include <string>
 
 namespace spdlog {
 namespace sinks {
 
+// How the full files are named:
+// shift      - log.txt -> log.1.txt, log.1.txt -> log.2.txt .. log.<max_files>.txt -> delete.
+//              Rotating costs max_files renames.
+// increasing - log.txt -> log.<n>.txt, with n one more than the previous one (found in the
+//              directory when the sink is created), and log.<n - max_files>.txt -> delete.
+//              Rotating costs a rename and a remove. The newest full file has the highest index.
+enum class rotation_naming { shift, increasing };
+
 //
 // Rotating file sink based on size
 //
+// With background_rotation (and rotation_naming::shift), rotating only renames the full file to
+// a pending name and opens a new one, and a housekeeping thread of the sink renames the older
+// files and gives the pending one its final name. A failure there is reported (as spdlog_ex) by
+// the next rotation.
+//
+// With set_compression(), the full files are compressed by the housekeeping thread too (log.1.txt
+// becoming log.1.txt.gz), which implies background_rotation for rotation_naming::shift.
+//
+// The size of the file is counted as the messages are written, and read from the file only when
+// the sink is created and when the count reaches max_size. With set_size_check_interval(), it is
+// also read again by the first message logged after each interval, so the count follows the file
+// being truncated by another process (e.g. logrotate's copytruncate: the file is opened in append
+// mode, so the next messages are written at its new end) or written to by another one.
+//
+// With set_rotation_interval(), the file is also rotated by the first message logged in each new
+// interval (counted from the epoch, in UTC: hours(1) rotates on the hour), if it isn't empty.
+//
+// With set_max_total_size(), the housekeeping thread deletes the oldest full files after each
+// rotation until they take no more than the total size minus max_size (kept for the current
+// file), on top of the max_files limit. Like set_compression(), it implies background_rotation
+// for rotation_naming::shift.
+//
 template <typename Mutex>
 class rotating_file_sink final : public base_sink<Mutex> {
 public:
@@ -25,15 +57,67 @@ public:
                        std::size_t max_size,
                        std::size_t max_files,
                        bool rotate_on_open = false,
-                       const file_event_handlers &event_handlers = {});
+                       const file_event_handlers &event_handlers = {},
+                       bool background_rotation = false,
+                       rotation_naming naming = rotation_naming::shift);
+    ~rotating_file_sink() override;
     static filename_t calc_filename(const filename_t &filename, std::size_t index);
     filename_t filename();
 
+    // compress the files from now on. throw spdlog_ex if the compression isn't available.
+    void set_compression(const compression_options &options);
+
+    // re-read the size of the file every interval (0, the default, for never)
+    void set_size_check_interval(std::chrono::seconds interval);
+
+    // rotate at the start of every interval too (0, the default, for never)
+    void set_rotation_interval(std::chrono::seconds interval);
+
+    // limit the size of all the files together (0, the default, for no limit)
+    void set_max_total_size(std::size_t max_total_size);
+
 protected:
     void sink_it_(const details::log_msg &msg) override;
+    void sink_batch_(const details::log_msg *msgs, size_t count) override;
     void flush_() override;
 
 private:
+    // re-read the size of the file if the check interval elapsed at the time of the message
+    void check_size_(log_clock::time_point now) {
+        if (size_check_interval_.count() > 0 && now >= next_size_check_) {
+            current_size_ = file_helper_.size();
+            next_size_check_ = now + size_check_interval_;
+        }
+    }
+
+    // rotate if the message is the first one of a new rotation interval
+    void rotate_on_time_(log_clock::time_point now) {
+        if (rotation_interval_.count() > 0 && now >= next_rotation_) {
+            if (current_size_ > 0) {
+                file_helper_.flush();
+                if (file_helper_.size() > 0) {
+                    rotate_();
+                }
+                current_size_ = 0;
+            }
+            next_rotation_ = next_rotation_time_(now);
+        }
+    }
+
+    log_clock::time_point next_rotation_time_(log_clock::time_point now) const;
+
+    // the msg_field bits of the checks reading the message times
+    unsigned own_fields_();
+
+    // delete the oldest full files over the budget (on the housekeeping thread), the newest
+    // being newest_index. return the error message on failure.
+    std::string trim_to_budget_(std::size_t newest_index, std::size_t budget);
+
+    // the part of max_total_size_ the full files can take
+    std::size_t full_files_budget_() const {
+        return max_total_size_ > max_size_ ? max_total_size_ - max_size_ : 0;
+    }
+
     // Rotate files:
     // log.txt -> log.1.txt
     // log.1.txt -> log.2.txt
@@ -41,6 +125,20 @@ private:
     // log.3.txt -> delete
     void rotate_();
 
+    // log.txt -> log.<last_index_ + 1>.txt, and delete the file max_files before
+    void rotate_increasing_();
+
+    // highest index of the full files in the directory, deleting the ones over max_files
+    std::size_t scan_last_index_();
+
+    // log.txt -> log.rotating<n>.txt, and the rest of rotate_() posted to the housekeeper
+    void rotate_in_background_();
+
+    // rotate_() with the pending file instead of log.txt (on the housekeeping thread), then
+    // compress log.1.txt. return the error message on failure.
+    std::string shift_files_(const filename_t &pending_filename,
+                             const compression_options &compression);
+
     // delete the target if exists, and rename the src file  to target
     // return true on success, false otherwise.
     bool rename_file_(const filename_t &src_filename, const filename_t &target_filename);
@@ -50,11 +148,26 @@ private:
     std::size_t max_files_;
     std::size_t current_size_;
     details::file_helper file_helper_;
+    std::chrono::seconds size_check_interval_{0};
+    log_clock::time_point next_size_check_;
+    std::chrono::seconds rotation_interval_{0};
+    log_clock::time_point next_rotation_;
+    std::size_t max_total_size_ = 0;
+
+    rotation_naming naming_;
+    std::size_t last_index_ = 0;  // of the newest full file, with rotation_naming::increasing
+    std::size_t pending_count_ = 0;
+    compression_options compression_;
+    // with background_rotation or compression. last, so it's done before the members go away.
+    std::unique_ptr<details::file_housekeeper> housekeeper_;
 };
 
 using rotating_file_sink_mt = rotating_file_sink<std::mutex>;
 using rotating_file_sink_st = rotating_file_sink<details::null_mutex>;
 
+template <typename Mutex>
+struct shares_file<rotating_file_sink<Mutex>> : std::true_type {};
+
 }  // namespace sinks
 
 //
@@ -67,9 +180,13 @@ inline std::shared_ptr<logger> rotating_logger_mt(const std::string &logger_name
                                                   size_t max_file_size,
                                                   size_t max_files,
                                                   bool rotate_on_open = false,
-                                                  const file_event_handlers &event_handlers = {}) {
+                                                  const file_event_handlers &event_handlers = {},
+                                                  bool background_rotation = false,
+                                                  sinks::rotation_naming naming =
+                                                      sinks::rotation_naming::shift) {
     return Factory::template create<sinks::rotating_file_sink_mt>(
-        logger_name, filename, max_file_size, max_files, rotate_on_open, event_handlers);
+        logger_name, filename, max_file_size, max_files, rotate_on_open, event_handlers,
+        background_rotation, naming);
 }
 
 template <typename Factory = spdlog::synchronous_factory>
@@ -78,12 +195,20 @@ inline std::shared_ptr<logger> rotating_logger_st(const std::string &logger_name
                                                   size_t max_file_size,
                                                   size_t max_files,
                                                   bool rotate_on_open = false,
-                                                  const file_event_handlers &event_handlers = {}) {
+                                                  const file_event_handlers &event_handlers = {},
+                                                  bool background_rotation = false,
+                                                  sinks::rotation_naming naming =
+                                                      sinks::rotation_naming::shift) {
     return Factory::template create<sinks::rotating_file_sink_st>(
-        logger_name, filename, max_file_size, max_files, rotate_on_open, event_handlers);
+        logger_name, filename, max_file_size, max_files, rotate_on_open, event_handlers,
+        background_rotation, naming);
 }
 }  // namespace spdlog
 
 #ifdef SPDLOG_HEADER_ONLY
     #include "rotating_file_sink-inl.h"
+    #ifdef SPDLOG_EXTERN_TEMPLATES  // defined in spdlog/instantiate.h
+extern template class spdlog::sinks::rotating_file_sink<std::mutex>;
+extern template class spdlog::sinks::rotating_file_sink<spdlog::details::null_mutex>;
+    #endif
 #endif
@@ -0,0 +1,107 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef _WIN32
+    #error shm_ring_sink is not supported on windows
+#endif
+
+// Sink writing each formatted message as a record of a POSIX shared memory ring (see shm_ring.h
+// for the layout), for a sidecar process (e.g. a log shipper) reading it with the
+// shm_ring_reader. Logging never blocks on the reader and makes no system call: when the ring is
+// full, the messages are dropped (see dropped()). The batches of messages (from the async
+// loggers) are published at once.
+//
+// The ring is created if needed, kept if it exists with the same capacity, and left in place
+// when the sink is destroyed (the reader calls shm_ring_reader::remove() when done with it).
+// With the binary_formatter, each record holds the binary entries of one message, the stream
+// starting again with a header after a message dropped.
+//
+// Link with -lrt for glibc older than 2.34.
+//
+// Usage example:
+// auto logger = spdlog::shm_ring_logger_mt("shm", "/myapp_logs", 16 * 1024 * 1024);
+
+#include <spdlog/binary_formatter.h>
+#include <spdlog/common.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/shm_ring.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <mutex>
+#include <string>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class shm_ring_sink final : public base_sink<Mutex> {
+public:
+    // name is the shared memory object name ("/something"), capacity the size of the ring's
+    // data, rounded up to a power of 2
+    explicit shm_ring_sink(const std::string &name, size_t capacity = 4 * 1024 * 1024)
+        : ring_(name, capacity) {
+        base_sink<Mutex>::set_own_fields_(msg_field::none);
+    }
+
+    // number of messages dropped because the ring was full, since it was created
+    size_t dropped() { return ring_.dropped(); }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        append_(msg);
+        ring_.publish();
+    }
+
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        for (size_t i = 0; i < count; i++) {
+            append_(msgs[i]);
+        }
+        ring_.publish();
+    }
+
+    // the records are visible to the reader once published
+    void flush_() override {}
+
+private:
+    shm_ring_writer ring_;
+    memory_buf_t formatted_;
+
+    void append_(const details::log_msg &msg) {
+        formatted_.clear();
+        base_sink<Mutex>::formatter_->format(msg, formatted_);
+        if (!ring_.append(formatted_.data(), formatted_.size())) {
+            // the dropped record might have defined ids the next ones use
+            auto *binary = dynamic_cast<binary_formatter *>(base_sink<Mutex>::formatter_.get());
+            if (binary != nullptr) {
+                binary->reset();
+            }
+        }
+    }
+};
+
+using shm_ring_sink_mt = shm_ring_sink<std::mutex>;
+using shm_ring_sink_st = shm_ring_sink<details::null_mutex>;
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> shm_ring_logger_mt(const std::string &logger_name,
+                                                  const std::string &name,
+                                                  size_t capacity = 4 * 1024 * 1024) {
+    return Factory::template create<sinks::shm_ring_sink_mt>(logger_name, name, capacity);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> shm_ring_logger_st(const std::string &logger_name,
+                                                  const std::string &name,
+                                                  size_t capacity = 4 * 1024 * 1024) {
+    return Factory::template create<sinks::shm_ring_sink_st>(logger_name, name, capacity);
+}
+
+}  // namespace spdlog
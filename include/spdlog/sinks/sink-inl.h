@@ -13,6 +13,22 @@ SPDLOG_INLINE bool spdlog::sinks::sink::should_log(spdlog::level::level_enum msg
     return msg_level >= level_.load(std::memory_order_relaxed);
 }
 
+SPDLOG_INLINE bool spdlog::sinks::sink::should_log(const details::log_msg &msg) const {
+    return should_log(msg.level) && !skip_suspended_() && (!filter_ || (*filter_)(msg));
+}
+
+SPDLOG_INLINE void spdlog::sinks::sink::set_filter(std::shared_ptr<sink_filter> filter) {
+    filter_ = std::move(filter);
+}
+
+SPDLOG_INLINE void spdlog::sinks::sink::log_batch(const details::log_msg *msgs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (should_log(msgs[i])) {
+            log(msgs[i]);
+        }
+    }
+}
+
 SPDLOG_INLINE void spdlog::sinks::sink::set_level(level::level_enum log_level) {
     level_.store(log_level, std::memory_order_relaxed);
 }
@@ -20,3 +36,55 @@ SPDLOG_INLINE void spdlog::sinks::sink::set_level(level::level_enum log_level) {
 SPDLOG_INLINE spdlog::level::level_enum spdlog::sinks::sink::level() const {
     return static_cast<spdlog::level::level_enum>(level_.load(std::memory_order_relaxed));
 }
+
+SPDLOG_INLINE unsigned spdlog::sinks::sink::needed_fields() const {
+    return needed_fields_.load(std::memory_order_relaxed);
+}
+
+SPDLOG_INLINE bool spdlog::sinks::sink::claim_exclusive(std::thread::id) { return false; }
+
+SPDLOG_INLINE void spdlog::sinks::sink::release_exclusive() {}
+
+SPDLOG_INLINE void spdlog::sinks::sink::set_retry_interval(std::chrono::milliseconds interval) {
+    retry_interval_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count(),
+                             std::memory_order_relaxed);
+    if (interval.count() == 0) {
+        suspended_until_.store(0, std::memory_order_relaxed);
+    }
+}
+
+SPDLOG_INLINE bool spdlog::sinks::sink::suspended() const {
+    auto until = suspended_until_.load(std::memory_order_relaxed);
+    return until != 0 && now_ns_() < until;
+}
+
+SPDLOG_INLINE size_t spdlog::sinks::sink::suspended_drops() const {
+    return suspended_drops_.load(std::memory_order_relaxed);
+}
+
+SPDLOG_INLINE void spdlog::sinks::sink::on_error() {
+    auto interval = retry_interval_ns_.load(std::memory_order_relaxed);
+    if (interval > 0) {
+        suspended_until_.store(now_ns_() + interval, std::memory_order_relaxed);
+    }
+}
+
+SPDLOG_INLINE std::int64_t spdlog::sinks::sink::now_ns_() {
+    return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+}
+
+SPDLOG_INLINE bool spdlog::sinks::sink::skip_suspended_() const {
+    auto until = suspended_until_.load(std::memory_order_relaxed);
+    if (until == 0) {
+        return false;
+    }
+    if (now_ns_() < until) {
+        suspended_drops_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    // retry with this message: it suspends the sink again if it fails
+    suspended_until_.compare_exchange_strong(until, 0, std::memory_order_relaxed);
+    return false;
+}
@@ -5,6 +5,14 @@
 
 #include <spdlog/details/log_msg.h>
 #include <spdlog/formatter.h>
+#include <spdlog/sinks/sink_filter.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
 
 namespace spdlog {
 
@@ -13,6 +21,9 @@ class SPDLOG_API sink {
 public:
     virtual ~sink() = default;
     virtual void log(const details::log_msg &msg) = 0;
+    // log a batch of messages (those not passing should_log() are skipped).
+    // the default calls log() for each message, sinks can override it to lock only once.
+    virtual void log_batch(const details::log_msg *msgs, size_t count);
     virtual void flush() = 0;
     virtual void set_pattern(const std::string &pattern) = 0;
     virtual void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) = 0;
@@ -20,12 +31,53 @@ public:
     void set_level(level::level_enum log_level);
     level::level_enum level() const;
     bool should_log(level::level_enum msg_level) const;
+    // the level and the filter (if any), checked before logging a message to the sink
+    bool should_log(const details::log_msg &msg) const;
+    // set (or remove, with nullptr) the filter before logging to the sink
+    void set_filter(std::shared_ptr<sink_filter> filter);
+    // the msg_field bits of the fields the sink reads. the loggers don't fill the others.
+    unsigned needed_fields() const;
+
+    // let only the owner thread (e.g. the worker of a single thread pool) use the sink from
+    // now on, so it can skip its locking. true if the sink supports it (see base_sink).
+    // release_exclusive() must be called once the owner no longer uses the sink.
+    virtual bool claim_exclusive(std::thread::id owner);
+    virtual void release_exclusive();
+
+    // once logging to (or flushing) the sink failed, skip it for the given interval before
+    // trying again, instead of failing again on each message. 0 (the default) to keep trying.
+    void set_retry_interval(std::chrono::milliseconds interval);
+    // whether the sink is skipped after a failure
+    bool suspended() const;
+    // the messages skipped while suspended
+    size_t suspended_drops() const;
+    // called by the loggers when logging to (or flushing) the sink failed
+    void on_error();
 
 protected:
     // sink log level - default is all
     level_t level_{level::trace};
+    // sinks reading only some fields (e.g. only those of their formatter) update it
+    std::atomic<unsigned> needed_fields_{msg_field::all};
+    std::shared_ptr<sink_filter> filter_;
+
+private:
+    std::atomic<std::int64_t> retry_interval_ns_{0};
+    // steady_clock time (ns) until which the sink is skipped, 0 if it is not
+    mutable std::atomic<std::int64_t> suspended_until_{0};
+    mutable std::atomic<size_t> suspended_drops_{0};
+
+    static std::int64_t now_ns_();
+    // whether to skip a message because the sink is suspended (and count it if so). the first
+    // message after the retry interval lifts the suspension.
+    bool skip_suspended_() const;
 };
 
+// whether the loggers created by the factory functions for the same file can share a Sink
+// (see spdlog::set_sink_sharing): specialized by the file sinks, taking the filename first
+template <typename Sink>
+struct shares_file : std::false_type {};
+
 }  // namespace sinks
 }  // namespace spdlog
 
@@ -0,0 +1,109 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Filter of the messages a sink logs, besides its level, checked before the message is
+// formatted: by logger name, by mdc entry, by sampling, or with a predicate. A message has to
+// pass all the conditions set.
+//
+// The mdc is the one of the thread logging to the sink: the thread pool's worker for the
+// async loggers, which don't carry the mdc of the logging threads.
+//
+// Usage example:
+// auto filter = std::make_shared<spdlog::sinks::sink_filter>();
+// filter->loggers({"net", "db"}).sample(0.1);
+// sink->set_filter(filter);
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/mdc.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+class sink_filter {
+public:
+    // only the messages of these loggers
+    sink_filter &loggers(std::vector<std::string> names) {
+        loggers_ = std::move(names);
+        has_loggers_ = true;
+        return *this;
+    }
+
+    // only the messages logged with key in the mdc (with this value if not empty)
+    sink_filter &mdc_key(std::string key, std::string value = {}) {
+        mdc_key_ = std::move(key);
+        mdc_value_ = std::move(value);
+        return *this;
+    }
+
+    // only this ratio (0 to 1) of the messages passing the other conditions, evenly spread
+    sink_filter &sample(double ratio) {
+        if (ratio < 0 || ratio > 1) {
+            throw_spdlog_ex("sink_filter: invalid sampling ratio " + std::to_string(ratio));
+        }
+        // out of 2^32 per message, not to convert the count to double
+        sample_step_ = static_cast<std::uint64_t>(ratio * 4294967296.0);
+        return *this;
+    }
+
+    // only the messages for which predicate(msg) is true
+    sink_filter &predicate(std::function<bool(const details::log_msg &)> predicate) {
+        predicate_ = std::move(predicate);
+        return *this;
+    }
+
+    bool operator()(const details::log_msg &msg) const {
+        if (has_loggers_ && !has_logger_(msg.logger_name)) {
+            return false;
+        }
+#ifndef SPDLOG_NO_TLS
+        if (!mdc_key_.empty()) {
+            string_view_t value;
+            if (!mdc::get_context().find(mdc_key_, value) ||
+                (!mdc_value_.empty() && value != string_view_t(mdc_value_))) {
+                return false;
+            }
+        }
+#endif
+        if (predicate_ && !predicate_(msg)) {
+            return false;
+        }
+        if (sample_step_ < full_step_) {
+            // passes when the accumulated ratio crosses an integer
+            auto before = sampled_.fetch_add(sample_step_, std::memory_order_relaxed);
+            return ((before + sample_step_) >> 32) != (before >> 32);
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::uint64_t full_step_ = std::uint64_t(1) << 32;
+
+    std::vector<std::string> loggers_;
+    bool has_loggers_ = false;
+    std::string mdc_key_;
+    std::string mdc_value_;
+    std::uint64_t sample_step_ = full_step_;
+    mutable std::atomic<std::uint64_t> sampled_{0};
+    std::function<bool(const details::log_msg &)> predicate_;
+
+    bool has_logger_(string_view_t name) const {
+        for (const auto &logger_name : loggers_) {
+            if (name == string_view_t(logger_name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+}  // namespace sinks
+}  // namespace spdlog
@@ -0,0 +1,349 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef _WIN32
+    #error spill_sink is not supported on windows
+#endif
+
+// Sink decorating a downstream sink which can be slow or failing (tcp, udp, kafka, http..):
+// the messages are queued, and a background thread logs them to the downstream sink, so logging
+// never waits for it. Up to max_memory_bytes of messages are kept in memory, the next ones are
+// appended to the spill file (as binary_formatter records), up to max_spill_bytes, and dropped
+// beyond (see dropped()).
+//
+// When the downstream sink throws, the message is logged again with exponential backoff, and
+// the messages keep their order: those in memory, then the spill file, which is renamed to
+// spill_filename + ".replay" and replayed from a read only mapping, then the next ones.
+//
+// When the sink is destroyed while the downstream sink is failing, the messages in memory are
+// dropped, and the spill files are left on disk, to be replayed by the next sink using them
+// (the replay file from the start, so some of its messages can be logged twice).
+//
+// Usage example:
+// auto tcp = std::make_shared<spdlog::sinks::tcp_sink_mt>(tcp_cfg);
+// spdlog::sinks::spill_sink_config cfg("logs/tcp_spill.bin");
+// auto sink = std::make_shared<spdlog::sinks::spill_sink_mt>(tcp, cfg);
+
+#include <spdlog/binary_formatter.h>
+#include <spdlog/common.h>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace spdlog {
+namespace sinks {
+
+struct spill_sink_config {
+    filename_t spill_filename;
+    size_t max_memory_bytes = 4 * 1024 * 1024;     // of the messages queued in memory
+    size_t max_spill_bytes = 1024 * 1024 * 1024;  // of the spill file
+    std::chrono::milliseconds retry_min_delay{100};
+    std::chrono::milliseconds retry_max_delay{30000};
+
+    explicit spill_sink_config(filename_t filename)
+        : spill_filename{std::move(filename)} {}
+};
+
+template <typename Mutex>
+class spill_sink final : public base_sink<Mutex> {
+public:
+    spill_sink(std::shared_ptr<sink> downstream, spill_sink_config sink_config)
+        : downstream_{std::move(downstream)},
+          config_{std::move(sink_config)},
+          replay_filename_{config_.spill_filename + SPDLOG_FILENAME_T(".replay")} {
+        if (!downstream_) {
+            throw_spdlog_ex("spill_sink: the downstream sink cannot be null");
+        }
+        // left by a previous sink, older than the spill file
+        replaying_ = details::os::path_exists(replay_filename_);
+        spill_.open(config_.spill_filename);
+        spill_open_ = true;
+        spill_size_ = spill_.size();
+        // the spill file keeps all the fields, the downstream sink formats
+        base_sink<Mutex>::set_own_fields_(msg_field::all, false);
+        worker_ = std::thread([this] { worker_loop_(); });
+    }
+
+    spill_sink(const spill_sink &) = delete;
+    spill_sink &operator=(const spill_sink &) = delete;
+
+    // log what is left to the downstream sink, unless it was failing
+    ~spill_sink() override {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        worker_.join();
+        close_replay_();
+        flush_downstream_();
+    }
+
+    // number of messages dropped: beyond max_spill_bytes, or in memory when destroyed while the
+    // downstream sink was failing
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    std::shared_ptr<sink> downstream() const { return downstream_; }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            auto size = memory_size_(msg);
+            // once spilling, everything goes to the spill file until it's taken, for the order
+            if (spill_size_ == 0 && pending_bytes_ + size <= config_.max_memory_bytes) {
+                pending_.emplace_back(msg);
+                pending_bytes_ += size;
+            } else if (!spill_open_ || spill_size_ >= config_.max_spill_bytes) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                spill_buf_.clear();
+                spill_formatter_.format(msg, spill_buf_);
+                spill_.write(spill_buf_);
+                spill_size_ += spill_buf_.size();
+            }
+        }
+        cv_.notify_one();
+    }
+
+    // flush the downstream sink once the messages queued are logged
+    void flush_() override {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            flush_requested_ = true;
+        }
+        cv_.notify_one();
+    }
+
+    void set_pattern_(const std::string &pattern) override { downstream_->set_pattern(pattern); }
+
+    void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        downstream_->set_formatter(std::move(sink_formatter));
+    }
+
+private:
+    std::shared_ptr<sink> downstream_;
+    spill_sink_config config_;
+    filename_t replay_filename_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable cv_;
+    std::deque<details::log_msg_buffer> pending_;  // in memory, before the spill file
+    size_t pending_bytes_ = 0;
+    details::file_helper spill_;  // messages not fitting in pending_, logged after them
+    bool spill_open_ = false;
+    size_t spill_size_ = 0;
+    binary_formatter spill_formatter_;
+    memory_buf_t spill_buf_;
+    bool flush_requested_ = false;
+    bool stop_ = false;
+    std::atomic<size_t> dropped_{0};
+
+    // owned by the worker: taken from pending_ and the spill file, logged in this order
+    std::deque<details::log_msg_buffer> sending_;
+    bool replaying_ = false;  // the replay file is to be logged
+    const char *replay_data_ = nullptr;
+    size_t replay_size_ = 0;
+    std::unique_ptr<binary_log_reader> replay_reader_;
+    details::log_msg replay_msg_;
+    bool replay_msg_read_ = false;  // replay_msg_ is still to be logged
+    bool failed_ = false;           // the downstream sink threw at the last attempt
+    std::thread worker_;
+
+    static size_t memory_size_(const details::log_msg &msg) {
+        return sizeof(details::log_msg_buffer) + msg.logger_name.size() + msg.payload.size() +
+               msg.thread_name.size();
+    }
+
+    bool has_work_() const {
+        return !pending_.empty() || spill_size_ > 0 || !sending_.empty() || replaying_;
+    }
+
+    // move the messages waiting to the worker's side, once it logged the previous ones
+    void take_() {
+        if (!sending_.empty() || replaying_) {
+            return;
+        }
+        sending_.swap(pending_);
+        pending_bytes_ = 0;
+        if (spill_size_ == 0) {
+            return;
+        }
+        SPDLOG_TRY {
+            spill_open_ = false;
+            spill_.close();
+            replaying_ = details::os::rename(config_.spill_filename, replay_filename_) == 0;
+            spill_.open(config_.spill_filename, replaying_);
+            spill_open_ = true;
+            if (replaying_) {
+                spill_size_ = 0;
+                spill_formatter_.reset();  // the new file starts with a header
+            }
+        }
+        SPDLOG_CATCH_STD
+    }
+
+    void worker_loop_() {
+        auto delay = config_.retry_min_delay;
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || flush_requested_ || has_work_(); });
+            if (!has_work_()) {
+                if (flush_requested_) {
+                    flush_requested_ = false;
+                    lock.unlock();
+                    flush_downstream_();
+                    lock.lock();
+                    continue;
+                }
+                return;  // stopped
+            }
+            take_();
+            auto stopping = stop_;
+            if (sending_.empty() && !replaying_) {
+                // the spill file couldn't be taken yet
+                if (stopping) {
+                    return;
+                }
+                cv_.wait_for(lock, delay, [this] { return stop_; });
+                continue;
+            }
+            lock.unlock();
+            // no more attempts when stopping after a failure, the destructor shouldn't wait
+            bool logged = (!stopping || !failed_) && log_taken_();
+            failed_ = !logged;
+            lock.lock();
+            if (logged) {
+                delay = config_.retry_min_delay;
+                continue;
+            }
+            if (stopping) {
+                dropped_.fetch_add(sending_.size() + pending_.size(), std::memory_order_relaxed);
+                return;
+            }
+            cv_.wait_for(lock, delay, [this] { return stop_; });
+            delay = (std::min)(delay * 2, config_.retry_max_delay);
+        }
+    }
+
+    void flush_downstream_() {
+        SPDLOG_TRY { downstream_->flush(); }
+        SPDLOG_CATCH_STD
+    }
+
+    // log the messages taken to the downstream sink. false if it threw, the message failing
+    // being the first one to log at the next attempt
+    bool log_taken_() {
+        SPDLOG_TRY {
+            while (!sending_.empty()) {
+                if (downstream_->should_log(sending_.front())) {
+                    downstream_->log(sending_.front());
+                }
+                sending_.pop_front();
+            }
+            if (replaying_) {
+                replay_();
+            }
+            return true;
+        }
+        SPDLOG_CATCH_STD
+        return false;
+    }
+
+    void replay_() {
+        if (!replay_reader_ && !open_replay_()) {
+            finish_replay_();
+            return;
+        }
+        for (;;) {
+            if (!replay_msg_read_) {
+                if (!next_replay_msg_()) {
+                    break;
+                }
+                replay_msg_read_ = true;
+            }
+            if (downstream_->should_log(replay_msg_)) {
+                downstream_->log(replay_msg_);
+            }
+            replay_msg_read_ = false;
+        }
+        finish_replay_();
+    }
+
+    // false if there is nothing to replay
+    bool open_replay_() {
+        int fd = ::open(replay_filename_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        void *ptr = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            replay_size_ = static_cast<size_t>(st.st_size);
+            ptr = ::mmap(nullptr, replay_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (ptr == MAP_FAILED) {
+            return false;
+        }
+#ifdef MADV_SEQUENTIAL
+        ::madvise(ptr, replay_size_, MADV_SEQUENTIAL);
+#endif
+        replay_data_ = static_cast<const char *>(ptr);
+        SPDLOG_TRY {
+            replay_reader_ =
+                details::make_unique<binary_log_reader>(string_view_t(replay_data_, replay_size_));
+            return true;
+        }
+        SPDLOG_CATCH_STD
+        close_replay_();
+        return false;
+    }
+
+    // a replay file which is not a binary log (any more) is dropped
+    bool next_replay_msg_() {
+        SPDLOG_TRY { return replay_reader_->next(replay_msg_); }
+        SPDLOG_CATCH_STD
+        return false;
+    }
+
+    void close_replay_() {
+        replay_reader_.reset();
+        if (replay_data_ != nullptr) {
+            ::munmap(const_cast<char *>(replay_data_), replay_size_);
+            replay_data_ = nullptr;
+        }
+    }
+
+    void finish_replay_() {
+        close_replay_();
+        (void)details::os::remove(replay_filename_);
+        replaying_ = false;
+    }
+};
+
+using spill_sink_mt = spill_sink<std::mutex>;
+using spill_sink_st = spill_sink<details::null_mutex>;
+
+}  // namespace sinks
+}  // namespace spdlog
@@ -0,0 +1,266 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/sinks/sink.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Pipeline stages added to a sink, e.g. for redaction, sampling, enrichment or metrics.
+// A stage is a class with any of:
+//
+//   bool pre_format(details::log_msg &msg);
+//       before the message is formatted: may change the copy of the message it's given (e.g.
+//       point its payload to a buffer of the stage, reused by the next message), or return
+//       false to drop the message.
+//   void post_format(const details::log_msg &msg, memory_buf_t &formatted);
+//       once formatted, before the sink writes it: may change the formatted message.
+//   unsigned needed_fields() const;
+//       the msg_field bits of the fields the stage reads (none if not declared).
+//
+// The stages are called in order, without virtual calls nor std::function. A sink gets no
+// formatter wrapper without post_format stages, and no copy of the messages without
+// pre_format stages. pre_format() is called under the lock of the staged sink (held until
+// the sink logged the message), post_format() under the lock of the sink.
+//
+// Example:
+//
+//     struct redact_digits {
+//         void post_format(const spdlog::details::log_msg &, spdlog::memory_buf_t &formatted) {
+//             std::replace_if(formatted.begin(), formatted.end(), ::isdigit, '#');
+//         }
+//     };
+//     auto file = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/app.log");
+//     auto sink = spdlog::sinks::make_staged_sink<std::mutex>(file, redact_digits{});
+
+namespace spdlog {
+namespace details {
+
+template <typename Stage, typename = void>
+struct has_pre_format : std::false_type {};
+
+template <typename Stage>
+struct has_pre_format<
+    Stage,
+    decltype(void(std::declval<Stage &>().pre_format(std::declval<log_msg &>())))>
+    : std::true_type {};
+
+template <typename Stage, typename = void>
+struct has_post_format : std::false_type {};
+
+template <typename Stage>
+struct has_post_format<Stage,
+                       decltype(void(std::declval<Stage &>().post_format(
+                           std::declval<const log_msg &>(), std::declval<memory_buf_t &>())))>
+    : std::true_type {};
+
+template <bool...>
+struct any_stage : std::false_type {};
+
+template <bool First, bool... Others>
+struct any_stage<First, Others...>
+    : std::integral_constant<bool, First || any_stage<Others...>::value> {};
+
+template <typename Stage>
+auto stage_pre_format(Stage &stage, log_msg &msg, int) -> decltype(stage.pre_format(msg)) {
+    return stage.pre_format(msg);
+}
+
+template <typename Stage>
+bool stage_pre_format(Stage &, log_msg &, long) {
+    return true;
+}
+
+template <typename Stage>
+auto stage_post_format(Stage &stage, const log_msg &msg, memory_buf_t &formatted, int)
+    -> decltype(stage.post_format(msg, formatted)) {
+    stage.post_format(msg, formatted);
+}
+
+template <typename Stage>
+void stage_post_format(Stage &, const log_msg &, memory_buf_t &, long) {}
+
+template <typename Stage>
+auto stage_needed_fields(const Stage &stage, int) -> decltype(stage.needed_fields()) {
+    return stage.needed_fields();
+}
+
+template <typename Stage>
+unsigned stage_needed_fields(const Stage &, long) {
+    return msg_field::none;
+}
+
+}  // namespace details
+
+namespace sinks {
+
+// the sink given to the ctor gets a new formatter (a pattern_formatter with the default
+// pattern): its pattern must be set through the staged sink.
+template <typename Mutex, typename... Stages>
+class staged_sink final : public sink {
+    using stages_t = std::tuple<Stages...>;
+    static constexpr bool pre_formats =
+        details::any_stage<details::has_pre_format<Stages>::value...>::value;
+    static constexpr bool post_formats =
+        details::any_stage<details::has_post_format<Stages>::value...>::value;
+
+public:
+    explicit staged_sink(sink_ptr sink, Stages... stages)
+        : sink_(std::move(sink)),
+          stages_(std::make_shared<stages_t>(std::move(stages)...)) {
+        set_formatter(details::make_unique<pattern_formatter>());
+    }
+
+    staged_sink(const staged_sink &) = delete;
+    staged_sink &operator=(const staged_sink &) = delete;
+
+    const sink_ptr &wrapped_sink() const { return sink_; }
+
+    // the stage I, to configure or read it (under the locks of the stage functions it has)
+    template <size_t I>
+    typename std::tuple_element<I, stages_t>::type &stage() {
+        return std::get<I>(*stages_);
+    }
+
+    void log(const details::log_msg &msg) override {
+        if (!sink_->should_log(msg)) {
+            return;
+        }
+        log_(msg, std::integral_constant<bool, pre_formats>{});
+    }
+
+    void log_batch(const details::log_msg *msgs, size_t count) override {
+        log_batch_(msgs, count, std::integral_constant<bool, pre_formats>{});
+    }
+
+    void flush() override { sink_->flush(); }
+
+    void set_pattern(const std::string &pattern) override {
+        set_formatter(details::make_unique<pattern_formatter>(pattern));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        set_formatter_(std::move(sink_formatter), std::integral_constant<bool, post_formats>{});
+        auto fields = sink_->needed_fields() | stages_needed_fields_(index<0>{});
+        needed_fields_.store(fields, std::memory_order_relaxed);
+    }
+
+private:
+    template <size_t I>
+    using index = std::integral_constant<size_t, I>;
+
+    // runs the post_format stages after the formatter of the sink
+    class stage_formatter final : public spdlog::formatter {
+    public:
+        stage_formatter(std::unique_ptr<spdlog::formatter> formatter,
+                        std::shared_ptr<stages_t> stages)
+            : formatter_(std::move(formatter)),
+              stages_(std::move(stages)) {}
+
+        void format(const details::log_msg &msg, memory_buf_t &dest) override {
+            if (dest.size() == 0) {
+                formatter_->format(msg, dest);
+                post_format_(msg, dest, index<0>{});
+                return;
+            }
+            // appended to other messages (see base_sink::format_batch_)
+            memory_buf_t formatted;
+            formatter_->format(msg, formatted);
+            post_format_(msg, formatted, index<0>{});
+            dest.append(formatted.data(), formatted.data() + formatted.size());
+        }
+
+        std::unique_ptr<spdlog::formatter> clone() const override {
+            return details::make_unique<stage_formatter>(formatter_->clone(), stages_);
+        }
+
+        unsigned needed_fields() const override { return formatter_->needed_fields(); }
+
+    private:
+        std::unique_ptr<spdlog::formatter> formatter_;
+        std::shared_ptr<stages_t> stages_;
+
+        void post_format_(const details::log_msg &, memory_buf_t &, index<sizeof...(Stages)>) {}
+
+        template <size_t I>
+        void post_format_(const details::log_msg &msg, memory_buf_t &formatted, index<I>) {
+            details::stage_post_format(std::get<I>(*stages_), msg, formatted, 0);
+            post_format_(msg, formatted, index<I + 1>{});
+        }
+    };
+
+    sink_ptr sink_;
+    std::shared_ptr<stages_t> stages_;
+    Mutex mutex_;
+
+    void log_(const details::log_msg &msg, std::false_type) { sink_->log(msg); }
+
+    // the lock is held until the sink logged the message, whose payload may be a buffer of a
+    // stage
+    void log_(const details::log_msg &msg, std::true_type) {
+        details::log_msg staged(msg);
+        std::lock_guard<Mutex> lock(mutex_);
+        if (pre_format_(staged, index<0>{})) {
+            sink_->log(staged);
+        }
+    }
+
+    void log_batch_(const details::log_msg *msgs, size_t count, std::false_type) {
+        sink_->log_batch(msgs, count);
+    }
+
+    // one message at a time, for the same reason
+    void log_batch_(const details::log_msg *msgs, size_t count, std::true_type) {
+        for (size_t i = 0; i < count; i++) {
+            log(msgs[i]);
+        }
+    }
+
+    void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter, std::false_type) {
+        sink_->set_formatter(std::move(sink_formatter));
+    }
+
+    void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter, std::true_type) {
+        sink_->set_formatter(
+            details::make_unique<stage_formatter>(std::move(sink_formatter), stages_));
+    }
+
+    bool pre_format_(details::log_msg &, index<sizeof...(Stages)>) { return true; }
+
+    template <size_t I>
+    bool pre_format_(details::log_msg &msg, index<I>) {
+        return details::stage_pre_format(std::get<I>(*stages_), msg, 0) &&
+               pre_format_(msg, index<I + 1>{});
+    }
+
+    unsigned stages_needed_fields_(index<sizeof...(Stages)>) const { return msg_field::none; }
+
+    template <size_t I>
+    unsigned stages_needed_fields_(index<I>) const {
+        return details::stage_needed_fields(std::get<I>(*stages_), 0) |
+               stages_needed_fields_(index<I + 1>{});
+    }
+};
+
+// the sink itself without stages
+template <typename Mutex>
+inline sink_ptr make_staged_sink(sink_ptr sink) {
+    return sink;
+}
+
+template <typename Mutex, typename Stage, typename... Stages>
+inline sink_ptr make_staged_sink(sink_ptr sink, Stage stage, Stages... stages) {
+    return std::make_shared<staged_sink<Mutex, Stage, Stages...>>(
+        std::move(sink), std::move(stage), std::move(stages)...);
+}
+
+}  // namespace sinks
+}  // namespace spdlog
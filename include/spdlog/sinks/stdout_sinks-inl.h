@@ -7,6 +7,7 @@
     #include <spdlog/sinks/stdout_sinks.h>
 #endif
 
+#include <cerrno>
 #include <memory>
 #include <spdlog/details/console_globals.h>
 #include <spdlog/pattern_formatter.h>
@@ -22,7 +23,9 @@
 
     #include <io.h>     // _get_osfhandle(..)
     #include <stdio.h>  // _fileno(..)
-#endif                  // WIN32
+#else
+    #include <unistd.h>  // write(..)
+#endif                   // WIN32
 
 namespace spdlog {
 
@@ -30,9 +33,10 @@ namespace sinks {
 
 template <typename ConsoleMutex>
 SPDLOG_INLINE stdout_sink_base<ConsoleMutex>::stdout_sink_base(FILE *file)
-    : mutex_(ConsoleMutex::mutex()),
+    : mutex_(ConsoleMutex::mutex(file)),
       file_(file),
       formatter_(details::make_unique<spdlog::pattern_formatter>()) {
+    needed_fields_.store(formatter_->needed_fields(), std::memory_order_relaxed);
 #ifdef _WIN32
     // get windows handle from the FILE* object
 
@@ -82,6 +86,7 @@ template <typename ConsoleMutex>
 SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::set_pattern(const std::string &pattern) {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::unique_ptr<spdlog::formatter>(new pattern_formatter(pattern));
+    needed_fields_.store(formatter_->needed_fields(), std::memory_order_relaxed);
 }
 
 template <typename ConsoleMutex>
@@ -89,8 +94,207 @@ SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::set_formatter(
     std::unique_ptr<spdlog::formatter> sink_formatter) {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::move(sink_formatter);
+    needed_fields_.store(formatter_->needed_fields(), std::memory_order_relaxed);
+}
+
+// buffered stdout sink base
+template <typename ConsoleMutex>
+SPDLOG_INLINE buffered_stdout_sink_base<ConsoleMutex>::buffered_stdout_sink_base(
+    FILE *file, stdout_buffer_options options)
+    : stdout_sink_base<ConsoleMutex>(file),
+      options_(options) {
+    update_needed_fields_();
+    if (options_.background) {
+        writer_ = std::thread([this] { writer_loop_(); });
+    }
 }
 
+template <typename ConsoleMutex>
+SPDLOG_INLINE buffered_stdout_sink_base<ConsoleMutex>::~buffered_stdout_sink_base() {
+    SPDLOG_TRY { flush(); }
+    SPDLOG_CATCH_STD
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            stop_ = true;
+        }
+        pending_cv_.notify_all();
+        writer_.join();
+    }
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::log(const details::log_msg &msg) {
+    std::lock_guard<mutex_t> lock(buffer_mutex_);
+    if (append_(msg) || buffer_.size() >= options_.buffer_size) {
+        write_();
+    }
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::log_batch(
+    const details::log_msg *msgs, size_t count) {
+    std::lock_guard<mutex_t> lock(buffer_mutex_);
+    bool due = false;
+    for (size_t i = 0; i < count; i++) {
+        if (this->should_log(msgs[i])) {
+            due = append_(msgs[i]) || due;
+        }
+    }
+    if (due || buffer_.size() >= options_.buffer_size) {
+        write_();
+    }
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE bool buffered_stdout_sink_base<ConsoleMutex>::append_(const details::log_msg &msg) {
+    if (buffer_.size() == 0) {
+        oldest_ = msg.time;
+    }
+    this->formatter_->format(msg, buffer_);
+    buffer_count_++;
+    return msg.level >= options_.flush_level ||
+           (options_.max_delay.count() > 0 && msg.time - oldest_ >= options_.max_delay);
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::flush() {
+    {
+        std::lock_guard<mutex_t> lock(buffer_mutex_);
+        write_();
+    }
+    if (options_.background) {
+        wait_written_();  // without holding the logging threads
+    }
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::set_pattern(
+    const std::string &pattern) {
+    std::lock_guard<mutex_t> lock(buffer_mutex_);
+    this->formatter_ = std::unique_ptr<spdlog::formatter>(new pattern_formatter(pattern));
+    update_needed_fields_();
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::set_formatter(
+    std::unique_ptr<spdlog::formatter> sink_formatter) {
+    std::lock_guard<mutex_t> lock(buffer_mutex_);
+    this->formatter_ = std::move(sink_formatter);
+    update_needed_fields_();
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::update_needed_fields_() {
+    auto fields = this->formatter_->needed_fields();
+    if (options_.max_delay.count() > 0) {
+        fields |= msg_field::time;
+    }
+    this->needed_fields_.store(fields, std::memory_order_relaxed);
+}
+
+// called with buffer_mutex_ locked
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::write_() {
+    if (buffer_.size() == 0) {
+        return;
+    }
+    auto count = buffer_count_;
+    buffer_count_ = 0;
+    if (!options_.background) {
+        const char *data = buffer_.data();
+        size_t size = buffer_.size();
+        buffer_.clear();  // dropped on error, so the next messages don't bring it back
+        write_data_(data, size);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (!pending_.empty() && pending_.size() + buffer_.size() > options_.max_pending) {
+            dropped_.fetch_add(count, std::memory_order_relaxed);
+        } else {
+            pending_.append(buffer_.data(), buffer_.size());
+        }
+    }
+    buffer_.clear();
+    pending_cv_.notify_all();
+}
+
+// write with as few system calls as possible, after what was written through the FILE
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::write_data_(const char *data,
+                                                                        size_t size) {
+    std::lock_guard<mutex_t> lock(this->mutex_);
+    ::fflush(this->file_);
+#ifdef _WIN32
+    if (this->handle_ == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    while (size > 0) {
+        DWORD bytes_written = 0;
+        if (::WriteFile(this->handle_, data, static_cast<DWORD>(size), &bytes_written, nullptr) ==
+            0) {
+            throw_spdlog_ex("buffered_stdout_sink: WriteFile() failed. GetLastError(): " +
+                            std::to_string(::GetLastError()));
+        }
+        data += bytes_written;
+        size -= bytes_written;
+    }
+#else
+    auto fd = ::fileno(this->file_);
+    while (size > 0) {
+        auto rv = ::write(fd, data, size);
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_spdlog_ex("buffered_stdout_sink: write() failed", errno);
+        }
+        data += rv;
+        size -= static_cast<size_t>(rv);
+    }
+#endif
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::wait_written_() {
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    pending_cv_.wait(lock, [this] { return pending_.empty() && !writing_; });
+}
+
+template <typename ConsoleMutex>
+SPDLOG_INLINE void buffered_stdout_sink_base<ConsoleMutex>::writer_loop_() {
+    std::string writing;
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    for (;;) {
+        pending_cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            return;  // stopped
+        }
+        writing.swap(pending_);
+        writing_ = true;
+        lock.unlock();
+        SPDLOG_TRY { write_data_(writing.data(), writing.size()); }
+        SPDLOG_CATCH_STD
+        writing.clear();
+        lock.lock();
+        writing_ = false;
+        pending_cv_.notify_all();
+    }
+}
+
+// buffered stdout sink
+template <typename ConsoleMutex>
+SPDLOG_INLINE buffered_stdout_sink<ConsoleMutex>::buffered_stdout_sink(
+    stdout_buffer_options options)
+    : buffered_stdout_sink_base<ConsoleMutex>(stdout, options) {}
+
+// buffered stderr sink
+template <typename ConsoleMutex>
+SPDLOG_INLINE buffered_stderr_sink<ConsoleMutex>::buffered_stderr_sink(
+    stdout_buffer_options options)
+    : buffered_stdout_sink_base<ConsoleMutex>(stderr, options) {}
+
 // stdout sink
 template <typename ConsoleMutex>
 SPDLOG_INLINE stdout_sink<ConsoleMutex>::stdout_sink()
@@ -123,4 +327,16 @@ template <typename Factory>
 SPDLOG_INLINE std::shared_ptr<logger> stderr_logger_st(const std::string &logger_name) {
     return Factory::template create<sinks::stderr_sink_st>(logger_name);
 }
+
+template <typename Factory>
+SPDLOG_INLINE std::shared_ptr<logger> buffered_stdout_logger_mt(
+    const std::string &logger_name, sinks::stdout_buffer_options options) {
+    return Factory::template create<sinks::buffered_stdout_sink_mt>(logger_name, options);
+}
+
+template <typename Factory>
+SPDLOG_INLINE std::shared_ptr<logger> buffered_stdout_logger_st(
+    const std::string &logger_name, sinks::stdout_buffer_options options) {
+    return Factory::template create<sinks::buffered_stdout_sink_st>(logger_name, options);
+}
 }  // namespace spdlog
@@ -3,7 +3,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <spdlog/details/console_globals.h>
 #include <spdlog/details/synchronous_factory.h>
 #include <spdlog/sinks/sink.h>
@@ -56,12 +62,90 @@ public:
     stderr_sink();
 };
 
+// stdout/stderr sink for an output collected through a pipe (e.g. by a container runtime):
+// the messages are formatted into a private buffer under the sink's own lock, and written with
+// one write() call once the buffer is full, for a message of flush_level or above, once the
+// oldest message waited max_delay (checked when logging: use spdlog::flush_every() for a bound
+// when idle) and on flush(). The console mutex is only taken for the write, so the messages
+// of the other console sinks can't be written in the middle of a batch.
+//
+// With background set, the buffer is handed to a thread of the sink which writes it, so that a
+// blocked terminal or pipe doesn't stall the logging threads: up to max_pending bytes wait for it,
+// the messages beyond are dropped (see dropped()). flush() still waits for them to be written.
+struct stdout_buffer_options {
+    size_t buffer_size = 64 * 1024;
+    level::level_enum flush_level = level::warn;
+    std::chrono::milliseconds max_delay{1000};  // 0 for no limit
+    bool background = false;
+    size_t max_pending = 1024 * 1024;
+};
+
+template <typename ConsoleMutex>
+class buffered_stdout_sink_base : public stdout_sink_base<ConsoleMutex> {
+public:
+    using mutex_t = typename ConsoleMutex::mutex_t;
+    buffered_stdout_sink_base(FILE *file, stdout_buffer_options options);
+    ~buffered_stdout_sink_base() override;
+
+    void log(const details::log_msg &msg) override;
+    void log_batch(const details::log_msg *msgs, size_t count) override;
+    void flush() override;
+    void set_pattern(const std::string &pattern) override;
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+    // number of messages dropped because the background writer was too far behind
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+protected:
+    mutex_t buffer_mutex_;  // of the buffer and the formatter
+    stdout_buffer_options options_;
+    memory_buf_t buffer_;
+    size_t buffer_count_ = 0;       // of the messages in the buffer
+    log_clock::time_point oldest_;  // of the messages in the buffer
+
+    // the background writer's
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::string pending_;  // handed to the writer
+    bool writing_ = false;
+    bool stop_ = false;
+    std::atomic<size_t> dropped_{0};
+    std::thread writer_;
+
+    void update_needed_fields_();
+    // format msg into the buffer, true if it should be written now
+    bool append_(const details::log_msg &msg);
+    // write the buffer, or hand it to the background writer
+    void write_();
+    void write_data_(const char *data, size_t size);
+    void wait_written_();
+    void writer_loop_();
+};
+
+template <typename ConsoleMutex>
+class buffered_stdout_sink : public buffered_stdout_sink_base<ConsoleMutex> {
+public:
+    explicit buffered_stdout_sink(stdout_buffer_options options = {});
+};
+
+template <typename ConsoleMutex>
+class buffered_stderr_sink : public buffered_stdout_sink_base<ConsoleMutex> {
+public:
+    explicit buffered_stderr_sink(stdout_buffer_options options = {});
+};
+
 using stdout_sink_mt = stdout_sink<details::console_mutex>;
 using stdout_sink_st = stdout_sink<details::console_nullmutex>;
 
 using stderr_sink_mt = stderr_sink<details::console_mutex>;
 using stderr_sink_st = stderr_sink<details::console_nullmutex>;
 
+using buffered_stdout_sink_mt = buffered_stdout_sink<details::console_mutex>;
+using buffered_stdout_sink_st = buffered_stdout_sink<details::console_nullmutex>;
+
+using buffered_stderr_sink_mt = buffered_stderr_sink<details::console_mutex>;
+using buffered_stderr_sink_st = buffered_stderr_sink<details::console_nullmutex>;
+
 }  // namespace sinks
 
 // factory methods
@@ -77,8 +161,30 @@ std::shared_ptr<logger> stderr_logger_mt(const std::string &logger_name);
 template <typename Factory = spdlog::synchronous_factory>
 std::shared_ptr<logger> stderr_logger_st(const std::string &logger_name);
 
+template <typename Factory = spdlog::synchronous_factory>
+std::shared_ptr<logger> buffered_stdout_logger_mt(const std::string &logger_name,
+                                                  sinks::stdout_buffer_options options = {});
+
+template <typename Factory = spdlog::synchronous_factory>
+std::shared_ptr<logger> buffered_stdout_logger_st(const std::string &logger_name,
+                                                  sinks::stdout_buffer_options options = {});
+
 }  // namespace spdlog
 
 #ifdef SPDLOG_HEADER_ONLY
     #include "stdout_sinks-inl.h"
+    #ifdef SPDLOG_EXTERN_TEMPLATES  // defined in spdlog/instantiate.h
+extern template class spdlog::sinks::stdout_sink_base<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::stdout_sink_base<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::stdout_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::stdout_sink<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::stderr_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::stderr_sink<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::buffered_stdout_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::buffered_stdout_sink<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::buffered_stderr_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::buffered_stderr_sink<spdlog::details::console_nullmutex>;
+    #endif
 #endif
@@ -0,0 +1,218 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Sink counting the messages of each callsite instead of writing them, and logging a summary
+// of each callsite to the downstream sink every interval, e.g.
+// "net.cpp:120 fired 48213 times in the last 10.0s, last payload: connection reset by peer"
+// (with the level, logger name, source and thread of the last message). A callsite which fired
+// once in the interval gets its message logged as is.
+//
+// The callsites are told apart by their source location and format string (msg_field::arguments,
+// when the loggers attach it), or by their payload without source location. The counters are in
+// a hash table split in stripes, each with its own lock, so concurrent callsites rarely contend.
+// The summaries are logged by the housekeeping scheduler's thread (see details/scheduler.h), and
+// on flush(). Messages of forward_level or above are logged to the downstream sink directly.
+//
+// Usage example:
+// auto summary = std::make_shared<spdlog::sinks::summary_sink>(file_sink,
+//                                                              std::chrono::seconds(10));
+// auto chatty = std::make_shared<spdlog::logger>("net", summary);
+
+#include <spdlog/common.h>
+#include <spdlog/details/flag_formatters.h>
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/details/periodic_worker.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+class summary_sink final : public base_sink<details::null_mutex> {
+public:
+    summary_sink(std::shared_ptr<sink> downstream,
+                 std::chrono::milliseconds interval,
+                 level::level_enum forward_level = level::off)
+        : downstream_(std::move(downstream)),
+          forward_level_(forward_level),
+          last_summary_(std::chrono::steady_clock::now()) {
+        if (!downstream_) {
+            throw_spdlog_ex("summary_sink: downstream sink cannot be null");
+        }
+        set_own_fields_(msg_field::all | msg_field::arguments, false);
+        timer_ = details::make_unique<details::periodic_worker>([this] { summarize_safe_(); },
+                                                                interval);
+    }
+
+    summary_sink(const summary_sink &) = delete;
+    summary_sink &operator=(const summary_sink &) = delete;
+
+    // the timer is stopped before the last summaries
+    ~summary_sink() override {
+        timer_.reset();
+        summarize_safe_();
+    }
+
+    const std::shared_ptr<sink> &downstream() const { return downstream_; }
+
+    // the callsites counted since the last summary
+    size_t pending_callsites() {
+        size_t count = 0;
+        for (auto &s : stripes_) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            for (auto &it : s.entries) {
+                count += it.second.count > 0 ? 1 : 0;
+            }
+        }
+        return count;
+    }
+
+    // log the summaries of the callsites counted since the last ones now
+    void summarize() {
+        std::lock_guard<std::mutex> lock(summary_mutex_);
+        summarize_();
+    }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        if (msg.level >= forward_level_ && msg.level != level::off) {
+            log_downstream_(msg);
+            return;
+        }
+        auto hash = hash_(msg);
+        auto &s = stripes_[hash % stripes_n];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto &e = s.entries[hash];
+        e.count++;
+        e.last.assign(msg);
+    }
+
+    void flush_() override {
+        summarize();
+        downstream_->flush();
+    }
+
+    void set_pattern_(const std::string &pattern) override { downstream_->set_pattern(pattern); }
+
+    void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        downstream_->set_formatter(std::move(sink_formatter));
+    }
+
+private:
+    struct entry {
+        size_t count = 0;  // since the last summary, the entry is removed after one without
+        details::log_msg_buffer last;
+    };
+
+    struct stripe {
+        std::mutex mutex;
+        std::unordered_map<std::uint64_t, entry> entries;  // by callsite hash
+        char padding[64];
+    };
+
+    static constexpr size_t stripes_n = 16;
+
+    std::shared_ptr<sink> downstream_;
+    level::level_enum forward_level_;
+    stripe stripes_[stripes_n];
+    std::mutex summary_mutex_;  // one summary at a time
+    std::chrono::steady_clock::time_point last_summary_;
+    std::vector<entry> fired_;  // of the summary being logged
+    memory_buf_t payload_;
+    std::unique_ptr<details::periodic_worker> timer_;
+
+    void log_downstream_(const details::log_msg &msg) {
+        if (downstream_->should_log(msg)) {
+            downstream_->log(msg);
+        }
+    }
+
+    // on the scheduler's thread, every interval
+    void summarize_safe_() {
+        SPDLOG_TRY { summarize(); }
+        SPDLOG_CATCH_STD
+    }
+
+    void summarize_() {
+        auto now = std::chrono::steady_clock::now();
+        auto seconds = std::chrono::duration<double>(now - last_summary_).count();
+        last_summary_ = now;
+        fired_.clear();
+        for (auto &s : stripes_) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            for (auto it = s.entries.begin(); it != s.entries.end();) {
+                if (it->second.count == 0) {
+                    it = s.entries.erase(it);
+                    continue;
+                }
+                fired_.push_back(std::move(it->second));
+                it->second.count = 0;
+                ++it;
+            }
+        }
+        for (auto &e : fired_) {
+            if (e.count == 1) {
+                log_downstream_(e.last);
+                continue;
+            }
+            payload_.clear();
+            const auto &source = e.last.source;
+            if (!source.empty()) {
+                using filename_formatter =
+                    details::short_filename_formatter<details::null_scoped_padder>;
+                fmt_lib::format_to(std::back_inserter(payload_), "{}:{}",
+                                   filename_formatter::short_filename(source), source.line);
+            } else {
+                details::fmt_helper::append_string_view("message", payload_);
+            }
+            fmt_lib::format_to(std::back_inserter(payload_),
+                               " fired {} times in the last {:.1f}s, last payload: ", e.count,
+                               seconds);
+            details::fmt_helper::append_string_view(e.last.payload, payload_);
+            details::log_msg summary(e.last);
+            summary.time = details::os::now();
+            summary.payload = string_view_t(payload_.data(), payload_.size());
+            summary.format = string_view_t();
+            summary.args = nullptr;
+            summary.arg_count = 0;
+            log_downstream_(summary);
+        }
+        fired_.clear();
+    }
+
+    // 64 bit FNV-1a of the source location and the format string, or of the payload
+    static std::uint64_t hash_(const details::log_msg &msg) {
+        std::uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](const char *data, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                hash ^= static_cast<unsigned char>(data[i]);
+                hash *= 1099511628211ull;
+            }
+        };
+        if (msg.source.empty()) {
+            add(msg.payload.data(), msg.payload.size());
+            return hash;
+        }
+        add(msg.source.filename, std::strlen(msg.source.filename));
+        add(reinterpret_cast<const char *>(&msg.source.line), sizeof(msg.source.line));
+        add(msg.format.data(), msg.format.size());
+        return hash;
+    }
+};
+
+}  // namespace sinks
+}  // namespace spdlog
@@ -3,27 +3,41 @@
 
 #pragma once
 
+#include <spdlog/details/fmt_helper.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/details/os.h>
 #include <spdlog/details/synchronous_factory.h>
 #include <spdlog/sinks/base_sink.h>
+#ifndef SPDLOG_NO_TLS
+    #include <spdlog/mdc.h>
+#endif
 
 #include <array>
+#include <string>
+#include <vector>
 #ifndef SD_JOURNAL_SUPPRESS_LOCATION
     #define SD_JOURNAL_SUPPRESS_LOCATION
 #endif
+#include <sys/uio.h>
 #include <systemd/sd-journal.h>
 
 namespace spdlog {
 namespace sinks {
 
 /**
- * Sink that write to systemd journal using the `sd_journal_send()` library call.
+ * Sink that write to systemd journal using the `sd_journal_sendv()` library call.
+ *
+ * The journal fields are written into a buffer of the sink and passed as an iovec, without
+ * printf-like formatting: PRIORITY and SYSLOG_IDENTIFIER are computed once, MESSAGE, TID and
+ * CODE_FILE, CODE_LINE, CODE_FUNC (if the source location is known) for each message.
+ * With mdc_fields, the MDC entries of the logging thread are added as fields too, and the kv
+ * fields of the message (see kv.h) always are, their keys upper cased, the chars other than
+ * letters, digits and '_' replaced by '_' (the keys not starting with a letter are left out).
  */
 template <typename Mutex>
 class systemd_sink : public base_sink<Mutex> {
 public:
-    systemd_sink(std::string ident = "", bool enable_formatting = false)
+    systemd_sink(std::string ident = "", bool enable_formatting = false, bool mdc_fields = true)
         : ident_{std::move(ident)},
           enable_formatting_{enable_formatting},
           syslog_levels_{{/* spdlog::level::trace      */ LOG_DEBUG,
@@ -32,7 +46,17 @@ public:
                           /* spdlog::level::warn       */ LOG_WARNING,
                           /* spdlog::level::err        */ LOG_ERR,
                           /* spdlog::level::critical   */ LOG_CRIT,
-                          /* spdlog::level::off        */ LOG_INFO}} {}
+                          /* spdlog::level::off        */ LOG_INFO}},
+          mdc_fields_{mdc_fields} {
+        for (size_t i = 0; i < priority_fields_.size(); i++) {
+            priority_fields_[i] = "PRIORITY=" + std::to_string(syslog_levels_[i]);
+        }
+        if (!ident_.empty()) {
+            identifier_field_ = "SYSLOG_IDENTIFIER=" + ident_;
+        }
+        base_sink<Mutex>::set_own_fields_(msg_field::thread_id | msg_field::source,
+                                          enable_formatting_);
+    }
 
     ~systemd_sink() override {}
 
@@ -46,7 +70,6 @@ protected:
     levels_array syslog_levels_;
 
     void sink_it_(const details::log_msg &msg) override {
-        int err;
         string_view_t payload;
         memory_buf_t formatted;
         if (enable_formatting_) {
@@ -56,40 +79,52 @@ protected:
             payload = msg.payload;
         }
 
-        size_t length = payload.size();
-        // limit to max int
-        if (length > static_cast<size_t>(std::numeric_limits<int>::max())) {
-            length = static_cast<size_t>(std::numeric_limits<int>::max());
-        }
-
-        const string_view_t syslog_identifier = ident_.empty() ? msg.logger_name : ident_;
-
-        // Do not send source location if not available
-        if (msg.source.empty()) {
-            // Note: function call inside '()' to avoid macro expansion
-            err = (sd_journal_send)("MESSAGE=%.*s", static_cast<int>(length), payload.data(),
-                                    "PRIORITY=%d", syslog_level(msg.level),
+        fields_.clear();
+        ends_.clear();
+        add_field_("MESSAGE=", payload);
 #ifndef SPDLOG_NO_THREAD_ID
-                                    "TID=%zu", msg.thread_id,
+        append_(string_view_t("TID="));
+        details::fmt_helper::append_int(msg.thread_id, fields_);
+        ends_.push_back(fields_.size());
 #endif
-                                    "SYSLOG_IDENTIFIER=%.*s",
-                                    static_cast<int>(syslog_identifier.size()),
-                                    syslog_identifier.data(), nullptr);
-        } else {
-            err = (sd_journal_send)("MESSAGE=%.*s", static_cast<int>(length), payload.data(),
-                                    "PRIORITY=%d", syslog_level(msg.level),
-#ifndef SPDLOG_NO_THREAD_ID
-                                    "TID=%zu", msg.thread_id,
+        // Do not send source location if not available
+        if (!msg.source.empty()) {
+            add_field_("CODE_FILE=", msg.source.filename);
+            append_(string_view_t("CODE_LINE="));
+            details::fmt_helper::append_int(msg.source.line, fields_);
+            ends_.push_back(fields_.size());
+            add_field_("CODE_FUNC=", msg.source.funcname);
+        }
+#ifndef SPDLOG_NO_TLS
+        if (mdc_fields_) {
+            for (auto entry : mdc::get_context()) {
+                if (append_field_name_(entry.first)) {
+                    add_field_(string_view_t(), entry.second);
+                }
+            }
+        }
 #endif
-                                    "SYSLOG_IDENTIFIER=%.*s",
-                                    static_cast<int>(syslog_identifier.size()),
-                                    syslog_identifier.data(), "CODE_FILE=%s", msg.source.filename,
-                                    "CODE_LINE=%d", msg.source.line, "CODE_FUNC=%s",
-                                    msg.source.funcname, nullptr);
+        for (size_t i = 0; i < msg.kv_count; i++) {
+            const auto &field = msg.kv_fields[i];
+            if (append_field_name_(field.key)) {
+                details::fmt_helper::append_kv_value(field, fields_);
+                ends_.push_back(fields_.size());
+            }
+        }
+
+        iovs_.clear();
+        add_iov_(priority_fields_.at(static_cast<size_t>(msg.level)));
+        add_iov_(identifier_(msg.logger_name));
+        size_t start = 0;
+        for (auto end : ends_) {
+            iovs_.push_back(iovec{fields_.data() + start, end - start});
+            start = end;
         }
 
-        if (err) {
-            throw_spdlog_ex("Failed writing to systemd", errno);
+        // Note: function call inside '()' to avoid macro expansion
+        auto err = (sd_journal_sendv)(iovs_.data(), static_cast<int>(iovs_.size()));
+        if (err < 0) {
+            throw_spdlog_ex("Failed writing to systemd", -err);
         }
     }
 
@@ -98,6 +133,62 @@ protected:
     }
 
     void flush_() override {}
+
+private:
+    bool mdc_fields_;
+    std::array<std::string, 7> priority_fields_;
+    std::string identifier_field_;  // of ident_, or of the last logger name if none
+    memory_buf_t fields_;           // the fields of the message being sent, back to back
+    std::vector<size_t> ends_;      // of each field in fields_
+    std::vector<iovec> iovs_;
+
+    void append_(string_view_t s) { details::fmt_helper::append_string_view(s, fields_); }
+
+    void add_field_(string_view_t name, string_view_t value) {
+        append_(name);
+        append_(value);
+        ends_.push_back(fields_.size());
+    }
+
+    void add_field_(string_view_t name, const char *value) {
+        add_field_(name, value == nullptr ? string_view_t() : string_view_t(value));
+    }
+
+    // append the journal field name of an mdc or kv key and '=', false if it can't be one
+    bool append_field_name_(string_view_t key) {
+        auto first = key.size() > 0 ? key[0] : '\0';
+        if (!((first >= 'a' && first <= 'z') || (first >= 'A' && first <= 'Z'))) {
+            return false;
+        }
+        auto size = key.size() < 64 ? key.size() : 64;  // the longest field name of the journal
+        for (size_t i = 0; i < size; i++) {
+            auto c = key[i];
+            if (c >= 'a' && c <= 'z') {
+                c = static_cast<char>(c - 'a' + 'A');
+            } else if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) {
+                c = '_';
+            }
+            fields_.push_back(c);
+        }
+        fields_.push_back('=');
+        return true;
+    }
+
+    void add_iov_(const std::string &field) {
+        iovs_.push_back(iovec{const_cast<char *>(field.data()), field.size()});
+    }
+
+    const std::string &identifier_(string_view_t logger_name) {
+        static constexpr size_t prefix_size = sizeof("SYSLOG_IDENTIFIER=") - 1;
+        if (ident_.empty() &&
+            (identifier_field_.size() != prefix_size + logger_name.size() ||
+             identifier_field_.compare(prefix_size, logger_name.size(), logger_name.data(),
+                                       logger_name.size()) != 0)) {
+            identifier_field_.assign("SYSLOG_IDENTIFIER=");
+            identifier_field_.append(logger_name.data(), logger_name.size());
+        }
+        return identifier_field_;
+    }
 };
 
 using systemd_sink_mt = systemd_sink<std::mutex>;
@@ -108,14 +199,18 @@ using systemd_sink_st = systemd_sink<details::null_mutex>;
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> systemd_logger_mt(const std::string &logger_name,
                                                  const std::string &ident = "",
-                                                 bool enable_formatting = false) {
-    return Factory::template create<sinks::systemd_sink_mt>(logger_name, ident, enable_formatting);
+                                                 bool enable_formatting = false,
+                                                 bool mdc_fields = true) {
+    return Factory::template create<sinks::systemd_sink_mt>(logger_name, ident, enable_formatting,
+                                                            mdc_fields);
 }
 
 template <typename Factory = spdlog::synchronous_factory>
 inline std::shared_ptr<logger> systemd_logger_st(const std::string &logger_name,
                                                  const std::string &ident = "",
-                                                 bool enable_formatting = false) {
-    return Factory::template create<sinks::systemd_sink_st>(logger_name, ident, enable_formatting);
+                                                 bool enable_formatting = false,
+                                                 bool mdc_fields = true) {
+    return Factory::template create<sinks::systemd_sink_st>(logger_name, ident, enable_formatting,
+                                                            mdc_fields);
 }
 }  // namespace spdlog
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <spdlog/binary_formatter.h>
 #include <spdlog/common.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/sinks/base_sink.h>
@@ -12,6 +13,8 @@
     #include <spdlog/details/tcp_client.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <mutex>
@@ -22,6 +25,11 @@
 // Simple tcp client sink
 // Connects to remote address and send the formatted log.
 // Will attempt to reconnect if connection drops.
+// While the server can't be reached, the messages are dropped (and counted) without trying to
+// connect: the next attempt is made by the first message after a delay, which doubles after
+// each failed attempt (from reconnect_min_delay up to reconnect_max_delay).
+// With the binary_formatter, each connection gets a stream of its own, starting with a header
+// (see tools/log_receiver.cpp).
 // If more complicated behaviour is needed (i.e get responses), you can inherit it and override the
 // sink_it_ method.
 
@@ -32,6 +40,9 @@ struct tcp_sink_config {
     std::string server_host;
     int server_port;
     bool lazy_connect = false;  // if true connect on first log call instead of on construction
+    std::chrono::milliseconds reconnect_min_delay{100};
+    std::chrono::milliseconds reconnect_max_delay{30000};
+    std::chrono::milliseconds dns_ttl{60000};  // how long the server's addresses are reused
 
     tcp_sink_config(std::string host, int port)
         : server_host{std::move(host)},
@@ -45,27 +56,52 @@ public:
     // host can be hostname or ip address
 
     explicit tcp_sink(tcp_sink_config sink_config)
-        : config_{std::move(sink_config)} {
+        : config_{std::move(sink_config)},
+          reconnect_delay_{config_.reconnect_min_delay} {
+        client_.set_dns_ttl(config_.dns_ttl);
         if (!config_.lazy_connect) {
             this->client_.connect(config_.server_host, config_.server_port);
         }
+        this->set_own_fields_(msg_field::none);
     }
 
     ~tcp_sink() override = default;
 
+    // the messages dropped while waiting to try connecting again
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
 protected:
     void sink_it_(const spdlog::details::log_msg &msg) override {
-        spdlog::memory_buf_t formatted;
-        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
         if (!client_.is_connected()) {
+            auto now = std::chrono::steady_clock::now();
+            if (now < next_connect_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // if it fails (and throws), wait before the next attempt
+            next_connect_ = now + reconnect_delay_;
+            reconnect_delay_ = (std::min)(reconnect_delay_ * 2, config_.reconnect_max_delay);
             client_.connect(config_.server_host, config_.server_port);
+            reconnect_delay_ = config_.reconnect_min_delay;
+            // the ids defined on the previous connection are unknown to the new one
+            auto *binary = dynamic_cast<binary_formatter *>(base_sink<Mutex>::formatter_.get());
+            if (binary != nullptr) {
+                binary->reset();
+            }
         }
+        spdlog::memory_buf_t formatted;
+        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
         client_.send(formatted.data(), formatted.size());
     }
 
     void flush_() override {}
     tcp_sink_config config_;
     details::tcp_client client_;
+
+private:
+    std::chrono::milliseconds reconnect_delay_;
+    std::chrono::steady_clock::time_point next_connect_;
+    std::atomic<size_t> dropped_{0};
 };
 
 using tcp_sink_mt = tcp_sink<std::mutex>;
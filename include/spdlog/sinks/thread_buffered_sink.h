@@ -0,0 +1,193 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#if defined(SPDLOG_NO_TLS)
+    #error "This header requires thread local storage support, but SPDLOG_NO_TLS is defined."
+#endif
+
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/sinks/sink.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Synchronous logging without taking the lock of the sink for each message: each thread
+// keeps a copy of its messages in a buffer of its own, passed to the sink as a batch (see
+// sink::log_batch(), under one lock and in one write for the file sinks) once it holds
+// max_messages, on flush() and when the thread exits.
+//
+// flush() passes the messages of all the threads. Until then, the messages of different
+// threads aren't in time order in the sink, and a message is lost if the program crashes.
+//
+// Usage example:
+// auto file = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/batch.log");
+// auto sink = std::make_shared<spdlog::sinks::thread_buffered_sink>(file, 256);
+// spdlog::logger logger("batch", sink);
+
+namespace spdlog {
+namespace sinks {
+
+class thread_buffered_sink final : public sink {
+public:
+    explicit thread_buffered_sink(sink_ptr sink, size_t max_messages = 64)
+        : sink_(std::move(sink)),
+          max_messages_(max_messages == 0 ? 1 : max_messages),
+          id_(next_id_()) {
+        needed_fields_.store(sink_->needed_fields(), std::memory_order_relaxed);
+    }
+
+    // pass the messages still buffered by the threads
+    ~thread_buffered_sink() override {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        for (auto &buffer : buffers_) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            SPDLOG_TRY { drain_(*buffer); }
+            SPDLOG_CATCH_STD
+            buffer->owner = nullptr;
+        }
+    }
+
+    thread_buffered_sink(const thread_buffered_sink &) = delete;
+    thread_buffered_sink &operator=(const thread_buffered_sink &) = delete;
+
+    const sink_ptr &wrapped_sink() const { return sink_; }
+
+    void log(const details::log_msg &msg) override {
+        if (!sink_->should_log(msg)) {
+            return;
+        }
+        auto &buffer = local_buffer_();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.count == buffer.msgs.size()) {
+            buffer.msgs.emplace_back(msg);
+        } else {
+            buffer.msgs[buffer.count].assign(msg);
+        }
+        buffer.count++;
+        if (buffer.count >= max_messages_) {
+            drain_(buffer);
+        }
+    }
+
+    // already a batch (e.g. from a thread pool worker): passed as is
+    void log_batch(const details::log_msg *msgs, size_t count) override {
+        sink_->log_batch(msgs, count);
+    }
+
+    void flush() override {
+        {
+            std::lock_guard<std::mutex> lock(buffers_mutex_);
+            for (auto &buffer : buffers_) {
+                std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+                drain_(*buffer);
+            }
+            // the buffers of the threads which exited
+            buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                          [](const std::shared_ptr<thread_buffer> &buffer) {
+                                              return buffer->orphaned.load();
+                                          }),
+                           buffers_.end());
+        }
+        sink_->flush();
+    }
+
+    void set_pattern(const std::string &pattern) override {
+        sink_->set_pattern(pattern);
+        needed_fields_.store(sink_->needed_fields(), std::memory_order_relaxed);
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        sink_->set_formatter(std::move(sink_formatter));
+        needed_fields_.store(sink_->needed_fields(), std::memory_order_relaxed);
+    }
+
+private:
+    struct thread_buffer {
+        std::mutex mutex;
+        // null once the sink is destroyed
+        thread_buffered_sink *owner;
+        std::uint64_t owner_id;
+        // msgs[0, count) are buffered, the others kept for their storage
+        std::vector<details::log_msg_buffer> msgs;
+        size_t count = 0;
+        std::vector<details::log_msg> batch;
+        std::atomic<bool> orphaned{false};  // the thread exited
+
+        thread_buffer(thread_buffered_sink *sink, std::uint64_t sink_id)
+            : owner(sink),
+              owner_id(sink_id) {}
+    };
+
+    // the buffers of a thread, for all the sinks it logged to
+    struct thread_buffers {
+        std::vector<std::shared_ptr<thread_buffer>> buffers;
+
+        ~thread_buffers() {
+            for (auto &buffer : buffers) {
+                std::lock_guard<std::mutex> lock(buffer->mutex);
+                if (buffer->owner != nullptr) {
+                    SPDLOG_TRY { buffer->owner->drain_(*buffer); }
+                    SPDLOG_CATCH_STD
+                }
+                buffer->orphaned = true;
+            }
+        }
+    };
+
+    sink_ptr sink_;
+    size_t max_messages_;
+    // never reused, unlike the address of the sink
+    std::uint64_t id_;
+    std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<thread_buffer>> buffers_;
+
+    static std::uint64_t next_id_() {
+        static std::atomic<std::uint64_t> id{0};
+        return ++id;
+    }
+
+    thread_buffer &local_buffer_() {
+        static thread_local thread_buffers local;
+        auto &buffers = local.buffers;
+        for (auto &buffer : buffers) {
+            if (buffer->owner_id == id_) {
+                return *buffer;
+            }
+        }
+        // forget the buffers of the sinks destroyed since
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                     [](const std::shared_ptr<thread_buffer> &buffer) {
+                                         std::lock_guard<std::mutex> lock(buffer->mutex);
+                                         return buffer->owner == nullptr;
+                                     }),
+                      buffers.end());
+        auto buffer = std::make_shared<thread_buffer>(this, id_);
+        {
+            std::lock_guard<std::mutex> lock(buffers_mutex_);
+            buffers_.push_back(buffer);
+        }
+        buffers.push_back(std::move(buffer));
+        return *buffers.back();
+    }
+
+    // under the lock of the buffer. the buffer is emptied even if the sink throws.
+    void drain_(thread_buffer &buffer) {
+        if (buffer.count == 0) {
+            return;
+        }
+        buffer.batch.assign(buffer.msgs.begin(), buffer.msgs.begin() + buffer.count);
+        buffer.count = 0;
+        sink_->log_batch(buffer.batch.data(), buffer.batch.size());
+    }
+};
+
+}  // namespace sinks
+}  // namespace spdlog
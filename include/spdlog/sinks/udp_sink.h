@@ -16,9 +16,13 @@
 #include <functional>
 #include <mutex>
 #include <string>
+#include <vector>
 
 // Simple udp client sink
-// Sends formatted log via udp
+// Sends formatted log via udp.
+// The batches of messages (from the async loggers) are sent with one system call per 64
+// datagrams on linux, and with max_datagram_size set, several messages are packed in each
+// datagram.
 
 namespace spdlog {
 namespace sinks {
@@ -26,6 +30,9 @@ namespace sinks {
 struct udp_sink_config {
     std::string server_host;
     uint16_t server_port;
+    // if not 0, the messages of a batch are packed in datagrams up to this size (e.g. 1472
+    // for a 1500 bytes MTU). a bigger message is sent alone.
+    size_t max_datagram_size = 0;
 
     udp_sink_config(std::string host, uint16_t port)
         : server_host{std::move(host)},
@@ -37,7 +44,10 @@ class udp_sink : public spdlog::sinks::base_sink<Mutex> {
 public:
     // host can be hostname or ip address
     explicit udp_sink(udp_sink_config sink_config)
-        : client_{sink_config.server_host, sink_config.server_port} {}
+        : client_{sink_config.server_host, sink_config.server_port},
+          max_datagram_size_{sink_config.max_datagram_size} {
+        this->set_own_fields_(msg_field::none);
+    }
 
     ~udp_sink() override = default;
 
@@ -48,8 +58,38 @@ protected:
         client_.send(formatted.data(), formatted.size());
     }
 
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        memory_buf_t formatted;
+        ends_.clear();
+        base_sink<Mutex>::format_batch_(
+            msgs, count, formatted, [&](size_t) { ends_.push_back(formatted.size()); },
+            [&] { send_batch_(formatted); });
+    }
+
     void flush_() override {}
     details::udp_client client_;
+    size_t max_datagram_size_;
+
+private:
+    std::vector<size_t> ends_;  // of each message of the batch in the formatted buffer
+    std::vector<string_view_t> datagrams_;
+
+    void send_batch_(const memory_buf_t &formatted) {
+        datagrams_.clear();
+        size_t start = 0;  // of the datagram being filled
+        size_t end = 0;    // of the messages in it
+        for (auto msg_end : ends_) {
+            if (end > start && (max_datagram_size_ == 0 || msg_end - start > max_datagram_size_)) {
+                datagrams_.emplace_back(formatted.data() + start, end - start);
+                start = end;
+            }
+            end = msg_end;
+        }
+        if (end > start) {
+            datagrams_.emplace_back(formatted.data() + start, end - start);
+        }
+        client_.send_many(datagrams_.data(), datagrams_.size());
+    }
 };
 
 using udp_sink_mt = udp_sink<std::mutex>;
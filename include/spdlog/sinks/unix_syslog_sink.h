@@ -0,0 +1,184 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifdef _WIN32
+    #error unix_syslog_sink is not supported on windows
+#endif
+
+// Syslog sink sending the messages as RFC 5424 frames (see rfc5424_formatter) straight to the
+// local syslog daemon's datagram socket, kept open, instead of calling ::syslog() (which takes
+// a process wide lock and formats the message again). The batches of messages (from the async
+// loggers) are sent with one system call per 64 messages on linux. If the daemon was restarted,
+// the socket is connected again and the messages sent again, once.
+//
+// set_pattern() sets the format of the MSG part, the header being written by the sink.
+// rsyslog and syslog-ng parse the RFC 5424 header on /dev/log, systemd-journald doesn't.
+// For remote syslog servers, use the rfc5424_formatter with the udp or tcp sinks.
+//
+// Usage example:
+// spdlog::rfc5424_options options;
+// options.app_name = "myapp";
+// auto logger = spdlog::unix_syslog_logger_mt("syslog", options);
+
+#include <spdlog/common.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/send_datagrams.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/rfc5424_formatter.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class unix_syslog_sink final : public base_sink<Mutex> {
+public:
+    explicit unix_syslog_sink(rfc5424_options options = {},
+                              std::string socket_path = "/dev/log")
+        : base_sink<Mutex>(details::make_unique<rfc5424_formatter>(options)),
+          options_(std::move(options)),
+          socket_path_(std::move(socket_path)) {
+        if (socket_path_.size() >= sizeof(sockaddr_un{}.sun_path)) {
+            throw_spdlog_ex("unix_syslog_sink: socket path too long: " + socket_path_);
+        }
+        connect_();
+        base_sink<Mutex>::set_own_fields_(msg_field::none);
+    }
+
+    unix_syslog_sink(const unix_syslog_sink &) = delete;
+    unix_syslog_sink &operator=(const unix_syslog_sink &) = delete;
+
+    ~unix_syslog_sink() override { close_(); }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        memory_buf_t formatted;
+        base_sink<Mutex>::formatter_->format(msg, formatted);
+        string_view_t datagram(formatted.data(), formatted.size());
+        send_(&datagram, 1);
+    }
+
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        memory_buf_t formatted;
+        ends_.clear();
+        base_sink<Mutex>::format_batch_(
+            msgs, count, formatted, [&](size_t) { ends_.push_back(formatted.size()); }, [&] {
+                datagrams_.clear();
+                size_t start = 0;
+                for (auto end : ends_) {
+                    datagrams_.emplace_back(formatted.data() + start, end - start);
+                    start = end;
+                }
+                send_(datagrams_.data(), datagrams_.size());
+            });
+    }
+
+    void flush_() override {}
+
+    // the pattern of the MSG part
+    void set_pattern_(const std::string &pattern) override {
+        base_sink<Mutex>::set_formatter_(details::make_unique<rfc5424_formatter>(
+            options_, details::make_unique<pattern_formatter>(pattern, pattern_time_type::local,
+                                                              std::string())));
+    }
+
+private:
+    rfc5424_options options_;
+    std::string socket_path_;
+    int fd_ = -1;
+    std::vector<size_t> ends_;  // of each message of the batch in the formatted buffer
+    std::vector<string_view_t> datagrams_;
+
+    void connect_() {
+#ifdef SOCK_CLOEXEC
+        fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+#else
+        fd_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (fd_ >= 0) {
+            ::fcntl(fd_, F_SETFD, FD_CLOEXEC);
+        }
+#endif
+        if (fd_ < 0) {
+            throw_spdlog_ex("unix_syslog_sink: failed creating the socket", errno);
+        }
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+        if (::connect(fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            auto err = errno;
+            close_();
+            throw_spdlog_ex("unix_syslog_sink: failed connecting to " + socket_path_, err);
+        }
+    }
+
+    void close_() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // the errors of a daemon restarted (or not listening any more) since connect_()
+    static bool disconnected_(int err) {
+        return err == ECONNREFUSED || err == ENOTCONN || err == ECONNRESET || err == ENOENT;
+    }
+
+    void send_(const string_view_t *datagrams, size_t count) {
+        size_t sent = 0;
+        if (fd_ >= 0) {
+            sent = details::send_datagrams(fd_, nullptr, 0, datagrams, count);
+            if (sent == count) {
+                return;
+            }
+            if (!disconnected_(errno)) {
+                throw_spdlog_ex("unix_syslog_sink: failed sending to " + socket_path_, errno);
+            }
+            close_();
+        }
+        connect_();
+        if (details::send_datagrams(fd_, nullptr, 0, datagrams + sent, count - sent) <
+            count - sent) {
+            throw_spdlog_ex("unix_syslog_sink: failed sending to " + socket_path_, errno);
+        }
+    }
+};
+
+using unix_syslog_sink_mt = unix_syslog_sink<std::mutex>;
+using unix_syslog_sink_st = unix_syslog_sink<details::null_mutex>;
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> unix_syslog_logger_mt(const std::string &logger_name,
+                                                     rfc5424_options options = {},
+                                                     const std::string &socket_path = "/dev/log") {
+    return Factory::template create<sinks::unix_syslog_sink_mt>(logger_name, std::move(options),
+                                                                socket_path);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> unix_syslog_logger_st(const std::string &logger_name,
+                                                     rfc5424_options options = {},
+                                                     const std::string &socket_path = "/dev/log") {
+    return Factory::template create<sinks::unix_syslog_sink_st>(logger_name, std::move(options),
+                                                                socket_path);
+}
+
+}  // namespace spdlog
@@ -0,0 +1,290 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// File sink submitting its writes (and the fsyncs, if sync_on_flush) to an io_uring instead of
+// doing them in the logging thread. The messages are formatted into one of several buffers,
+// and a full buffer (or the current one on flush) is written in the background while the next
+// ones fill up, so the logging thread only waits when all the buffers are still in flight.
+//
+// Linux only (kernel 5.6 or newer). The writes are done at explicit offsets tracked by the
+// sink, so the file shouldn't be written by anything else while the sink is open.
+//
+// Usage example:
+// auto logger = spdlog::uring_logger_mt("uring_logger", "logs/uring.txt");
+// or
+// auto sink = std::make_shared<spdlog::sinks::uring_file_sink_mt>("logs/uring.txt");
+
+#include <spdlog/common.h>
+#include <spdlog/details/io_uring.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spdlog {
+namespace sinks {
+
+template <typename Mutex>
+class uring_file_sink final : public base_sink<Mutex> {
+public:
+    explicit uring_file_sink(filename_t filename,
+                             bool truncate = false,
+                             size_t buffer_size = 64 * 1024,
+                             size_t buffers = 4,
+                             bool sync_on_flush = false)
+        : filename_(std::move(filename)),
+          buffer_size_(buffer_size == 0 ? 1 : buffer_size),
+          sync_on_flush_(sync_on_flush),
+          buffers_(buffers == 0 ? 1 : buffers),
+          ring_(static_cast<unsigned>(buffers_.size() + 2)) {
+        details::os::create_dir(details::os::dir_name(filename_));
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0);
+        fd_ = ::open(filename_.c_str(), flags, 0644);
+        struct stat st;
+        if (fd_ < 0 || ::fstat(fd_, &st) != 0) {
+            auto err = errno;
+            close_();
+            throw_spdlog_ex("Failed opening file " + filename_ + " for writing", err);
+        }
+        offset_ = static_cast<std::uint64_t>(st.st_size);
+        for (auto &buffer : buffers_) {
+            buffer.data.reserve(buffer_size_);
+        }
+    }
+
+    uring_file_sink(const uring_file_sink &) = delete;
+    uring_file_sink &operator=(const uring_file_sink &) = delete;
+
+    ~uring_file_sink() override {
+        SPDLOG_TRY {
+            std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+            submit_current_();
+            while (in_flight_ > 0 && ring_.submit(1)) {
+                reap_();
+            }
+        }
+        SPDLOG_CATCH_STD
+        close_();
+    }
+
+    const filename_t &filename() const { return filename_; }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        throw_if_failed_();
+        memory_buf_t formatted;
+        base_sink<Mutex>::formatter_->format(msg, formatted);
+        auto data = formatted.data();
+        auto size = formatted.size();
+        while (size > 0) {
+            auto &buffer = buffers_[current_].data;
+            auto n = (std::min)(size, buffer_size_ - buffer.size());
+            buffer.insert(buffer.end(), data, data + n);
+            data += n;
+            size -= n;
+            if (buffer.size() == buffer_size_) {
+                submit_current_();
+            }
+        }
+        reap_();
+    }
+
+    void flush_() override {
+        throw_if_failed_();
+        submit_current_();
+        if (sync_on_flush_) {
+            if (sync_in_flight_) {
+                sync_pending_ = true;  // submitted once the one in flight completes
+            } else {
+                submit_sync_();
+            }
+        }
+        reap_();
+        throw_if_failed_();
+    }
+
+private:
+    struct buffer {
+        std::vector<char> data;
+        std::uint64_t offset = 0;  // in the file
+        size_t written = 0;        // completed so far, if in flight
+        bool in_flight = false;
+    };
+
+    static constexpr std::uint64_t sync_tag = ~std::uint64_t{0};
+
+    filename_t filename_;
+    size_t buffer_size_;
+    bool sync_on_flush_;
+    std::vector<buffer> buffers_;
+    details::io_uring ring_;
+    int fd_ = -1;
+    std::uint64_t offset_ = 0;  // where the next buffer goes
+    size_t current_ = 0;        // the buffer being filled
+    size_t in_flight_ = 0;      // submitted operations not completed yet
+    bool sync_in_flight_ = false;
+    bool sync_pending_ = false;
+    int error_ = 0;  // errno of the first failed operation
+
+    io_uring_sqe *get_sqe_() {
+        auto *sqe = ring_.get_sqe();
+        if (sqe == nullptr) {
+            submit_(0);
+            sqe = ring_.get_sqe();
+        }
+        return sqe;  // never null: at most buffers + 1 operations are in flight
+    }
+
+    void submit_(unsigned wait_nr) {
+        if (!ring_.submit(wait_nr)) {
+            throw_spdlog_ex("Failed submitting writes to file " + filename_, errno);
+        }
+    }
+
+    void submit_write_(size_t index) {
+        auto &b = buffers_[index];
+        auto *sqe = get_sqe_();
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = fd_;
+        sqe->addr = reinterpret_cast<std::uint64_t>(b.data.data() + b.written);
+        sqe->len = static_cast<std::uint32_t>(b.data.size() - b.written);
+        sqe->off = b.offset + b.written;
+        sqe->user_data = index;
+    }
+
+    void submit_sync_() {
+        auto *sqe = get_sqe_();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = fd_;
+        sqe->flags = IOSQE_IO_DRAIN;  // after the writes submitted before
+        sqe->user_data = sync_tag;
+        sync_in_flight_ = true;
+        in_flight_++;
+        submit_(0);
+    }
+
+    // write the current buffer in the background and move to a free one, waiting for one of
+    // the writes in flight if there is none
+    void submit_current_() {
+        auto &b = buffers_[current_];
+        if (b.data.empty()) {
+            return;
+        }
+        b.offset = offset_;
+        b.written = 0;
+        b.in_flight = true;
+        offset_ += b.data.size();
+        in_flight_++;
+        submit_write_(current_);
+        submit_(0);
+        for (;;) {
+            for (size_t i = 0; i < buffers_.size(); i++) {
+                if (!buffers_[i].in_flight) {
+                    current_ = i;
+                    return;
+                }
+            }
+            submit_(1);
+            reap_();
+        }
+    }
+
+    void reap_() {
+        ring_.for_each_cqe([this](const io_uring_cqe &cqe) { complete_(cqe); });
+        // short writes are resubmitted by complete_()
+        submit_(0);
+    }
+
+    void complete_(const io_uring_cqe &cqe) {
+        in_flight_--;
+        if (cqe.user_data == sync_tag) {
+            sync_in_flight_ = false;
+            if (cqe.res < 0 && error_ == 0) {
+                error_ = -cqe.res;
+            }
+            if (sync_pending_) {
+                sync_pending_ = false;
+                submit_sync_();
+            }
+            return;
+        }
+        auto index = static_cast<size_t>(cqe.user_data);
+        auto &b = buffers_[index];
+        if (cqe.res > 0 && b.written + static_cast<size_t>(cqe.res) < b.data.size()) {
+            b.written += static_cast<size_t>(cqe.res);
+            in_flight_++;
+            submit_write_(index);
+            return;
+        }
+        if (cqe.res <= 0 && error_ == 0) {
+            error_ = cqe.res < 0 ? -cqe.res : EIO;
+        }
+        b.data.clear();
+        b.in_flight = false;
+    }
+
+    void throw_if_failed_() {
+        if (error_ != 0) {
+            auto err = error_;
+            error_ = 0;
+            throw_spdlog_ex("Failed writing to file " + filename_, err);
+        }
+    }
+
+    void close_() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+};
+
+using uring_file_sink_mt = uring_file_sink<std::mutex>;
+using uring_file_sink_st = uring_file_sink<details::null_mutex>;
+
+template <typename Mutex>
+struct shares_file<uring_file_sink<Mutex>> : std::true_type {};
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> uring_logger_mt(const std::string &logger_name,
+                                               const filename_t &filename,
+                                               bool truncate = false,
+                                               size_t buffer_size = 64 * 1024,
+                                               size_t buffers = 4,
+                                               bool sync_on_flush = false) {
+    return Factory::template create<sinks::uring_file_sink_mt>(logger_name, filename, truncate,
+                                                               buffer_size, buffers,
+                                                               sync_on_flush);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> uring_logger_st(const std::string &logger_name,
+                                               const filename_t &filename,
+                                               bool truncate = false,
+                                               size_t buffer_size = 64 * 1024,
+                                               size_t buffers = 4,
+                                               bool sync_on_flush = false) {
+    return Factory::template create<sinks::uring_file_sink_st>(logger_name, filename, truncate,
+                                                               buffer_size, buffers,
+                                                               sync_on_flush);
+}
+
+}  // namespace spdlog
@@ -0,0 +1,145 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/synchronous_factory.h>
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/sinks/sink.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// with SPDLOG_USDT_SEMAPHORE, the probe gets a semaphore which the tracers attached to it
+// increment. it must be defined once in the program, with SPDLOG_USDT_DEFINE_SEMAPHORE.
+#ifdef SPDLOG_USDT_SEMAPHORE
+    #ifndef _SDT_HAS_SEMAPHORES
+        #define _SDT_HAS_SEMAPHORES 1
+    #endif
+extern unsigned short spdlog_log_semaphore;
+    #define SPDLOG_USDT_DEFINE_SEMAPHORE \
+        __extension__ unsigned short spdlog_log_semaphore __attribute__((unused)) \
+            __attribute__((section(".probes")))
+#endif
+#include <sys/sdt.h>
+
+namespace spdlog {
+namespace sinks {
+
+/**
+ * Sink firing the USDT probe spdlog:log (see <sys/sdt.h>, from SystemTap) for each message,
+ * to be traced with e.g. bpftrace, perf or SystemTap:
+ *
+ *   bpftrace -e 'usdt:./app:spdlog:log { printf("%s\n", str(arg5, arg6)); }'
+ *
+ * The probe arguments are: level, time (ns since the epoch), thread id, logger name and its
+ * size, message and its size, source file (or null) and line. The strings aren't null
+ * terminated. The message is the payload, or the formatted message with enable_formatting.
+ *
+ * The probe is a nop until a tracer attaches to it. With SPDLOG_USDT_SEMAPHORE, the sink
+ * doesn't do anything either while no tracer is attached, not even formatting. It only
+ * locks to format the messages.
+ */
+template <typename Mutex>
+class usdt_sink final : public sink {
+public:
+    explicit usdt_sink(bool enable_formatting = false)
+        : enable_formatting_(enable_formatting),
+          formatter_(details::make_unique<pattern_formatter>()) {
+        update_needed_fields_();
+    }
+
+    usdt_sink(const usdt_sink &) = delete;
+    usdt_sink &operator=(const usdt_sink &) = delete;
+
+    // whether a tracer is attached to the probe. always true without SPDLOG_USDT_SEMAPHORE.
+    static bool tracing() {
+#ifdef SPDLOG_USDT_SEMAPHORE
+        return *static_cast<volatile unsigned short *>(&spdlog_log_semaphore) != 0;
+#else
+        return true;
+#endif
+    }
+
+    void log(const details::log_msg &msg) override {
+        if (!tracing()) {
+            return;
+        }
+        if (!enable_formatting_) {
+            fire_(msg, msg.payload);
+            return;
+        }
+        memory_buf_t formatted;
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            formatter_->format(msg, formatted);
+        }
+        fire_(msg, string_view_t(formatted.data(), formatted.size()));
+    }
+
+    void flush() override {}
+
+    void set_pattern(const std::string &pattern) override {
+        set_formatter(details::make_unique<pattern_formatter>(pattern));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        std::lock_guard<Mutex> lock(mutex_);
+        formatter_ = std::move(sink_formatter);
+        update_needed_fields_();
+    }
+
+private:
+    static void fire_(const details::log_msg &msg, string_view_t text) {
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        msg.time.time_since_epoch())
+                        .count();
+        auto level = static_cast<int>(msg.level);
+        auto thread_id = static_cast<std::uint64_t>(msg.thread_id);
+        auto *name = msg.logger_name.data();
+        auto name_size = msg.logger_name.size();
+        auto *text_data = text.data();
+        auto text_size = text.size();
+        auto *file = msg.source.filename;
+        auto line = msg.source.line;
+        STAP_PROBE9(spdlog, log, level, time, thread_id, name, name_size, text_data, text_size,
+                    file, line);
+    }
+
+    void update_needed_fields_() {
+        auto fields = unsigned{msg_field::time | msg_field::thread_id | msg_field::source};
+        if (enable_formatting_) {
+            fields |= formatter_->needed_fields();
+        }
+        needed_fields_.store(fields, std::memory_order_relaxed);
+    }
+
+    bool enable_formatting_;
+    Mutex mutex_;
+    std::unique_ptr<spdlog::formatter> formatter_;
+};
+
+using usdt_sink_mt = usdt_sink<std::mutex>;
+using usdt_sink_st = usdt_sink<details::null_mutex>;
+
+}  // namespace sinks
+
+//
+// factory functions
+//
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> usdt_logger_mt(const std::string &logger_name,
+                                              bool enable_formatting = false) {
+    return Factory::template create<sinks::usdt_sink_mt>(logger_name, enable_formatting);
+}
+
+template <typename Factory = spdlog::synchronous_factory>
+inline std::shared_ptr<logger> usdt_logger_st(const std::string &logger_name,
+                                              bool enable_formatting = false) {
+    return Factory::template create<sinks::usdt_sink_st>(logger_name, enable_formatting);
+}
+}  // namespace spdlog
@@ -39,8 +39,11 @@ Windows Registry Editor Version 5.00
 #include <spdlog/details/windows_include.h>
 #include <winbase.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace spdlog {
@@ -180,6 +183,14 @@ struct eventlog {
 
 }  // namespace internal
 
+// With background set, the messages are reported by a thread of the sink, so that a burst of
+// them doesn't block the logging threads on ReportEvent: up to max_pending bytes of messages
+// wait for it, those beyond are dropped (see dropped()). flush() waits for them to be reported.
+struct win_eventlog_options {
+    bool background = false;
+    size_t max_pending = 1024 * 1024;
+};
+
 /*
  * Windows Event Log sink
  */
@@ -190,6 +201,32 @@ private:
     internal::sid_t current_user_sid_;
     std::string source_;
     DWORD event_id_;
+    win_eventlog_options options_;
+
+#ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
+    using wide_buf_t = wmemory_buf_t;
+#else
+    struct wide_buf_t {};  // not needed for ReportEventA
+#endif
+
+    // reused from one message to the next (under the sink's lock)
+    memory_buf_t formatted_;
+    wide_buf_t wformatted_;
+
+    // the background reporter's: the messages (null terminated, back to back) and their events
+    struct pending_event {
+        WORD type;
+        WORD category;
+        size_t size;
+    };
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::string pending_text_;
+    std::vector<pending_event> pending_events_;
+    bool reporting_ = false;
+    bool stop_ = false;
+    std::atomic<size_t> dropped_{0};
+    std::thread reporter_;
 
     HANDLE event_log_handle() {
         if (!hEventLog_) {
@@ -202,28 +239,25 @@ private:
         return hEventLog_;
     }
 
-protected:
-    void sink_it_(const details::log_msg &msg) override {
+    // report the null terminated text (size including the null)
+    void report_(WORD type, WORD category, const char *text, size_t size, wide_buf_t &wbuf) {
         using namespace internal;
 
         bool succeeded;
-        memory_buf_t formatted;
-        base_sink<Mutex>::formatter_->format(msg, formatted);
-        formatted.push_back('\0');
-
 #ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
-        wmemory_buf_t buf;
-        details::os::utf8_to_wstrbuf(string_view_t(formatted.data(), formatted.size()), buf);
+        details::os::utf8_to_wstrbuf(string_view_t(text, size), wbuf);
 
-        LPCWSTR lp_wstr = buf.data();
-        succeeded = static_cast<bool>(::ReportEventW(
-            event_log_handle(), eventlog::get_event_type(msg), eventlog::get_event_category(msg),
-            event_id_, current_user_sid_.as_sid(), 1, 0, &lp_wstr, nullptr));
+        LPCWSTR lp_wstr = wbuf.data();
+        succeeded = static_cast<bool>(::ReportEventW(event_log_handle(), type, category, event_id_,
+                                                     current_user_sid_.as_sid(), 1, 0, &lp_wstr,
+                                                     nullptr));
 #else
-        LPCSTR lp_str = formatted.data();
-        succeeded = static_cast<bool>(::ReportEventA(
-            event_log_handle(), eventlog::get_event_type(msg), eventlog::get_event_category(msg),
-            event_id_, current_user_sid_.as_sid(), 1, 0, &lp_str, nullptr));
+        (void)size;
+        (void)wbuf;
+        LPCSTR lp_str = text;
+        succeeded = static_cast<bool>(::ReportEventA(event_log_handle(), type, category, event_id_,
+                                                     current_user_sid_.as_sid(), 1, 0, &lp_str,
+                                                     nullptr));
 #endif
 
         if (!succeeded) {
@@ -231,24 +265,104 @@ protected:
         }
     }
 
-    void flush_() override {}
+    void reporter_loop_() {
+        std::string text;
+        std::vector<pending_event> events;
+        wide_buf_t wbuf;
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        for (;;) {
+            pending_cv_.wait(lock, [this] { return stop_ || !pending_events_.empty(); });
+            if (pending_events_.empty()) {
+                return;  // stopped
+            }
+            text.swap(pending_text_);
+            events.swap(pending_events_);
+            reporting_ = true;
+            lock.unlock();
+            size_t offset = 0;
+            for (const auto &event : events) {
+                SPDLOG_TRY {
+                    report_(event.type, event.category, text.data() + offset, event.size, wbuf);
+                }
+                SPDLOG_CATCH_STD
+                offset += event.size;
+            }
+            text.clear();
+            events.clear();
+            lock.lock();
+            reporting_ = false;
+            pending_cv_.notify_all();
+        }
+    }
+
+protected:
+    void sink_it_(const details::log_msg &msg) override {
+        using namespace internal;
+
+        formatted_.clear();
+        base_sink<Mutex>::formatter_->format(msg, formatted_);
+        formatted_.push_back('\0');
+        auto type = eventlog::get_event_type(msg);
+        auto category = eventlog::get_event_category(msg);
+        if (!options_.background) {
+            report_(type, category, formatted_.data(), formatted_.size(), wformatted_);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            if (!pending_text_.empty() &&
+                pending_text_.size() + formatted_.size() > options_.max_pending) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            pending_text_.append(formatted_.data(), formatted_.size());
+            pending_events_.push_back(pending_event{type, category, formatted_.size()});
+        }
+        pending_cv_.notify_all();
+    }
+
+    // waits for the background reporter to report the messages given to it
+    void flush_() override {
+        if (!options_.background) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        pending_cv_.wait(lock, [this] { return pending_events_.empty() && !reporting_; });
+    }
 
 public:
     win_eventlog_sink(std::string const &source,
-                      DWORD event_id = 1000 /* according to mscoree.dll */)
+                      DWORD event_id = 1000 /* according to mscoree.dll */,
+                      win_eventlog_options options = {})
         : source_(source),
-          event_id_(event_id) {
+          event_id_(event_id),
+          options_(options) {
         try {
             current_user_sid_ = internal::sid_t::get_current_user_sid();
         } catch (...) {
             // get_current_user_sid() is unlikely to fail and if it does, we can still proceed
             // without current_user_sid but in the event log the record will have no user name
         }
+        if (options_.background) {
+            reporter_ = std::thread([this] { reporter_loop_(); });
+        }
     }
 
+    // the messages waiting are reported first
     ~win_eventlog_sink() {
+        if (reporter_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                stop_ = true;
+            }
+            pending_cv_.notify_all();
+            reporter_.join();
+        }
         if (hEventLog_) DeregisterEventSource(hEventLog_);
     }
+
+    // number of messages dropped because the background reporter was too far behind
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
 };
 
 }  // namespace win_eventlog
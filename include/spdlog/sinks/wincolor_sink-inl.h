@@ -13,12 +13,15 @@
 #include <spdlog/common.h>
 #include <spdlog/pattern_formatter.h>
 
+#include <iterator>
+
 namespace spdlog {
 namespace sinks {
 template <typename ConsoleMutex>
 SPDLOG_INLINE wincolor_sink<ConsoleMutex>::wincolor_sink(void *out_handle, color_mode mode)
     : out_handle_(out_handle),
-      mutex_(ConsoleMutex::mutex()),
+      mutex_(
+          ConsoleMutex::mutex(out_handle == ::GetStdHandle(STD_ERROR_HANDLE) ? stderr : stdout)),
       formatter_(details::make_unique<spdlog::pattern_formatter>()) {
     set_color_mode_impl(mode);
     // set level colors
@@ -54,9 +57,47 @@ void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::log(const details::log_msg &msg)
     }
 
     std::lock_guard<mutex_t> lock(mutex_);
+    log_(msg);
+}
+
+template <typename ConsoleMutex>
+void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::log_batch(const details::log_msg *msgs,
+                                                          size_t count) {
+    if (out_handle_ == nullptr || out_handle_ == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    std::lock_guard<mutex_t> lock(mutex_);
+    if (!vt_mode_) {
+        for (size_t i = 0; i < count; i++) {
+            if (should_log(msgs[i])) {
+                log_(msgs[i]);
+            }
+        }
+        return;
+    }
+    // the whole batch with one console call
+    memory_buf_t formatted;
+    memory_buf_t batch;
+    for (size_t i = 0; i < count; i++) {
+        if (should_log(msgs[i])) {
+            append_vt_(msgs[i], formatted, batch);
+        }
+    }
+    print_range_(batch, 0, batch.size());
+}
+
+template <typename ConsoleMutex>
+void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::log_(const details::log_msg &msg) {
+    memory_buf_t formatted;
+    if (vt_mode_) {
+        memory_buf_t colored;
+        append_vt_(msg, formatted, colored);
+        print_range_(colored, 0, colored.size());
+        return;
+    }
     msg.color_range_start = 0;
     msg.color_range_end = 0;
-    memory_buf_t formatted;
     formatter_->format(msg, formatted);
     if (should_do_colors_ && msg.color_range_end > msg.color_range_start) {
         // before color range
@@ -74,6 +115,37 @@ void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::log(const details::log_msg &msg)
     }
 }
 
+template <typename ConsoleMutex>
+void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::append_vt_(const details::log_msg &msg,
+                                                           memory_buf_t &formatted,
+                                                           memory_buf_t &dest) {
+    msg.color_range_start = 0;
+    msg.color_range_end = 0;
+    formatted.clear();
+    formatter_->format(msg, formatted);
+    const char *data = formatted.data();
+    if (msg.color_range_end <= msg.color_range_start) {
+        dest.append(data, data + formatted.size());
+        return;
+    }
+    dest.append(data, data + msg.color_range_start);
+    // the console attributes as SGR colors: red, green and blue bits swapped, intensity as bright
+    static const int rgb_to_ansi[] = {0, 4, 2, 6, 1, 5, 3, 7};
+    auto attribs = colors_[static_cast<size_t>(msg.level)];
+    int foreground = ((attribs & FOREGROUND_INTENSITY) ? 90 : 30) + rgb_to_ansi[attribs & 7];
+    if (attribs & 0xf0) {
+        int background =
+            ((attribs & BACKGROUND_INTENSITY) ? 100 : 40) + rgb_to_ansi[(attribs >> 4) & 7];
+        fmt_lib::format_to(std::back_inserter(dest), "\x1b[{};{}m", foreground, background);
+    } else {
+        fmt_lib::format_to(std::back_inserter(dest), "\x1b[{}m", foreground);
+    }
+    dest.append(data + msg.color_range_start, data + msg.color_range_end);
+    static const char reset[] = "\x1b[m";
+    dest.append(reset, reset + sizeof(reset) - 1);
+    dest.append(data + msg.color_range_end, data + formatted.size());
+}
+
 template <typename ConsoleMutex>
 void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::flush() {
     // windows console always flushed?
@@ -100,14 +172,23 @@ void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::set_color_mode(color_mode mode)
 
 template <typename ConsoleMutex>
 void SPDLOG_INLINE wincolor_sink<ConsoleMutex>::set_color_mode_impl(color_mode mode) {
+    // should do colors only if out_handle_  points to actual console.
+    DWORD console_mode = 0;
+    bool in_console = ::GetConsoleMode(static_cast<HANDLE>(out_handle_), &console_mode) != 0;
     if (mode == color_mode::automatic) {
-        // should do colors only if out_handle_  points to actual console.
-        DWORD console_mode;
-        bool in_console = ::GetConsoleMode(static_cast<HANDLE>(out_handle_), &console_mode) != 0;
         should_do_colors_ = in_console;
     } else {
         should_do_colors_ = mode == color_mode::always ? true : false;
     }
+    vt_mode_ = false;
+    if (should_do_colors_ && in_console) {
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+        const DWORD ENABLE_VIRTUAL_TERMINAL_PROCESSING = 0x0004;
+#endif
+        vt_mode_ = (console_mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0 ||
+                   ::SetConsoleMode(static_cast<HANDLE>(out_handle_),
+                                    console_mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+    }
 }
 
 // set foreground color and return the orig console attributes (for resetting later)
@@ -18,7 +18,12 @@ namespace spdlog {
 namespace sinks {
 /*
  * Windows color console sink. Uses WriteConsoleA to write to the console with
- * colors
+ * colors (WriteConsoleW with SPDLOG_UTF8_TO_WCHAR_CONSOLE).
+ *
+ * On consoles supporting virtual terminal sequences (Windows 10 and up, where the sink enables
+ * them), the colors are written as escape sequences: one console call per message, or per batch
+ * of messages (e.g. from an async logger), instead of one per color range plus the calls
+ * changing the attributes.
  */
 template <typename ConsoleMutex>
 class wincolor_sink : public sink {
@@ -32,6 +37,7 @@ public:
     // change the color for the given level
     void set_color(level::level_enum level, std::uint16_t color);
     void log(const details::log_msg &msg) final override;
+    void log_batch(const details::log_msg *msgs, size_t count) final override;
     void flush() final override;
     void set_pattern(const std::string &pattern) override final;
     void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override final;
@@ -42,9 +48,16 @@ protected:
     void *out_handle_;
     mutex_t &mutex_;
     bool should_do_colors_;
+    bool vt_mode_ = false;  // colors written as virtual terminal sequences
     std::unique_ptr<spdlog::formatter> formatter_;
     std::array<std::uint16_t, level::n_levels> colors_;
 
+    // called with mutex_ locked
+    void log_(const details::log_msg &msg);
+
+    // format msg into formatted, and append it to dest with its color range in sequences
+    void append_vt_(const details::log_msg &msg, memory_buf_t &formatted, memory_buf_t &dest);
+
     // set foreground color and return the orig console attributes (for resetting later)
     std::uint16_t set_foreground_color_(std::uint16_t attribs);
 
@@ -79,4 +92,12 @@ using wincolor_stderr_sink_st = wincolor_stderr_sink<details::console_nullmutex>
 
 #ifdef SPDLOG_HEADER_ONLY
     #include "wincolor_sink-inl.h"
+    #ifdef SPDLOG_EXTERN_TEMPLATES  // defined in spdlog/instantiate.h
+extern template class spdlog::sinks::wincolor_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::wincolor_sink<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::wincolor_stdout_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::wincolor_stdout_sink<spdlog::details::console_nullmutex>;
+extern template class spdlog::sinks::wincolor_stderr_sink<spdlog::details::console_mutex>;
+extern template class spdlog::sinks::wincolor_stderr_sink<spdlog::details::console_nullmutex>;
+    #endif
 #endif
@@ -8,6 +8,7 @@
 #endif
 
 #include <spdlog/common.h>
+#include <spdlog/details/os.h>
 #include <spdlog/pattern_formatter.h>
 
 namespace spdlog {
@@ -16,7 +17,11 @@ SPDLOG_INLINE void initialize_logger(std::shared_ptr<logger> logger) {
     details::registry::instance().initialize_logger(std::move(logger));
 }
 
-SPDLOG_INLINE std::shared_ptr<logger> get(const std::string &name) {
+SPDLOG_INLINE void initialize_loggers(const std::vector<std::shared_ptr<logger>> &loggers) {
+    details::registry::instance().initialize_loggers(loggers);
+}
+
+SPDLOG_INLINE std::shared_ptr<logger> get(string_view_t name) {
     return details::registry::instance().get(name);
 }
 
@@ -35,18 +40,22 @@ SPDLOG_INLINE void enable_backtrace(size_t n_messages) {
 
 SPDLOG_INLINE void disable_backtrace() { details::registry::instance().disable_backtrace(); }
 
-SPDLOG_INLINE void dump_backtrace() { default_logger_raw()->dump_backtrace(); }
+SPDLOG_INLINE void dump_backtrace() { details::default_logger_ref()->dump_backtrace(); }
 
-SPDLOG_INLINE level::level_enum get_level() { return default_logger_raw()->level(); }
+SPDLOG_INLINE level::level_enum get_level() { return details::default_logger_ref()->level(); }
 
 SPDLOG_INLINE bool should_log(level::level_enum log_level) {
-    return default_logger_raw()->should_log(log_level);
+    return details::default_logger_ref()->should_log(log_level);
 }
 
 SPDLOG_INLINE void set_level(level::level_enum log_level) {
     details::registry::instance().set_level(log_level);
 }
 
+SPDLOG_INLINE void set_tree_level(const std::string &name, level::level_enum log_level) {
+    details::registry::instance().set_tree_level(name, log_level);
+}
+
 SPDLOG_INLINE void flush_on(level::level_enum log_level) {
     details::registry::instance().flush_on(log_level);
 }
@@ -63,6 +72,10 @@ SPDLOG_INLINE void apply_all(const std::function<void(std::shared_ptr<logger>)>
     details::registry::instance().apply_all(fun);
 }
 
+SPDLOG_INLINE bool flush_all(std::chrono::milliseconds timeout) {
+    return details::registry::instance().flush_all(timeout);
+}
+
 SPDLOG_INLINE void drop(const std::string &name) { details::registry::instance().drop(name); }
 
 SPDLOG_INLINE void drop_all() { details::registry::instance().drop_all(); }
@@ -73,10 +86,46 @@ SPDLOG_INLINE void set_automatic_registration(bool automatic_registration) {
     details::registry::instance().set_automatic_registration(automatic_registration);
 }
 
+SPDLOG_INLINE void set_sink_sharing(bool sink_sharing) {
+    details::registry::instance().set_sink_sharing(sink_sharing);
+}
+
+SPDLOG_INLINE void invalidate_thread_names() { details::os::invalidate_thread_names(); }
+
 SPDLOG_INLINE std::shared_ptr<spdlog::logger> default_logger() {
     return details::registry::instance().default_logger();
 }
 
+SPDLOG_INLINE std::uint32_t details::refresh_default_callsite(std::atomic<std::uint32_t> &callsite,
+                                                             level::level_enum lvl,
+                                                             const char *file) {
+    // read before the levels, so that a change after them makes the callsite check again
+    auto generation = details::level_generation();
+    auto file_level = details::registry::instance().file_level(file);
+    details::default_logger_ref logger;
+    auto state = details::callsite_off;
+    if (logger.get() != nullptr) {
+        if (file_level != level::n_levels) {
+            state = lvl >= file_level ? details::callsite_forced : details::callsite_off;
+        } else if (logger->should_log(lvl) || logger->should_backtrace()) {
+            state = details::callsite_logs;
+        }
+    }
+    callsite.store((generation << details::callsite_state_bits) | state,
+                   std::memory_order_relaxed);
+    return state;
+}
+
+SPDLOG_INLINE level::level_enum details::refresh_file_callsite(
+    std::atomic<std::uint32_t> &callsite, const char *file) {
+    auto generation = details::level_generation();
+    auto file_level = details::registry::instance().file_level(file);
+    callsite.store((generation << details::callsite_state_bits) |
+                       static_cast<std::uint32_t>(file_level),
+                   std::memory_order_relaxed);
+    return file_level;
+}
+
 SPDLOG_INLINE spdlog::logger *default_logger_raw() {
     return details::registry::instance().get_default_raw();
 }
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <spdlog/common.h>
+#include <spdlog/details/callsite.h>
 #include <spdlog/details/registry.h>
 #include <spdlog/details/synchronous_factory.h>
 #include <spdlog/logger.h>
@@ -19,6 +20,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace spdlog {
 
@@ -36,6 +38,19 @@ inline std::shared_ptr<spdlog::logger> create(std::string logger_name, SinkArgs
                                          std::forward<SinkArgs>(sink_args)...);
 }
 
+// Create and register loggers sharing a single sink of a templated type, at once: faster than
+// creating them one by one when there are thousands of them. Throw spdlog_ex, creating none of
+// them, if a name is already registered.
+//
+// Example:
+//   auto loggers = spdlog::create_many<basic_file_sink_mt>({"plugin1", "plugin2"}, "plugins.log");
+template <typename Sink, typename... SinkArgs>
+inline std::vector<std::shared_ptr<spdlog::logger>> create_many(
+    const std::vector<std::string> &logger_names, SinkArgs &&...sink_args) {
+    return default_factory::create_many<Sink>(logger_names,
+                                              std::forward<SinkArgs>(sink_args)...);
+}
+
 // Initialize and register a logger,
 // formatter and flush level will be set according the global settings.
 //
@@ -46,10 +61,13 @@ inline std::shared_ptr<spdlog::logger> create(std::string logger_name, SinkArgs
 //   spdlog::initialize_logger(mylogger);
 SPDLOG_API void initialize_logger(std::shared_ptr<logger> logger);
 
+// initialize_logger() for each of the loggers, registered at once
+SPDLOG_API void initialize_loggers(const std::vector<std::shared_ptr<logger>> &loggers);
+
 // Return an existing logger or nullptr if a logger with such name doesn't
 // exist.
 // example: spdlog::get("my_logger")->info("hello {}", "world");
-SPDLOG_API std::shared_ptr<logger> get(const std::string &name);
+SPDLOG_API std::shared_ptr<logger> get(string_view_t name);
 
 // Set global formatter. Each sink in each logger will get a clone of this object
 SPDLOG_API void set_formatter(std::unique_ptr<spdlog::formatter> formatter);
@@ -74,6 +92,11 @@ SPDLOG_API level::level_enum get_level();
 // Set global logging level
 SPDLOG_API void set_level(level::level_enum log_level);
 
+// Set the level of the loggers named name or one of its dotted children (e.g. "db.pool.conn"
+// for "db"), except the children of a nearer name set. The loggers registered later get it too,
+// and it's kept until set_level() is called on a logger. Setting it again costs a single store.
+SPDLOG_API void set_tree_level(const std::string &name, level::level_enum log_level);
+
 // Determine whether the default logger should log messages with a certain level
 SPDLOG_API bool should_log(level::level_enum lvl);
 
@@ -98,6 +121,10 @@ SPDLOG_API void register_logger(std::shared_ptr<logger> logger);
 // spdlog::apply_all([&](std::shared_ptr<spdlog::logger> l) {l->flush();});
 SPDLOG_API void apply_all(const std::function<void(std::shared_ptr<logger>)> &fun);
 
+// Flush all the registered loggers in parallel, waiting for them up to the timeout.
+// Return false if some of them were still flushing then.
+SPDLOG_API bool flush_all(std::chrono::milliseconds timeout);
+
 // Drop the reference to the given logger
 SPDLOG_API void drop(const std::string &name);
 
@@ -110,6 +137,15 @@ SPDLOG_API void shutdown();
 // Automatic registration of loggers when using spdlog::create() or spdlog::create_async
 SPDLOG_API void set_automatic_registration(bool automatic_registration);
 
+// Share one sink between the loggers created by the factory functions (e.g. basic_logger_mt)
+// for the same file and sink type, instead of each one opening the file. The arguments of the
+// first logger's sink apply to the next ones.
+SPDLOG_API void set_sink_sharing(bool sink_sharing);
+
+// The thread name (%N) is cached by each thread. Call this after renaming a thread (other than
+// with the thread pool's thread names) so the new name gets logged.
+SPDLOG_API void invalidate_thread_names();
+
 // API for using default logger (stdout_color_mt),
 // e.g: spdlog::info("Message {}", 1);
 //
@@ -120,10 +156,9 @@ SPDLOG_API void set_automatic_registration(bool automatic_registration);
 // The default logger can replaced using spdlog::set_default_logger(new_logger).
 // For example, to replace it with a file logger.
 //
-// IMPORTANT:
-// The default API is thread safe (for _mt loggers), but:
-// set_default_logger() *should not* be used concurrently with the default API.
-// e.g do not call set_default_logger() from one thread while calling spdlog::info() from another.
+// The default API is thread safe (for _mt loggers), and set_default_logger() can be called
+// while other threads log with it: the previous default logger is destroyed once they are done.
+// Only default_logger_raw() should not be used concurrently with set_default_logger().
 
 SPDLOG_API std::shared_ptr<spdlog::logger> default_logger();
 
@@ -140,57 +175,141 @@ SPDLOG_API void set_default_logger(std::shared_ptr<spdlog::logger> default_logge
 //   spdlog::apply_logger_env_levels(mylogger);
 SPDLOG_API void apply_logger_env_levels(std::shared_ptr<logger> logger);
 
+namespace details {
+// the state of a default api macro callsite: not logging, logging with the default logger's
+// level, or logging whatever it is (for the level set for the source file)
+constexpr std::uint32_t callsite_off = 0;
+constexpr std::uint32_t callsite_logs = 1;
+constexpr std::uint32_t callsite_forced = 2;
+
+// store in callsite the current level generation, and its state for lvl
+SPDLOG_API std::uint32_t refresh_default_callsite(std::atomic<std::uint32_t> &callsite,
+                                                  level::level_enum lvl,
+                                                  const char *file);
+
+// the state of a callsite of the default api macros for lvl, as cached
+inline std::uint32_t default_callsite(std::atomic<std::uint32_t> &callsite,
+                                      level::level_enum lvl,
+                                      const char *file) {
+    auto state = callsite.load(std::memory_order_relaxed);
+    if ((state >> callsite_state_bits) == level_generation()) {
+        return state & callsite_state_mask;
+    }
+    return refresh_default_callsite(callsite, lvl, file);
+}
+
+// store in callsite the current level generation, and the level set for file
+SPDLOG_API level::level_enum refresh_file_callsite(std::atomic<std::uint32_t> &callsite,
+                                                   const char *file);
+
+// the level set for the source file of a callsite of the logger macros (level::n_levels if
+// none), as cached
+inline level::level_enum file_callsite_level(std::atomic<std::uint32_t> &callsite,
+                                             const char *file) {
+    auto state = callsite.load(std::memory_order_relaxed);
+    if ((state >> callsite_state_bits) == level_generation()) {
+        return static_cast<level::level_enum>(state & callsite_state_mask);
+    }
+    return refresh_file_callsite(callsite, file);
+}
+}  // namespace details
+
 template <typename... Args>
 inline void log(source_loc source,
                 level::level_enum lvl,
                 format_string_t<Args...> fmt,
                 Args &&...args) {
-    default_logger_raw()->log(source, lvl, fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->log(source, lvl, fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void log(level::level_enum lvl, format_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->log(source_loc{}, lvl, fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->log(source_loc{}, lvl, fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void trace(format_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->trace(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->trace(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void debug(format_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->debug(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->debug(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void info(format_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->info(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->info(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void warn(format_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->warn(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->warn(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void error(format_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->error(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->error(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void critical(format_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->critical(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->critical(fmt, std::forward<Args>(args)...);
+}
+
+// messages with typed fields (see kv.h and logger::log)
+template <typename... Fields>
+inline void log(source_loc source,
+                level::level_enum lvl,
+                const char *msg,
+                kv_field field,
+                Fields... fields) {
+    details::default_logger_ref()->log(source, lvl, msg, field, fields...);
+}
+
+template <typename... Fields>
+inline void log(level::level_enum lvl, const char *msg, kv_field field, Fields... fields) {
+    details::default_logger_ref()->log(source_loc{}, lvl, msg, field, fields...);
+}
+
+template <typename... Fields>
+inline void trace(const char *msg, kv_field field, Fields... fields) {
+    details::default_logger_ref()->trace(msg, field, fields...);
+}
+
+template <typename... Fields>
+inline void debug(const char *msg, kv_field field, Fields... fields) {
+    details::default_logger_ref()->debug(msg, field, fields...);
+}
+
+template <typename... Fields>
+inline void info(const char *msg, kv_field field, Fields... fields) {
+    details::default_logger_ref()->info(msg, field, fields...);
+}
+
+template <typename... Fields>
+inline void warn(const char *msg, kv_field field, Fields... fields) {
+    details::default_logger_ref()->warn(msg, field, fields...);
+}
+
+template <typename... Fields>
+inline void error(const char *msg, kv_field field, Fields... fields) {
+    details::default_logger_ref()->error(msg, field, fields...);
+}
+
+template <typename... Fields>
+inline void critical(const char *msg, kv_field field, Fields... fields) {
+    details::default_logger_ref()->critical(msg, field, fields...);
 }
 
 template <typename T>
 inline void log(source_loc source, level::level_enum lvl, const T &msg) {
-    default_logger_raw()->log(source, lvl, msg);
+    details::default_logger_ref()->log(source, lvl, msg);
 }
 
 template <typename T>
 inline void log(level::level_enum lvl, const T &msg) {
-    default_logger_raw()->log(lvl, msg);
+    details::default_logger_ref()->log(lvl, msg);
 }
 
 #ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
@@ -199,73 +318,73 @@ inline void log(source_loc source,
                 level::level_enum lvl,
                 wformat_string_t<Args...> fmt,
                 Args &&...args) {
-    default_logger_raw()->log(source, lvl, fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->log(source, lvl, fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void log(level::level_enum lvl, wformat_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->log(source_loc{}, lvl, fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->log(source_loc{}, lvl, fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void trace(wformat_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->trace(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->trace(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void debug(wformat_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->debug(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->debug(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void info(wformat_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->info(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->info(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void warn(wformat_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->warn(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->warn(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void error(wformat_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->error(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->error(fmt, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 inline void critical(wformat_string_t<Args...> fmt, Args &&...args) {
-    default_logger_raw()->critical(fmt, std::forward<Args>(args)...);
+    details::default_logger_ref()->critical(fmt, std::forward<Args>(args)...);
 }
 #endif
 
 template <typename T>
 inline void trace(const T &msg) {
-    default_logger_raw()->trace(msg);
+    details::default_logger_ref()->trace(msg);
 }
 
 template <typename T>
 inline void debug(const T &msg) {
-    default_logger_raw()->debug(msg);
+    details::default_logger_ref()->debug(msg);
 }
 
 template <typename T>
 inline void info(const T &msg) {
-    default_logger_raw()->info(msg);
+    details::default_logger_ref()->info(msg);
 }
 
 template <typename T>
 inline void warn(const T &msg) {
-    default_logger_raw()->warn(msg);
+    details::default_logger_ref()->warn(msg);
 }
 
 template <typename T>
 inline void error(const T &msg) {
-    default_logger_raw()->error(msg);
+    details::default_logger_ref()->error(msg);
 }
 
 template <typename T>
 inline void critical(const T &msg) {
-    default_logger_raw()->critical(msg);
+    details::default_logger_ref()->critical(msg);
 }
 
 }  // namespace spdlog
@@ -284,17 +403,89 @@ inline void critical(const T &msg) {
 //
 
 #ifndef SPDLOG_NO_SOURCE_LOC
-    #define SPDLOG_LOGGER_CALL(logger, level, ...) \
-        (logger)->log(spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, level, __VA_ARGS__)
+    #define SPDLOG_SOURCE_LOC_ \
+        spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION, SPDLOG_SHORT_FILENAME(__FILE__)}
+#else
+    #define SPDLOG_SOURCE_LOC_ spdlog::source_loc{}
+#endif
+
+// define SPDLOG_USE_FMT_COMPILE (before including spdlog.h) to have the macros below wrap their
+// format string in FMT_COMPILE(), so it is parsed at compile time (C++17 and up) instead of on
+// each call. The format string must then be a string literal.
+//
+
+#ifdef SPDLOG_USE_FMT_COMPILE
+    #ifdef SPDLOG_USE_STD_FORMAT
+        #error "SPDLOG_USE_FMT_COMPILE requires fmt, but SPDLOG_USE_STD_FORMAT is defined."
+    #endif
+
+namespace spdlog {
+namespace details {
+// SPDLOG_LOGGER_CALL passes the literal format string along with its compiled version, since
+// it can't split the format string from the arguments without a trailing comma.
+template <typename L, typename S, typename... Args>
+inline void log_compiled(L &&logger,
+                         source_loc loc,
+                         level::level_enum lvl,
+                         const S &fmt,
+                         string_view_t,
+                         Args &&...args) {
+    logger->log(loc, lvl, fmt, std::forward<Args>(args)...);
+}
+}  // namespace details
+}  // namespace spdlog
+
+    #define SPDLOG_EXPAND_(x) x
+    #define SPDLOG_FIRST_ARG_(first, ...) first
+    #define SPDLOG_COMPILED_ARGS_(...) \
+        FMT_COMPILE(SPDLOG_EXPAND_(SPDLOG_FIRST_ARG_(__VA_ARGS__, 0))), __VA_ARGS__
+
+    #define SPDLOG_LOGGER_CALL(logger, level, ...)                         \
+        spdlog::details::log_compiled((logger), SPDLOG_SOURCE_LOC_, level, \
+                                      SPDLOG_COMPILED_ARGS_(__VA_ARGS__))
 #else
     #define SPDLOG_LOGGER_CALL(logger, level, ...) \
-        (logger)->log(spdlog::source_loc{}, level, __VA_ARGS__)
+        (logger)->log(SPDLOG_SOURCE_LOC_, level, __VA_ARGS__)
+#endif
+
+// the default logger macros: each callsite caches whether it's enabled, so that a disabled
+// one costs a branch on its cache (see details/callsite.h). the callsites of the logger macros
+// cache the level set for their source file, if any (see cfg::helpers::load_vmodule).
+#ifdef SPDLOG_NO_CALLSITE_CACHE
+    #define SPDLOG_DEFAULT_CALL_(level, ...) \
+        SPDLOG_LOGGER_CALL(spdlog::details::default_logger_ref(), level, __VA_ARGS__)
+    #define SPDLOG_LOGGER_LEVEL_CALL_(logger, level, ...) \
+        SPDLOG_LOGGER_CALL(logger, level, __VA_ARGS__)
+#else
+    #define SPDLOG_DEFAULT_CALL_(log_level, ...)                                                   \
+        do {                                                                                       \
+            static std::atomic<std::uint32_t> spdlog_callsite_{0};                                 \
+            auto spdlog_state_ =                                                                   \
+                spdlog::details::default_callsite(spdlog_callsite_, log_level, __FILE__);          \
+            if (spdlog_state_ == spdlog::details::callsite_logs) {                                 \
+                SPDLOG_LOGGER_CALL(spdlog::details::default_logger_ref(), log_level, __VA_ARGS__); \
+            } else if (spdlog_state_ == spdlog::details::callsite_forced) {                        \
+                spdlog::details::default_logger_ref()->log_forced(SPDLOG_SOURCE_LOC_, log_level,   \
+                                                                  __VA_ARGS__);                    \
+            }                                                                                      \
+        } while (0)
+    #define SPDLOG_LOGGER_LEVEL_CALL_(logger, log_level, ...)                                     \
+        do {                                                                                      \
+            static std::atomic<std::uint32_t> spdlog_callsite_{0};                                \
+            auto spdlog_file_level_ =                                                             \
+                spdlog::details::file_callsite_level(spdlog_callsite_, __FILE__);                 \
+            if (spdlog_file_level_ == spdlog::level::n_levels) {                                  \
+                SPDLOG_LOGGER_CALL(logger, log_level, __VA_ARGS__);                               \
+            } else if (log_level >= spdlog_file_level_) {                                         \
+                (logger)->log_forced(SPDLOG_SOURCE_LOC_, log_level, __VA_ARGS__);                 \
+            }                                                                                     \
+        } while (0)
 #endif
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
     #define SPDLOG_LOGGER_TRACE(logger, ...) \
-        SPDLOG_LOGGER_CALL(logger, spdlog::level::trace, __VA_ARGS__)
-    #define SPDLOG_TRACE(...) SPDLOG_LOGGER_TRACE(spdlog::default_logger_raw(), __VA_ARGS__)
+        SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::trace, __VA_ARGS__)
+    #define SPDLOG_TRACE(...) SPDLOG_DEFAULT_CALL_(spdlog::level::trace, __VA_ARGS__)
 #else
     #define SPDLOG_LOGGER_TRACE(logger, ...) (void)0
     #define SPDLOG_TRACE(...) (void)0
@@ -302,8 +493,8 @@ inline void critical(const T &msg) {
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
     #define SPDLOG_LOGGER_DEBUG(logger, ...) \
-        SPDLOG_LOGGER_CALL(logger, spdlog::level::debug, __VA_ARGS__)
-    #define SPDLOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(spdlog::default_logger_raw(), __VA_ARGS__)
+        SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::debug, __VA_ARGS__)
+    #define SPDLOG_DEBUG(...) SPDLOG_DEFAULT_CALL_(spdlog::level::debug, __VA_ARGS__)
 #else
     #define SPDLOG_LOGGER_DEBUG(logger, ...) (void)0
     #define SPDLOG_DEBUG(...) (void)0
@@ -311,8 +502,8 @@ inline void critical(const T &msg) {
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
     #define SPDLOG_LOGGER_INFO(logger, ...) \
-        SPDLOG_LOGGER_CALL(logger, spdlog::level::info, __VA_ARGS__)
-    #define SPDLOG_INFO(...) SPDLOG_LOGGER_INFO(spdlog::default_logger_raw(), __VA_ARGS__)
+        SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::info, __VA_ARGS__)
+    #define SPDLOG_INFO(...) SPDLOG_DEFAULT_CALL_(spdlog::level::info, __VA_ARGS__)
 #else
     #define SPDLOG_LOGGER_INFO(logger, ...) (void)0
     #define SPDLOG_INFO(...) (void)0
@@ -320,8 +511,8 @@ inline void critical(const T &msg) {
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
     #define SPDLOG_LOGGER_WARN(logger, ...) \
-        SPDLOG_LOGGER_CALL(logger, spdlog::level::warn, __VA_ARGS__)
-    #define SPDLOG_WARN(...) SPDLOG_LOGGER_WARN(spdlog::default_logger_raw(), __VA_ARGS__)
+        SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::warn, __VA_ARGS__)
+    #define SPDLOG_WARN(...) SPDLOG_DEFAULT_CALL_(spdlog::level::warn, __VA_ARGS__)
 #else
     #define SPDLOG_LOGGER_WARN(logger, ...) (void)0
     #define SPDLOG_WARN(...) (void)0
@@ -329,8 +520,8 @@ inline void critical(const T &msg) {
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
     #define SPDLOG_LOGGER_ERROR(logger, ...) \
-        SPDLOG_LOGGER_CALL(logger, spdlog::level::err, __VA_ARGS__)
-    #define SPDLOG_ERROR(...) SPDLOG_LOGGER_ERROR(spdlog::default_logger_raw(), __VA_ARGS__)
+        SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::err, __VA_ARGS__)
+    #define SPDLOG_ERROR(...) SPDLOG_DEFAULT_CALL_(spdlog::level::err, __VA_ARGS__)
 #else
     #define SPDLOG_LOGGER_ERROR(logger, ...) (void)0
     #define SPDLOG_ERROR(...) (void)0
@@ -338,13 +529,195 @@ inline void critical(const T &msg) {
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_CRITICAL
     #define SPDLOG_LOGGER_CRITICAL(logger, ...) \
-        SPDLOG_LOGGER_CALL(logger, spdlog::level::critical, __VA_ARGS__)
-    #define SPDLOG_CRITICAL(...) SPDLOG_LOGGER_CRITICAL(spdlog::default_logger_raw(), __VA_ARGS__)
+        SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::critical, __VA_ARGS__)
+    #define SPDLOG_CRITICAL(...) SPDLOG_DEFAULT_CALL_(spdlog::level::critical, __VA_ARGS__)
 #else
     #define SPDLOG_LOGGER_CRITICAL(logger, ...) (void)0
     #define SPDLOG_CRITICAL(...) (void)0
 #endif
 
+// Per category compile time levels: SPDLOG_CATEGORY(category, active_level) declares a category
+// whose calls below active_level (one of the SPDLOG_LEVEL_ values above) are compiled out, as
+// SPDLOG_ACTIVE_LEVEL does for the whole build, and which ignores SPDLOG_ACTIVE_LEVEL. e.g.
+// SPDLOG_CATEGORY(net, SPDLOG_LEVEL_INFO);
+// SPDLOG_CATEGORY(control, SPDLOG_LEVEL_TRACE);
+// ...
+// SPDLOG_CAT_TRACE(net, "packet {}", id);          // no code, the args aren't evaluated
+// SPDLOG_CAT_TRACE(control, "state {}", state);    // same as SPDLOG_TRACE
+// SPDLOG_LOGGER_CAT_DEBUG(logger, control, "..."); // same as SPDLOG_LOGGER_DEBUG
+// The category is looked up where the macros are used, like any other name.
+//
+#define SPDLOG_CATEGORY(category, active_level)               \
+    struct spdlog_category_##category {                       \
+        static_assert((active_level) >= SPDLOG_LEVEL_TRACE && \
+                          (active_level) <= SPDLOG_LEVEL_OFF, \
+                      "SPDLOG_CATEGORY: invalid level");      \
+        static constexpr int level = (active_level);          \
+    }
+// a call compiled out is a constant false branch, removed by the compiler
+#define SPDLOG_CAT_CALL_(category, min_level, call)             \
+    do {                                                        \
+        if (spdlog_category_##category::level <= (min_level)) { \
+            call;                                               \
+        }                                                       \
+    } while (0)
+
+#define SPDLOG_LOGGER_CAT_TRACE(logger, category, ...) \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_TRACE,     \
+                     SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::trace, __VA_ARGS__))
+#define SPDLOG_CAT_TRACE(category, ...)            \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_TRACE, \
+                     SPDLOG_DEFAULT_CALL_(spdlog::level::trace, __VA_ARGS__))
+#define SPDLOG_LOGGER_CAT_DEBUG(logger, category, ...) \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_DEBUG,     \
+                     SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::debug, __VA_ARGS__))
+#define SPDLOG_CAT_DEBUG(category, ...)            \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_DEBUG, \
+                     SPDLOG_DEFAULT_CALL_(spdlog::level::debug, __VA_ARGS__))
+#define SPDLOG_LOGGER_CAT_INFO(logger, category, ...) \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_INFO,     \
+                     SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::info, __VA_ARGS__))
+#define SPDLOG_CAT_INFO(category, ...)            \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_INFO, \
+                     SPDLOG_DEFAULT_CALL_(spdlog::level::info, __VA_ARGS__))
+#define SPDLOG_LOGGER_CAT_WARN(logger, category, ...) \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_WARN,     \
+                     SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::warn, __VA_ARGS__))
+#define SPDLOG_CAT_WARN(category, ...)            \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_WARN, \
+                     SPDLOG_DEFAULT_CALL_(spdlog::level::warn, __VA_ARGS__))
+#define SPDLOG_LOGGER_CAT_ERROR(logger, category, ...) \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_ERROR,     \
+                     SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::err, __VA_ARGS__))
+#define SPDLOG_CAT_ERROR(category, ...)            \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_ERROR, \
+                     SPDLOG_DEFAULT_CALL_(spdlog::level::err, __VA_ARGS__))
+#define SPDLOG_LOGGER_CAT_CRITICAL(logger, category, ...) \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_CRITICAL,     \
+                     SPDLOG_LOGGER_LEVEL_CALL_(logger, spdlog::level::critical, __VA_ARGS__))
+#define SPDLOG_CAT_CRITICAL(category, ...)            \
+    SPDLOG_CAT_CALL_(category, SPDLOG_LEVEL_CRITICAL, \
+                     SPDLOG_DEFAULT_CALL_(spdlog::level::critical, __VA_ARGS__))
+
+// Rate limited and sampled logging (see log_limiter.h), each callsite keeping its own state:
+// SPDLOG_LOGGER_EVERY_N(logger, level, n, ...): the 1st message, then one every n.
+// SPDLOG_LOGGER_FIRST_N(logger, level, n, ...): only the n first messages.
+// SPDLOG_LOGGER_EVERY_MS(logger, level, ms, ...): at most one message every ms milliseconds.
+// SPDLOG_LOGGER_SAMPLED(logger, level, ratio, ...): this ratio (0 to 1) of the messages.
+// and SPDLOG_INFO_EVERY_N(n, ...) etc. for the default logger.
+// The messages suppressed are not formatted, and their number is appended to the next one.
+//
+#define SPDLOG_LOGGER_LIMITED_(logger, level, limiter_args, ...)                        \
+    do {                                                                                \
+        static spdlog::log_limiter spdlog_limiter_ limiter_args;                        \
+        (logger)->log_limited(spdlog_limiter_, SPDLOG_SOURCE_LOC_, level, __VA_ARGS__); \
+    } while (0)
+#define SPDLOG_LOGGER_EVERY_N(logger, level, n, ...) \
+    SPDLOG_LOGGER_LIMITED_(logger, level, (spdlog::log_limiter::every_n, n), __VA_ARGS__)
+#define SPDLOG_LOGGER_FIRST_N(logger, level, n, ...) \
+    SPDLOG_LOGGER_LIMITED_(logger, level, (spdlog::log_limiter::first_n, n), __VA_ARGS__)
+#define SPDLOG_LOGGER_EVERY_MS(logger, level, ms, ...) \
+    SPDLOG_LOGGER_LIMITED_(logger, level, (spdlog::log_limiter::every_ms, ms), __VA_ARGS__)
+#define SPDLOG_LOGGER_SAMPLED(logger, level, ratio, ...) \
+    SPDLOG_LOGGER_LIMITED_(logger, level, (static_cast<double>(ratio)), __VA_ARGS__)
+#define SPDLOG_DEFAULT_LOGGER_ spdlog::details::default_logger_ref()
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+    #define SPDLOG_TRACE_EVERY_N(n, ...) \
+        SPDLOG_LOGGER_EVERY_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::trace, n, __VA_ARGS__)
+    #define SPDLOG_TRACE_FIRST_N(n, ...) \
+        SPDLOG_LOGGER_FIRST_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::trace, n, __VA_ARGS__)
+    #define SPDLOG_TRACE_EVERY_MS(ms, ...) \
+        SPDLOG_LOGGER_EVERY_MS(SPDLOG_DEFAULT_LOGGER_, spdlog::level::trace, ms, __VA_ARGS__)
+    #define SPDLOG_TRACE_SAMPLED(ratio, ...) \
+        SPDLOG_LOGGER_SAMPLED(SPDLOG_DEFAULT_LOGGER_, spdlog::level::trace, ratio, __VA_ARGS__)
+#else
+    #define SPDLOG_TRACE_EVERY_N(n, ...) (void)0
+    #define SPDLOG_TRACE_FIRST_N(n, ...) (void)0
+    #define SPDLOG_TRACE_EVERY_MS(ms, ...) (void)0
+    #define SPDLOG_TRACE_SAMPLED(ratio, ...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+    #define SPDLOG_DEBUG_EVERY_N(n, ...) \
+        SPDLOG_LOGGER_EVERY_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::debug, n, __VA_ARGS__)
+    #define SPDLOG_DEBUG_FIRST_N(n, ...) \
+        SPDLOG_LOGGER_FIRST_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::debug, n, __VA_ARGS__)
+    #define SPDLOG_DEBUG_EVERY_MS(ms, ...) \
+        SPDLOG_LOGGER_EVERY_MS(SPDLOG_DEFAULT_LOGGER_, spdlog::level::debug, ms, __VA_ARGS__)
+    #define SPDLOG_DEBUG_SAMPLED(ratio, ...) \
+        SPDLOG_LOGGER_SAMPLED(SPDLOG_DEFAULT_LOGGER_, spdlog::level::debug, ratio, __VA_ARGS__)
+#else
+    #define SPDLOG_DEBUG_EVERY_N(n, ...) (void)0
+    #define SPDLOG_DEBUG_FIRST_N(n, ...) (void)0
+    #define SPDLOG_DEBUG_EVERY_MS(ms, ...) (void)0
+    #define SPDLOG_DEBUG_SAMPLED(ratio, ...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+    #define SPDLOG_INFO_EVERY_N(n, ...) \
+        SPDLOG_LOGGER_EVERY_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::info, n, __VA_ARGS__)
+    #define SPDLOG_INFO_FIRST_N(n, ...) \
+        SPDLOG_LOGGER_FIRST_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::info, n, __VA_ARGS__)
+    #define SPDLOG_INFO_EVERY_MS(ms, ...) \
+        SPDLOG_LOGGER_EVERY_MS(SPDLOG_DEFAULT_LOGGER_, spdlog::level::info, ms, __VA_ARGS__)
+    #define SPDLOG_INFO_SAMPLED(ratio, ...) \
+        SPDLOG_LOGGER_SAMPLED(SPDLOG_DEFAULT_LOGGER_, spdlog::level::info, ratio, __VA_ARGS__)
+#else
+    #define SPDLOG_INFO_EVERY_N(n, ...) (void)0
+    #define SPDLOG_INFO_FIRST_N(n, ...) (void)0
+    #define SPDLOG_INFO_EVERY_MS(ms, ...) (void)0
+    #define SPDLOG_INFO_SAMPLED(ratio, ...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+    #define SPDLOG_WARN_EVERY_N(n, ...) \
+        SPDLOG_LOGGER_EVERY_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::warn, n, __VA_ARGS__)
+    #define SPDLOG_WARN_FIRST_N(n, ...) \
+        SPDLOG_LOGGER_FIRST_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::warn, n, __VA_ARGS__)
+    #define SPDLOG_WARN_EVERY_MS(ms, ...) \
+        SPDLOG_LOGGER_EVERY_MS(SPDLOG_DEFAULT_LOGGER_, spdlog::level::warn, ms, __VA_ARGS__)
+    #define SPDLOG_WARN_SAMPLED(ratio, ...) \
+        SPDLOG_LOGGER_SAMPLED(SPDLOG_DEFAULT_LOGGER_, spdlog::level::warn, ratio, __VA_ARGS__)
+#else
+    #define SPDLOG_WARN_EVERY_N(n, ...) (void)0
+    #define SPDLOG_WARN_FIRST_N(n, ...) (void)0
+    #define SPDLOG_WARN_EVERY_MS(ms, ...) (void)0
+    #define SPDLOG_WARN_SAMPLED(ratio, ...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+    #define SPDLOG_ERROR_EVERY_N(n, ...) \
+        SPDLOG_LOGGER_EVERY_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::err, n, __VA_ARGS__)
+    #define SPDLOG_ERROR_FIRST_N(n, ...) \
+        SPDLOG_LOGGER_FIRST_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::err, n, __VA_ARGS__)
+    #define SPDLOG_ERROR_EVERY_MS(ms, ...) \
+        SPDLOG_LOGGER_EVERY_MS(SPDLOG_DEFAULT_LOGGER_, spdlog::level::err, ms, __VA_ARGS__)
+    #define SPDLOG_ERROR_SAMPLED(ratio, ...) \
+        SPDLOG_LOGGER_SAMPLED(SPDLOG_DEFAULT_LOGGER_, spdlog::level::err, ratio, __VA_ARGS__)
+#else
+    #define SPDLOG_ERROR_EVERY_N(n, ...) (void)0
+    #define SPDLOG_ERROR_FIRST_N(n, ...) (void)0
+    #define SPDLOG_ERROR_EVERY_MS(ms, ...) (void)0
+    #define SPDLOG_ERROR_SAMPLED(ratio, ...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_CRITICAL
+    #define SPDLOG_CRITICAL_EVERY_N(n, ...) \
+        SPDLOG_LOGGER_EVERY_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::critical, n, __VA_ARGS__)
+    #define SPDLOG_CRITICAL_FIRST_N(n, ...) \
+        SPDLOG_LOGGER_FIRST_N(SPDLOG_DEFAULT_LOGGER_, spdlog::level::critical, n, __VA_ARGS__)
+    #define SPDLOG_CRITICAL_EVERY_MS(ms, ...) \
+        SPDLOG_LOGGER_EVERY_MS(SPDLOG_DEFAULT_LOGGER_, spdlog::level::critical, ms, __VA_ARGS__)
+    #define SPDLOG_CRITICAL_SAMPLED(ratio, ...) \
+        SPDLOG_LOGGER_SAMPLED(SPDLOG_DEFAULT_LOGGER_, spdlog::level::critical, ratio, __VA_ARGS__)
+#else
+    #define SPDLOG_CRITICAL_EVERY_N(n, ...) (void)0
+    #define SPDLOG_CRITICAL_FIRST_N(n, ...) (void)0
+    #define SPDLOG_CRITICAL_EVERY_MS(ms, ...) (void)0
+    #define SPDLOG_CRITICAL_SAMPLED(ratio, ...) (void)0
+#endif
+
 #ifdef SPDLOG_HEADER_ONLY
     #include "spdlog-inl.h"
 #endif
@@ -0,0 +1,410 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Pattern formatter for patterns known at compile time (C++20):
+//
+//   logger->set_formatter(std::make_unique<spdlog::static_pattern_formatter<"[%T] [%l] %v">>());
+//
+// The pattern is parsed at compile time into a tuple of the built-in flag formatters, so each
+// message is formatted by direct calls to them (no virtual call per flag), and the flags
+// without padding use the null padder. The output is the same as with pattern_formatter.
+// Custom flags are not supported.
+
+#include <spdlog/details/flag_formatters.h>
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+    #define SPDLOG_HAS_STATIC_PATTERN_FORMATTER
+#endif
+
+#ifdef SPDLOG_HAS_STATIC_PATTERN_FORMATTER
+
+    #include <array>
+    #include <cstring>
+    #include <memory>
+    #include <string>
+    #include <tuple>
+    #include <type_traits>
+    #include <utility>
+
+namespace spdlog {
+namespace details {
+
+// string literal usable as a template argument
+template <size_t N>
+struct static_pattern {
+    constexpr static_pattern(const char (&str)[N]) {
+        for (size_t i = 0; i < N; i++) {
+            chars[i] = str[i];
+        }
+    }
+
+    constexpr size_t size() const { return N - 1; }
+    constexpr char operator[](size_t i) const { return chars[i]; }
+
+    char chars[N] = {};
+};
+
+// a flag (with its padding) or a run of literal chars [begin, end) of the pattern
+struct static_pattern_token {
+    char flag = 0;  // 0 for literal chars
+    size_t begin = 0;
+    size_t end = 0;
+    bool padded = false;
+    size_t width = 0;
+    padding_info::pad_side side = padding_info::pad_side::left;
+    bool truncate = false;
+};
+
+constexpr bool is_static_pattern_flag(char flag) {
+    #ifndef SPDLOG_NO_TLS
+    if (flag == '&') {
+        return true;
+    }
+    #endif
+    for (char ch : "+nlLtNvaAbhBcCYDxmdHIMSefFEprRTXzP^$@sg#!uioO") {
+        if (ch != '\0' && ch == flag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the log_msg fields read by a flag (same as pattern_formatter)
+constexpr unsigned static_pattern_flag_fields(char flag) {
+    switch (flag) {
+        case 't':
+            return msg_field::thread_id;
+        case 'N':
+            return msg_field::thread_name;
+        case '@':
+        case 's':
+        case 'g':
+        case '#':
+        case '!':
+            return msg_field::source;
+        case '+':
+            return msg_field::time | msg_field::source;
+        default:
+            break;
+    }
+    for (char ch : "aAbhBcCYDxmdHIMSprRTXzefFEuioO") {
+        if (ch != '\0' && ch == flag) {
+            return msg_field::time;
+        }
+    }
+    return msg_field::none;
+}
+
+constexpr bool static_pattern_flag_needs_localtime(char flag) {
+    for (char ch : "+aAbhBcCYDxmdHIMSprRTXz") {
+        if (ch != '\0' && ch == flag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// same rules as pattern_formatter::compile_pattern_() and handle_padspec_().
+// store the tokens (if not null) and return their number.
+template <size_t N>
+constexpr size_t parse_static_pattern(const static_pattern<N> &pattern,
+                                      static_pattern_token *tokens) {
+    const size_t max_width = 64;
+    const size_t end = pattern.size();
+    size_t n = 0;
+    auto add = [&](const static_pattern_token &token) {
+        if (tokens != nullptr) {
+            tokens[n] = token;
+        }
+        n++;
+    };
+    auto add_chars = [&](size_t begin, size_t chars_end) {
+        static_pattern_token token;
+        token.begin = begin;
+        token.end = chars_end;
+        add(token);
+    };
+    auto is_digit = [&](size_t i) { return i < end && pattern[i] >= '0' && pattern[i] <= '9'; };
+
+    size_t chars_begin = 0;
+    size_t i = 0;
+    while (i < end) {
+        if (pattern[i] != '%') {
+            i++;
+            continue;
+        }
+        if (chars_begin < i) {
+            add_chars(chars_begin, i);
+        }
+        auto percent = i++;
+
+        static_pattern_token token;
+        if (i < end && pattern[i] == '-') {
+            token.side = padding_info::pad_side::right;
+            i++;
+        } else if (i < end && pattern[i] == '=') {
+            token.side = padding_info::pad_side::center;
+            i++;
+        }
+        if (is_digit(i)) {
+            for (; is_digit(i); i++) {
+                token.width = token.width * 10 + static_cast<size_t>(pattern[i] - '0');
+            }
+            if (i < end && pattern[i] == '!') {
+                token.truncate = true;
+                i++;
+            }
+            token.width = token.width < max_width ? token.width : max_width;
+            token.padded = true;
+        } else {
+            token.side = padding_info::pad_side::left;
+        }
+
+        if (i == end) {
+            chars_begin = end;
+            break;
+        }
+        token.flag = pattern[i];
+        if (token.flag == '%') {
+            add_chars(i, i + 1);
+        } else if (is_static_pattern_flag(token.flag)) {
+            add(token);
+        } else if (!token.truncate) {
+            // unknown flag appears as is
+            add_chars(percent, percent + 1);
+            add_chars(i, i + 1);
+        } else {
+            // "%3!!" - the truncate marker was the funcname flag (see issue #1617)
+            token.flag = '!';
+            token.truncate = false;
+            add(token);
+            add_chars(i, i + 1);
+        }
+        chars_begin = ++i;
+    }
+    if (chars_begin < end) {
+        add_chars(chars_begin, end);
+    }
+    return n;
+}
+
+template <static_pattern Pattern>
+constexpr auto compile_static_pattern() {
+    constexpr size_t n = parse_static_pattern(Pattern, nullptr);
+    std::array<static_pattern_token, n> tokens{};
+    parse_static_pattern(Pattern, tokens.data());
+    return tokens;
+}
+
+// placeholder for the literal chars in the formatters tuple
+struct static_chars_formatter {};
+
+template <char Flag, typename Padder>
+auto make_static_flag_formatter(padding_info padding) {
+    if constexpr (Flag == '+') {
+        return full_formatter(padding);
+    } else if constexpr (Flag == 'n') {
+        return name_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'l') {
+        return level_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'L') {
+        return short_level_formatter<Padder>(padding);
+    } else if constexpr (Flag == 't') {
+        return t_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'N') {
+        return thread_name_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'v') {
+        return v_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'a') {
+        return a_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'A') {
+        return A_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'b' || Flag == 'h') {
+        return b_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'B') {
+        return B_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'c') {
+        return c_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'C') {
+        return C_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'Y') {
+        return Y_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'D' || Flag == 'x') {
+        return D_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'm') {
+        return m_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'd') {
+        return d_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'H') {
+        return H_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'I') {
+        return I_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'M') {
+        return M_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'S') {
+        return S_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'e') {
+        return e_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'f') {
+        return f_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'F') {
+        return F_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'E') {
+        return E_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'p') {
+        return p_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'r') {
+        return r_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'R') {
+        return R_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'T' || Flag == 'X') {
+        return T_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'z') {
+        return z_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'P') {
+        return pid_formatter<Padder>(padding);
+    } else if constexpr (Flag == '^') {
+        return color_start_formatter(padding);
+    } else if constexpr (Flag == '$') {
+        return color_stop_formatter(padding);
+    } else if constexpr (Flag == '@') {
+        return source_location_formatter<Padder>(padding);
+    } else if constexpr (Flag == 's') {
+        return short_filename_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'g') {
+        return source_filename_formatter<Padder>(padding);
+    } else if constexpr (Flag == '#') {
+        return source_linenum_formatter<Padder>(padding);
+    } else if constexpr (Flag == '!') {
+        return source_funcname_formatter<Padder>(padding);
+    } else if constexpr (Flag == 'u') {
+        return elapsed_formatter<Padder, std::chrono::nanoseconds>(padding);
+    } else if constexpr (Flag == 'i') {
+        return elapsed_formatter<Padder, std::chrono::microseconds>(padding);
+    } else if constexpr (Flag == 'o') {
+        return elapsed_formatter<Padder, std::chrono::milliseconds>(padding);
+    } else if constexpr (Flag == 'O') {
+        return elapsed_formatter<Padder, std::chrono::seconds>(padding);
+    #ifndef SPDLOG_NO_TLS
+    } else if constexpr (Flag == '&') {
+        return mdc_formatter<Padder>(padding);
+    #endif
+    } else {
+        return static_chars_formatter{};
+    }
+}
+
+template <static_pattern_token Token>
+auto make_static_token_formatter() {
+    if constexpr (Token.padded) {
+        return make_static_flag_formatter<Token.flag, scoped_padder>(
+            padding_info{Token.width, Token.side, Token.truncate});
+    } else {
+        return make_static_flag_formatter<Token.flag, null_scoped_padder>(padding_info{});
+    }
+}
+
+// built in place: some flag formatters (e.g. z_formatter) can't be moved
+template <static_pattern_token Token>
+struct static_token_formatter {
+    decltype(make_static_token_formatter<Token>()) formatter = make_static_token_formatter<Token>();
+};
+
+template <auto Tokens, size_t... I>
+std::tuple<static_token_formatter<Tokens[I]>...> static_token_formatters(
+    std::index_sequence<I...>);
+
+}  // namespace details
+
+template <details::static_pattern Pattern>
+class static_pattern_formatter final : public formatter {
+public:
+    explicit static_pattern_formatter(pattern_time_type time_type = pattern_time_type::local,
+                                      std::string eol = spdlog::details::os::default_eol)
+        : eol_(std::move(eol)),
+          pattern_time_type_(time_type) {
+        std::memset(&cached_tm_, 0, sizeof(cached_tm_));
+    }
+
+    static_pattern_formatter(const static_pattern_formatter &other) = delete;
+    static_pattern_formatter &operator=(const static_pattern_formatter &other) = delete;
+
+    std::unique_ptr<formatter> clone() const override {
+        return details::make_unique<static_pattern_formatter>(pattern_time_type_, eol_);
+    }
+
+    void format(const details::log_msg &msg, memory_buf_t &dest) override {
+        if constexpr (need_localtime_) {
+            const auto secs =
+                std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
+            if (secs != last_log_secs_) {
+                cached_tm_ = pattern_time_type_ == pattern_time_type::local
+                                 ? details::os::fast_localtime(log_clock::to_time_t(msg.time))
+                                 : details::os::fast_gmtime(log_clock::to_time_t(msg.time));
+                last_log_secs_ = secs;
+            }
+        }
+        format_tokens_(msg, dest, std::make_index_sequence<tokens_.size()>{});
+        details::fmt_helper::append_string_view(eol_, dest);
+    }
+
+    unsigned needed_fields() const override { return needed_fields_; }
+
+    static constexpr string_view_t pattern() {
+        return string_view_t(Pattern.chars, Pattern.size());
+    }
+
+private:
+    static constexpr auto tokens_ = details::compile_static_pattern<Pattern>();
+
+    static constexpr bool need_localtime_ = [] {
+        for (auto &token : tokens_) {
+            if (details::static_pattern_flag_needs_localtime(token.flag)) {
+                return true;
+            }
+        }
+        return false;
+    }();
+
+    static constexpr unsigned needed_fields_ = [] {
+        unsigned fields = msg_field::none;
+        for (auto &token : tokens_) {
+            fields |= details::static_pattern_flag_fields(token.flag);
+        }
+        return fields;
+    }();
+
+    std::string eol_;
+    pattern_time_type pattern_time_type_;
+    std::tm cached_tm_;
+    std::chrono::seconds last_log_secs_{0};
+    decltype(details::static_token_formatters<tokens_>(
+        std::make_index_sequence<tokens_.size()>{})) formatters_;
+
+    template <size_t... I>
+    void format_tokens_(const details::log_msg &msg,
+                        memory_buf_t &dest,
+                        std::index_sequence<I...>) {
+        (format_token_<I>(msg, dest), ...);
+    }
+
+    template <size_t I>
+    void format_token_(const details::log_msg &msg, memory_buf_t &dest) {
+        constexpr auto token = tokens_[I];
+        if constexpr (token.flag == 0) {
+            details::fmt_helper::append_string_view(
+                string_view_t(Pattern.chars + token.begin, token.end - token.begin), dest);
+        } else {
+            // qualified call: not dispatched through the vtable
+            auto &token_formatter = std::get<I>(formatters_).formatter;
+            using formatter_type = std::remove_reference_t<decltype(token_formatter)>;
+            token_formatter.formatter_type::format(msg, cached_tm_, dest);
+        }
+    }
+};
+
+}  // namespace spdlog
+
+#endif  // SPDLOG_HAS_STATIC_PATTERN_FORMATTER
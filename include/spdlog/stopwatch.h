@@ -4,6 +4,8 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <spdlog/details/tsc_clock.h>
 #include <spdlog/fmt/fmt.h>
 
 // Stopwatch support for spdlog  (using std::chrono::steady_clock).
@@ -25,6 +27,11 @@
 // using std::chrono::duration_cast;
 // using std::chrono::milliseconds;
 // spdlog::info("Elapsed {}", duration_cast<milliseconds>(sw.elapsed())); => "Elapsed 5ms"
+//
+// spdlog::tsc_stopwatch is used the same way, and reads the cpu time stamp counter instead of
+// steady_clock (see details::tsc_clock), so starting and reading it cost a few cycles. Until the
+// counter's rate is calibrated (a few dozen ms after the first ones started), or where there is
+// no invariant counter, it reads steady_clock.
 
 namespace spdlog {
 class stopwatch {
@@ -45,6 +52,44 @@ public:
 
     void reset() { start_tp_ = clock::now(); }
 };
+
+class tsc_stopwatch {
+    using clock = std::chrono::steady_clock;
+    double ns_per_tick_;  // 0 if reading steady_clock
+    std::uint64_t start_ticks_ = 0;
+    std::chrono::time_point<clock> start_tp_;
+
+    double elapsed_ns_() const {
+        return static_cast<double>(details::tsc_clock::ticks() - start_ticks_) * ns_per_tick_;
+    }
+
+public:
+    tsc_stopwatch() { reset(); }
+
+    std::chrono::duration<double> elapsed() const {
+        if (ns_per_tick_ == 0) {
+            return std::chrono::duration<double>(clock::now() - start_tp_);
+        }
+        return std::chrono::duration<double>(elapsed_ns_() / 1e9);
+    }
+
+    std::chrono::milliseconds elapsed_ms() const {
+        if (ns_per_tick_ == 0) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_tp_);
+        }
+        return std::chrono::milliseconds(static_cast<std::int64_t>(elapsed_ns_() / 1e6));
+    }
+
+    void reset() {
+        ns_per_tick_ = details::tsc_clock::ns_per_tick();
+        if (ns_per_tick_ == 0) {
+            details::tsc_clock::now();  // takes a calibration sample
+            start_tp_ = clock::now();
+        } else {
+            start_ticks_ = details::tsc_clock::ticks();
+        }
+    }
+};
 }  // namespace spdlog
 
 // Support for fmt formatting  (e.g. "{:012.9}" or just "{}")
@@ -63,4 +108,13 @@ struct formatter<spdlog::stopwatch> : formatter<double> {
         return formatter<double>::format(sw.elapsed().count(), ctx);
     }
 };
+
+template <>
+struct formatter<spdlog::tsc_stopwatch> : formatter<double> {
+    template <typename FormatContext>
+    auto format(const spdlog::tsc_stopwatch &sw, FormatContext &ctx) const
+        -> decltype(ctx.out()) {
+        return formatter<double>::format(sw.elapsed().count(), ctx);
+    }
+};
 }  // namespace std
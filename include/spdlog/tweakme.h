@@ -53,6 +53,15 @@
 // #define SPDLOG_NO_ATOMIC_LEVELS
 ///////////////////////////////////////////////////////////////////////////////
 
+///////////////////////////////////////////////////////////////////////////////
+// Header-only build: uncomment to declare the _mt/_st instantiations of the
+// base, file and console sinks extern, so that they are compiled once instead of
+// in each translation unit using them.
+// Exactly one translation unit must then include <spdlog/instantiate.h>.
+//
+// #define SPDLOG_EXTERN_TEMPLATES
+///////////////////////////////////////////////////////////////////////////////
+
 ///////////////////////////////////////////////////////////////////////////////
 // Uncomment to enable usage of wchar_t for file names on Windows.
 //
@@ -139,3 +148,65 @@
 // # define SPDLOG_FUNCTION __FUNCTION__
 // #endif
 ///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment to have SPDLOG_INFO(..) and the other macros parse their format string at compile
+// time with FMT_COMPILE() (C++17 and up, ignored otherwise). The format string must then be a
+// string literal. Not available with SPDLOG_USE_STD_FORMAT.
+//
+// #define SPDLOG_USE_FMT_COMPILE
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment and set to change the size of the buffer embedded in each async
+// (and backtrace) message. Longer messages take a buffer from a pool instead.
+//
+// #define SPDLOG_MSG_BUFFER_INLINE_SIZE 250
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment and set to change the capacity up to which the buffer each thread formats its
+// messages to is kept between messages. A bigger one is freed after the message.
+//
+// #define SPDLOG_SCRATCH_BUFFER_MAX_SIZE (64 * 1024)
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment and set to change the text appended to the payloads cut at a logger's
+// max_payload_size().
+//
+// #define SPDLOG_TRUNCATION_MARKER "...[truncated]"
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment and set to change the size up to which the level specs of SPDLOG_LEVEL and
+// SPDLOG_VMODULE (or their cfg::helpers functions) are applied. Longer ones are ignored.
+//
+// #define SPDLOG_CFG_MAX_SIZE 512
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment and set to an allocator template (std::allocator interface, default
+// constructible and copy assignable) to allocate the formatting buffers (memory_buf_t)
+// with it, in the loggers, the formatters and the sinks. Only the messages longer than
+// 250 bytes allocate. Not available with SPDLOG_USE_STD_FORMAT.
+// std::pmr::polymorphic_allocator is not assignable: wrap its memory_resource pointer.
+//
+// #define SPDLOG_BUFFER_ALLOCATOR my_arena_allocator
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment and set to an allocator template (same requirements as above) to allocate the
+// buffers of the async and backtrace messages too big for their inline buffer with it,
+// instead of taking them from spdlog's pool. Those buffers are freed on the thread pool's
+// threads. Not available with SPDLOG_USE_STD_FORMAT.
+//
+// #define SPDLOG_MSG_BUFFER_ALLOCATOR my_arena_allocator
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment to park the threads of the lock-free async queue on a mutex and
+// condition variables in C++20 too, instead of std::atomic::wait/notify.
+//
+// #define SPDLOG_NO_ATOMIC_WAIT
+///////////////////////////////////////////////////////////////////////////////
@@ -7,5 +7,7 @@
 
 #include <spdlog/async.h>
 #include <spdlog/async_logger-inl.h>
+#include <spdlog/async_tee_logger-inl.h>
 #include <spdlog/details/periodic_worker-inl.h>
+#include <spdlog/details/scheduler-inl.h>
 #include <spdlog/details/thread_pool-inl.h>
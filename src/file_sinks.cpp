@@ -5,7 +5,11 @@
     #error Please define SPDLOG_COMPILED_LIB to compile this file.
 #endif
 
+#include <spdlog/details/dir_snapshot-inl.h>
 #include <spdlog/details/file_helper-inl.h>
+#include <spdlog/details/file_index-inl.h>
+#include <spdlog/details/file_housekeeper-inl.h>
+#include <spdlog/details/rotation_schedule-inl.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/sinks/base_sink-inl.h>
 #include <spdlog/sinks/basic_file_sink-inl.h>
@@ -5,15 +5,22 @@
     #error Please define SPDLOG_COMPILED_LIB to compile this file.
 #endif
 
+#include <spdlog/binary_formatter-inl.h>
 #include <spdlog/common-inl.h>
 #include <spdlog/details/backtracer-inl.h>
 #include <spdlog/details/log_msg-inl.h>
 #include <spdlog/details/log_msg_buffer-inl.h>
+#include <spdlog/details/msg_pool-inl.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/details/os-inl.h>
 #include <spdlog/details/registry-inl.h>
+#include <spdlog/details/tsc_clock-inl.h>
+#include <spdlog/json_formatter-inl.h>
+#include <spdlog/logfmt_formatter-inl.h>
 #include <spdlog/logger-inl.h>
+#include <spdlog/logger_fwd-inl.h>
 #include <spdlog/pattern_formatter-inl.h>
+#include <spdlog/redactor-inl.h>
 #include <spdlog/sinks/base_sink-inl.h>
 #include <spdlog/sinks/sink-inl.h>
 #include <spdlog/spdlog-inl.h>
@@ -17,6 +17,13 @@ template class SPDLOG_API spdlog::sinks::stdout_sink<spdlog::details::console_mu
 template class SPDLOG_API spdlog::sinks::stdout_sink<spdlog::details::console_nullmutex>;
 template class SPDLOG_API spdlog::sinks::stderr_sink<spdlog::details::console_mutex>;
 template class SPDLOG_API spdlog::sinks::stderr_sink<spdlog::details::console_nullmutex>;
+template class SPDLOG_API spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_mutex>;
+template class SPDLOG_API
+    spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_nullmutex>;
+template class SPDLOG_API spdlog::sinks::buffered_stdout_sink<spdlog::details::console_mutex>;
+template class SPDLOG_API spdlog::sinks::buffered_stdout_sink<spdlog::details::console_nullmutex>;
+template class SPDLOG_API spdlog::sinks::buffered_stderr_sink<spdlog::details::console_mutex>;
+template class SPDLOG_API spdlog::sinks::buffered_stderr_sink<spdlog::details::console_nullmutex>;
 
 template SPDLOG_API std::shared_ptr<spdlog::logger>
 spdlog::stdout_logger_mt<spdlog::synchronous_factory>(const std::string &logger_name);
@@ -26,6 +33,12 @@ template SPDLOG_API std::shared_ptr<spdlog::logger>
 spdlog::stderr_logger_mt<spdlog::synchronous_factory>(const std::string &logger_name);
 template SPDLOG_API std::shared_ptr<spdlog::logger>
 spdlog::stderr_logger_st<spdlog::synchronous_factory>(const std::string &logger_name);
+template SPDLOG_API std::shared_ptr<spdlog::logger>
+spdlog::buffered_stdout_logger_mt<spdlog::synchronous_factory>(
+    const std::string &logger_name, spdlog::sinks::stdout_buffer_options options);
+template SPDLOG_API std::shared_ptr<spdlog::logger>
+spdlog::buffered_stdout_logger_st<spdlog::synchronous_factory>(
+    const std::string &logger_name, spdlog::sinks::stdout_buffer_options options);
 
 template SPDLOG_API std::shared_ptr<spdlog::logger> spdlog::stdout_logger_mt<spdlog::async_factory>(
     const std::string &logger_name);
@@ -35,3 +48,9 @@ template SPDLOG_API std::shared_ptr<spdlog::logger> spdlog::stderr_logger_mt<spd
     const std::string &logger_name);
 template SPDLOG_API std::shared_ptr<spdlog::logger> spdlog::stderr_logger_st<spdlog::async_factory>(
     const std::string &logger_name);
+template SPDLOG_API std::shared_ptr<spdlog::logger>
+spdlog::buffered_stdout_logger_mt<spdlog::async_factory>(
+    const std::string &logger_name, spdlog::sinks::stdout_buffer_options options);
+template SPDLOG_API std::shared_ptr<spdlog::logger>
+spdlog::buffered_stdout_logger_st<spdlog::async_factory>(
+    const std::string &logger_name, spdlog::sinks::stdout_buffer_options options);
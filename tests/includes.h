@@ -27,6 +27,7 @@
 #include "spdlog/async.h"
 #include "spdlog/details/fmt_helper.h"
 #include "spdlog/details/os.h"
+#include "spdlog/details/tsc_clock.h"
 
 #ifndef SPDLOG_NO_TLS
     #include "spdlog/mdc.h"
@@ -40,3 +41,7 @@
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/sinks/msvc_sink.h"
 #include "spdlog/pattern_formatter.h"
+#include "spdlog/static_pattern_formatter.h"
+#include "spdlog/json_formatter.h"
+#include "spdlog/logfmt_formatter.h"
+#include "spdlog/binary_formatter.h"
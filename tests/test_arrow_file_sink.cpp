@@ -0,0 +1,250 @@
+#include "includes.h"
+#include "spdlog/sinks/arrow_file_sink.h"
+
+#define ARROW_FILENAME "test_logs/log.arrows"
+
+namespace {
+template <typename T>
+T read_le(const char *p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// reads the flatbuffers tables of the metadata
+struct fb_table {
+    const char *pos;
+
+    const char *field(unsigned slot) const {
+        const char *vtable = pos - read_le<std::int32_t>(pos);
+        auto vtable_size = read_le<std::uint16_t>(vtable);
+        if (4 + 2 * slot >= vtable_size) {
+            return nullptr;
+        }
+        auto offset = read_le<std::uint16_t>(vtable + 4 + 2 * slot);
+        return offset == 0 ? nullptr : pos + offset;
+    }
+
+    template <typename T>
+    T scalar(unsigned slot) const {
+        auto *p = field(slot);
+        return p == nullptr ? T(0) : read_le<T>(p);
+    }
+
+    static const char *deref(const char *p) { return p + read_le<std::uint32_t>(p); }
+
+    fb_table table(unsigned slot) const { return fb_table{deref(field(slot))}; }
+
+    std::string string(unsigned slot) const {
+        auto *s = deref(field(slot));
+        return std::string(s + 4, read_le<std::uint32_t>(s));
+    }
+
+    // the elements and their count
+    const char *vector(unsigned slot, size_t &count) const {
+        auto *v = deref(field(slot));
+        count = read_le<std::uint32_t>(v);
+        return v + 4;
+    }
+
+    std::vector<fb_table> tables(unsigned slot) const {
+        size_t count;
+        auto *elements = vector(slot, count);
+        std::vector<fb_table> result;
+        for (size_t i = 0; i < count; i++) {
+            result.push_back(fb_table{deref(elements + 4 * i)});
+        }
+        return result;
+    }
+};
+
+struct arrow_message {
+    std::uint8_t type;  // 1: schema, 3: record batch
+    fb_table header;
+    const char *body;
+};
+
+// the messages of an Arrow IPC stream, checking its framing
+std::vector<arrow_message> read_stream(const std::string &data, bool &ended) {
+    std::vector<arrow_message> messages;
+    size_t pos = 0;
+    ended = false;
+    while (pos + 8 <= data.size()) {
+        REQUIRE(pos % 8 == 0);
+        REQUIRE(read_le<std::uint32_t>(data.data() + pos) == 0xffffffff);
+        auto size = read_le<std::uint32_t>(data.data() + pos + 4);
+        if (size == 0) {
+            ended = true;
+            REQUIRE(pos + 8 == data.size());
+            break;
+        }
+        REQUIRE(size % 8 == 0);
+        auto *metadata = data.data() + pos + 8;
+        fb_table message{fb_table::deref(metadata)};
+        REQUIRE(message.scalar<std::int16_t>(0) == 4);  // V5
+        auto body_length = static_cast<size_t>(message.scalar<std::int64_t>(3));
+        REQUIRE(body_length % 8 == 0);
+        messages.push_back(arrow_message{message.scalar<std::uint8_t>(1), message.table(2),
+                                         metadata + size});
+        pos += 8 + size + body_length;
+        REQUIRE(pos <= data.size());
+    }
+    return messages;
+}
+
+// the columns of a record batch (see details/arrow_ipc.h for the order of their buffers)
+struct record_batch {
+    std::int64_t rows;
+    std::vector<std::int64_t> nodes;    // length, null count
+    std::vector<std::int64_t> buffers;  // offset, length
+    const char *body;
+
+    explicit record_batch(const arrow_message &message)
+        : rows(message.header.scalar<std::int64_t>(0)),
+          body(message.body) {
+        size_t count;
+        auto *p = message.header.vector(1, count);
+        for (size_t i = 0; i < count * 2; i++) {
+            nodes.push_back(read_le<std::int64_t>(p + 8 * i));
+        }
+        p = message.header.vector(2, count);
+        for (size_t i = 0; i < count * 2; i++) {
+            buffers.push_back(read_le<std::int64_t>(p + 8 * i));
+        }
+    }
+
+    const char *buffer(size_t index) const { return body + buffers[2 * index]; }
+
+    size_t buffer_size(size_t index) const { return static_cast<size_t>(buffers[2 * index + 1]); }
+
+    template <typename T>
+    T value(size_t buffer_index, size_t row) const {
+        return read_le<T>(buffer(buffer_index) + sizeof(T) * row);
+    }
+
+    // the offsets are in the buffer, the data in the next one
+    std::string text(size_t offsets_index, size_t row) const {
+        auto begin = value<std::int32_t>(offsets_index, row);
+        auto end = value<std::int32_t>(offsets_index, row + 1);
+        return std::string(buffer(offsets_index + 1) + begin, static_cast<size_t>(end - begin));
+    }
+
+    bool valid(size_t validity_index, size_t row) const {
+        if (buffer_size(validity_index) == 0) {
+            return true;
+        }
+        return (buffer(validity_index)[row / 8] >> (row % 8) & 1) != 0;
+    }
+};
+}  // namespace
+
+TEST_CASE("arrow_file_sink", "[arrow_file_sink]") {
+    prepare_logdir();
+    auto before = std::chrono::system_clock::now();
+    {
+        auto sink = std::make_shared<spdlog::sinks::arrow_file_sink_st>(
+            SPDLOG_FILENAME_T(ARROW_FILENAME), 1024 * 1024, 0, 3);
+        spdlog::logger logger("arrow", sink);
+        logger.set_level(spdlog::level::trace);
+        logger.info("first");
+        logger.log(spdlog::source_loc{"file.cpp", 42, "func"}, spdlog::level::warn, "second");
+        logger.error("third {}", 3);
+        logger.info("fourth", spdlog::kv("status", 200), spdlog::kv("path", "/index"));
+    }
+
+    bool ended;
+    auto data = file_contents(ARROW_FILENAME);
+    auto messages = read_stream(data, ended);
+    REQUIRE(ended);
+    REQUIRE(messages.size() == 3);
+
+    REQUIRE(messages[0].type == 1);
+    auto fields = messages[0].header.tables(1);
+    std::vector<std::string> names;
+    for (auto &field : fields) {
+        names.push_back(field.string(0));
+    }
+    REQUIRE(names == std::vector<std::string>{"time", "level", "logger", "thread", "source_file",
+                                              "source_line", "source_function", "message",
+                                              "fields"});
+    REQUIRE(fields[0].scalar<std::uint8_t>(2) == 10);  // timestamp
+    REQUIRE(fields[0].table(3).scalar<std::int16_t>(0) == 3);
+    REQUIRE(fields[0].table(3).string(1) == "UTC");
+    REQUIRE(fields[3].scalar<std::uint8_t>(2) == 2);  // int
+    REQUIRE(fields[3].table(3).scalar<std::int32_t>(0) == 64);
+    REQUIRE(fields[4].scalar<std::uint8_t>(1) == 1);  // nullable
+    REQUIRE(fields[8].scalar<std::uint8_t>(2) == 17);  // map
+    auto entries = fields[8].tables(5);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].scalar<std::uint8_t>(2) == 13);  // struct
+    REQUIRE(entries[0].tables(5).size() == 2);
+    REQUIRE(entries[0].tables(5)[0].string(0) == "key");
+
+    REQUIRE(messages[1].type == 3);
+    record_batch first(messages[1]);
+    REQUIRE(first.rows == 3);
+    REQUIRE(first.nodes.size() == 12 * 2);
+    REQUIRE(first.buffers.size() == 30 * 2);
+    auto time = spdlog::log_clock::time_point(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(
+            std::chrono::nanoseconds(first.value<std::int64_t>(1, 0))));
+    REQUIRE(time >= before - std::chrono::seconds(1));
+    REQUIRE(time <= std::chrono::system_clock::now());
+    REQUIRE(first.text(3, 0) == "info");
+    REQUIRE(first.text(3, 1) == "warning");
+    REQUIRE(first.text(6, 2) == "arrow");
+    REQUIRE(first.value<std::uint64_t>(9, 0) == spdlog::details::os::thread_id());
+    REQUIRE(first.nodes[4 * 2 + 1] == 2);  // source_file nulls
+    REQUIRE_FALSE(first.valid(10, 0));
+    REQUIRE(first.valid(10, 1));
+    REQUIRE(first.text(11, 1) == "file.cpp");
+    REQUIRE(first.value<std::int32_t>(14, 1) == 42);
+    REQUIRE(first.text(16, 1) == "func");
+    REQUIRE(first.text(19, 2) == "third 3");
+    REQUIRE(first.nodes[9 * 2] == 0);  // no kv fields
+
+    record_batch second(messages[2]);
+    REQUIRE(second.rows == 1);
+    REQUIRE(second.text(19, 0) == "fourth");
+    REQUIRE(second.nodes[4 * 2 + 1] == 1);
+    REQUIRE(second.value<std::int32_t>(22, 1) == 2);  // the fields of the row
+    REQUIRE(second.text(25, 0) == "status");
+    REQUIRE(second.text(28, 0) == "200");
+    REQUIRE(second.text(25, 1) == "path");
+    REQUIRE(second.text(28, 1) == "/index");
+}
+
+TEST_CASE("arrow_file_sink rotation", "[arrow_file_sink]") {
+    prepare_logdir();
+    {
+        // a batch for each message, each rotating the file
+        auto sink = std::make_shared<spdlog::sinks::arrow_file_sink_st>(
+            SPDLOG_FILENAME_T(ARROW_FILENAME), 1, 2, 1);
+        spdlog::logger logger("arrow", sink);
+        for (int i = 0; i < 5; i++) {
+            logger.info("message {}", i);
+        }
+    }
+    REQUIRE(count_files("test_logs") == 3);
+
+    bool ended;
+    auto current = file_contents(ARROW_FILENAME);
+    REQUIRE(read_stream(current, ended).size() == 1);  // the schema
+    REQUIRE(ended);
+    auto newest = file_contents("test_logs/log.1.arrows");
+    auto messages = read_stream(newest, ended);
+    REQUIRE(ended);
+    REQUIRE(messages.size() == 2);
+    REQUIRE(record_batch(messages[1]).text(19, 0) == "message 4");
+    auto oldest = file_contents("test_logs/log.2.arrows");
+    messages = read_stream(oldest, ended);
+    REQUIRE(record_batch(messages[1]).text(19, 0) == "message 3");
+
+    // an existing file is rotated
+    {
+        auto sink = std::make_shared<spdlog::sinks::arrow_file_sink_st>(
+            SPDLOG_FILENAME_T(ARROW_FILENAME), 1024 * 1024, 2, 1);
+    }
+    REQUIRE(file_contents("test_logs/log.1.arrows") == current);
+    REQUIRE(file_contents("test_logs/log.2.arrows") == newest);
+}
@@ -1,8 +1,13 @@
 #include "includes.h"
 #include "spdlog/async.h"
+#include "spdlog/async_tee_logger.h"
 #include "spdlog/sinks/basic_file_sink.h"
+#include "spdlog/sinks/callback_sink.h"
+#include "spdlog/sinks/ringbuffer_sink.h"
 #include "test_sink.h"
 
+#include <algorithm>
+
 #define TEST_FILENAME "test_logs/async_test.log"
 
 TEST_CASE("basic async test ", "[async]") {
@@ -57,6 +62,147 @@ TEST_CASE("discard policy discard_new ", "[async]") {
     REQUIRE(tp->discard_counter() > 0);
 }
 
+TEST_CASE("sample overflow policy", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%v");
+    test_sink->set_delay(std::chrono::milliseconds(2));
+    size_t messages = 200;
+
+    spdlog::details::thread_pool_options options(16, 1);
+    options.sample_rate = 1;
+    options.sample_burst = 2;
+    auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+    auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp,
+                                                         spdlog::async_overflow_policy::sample);
+    for (size_t i = 0; i < messages; i++) {
+        logger->info("Hello message");
+    }
+    auto dropped = tp->sampled_out_counter();
+    REQUIRE(dropped > 0);
+    REQUIRE(tp->discard_counter() == 0);
+
+    // once the queue drained, the next message reports the dropped ones first
+    while (tp->queue_size() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    logger->info("after");
+    logger->flush();
+    while (test_sink->flush_counter() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(test_sink->msg_counter() == messages - dropped + 2);
+    auto lines = test_sink->lines();
+    REQUIRE(lines.size() >= 2);
+    REQUIRE(lines[lines.size() - 2] == std::to_string(dropped) + " messages dropped");
+    REQUIRE(lines.back() == "after");
+}
+
+TEST_CASE("queue latency", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_delay(std::chrono::milliseconds(1));
+    spdlog::details::thread_pool_options options(128, 1);
+    options.queue_latency = true;
+    options.batch_size = 1;
+    auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+    auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+    for (int i = 0; i < 20; i++) {
+        logger->info("message {}", i);
+    }
+    logger->flush();
+    while (test_sink->flush_counter() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto latency = tp->queue_latency();
+    REQUIRE(latency.count == 20);
+    // the last messages waited for the sink to write (at least 1ms each) those before them
+    REQUIRE(latency.percentile(1.0) >= std::chrono::milliseconds(10));
+    REQUIRE(latency.mean() > std::chrono::nanoseconds(0));
+
+    tp->reset_queue_latency();
+    REQUIRE(tp->queue_latency().count == 0);
+
+    // off by default
+    auto quiet_tp = std::make_shared<spdlog::details::thread_pool>(16, 1);
+    auto quiet_logger = std::make_shared<spdlog::async_logger>("quiet", test_sink, quiet_tp);
+    quiet_logger->info("message");
+    while (test_sink->msg_counter() < 21) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(quiet_tp->queue_latency().count == 0);
+}
+
+TEST_CASE("queue quota", "[async]") {
+    auto noisy_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    noisy_sink->set_delay(std::chrono::milliseconds(1));
+    auto quiet_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t messages = 500;
+    size_t overruns = 0;
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(64, 1);
+        auto noisy = std::make_shared<spdlog::async_logger>(
+            "noisy", noisy_sink, tp, spdlog::async_overflow_policy::discard_new);
+        noisy->set_queue_quota(8);
+        auto quiet = std::make_shared<spdlog::async_logger>(
+            "quiet", quiet_sink, tp, spdlog::async_overflow_policy::discard_new);
+        for (size_t i = 0; i < messages; i++) {
+            noisy->info("Hello message");
+            if (i % 25 == 0) {
+                quiet->info("Hello message");
+            }
+        }
+        overruns = noisy->overrun_counter();
+        REQUIRE(overruns > 0);
+        REQUIRE(quiet->overrun_counter() == 0);
+        REQUIRE(tp->discard_counter() == 0);
+    }
+    REQUIRE(noisy_sink->msg_counter() == messages - overruns);
+    REQUIRE(quiet_sink->msg_counter() == messages / 25);
+}
+
+TEST_CASE("queue quota block", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_delay(std::chrono::milliseconds(1));
+    size_t messages = 100;
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(64, 1);
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        logger->set_queue_quota(4);
+        for (size_t i = 0; i < messages; i++) {
+            logger->info("Hello message");
+            REQUIRE(tp->queue_size() <= 4);
+        }
+        REQUIRE(logger->overrun_counter() == 0);
+    }
+    REQUIRE(test_sink->msg_counter() == messages);
+}
+
+TEST_CASE("shutdown with deadline", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%l");
+    test_sink->set_delay(std::chrono::milliseconds(5));
+    auto tp = std::make_shared<spdlog::details::thread_pool>(1024, 1);
+    auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+    for (size_t i = 0; i < 200; i++) {
+        logger->info("Hello message");
+    }
+    for (size_t i = 0; i < 10; i++) {
+        logger->error("Hello message");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto abandoned = tp->shutdown(std::chrono::milliseconds(400));
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    REQUIRE(abandoned > 0);
+    REQUIRE(test_sink->msg_counter() == 210 - abandoned);
+    // the errors were kept, the infos skipped first
+    auto lines = test_sink->lines();
+    REQUIRE(std::count(lines.begin(), lines.end(), "error") == 10);
+
+    // the pool doesn't take messages anymore
+    logger->info("after shutdown");
+    REQUIRE(tp->shutdown(std::chrono::milliseconds(0)) == abandoned + 1);
+}
+
 TEST_CASE("discard policy using factory ", "[async]") {
     size_t queue_size = 4;
     size_t messages = 1024;
@@ -198,3 +344,818 @@ TEST_CASE("bad_tp", "[async]") {
     logger->info("Please throw an exception");
     REQUIRE(test_sink->msg_counter() == 0);
 }
+
+TEST_CASE("batches of interleaved loggers", "[async]") {
+    auto sink1 = std::make_shared<spdlog::sinks::test_sink_mt>();
+    auto sink2 = std::make_shared<spdlog::sinks::test_sink_mt>();
+    sink1->set_pattern("%v");
+    sink2->set_pattern("%v");
+    {
+        spdlog::details::thread_pool_options options(128, 1);
+        options.batch_size = 16;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger1 = std::make_shared<spdlog::async_logger>("as1", sink1, tp);
+        auto logger2 = std::make_shared<spdlog::async_logger>("as2", sink2, tp);
+        for (int i = 0; i < 100; i++) {
+            logger1->info("{}", i);
+            logger2->info("{}", i);
+            if (i % 10 == 0) {
+                logger1->info("{}", i);
+            }
+        }
+        logger1->flush();
+    }
+    REQUIRE(sink1->msg_counter() == 110);
+    REQUIRE(sink2->msg_counter() == 100);
+    REQUIRE(sink1->flush_counter() == 1);
+    auto lines = sink2->lines();
+    for (size_t i = 0; i < lines.size(); i++) {
+        REQUIRE(lines[i] == std::to_string(i));
+    }
+}
+
+TEST_CASE("deferred formatting", "[async]") {
+    using spdlog::details::is_deferrable;
+    REQUIRE(is_deferrable<std::string, char[8], const char *, int, double, char, bool>::value);
+    REQUIRE_FALSE(is_deferrable<int, const void *>::value);
+
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%v");
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(128, 1);
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        logger->set_deferred_formatting(true);
+        {
+            std::string s = "string";
+            logger->info("{} {} {} {} {:.2f}", s, spdlog::string_view_t("view"), "literal", 42,
+                         1.5);
+        }
+        const char *null_str = nullptr;
+        logger->info("{} {}", 'c', true);
+        logger->info("{}", static_cast<const void *>(null_str));
+        logger->info("no args");
+    }
+    REQUIRE(test_sink->lines() == std::vector<std::string>{"string view literal 42 1.50",
+                                                           "c true", "0x0", "no args"});
+}
+
+#if !defined(SPDLOG_USE_STD_FORMAT)  // std format doesn't fully support runtime strings
+TEST_CASE("deferred formatting error", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    std::atomic<int> errors{0};
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(128, 1);
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        logger->set_deferred_formatting(true);
+        logger->set_error_handler([&](const std::string &) { errors++; });
+        logger->info(SPDLOG_FMT_RUNTIME("Bad format msg {} {}"), 1);
+        logger->info("Good message {}", 2);
+    }
+    REQUIRE(errors == 1);
+    REQUIRE(test_sink->msg_counter() == 1);
+}
+#endif
+
+TEST_CASE("large messages", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%v");
+    std::string large(5000, 'x');
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(16, 1);
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        for (int i = 0; i < 100; i++) {
+            logger->info("{} {}", i, large);
+        }
+    }
+    auto lines = test_sink->lines();
+    REQUIRE(lines.size() == 100);
+    REQUIRE(lines[99] == "99 " + large);
+}
+
+#ifndef SPDLOG_USE_STD_FORMAT
+TEST_CASE("large messages buffer reuse", "[async]") {
+    auto &pool = spdlog::details::msg_pool::instance();
+    std::string payload(1000, 'x');
+    spdlog::details::log_msg msg("test", spdlog::level::info, payload);
+    { spdlog::details::log_msg_buffer warmup(msg); }
+    auto free_blocks = pool.free_blocks();
+    REQUIRE(free_blocks > 0);
+    {
+        spdlog::details::log_msg_buffer buffer(msg);
+        REQUIRE(pool.free_blocks() == free_blocks - 1);
+        REQUIRE(buffer.payload == msg.payload);
+    }
+    REQUIRE(pool.free_blocks() == free_blocks);
+}
+#endif
+
+TEST_CASE("spinning workers", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t messages = 1024;
+    {
+        spdlog::details::thread_pool_options options(128, 2);
+        options.spin_count = 1000;
+        options.yield_count = 100;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        for (size_t i = 0; i < messages; i++) {
+            logger->info("Hello message #{}", i);
+            if (i % 100 == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        logger->flush();
+    }
+    REQUIRE(test_sink->msg_counter() == messages);
+    REQUIRE(test_sink->flush_counter() == 1);
+}
+
+TEST_CASE("priority lanes", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%v");
+    test_sink->set_delay(std::chrono::milliseconds(1));
+    {
+        spdlog::details::thread_pool_options options(4, 1);
+        options.queue_type = spdlog::async_queue_type::priority_lanes;
+        options.lanes = {{spdlog::level::trace, 4}, {spdlog::level::err, 4}};
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>(
+            "as", test_sink, tp, spdlog::async_overflow_policy::overrun_oldest);
+        logger->set_level(spdlog::level::trace);
+        for (int i = 0; i < 200; i++) {
+            logger->debug("debug");
+            if (i == 100) {
+                logger->error("error");
+            }
+        }
+        logger->flush();
+        REQUIRE(tp->overrun_counter() > 0);
+    }
+    auto lines = test_sink->lines();
+    REQUIRE(lines.size() < 202);
+    REQUIRE(std::count(lines.begin(), lines.end(), "error") == 1);
+    REQUIRE(test_sink->flush_counter() == 1);
+}
+
+TEST_CASE("sharded pool", "[async]") {
+    size_t n_loggers = 4;
+    size_t messages = 500;
+    std::vector<std::shared_ptr<spdlog::sinks::test_sink_mt>> sinks;
+    {
+        spdlog::details::thread_pool_options options(16, 3);
+        options.sharded = true;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        std::vector<std::shared_ptr<spdlog::async_logger>> loggers;
+        for (size_t i = 0; i < n_loggers; i++) {
+            sinks.push_back(std::make_shared<spdlog::sinks::test_sink_mt>());
+            sinks.back()->set_pattern("%v");
+            loggers.push_back(
+                std::make_shared<spdlog::async_logger>("as" + std::to_string(i), sinks.back(), tp));
+        }
+        for (size_t i = 0; i < messages; i++) {
+            for (auto &logger : loggers) {
+                logger->info("{}", i);
+            }
+        }
+        for (auto &logger : loggers) {
+            logger->flush();
+        }
+    }
+    for (auto &sink : sinks) {
+        REQUIRE(sink->msg_counter() == messages);
+        auto lines = sink->lines();
+        for (size_t i = 0; i < lines.size(); i++) {
+            REQUIRE(lines[i] == std::to_string(i));
+        }
+        REQUIRE(sink->flush_counter() == 1);
+    }
+}
+
+TEST_CASE("numa aware pool", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t messages = 1024;
+    {
+        spdlog::details::thread_pool_options options(16, 1);
+        options.numa_aware = true;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        // one worker per node, or the single worker asked for on single node machines
+        auto nodes = spdlog::details::os::numa_node_cpus().size();
+        REQUIRE(tp->holds_loggers() == (nodes > 1));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        for (size_t i = 0; i < messages; i++) {
+            logger->info("Hello message #{}", i);
+        }
+        logger->flush();
+    }
+    REQUIRE(test_sink->msg_counter() == messages);
+    REQUIRE(test_sink->flush_counter() == 1);
+}
+
+#ifdef __linux__
+    #include <pthread.h>
+
+TEST_CASE("worker options", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    auto cpus = spdlog::details::os::thread_affinity();
+    REQUIRE_FALSE(cpus.empty());
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::vector<std::vector<int>> affinities;
+    {
+        spdlog::details::thread_pool_options options(16, 2);
+        options.worker.cpus = {cpus.front()};
+        options.worker.sched_policy = spdlog::details::os::sched_policy::batch;
+        options.worker.nice = 1;
+        options.worker.name = "spdlog-w";
+        options.on_thread_start = [&] {
+            char name[16];
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            std::lock_guard<std::mutex> lock(mutex);
+            names.emplace_back(name);
+            affinities.push_back(spdlog::details::os::thread_affinity());
+        };
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        logger->info("Hello message");
+    }
+    REQUIRE(test_sink->msg_counter() == 1);
+    std::sort(names.begin(), names.end());
+    REQUIRE(names == std::vector<std::string>{"spdlog-w0", "spdlog-w1"});
+    for (auto &affinity : affinities) {
+        REQUIRE(affinity == std::vector<int>{cpus.front()});
+    }
+}
+#endif
+
+#ifndef SPDLOG_NO_EXCEPTIONS
+TEST_CASE("worker options failure", "[async]") {
+    spdlog::details::thread_pool_options options(16, 2);
+    options.worker.cpus = {-1};
+    REQUIRE_THROWS_AS(spdlog::details::thread_pool(std::move(options)), spdlog::spdlog_ex);
+}
+#endif
+
+TEST_CASE("huge pages queue", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t messages = 1024;
+    for (auto queue_type :
+         {spdlog::async_queue_type::blocking, spdlog::async_queue_type::lock_free}) {
+        {
+            spdlog::details::thread_pool_options options(65536, 1);
+            options.queue_type = queue_type;
+            options.huge_pages = true;
+            auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+            auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+            for (size_t i = 0; i < messages; i++) {
+                logger->info("Hello message #{}", i);
+            }
+            logger->flush();
+        }
+    }
+    REQUIRE(test_sink->msg_counter() == 2 * messages);
+}
+
+TEST_CASE("queue high water mark", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_delay(std::chrono::milliseconds(1));
+    auto tp = std::make_shared<spdlog::details::thread_pool>(16, 1);
+    {
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        for (size_t i = 0; i < 40; i++) {
+            logger->info("Hello message");
+        }
+        REQUIRE(tp->queue_high_water_mark() > 1);
+        REQUIRE(tp->queue_high_water_mark() <= 16);
+    }
+    REQUIRE(tp->queue_size() == 0);
+    tp->reset_queue_high_water_mark();
+    REQUIRE(tp->queue_high_water_mark() == 0);
+}
+
+TEST_CASE("elastic pool", "[async]") {
+    const size_t loggers_n = 4;
+    const size_t messages = 100;
+    std::vector<std::shared_ptr<spdlog::sinks::test_sink_mt>> sinks;
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < messages; i++) {
+        expected.push_back(std::to_string(i));
+    }
+    spdlog::details::thread_pool_options options(64, 1);
+    options.max_threads_n = 4;
+    options.grow_threshold = 8;
+    options.idle_timeout = std::chrono::milliseconds(50);
+    auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+    REQUIRE_FALSE(tp->holds_loggers());
+    REQUIRE(tp->workers_count() == 1);
+    {
+        std::vector<std::thread> producers;
+        for (size_t i = 0; i < loggers_n; i++) {
+            sinks.push_back(std::make_shared<spdlog::sinks::test_sink_mt>());
+            sinks.back()->set_pattern("%v");
+            sinks.back()->set_delay(std::chrono::milliseconds(1));
+            auto logger = std::make_shared<spdlog::async_logger>("as", sinks.back(), tp);
+            producers.emplace_back([logger, messages] {
+                for (size_t j = 0; j < messages; j++) {
+                    logger->info("{}", j);
+                    if (j % 10 == 9) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    }
+                }
+            });
+        }
+        size_t max_workers = 0;
+        while (sinks.front()->msg_counter() < messages / 2) {
+            max_workers = (std::max)(max_workers, tp->workers_count());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for (auto &t : producers) {
+            t.join();
+        }
+        REQUIRE(max_workers > 1);
+    }
+    // the loggers were drained when destroyed
+    for (auto &sink : sinks) {
+        REQUIRE(sink->lines() == expected);
+    }
+
+    // the added workers stop once idle
+    auto start = std::chrono::steady_clock::now();
+    while (tp->workers_count() > 1 &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(tp->workers_count() == 1);
+}
+
+#ifdef SPDLOG_HAS_COROUTINES
+namespace {
+struct detached_task {
+    struct promise_type {
+        detached_task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+detached_task log_messages(std::shared_ptr<spdlog::async_logger> logger,
+                           size_t messages,
+                           std::function<void(std::coroutine_handle<>)> schedule,
+                           std::atomic<bool> &done) {
+    for (size_t i = 0; i < messages; i++) {
+        co_await logger->async_info("{}", i).resume_via(schedule);
+    }
+    done = true;
+}
+}  // namespace
+
+TEST_CASE("awaitable logging", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%v");
+    test_sink->set_delay(std::chrono::milliseconds(1));
+    size_t messages = 100;
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < messages; i++) {
+        expected.push_back(std::to_string(i));
+    }
+    // the coroutines waiting for room are handed to the test thread
+    std::mutex mutex;
+    std::vector<std::coroutine_handle<>> ready;
+    auto schedule = [&](std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(handle);
+    };
+    size_t resumed = 0;
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(4, 1);
+        auto logger = std::make_shared<spdlog::async_logger>(
+            "as", test_sink, tp, spdlog::async_overflow_policy::discard_new);
+        std::atomic<bool> done{false};
+        log_messages(logger, messages, schedule, done);
+        while (!done) {
+            std::vector<std::coroutine_handle<>> handles;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                handles.swap(ready);
+            }
+            for (auto handle : handles) {
+                resumed++;
+                handle.resume();
+            }
+            std::this_thread::yield();
+        }
+        REQUIRE(tp->discard_counter() == 0);
+    }
+    REQUIRE(resumed > 0);
+    REQUIRE(test_sink->lines() == expected);
+}
+#endif
+
+TEST_CASE("logger destroyed with queued messages", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_delay(std::chrono::milliseconds(1));
+    auto tp = std::make_shared<spdlog::details::thread_pool>(16, 1);
+    REQUIRE_FALSE(tp->holds_loggers());
+    {
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        for (int i = 0; i < 32; i++) {
+            logger->info("Hello message #{}", i);
+        }
+    }
+    // the logger destructor waited for its messages
+    REQUIRE(test_sink->msg_counter() == 32);
+}
+
+TEST_CASE("logger destroyed while others overrun the queue", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    auto tp = std::make_shared<spdlog::details::thread_pool>(8, 1);
+    auto noisy = std::make_shared<spdlog::async_logger>(
+        "noisy", test_sink, tp, spdlog::async_overflow_policy::overrun_oldest);
+    std::atomic<bool> done{false};
+    std::thread flood([&] {
+        while (!done) {
+            noisy->info("flood");
+        }
+    });
+    for (int i = 0; i < 10; i++) {
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        logger->info("message");
+    }
+    done = true;
+    flood.join();
+}
+
+TEST_CASE("coalesced flushes", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t coalesced = 0;
+    {
+        spdlog::details::thread_pool_options options(128, 1);
+        options.flush_coalesce_window = std::chrono::milliseconds(200);
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        for (int i = 0; i < 10; i++) {
+            logger->info("Hello message #{}", i);
+            logger->flush();
+        }
+        // first flush is immediate, the others are merged into one at the end of the window
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        REQUIRE(test_sink->flush_counter() == 2);
+        coalesced = tp->coalesced_flush_counter();
+    }
+    REQUIRE(coalesced == 8);
+    REQUIRE(test_sink->msg_counter() == 10);
+}
+
+TEST_CASE("coalesced flushes byte budget", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    {
+        spdlog::details::thread_pool_options options(128, 1);
+        options.flush_coalesce_window = std::chrono::milliseconds(10000);
+        options.flush_coalesce_bytes = 100;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        logger->flush();
+        logger->info(std::string(200, 'x'));
+        logger->flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        REQUIRE(test_sink->flush_counter() == 2);
+        REQUIRE(tp->coalesced_flush_counter() == 0);
+        // pending flushes are done when the logger is destroyed
+        logger->flush();
+    }
+    REQUIRE(test_sink->flush_counter() == 3);
+}
+
+TEST_CASE("lock free queue", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t messages = 1024;
+    size_t n_threads = 4;
+    {
+        spdlog::details::thread_pool_options options(128, 2);
+        options.queue_type = spdlog::async_queue_type::lock_free;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp,
+                                                             spdlog::async_overflow_policy::block);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < n_threads; i++) {
+            threads.emplace_back([logger, messages] {
+                for (size_t j = 0; j < messages; j++) {
+                    logger->info("Hello message #{}", j);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        logger->flush();
+        REQUIRE(tp->overrun_counter() == 0);
+    }
+    REQUIRE(test_sink->msg_counter() == messages * n_threads);
+    REQUIRE(test_sink->flush_counter() == 1);
+}
+
+TEST_CASE("lock free queue discard policy", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_delay(std::chrono::milliseconds(1));
+    size_t messages = 1024;
+
+    spdlog::details::thread_pool_options options(4, 1);
+    options.queue_type = spdlog::async_queue_type::lock_free;
+    auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+    auto logger = std::make_shared<spdlog::async_logger>(
+        "as", test_sink, tp, spdlog::async_overflow_policy::overrun_oldest);
+    for (size_t i = 0; i < messages; i++) {
+        logger->info("Hello message");
+    }
+    REQUIRE(test_sink->msg_counter() < messages);
+    REQUIRE(tp->overrun_counter() > 0);
+}
+
+#ifndef SPDLOG_NO_TLS
+TEST_CASE("per thread queues", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t messages = 1024;
+    size_t n_threads = 4;
+    {
+        spdlog::details::thread_pool_options options(64, 1);
+        options.queue_type = spdlog::async_queue_type::per_thread;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp,
+                                                             spdlog::async_overflow_policy::block);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < n_threads; i++) {
+            threads.emplace_back([logger, messages] {
+                for (size_t j = 0; j < messages; j++) {
+                    logger->info("Hello message #{}", j);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        logger->flush();
+    }
+    REQUIRE(test_sink->msg_counter() == messages * n_threads);
+    REQUIRE(test_sink->flush_counter() == 1);
+}
+
+TEST_CASE("per thread queues timestamp order", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%v");
+    test_sink->set_delay(std::chrono::milliseconds(100));
+    {
+        spdlog::details::thread_pool_options options(16, 1);
+        options.queue_type = spdlog::async_queue_type::per_thread;
+        options.batch_size = 1;  // don't let the worker grab "2" and "4" along with "first"
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+
+        // keep the worker busy with the first message while both threads fill their rings
+        auto now = spdlog::log_clock::now();
+        logger->info("first");
+        std::thread other([&] {
+            logger->log(now + std::chrono::seconds(1), {}, spdlog::level::info, "1");
+            logger->log(now + std::chrono::seconds(3), {}, spdlog::level::info, "3");
+        });
+        logger->log(now + std::chrono::seconds(2), {}, spdlog::level::info, "2");
+        logger->log(now + std::chrono::seconds(4), {}, spdlog::level::info, "4");
+        other.join();
+    }
+    REQUIRE(test_sink->lines() == std::vector<std::string>{"first", "1", "2", "3", "4"});
+}
+
+TEST_CASE("per thread queues round robin", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    size_t messages = 256;
+    {
+        spdlog::details::thread_pool_options options(8, 2);
+        options.queue_type = spdlog::async_queue_type::per_thread;
+        options.round_robin = true;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>(
+            "as", test_sink, tp, spdlog::async_overflow_policy::block);
+        std::thread other([logger, messages] {
+            for (size_t j = 0; j < messages; j++) {
+                logger->info("Hello message #{}", j);
+            }
+        });
+        for (size_t j = 0; j < messages; j++) {
+            logger->info("Hello message #{}", j);
+        }
+        other.join();
+    }
+    REQUIRE(test_sink->msg_counter() == messages * 2);
+}
+#endif
+
+TEST_CASE("exclusive sink", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    size_t messages = 256;
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(128, 1);
+        REQUIRE(tp->claim_exclusive(*test_sink));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp,
+                                                             spdlog::async_overflow_policy::block);
+        for (size_t i = 0; i < messages; i++) {
+            logger->info("Hello message #{}", i);
+        }
+        logger->flush();
+#ifndef NDEBUG
+        spdlog::details::log_msg msg("as", spdlog::level::info, "not the owner");
+        REQUIRE_THROWS_AS(test_sink->log(msg), spdlog::spdlog_ex);
+#endif
+    }
+    test_sink->release_exclusive();
+    REQUIRE(test_sink->msg_counter() == messages);
+    REQUIRE(test_sink->flush_counter() == 1);
+
+    // usable from any thread once released
+    spdlog::logger sync_logger("sync", test_sink);
+    sync_logger.info("synchronous");
+    REQUIRE(test_sink->msg_counter() == messages + 1);
+
+    auto multi = std::make_shared<spdlog::details::thread_pool>(128, 2);
+    REQUIRE_FALSE(multi->claim_exclusive(*test_sink));
+}
+
+TEST_CASE("static messages are not copied", "[async]") {
+    static const char text[] = "connection closed";
+    std::atomic<int> same_storage{0};
+    auto sink = std::make_shared<spdlog::sinks::callback_sink_mt>(
+        [&](const spdlog::details::log_msg &msg) {
+            if (msg.payload.data() == text && msg.payload.size() == sizeof(text) - 1) {
+                same_storage++;
+            }
+        });
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(16, 1);
+        auto logger = std::make_shared<spdlog::async_logger>("as", sink, tp);
+        logger->info(spdlog::static_msg(text));
+        logger->info("connection closed");  // copied
+        logger->flush();
+    }
+    REQUIRE(same_storage == 1);
+}
+
+TEST_CASE("queued messages reference the logger name", "[async]") {
+    const std::string name(100, 'n');
+    const char *name_data = nullptr;
+    std::atomic<int> referenced{0};
+    auto sink = std::make_shared<spdlog::sinks::callback_sink_mt>(
+        [&](const spdlog::details::log_msg &msg) {
+            if (msg.logger_name.data() == name_data && msg.logger_name == name) {
+                referenced++;
+            }
+        });
+    auto ring = std::make_shared<spdlog::sinks::ringbuffer_sink_mt>(4);
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(16, 1);
+        auto logger = std::make_shared<spdlog::async_logger>(
+            name, spdlog::sinks_init_list{sink, ring}, tp);
+        name_data = logger->name().data();
+        logger->info("message {}", 1);
+        logger->info("message {}", std::string(500, 'x'));
+        logger->flush();
+    }
+    REQUIRE(referenced == 2);
+    // copies kept by the sinks have their own name
+    auto kept = ring->last_raw();
+    REQUIRE(kept.size() == 2);
+    REQUIRE(kept[0].logger_name == name);
+    REQUIRE(kept[0].payload == "message 1");
+}
+
+TEST_CASE("async tee logger", "[async]") {
+    std::atomic<bool> released{false};
+    std::atomic<const char *> slow_payload{nullptr};
+    auto slow_sink = std::make_shared<spdlog::sinks::callback_sink_mt>(
+        [&](const spdlog::details::log_msg &msg) {
+            const char *none = nullptr;
+            slow_payload.compare_exchange_strong(none, msg.payload.data());
+            while (!released) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    std::atomic<const char *> fast_payload{nullptr};
+    auto fast_sink = std::make_shared<spdlog::sinks::callback_sink_mt>(
+        [&](const spdlog::details::log_msg &msg) {
+            const char *none = nullptr;
+            fast_payload.compare_exchange_strong(none, msg.payload.data());
+        });
+    auto counting_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    auto slow_counting_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    {
+        auto fast_tp = std::make_shared<spdlog::details::thread_pool>(64, 1);
+        auto slow_tp = std::make_shared<spdlog::details::thread_pool>(64, 1);
+        auto logger = std::make_shared<spdlog::async_tee_logger>(
+            "tee", std::vector<spdlog::async_branch>{{{fast_sink, counting_sink}, fast_tp},
+                                                     {{slow_sink, slow_counting_sink}, slow_tp}});
+        logger->set_pattern("%n %v");
+        REQUIRE(logger->sinks().size() == 4);
+        for (int i = 0; i < 10; i++) {
+            logger->info("message {}", i);
+        }
+        // the blocked pool doesn't hold back the other one
+        for (int i = 0; i < 5000 && counting_sink->msg_counter() < 10; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(counting_sink->msg_counter() == 10);
+        REQUIRE(slow_counting_sink->msg_counter() == 0);
+        // one copy of the payload for both pools
+        REQUIRE(fast_payload.load() != nullptr);
+        REQUIRE(fast_payload.load() == slow_payload.load());
+        released = true;
+    }
+    REQUIRE(slow_counting_sink->msg_counter() == 10);
+    REQUIRE(slow_counting_sink->lines()[9] == "tee message 9");
+
+    auto cloned_tp = std::make_shared<spdlog::details::thread_pool>(64, 1);
+    spdlog::async_tee_logger logger("tee", {{{counting_sink}, cloned_tp}});
+    auto cloned = std::static_pointer_cast<spdlog::async_tee_logger>(logger.clone("cloned"));
+    REQUIRE(cloned->branches().size() == 1);
+    REQUIRE(cloned->branches()[0] != logger.branches()[0]);
+    REQUIRE(cloned->branches()[0]->name() == "cloned");
+    cloned->info("cloned");
+    cloned->flush();
+    cloned.reset();
+    REQUIRE(counting_sink->lines().back() == "cloned cloned");
+}
+
+#ifdef __linux__
+    #include <poll.h>
+
+static bool fd_readable(int fd) {
+    pollfd pfd{fd, POLLIN, 0};
+    return ::poll(&pfd, 1, 0) == 1;
+}
+#endif
+
+TEST_CASE("polled thread pool", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    spdlog::details::thread_pool_options options;
+    options.queue_size = 8;
+    options.polled = true;
+    auto tp = std::make_shared<spdlog::details::thread_pool>(options);
+    REQUIRE(tp->workers_count() == 0);
+    {
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp,
+                                                             spdlog::async_overflow_policy::block);
+#ifdef __linux__
+        REQUIRE(tp->poll_fd() >= 0);
+        REQUIRE_FALSE(fd_readable(tp->poll_fd()));
+#endif
+        // the queue is full after 8 messages: the others are discarded, not waited for
+        for (int i = 0; i < 10; i++) {
+            logger->info("message {}", i);
+        }
+        REQUIRE(test_sink->msg_counter() == 0);
+        REQUIRE(tp->discard_counter() == 2);
+#ifdef __linux__
+        REQUIRE(fd_readable(tp->poll_fd()));
+#endif
+        REQUIRE(tp->poll(5) == 5);
+        REQUIRE(test_sink->msg_counter() == 5);
+#ifdef __linux__
+        REQUIRE(fd_readable(tp->poll_fd()));
+#endif
+        REQUIRE(tp->poll() == 3);
+        REQUIRE(tp->poll() == 0);
+#ifdef __linux__
+        REQUIRE_FALSE(fd_readable(tp->poll_fd()));
+#endif
+        logger->info("message 10");
+        logger->flush();
+        REQUIRE(test_sink->flush_counter() == 0);
+    }
+    // processed when the logger was destroyed
+    REQUIRE(test_sink->msg_counter() == 9);
+    REQUIRE(test_sink->flush_counter() == 1);
+}
+
+TEST_CASE("sync level", "[async]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%v");
+    {
+        // polled: the queued messages wait for poll()
+        spdlog::details::thread_pool_options options(16, 1);
+        options.polled = true;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", test_sink, tp);
+        REQUIRE(logger->sync_level() == spdlog::level::off);
+        logger->set_sync_level(spdlog::level::err);
+        logger->info("queued {}", 1);
+        logger->error("error {}", 2);
+        REQUIRE(test_sink->lines() == std::vector<std::string>{"error 2"});
+        REQUIRE(test_sink->flush_counter() == 1);
+
+        logger->set_deferred_formatting(true);
+        logger->critical("critical {}", 3);
+        logger->warn("queued {}", 4);
+        REQUIRE(test_sink->lines() == std::vector<std::string>{"error 2", "critical 3"});
+        REQUIRE(test_sink->flush_counter() == 2);
+        REQUIRE(tp->poll() == 2);
+    }
+    REQUIRE(test_sink->lines() ==
+            std::vector<std::string>{"error 2", "critical 3", "queued 1", "queued 4"});
+}
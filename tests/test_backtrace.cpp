@@ -71,3 +71,122 @@ TEST_CASE("bactrace-async", "[bactrace]") {
     REQUIRE(test_sink->lines()[6] == "debug message 99");
     REQUIRE(test_sink->lines()[7] == "****************** Backtrace End ********************");
 }
+
+TEST_CASE("bactrace-multithreaded", "[bactrace]") {
+    using spdlog::sinks::test_sink_mt;
+    auto test_sink = std::make_shared<test_sink_mt>();
+    size_t backtrace_size = 64;
+
+    spdlog::logger logger("test-backtrace", test_sink);
+    logger.set_pattern("%v");
+    logger.enable_backtrace(backtrace_size);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < 10000; i++) {
+                logger.debug("{} {}", t, i);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    logger.dump_backtrace();
+    auto lines = test_sink->lines();
+    REQUIRE(lines.size() == backtrace_size + 2);
+    // in order for each thread
+    std::vector<int> last(4, -1);
+    for (size_t i = 1; i <= backtrace_size; i++) {
+        int t = 0, n = 0;
+        REQUIRE(std::sscanf(lines[i].c_str(), "%d %d", &t, &n) == 2);
+        REQUIRE(n > last[t]);
+        last[t] = n;
+    }
+    REQUIRE(*std::max_element(last.begin(), last.end()) == 9999);
+
+    // popped by the dump
+    logger.dump_backtrace();
+    REQUIRE(test_sink->lines().size() == backtrace_size + 2);
+}
+
+TEST_CASE("bactrace-clone", "[bactrace]") {
+    using spdlog::sinks::test_sink_st;
+    auto test_sink = std::make_shared<test_sink_st>();
+    spdlog::logger logger("test-backtrace", test_sink);
+    logger.set_pattern("%v");
+    logger.enable_backtrace(2);
+    logger.debug("one");
+    logger.debug("two");
+    logger.debug("three");
+    auto cloned = logger.clone("cloned");
+    cloned->debug("four");
+    cloned->dump_backtrace();
+    REQUIRE(test_sink->lines().size() == 4);
+    REQUIRE(test_sink->lines()[1] == "three");
+    REQUIRE(test_sink->lines()[2] == "four");
+    // the original keeps its own messages
+    logger.dump_backtrace();
+    REQUIRE(test_sink->lines().size() == 8);
+    REQUIRE(test_sink->lines()[5] == "two");
+    REQUIRE(test_sink->lines()[6] == "three");
+}
+
+TEST_CASE("bactrace-lazy", "[bactrace]") {
+    using spdlog::sinks::test_sink_st;
+    auto test_sink = std::make_shared<test_sink_st>();
+    // copies of a logger never enabled have no backtracer state, until enabled
+    spdlog::logger logger("test-backtrace", test_sink);
+    logger.set_pattern("%v");
+    spdlog::logger copy(logger);
+    logger = copy;
+    logger.debug("one");
+    logger.dump_backtrace();
+    REQUIRE(test_sink->lines().empty());
+    logger.enable_backtrace(2);
+    logger.debug("two");
+    copy.enable_backtrace(2);
+    copy.debug("three");
+    logger.dump_backtrace();
+    copy.dump_backtrace();
+    REQUIRE(test_sink->lines().size() == 6);
+    REQUIRE(test_sink->lines()[1] == "two");
+    REQUIRE(test_sink->lines()[4] == "three");
+    // assigning a logger without backtrace drops it
+    logger.debug("four");
+    logger = spdlog::logger("other", test_sink);
+    REQUIRE_FALSE(logger.should_backtrace());
+    logger.dump_backtrace();
+    REQUIRE(test_sink->lines().size() == 6);
+}
+
+TEST_CASE("bactrace-deferred", "[bactrace]") {
+    using spdlog::sinks::test_sink_st;
+    auto test_sink = std::make_shared<test_sink_st>();
+    spdlog::logger logger("test-backtrace", test_sink);
+    logger.set_pattern("%l %v");
+    logger.enable_backtrace(3);
+    {
+        // the arguments below the level are kept packed, strings copied
+        std::string temporary("temporary string");
+        logger.debug("{} {:.2f} {}", temporary, 1.5, 42);
+    }
+    logger.debug("no arguments");
+    logger.debug(std::string("runtime message"));
+    logger.info("logged {}", 1);  // formatted right away, for the sinks
+    REQUIRE(test_sink->lines().size() == 1);
+
+    logger.dump_backtrace();
+    auto lines = test_sink->lines();
+    REQUIRE(lines.size() == 6);
+    REQUIRE(lines[2] == "debug no arguments");
+    REQUIRE(lines[3] == "debug runtime message");
+    REQUIRE(lines[4] == "info logged 1");
+
+    logger.enable_backtrace(3);
+    {
+        std::string temporary("temporary string");
+        logger.debug("{} {:.2f} {}", temporary, 1.5, 42);
+    }
+    logger.dump_backtrace();
+    REQUIRE(test_sink->lines()[7] == "debug temporary string 1.50 42");
+}
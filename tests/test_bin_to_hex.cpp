@@ -95,3 +95,23 @@ TEST_CASE("to_hex_no_ascii", "[to_hex]") {
     REQUIRE(
         ends_with(oss.str(), "090A0B410C4BFFFF" + std::string(spdlog::details::os::default_eol)));
 }
+
+TEST_CASE("to_hex_long_range", "[to_hex]") {
+    std::vector<unsigned char> v(70000);
+    for (size_t i = 0; i < v.size(); i++) {
+        v[i] = static_cast<unsigned char>(i);
+    }
+
+    // a single line much longer than the rendering buffer
+    auto single_line = fmt::format("{:n}", spdlog::to_hex(v));
+    REQUIRE(single_line.size() == v.size() * 3 - 1);
+    REQUIRE(single_line.substr(0, 12) == "00 01 02 03 ");
+    REQUIRE(single_line.substr(single_line.size() - 5) == "6e 6f");
+
+    // positions past 0xFFFF get more than 4 digits
+    auto lines = fmt::format("{:Xs}", spdlog::to_hex(v, 0x8000));
+    auto eol = std::string(spdlog::details::os::default_eol);
+    REQUIRE(lines.find(eol + "8000: 0001") != std::string::npos);
+    REQUIRE(lines.find(eol + "10000: 0001") != std::string::npos);
+    REQUIRE(ends_with(lines, "6D6E6F"));
+}
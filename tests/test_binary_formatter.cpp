@@ -0,0 +1,178 @@
+#include "includes.h"
+
+using spdlog::memory_buf_t;
+
+static std::vector<std::string> decode_binary(const std::string &data, const std::string &pattern) {
+    spdlog::pattern_formatter formatter(pattern, spdlog::pattern_time_type::utc, "\n");
+    spdlog::binary_log_reader reader(spdlog::string_view_t(data.data(), data.size()));
+    spdlog::details::log_msg msg;
+    std::vector<std::string> lines;
+    while (reader.next(msg)) {
+        memory_buf_t formatted;
+        formatter.format(msg, formatted);
+        lines.emplace_back(formatted.data(), formatted.size());
+    }
+    return lines;
+}
+
+TEST_CASE("binary formatter round trip", "[binary_formatter]") {
+    const std::string pattern = "[%Y-%m-%d %H:%M:%S.%F] [%n] [%l] [%t] [%s:%# %!] %v";
+    spdlog::binary_formatter formatter;
+    spdlog::pattern_formatter text_formatter(pattern, spdlog::pattern_time_type::utc, "\n");
+
+    auto base_time = spdlog::log_clock::time_point(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(
+            std::chrono::milliseconds(1700000000123)));
+    spdlog::source_loc loc{"some/dir/file.cpp", 42, "func"};
+    std::vector<spdlog::details::log_msg> msgs;
+    msgs.emplace_back(base_time, loc, "logger1", spdlog::level::info, "first message");
+    msgs.emplace_back(base_time + std::chrono::microseconds(15), loc, "logger2", spdlog::level::err,
+                      "second message");
+    msgs.emplace_back(base_time - std::chrono::seconds(1), spdlog::source_loc{}, "logger1",
+                      spdlog::level::trace, "");
+    msgs.emplace_back(base_time, loc, "logger2", spdlog::level::critical, "last message");
+    msgs[1].thread_id = 123456789;
+
+    memory_buf_t binary;
+    std::vector<std::string> expected;
+    for (auto &msg : msgs) {
+        formatter.format(msg, binary);
+        memory_buf_t formatted;
+        text_formatter.format(msg, formatted);
+        expected.emplace_back(formatted.data(), formatted.size());
+    }
+    std::string data(binary.data(), binary.size());
+    REQUIRE(decode_binary(data, pattern) == expected);
+
+    // the logger and source definitions are written only once
+    REQUIRE(std::count(data.begin(), data.end(), 'H') == 1);
+    REQUIRE(data.find("logger1") == data.rfind("logger1"));
+    REQUIRE(data.find("file.cpp") == data.rfind("file.cpp"));
+
+    // a partial trailing record is ignored
+    auto truncated = data.substr(0, data.size() - 3);
+    REQUIRE(decode_binary(truncated, pattern) ==
+            std::vector<std::string>(expected.begin(), expected.end() - 1));
+}
+
+TEST_CASE("binary formatter reset", "[binary_formatter]") {
+    spdlog::binary_formatter formatter;
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger", spdlog::level::info, "message");
+    memory_buf_t first, second;
+    formatter.format(msg, first);
+    formatter.reset();
+    formatter.format(msg, second);
+    REQUIRE(std::string(first.data(), first.size()) == std::string(second.data(), second.size()));
+
+    // the streams of several formatters can be concatenated
+    auto cloned = formatter.clone();
+    cloned->format(msg, second);
+    std::string data(second.data(), second.size());
+    data.append(first.data(), first.size());
+    REQUIRE(decode_binary(data, "%n %v").size() == 3);
+}
+
+TEST_CASE("binary log reader stream", "[binary_formatter]") {
+    spdlog::binary_formatter formatter;
+    memory_buf_t binary;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 10; i++) {
+        auto payload = "message " + std::to_string(i);
+        spdlog::details::log_msg msg(spdlog::source_loc{"file.cpp", i + 1, "func"},
+                                     i % 2 == 0 ? "even" : "odd", spdlog::level::info, payload);
+        formatter.format(msg, binary);
+        expected.push_back(std::string(i % 2 == 0 ? "even" : "odd") + " file.cpp:" +
+                           std::to_string(i + 1) + " " + payload + "\n");
+    }
+
+    // received in chunks of 7 bytes, the ids and records being split across them
+    spdlog::pattern_formatter text_formatter("%n %s:%# %v", spdlog::pattern_time_type::utc, "\n");
+    spdlog::binary_log_reader reader(spdlog::string_view_t{});
+    spdlog::details::log_msg msg;
+    std::string buffer;
+    std::vector<std::string> lines;
+    for (size_t pos = 0; pos < binary.size(); pos += 7) {
+        buffer.append(binary.data() + pos, std::min<size_t>(7, binary.size() - pos));
+        reader.feed(spdlog::string_view_t(buffer.data(), buffer.size()));
+        while (reader.next(msg)) {
+            memory_buf_t formatted;
+            text_formatter.format(msg, formatted);
+            lines.emplace_back(formatted.data(), formatted.size());
+        }
+        buffer.erase(0, reader.consumed());
+    }
+    REQUIRE(lines == expected);
+    REQUIRE(buffer.empty());
+}
+
+#ifndef SPDLOG_NO_EXCEPTIONS
+TEST_CASE("binary log reader errors", "[binary_formatter]") {
+    std::string not_binary = "[info] some text";
+    spdlog::binary_log_reader reader(spdlog::string_view_t(not_binary.data(), not_binary.size()));
+    spdlog::details::log_msg msg;
+    REQUIRE_THROWS_AS(reader.next(msg), spdlog::spdlog_ex);
+
+    std::string bad_header = "HSPDX\x01";
+    spdlog::binary_log_reader header_reader(
+        spdlog::string_view_t(bad_header.data(), bad_header.size()));
+    REQUIRE_THROWS_AS(header_reader.next(msg), spdlog::spdlog_ex);
+}
+#endif
+
+TEST_CASE("binary formatter sink", "[binary_formatter]") {
+    std::ostringstream oss;
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(oss);
+    sink->set_formatter(spdlog::details::make_unique<spdlog::binary_formatter>());
+    spdlog::logger logger("binary", sink);
+    logger.info("Hello {} {}", "binary", 42);
+    logger.warn("second");
+    REQUIRE(decode_binary(oss.str(), "[%n] [%l] %v") ==
+            std::vector<std::string>{"[binary] [info] Hello binary 42\n",
+                                     "[binary] [warning] second\n"});
+}
+
+#ifndef SPDLOG_USE_STD_FORMAT
+TEST_CASE("binary formatter message catalog", "[binary_formatter]") {
+    std::ostringstream catalog_oss, text_oss;
+    auto catalog_sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(catalog_oss);
+    catalog_sink->set_formatter(spdlog::details::make_unique<spdlog::binary_formatter>(true));
+    auto text_sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(text_oss);
+    text_sink->set_formatter(spdlog::details::make_unique<spdlog::binary_formatter>());
+    spdlog::logger logger("catalog", {catalog_sink, text_sink});
+
+    std::vector<std::string> expected;
+    for (int i = 0; i < 20; i++) {
+        logger.info("request {} for {} took {:.1f}ms: {}", i, std::string("/index"), i * 1.5,
+                    i % 2 == 0);
+        expected.push_back(fmt::format("[info] request {} for /index took {:.1f}ms: {}\n", i,
+                                       i * 1.5, i % 2 == 0));
+    }
+    logger.warn("no arguments");
+    expected.emplace_back("[warning] no arguments\n");
+    logger.warn("char {}", 'x');  // not kept: written as text
+    expected.emplace_back("[warning] char x\n");
+
+    auto catalog = catalog_oss.str();
+    REQUIRE(decode_binary(catalog, "[%l] %v") == expected);
+    REQUIRE(decode_binary(text_oss.str(), "[%l] %v") == expected);
+    REQUIRE(catalog.find("request {}") == catalog.rfind("request {}"));
+    REQUIRE(catalog.find("/index") != catalog.rfind("/index"));  // the arguments are kept
+    REQUIRE(catalog.size() < text_oss.str().size());
+
+    // the arguments are copied with the message (e.g. by the async loggers)
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "catalog", spdlog::level::info, "7 ok");
+    std::string status = "ok";
+    spdlog::kv_field args[] = {spdlog::details::message_arg(7),
+                               spdlog::details::message_arg(status)};
+    msg.format = "{} {}";
+    msg.args = args;
+    msg.arg_count = 2;
+    spdlog::details::log_msg_buffer copy(msg);
+    status = "changed";
+    spdlog::binary_formatter formatter(true);
+    memory_buf_t binary;
+    formatter.format(copy, binary);
+    REQUIRE(decode_binary(std::string(binary.data(), binary.size()), "%v") ==
+            std::vector<std::string>{"7 ok\n"});
+}
+#endif
@@ -0,0 +1,358 @@
+#include "includes.h"
+#include "spdlog/sinks/buffered_tcp_sink.h"
+#include "spdlog/sinks/tcp_sink.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+#ifdef SPDLOG_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef SPDLOG_OPENSSL
+    #include <openssl/pem.h>
+    #include <openssl/x509v3.h>
+#endif
+
+namespace {
+// accepts one connection and reads it until closed
+class test_server {
+public:
+    test_server() {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ::bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+    }
+
+    ~test_server() { ::close(fd_); }
+
+    int port() const { return port_; }
+
+    void start_listening() { ::listen(fd_, 1); }
+
+    int accept() { return ::accept(fd_, nullptr, nullptr); }
+
+    void start() {
+        start_listening();
+        thread_ = std::thread([this] {
+            int client = accept();
+            char buf[4096];
+            ssize_t n;
+            while ((n = ::read(client, buf, sizeof(buf))) > 0) {
+                received_.append(buf, static_cast<size_t>(n));
+            }
+            ::close(client);
+        });
+    }
+
+    std::string join() {
+        thread_.join();
+        return received_;
+    }
+
+private:
+    int fd_;
+    int port_;
+    std::thread thread_;
+    std::string received_;
+};
+
+size_t count_occurrences(const std::string &text, const std::string &what) {
+    size_t count = 0;
+    for (auto pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+#ifdef SPDLOG_OPENSSL
+// accepts TLS connections with a self-signed certificate for 127.0.0.1 (written to cert_file) and
+// reads them until closed
+class tls_test_server {
+public:
+    static constexpr const char *cert_file = "test_logs/tls_cert.pem";
+
+    explicit tls_test_server(int connections)
+        : connections_(connections) {
+        key_ = EVP_EC_gen("P-256");
+        cert_ = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert_), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert_), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert_), 3600);
+        X509_set_pubkey(cert_, key_);
+        auto *name = X509_get_subject_name(cert_);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char *>("127.0.0.1"), -1, -1, 0);
+        X509_set_issuer_name(cert_, name);
+        auto *san = X509V3_EXT_conf_nid(nullptr, nullptr, NID_subject_alt_name,
+                                        const_cast<char *>("IP:127.0.0.1"));
+        X509_add_ext(cert_, san, -1);
+        X509_EXTENSION_free(san);
+        X509_sign(cert_, key_, EVP_sha256());
+
+        prepare_logdir();
+        spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+        auto *file = std::fopen(cert_file, "w");
+        PEM_write_X509(file, cert_);
+        std::fclose(file);
+
+        ctx_ = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_use_certificate(ctx_, cert_);
+        SSL_CTX_use_PrivateKey(ctx_, key_);
+        server_.start_listening();
+    }
+
+    ~tls_test_server() {
+        SSL_CTX_free(ctx_);
+        X509_free(cert_);
+        EVP_PKEY_free(key_);
+    }
+
+    int port() const { return server_.port(); }
+
+    void start() {
+        thread_ = std::thread([this] {
+            for (int i = 0; i < connections_; i++) {
+                int client = server_.accept();
+                SSL *ssl = SSL_new(ctx_);
+                SSL_set_fd(ssl, client);
+                if (SSL_accept(ssl) == 1) {
+                    char buf[4096];
+                    int n;
+                    while ((n = SSL_read(ssl, buf, sizeof(buf))) > 0) {
+                        received_.append(buf, static_cast<size_t>(n));
+                    }
+                }
+                SSL_free(ssl);
+                ::close(client);
+            }
+        });
+    }
+
+    std::string join() {
+        thread_.join();
+        return received_;
+    }
+
+private:
+    test_server server_;
+    int connections_;
+    EVP_PKEY *key_;
+    X509 *cert_;
+    SSL_CTX *ctx_;
+    std::thread thread_;
+    std::string received_;
+};
+#endif
+}  // namespace
+
+TEST_CASE("buffered_tcp_sink", "[buffered_tcp_sink]") {
+    test_server server;
+    server.start();
+    {
+        spdlog::sinks::buffered_tcp_sink_config cfg("127.0.0.1", server.port());
+        auto sink = std::make_shared<spdlog::sinks::buffered_tcp_sink_mt>(cfg);
+        sink->set_pattern("%v");
+        spdlog::logger logger("tcp", sink);
+        for (int i = 0; i < 1000; i++) {
+            logger.info("message {}", i);
+        }
+    }
+    auto received = server.join();
+    REQUIRE(count_occurrences(received, "message ") == 1000);
+    REQUIRE(received.find("message 999") != std::string::npos);
+}
+
+TEST_CASE("buffered_tcp_sink drops when full", "[buffered_tcp_sink]") {
+    test_server server;  // not listening
+    spdlog::sinks::buffered_tcp_sink_config cfg("127.0.0.1", server.port());
+    cfg.max_buffer_size = 100;
+    auto sink = std::make_shared<spdlog::sinks::buffered_tcp_sink_st>(cfg);
+    spdlog::logger logger("tcp", sink);
+    for (int i = 0; i < 100; i++) {
+        logger.info("message {}", i);
+    }
+    REQUIRE(sink->dropped() > 0);
+    REQUIRE_FALSE(sink->connected());
+}
+
+TEST_CASE("buffered_tcp_sink spills to disk", "[buffered_tcp_sink]") {
+    prepare_logdir();
+    test_server server;
+    spdlog::sinks::buffered_tcp_sink_config cfg("127.0.0.1", server.port());
+    cfg.max_buffer_size = 100;
+    cfg.spill_filename = SPDLOG_FILENAME_T("test_logs/tcp_spill.txt");
+    {
+        // the server is down: everything left goes to the spill files
+        auto sink = std::make_shared<spdlog::sinks::buffered_tcp_sink_mt>(cfg);
+        sink->set_pattern("%v");
+        spdlog::logger logger("tcp", sink);
+        for (int i = 0; i < 100; i++) {
+            logger.info("message {:03d}", i);
+        }
+        REQUIRE(sink->dropped() == 0);
+    }
+
+    server.start();
+    {
+        // sent by the next sink, in order
+        auto sink = std::make_shared<spdlog::sinks::buffered_tcp_sink_mt>(cfg);
+        sink->set_pattern("%v");
+        spdlog::logger logger("tcp", sink);
+        logger.info("message 100");
+        for (int i = 0; i < 200 && !sink->connected(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    auto received = server.join();
+    REQUIRE(count_occurrences(received, "message ") == 101);
+    size_t pos = 0;
+    for (int i = 0; i <= 100; i++) {
+        auto next = received.find(spdlog::fmt_lib::format("message {:03d}", i), pos);
+        REQUIRE(next != std::string::npos);
+        pos = next;
+    }
+}
+
+#ifdef SPDLOG_ZLIB
+TEST_CASE("buffered_tcp_sink compression", "[buffered_tcp_sink]") {
+    std::vector<std::string> samples;
+    for (int i = 0; i < 10; i++) {
+        samples.push_back(spdlog::fmt_lib::format("request {} served from cache in {}ms", i, i));
+    }
+    auto dictionary = spdlog::sinks::train_compression_dictionary(samples);
+    REQUIRE(dictionary.find("request") != std::string::npos);
+    REQUIRE(dictionary.find("cache") != std::string::npos);
+    REQUIRE(dictionary.find("7ms") == std::string::npos);  // seen once
+
+    test_server server;
+    server.start();
+    std::string expected;
+    {
+        spdlog::sinks::buffered_tcp_sink_config cfg("127.0.0.1", server.port());
+        cfg.compression_level = 6;
+        cfg.compression_dictionary = dictionary;
+        auto sink = std::make_shared<spdlog::sinks::buffered_tcp_sink_mt>(cfg);
+        sink->set_pattern("%v");
+        spdlog::logger logger("tcp", sink);
+        for (int i = 0; i < 1000; i++) {
+            logger.info("request {} served from cache in {}ms", i, i % 10);
+            expected += spdlog::fmt_lib::format("request {} served from cache in {}ms\n", i,
+                                                i % 10);
+        }
+    }
+    auto received = server.join();
+    REQUIRE(received.size() * 5 < expected.size());
+
+    z_stream stream{};
+    REQUIRE(inflateInit(&stream) == Z_OK);
+    std::string inflated(expected.size() + 1, '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(&received[0]);
+    stream.avail_in = static_cast<uInt>(received.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&inflated[0]);
+    stream.avail_out = static_cast<uInt>(inflated.size());
+    int rv = inflate(&stream, Z_SYNC_FLUSH);
+    REQUIRE(rv == Z_NEED_DICT);
+    REQUIRE(inflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(dictionary.data()),
+                                 static_cast<uInt>(dictionary.size())) == Z_OK);
+    rv = inflate(&stream, Z_SYNC_FLUSH);
+    REQUIRE(rv == Z_OK);
+    REQUIRE(stream.avail_in == 0);
+    inflated.resize(inflated.size() - stream.avail_out);
+    (void)inflateEnd(&stream);
+    REQUIRE(inflated == expected);
+}
+#endif
+
+TEST_CASE("tcp_sink waits before reconnecting", "[tcp_sink]") {
+    test_server server;  // not listening yet
+    spdlog::sinks::tcp_sink_config cfg("127.0.0.1", server.port());
+    cfg.lazy_connect = true;
+    cfg.reconnect_min_delay = std::chrono::milliseconds(50);
+    auto sink = std::make_shared<spdlog::sinks::tcp_sink_mt>(cfg);
+    sink->set_pattern("%v");
+    size_t errors = 0;
+    {
+        spdlog::logger logger("tcp", sink);
+        logger.set_error_handler([&](const std::string &) { errors++; });
+        logger.info("refused");
+        logger.info("dropped 1");
+        logger.info("dropped 2");
+        REQUIRE(errors == 1);
+        REQUIRE(sink->dropped() == 2);
+
+        server.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        logger.info("sent");
+    }
+    sink.reset();  // closes the connection
+    REQUIRE(errors == 1);
+    auto received = server.join();
+    REQUIRE(received.find("sent") != std::string::npos);
+    REQUIRE(received.find("dropped") == std::string::npos);
+}
+
+#ifdef SPDLOG_OPENSSL
+TEST_CASE("buffered_tcp_sink over TLS", "[buffered_tcp_sink]") {
+    tls_test_server server(1);
+    server.start();
+    {
+        spdlog::sinks::buffered_tcp_sink_config cfg("127.0.0.1", server.port());
+        cfg.tls.enabled = true;
+        cfg.tls.ca_file = tls_test_server::cert_file;
+        auto sink = std::make_shared<spdlog::sinks::buffered_tcp_sink_mt>(cfg);
+        sink->set_pattern("%v");
+        spdlog::logger logger("tcp", sink);
+        for (int i = 0; i < 1000; i++) {
+            logger.info("message {}", i);
+        }
+    }
+    auto received = server.join();
+    REQUIRE(count_occurrences(received, "message ") == 1000);
+    REQUIRE(received.find("message 999") != std::string::npos);
+}
+
+TEST_CASE("tls_client resumes the session", "[buffered_tcp_sink]") {
+    tls_test_server server(2);
+    server.start();
+    spdlog::details::tls_config config;
+    config.enabled = true;
+    config.ca_file = tls_test_server::cert_file;
+    spdlog::details::tls_client client;
+    client.set_config(config);
+
+    client.connect("127.0.0.1", server.port());
+    REQUIRE_FALSE(client.session_reused());
+    // the session tickets of TLS 1.3 follow the handshake, and are read by send()
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    client.send("first\n", 6);
+    client.close();
+
+    client.connect("127.0.0.1", server.port());
+    REQUIRE(client.session_reused());
+    client.send("second\n", 7);
+    client.close();
+    REQUIRE(server.join() == "first\nsecond\n");
+}
+
+TEST_CASE("tls_client rejects an untrusted server", "[buffered_tcp_sink]") {
+    tls_test_server server(1);
+    server.start();
+    spdlog::details::tls_config config;
+    config.enabled = true;  // verified with the system's certificates
+    spdlog::details::tls_client client;
+    client.set_config(config);
+    REQUIRE_THROWS_AS(client.connect("127.0.0.1", server.port()), spdlog::spdlog_ex);
+    REQUIRE_FALSE(client.is_connected());
+    server.join();
+}
+#endif
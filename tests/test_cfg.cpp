@@ -4,9 +4,14 @@
 
 #include <spdlog/cfg/env.h>
 #include <spdlog/cfg/argv.h>
+#include <spdlog/cfg/file.h>
+
+#include <fstream>
+#include <thread>
 
 using spdlog::cfg::load_argv_levels;
 using spdlog::cfg::load_env_levels;
+using spdlog::sinks::test_sink_mt;
 using spdlog::sinks::test_sink_st;
 
 TEST_CASE("env", "[cfg]") {
@@ -160,6 +165,19 @@ TEST_CASE("level-not-set-test5", "[cfg]") {
     REQUIRE(spdlog::default_logger()->level() == spdlog::level::warn);
 }
 
+TEST_CASE("levels spec parsing", "[cfg]") {
+    spdlog::drop("l1");
+    spdlog::drop("l2");
+    spdlog::cfg::helpers::load_levels(" l1 = WARN ,, l2=junk, =, l2 = Critical,Debug ");
+    auto l1 = spdlog::create<test_sink_st>("l1");
+    auto l2 = spdlog::create<test_sink_st>("l2");
+    auto l3 = spdlog::create<test_sink_st>("l3");
+    REQUIRE(l1->level() == spdlog::level::warn);
+    REQUIRE(l2->level() == spdlog::level::critical);
+    REQUIRE(l3->level() == spdlog::level::debug);
+    spdlog::drop("l3");
+}
+
 TEST_CASE("restore-to-default", "[cfg]") {
     spdlog::drop("l1");
     spdlog::drop("l2");
@@ -167,3 +185,114 @@ TEST_CASE("restore-to-default", "[cfg]") {
     load_argv_levels(2, argv);
     REQUIRE(spdlog::default_logger()->level() == spdlog::level::info);
 }
+
+TEST_CASE("vmodule", "[cfg]") {
+    auto sink = std::make_shared<test_sink_st>();
+    auto logger = std::make_shared<spdlog::logger>("vmodule", sink);
+    logger->set_level(spdlog::level::info);
+
+    spdlog::cfg::helpers::load_vmodule("other/*=trace, tests/test_c?g.*=debug");
+    SPDLOG_LOGGER_DEBUG(logger, "debug {}", 1);
+    REQUIRE(sink->msg_counter() == 1);
+
+    // the first pattern matching applies, whatever the logger's level
+    spdlog::cfg::helpers::load_vmodule("test_cfg.cpp = ERROR,tests/*=debug");
+    SPDLOG_LOGGER_WARN(logger, "warn");
+    SPDLOG_LOGGER_ERROR(logger, "error");
+    REQUIRE(sink->msg_counter() == 2);
+
+    // the sinks' levels still apply
+    spdlog::cfg::helpers::load_vmodule("*=debug");
+    sink->set_level(spdlog::level::info);
+    SPDLOG_LOGGER_DEBUG(logger, "debug");
+    REQUIRE(sink->msg_counter() == 2);
+    sink->set_level(spdlog::level::trace);
+
+    // a pattern matches from a path separator only
+    spdlog::cfg::helpers::load_vmodule("cfg.cpp=debug,sts/*=debug,junk-level=junk");
+    SPDLOG_LOGGER_DEBUG(logger, "debug");
+    REQUIRE(sink->msg_counter() == 2);
+
+    const char *argv[] = {"ignore", "SPDLOG_VMODULE=tests/*=debug"};
+    load_argv_levels(2, argv);
+    SPDLOG_LOGGER_DEBUG(logger, "debug");
+    REQUIRE(sink->msg_counter() == 3);
+
+    spdlog::cfg::helpers::load_vmodule("");
+    SPDLOG_LOGGER_DEBUG(logger, "debug");
+    SPDLOG_LOGGER_INFO(logger, "info");
+    REQUIRE(sink->msg_counter() == 4);
+}
+
+TEST_CASE("vmodule default logger", "[cfg]") {
+    auto previous = spdlog::default_logger();
+    auto sink = std::make_shared<test_sink_st>();
+    auto logger = std::make_shared<spdlog::logger>("vmodule-default", sink);
+    logger->set_level(spdlog::level::info);
+    spdlog::set_default_logger(logger);
+
+    SPDLOG_DEBUG("debug");
+    REQUIRE(sink->msg_counter() == 0);
+    spdlog::cfg::helpers::load_vmodule("test_cfg.cpp=debug");
+    SPDLOG_DEBUG("debug {}", 1);
+    REQUIRE(sink->msg_counter() == 1);
+    spdlog::cfg::helpers::load_vmodule("test_cfg.cpp=critical");
+    SPDLOG_ERROR("error");
+    REQUIRE(sink->msg_counter() == 1);
+
+    spdlog::cfg::helpers::load_vmodule("");
+    SPDLOG_ERROR("error");
+    REQUIRE(sink->msg_counter() == 2);
+    spdlog::set_default_logger(previous);
+}
+
+TEST_CASE("config file reload", "[cfg]") {
+    prepare_logdir();
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    const std::string filename = "test_logs/logging.cfg";
+    auto write_config = [&](const std::string &content) {
+        std::ofstream ofs(filename, std::ios_base::binary);
+        ofs << content;
+    };
+    write_config("# only l1\nlevel = off,l1=debug\npattern = [%n] %v\nflush_level=warn\n");
+    auto sink = std::make_shared<test_sink_mt>();
+    auto l1 = std::make_shared<spdlog::logger>("l1", sink);
+    spdlog::register_logger(l1);
+    {
+        spdlog::cfg::file_watcher watcher(filename, std::chrono::milliseconds(10));
+        REQUIRE(watcher.reloads() == 1);
+        REQUIRE(l1->level() == spdlog::level::debug);
+        REQUIRE(l1->flush_level() == spdlog::level::warn);
+        l1->debug("hello");
+        REQUIRE(sink->lines().back() == "[l1] hello");
+
+        // logging while the config changes (fewer messages than the sink keeps)
+        std::atomic<bool> stop{false};
+        std::thread logging([&] {
+            for (int i = 0; i < 50 && !stop; i++) {
+                l1->info("message");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        write_config("level = l1=warn\npattern = %v!\nunknown = ignored\n");
+        for (int i = 0; i < 500 && watcher.reloads() < 2; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        stop = true;
+        logging.join();
+        REQUIRE(watcher.reloads() == 2);
+        REQUIRE(l1->level() == spdlog::level::warn);
+        l1->warn("changed");
+        REQUIRE(sink->lines().back() == "changed!");
+
+        REQUIRE(watcher.check());  // unchanged
+        REQUIRE(watcher.reloads() == 2);
+    }
+    REQUIRE(spdlog::cfg::load_file(filename));
+    REQUIRE_FALSE(spdlog::cfg::load_file("test_logs/missing.cfg"));
+
+    spdlog::drop("l1");
+    spdlog::set_pattern("%+");
+    spdlog::flush_on(spdlog::level::off);
+    spdlog::cfg::helpers::load_levels("info");
+}
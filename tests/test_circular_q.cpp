@@ -47,4 +47,28 @@ TEST_CASE("test_empty", "[circular_q]") {
     q_type q(0);
     q.push_back(1);
     REQUIRE(q.empty());
-}
\ No newline at end of file
+}
+TEST_CASE("test_non_power_of_two", "[circular_q]") {
+    // the storage is rounded up to 8, holding 5 items at most
+    q_type q(5);
+    for (size_t i = 0; i < 20; i++) {
+        q.push_back(std::move(i));
+        REQUIRE(q.size() == (std::min)(i + 1, size_t{5}));
+        REQUIRE(q.full() == (i >= 4));
+        REQUIRE(q.front() == (i >= 4 ? i - 4 : 0));
+        REQUIRE(q.at(q.size() - 1) == i);
+    }
+    REQUIRE(q.overrun_counter() == 15);
+    q.pop_front();
+    q.pop_front();
+    REQUIRE(q.size() == 3);
+    REQUIRE(q.at(0) == 17);
+    REQUIRE(q.at(2) == 19);
+
+    q_type moved(std::move(q));
+    REQUIRE(moved.size() == 3);
+    REQUIRE(moved.front() == 17);
+    REQUIRE(q.empty());
+    q.push_back(1);
+    REQUIRE(q.empty());
+}
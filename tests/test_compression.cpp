@@ -0,0 +1,134 @@
+#include "includes.h"
+#include "spdlog/details/file_housekeeper.h"
+#include "spdlog/sinks/daily_file_sink.h"
+#include "spdlog/sinks/rotating_file_sink.h"
+#ifdef SPDLOG_ZLIB
+    #include "spdlog/sinks/gzip_file_sink.h"
+#endif
+
+#include <fstream>
+
+#ifdef SPDLOG_ZLIB
+    #include <zlib.h>
+
+static std::string gunzip_contents(const std::string &filename) {
+    std::string contents;
+    gzFile file = gzopen(filename.c_str(), "rb");
+    REQUIRE(file != nullptr);
+    char buf[4096];
+    int n;
+    while ((n = gzread(file, buf, sizeof(buf))) > 0) {
+        contents.append(buf, static_cast<size_t>(n));
+    }
+    gzclose(file);
+    return contents;
+}
+
+TEST_CASE("compress_file", "[compression]") {
+    prepare_logdir();
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    std::string data;
+    for (int i = 0; i < 10000; i++) {
+        data += spdlog::fmt_lib::format("Test message {}\n", i);
+    }
+    {
+        std::ofstream out("test_logs/compress.txt", std::ios::binary);
+        out << data;
+    }
+    auto start = std::chrono::steady_clock::now();
+    spdlog::compression_options options(spdlog::file_compression::gzip, 6, 500 * 1024);
+    REQUIRE(spdlog::details::compress_file(SPDLOG_FILENAME_T("test_logs/compress.txt"), options)
+                .empty());
+    // about 200KB read at most at 500KB/sec
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(300));
+    REQUIRE(count_files("test_logs") == 1);
+    REQUIRE(get_filesize("test_logs/compress.txt.gz") < data.size() / 4);
+    REQUIRE(gunzip_contents("test_logs/compress.txt.gz") == data);
+}
+
+TEST_CASE("rotating_file_sink compression", "[compression]") {
+    prepare_logdir();
+    using spdlog::sinks::rotating_file_sink_st;
+    auto lines = [](int first, int count) {
+        std::string s;
+        for (int i = first; i < first + count; i++) {
+            s += spdlog::fmt_lib::format("Test message {:02}{}", i,
+                                         spdlog::details::os::default_eol);
+        }
+        return s;
+    };
+    auto line_size = lines(0, 1).size();
+    spdlog::filename_t basename = SPDLOG_FILENAME_T("test_logs/compressed.txt");
+    {
+        auto sink = std::make_shared<rotating_file_sink_st>(basename, 4 * line_size, 2);
+        sink->set_compression(spdlog::compression_options(spdlog::file_compression::gzip));
+        spdlog::logger logger("logger", sink);
+        logger.set_pattern("%v");
+        for (int i = 0; i < 13; i++) {
+            logger.info("Test message {:02}", i);
+        }
+    }
+    REQUIRE(count_files("test_logs") == 3);
+    REQUIRE(file_contents("test_logs/compressed.txt") == lines(12, 1));
+    REQUIRE(gunzip_contents("test_logs/compressed.1.txt.gz") == lines(8, 4));
+    REQUIRE(gunzip_contents("test_logs/compressed.2.txt.gz") == lines(4, 4));
+}
+
+TEST_CASE("daily_file_sink compression", "[compression]") {
+    prepare_logdir();
+    spdlog::filename_t basename = SPDLOG_FILENAME_T("test_logs/daily_compressed.txt");
+    {
+        spdlog::sinks::daily_file_sink_st sink(basename, 2, 30, true, 3);
+        sink.set_compression(spdlog::compression_options(spdlog::file_compression::gzip));
+        for (int i = 0; i < 5; i++) {
+            spdlog::details::log_msg msg{"test", spdlog::level::info, "Hello Message"};
+            msg.time = spdlog::log_clock::now() + std::chrono::hours(24 * i);
+            sink.log(msg);
+        }
+    }
+    // the current file and the last 2 compressed
+    REQUIRE(count_files("test_logs") == 3);
+    auto tm = spdlog::details::os::localtime(
+        spdlog::log_clock::to_time_t(spdlog::log_clock::now() + std::chrono::hours(24 * 3)));
+    auto filename = spdlog::details::os::filename_to_str(
+        spdlog::sinks::daily_filename_calculator::calc_filename(basename, tm));
+    REQUIRE(ends_with(gunzip_contents(filename + ".gz"),
+                      std::string("Hello Message") + spdlog::details::os::default_eol));
+}
+
+TEST_CASE("gzip_file_sink", "[compression]") {
+    prepare_logdir();
+    using spdlog::details::os::default_eol;
+    auto sink = std::make_shared<spdlog::sinks::gzip_file_sink_mt>(
+        SPDLOG_FILENAME_T("test_logs/gzip_log.txt.gz"), true);
+    auto logger = std::make_shared<spdlog::logger>("gzip_logger", sink);
+    logger->set_pattern("%v");
+    std::string expected;
+    for (int i = 0; i < 1000; i++) {
+        logger->info("Test message {}", i);
+        expected += spdlog::fmt_lib::format("Test message {}{}", i, default_eol);
+    }
+    // a complete gzip member after the flush
+    logger->flush();
+    REQUIRE(get_filesize("test_logs/gzip_log.txt.gz") < expected.size() / 4);
+    REQUIRE(gunzip_contents("test_logs/gzip_log.txt.gz") == expected);
+
+    // the next member is appended
+    logger->info("Last message");
+    logger->flush();
+    REQUIRE(gunzip_contents("test_logs/gzip_log.txt.gz") ==
+            expected + "Last message" + default_eol);
+}
+
+#else
+
+TEST_CASE("compression unsupported", "[compression]") {
+    prepare_logdir();
+    spdlog::sinks::rotating_file_sink_st sink(SPDLOG_FILENAME_T("test_logs/compressed.txt"), 1024,
+                                              2);
+    REQUIRE_THROWS_AS(
+        sink.set_compression(spdlog::compression_options(spdlog::file_compression::gzip)),
+        spdlog::spdlog_ex);
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "includes.h"
+#include "spdlog/crash_dump.h"
+#include "spdlog/sinks/callback_sink.h"
+
+#include <atomic>
+#include <csignal>
+#include <fcntl.h>
+
+#ifndef _WIN32
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+#define TEST_FILENAME "test_logs/crash_dump.log"
+
+#ifndef _WIN32
+static int open_dump_file() {
+    prepare_logdir();
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    return ::open(TEST_FILENAME, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+TEST_CASE("queued messages", "[crash_dump]") {
+    std::atomic<bool> release{false};
+    std::atomic<int> written{0};
+    auto sink = std::make_shared<spdlog::sinks::callback_sink_mt>(
+        [&](const spdlog::details::log_msg &) {
+            written++;
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    spdlog::details::thread_pool_options options(16, 1);
+    options.batch_size = 1;
+    auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+    auto logger = std::make_shared<spdlog::async_logger>("crashing", sink, tp);
+    logger->info("taken by the worker");
+    while (written == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    logger->info("queued {}", 1);
+    logger->warn("queued {}", 2);
+    logger->set_deferred_formatting(true);
+    logger->error("deferred {}", 3);
+
+    spdlog::crash_dump::watch(tp);
+    int fd = open_dump_file();
+    if (fd >= 0) {
+        spdlog::crash_dump::dump(fd);
+        ::close(fd);
+    }
+    spdlog::crash_dump::disable();
+    release = true;
+    logger.reset();
+    tp.reset();
+    REQUIRE(fd >= 0);
+
+    auto contents = file_contents(TEST_FILENAME);
+    REQUIRE(contents.find("*** queued messages of thread pool #0\n") == 0);
+    REQUIRE(contents.find("taken by the worker") == std::string::npos);
+    REQUIRE(contents.find("] [crashing] [info] queued 1\n") != std::string::npos);
+    REQUIRE(contents.find("] [crashing] [warning] queued 2\n") != std::string::npos);
+    REQUIRE(contents.find("] [crashing] [error] deferred {} (arguments not formatted)\n") !=
+            std::string::npos);
+}
+
+TEST_CASE("backtrace messages", "[crash_dump]") {
+    auto logger = std::make_shared<spdlog::logger>("traced",
+                                                   std::make_shared<spdlog::sinks::null_sink_mt>());
+    logger->enable_backtrace(2);
+    logger->debug("debug 1");
+    logger->debug("debug 2");
+    logger->debug("debug {}", 3);
+
+    spdlog::crash_dump::watch(logger);
+    int fd = open_dump_file();
+    REQUIRE(fd >= 0);
+    spdlog::crash_dump::dump(fd);
+    ::close(fd);
+    spdlog::crash_dump::disable();
+
+    auto contents = file_contents(TEST_FILENAME);
+    REQUIRE(contents.find("*** backtrace of logger [traced]\n") == 0);
+    REQUIRE(contents.find("debug 1") == std::string::npos);
+    auto second = contents.find("] [traced] [debug] debug 2\n");
+    // formatted when dumped normally
+    auto third = contents.find("] [traced] [debug] debug {} (arguments not formatted)\n");
+    REQUIRE(second != std::string::npos);
+    REQUIRE(third != std::string::npos);
+    REQUIRE(second < third);
+}
+
+TEST_CASE("dump on a fatal signal", "[crash_dump]") {
+    ::close(open_dump_file());
+    auto pid = ::fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        // the child crashes, once the dump is enabled
+        auto logger = std::make_shared<spdlog::logger>(
+            "child", std::make_shared<spdlog::sinks::null_sink_mt>());
+        logger->enable_backtrace(8);
+        logger->debug("last words");
+        int fd = ::open(TEST_FILENAME, O_WRONLY | O_TRUNC);
+        std::signal(SIGABRT, SIG_DFL);  // not the handler of the test framework afterwards
+        spdlog::crash_dump::watch(logger);
+        spdlog::crash_dump::enable(fd);
+        std::raise(SIGABRT);
+        ::_exit(0);  // not reached
+    }
+    int status = 0;
+    REQUIRE(::waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFSIGNALED(status));
+    REQUIRE(WTERMSIG(status) == SIGABRT);
+
+    auto contents = file_contents(TEST_FILENAME);
+    REQUIRE(contents.find("*** spdlog crash dump: signal " + std::to_string(SIGABRT) + "\n") ==
+            0);
+    REQUIRE(contents.find("] [child] [debug] last words\n") != std::string::npos);
+}
+#endif
@@ -33,3 +33,39 @@ TEST_CASE("custom_callback_logger", "[custom_callback_logger]") {
     REQUIRE(lines[2] == ref_lines[2]);
     spdlog::drop_all();
 }
+
+TEST_CASE("batch_callback_logger", "[custom_callback_logger]") {
+    std::vector<std::string> payloads;
+    size_t calls = 0;
+    auto sink = std::make_shared<spdlog::sinks::batch_callback_sink_mt>(
+        [&](const spdlog::details::log_msg *msgs, size_t count) {
+            calls++;
+            for (size_t i = 0; i < count; i++) {
+                payloads.emplace_back(msgs[i].payload.data(), msgs[i].payload.size());
+            }
+        });
+    sink->set_level(spdlog::level::info);
+    {
+        spdlog::details::thread_pool_options options(128, 1);
+        options.batch_size = 16;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", sink, tp);
+        logger->set_level(spdlog::level::trace);
+        for (int i = 0; i < 100; i++) {
+            logger->log(i % 5 == 0 ? spdlog::level::debug : spdlog::level::info, "{}", i);
+        }
+    }
+    REQUIRE(payloads.size() == 80);
+    REQUIRE(payloads.front() == "1");
+    REQUIRE(payloads.back() == "99");
+    REQUIRE(calls <= payloads.size());
+
+    // one message per call for the synchronous loggers
+    calls = 0;
+    payloads.clear();
+    spdlog::logger logger("sync", sink);
+    logger.info("first");
+    logger.info("second");
+    REQUIRE(calls == 2);
+    REQUIRE(payloads == std::vector<std::string>{"first", "second"});
+}
@@ -171,3 +171,92 @@ TEST_CASE("daily_logger rotate", "[daily_file_sink]") {
     test_rotate(days_to_run, 11, 10);
     test_rotate(days_to_run, 20, 10);
 }
+
+TEST_CASE("rotation_schedule daily", "[daily_file_sink]") {
+    using spdlog::log_clock;
+    spdlog::details::rotation_schedule schedule{std::chrono::hours(24), std::chrono::minutes(150)};
+    auto now = log_clock::now();
+    auto next = schedule.next_after(now);
+    REQUIRE(next > now);
+    REQUIRE(next <= now + std::chrono::hours(25));  // 25 on a DST change
+    auto tm = spdlog::details::os::localtime(log_clock::to_time_t(next));
+    REQUIRE(tm.tm_hour == 2);
+    REQUIRE(tm.tm_min == 30);
+    REQUIRE(tm.tm_sec == 0);
+    REQUIRE(schedule.next_after(next) > next);
+    REQUIRE(schedule.next_after(next - std::chrono::seconds(1)) == next);
+}
+
+TEST_CASE("rotation_schedule minutes", "[daily_file_sink]") {
+    using spdlog::log_clock;
+    spdlog::details::rotation_schedule schedule{std::chrono::minutes(5), std::chrono::seconds(0)};
+    auto now = log_clock::now();
+    auto next = schedule.next_after(now);
+    REQUIRE(next > now);
+    REQUIRE(next <= now + std::chrono::minutes(5));
+    auto tm = spdlog::details::os::localtime(log_clock::to_time_t(next));
+    REQUIRE(tm.tm_min % 5 == 0);
+    REQUIRE(tm.tm_sec == 0);
+    REQUIRE(schedule.next_after(next) == next + std::chrono::minutes(5));
+}
+
+TEST_CASE("rotation_schedule invalid", "[daily_file_sink]") {
+    using spdlog::details::rotation_schedule;
+    REQUIRE_THROWS_AS(rotation_schedule(std::chrono::hours(7), std::chrono::seconds(0)),
+                      spdlog::spdlog_ex);
+    REQUIRE_THROWS_AS(rotation_schedule(std::chrono::hours(1), std::chrono::hours(1)),
+                      spdlog::spdlog_ex);
+    REQUIRE_THROWS_AS(spdlog::sinks::daily_file_sink_st(SPDLOG_FILENAME_T("test_logs/daily.txt"),
+                                                        24, 0),
+                      spdlog::spdlog_ex);
+}
+
+TEST_CASE("daily_file_sink::daily_filename_format_calculator long", "[daily_file_sink]") {
+    std::tm tm = spdlog::details::os::localtime();
+    spdlog::filename_t pattern;
+    spdlog::filename_t expected;
+    auto year = spdlog::fmt_lib::format(SPDLOG_FILENAME_T("{:04d}"), tm.tm_year + 1900);
+    for (int i = 0; i < 100; i++) {
+        pattern += SPDLOG_FILENAME_T("%Y");
+        expected += year;
+    }
+    using spdlog::sinks::daily_filename_format_calculator;
+    REQUIRE(daily_filename_format_calculator::calc_filename(pattern, tm) == expected);
+    REQUIRE(daily_filename_format_calculator::calc_filename(SPDLOG_FILENAME_T(""), tm).empty());
+}
+
+TEST_CASE("dir_snapshot", "[daily_file_sink]") {
+    prepare_logdir();
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs/sub"));
+    std::ofstream(SPDLOG_FILENAME_T("test_logs/a.txt")).put('a');
+    std::ofstream(SPDLOG_FILENAME_T("test_logs/sub/b.txt")).put('b');
+    spdlog::details::dir_snapshot files;
+    REQUIRE(files.exists(SPDLOG_FILENAME_T("test_logs/a.txt")));
+    REQUIRE(files.exists(SPDLOG_FILENAME_T("test_logs/sub/b.txt")));
+    REQUIRE_FALSE(files.exists(SPDLOG_FILENAME_T("test_logs/b.txt")));
+    REQUIRE_FALSE(files.exists(SPDLOG_FILENAME_T("test_logs/none/a.txt")));
+}
+
+TEST_CASE("daily_logger retention of previous runs", "[daily_file_sink]") {
+    using spdlog::log_clock;
+    using spdlog::sinks::daily_filename_calculator;
+    prepare_logdir();
+
+    // the files of the 4 previous days, left by previous runs
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    spdlog::filename_t basename = SPDLOG_FILENAME_T("test_logs/daily_retention.txt");
+    std::vector<spdlog::filename_t> previous;
+    for (int i = 4; i > 0; i--) {
+        auto tp = log_clock::now() - std::chrono::hours(24 * i);
+        auto tm = spdlog::details::os::localtime(log_clock::to_time_t(tp));
+        previous.push_back(daily_filename_calculator::calc_filename(basename, tm));
+        std::ofstream(previous.back()).put('x');
+    }
+
+    spdlog::sinks::daily_file_sink_st sink{basename, 2, 30, true, 3};
+    sink.log(create_msg(std::chrono::seconds(24 * 3600)));
+    // the queue was rebuilt with the 2 previous days: the older of them is removed
+    REQUIRE(count_files("test_logs") == 5);
+    REQUIRE_FALSE(spdlog::details::os::path_exists(previous[2]));
+    REQUIRE(spdlog::details::os::path_exists(previous[3]));
+}
@@ -0,0 +1,62 @@
+#include "includes.h"
+#include "spdlog/sinks/direct_file_sink.h"
+
+#define DIRECT_FILENAME "test_logs/direct_log.txt"
+
+using spdlog::sinks::direct_file_sink_st;
+
+static std::shared_ptr<direct_file_sink_st> make_direct_sink(size_t buffer_size) {
+    try {
+        return std::make_shared<direct_file_sink_st>(SPDLOG_FILENAME_T(DIRECT_FILENAME), false,
+                                                     buffer_size);
+    } catch (const spdlog::spdlog_ex &) {
+        return nullptr;  // O_DIRECT not supported by the file system
+    }
+}
+
+static std::string expected_messages(int first, int last) {
+    std::string expected;
+    for (int i = first; i < last; i++) {
+        expected +=
+            spdlog::fmt_lib::format("Test message {}{}", i, spdlog::details::os::default_eol);
+    }
+    return expected;
+}
+
+TEST_CASE("direct_file_sink", "[direct_file_sink]") {
+    prepare_logdir();
+    {
+        // 2 blocks buffer
+        auto sink = make_direct_sink(8192);
+        if (!sink) {
+            WARN("O_DIRECT not supported");
+            return;
+        }
+        spdlog::logger logger("direct_logger", sink);
+        logger.set_pattern("%v");
+        for (int i = 0; i < 1000; i++) {
+            logger.info("Test message {}", i);
+        }
+        logger.flush();
+        REQUIRE(file_contents(DIRECT_FILENAME) == expected_messages(0, 1000));
+        // the partial block written again
+        for (int i = 1000; i < 1010; i++) {
+            logger.info("Test message {}", i);
+        }
+        logger.flush();
+        REQUIRE(file_contents(DIRECT_FILENAME) == expected_messages(0, 1010));
+        logger.info("Test message {}", 1010);
+    }
+    REQUIRE(file_contents(DIRECT_FILENAME) == expected_messages(0, 1011));
+
+    // appending to the last partial block of the file
+    {
+        auto sink = make_direct_sink(4096);
+        spdlog::logger logger("direct_logger", sink);
+        logger.set_pattern("%v");
+        for (int i = 1011; i < 1500; i++) {
+            logger.info("Test message {}", i);
+        }
+    }
+    REQUIRE(file_contents(DIRECT_FILENAME) == expected_messages(0, 1500));
+}
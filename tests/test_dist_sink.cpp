@@ -0,0 +1,252 @@
+#include "includes.h"
+#include "test_sink.h"
+#include "spdlog/sinks/dist_sink.h"
+#include "spdlog/sinks/flush_policy_sink.h"
+#include "spdlog/sinks/reorder_sink.h"
+#include "spdlog/sinks/summary_sink.h"
+
+using spdlog::sinks::test_sink_mt;
+
+TEST_CASE("dist_sink", "[dist_sink]") {
+    auto sink1 = std::make_shared<test_sink_mt>();
+    auto sink2 = std::make_shared<test_sink_mt>();
+    auto dist = std::make_shared<spdlog::sinks::dist_sink_mt>();
+    dist->add_sink(sink1);
+    dist->add_sink(sink2);
+    spdlog::logger logger("logger", dist);
+    logger.info("message");
+    dist->remove_sink(sink2);
+    logger.info("message");
+    logger.flush();
+    REQUIRE(sink1->msg_counter() == 2);
+    REQUIRE(sink2->msg_counter() == 1);
+    REQUIRE(sink1->flush_counter() == 1);
+    REQUIRE(sink2->flush_counter() == 0);
+}
+
+TEST_CASE("dist_sink batch", "[dist_sink]") {
+    auto sink1 = std::make_shared<test_sink_mt>();
+    auto sink2 = std::make_shared<test_sink_mt>();
+    sink2->set_level(spdlog::level::warn);
+    spdlog::sinks::dist_sink_mt dist({sink1, sink2});
+    std::vector<spdlog::details::log_msg> msgs{
+        spdlog::details::log_msg("test", spdlog::level::info, "info"),
+        spdlog::details::log_msg("test", spdlog::level::warn, "warn"),
+        spdlog::details::log_msg("test", spdlog::level::info, "info")};
+
+    // passed on as a batch, filtered by each sub sink
+    dist.log_batch(msgs.data(), msgs.size());
+    REQUIRE(sink1->batch_counter() == 1);
+    REQUIRE(sink1->msg_counter() == 3);
+    REQUIRE(sink2->batch_counter() == 1);
+    REQUIRE(sink2->msg_counter() == 1);
+
+    // one message at a time when the dist_sink drops some of them
+    dist.set_level(spdlog::level::warn);
+    dist.log_batch(msgs.data(), msgs.size());
+    REQUIRE(sink1->batch_counter() == 1);
+    REQUIRE(sink1->msg_counter() == 4);
+}
+
+TEST_CASE("dist_sink parallel", "[dist_sink]") {
+    auto slow = std::make_shared<test_sink_mt>();
+    slow->set_delay(std::chrono::milliseconds(100));
+    auto fast = std::make_shared<test_sink_mt>();
+    {
+        auto dist = std::make_shared<spdlog::sinks::dist_sink_mt>(
+            std::vector<spdlog::sink_ptr>{slow, fast}, spdlog::sinks::dist_sink_parallel{});
+        spdlog::logger logger("logger", dist);
+        logger.set_pattern("%v");
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 10; i++) {
+            logger.info("message {}", i);
+        }
+        logger.flush();
+
+        // the fast sink doesn't wait for the slow one, logging for a second
+        while (fast->flush_counter() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+        REQUIRE(fast->msg_counter() == 10);
+    }
+    // the messages queued are logged when the dist_sink is destroyed
+    REQUIRE(slow->msg_counter() == 10);
+    REQUIRE(slow->flush_counter() == 1);
+    REQUIRE(slow->lines()[9] == "message 9");
+    REQUIRE(fast->lines()[0] == "message 0");
+}
+
+TEST_CASE("dist_sink parallel discard", "[dist_sink]") {
+    auto slow = std::make_shared<test_sink_mt>();
+    slow->set_delay(std::chrono::milliseconds(50));
+    spdlog::sinks::dist_sink_parallel parallel;
+    parallel.queue_size = 4;
+    parallel.overflow_policy = spdlog::async_overflow_policy::discard_new;
+    auto dist = std::make_shared<spdlog::sinks::dist_sink_mt>(
+        std::vector<spdlog::sink_ptr>{slow}, parallel);
+    spdlog::logger logger("logger", dist);
+    for (int i = 0; i < 20; i++) {
+        logger.info("message {}", i);
+    }
+    auto dropped = dist->dropped();
+    REQUIRE(dropped > 0);
+    // the worker logs what was queued before stopping
+    dist->set_sinks({});
+    REQUIRE(slow->msg_counter() == 20 - dropped);
+}
+
+TEST_CASE("flush_policy_sink level and size", "[dist_sink]") {
+    auto sub_sink = std::make_shared<test_sink_mt>();
+    spdlog::sinks::flush_policy policy;
+    policy.flush_level = spdlog::level::err;
+    policy.max_pending_bytes = 10;
+    auto sink = std::make_shared<spdlog::sinks::flush_policy_sink_mt>(sub_sink, policy);
+    spdlog::logger logger("logger", sink);
+
+    logger.info("12345");
+    REQUIRE(sub_sink->flush_counter() == 0);
+    logger.info("67890");
+    REQUIRE(sub_sink->flush_counter() == 1);
+    logger.info("1");
+    logger.error("2");
+    REQUIRE(sub_sink->flush_counter() == 2);
+    // counted from the last flush
+    logger.info("123456789");
+    REQUIRE(sub_sink->flush_counter() == 2);
+    logger.flush();
+    logger.info("1");
+    REQUIRE(sub_sink->flush_counter() == 3);
+    REQUIRE(sub_sink->msg_counter() == 6);
+}
+
+TEST_CASE("flush_policy_sink delay", "[dist_sink]") {
+    auto sub_sink = std::make_shared<test_sink_mt>();
+    spdlog::sinks::flush_policy policy;
+    policy.max_delay = std::chrono::milliseconds(10);
+    auto sink = std::make_shared<spdlog::sinks::flush_policy_sink_mt>(
+        std::vector<spdlog::sink_ptr>{sub_sink}, policy);
+    spdlog::logger logger("logger", sink);
+
+    // nothing to flush
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(sub_sink->flush_counter() == 0);
+
+    logger.info("message");
+    for (int i = 0; i < 500 && sub_sink->flush_counter() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(sub_sink->flush_counter() == 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(sub_sink->flush_counter() == 1);
+}
+
+TEST_CASE("reorder_sink", "[dist_sink]") {
+    auto sub_sink = std::make_shared<test_sink_mt>();
+    sub_sink->set_pattern("%v");
+    spdlog::sinks::reorder_sink_st sink(std::chrono::hours(1), 3);
+    sink.add_sink(sub_sink);
+    auto now = spdlog::log_clock::now();
+    auto log_at = [&sink](spdlog::log_clock::time_point time, const char *payload) {
+        spdlog::details::log_msg msg(time, spdlog::source_loc{}, "test", spdlog::level::info,
+                                     payload);
+        sink.log(msg);
+    };
+
+    log_at(now - std::chrono::seconds(1), "b");
+    log_at(now - std::chrono::seconds(2), "a");
+    log_at(now, "c");
+    REQUIRE(sub_sink->msg_counter() == 0);
+    REQUIRE(sink.held_messages() == 3);
+
+    // full: the oldest is passed to make room
+    log_at(now - std::chrono::milliseconds(500), "d");
+    REQUIRE(sub_sink->lines() == std::vector<std::string>{"a"});
+
+    sink.flush();
+    REQUIRE(sub_sink->lines() == std::vector<std::string>{"a", "b", "d", "c"});
+    REQUIRE(sink.held_messages() == 0);
+    REQUIRE(sink.late_messages() == 0);
+
+    // older than a message passed
+    log_at(now - std::chrono::seconds(3), "e");
+    REQUIRE(sub_sink->msg_counter() == 5);
+    REQUIRE(sink.late_messages() == 1);
+}
+
+TEST_CASE("reorder_sink window", "[dist_sink]") {
+    auto sub_sink = std::make_shared<test_sink_mt>();
+    sub_sink->set_pattern("%v");
+    auto sink = std::make_shared<spdlog::sinks::reorder_sink_mt>(std::chrono::milliseconds(50));
+    sink->add_sink(sub_sink);
+    spdlog::logger logger("logger", sink);
+
+    logger.info("1");
+    logger.info("2");
+    REQUIRE(sub_sink->msg_counter() == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    logger.info("3");
+    REQUIRE(sub_sink->lines() == std::vector<std::string>{"1", "2"});
+    REQUIRE(sink->held_messages() == 1);
+}
+
+TEST_CASE("summary_sink", "[dist_sink]") {
+    auto downstream = std::make_shared<test_sink_mt>();
+    downstream->set_pattern("%v");
+    // no timer: summarized on flush
+    auto sink = std::make_shared<spdlog::sinks::summary_sink>(
+        downstream, std::chrono::milliseconds(0), spdlog::level::err);
+    spdlog::logger logger("logger", sink);
+
+    for (int i = 0; i < 5; i++) {
+        logger.log(spdlog::source_loc{"src/net.cpp", 10, "f"}, spdlog::level::warn, "reset {}", i);
+    }
+    logger.log(spdlog::source_loc{"src/net.cpp", 20, "f"}, spdlog::level::warn, "once");
+    logger.error("forwarded");
+    REQUIRE(downstream->lines() == std::vector<std::string>{"forwarded"});
+    REQUIRE(sink->pending_callsites() == 2);
+
+    logger.flush();
+    REQUIRE(downstream->flush_counter() == 1);
+    auto lines = downstream->lines();
+    REQUIRE(lines.size() == 3);
+    std::sort(lines.begin() + 1, lines.end());
+    REQUIRE(lines[1].find("net.cpp:10 fired 5 times in the last ") == 0);
+    REQUIRE(ends_with(lines[1], "s, last payload: reset 4"));
+    REQUIRE(lines[2] == "once");
+    REQUIRE(sink->pending_callsites() == 0);
+
+    // from several threads, without source location
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&logger] {
+            for (int i = 0; i < 1000; i++) {
+                logger.warn("busy");
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    sink->summarize();
+    REQUIRE(downstream->msg_counter() == 4);
+    REQUIRE(downstream->lines()[3].find("message fired 4000 times in the last ") == 0);
+    sink->summarize();
+    REQUIRE(downstream->msg_counter() == 4);
+}
+
+TEST_CASE("summary_sink interval", "[dist_sink]") {
+    auto downstream = std::make_shared<test_sink_mt>();
+    downstream->set_pattern("%v");
+    auto sink = std::make_shared<spdlog::sinks::summary_sink>(downstream,
+                                                              std::chrono::milliseconds(20));
+    spdlog::logger logger("logger", sink);
+    logger.info("first");
+    logger.info("first");
+    for (int i = 0; i < 500 && downstream->msg_counter() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // a summary, or the messages as is if the timer ran in between
+    REQUIRE(downstream->msg_counter() >= 1);
+    REQUIRE(ends_with(downstream->lines()[0], "first"));
+}
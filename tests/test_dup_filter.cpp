@@ -81,3 +81,46 @@ TEST_CASE("dup_filter_test5", "[dup_filter_sink]") {
             3);  // skip 2 messages but log the "skipped.." message before message2
     REQUIRE(test_sink->lines()[1] == "Skipped 2 duplicate messages..");
 }
+
+TEST_CASE("dup_filter_window", "[dup_filter_sink]") {
+    using spdlog::sinks::dup_filter_sink_st;
+    using spdlog::sinks::test_sink_mt;
+
+    dup_filter_sink_st dup_sink{std::chrono::seconds{5}, spdlog::level::info, 2};
+    auto test_sink = std::make_shared<test_sink_mt>();
+    test_sink->set_pattern("%v");
+    dup_sink.add_sink(test_sink);
+
+    // interleaved repeats are skipped within the window
+    for (int i = 0; i < 10; i++) {
+        dup_sink.log(spdlog::details::log_msg{"test", spdlog::level::info, "message1"});
+        dup_sink.log(spdlog::details::log_msg{"test", spdlog::level::info, "message2"});
+    }
+    REQUIRE(test_sink->msg_counter() == 2);
+
+    // message3 pushes message1 out of the window
+    dup_sink.log(spdlog::details::log_msg{"test", spdlog::level::info, "message3"});
+    dup_sink.log(spdlog::details::log_msg{"test", spdlog::level::info, "message2"});
+    dup_sink.log(spdlog::details::log_msg{"test", spdlog::level::info, "message1"});
+    REQUIRE(test_sink->msg_counter() == 6);
+    REQUIRE(test_sink->lines()[2] == "Skipped 18 duplicate messages..");
+    REQUIRE(test_sink->lines()[3] == "message3");
+    REQUIRE(test_sink->lines()[4] == "Skipped 1 duplicate messages..");
+}
+
+TEST_CASE("dup_filter_window_expiry", "[dup_filter_sink]") {
+    using spdlog::sinks::dup_filter_sink_st;
+    using spdlog::sinks::test_sink_mt;
+
+    dup_filter_sink_st dup_sink{std::chrono::milliseconds{10}, spdlog::level::info, 4};
+    auto test_sink = std::make_shared<test_sink_mt>();
+    dup_sink.add_sink(test_sink);
+
+    spdlog::details::log_msg msg1{"test", spdlog::level::info, "message1"};
+    spdlog::details::log_msg msg2{"test", spdlog::level::info, "message2"};
+    dup_sink.log(msg1);
+    dup_sink.log(msg2);
+    msg1.time += std::chrono::milliseconds(50);
+    dup_sink.log(msg1);
+    REQUIRE(test_sink->msg_counter() == 3);
+}
@@ -91,6 +91,31 @@ TEST_CASE("async_error_handler", "[errors]") {
 #endif
 
 // Make sure async error handler is executed
+TEST_CASE("log_batch_error", "[errors]") {
+    // the failing message must not prevent the rest of the batch from being logged
+    class sometimes_failing_sink : public spdlog::sinks::base_sink<std::mutex> {
+    public:
+        size_t logged = 0;
+
+    protected:
+        void sink_it_(const spdlog::details::log_msg &msg) final {
+            if (msg.payload == "bad") {
+                throw std::runtime_error("bad message");
+            }
+            logged++;
+        }
+        void flush_() final {}
+    };
+
+    sometimes_failing_sink sink;
+    spdlog::details::log_msg msgs[3] = {
+        spdlog::details::log_msg("test", spdlog::level::info, "good"),
+        spdlog::details::log_msg("test", spdlog::level::info, "bad"),
+        spdlog::details::log_msg("test", spdlog::level::info, "good")};
+    REQUIRE_THROWS_AS(sink.log_batch(msgs, 3), std::runtime_error);
+    REQUIRE(sink.logged == 2);
+}
+
 TEST_CASE("async_error_handler2", "[errors]") {
     prepare_logdir();
     std::string err_msg("This is async handler error message");
@@ -110,3 +135,35 @@ TEST_CASE("async_error_handler2", "[errors]") {
     spdlog::init_thread_pool(128, 1);
     REQUIRE(file_contents("test_logs/custom_err2.txt") == err_msg);
 }
+
+TEST_CASE("suspend failing sink", "[errors]") {
+    auto sink = std::make_shared<failing_sink>();
+    sink->set_retry_interval(std::chrono::hours(1));
+    spdlog::logger logger("failed_logger", sink);
+    size_t errors = 0;
+    logger.set_error_handler([&](const std::string &) { errors++; });
+    logger.info("first");
+    REQUIRE(sink->suspended());
+    logger.info("second");
+    logger.info("third");
+    logger.flush();
+    REQUIRE(errors == 1);
+    REQUIRE(sink->suspended_drops() == 2);
+
+    // retried once the interval is over
+    sink->set_retry_interval(std::chrono::milliseconds(1));
+    sink->on_error();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE_FALSE(sink->suspended());
+    logger.info("fourth");
+    REQUIRE(errors == 2);
+    REQUIRE(sink->suspended());
+
+    // 0 to keep trying each message
+    sink->set_retry_interval(std::chrono::milliseconds(0));
+    REQUIRE_FALSE(sink->suspended());
+    logger.info("fifth");
+    logger.info("sixth");
+    REQUIRE(errors == 4);
+    REQUIRE(sink->suspended_drops() == 2);
+}
@@ -167,3 +167,124 @@ TEST_CASE("file_helper_open", "[file_helper]") {
     target_filename += SPDLOG_FILENAME_T("/invalid");
     REQUIRE_THROWS_AS(helper.open(target_filename), spdlog::spdlog_ex);
 }
+
+TEST_CASE("file_helper_open_removed_dir", "[file_helper]") {
+    prepare_logdir();
+    spdlog::filename_t target_filename = SPDLOG_FILENAME_T("test_logs/dir/file_helper_test.txt");
+    file_helper helper;
+    helper.open(target_filename);
+    helper.close();
+
+    // the directory is known to exist, created again when the open fails
+    prepare_logdir();
+    helper.open(target_filename);
+    helper.write("x", 1);
+    helper.close();
+    REQUIRE(file_contents("test_logs/dir/file_helper_test.txt") == "x");
+}
+
+TEST_CASE("file_helper_write_buffer", "[file_helper]") {
+    prepare_logdir();
+    spdlog::filename_t target_filename = SPDLOG_FILENAME_T(TEST_FILENAME);
+    spdlog::file_event_handlers handlers;
+    handlers.write_buffer_size = 16;
+    handlers.after_open = [](spdlog::filename_t, std::FILE *fstream) {
+        fputs("header\n", fstream);
+    };
+    handlers.before_close = [](spdlog::filename_t, std::FILE *fstream) {
+        fputs("footer\n", fstream);
+    };
+
+    spdlog::memory_buf_t small, large;
+    spdlog::fmt_lib::format_to(std::back_inserter(small), "{}", "small\n");
+    spdlog::fmt_lib::format_to(std::back_inserter(large), "{}", std::string(20, 'x') + "\n");
+    {
+        file_helper helper{handlers};
+        helper.open(target_filename);
+        REQUIRE(file_contents(TEST_FILENAME) == "header\n");
+
+        helper.write(small);
+        helper.write(small);
+        REQUIRE(file_contents(TEST_FILENAME) == "header\n");
+        REQUIRE(helper.size() == 7 + 12);
+
+        // doesn't fit: the buffered messages, then this one written directly
+        helper.write(large);
+        REQUIRE(file_contents(TEST_FILENAME) == "header\nsmall\nsmall\n" + std::string(20, 'x') +
+                                                    "\n");
+        helper.write(small);
+        helper.flush();
+        REQUIRE(get_filesize(TEST_FILENAME) == 7 + 12 + 21 + 6);
+        helper.write(small);
+    }
+    REQUIRE(file_contents(TEST_FILENAME) ==
+            "header\nsmall\nsmall\n" + std::string(20, 'x') + "\nsmall\nsmall\nfooter\n");
+}
+
+TEST_CASE("file_helper_durability", "[file_helper]") {
+    using spdlog::sync_method;
+    spdlog::memory_buf_t line;
+    spdlog::fmt_lib::format_to(std::back_inserter(line), "{}", "123456789\n");
+    for (auto method : {sync_method::fsync, sync_method::fdatasync, sync_method::write_behind}) {
+        prepare_logdir();
+        spdlog::file_event_handlers handlers;
+        handlers.durability = spdlog::durability_policy(method, 64);
+        file_helper helper{handlers};
+        helper.open(SPDLOG_FILENAME_T(TEST_FILENAME));
+        for (int i = 0; i < 9; i++) {
+            helper.write(line);
+        }
+        // flushed and synced by the 7th line, the next ones still buffered
+        REQUIRE(get_filesize(TEST_FILENAME) == 70);
+        helper.sync();
+        REQUIRE(get_filesize(TEST_FILENAME) == 90);
+    }
+
+    prepare_logdir();
+    spdlog::file_event_handlers handlers;
+    handlers.durability = spdlog::durability_policy(sync_method::fdatasync, 0,
+                                                    std::chrono::milliseconds(10));
+    file_helper helper{handlers};
+    helper.open(SPDLOG_FILENAME_T(TEST_FILENAME));
+    helper.write(line);
+    REQUIRE(get_filesize(TEST_FILENAME) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    helper.write(line);
+    REQUIRE(get_filesize(TEST_FILENAME) == 20);
+}
+
+#ifdef __linux__
+    #include <sys/stat.h>
+
+static size_t allocated_size(const char *filename) {
+    struct stat st;
+    REQUIRE(::stat(filename, &st) == 0);
+    return static_cast<size_t>(st.st_blocks) * 512;
+}
+
+TEST_CASE("file_helper_preallocate", "[file_helper]") {
+    prepare_logdir();
+    spdlog::filename_t target_filename = SPDLOG_FILENAME_T(TEST_FILENAME);
+    spdlog::file_event_handlers handlers;
+    handlers.preallocate_size = 1024 * 1024;
+    spdlog::memory_buf_t line;
+    spdlog::fmt_lib::format_to(std::back_inserter(line), "{}", std::string(99, 'x') + "\n");
+    {
+        file_helper helper{handlers};
+        helper.open(target_filename);
+        for (int i = 0; i < 20000; i++) {
+            helper.write(line);
+        }
+        helper.flush();
+        // a 2MB file in 1MB chunks
+        REQUIRE(get_filesize(TEST_FILENAME) == 2000000);
+        auto allocated = allocated_size(TEST_FILENAME);
+        if (allocated < 2 * 1024 * 1024) {
+            WARN("fallocate not supported by the file system");
+            return;
+        }
+    }
+    REQUIRE(get_filesize(TEST_FILENAME) == 2000000);
+    REQUIRE(allocated_size(TEST_FILENAME) < 2100000);
+}
+#endif
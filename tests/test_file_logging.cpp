@@ -4,6 +4,11 @@
  */
 #include "includes.h"
 
+#ifndef _WIN32
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
 #define SIMPLE_LOG "test_logs/simple_log"
 #define ROTATING_LOG "test_logs/rotating_log"
 
@@ -101,3 +106,296 @@ TEST_CASE("rotating_file_logger3", "[rotating_logger]") {
     REQUIRE_THROWS_AS(spdlog::rotating_logger_mt("logger", basename, max_size, 0),
                       spdlog::spdlog_ex);
 }
+
+static std::vector<spdlog::details::log_msg> make_batch(std::vector<std::string> &payloads) {
+    std::vector<spdlog::details::log_msg> msgs;
+    for (const auto &payload : payloads) {
+        msgs.emplace_back("logger", spdlog::level::info, payload);
+    }
+    msgs[1].level = spdlog::level::debug;  // filtered out by the sinks
+    return msgs;
+}
+
+TEST_CASE("file sink batch", "[simple_logger]") {
+    prepare_logdir();
+    std::vector<std::string> payloads = {"1", "2", "3", "4"};
+    auto msgs = make_batch(payloads);
+    spdlog::sinks::basic_file_sink_st sink(SPDLOG_FILENAME_T(SIMPLE_LOG));
+    sink.set_pattern("%v");
+    sink.set_level(spdlog::level::info);
+    sink.log_batch(msgs.data(), msgs.size());
+    sink.flush();
+    using spdlog::details::os::default_eol;
+    REQUIRE(file_contents(SIMPLE_LOG) ==
+            spdlog::fmt_lib::format("1{}3{}4{}", default_eol, default_eol, default_eol));
+}
+
+TEST_CASE("rotating file sink batch", "[rotating_logger]") {
+    prepare_logdir();
+    std::vector<std::string> payloads;
+    for (int i = 0; i < 10; i++) {
+        payloads.push_back(std::string(9, static_cast<char>('0' + i)));
+    }
+    auto msgs = make_batch(payloads);
+    using spdlog::details::os::default_eol;
+    auto line_size = 9 + std::strlen(default_eol);
+    spdlog::filename_t basename = SPDLOG_FILENAME_T(ROTATING_LOG);
+    spdlog::sinks::rotating_file_sink_st sink(basename, 4 * line_size, 2);
+    sink.set_pattern("%v");
+    sink.set_level(spdlog::level::info);
+    sink.log_batch(msgs.data(), msgs.size());
+    sink.flush();
+
+    // 9 lines logged: 1 in the current file, 4 in each rotated one
+    auto line = [&](char c) { return std::string(9, c) + default_eol; };
+    REQUIRE(file_contents(ROTATING_LOG) == line('9'));
+    REQUIRE(file_contents(spdlog::details::os::filename_to_str(
+                spdlog::sinks::rotating_file_sink_st::calc_filename(basename, 1))) ==
+            line('5') + line('6') + line('7') + line('8'));
+    REQUIRE(file_contents(spdlog::details::os::filename_to_str(
+                spdlog::sinks::rotating_file_sink_st::calc_filename(basename, 2))) ==
+            line('0') + line('2') + line('3') + line('4'));
+}
+
+TEST_CASE("rotating file sink size check", "[rotating_logger]") {
+    prepare_logdir();
+    using spdlog::details::os::default_eol;
+    auto line_size = 9 + std::strlen(default_eol);
+    spdlog::sinks::rotating_file_sink_st sink(SPDLOG_FILENAME_T(ROTATING_LOG), 4 * line_size, 2);
+    sink.set_pattern("%v");
+    sink.set_size_check_interval(std::chrono::seconds(1));
+    std::string payload(9, 'a');
+    spdlog::details::log_msg msg("logger", spdlog::level::info, payload);
+    auto start = msg.time;
+    for (int i = 0; i < 3; i++) {
+        sink.log(msg);
+    }
+    sink.flush();
+    // truncated by another process, as logrotate's copytruncate does
+    std::fclose(std::fopen(ROTATING_LOG, "w"));
+
+    // not seen before the interval elapsed
+    sink.log(msg);
+    sink.flush();
+    REQUIRE(get_filesize(ROTATING_LOG) == line_size);
+
+    // 2 more lines would have made the count reach 6 lines and rotate
+    msg.time = start + std::chrono::seconds(2);
+    for (int i = 0; i < 2; i++) {
+        sink.log(msg);
+    }
+    sink.flush();
+    REQUIRE(count_files("test_logs") == 1);
+    REQUIRE(get_filesize(ROTATING_LOG) == 3 * line_size);
+}
+
+TEST_CASE("rotating file sink rotation interval", "[rotating_logger]") {
+    prepare_logdir();
+    using spdlog::details::os::default_eol;
+    spdlog::filename_t basename = SPDLOG_FILENAME_T(ROTATING_LOG);
+    spdlog::sinks::rotating_file_sink_st sink(basename, 1024 * 1024, 2);
+    sink.set_pattern("%v");
+    sink.set_rotation_interval(std::chrono::hours(1));
+    std::string first = "first", second = "second";
+    spdlog::details::log_msg msg("logger", spdlog::level::info, first);
+    sink.log(msg);
+    sink.log(msg);
+    msg.time += std::chrono::hours(1);
+    msg.payload = second;
+    sink.log(msg);
+    sink.flush();
+    REQUIRE(file_contents(ROTATING_LOG) == second + default_eol);
+    REQUIRE(file_contents(spdlog::details::os::filename_to_str(
+                spdlog::sinks::rotating_file_sink_st::calc_filename(basename, 1))) ==
+            first + default_eol + first + default_eol);
+}
+
+TEST_CASE("rotating file sink total size", "[rotating_logger]") {
+    prepare_logdir();
+    using spdlog::details::os::default_eol;
+    auto line_size = 9 + std::strlen(default_eol);
+    spdlog::filename_t basename = SPDLOG_FILENAME_T(ROTATING_LOG);
+    for (auto naming : {spdlog::sinks::rotation_naming::shift,
+                        spdlog::sinks::rotation_naming::increasing}) {
+        prepare_logdir();
+        {
+            spdlog::sinks::rotating_file_sink_st sink(basename, 2 * line_size, 10, false, {},
+                                                      false, naming);
+            sink.set_pattern("%v");
+            // room for the current file and one full file and a half
+            sink.set_max_total_size(7 * line_size / 2 + 2 * line_size);
+            for (int i = 0; i < 12; i++) {
+                std::string payload(9, static_cast<char>('a' + i));
+                sink.log(spdlog::details::log_msg("logger", spdlog::level::info, payload));
+            }
+        }
+        REQUIRE(count_files("test_logs") == 2);
+    }
+}
+
+TEST_CASE("file sink index", "[simple_logger]") {
+    prepare_logdir();
+    using spdlog::details::os::default_eol;
+    auto line_size = 4 + std::strlen(default_eol);
+    spdlog::filename_t filename = SPDLOG_FILENAME_T(SIMPLE_LOG);
+    spdlog::file_event_handlers handlers;
+    handlers.index = spdlog::file_index_policy(2);
+    auto start = spdlog::log_clock::now();
+    {
+        spdlog::sinks::basic_file_sink_st sink(filename, false, handlers);
+        sink.set_pattern("%v");
+        for (int i = 0; i < 10; i++) {
+            std::string payload = "msg" + std::to_string(i);
+            spdlog::details::log_msg msg("logger", spdlog::level::info, payload);
+            msg.time = start + std::chrono::seconds(i);
+            sink.log(msg);
+        }
+    }
+    REQUIRE(count_files("test_logs") == 2);
+    // a record for the messages 0, 2, 4..
+    REQUIRE(spdlog::log_file_offset(filename, start + std::chrono::milliseconds(5500)) ==
+            4 * line_size);
+    REQUIRE(spdlog::log_file_offset(filename, start + std::chrono::seconds(4)) == 2 * line_size);
+    REQUIRE(spdlog::log_file_offset(filename, start) == 0);
+    REQUIRE(spdlog::log_file_offset(filename, start + std::chrono::hours(1)) == 8 * line_size);
+    REQUIRE(spdlog::log_file_offset(SPDLOG_FILENAME_T("test_logs/missing"), start) == 0);
+}
+
+#ifndef _WIN32
+TEST_CASE("file sink atomic records", "[simple_logger]") {
+    prepare_logdir();
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    // longer than the stdio buffer, which would split them
+    const size_t record_size = 6000;
+    const int records = 200;
+    std::vector<pid_t> pids;
+    for (char c : {'a', 'b'}) {
+        auto pid = ::fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            spdlog::file_event_handlers handlers;
+            handlers.atomic_records = true;
+            spdlog::sinks::basic_file_sink_st sink(SPDLOG_FILENAME_T(SIMPLE_LOG), false, handlers);
+            sink.set_pattern("%v");
+            std::string payload(record_size, c);
+            for (int i = 0; i < records; i++) {
+                sink.log(spdlog::details::log_msg("logger", spdlog::level::info, payload));
+            }
+            ::_exit(0);
+        }
+        pids.push_back(pid);
+    }
+    for (auto pid : pids) {
+        int status = 0;
+        REQUIRE(::waitpid(pid, &status, 0) == pid);
+        REQUIRE(WIFEXITED(status));
+    }
+
+    std::istringstream contents(file_contents(SIMPLE_LOG));
+    std::string line;
+    int lines = 0;
+    while (std::getline(contents, line)) {
+        REQUIRE(line.size() == record_size);
+        REQUIRE(line.find_first_not_of(line[0]) == std::string::npos);
+        lines++;
+    }
+    REQUIRE(lines == 2 * records);
+}
+#endif
+
+TEST_CASE("rotating_file_logger_background", "[rotating_logger]") {
+    prepare_logdir();
+    using spdlog::details::os::default_eol;
+    auto line_size = 9 + std::strlen(default_eol);
+    spdlog::filename_t basename = SPDLOG_FILENAME_T(ROTATING_LOG);
+    {
+        auto logger = spdlog::rotating_logger_st("logger", basename, 4 * line_size, 2, false, {},
+                                                 true);
+        logger->set_pattern("%v");
+        for (int i = 0; i < 17; i++) {
+            logger->info(std::string(9, static_cast<char>('a' + i)));
+        }
+        // the new file is used at once
+        logger->flush();
+        REQUIRE(get_filesize(ROTATING_LOG) == line_size);
+        spdlog::drop_all();
+    }
+
+    // the renames are done when the sink is destroyed
+    auto line = [&](char c) { return std::string(9, c) + default_eol; };
+    REQUIRE(count_files("test_logs") == 3);
+    REQUIRE(file_contents(ROTATING_LOG) == line('q'));
+    REQUIRE(file_contents(spdlog::details::os::filename_to_str(
+                spdlog::sinks::rotating_file_sink_st::calc_filename(basename, 1))) ==
+            line('m') + line('n') + line('o') + line('p'));
+    REQUIRE(file_contents(spdlog::details::os::filename_to_str(
+                spdlog::sinks::rotating_file_sink_st::calc_filename(basename, 2))) ==
+            line('i') + line('j') + line('k') + line('l'));
+}
+
+TEST_CASE("rotating_file_logger_increasing", "[rotating_logger]") {
+    prepare_logdir();
+    using spdlog::details::os::default_eol;
+    using spdlog::sinks::rotating_file_sink_st;
+    auto line_size = 9 + std::strlen(default_eol);
+    spdlog::filename_t basename = SPDLOG_FILENAME_T(ROTATING_LOG);
+    auto rotated = [&](size_t index) {
+        return spdlog::details::os::filename_to_str(
+            rotating_file_sink_st::calc_filename(basename, index));
+    };
+    auto line = [&](char c) { return std::string(9, c) + default_eol; };
+    // left by a previous run: 1 is too old to keep
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    std::fclose(std::fopen(rotated(1).c_str(), "w"));
+    std::fclose(std::fopen(rotated(7).c_str(), "w"));
+    {
+        auto sink = std::make_shared<rotating_file_sink_st>(
+            basename, 2 * line_size, 2, false, spdlog::file_event_handlers{}, false,
+            spdlog::sinks::rotation_naming::increasing);
+        spdlog::logger logger("logger", sink);
+        logger.set_pattern("%v");
+        for (int i = 0; i < 7; i++) {
+            logger.info(std::string(9, static_cast<char>('a' + i)));
+        }
+    }
+    REQUIRE(count_files("test_logs") == 3);
+    REQUIRE(file_contents(ROTATING_LOG) == line('g'));
+    REQUIRE(file_contents(rotated(10)) == line('e') + line('f'));
+    REQUIRE(file_contents(rotated(9)) == line('c') + line('d'));
+}
+
+TEST_CASE("shared file sinks", "[simple_logger]") {
+    prepare_logdir();
+    spdlog::filename_t filename = SPDLOG_FILENAME_T(SIMPLE_LOG);
+    spdlog::filename_t other_filename = SPDLOG_FILENAME_T(ROTATING_LOG);
+    spdlog::set_sink_sharing(true);
+
+    auto logger1 = spdlog::basic_logger_mt("shared1", filename);
+    auto logger2 = spdlog::basic_logger_mt("shared2", filename, true);
+    auto other = spdlog::basic_logger_mt("shared3", other_filename);
+    auto rotating = spdlog::rotating_logger_mt("shared4", filename, 1024, 1);
+    REQUIRE(logger1->sinks()[0] == logger2->sinks()[0]);
+    REQUIRE(logger1->sinks()[0] != other->sinks()[0]);
+    REQUIRE(logger1->sinks()[0] != rotating->sinks()[0]);  // another sink type
+
+    logger1->set_pattern("%v");
+    logger1->info("Test message {}", 1);
+    logger2->info("Test message {}", 2);
+    logger2->flush();
+    require_message_count(SIMPLE_LOG, 2);
+
+    // a new sink once the loggers are gone
+    std::weak_ptr<spdlog::sinks::sink> sink = logger1->sinks()[0];
+    spdlog::drop_all();
+    logger1.reset();
+    logger2.reset();
+    REQUIRE(sink.expired());
+    auto logger3 = spdlog::basic_logger_mt("shared1", filename);
+    auto logger4 = spdlog::basic_logger_mt("shared2", filename);
+    REQUIRE(logger3->sinks()[0] == logger4->sinks()[0]);
+
+    spdlog::set_sink_sharing(false);
+    auto logger5 = spdlog::basic_logger_mt("shared5", filename);
+    REQUIRE(logger5->sinks()[0] != logger3->sinks()[0]);
+    spdlog::drop_all();
+}
@@ -0,0 +1,49 @@
+/*
+ * This content is released under the MIT License as specified in
+ * https://raw.githubusercontent.com/gabime/spdlog/master/LICENSE
+ */
+
+#define SPDLOG_USE_FMT_COMPILE
+#include "includes.h"
+#include "test_sink.h"
+
+TEST_CASE("compiled format string macros", "[fmt_compile]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    spdlog::logger logger("fmt_compile", test_sink);
+    logger.set_pattern("%v");
+    logger.set_level(spdlog::level::trace);
+
+    SPDLOG_LOGGER_DEBUG(&logger, "no args");
+    SPDLOG_LOGGER_INFO(&logger, "{} + {} = {:>4}", 1, 2.5, "3.5");
+    SPDLOG_LOGGER_WARN(&logger, "{{escaped}} {}", std::string("braces"));
+    SPDLOG_LOGGER_TRACE(&logger, "compiled out");
+
+    logger.set_level(spdlog::level::err);
+    SPDLOG_LOGGER_WARN(&logger, "filtered {}", 1);
+
+    REQUIRE(test_sink->lines() ==
+            std::vector<std::string>{"no args", "1 + 2.5 =  3.5", "{escaped} braces"});
+}
+
+TEST_CASE("compiled format string source location", "[fmt_compile]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    auto logger = std::make_shared<spdlog::logger>("fmt_compile", test_sink);
+    logger->set_pattern("%s:%# %v");
+
+    SPDLOG_LOGGER_INFO(logger, "line {}", __LINE__);
+    auto line = std::to_string(__LINE__ - 1);
+    REQUIRE(test_sink->lines()[0] == "test_fmt_compile.cpp:" + line + " line " + line);
+}
+
+TEST_CASE("compiled format string logger api", "[fmt_compile]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    spdlog::logger logger("fmt_compile", test_sink);
+    logger.set_pattern("%v");
+
+    logger.info(FMT_COMPILE("{:04}"), 42);
+    logger.error(FMT_COMPILE("no args"));
+    logger.log(spdlog::level::warn, FMT_COMPILE("{}-{}"), 'a', 'b');
+    logger.debug(FMT_COMPILE("filtered {}"), 1);
+
+    REQUIRE(test_sink->lines() == std::vector<std::string>{"0042", "no args", "a-b"});
+}
@@ -65,6 +65,8 @@ TEST_CASE("pad6", "[fmt_helper]") {
     test_pad6(1234, "001234");
     test_pad6(12345, "012345");
     test_pad6(123456, "123456");
+    test_pad6(999999, "999999");
+    test_pad6(1000000, "1000000");
 }
 
 TEST_CASE("pad9", "[fmt_helper]") {
@@ -78,5 +80,7 @@ TEST_CASE("pad9", "[fmt_helper]") {
     test_pad9(1234567, "001234567");
     test_pad9(12345678, "012345678");
     test_pad9(123456789, "123456789");
+    test_pad9(905060708, "905060708");
+    test_pad9(999999999, "999999999");
     test_pad9(1234567891, "1234567891");
 }
@@ -0,0 +1,166 @@
+#include "includes.h"
+#include "spdlog/sinks/journal_sink.h"
+
+#include <thread>
+
+namespace {
+const spdlog::filename_t journal_filename = SPDLOG_FILENAME_T("test_logs/audit.journal");
+
+// keeps the payloads, throwing while failing
+class flaky_sink final : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    std::atomic<bool> failing{false};
+
+    std::vector<std::string> payloads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return payloads_;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override {
+        if (failing) {
+            throw spdlog::spdlog_ex("flaky_sink: failing");
+        }
+        payloads_.emplace_back(msg.payload.data(), msg.payload.size());
+    }
+    void flush_() override {}
+
+private:
+    std::vector<std::string> payloads_;
+};
+
+spdlog::sinks::journal_sink_config test_config(size_t capacity = 64 * 1024) {
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    spdlog::details::os::remove(journal_filename);
+    spdlog::sinks::journal_sink_config cfg(journal_filename);
+    cfg.capacity = capacity;
+    cfg.sync = false;
+    cfg.retry_min_delay = std::chrono::milliseconds(1);
+    cfg.retry_max_delay = std::chrono::milliseconds(5);
+    return cfg;
+}
+
+std::vector<std::string> numbers(int first, int last) {
+    std::vector<std::string> ret;
+    for (int i = first; i < last; i++) {
+        ret.push_back(std::to_string(i));
+    }
+    return ret;
+}
+}  // namespace
+
+TEST_CASE("journal_sink delivers and commits", "[journal_sink]") {
+    auto cfg = test_config();
+    cfg.sync = true;
+    auto downstream = std::make_shared<flaky_sink>();
+    {
+        auto sink = std::make_shared<spdlog::sinks::journal_sink_mt>(downstream, cfg);
+        spdlog::logger logger("audit", sink);
+        for (int i = 0; i < 100; i++) {
+            logger.info("{}", i);
+        }
+        logger.flush();
+        REQUIRE(downstream->payloads() == numbers(0, 100));
+        REQUIRE(sink->pending_bytes() == 0);
+    }
+    REQUIRE(get_filesize(journal_filename) == 4096 + 64 * 1024);
+
+    // nothing to replay
+    auto next = std::make_shared<flaky_sink>();
+    spdlog::sinks::journal_sink_mt sink(next, cfg);
+    sink.flush();
+    REQUIRE(next->payloads().empty());
+}
+
+TEST_CASE("journal_sink wraps around", "[journal_sink]") {
+    auto downstream = std::make_shared<flaky_sink>();
+    auto sink = std::make_shared<spdlog::sinks::journal_sink_mt>(downstream, test_config(4096));
+    spdlog::logger logger("audit", sink);
+    for (int i = 0; i < 2000; i++) {
+        logger.info("{}", i);
+    }
+    logger.flush();
+    REQUIRE(downstream->payloads() == numbers(0, 2000));
+}
+
+TEST_CASE("journal_sink replays what was not committed", "[journal_sink]") {
+    auto cfg = test_config();
+    auto failing = std::make_shared<flaky_sink>();
+    failing->failing = true;
+    {
+        auto sink = std::make_shared<spdlog::sinks::journal_sink_mt>(failing, cfg);
+        spdlog::logger logger("audit", sink);
+        for (int i = 0; i < 50; i++) {
+            logger.info("{}", i);
+        }
+        logger.flush();  // returns once the downstream sink threw
+        REQUIRE(sink->pending_bytes() > 0);
+    }
+    REQUIRE(failing->payloads().empty());
+
+    auto downstream = std::make_shared<flaky_sink>();
+    auto sink = std::make_shared<spdlog::sinks::journal_sink_mt>(downstream, cfg);
+    spdlog::logger logger("audit", sink);
+    logger.info("50");
+    logger.flush();
+    REQUIRE(downstream->payloads() == numbers(0, 51));
+}
+
+TEST_CASE("journal_sink retries the downstream sink", "[journal_sink]") {
+    auto downstream = std::make_shared<flaky_sink>();
+    downstream->failing = true;
+    auto sink = std::make_shared<spdlog::sinks::journal_sink_mt>(downstream, test_config());
+    spdlog::logger logger("audit", sink);
+    for (int i = 0; i < 10; i++) {
+        logger.info("{}", i);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    downstream->failing = false;
+    for (int i = 0; i < 500 && sink->pending_bytes() > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(downstream->payloads() == numbers(0, 10));
+}
+
+TEST_CASE("journal_sink ignores a partial record", "[journal_sink]") {
+    auto cfg = test_config();
+    auto failing = std::make_shared<flaky_sink>();
+    failing->failing = true;
+    {
+        auto sink = std::make_shared<spdlog::sinks::journal_sink_mt>(failing, cfg);
+        spdlog::logger logger("audit", sink);
+        logger.info("complete");
+        logger.info("torn");
+        logger.flush();
+    }
+    // corrupt the last byte of the second record's stream
+    {
+        std::FILE *file = std::fopen("test_logs/audit.journal", "r+b");
+        REQUIRE(file != nullptr);
+        spdlog::sinks::details_journal::record_header header;
+        std::fseek(file, 4096, SEEK_SET);
+        REQUIRE(std::fread(&header, sizeof(header), 1, file) == 1);
+        auto second = 4096 + spdlog::sinks::details_journal::align8(sizeof(header) + header.size);
+        std::fseek(file, static_cast<long>(second), SEEK_SET);
+        REQUIRE(std::fread(&header, sizeof(header), 1, file) == 1);
+        std::fseek(file, static_cast<long>(second + sizeof(header) + header.size - 1), SEEK_SET);
+        std::fputc('x', file);
+        std::fclose(file);
+    }
+    auto downstream = std::make_shared<flaky_sink>();
+    spdlog::sinks::journal_sink_mt sink(downstream, cfg);
+    sink.flush();
+    REQUIRE(downstream->payloads() == std::vector<std::string>{"complete"});
+}
+
+TEST_CASE("journal_sink rejects other files", "[journal_sink]") {
+    auto cfg = test_config();
+    {
+        std::FILE *file = std::fopen("test_logs/audit.journal", "wb");
+        REQUIRE(file != nullptr);
+        std::fputs("not a journal", file);
+        std::fclose(file);
+    }
+    REQUIRE_THROWS_AS(spdlog::sinks::journal_sink_mt(std::make_shared<flaky_sink>(), cfg),
+                      spdlog::spdlog_ex);
+}
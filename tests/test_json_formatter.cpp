@@ -0,0 +1,77 @@
+#include "includes.h"
+
+using spdlog::memory_buf_t;
+using spdlog::details::to_string_view;
+
+static std::string format_json(spdlog::formatter &formatter,
+                               const spdlog::details::log_msg &msg) {
+    memory_buf_t formatted;
+    formatter.format(msg, formatted);
+    return std::string(formatted.data(), formatted.size());
+}
+
+static spdlog::log_clock::time_point test_time(std::chrono::milliseconds since_epoch) {
+    return spdlog::log_clock::time_point(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(since_epoch));
+}
+
+TEST_CASE("json formatter", "[json_formatter]") {
+    spdlog::json_formatter formatter(spdlog::pattern_time_type::utc, "\n");
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::warn,
+                                 "some message");
+    msg.time = test_time(std::chrono::milliseconds(1700000000123));
+    msg.thread_id = 42;
+    REQUIRE(format_json(formatter, msg) ==
+            "{\"time\":\"2023-11-14T22:13:20.123Z\",\"level\":\"warning\",\"logger\":\"logger-"
+            "name\",\"thread\":42,\"message\":\"some message\"}\n");
+
+    spdlog::details::log_msg msg_with_source(spdlog::source_loc{"dir/file.cpp", 12, "func"},
+                                             "logger-name", spdlog::level::info, "msg");
+    msg_with_source.time = test_time(std::chrono::milliseconds(1700000001005));
+    msg_with_source.thread_id = 42;
+    REQUIRE(format_json(formatter, msg_with_source) ==
+            "{\"time\":\"2023-11-14T22:13:21.005Z\",\"level\":\"info\",\"logger\":\"logger-"
+            "name\",\"thread\":42,\"source\":{\"file\":\"dir/file.cpp\",\"line\":12,"
+            "\"function\":\"func\"},\"message\":\"msg\"}\n");
+
+    auto cloned = formatter.clone();
+    REQUIRE(format_json(*cloned, msg) == format_json(formatter, msg));
+}
+
+TEST_CASE("json formatter escapes", "[json_formatter]") {
+    spdlog::json_formatter formatter(spdlog::pattern_time_type::utc, "");
+    std::string payload = "a \"quoted\" back\\slash\n\ttab \x01 and some longer clean text";
+    payload += std::string(1, '\0') + "\x1f\x7f utf8: \xc3\xa9";
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "name\"", spdlog::level::info, payload);
+    auto formatted = format_json(formatter, msg);
+    REQUIRE(formatted.find("\"logger\":\"name\\\"\"") != std::string::npos);
+    auto message = formatted.substr(formatted.find("\"message\":"));
+    REQUIRE(message ==
+            "\"message\":\"a \\\"quoted\\\" back\\\\slash\\n\\ttab \\u0001 and some longer clean "
+            "text\\u0000\\u001f\x7f utf8: \xc3\xa9\"}");
+
+    // chars to escape at every position of the scanned blocks
+    for (size_t i = 0; i < 40; i++) {
+        std::string text(40, 'x');
+        text[i] = '"';
+        spdlog::details::log_msg quote_msg(spdlog::source_loc{}, "", spdlog::level::info, text);
+        auto expected = std::string(i, 'x') + "\\\"" + std::string(39 - i, 'x');
+        auto quote_formatted = format_json(formatter, quote_msg);
+        REQUIRE(quote_formatted.substr(quote_formatted.find("\"message\":")) ==
+                "\"message\":\"" + expected + "\"}");
+    }
+}
+
+#ifndef SPDLOG_NO_TLS
+TEST_CASE("json formatter mdc", "[json_formatter]") {
+    spdlog::mdc::put("key1", "value1");
+    spdlog::mdc::put("key\"2", "value\n2");
+    spdlog::json_formatter formatter(spdlog::pattern_time_type::local, "");
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::info,
+                                 "some message");
+    auto formatted = format_json(formatter, msg);
+    REQUIRE(formatted.find(",\"mdc\":{\"key\\\"2\":\"value\\n2\",\"key1\":\"value1\"},") !=
+            std::string::npos);
+    spdlog::mdc::clear();
+}
+#endif
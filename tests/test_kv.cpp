@@ -0,0 +1,107 @@
+#include "includes.h"
+#include "test_sink.h"
+
+using spdlog::memory_buf_t;
+
+static std::string format_kv(spdlog::formatter &formatter, const spdlog::details::log_msg &msg) {
+    memory_buf_t formatted;
+    formatter.format(msg, formatted);
+    return std::string(formatted.data(), formatted.size());
+}
+
+static spdlog::details::log_msg kv_msg(const spdlog::kv_field *fields, size_t count) {
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "kv", spdlog::level::info, "done");
+    msg.time = spdlog::log_clock::time_point(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(
+            std::chrono::milliseconds(1700000000123)));
+    msg.thread_id = 42;
+    msg.kv_fields = fields;
+    msg.kv_count = count;
+    return msg;
+}
+
+TEST_CASE("kv fields", "[kv]") {
+    std::string path = "/users";
+    const spdlog::kv_field fields[] = {spdlog::kv("status", 200), spdlog::kv("path", path),
+                                       spdlog::kv("bytes", 1234567890123ull),
+                                       spdlog::kv("ratio", 0.25), spdlog::kv("cached", true),
+                                       spdlog::kv("delta", -3)};
+    REQUIRE(fields[0].type == spdlog::kv_type::int64);
+    REQUIRE(fields[1].type == spdlog::kv_type::string);
+    REQUIRE(fields[2].type == spdlog::kv_type::uint64);
+    REQUIRE(fields[3].type == spdlog::kv_type::float64);
+    REQUIRE(fields[4].type == spdlog::kv_type::boolean);
+    auto msg = kv_msg(fields, 6);
+
+    spdlog::pattern_formatter pattern("%v [%&]", spdlog::pattern_time_type::utc, "");
+    REQUIRE(format_kv(pattern, msg) ==
+            "done [status:200 path:/users bytes:1234567890123 ratio:0.25 cached:true delta:-3]");
+
+    spdlog::json_formatter json(spdlog::pattern_time_type::utc, "");
+    REQUIRE(format_kv(json, msg) ==
+            "{\"time\":\"2023-11-14T22:13:20.123Z\",\"level\":\"info\",\"logger\":\"kv\","
+            "\"thread\":42,\"fields\":{\"status\":200,\"path\":\"/users\",\"bytes\":"
+            "1234567890123,\"ratio\":0.25,\"cached\":true,\"delta\":-3},\"message\":\"done\"}");
+
+    spdlog::logfmt_formatter logfmt(spdlog::pattern_time_type::utc, "");
+    auto line = format_kv(logfmt, msg);
+    REQUIRE(line.substr(line.find(" level=")) ==
+            " level=info logger=kv msg=done status=200 path=/users bytes=1234567890123 "
+            "ratio=0.25 cached=true delta=-3");
+}
+
+TEST_CASE("kv binary round trip", "[kv]") {
+    const spdlog::kv_field fields[] = {spdlog::kv("status", 200), spdlog::kv("path", "/users"),
+                                       spdlog::kv("ratio", 0.25), spdlog::kv("cached", false),
+                                       spdlog::kv("delta", -3)};
+    spdlog::binary_formatter formatter;
+    memory_buf_t binary;
+    formatter.format(kv_msg(fields, 5), binary);
+    formatter.format(kv_msg(nullptr, 0), binary);
+
+    spdlog::binary_log_reader reader(spdlog::string_view_t(binary.data(), binary.size()));
+    spdlog::details::log_msg msg;
+    REQUIRE(reader.next(msg));
+    REQUIRE(msg.kv_count == 5);
+    REQUIRE(msg.kv_fields[0].key == spdlog::string_view_t("status"));
+    REQUIRE(msg.kv_fields[0].int_value == 200);
+    REQUIRE(msg.kv_fields[1].string_value == spdlog::string_view_t("/users"));
+    REQUIRE(msg.kv_fields[2].float_value == 0.25);
+    REQUIRE(msg.kv_fields[3].type == spdlog::kv_type::boolean);
+    REQUIRE_FALSE(msg.kv_fields[3].bool_value);
+    REQUIRE(msg.kv_fields[4].int_value == -3);
+    REQUIRE(reader.next(msg));
+    REQUIRE(msg.kv_count == 0);
+    REQUIRE_FALSE(reader.next(msg));
+}
+
+TEST_CASE("kv logger", "[kv]") {
+    auto sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    sink->set_pattern("%v [%&]");
+    spdlog::logger logger("kv", sink);
+    logger.info("request done", spdlog::kv("latency_us", 42), spdlog::kv("status", 200));
+    logger.warn("{} text", "formatted");
+    logger.debug("filtered", spdlog::kv("k", 1));
+    REQUIRE(sink->lines() ==
+            std::vector<std::string>{"request done [latency_us:42 status:200]",
+                                     "formatted text []"});
+
+    // the async loggers and the backtrace copy the fields with the message
+    auto async_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    async_sink->set_pattern("%v [%&]");
+    {
+        auto tp = std::make_shared<spdlog::details::thread_pool>(16, 1);
+        auto async_logger = std::make_shared<spdlog::async_logger>("as", async_sink, tp);
+        async_logger->enable_backtrace(4);
+        std::string value = "temporary";
+        async_logger->debug("traced", spdlog::kv("value", value));
+        value = "changed";
+        async_logger->info("async", spdlog::kv("value", std::string(64, 'x')));
+        async_logger->dump_backtrace();
+        async_logger->flush();
+    }
+    auto lines = async_sink->lines();
+    REQUIRE(lines.size() == 5);  // async, then the backtrace of traced and async
+    REQUIRE(lines[0] == "async [value:" + std::string(64, 'x') + "]");
+    REQUIRE(lines[2] == "traced [value:temporary]");
+}
@@ -0,0 +1,57 @@
+#include "includes.h"
+
+using spdlog::memory_buf_t;
+
+static std::string format_logfmt(spdlog::formatter &formatter,
+                                 const spdlog::details::log_msg &msg) {
+    memory_buf_t formatted;
+    formatter.format(msg, formatted);
+    return std::string(formatted.data(), formatted.size());
+}
+
+TEST_CASE("logfmt formatter", "[logfmt_formatter]") {
+    spdlog::logfmt_formatter formatter(spdlog::pattern_time_type::utc, "\n");
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::warn,
+                                 "some message");
+    msg.time = spdlog::log_clock::time_point(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(
+            std::chrono::milliseconds(1700000000123)));
+    REQUIRE(format_logfmt(formatter, msg) ==
+            "ts=2023-11-14T22:13:20.123Z level=warning logger=logger-name msg=\"some message\"\n");
+
+    spdlog::details::log_msg plain_msg(spdlog::source_loc{}, "", spdlog::level::info, "plain");
+    plain_msg.time = msg.time;
+    REQUIRE(format_logfmt(formatter, plain_msg) ==
+            "ts=2023-11-14T22:13:20.123Z level=info logger=\"\" msg=plain\n");
+
+    auto cloned = formatter.clone();
+    REQUIRE(format_logfmt(*cloned, msg) == format_logfmt(formatter, msg));
+}
+
+TEST_CASE("logfmt formatter quoting", "[logfmt_formatter]") {
+    spdlog::logfmt_formatter formatter(spdlog::pattern_time_type::utc, "");
+    auto msg_of = [&](const char *payload) {
+        spdlog::details::log_msg msg(spdlog::source_loc{}, "l", spdlog::level::info, payload);
+        auto formatted = format_logfmt(formatter, msg);
+        return formatted.substr(formatted.find(" msg=") + 5);
+    };
+    REQUIRE(msg_of("key=value") == "\"key=value\"");
+    REQUIRE(msg_of("say \"hi\"") == "\"say \\\"hi\\\"\"");
+    REQUIRE(msg_of("back\\slash") == "\"back\\\\slash\"");
+    REQUIRE(msg_of("two\nlines\t\x01") == "\"two\\nlines\\t\\u0001\"");
+    REQUIRE(msg_of("utf8:\xc3\xa9") == "utf8:\xc3\xa9");
+}
+
+#ifndef SPDLOG_NO_TLS
+TEST_CASE("logfmt formatter mdc", "[logfmt_formatter]") {
+    spdlog::mdc::put("request_id", "42");
+    spdlog::mdc::put("user name", "John Doe");
+    spdlog::logfmt_formatter formatter(spdlog::pattern_time_type::local, "");
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::info,
+                                 "some message");
+    auto formatted = format_logfmt(formatter, msg);
+    REQUIRE(formatted.substr(formatted.find(" msg=")) ==
+            " msg=\"some message\" request_id=42 user_name=\"John Doe\"");
+    spdlog::mdc::clear();
+}
+#endif
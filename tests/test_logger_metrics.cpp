@@ -0,0 +1,102 @@
+#include "includes.h"
+#include "test_sink.h"
+
+using spdlog::sinks::test_sink_mt;
+
+TEST_CASE("latency snapshot", "[metrics]") {
+    using spdlog::latency_snapshot;
+    REQUIRE(latency_snapshot::bucket_of(3) == 3);
+    REQUIRE(latency_snapshot::bucket_of(4) == 4);
+    REQUIRE(latency_snapshot::bucket_of(9) == 8);  // [8, 10)
+    REQUIRE(latency_snapshot::bucket_of(10) == 9);
+    REQUIRE(latency_snapshot::upper_bound(8) == std::chrono::nanoseconds(10));
+    REQUIRE(latency_snapshot::bucket_of(UINT64_MAX) == latency_snapshot::buckets_n - 1);
+
+    spdlog::details::latency_histogram histogram;
+    histogram.record(std::chrono::nanoseconds(1));
+    histogram.record(std::chrono::nanoseconds(100), 2);  // [96, 112)
+    histogram.record(std::chrono::microseconds(10));     // [8192, 10240)
+    histogram.record(std::chrono::nanoseconds(-5));      // as 0
+    auto snapshot = histogram.snapshot();
+    REQUIRE(snapshot.count == 5);
+    REQUIRE(snapshot.buckets[0] == 1);
+    REQUIRE(snapshot.buckets[1] == 1);
+    REQUIRE(snapshot.buckets[latency_snapshot::bucket_of(100)] == 2);
+    REQUIRE(snapshot.buckets[latency_snapshot::bucket_of(10000)] == 1);
+    REQUIRE(snapshot.total_ns == 10201);
+    REQUIRE(snapshot.mean() == std::chrono::nanoseconds(2040));
+    REQUIRE(snapshot.percentile(0.5) == std::chrono::nanoseconds(112));
+    REQUIRE(snapshot.percentile(1.0) == std::chrono::nanoseconds(10240));
+
+    histogram.reset();
+    REQUIRE(histogram.snapshot().count == 0);
+    REQUIRE(histogram.snapshot().percentile(0.99) == std::chrono::nanoseconds(0));
+}
+
+TEST_CASE("logger metrics", "[metrics]") {
+    auto sink = std::make_shared<test_sink_mt>();
+    auto warn_sink = std::make_shared<test_sink_mt>();
+    warn_sink->set_level(spdlog::level::warn);
+    spdlog::logger logger("metrics", {sink, warn_sink});
+    logger.info("not counted");
+    REQUIRE_FALSE(logger.metrics_enabled());
+    REQUIRE(logger.metrics_snapshot().sinks.empty());
+
+    logger.enable_metrics();
+    logger.enable_metrics();
+    REQUIRE(logger.metrics_enabled());
+    logger.info("hello {}", 1);
+    logger.info("hello");
+    logger.warn("{}", "abc");
+    logger.debug("filtered");
+
+    auto metrics = logger.metrics_snapshot();
+    REQUIRE(metrics.messages[spdlog::level::info] == 2);
+    REQUIRE(metrics.messages[spdlog::level::warn] == 1);
+    REQUIRE(metrics.messages[spdlog::level::debug] == 0);
+    REQUIRE(metrics.formatted_bytes == 7 + 5 + 3);
+    REQUIRE(metrics.format_time.count == 2);  // the 2 formatted payloads
+    REQUIRE(metrics.sinks.size() == 2);
+    REQUIRE(metrics.sinks[0].sink == sink);
+    REQUIRE(metrics.sinks[0].write_time.count == 3);
+    REQUIRE(metrics.sinks[1].write_time.count == 1);
+
+    // the copies don't share the metrics
+    spdlog::logger copy(logger);
+    REQUIRE_FALSE(copy.metrics_enabled());
+    REQUIRE_FALSE(logger.clone("clone")->metrics_enabled());
+
+    logger.reset_metrics();
+    metrics = logger.metrics_snapshot();
+    REQUIRE(metrics.messages[spdlog::level::info] == 0);
+    REQUIRE(metrics.formatted_bytes == 0);
+    REQUIRE(metrics.sinks[0].write_time.count == 0);
+
+    // a sink added after enable_metrics() isn't timed
+    logger.sinks().push_back(std::make_shared<test_sink_mt>());
+    logger.error("error");
+    metrics = logger.metrics_snapshot();
+    REQUIRE(metrics.sinks.size() == 2);
+    REQUIRE(metrics.sinks[0].write_time.count == 1);
+}
+
+TEST_CASE("async logger metrics", "[metrics]") {
+    auto sink = std::make_shared<test_sink_mt>();
+    auto tp = std::make_shared<spdlog::details::thread_pool>(128, 1);
+    auto logger = std::make_shared<spdlog::async_logger>("as", sink, tp);
+    logger->set_deferred_formatting(true);
+    logger->enable_metrics();
+    for (int i = 0; i < 50; i++) {
+        logger->info("message {}", i);
+    }
+    logger->warn("done");
+    tp.reset();  // the worker sinks the queued messages before stopping
+    REQUIRE(sink->msg_counter() == 51);
+
+    auto metrics = logger->metrics_snapshot();
+    REQUIRE(metrics.messages[spdlog::level::info] == 50);
+    REQUIRE(metrics.messages[spdlog::level::warn] == 1);
+    REQUIRE(metrics.formatted_bytes == 10 * 9 + 40 * 10 + 4);
+    REQUIRE(metrics.format_time.count == 50);  // in the worker, deferred
+    REQUIRE(metrics.sinks[0].write_time.count == 51);
+}
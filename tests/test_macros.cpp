@@ -4,6 +4,7 @@
  */
 
 #include "includes.h"
+#include "test_sink.h"
 
 #if SPDLOG_ACTIVE_LEVEL != SPDLOG_LEVEL_DEBUG
     #error "Invalid SPDLOG_ACTIVE_LEVEL in test. Should be SPDLOG_LEVEL_DEBUG"
@@ -51,3 +52,132 @@ TEST_CASE("pass logger pointer", "[macros]") {
     SPDLOG_LOGGER_TRACE(&ref, "Test message 1");
     SPDLOG_LOGGER_DEBUG(&ref, "Test message 2");
 }
+
+namespace {
+SPDLOG_CATEGORY(test_net, SPDLOG_LEVEL_WARN);
+SPDLOG_CATEGORY(test_control, SPDLOG_LEVEL_TRACE);  // below SPDLOG_ACTIVE_LEVEL
+
+int not_evaluated() { throw std::runtime_error("Should not be evaluated"); }
+}  // namespace
+
+TEST_CASE("category macros", "[macros]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    auto logger = std::make_shared<spdlog::logger>("category", test_sink);
+    logger->set_pattern("%v");
+    logger->set_level(spdlog::level::trace);
+
+    SPDLOG_LOGGER_CAT_TRACE(logger, test_net, "{}", not_evaluated());
+    SPDLOG_LOGGER_CAT_INFO(logger, test_net, "{}", not_evaluated());
+    SPDLOG_LOGGER_CAT_WARN(logger, test_net, "net warn");
+    SPDLOG_LOGGER_CAT_TRACE(logger, test_control, "control trace {}", 1);
+    REQUIRE(test_sink->lines() == std::vector<std::string>{"net warn", "control trace 1"});
+
+    auto orig_default_logger = spdlog::default_logger();
+    spdlog::set_default_logger(logger);
+    SPDLOG_CAT_DEBUG(test_net, "{}", not_evaluated());
+    SPDLOG_CAT_ERROR(test_net, "net error");
+    SPDLOG_CAT_TRACE(test_control, "control trace {}", 2);
+    spdlog::set_default_logger(std::move(orig_default_logger));
+    REQUIRE(test_sink->msg_counter() == 4);
+    REQUIRE(test_sink->lines()[2] == "net error");
+    REQUIRE(test_sink->lines()[3] == "control trace 2");
+}
+
+TEST_CASE("rate limited macros", "[macros]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    auto logger = std::make_shared<spdlog::logger>("limited", test_sink);
+    logger->set_pattern("%v");
+    logger->set_level(spdlog::level::trace);
+
+    for (int i = 0; i < 10; i++) {
+        SPDLOG_LOGGER_EVERY_N(logger, spdlog::level::info, 4, "every {}", i);
+    }
+    auto lines = test_sink->lines();
+    REQUIRE(lines.size() == 3);
+    REQUIRE(lines[0] == "every 0");
+    REQUIRE(lines[1] == "every 4 (3 suppressed)");
+    REQUIRE(lines[2] == "every 8 (3 suppressed)");
+
+    for (int i = 0; i < 10; i++) {
+        SPDLOG_LOGGER_FIRST_N(logger, spdlog::level::warn, 2, "first {}", i);
+    }
+    REQUIRE(test_sink->msg_counter() == 5);
+    REQUIRE(test_sink->lines()[4] == "first 1");
+
+    for (int i = 0; i < 100; i++) {
+        SPDLOG_LOGGER_SAMPLED(logger, spdlog::level::info, 0.1, "sampled {}", i);
+    }
+    REQUIRE(test_sink->msg_counter() == 15);
+
+    for (int i = 0; i < 2; i++) {
+        if (i == 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        }
+        for (int j = 0; j < 5; j++) {
+            SPDLOG_LOGGER_EVERY_MS(logger, spdlog::level::info, 50, "timed {}", j);
+        }
+    }
+    REQUIRE(test_sink->msg_counter() == 17);
+    REQUIRE(test_sink->lines()[15] == "timed 0");
+    REQUIRE(test_sink->lines()[16] == "timed 0 (4 suppressed)");
+
+    // below the level: not counted
+    logger->set_level(spdlog::level::warn);
+    for (int i = 0; i < 10; i++) {
+        SPDLOG_LOGGER_EVERY_N(logger, spdlog::level::info, 2, "below {}", i);
+    }
+    REQUIRE(test_sink->msg_counter() == 17);
+}
+
+TEST_CASE("rate limited default logger", "[macros]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    auto orig_default_logger = spdlog::default_logger();
+    spdlog::set_default_logger(std::make_shared<spdlog::logger>("limited", test_sink));
+    spdlog::default_logger()->set_pattern("%v");
+    for (int i = 0; i < 5; i++) {
+        SPDLOG_INFO_EVERY_N(5, "message");
+        SPDLOG_WARN_FIRST_N(1, "first");
+        SPDLOG_TRACE_EVERY_N(1, "compiled out");
+    }
+    REQUIRE(test_sink->lines() == std::vector<std::string>{"message", "first"});
+    spdlog::set_default_logger(std::move(orig_default_logger));
+}
+
+namespace {
+void debug_callsite(int i) { SPDLOG_DEBUG("callsite {}", i); }
+}  // namespace
+
+TEST_CASE("callsite cache", "[macros]") {
+    auto orig_default_logger = spdlog::default_logger();
+    auto first_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    auto first = std::make_shared<spdlog::logger>("first", first_sink);
+    first->set_pattern("%v");
+    spdlog::set_default_logger(first);
+
+    debug_callsite(1);
+    REQUIRE(first_sink->msg_counter() == 0);
+    first->set_level(spdlog::level::debug);
+    debug_callsite(2);
+    REQUIRE(first_sink->lines() == std::vector<std::string>{"callsite 2"});
+
+    // a new default logger
+    auto second_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    spdlog::set_default_logger(std::make_shared<spdlog::logger>("second", second_sink));
+    debug_callsite(3);
+    REQUIRE(second_sink->msg_counter() == 0);
+
+    // backtrace
+    spdlog::default_logger()->set_pattern("%v");
+    spdlog::enable_backtrace(4);
+    debug_callsite(4);
+    spdlog::dump_backtrace();
+    REQUIRE(second_sink->lines().size() == 3);
+    REQUIRE(second_sink->lines()[1] == "callsite 4");
+    spdlog::disable_backtrace();
+
+    spdlog::default_logger()->set_level(spdlog::level::debug);
+    debug_callsite(5);
+    REQUIRE(second_sink->lines().back() == "callsite 5");
+    REQUIRE(first_sink->msg_counter() == 1);
+    spdlog::set_default_logger(std::move(orig_default_logger));
+}
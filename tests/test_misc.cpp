@@ -1,5 +1,22 @@
 #include "includes.h"
 #include "test_sink.h"
+#include "spdlog/details/utf8.h"
+#include "spdlog/fmt/lazy.h"
+#ifndef SPDLOG_USE_STD_FORMAT
+    #include "spdlog/fmt/compile.h"
+    #include "spdlog/fmt/ranges.h"
+#endif
+#include "spdlog/logger_fwd.h"
+#include "spdlog/sinks/callback_sink.h"
+#ifndef SPDLOG_NO_TLS
+    #include "spdlog/context_logger.h"
+    #include "spdlog/sinks/thread_buffered_sink.h"
+#endif
+#ifdef SPDLOG_HEADER_ONLY
+    #include "spdlog/instantiate.h"
+#endif
+
+#include <set>
 
 template <class T>
 std::string log_info(const T &what, spdlog::level::level_enum logger_level = spdlog::level::info) {
@@ -31,6 +48,19 @@ TEST_CASE("basic_logging ", "[basic_logging]") {
     // REQUIRE(log_info(some_logged_class("some_val")) == "some_val");
 }
 
+TEST_CASE("constant messages", "[basic_logging]") {
+    std::ostringstream oss;
+    auto oss_sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(oss);
+    spdlog::logger oss_logger("oss", oss_sink);
+    oss_logger.set_formatter(spdlog::details::make_unique<spdlog::pattern_formatter>(
+        "%v|", spdlog::pattern_time_type::local, ""));
+    oss_logger.info("connection closed");
+    oss_logger.info(spdlog::static_msg("kept {{as is}}"));
+    oss_logger.log(spdlog::source_loc{}, spdlog::level::warn, spdlog::static_msg("located"));
+    oss_logger.debug(spdlog::static_msg("below the level"));
+    REQUIRE(oss.str() == "connection closed|kept {{as is}}|located|");
+}
+
 TEST_CASE("log_levels", "[log_levels]") {
     REQUIRE(log_info("Hello", spdlog::level::err).empty());
     REQUIRE(log_info("Hello", spdlog::level::critical).empty());
@@ -69,6 +99,11 @@ TEST_CASE("to_level_enum", "[convert_to_level_enum]") {
     REQUIRE(spdlog::level::from_str("critical") == spdlog::level::critical);
     REQUIRE(spdlog::level::from_str("off") == spdlog::level::off);
     REQUIRE(spdlog::level::from_str("null") == spdlog::level::off);
+    REQUIRE(spdlog::level::from_str("err") == spdlog::level::err);
+    REQUIRE(spdlog::level::from_str("") == spdlog::level::off);
+    REQUIRE(spdlog::level::from_str("t") == spdlog::level::off);
+    REQUIRE(spdlog::level::from_str("infos") == spdlog::level::off);
+    REQUIRE(spdlog::level::from_str("Info") == spdlog::level::off);
 }
 
 TEST_CASE("periodic flush", "[periodic_flush]") {
@@ -83,6 +118,60 @@ TEST_CASE("periodic flush", "[periodic_flush]") {
     spdlog::drop_all();
 }
 
+TEST_CASE("periodic workers share a thread", "[periodic_flush]") {
+    using spdlog::details::periodic_worker;
+    std::mutex mutex;
+    std::set<std::thread::id> thread_ids;
+    std::atomic<int> runs_a{0}, runs_b{0};
+    {
+        periodic_worker a(
+            [&] {
+                std::lock_guard<std::mutex> lock(mutex);
+                thread_ids.insert(std::this_thread::get_id());
+                runs_a++;
+            },
+            std::chrono::milliseconds(1));
+        periodic_worker b(
+            [&] {
+                std::lock_guard<std::mutex> lock(mutex);
+                thread_ids.insert(std::this_thread::get_id());
+                runs_b++;
+            },
+            std::chrono::milliseconds(2));
+        for (int i = 0; i < 500 && (runs_a < 3 || runs_b < 3); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    REQUIRE(runs_a >= 3);
+    REQUIRE(runs_b >= 3);
+    REQUIRE(thread_ids.size() == 1);
+    REQUIRE(thread_ids.count(std::this_thread::get_id()) == 0);
+
+    // not run after their destruction
+    int total = runs_a + runs_b;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(runs_a + runs_b == total);
+}
+
+TEST_CASE("scheduler cancel from the task", "[periodic_flush]") {
+    auto &scheduler = spdlog::details::scheduler::instance();
+    std::atomic<int> runs{0};
+    std::atomic<spdlog::details::scheduler::task_id> id{0};
+    id = scheduler.schedule_every(
+        [&] {
+            if (++runs == 2) {
+                scheduler.cancel(id);
+            }
+        },
+        std::chrono::milliseconds(5));
+    for (int i = 0; i < 500 && runs < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    REQUIRE(runs == 2);
+    scheduler.cancel(id);  // no longer there
+}
+
 TEST_CASE("clone-logger", "[clone]") {
     using spdlog::sinks::test_sink_mt;
     auto test_sink = std::make_shared<test_sink_mt>();
@@ -185,3 +274,313 @@ TEST_CASE("utf8 to utf16 conversion using windows api", "[windows utf]") {
     REQUIRE(std::wstring(buffer.data(), buffer.size()) == std::wstring(L"\x306d\x3053"));
 }
 #endif
+
+TEST_CASE("parse cpu list", "[os]") {
+    using spdlog::details::os::parse_cpu_list;
+    REQUIRE(parse_cpu_list("").empty());
+    REQUIRE(parse_cpu_list("0") == std::vector<int>{0});
+    REQUIRE(parse_cpu_list("0-3,8,10-11") == std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+    // stops at the first malformed entry
+    REQUIRE(parse_cpu_list("2,x,4") == std::vector<int>{2});
+    REQUIRE(parse_cpu_list("5-3") == std::vector<int>{});
+}
+
+static bool same_tm(const std::tm &lhs, const std::tm &rhs) {
+    return lhs.tm_sec == rhs.tm_sec && lhs.tm_min == rhs.tm_min && lhs.tm_hour == rhs.tm_hour &&
+           lhs.tm_mday == rhs.tm_mday && lhs.tm_mon == rhs.tm_mon &&
+           lhs.tm_year == rhs.tm_year && lhs.tm_wday == rhs.tm_wday &&
+           lhs.tm_yday == rhs.tm_yday && lhs.tm_isdst == rhs.tm_isdst;
+}
+
+TEST_CASE("fast time conversion", "[os]") {
+    using spdlog::details::os::fast_gmtime;
+    using spdlog::details::os::fast_localtime;
+    // around the epoch, leap days and century years
+    const std::time_t times[] = {0,          -1,         59,         86399,      86400,
+                                 951782400,  951868799,  951868800,  4107542400, 4107628800,
+                                 1709164800, 1709251199, 1735689599, 1700000000, -86401};
+    for (auto t : times) {
+        REQUIRE(same_tm(fast_gmtime(t), spdlog::details::os::gmtime(t)));
+        REQUIRE(same_tm(fast_localtime(t), spdlog::details::os::localtime(t)));
+    }
+    // a year by steps of about 7 hours, across the DST changes (if any)
+    for (std::time_t t = 1700000000; t < 1700000000 + 366 * 86400; t += 25013) {
+        REQUIRE(same_tm(fast_gmtime(t), spdlog::details::os::gmtime(t)));
+        REQUIRE(same_tm(fast_localtime(t), spdlog::details::os::localtime(t)));
+    }
+}
+
+TEST_CASE("token bucket", "[token_bucket]") {
+    using clock = spdlog::details::token_bucket::clock;
+    auto now = clock::now();
+    spdlog::details::token_bucket bucket(10, 3);  // a token every 100ms
+    REQUIRE(bucket.try_acquire(now));
+    REQUIRE(bucket.try_acquire(now));
+    REQUIRE(bucket.try_acquire(now));
+    REQUIRE_FALSE(bucket.try_acquire(now));
+    REQUIRE_FALSE(bucket.try_acquire(now + std::chrono::milliseconds(50)));
+    REQUIRE(bucket.try_acquire(now + std::chrono::milliseconds(100)));
+    REQUIRE_FALSE(bucket.try_acquire(now + std::chrono::milliseconds(100)));
+
+    spdlog::details::token_bucket closed(0, 3);
+    REQUIRE_FALSE(closed.try_acquire(now));
+}
+
+TEST_CASE("striped counter", "[striped_counter]") {
+    spdlog::details::striped_counter counter;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&counter] {
+            for (size_t j = 0; j < 1000; j++) {
+                ++counter;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    REQUIRE(counter.load() == 4000);
+    counter.add(5);
+    REQUIRE(counter.load() == 4005);
+    counter.reset();
+    REQUIRE(counter.load() == 0);
+}
+
+TEST_CASE("huge page allocator", "[huge_pages]") {
+    spdlog::details::huge_page_allocator<size_t> alloc(true);
+    size_t n = 300000;  // more than one huge page
+    auto *p = alloc.allocate(n);
+    REQUIRE(p != nullptr);
+    for (size_t i = 0; i < n; i++) {
+        p[i] = i;
+    }
+    REQUIRE(p[n - 1] == n - 1);
+    alloc.deallocate(p, n);
+
+    spdlog::details::mpmc_lockfree_queue<int, spdlog::details::huge_page_allocator<int>> q(
+        16, spdlog::details::huge_page_allocator<int>(true));
+    q.enqueue(42);
+    int popped = 0;
+    REQUIRE(q.dequeue_for(popped, std::chrono::milliseconds(0)));
+    REQUIRE(popped == 42);
+}
+
+#ifndef SPDLOG_NO_TLS
+TEST_CASE("context logger", "[context_logger]") {
+    auto sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    sink->set_pattern("[%n] [%&] %v");
+    spdlog::logger parent("parent", sink);
+    spdlog::mdc::put("user", "john");
+
+    spdlog::context_logger request_logger(parent, {{"request_id", "42"}});
+    request_logger.info("started {}", 1);
+    auto child = request_logger.with("user", "jane").with("request_id", "43");
+    REQUIRE(child.size() == 2);
+    child.warn("child");
+    parent.info("parent");
+    parent.set_level(spdlog::level::warn);
+    request_logger.info("filtered");
+    request_logger.error(std::string("error"));
+
+    auto lines = sink->lines();
+    REQUIRE(lines.size() == 4);
+    REQUIRE(lines[0] == "[parent] [request_id:42 user:john] started 1");
+    REQUIRE(lines[1] == "[parent] [request_id:43 user:jane] child");
+    // the entries replaced are back
+    REQUIRE(lines[2] == "[parent] [user:john] parent");
+    REQUIRE(lines[3] == "[parent] [request_id:42 user:john] error");
+    REQUIRE(spdlog::mdc::get_context().size() == 1);
+    REQUIRE(spdlog::mdc::get("user") == "john");
+
+    REQUIRE_THROWS_AS(child.with("a", "1").with("b", "2").with("c", "3"), spdlog::spdlog_ex);
+    spdlog::mdc::clear();
+}
+#endif
+
+TEST_CASE("utf16 to utf8", "[utf8]") {
+    auto to_utf8 = [](const std::u16string &text) {
+        spdlog::memory_buf_t buf;
+        spdlog::details::append_utf16_as_utf8(text.data(), text.size(), buf);
+        return std::string(buf.data(), buf.size());
+    };
+    REQUIRE(to_utf8(u"") == "");
+    REQUIRE(to_utf8(u"plain ascii text, longer than a vector") ==
+            "plain ascii text, longer than a vector");
+    REQUIRE(to_utf8(u"caf\u00e9 \u20ac 12345678 \U0001F600!") ==
+            "caf\xc3\xa9 \xe2\x82\xac 12345678 \xf0\x9f\x98\x80!");
+    // unpaired surrogates
+    REQUIRE(to_utf8(std::u16string{u'a', char16_t(0xd800), u'b'}) == "a\xef\xbf\xbd" "b");
+    REQUIRE(to_utf8(std::u16string{char16_t(0xdc00)}) == "\xef\xbf\xbd");
+    REQUIRE(to_utf8(std::u16string{u'x', char16_t(0xd83d)}) == "x\xef\xbf\xbd");
+}
+
+#ifndef SPDLOG_NO_TLS
+TEST_CASE("scratch buffer", "[misc]") {
+    using scratch = spdlog::details::scratch_buffer<spdlog::memory_buf_t>;
+    const std::string big(1000, 'x');
+    {
+        scratch s;
+        s.buf().append(big.data(), big.data() + big.size());
+    }
+    {
+        // the thread's buffer keeps its capacity, and a nested one is a local buffer
+        scratch s;
+        REQUIRE(s.buf().size() == 0);
+        REQUIRE(s.buf().capacity() >= big.size());
+        scratch nested;
+        REQUIRE(&nested.buf() != &s.buf());
+        REQUIRE(nested.buf().capacity() < big.size());
+    }
+    {
+        scratch s;
+        s.buf().resize(SPDLOG_SCRATCH_BUFFER_MAX_SIZE + 1);
+    }
+    scratch s;
+    REQUIRE(s.buf().capacity() <= SPDLOG_SCRATCH_BUFFER_MAX_SIZE);
+}
+
+TEST_CASE("logging while logging", "[misc]") {
+    auto inner_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    inner_sink->set_pattern("%v");
+    spdlog::logger inner("inner", inner_sink);
+    const std::string big(1000, 'x');
+    auto outer_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    outer_sink->set_pattern("%v");
+    auto callback = std::make_shared<spdlog::sinks::callback_sink_st>(
+        [&](const spdlog::details::log_msg &) { inner.info("inner {}", big); });
+    spdlog::logger outer("outer", {callback, outer_sink});
+    outer.info("outer {}", big);
+    outer.info("outer {}", 2);
+    REQUIRE(outer_sink->lines() == std::vector<std::string>{"outer " + big, "outer 2"});
+    REQUIRE(inner_sink->lines() == std::vector<std::string>{"inner " + big, "inner " + big});
+}
+#endif
+
+TEST_CASE("logger_fwd", "[logger_fwd]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    test_sink->set_pattern("%l %v");
+    auto logger = std::make_shared<spdlog::logger>("fwd", test_sink);
+    logger->set_level(spdlog::level::info);
+    spdlog::register_logger(logger);
+
+    REQUIRE(spdlog::fwd::get("fwd") == logger);
+    REQUIRE(spdlog::fwd::get("no such logger") == nullptr);
+    REQUIRE(spdlog::fwd::should_log(*logger, spdlog::level::warn));
+    REQUIRE_FALSE(spdlog::fwd::should_log(*logger, spdlog::level::debug));
+    spdlog::fwd::log(*logger, spdlog::level::warn, std::string("ready"));
+    spdlog::fwd::log(*logger, spdlog::level::debug, std::string("skipped"));
+    spdlog::fwd::flush(*logger);
+    REQUIRE(test_sink->lines() == std::vector<std::string>{"warning ready"});
+    REQUIRE(test_sink->flush_counter() == 1);
+    spdlog::drop_all();
+}
+
+TEST_CASE("lazy arguments", "[misc]") {
+    auto sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    spdlog::logger logger("lazy", sink);
+    logger.set_pattern("%v");
+    int calls = 0;
+    auto expensive = [&] {
+        calls++;
+        return 3.14159;
+    };
+    logger.debug("disabled {}", spdlog::lazy(expensive));
+    REQUIRE(calls == 0);
+    REQUIRE(sink->msg_counter() == 0);
+
+    logger.info("enabled {:.2f}", spdlog::lazy(expensive));
+    REQUIRE(calls == 1);
+    logger.info("{:>5}", spdlog::lazy([] { return std::string("str"); }));
+    REQUIRE(sink->lines() == std::vector<std::string>{"enabled 3.14", "  str"});
+}
+
+#ifndef SPDLOG_NO_TLS
+TEST_CASE("thread buffered sink", "[misc]") {
+    auto sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    {
+        auto buffered = std::make_shared<spdlog::sinks::thread_buffered_sink>(sink, 8);
+        spdlog::logger logger("buffered", buffered);
+        logger.set_pattern("%v");
+        for (int i = 0; i < 10; i++) {
+            logger.info("message {}", i);
+        }
+        REQUIRE(sink->msg_counter() == 8);
+        logger.flush();
+        REQUIRE(sink->msg_counter() == 10);
+        REQUIRE(sink->flush_counter() == 1);
+        REQUIRE(sink->lines()[9] == "message 9");
+
+        // the buffers of the threads are passed when they exit
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&logger] {
+                for (int i = 0; i < 100; i++) {
+                    logger.info("thread message {}", i);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        REQUIRE(sink->msg_counter() == 410);
+
+        // and those of the other threads on flush()
+        std::atomic<bool> logged{false};
+        std::atomic<bool> done{false};
+        std::thread other([&] {
+            logger.info("other thread");
+            logged = true;
+            while (!done) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        while (!logged) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(sink->msg_counter() == 410);
+        logger.flush();
+        REQUIRE(sink->msg_counter() == 411);
+        done = true;
+        other.join();
+
+        logger.info("last");
+    }
+    // by the destructor
+    REQUIRE(sink->msg_counter() == 412);
+    REQUIRE(sink->lines().size() == 100);
+}
+#endif
+
+TEST_CASE("max payload size", "[misc]") {
+    auto sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    sink->set_pattern("%v");
+    spdlog::logger logger("capped", sink);
+    REQUIRE(logger.max_payload_size() == 0);
+    logger.set_max_payload_size(10);
+    const std::string marker = SPDLOG_TRUNCATION_MARKER;
+
+    logger.info("0123456789");
+    logger.info("{}", "0123456789x");
+    logger.info(std::string(1000, 'x'));
+    logger.info("{}{}", std::string(600, 'y'), std::string(600, 'z'));
+    // not cut in the middle of a UTF-8 sequence
+    logger.info("{}", "012345678\xc3\xa9");
+    REQUIRE(sink->lines() == std::vector<std::string>{"0123456789", "0123456789" + marker,
+                                                      std::string(10, 'x') + marker,
+                                                      std::string(10, 'y') + marker,
+                                                      "012345678" + marker});
+    REQUIRE(logger.clone("other")->max_payload_size() == 10);
+
+#ifndef SPDLOG_USE_STD_FORMAT
+    logger.set_max_payload_size(100);
+    std::vector<int> big(1000000, 7);
+    logger.info("{}", big);
+    std::string expected = "[7";
+    while (expected.size() < 100) {
+        expected += ", 7";
+    }
+    REQUIRE(sink->lines().back() == expected.substr(0, 100) + marker);
+    logger.info(FMT_COMPILE("{} {}"), "compiled", std::string(200, 'c'));
+    REQUIRE(sink->lines().back() == "compiled " + std::string(91, 'c') + marker);
+#endif
+}
@@ -0,0 +1,83 @@
+#include "includes.h"
+#include "spdlog/sinks/mmap_file_sink.h"
+
+#include <fstream>
+
+#define MMAP_FILENAME "test_logs/mmap_log.txt"
+
+using spdlog::sinks::mmap_file_sink_st;
+
+static std::string expected_messages(int first, int last) {
+    std::string expected;
+    for (int i = first; i < last; i++) {
+        expected +=
+            spdlog::fmt_lib::format("Test message {:04}{}", i, spdlog::details::os::default_eol);
+    }
+    return expected;
+}
+
+TEST_CASE("mmap_file_sink", "[mmap_file_sink]") {
+    prepare_logdir();
+    {
+        // one page window, so the messages span several windows
+        auto sink = std::make_shared<mmap_file_sink_st>(SPDLOG_FILENAME_T(MMAP_FILENAME),
+                                                        1024 * 1024, 0, 1);
+        spdlog::logger logger("mmap_logger", sink);
+        logger.set_pattern("%v");
+        for (int i = 0; i < 1000; i++) {
+            logger.info("Test message {:04}", i);
+        }
+        // visible before closing, followed by the zeros of the allocated space
+        auto contents = file_contents(MMAP_FILENAME);
+        auto expected = expected_messages(0, 1000);
+        REQUIRE(contents.size() == 1024 * 1024);
+        REQUIRE(contents.substr(0, expected.size()) == expected);
+        REQUIRE(contents.find_first_not_of('\0', expected.size()) == std::string::npos);
+    }
+    // truncated to the data when closed
+    REQUIRE(file_contents(MMAP_FILENAME) == expected_messages(0, 1000));
+}
+
+TEST_CASE("mmap_file_sink_rotate", "[mmap_file_sink]") {
+    prepare_logdir();
+    auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    auto line_size = expected_messages(0, 1).size();
+    auto lines_per_file = page_size / line_size;
+    {
+        auto sink = std::make_shared<mmap_file_sink_st>(SPDLOG_FILENAME_T(MMAP_FILENAME),
+                                                        page_size, 2, page_size);
+        spdlog::logger logger("mmap_logger", sink);
+        logger.set_pattern("%v");
+        for (size_t i = 0; i < lines_per_file * 2 + 1; i++) {
+            logger.info("Test message {:04}", i);
+        }
+    }
+    auto per_file = static_cast<int>(lines_per_file);
+    REQUIRE(file_contents("test_logs/mmap_log.2.txt") == expected_messages(0, per_file));
+    REQUIRE(file_contents("test_logs/mmap_log.1.txt") ==
+            expected_messages(per_file, per_file * 2));
+    REQUIRE(file_contents(MMAP_FILENAME) == expected_messages(per_file * 2, per_file * 2 + 1));
+}
+
+TEST_CASE("mmap_file_sink_reopen", "[mmap_file_sink]") {
+    prepare_logdir();
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    {
+        // as left by a process which died with the file mapped
+        std::ofstream out(MMAP_FILENAME, std::ios::binary);
+        auto data = expected_messages(0, 10);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        std::string zeros(10000, '\0');
+        out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+    {
+        auto sink = std::make_shared<mmap_file_sink_st>(SPDLOG_FILENAME_T(MMAP_FILENAME),
+                                                        64 * 1024, 0);
+        spdlog::logger logger("mmap_logger", sink);
+        logger.set_pattern("%v");
+        for (int i = 10; i < 20; i++) {
+            logger.info("Test message {:04}", i);
+        }
+    }
+    REQUIRE(file_contents(MMAP_FILENAME) == expected_messages(0, 20));
+}
@@ -112,3 +112,294 @@ TEST_CASE("full_queue", "[mpmc_blocking_q]") {
     q.dequeue(item);
     REQUIRE(item == 123456);
 }
+
+TEST_CASE("lockfree_dequeue-empty-wait", "[mpmc_lockfree_q]") {
+    size_t q_size = 100;
+    milliseconds wait_ms(250);
+    milliseconds tolerance_wait(250);
+
+    spdlog::details::mpmc_lockfree_queue<int> q(q_size);
+    int popped_item = 0;
+    auto start = test_clock::now();
+    auto rv = q.dequeue_for(popped_item, wait_ms);
+    auto delta_ms = millis_from(start);
+
+    REQUIRE(rv == false);
+    INFO("Delta " << delta_ms.count() << " millis");
+    REQUIRE(delta_ms >= wait_ms - tolerance_wait);
+    REQUIRE(delta_ms <= wait_ms + tolerance_wait);
+}
+
+TEST_CASE("lockfree_full_queue", "[mpmc_lockfree_q]") {
+    size_t q_size = 100;
+    spdlog::details::mpmc_lockfree_queue<int> q(q_size);
+    for (int i = 0; i < static_cast<int>(q_size); i++) {
+        q.enqueue(i + 0);
+    }
+    REQUIRE(q.size() == q_size);
+
+    q.enqueue_if_have_room(-1);
+    REQUIRE(q.discard_counter() == 1);
+
+    q.enqueue_nowait(123456);
+    REQUIRE(q.overrun_counter() == 1);
+
+    for (int i = 1; i < static_cast<int>(q_size); i++) {
+        int item = -1;
+        q.dequeue(item);
+        REQUIRE(item == i);
+    }
+
+    // last item pushed has overridden the oldest.
+    int item = -1;
+    q.dequeue(item);
+    REQUIRE(item == 123456);
+    REQUIRE(q.size() == 0);
+}
+
+TEST_CASE("lockfree_bad_queue", "[mpmc_lockfree_q]") {
+    spdlog::details::mpmc_lockfree_queue<int> q(0);
+    q.enqueue_nowait(1);
+    REQUIRE(q.overrun_counter() == 1);
+    int i = 0;
+    REQUIRE(q.dequeue_for(i, milliseconds(0)) == false);
+}
+
+TEST_CASE("lockfree_multi_producers", "[mpmc_lockfree_q]") {
+    size_t q_size = 16;
+    size_t n_producers = 4;
+    size_t per_producer = 2000;
+    spdlog::details::mpmc_lockfree_queue<size_t> q(q_size);
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < n_producers; p++) {
+        producers.emplace_back([&q, per_producer] {
+            for (size_t i = 1; i <= per_producer; i++) {
+                q.enqueue(i + 0);
+            }
+        });
+    }
+
+    size_t sum = 0;
+    for (size_t i = 0; i < n_producers * per_producer; i++) {
+        size_t item = 0;
+        q.dequeue(item);
+        sum += item;
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    REQUIRE(sum == n_producers * per_producer * (per_producer + 1) / 2);
+    REQUIRE(q.overrun_counter() == 0);
+}
+
+TEST_CASE("lockfree_parked_consumers", "[mpmc_lockfree_q]") {
+    // consumers parked with and without a timeout (see SPDLOG_QUEUE_ATOMIC_WAIT), and
+    // producers parked on the full queue
+    size_t q_size = 2;
+    size_t n_producers = 4;
+    size_t per_producer = 2000;
+    size_t total = n_producers * per_producer;
+    spdlog::details::mpmc_lockfree_queue<size_t> q(q_size);
+
+    std::atomic<size_t> popped{0};
+    std::atomic<size_t> sum{0};
+    auto blocking_consumer = std::thread([&] {
+        size_t item = 0;
+        // the last item is left to the other consumer
+        while (popped.load() + 1 < total) {
+            q.dequeue(item);
+            sum += item;
+            popped++;
+        }
+    });
+    auto timed_consumer = std::thread([&] {
+        size_t item = 0;
+        while (popped.load() < total) {
+            if (q.dequeue_for(item, std::chrono::milliseconds(10))) {
+                sum += item;
+                popped++;
+            }
+        }
+    });
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < n_producers; p++) {
+        producers.emplace_back([&q, per_producer] {
+            for (size_t i = 1; i <= per_producer; i++) {
+                q.enqueue(i + 0);
+            }
+        });
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    timed_consumer.join();
+    if (popped.load() + 1 >= total) {
+        q.enqueue(0);  // wake the blocking consumer if the timed one got the last items
+    }
+    blocking_consumer.join();
+    REQUIRE(sum == n_producers * per_producer * (per_producer + 1) / 2);
+}
+
+TEST_CASE("multi_producers", "[mpmc_blocking_q]") {
+    // small queue: producers and consumer keep going to sleep and waking each other
+    size_t q_size = 4;
+    size_t n_producers = 4;
+    size_t per_producer = 2000;
+    spdlog::details::mpmc_blocking_queue<size_t> q(q_size);
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < n_producers; p++) {
+        producers.emplace_back([&q, per_producer] {
+            for (size_t i = 1; i <= per_producer; i++) {
+                q.enqueue(i + 0);
+            }
+        });
+    }
+
+    size_t sum = 0;
+    size_t popped = 0;
+    size_t items[3];
+    while (popped < n_producers * per_producer) {
+        auto n = q.dequeue_bulk(items, 3);
+        for (size_t i = 0; i < n; i++) {
+            sum += items[i];
+        }
+        popped += n;
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    REQUIRE(sum == n_producers * per_producer * (per_producer + 1) / 2);
+    REQUIRE(q.overrun_counter() == 0);
+}
+
+TEST_CASE("dequeue_bulk", "[mpmc_blocking_q]") {
+    spdlog::details::mpmc_blocking_queue<int> q(10);
+    for (int i = 0; i < 5; i++) {
+        q.enqueue(i + 0);
+    }
+    int items[3] = {};
+    REQUIRE(q.dequeue_bulk(items, 3) == 3);
+    REQUIRE(items[0] == 0);
+    REQUIRE(items[2] == 2);
+    REQUIRE(q.dequeue_bulk(items, 3) == 2);
+    REQUIRE(items[0] == 3);
+    REQUIRE(items[1] == 4);
+    REQUIRE(q.size() == 0);
+}
+
+TEST_CASE("lockfree_dequeue_bulk", "[mpmc_lockfree_q]") {
+    spdlog::details::mpmc_lockfree_queue<int> q(4);
+    std::thread producer([&q] {
+        for (int i = 0; i < 100; i++) {
+            q.enqueue(i + 0);
+        }
+    });
+
+    int items[8] = {};
+    int expected = 0;
+    while (expected < 100) {
+        size_t n = q.dequeue_bulk(items, 8);
+        REQUIRE(n >= 1);
+        for (size_t i = 0; i < n; i++) {
+            REQUIRE(items[i] == expected++);
+        }
+    }
+    producer.join();
+}
+
+TEST_CASE("try_dequeue_bulk", "[mpmc_blocking_q]") {
+    spdlog::details::mpmc_blocking_queue<int> q(10);
+    int items[4] = {};
+    REQUIRE(q.try_dequeue_bulk(items, 4) == 0);
+    q.enqueue(1);
+    q.enqueue(2);
+    REQUIRE(q.try_dequeue_bulk(items, 4) == 2);
+    REQUIRE(items[1] == 2);
+}
+
+TEST_CASE("lockfree_try_dequeue_bulk", "[mpmc_lockfree_q]") {
+    spdlog::details::mpmc_lockfree_queue<int> q(10);
+    int items[4] = {};
+    REQUIRE(q.try_dequeue_bulk(items, 4) == 0);
+    for (int i = 0; i < 6; i++) {
+        q.enqueue(i + 0);
+    }
+    REQUIRE(q.try_dequeue_bulk(items, 4) == 4);
+    REQUIRE(items[3] == 3);
+    REQUIRE(q.try_dequeue_bulk(items, 4) == 2);
+}
+
+TEST_CASE("high_water_mark", "[mpmc_blocking_q]") {
+    spdlog::details::mpmc_blocking_queue<int> q(4);
+    for (int i = 0; i < 6; i++) {
+        q.enqueue_nowait(i + 0);
+    }
+    REQUIRE(q.size() == 4);
+    REQUIRE(q.overrun_counter() == 2);
+    int items[3] = {};
+    REQUIRE(q.try_dequeue_bulk(items, 3) == 3);
+    REQUIRE(q.size() == 1);
+    REQUIRE(q.high_water_mark() == 4);
+    q.reset_high_water_mark();
+    REQUIRE(q.high_water_mark() == 1);
+    q.reset_overrun_counter();
+    REQUIRE(q.overrun_counter() == 0);
+}
+
+TEST_CASE("lockfree_high_water_mark", "[mpmc_lockfree_q]") {
+    spdlog::details::mpmc_lockfree_queue<int> q(8);
+    for (int i = 0; i < 5; i++) {
+        q.enqueue(i + 0);
+    }
+    int items[8] = {};
+    REQUIRE(q.try_dequeue_bulk(items, 8) == 5);
+    REQUIRE(q.high_water_mark() == 5);
+    q.reset_high_water_mark();
+    REQUIRE(q.high_water_mark() == 0);
+}
+
+TEST_CASE("lanes", "[mpmc_lanes_q]") {
+    // even items go to lane 0, odd items to lane 1
+    spdlog::details::mpmc_lanes_queue<int> q({2, 3}, [](const int &i) -> size_t {
+        return static_cast<size_t>(i % 2);
+    });
+    for (int i = 0; i < 10; i++) {
+        q.enqueue_nowait(i + 0);
+    }
+    REQUIRE(q.size() == 5);
+    REQUIRE(q.high_water_mark() == 5);
+    REQUIRE(q.lane_size(0) == 2);
+    REQUIRE(q.overrun_counter() == 5);
+
+    q.enqueue_if_have_room(1);
+    REQUIRE(q.discard_counter() == 1);
+
+    // higher lane first
+    int items[5] = {};
+    REQUIRE(q.dequeue_bulk(items, 5) == 5);
+    REQUIRE(items[0] == 5);
+    REQUIRE(items[1] == 7);
+    REQUIRE(items[2] == 9);
+    REQUIRE(items[3] == 6);
+    REQUIRE(items[4] == 8);
+}
+
+TEST_CASE("lanes_blocking", "[mpmc_lanes_q]") {
+    spdlog::details::mpmc_lanes_queue<int> q({1, 1}, [](const int &i) -> size_t {
+        return static_cast<size_t>(i % 2);
+    });
+    q.enqueue(0);
+    // a full lane doesn't block the other one
+    q.enqueue(1);
+    std::thread producer([&q] { q.enqueue(2); });
+    int item = -1;
+    REQUIRE(q.dequeue_for(item, std::chrono::milliseconds(10)));
+    REQUIRE(item == 1);
+    REQUIRE(q.dequeue_for(item, std::chrono::milliseconds(10)));
+    REQUIRE(item == 0);
+    REQUIRE(q.dequeue_for(item, std::chrono::milliseconds(1000)));
+    REQUIRE(item == 2);
+    producer.join();
+}
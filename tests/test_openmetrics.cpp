@@ -0,0 +1,105 @@
+#include "includes.h"
+#include "test_sink.h"
+#include "spdlog/openmetrics.h"
+
+#define TEST_FILENAME "test_logs/openmetrics.prom"
+
+static bool has_line(const std::string &text, const std::string &line) {
+    return ("\n" + text).find("\n" + line + "\n") != std::string::npos;
+}
+
+TEST_CASE("openmetrics text", "[openmetrics]") {
+    spdlog::details::thread_pool_options options(16, 1);
+    options.queue_latency = true;
+    auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+    auto sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    auto async_logger = std::make_shared<spdlog::async_logger>("as\"ync", sink, tp);
+    auto sync_logger = std::make_shared<spdlog::logger>("sync", sink);
+    sync_logger->enable_metrics();
+    async_logger->info("queued");
+    while (sink->msg_counter() < 1) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sync_logger->info("one");
+    sync_logger->warn("two {}", 2);
+
+    spdlog::openmetrics_exporter exporter;
+    exporter.add_thread_pool("main", tp);
+    exporter.add_logger(async_logger);
+    exporter.add_logger(sync_logger);
+    auto text = exporter.text();
+
+    REQUIRE(text.size() > 6);
+    REQUIRE(text.substr(text.size() - 6) == "# EOF\n");
+    REQUIRE(has_line(text, "# TYPE spdlog_queue_overruns counter"));
+    REQUIRE(has_line(text, "spdlog_queue_overruns_total{pool=\"main\"} 0"));
+    REQUIRE(has_line(text, "spdlog_queue_size{pool=\"main\"} 0"));
+    REQUIRE(has_line(text, "spdlog_workers{pool=\"main\"} 1"));
+    REQUIRE(has_line(text, "# TYPE spdlog_queue_latency_seconds histogram"));
+    REQUIRE(has_line(text, "spdlog_queue_latency_seconds_bucket{pool=\"main\",le=\"+Inf\"} 1"));
+    REQUIRE(has_line(text, "spdlog_queue_latency_seconds_count{pool=\"main\"} 1"));
+    REQUIRE(has_line(text, "spdlog_logger_overruns_total{logger=\"as\\\"ync\"} 0"));
+    REQUIRE(has_line(text, "spdlog_logger_messages_total{logger=\"sync\",level=\"info\"} 1"));
+    REQUIRE(has_line(text, "spdlog_logger_messages_total{logger=\"sync\",level=\"warning\"} 1"));
+    REQUIRE(has_line(text, "spdlog_logger_formatted_bytes_total{logger=\"sync\"} 8"));
+    REQUIRE(has_line(text, "spdlog_logger_format_seconds_count{logger=\"sync\"} 1"));
+    REQUIRE(has_line(text, "spdlog_sink_write_seconds_count{logger=\"sync\",sink=\"0\"} 2"));
+    // the loggers without metrics have no samples
+    REQUIRE(text.find("spdlog_logger_messages_total{logger=\"as") == std::string::npos);
+    // the families are not repeated
+    REQUIRE(text.find("# TYPE spdlog_logger_messages") ==
+            text.rfind("# TYPE spdlog_logger_messages"));
+
+    // the pools and loggers destroyed are dropped
+    async_logger.reset();
+    tp.reset();
+    text = exporter.text();
+    REQUIRE(text.find("pool=\"main\"") == std::string::npos);
+    REQUIRE(text.find("as\\\"ync") == std::string::npos);
+}
+
+TEST_CASE("openmetrics registered loggers", "[openmetrics]") {
+    spdlog::drop_all();
+    auto logger = spdlog::create<spdlog::sinks::test_sink_mt>("registered");
+    logger->enable_metrics();
+    logger->error("error");
+    spdlog::openmetrics_exporter exporter;
+    exporter.add_registered_loggers();
+    exporter.add_logger(logger);  // not listed twice
+    auto text = exporter.text();
+    auto sample = "spdlog_logger_messages_total{logger=\"registered\",level=\"error\"} 1";
+    REQUIRE(has_line(text, sample));
+    REQUIRE(text.find(sample) == text.rfind(sample));
+    spdlog::drop_all();
+}
+
+TEST_CASE("openmetrics export", "[openmetrics]") {
+    prepare_logdir();
+    auto logger = std::make_shared<spdlog::logger>("exported");
+    logger->enable_metrics();
+    spdlog::openmetrics_exporter exporter;
+    exporter.add_logger(logger);
+
+    std::mutex mutex;
+    std::vector<std::string> exports;
+    exporter.export_every(std::chrono::milliseconds(1), [&](spdlog::string_view_t text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        exports.emplace_back(text.data(), text.size());
+    });
+    for (int i = 0; i < 1000; i++) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (exports.size() >= 2) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    exporter.stop_export();
+    REQUIRE(exports.size() >= 2);
+    REQUIRE(exports[0].find("logger=\"exported\"") != std::string::npos);
+
+    spdlog::filename_t filename = SPDLOG_FILENAME_T(TEST_FILENAME);
+    spdlog::openmetrics_exporter::write_file(filename, exporter.text());
+    REQUIRE(file_contents(TEST_FILENAME) == exporter.text());
+}
@@ -0,0 +1,316 @@
+#include "includes.h"
+#include "spdlog/mdc.h"
+#include "spdlog/sinks/otlp_http_sink.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <deque>
+#include <thread>
+
+namespace {
+// http server on localhost answering the requests with the given statuses (then 200), over
+// the connections accepted one after the other
+class test_collector {
+public:
+    explicit test_collector(std::deque<int> statuses = {})
+        : statuses_(std::move(statuses)) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        ::listen(listen_fd_, 4);
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this] { serve_(); });
+    }
+
+    ~test_collector() {
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        ::close(listen_fd_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (conn_fd_ >= 0) {
+                ::shutdown(conn_fd_, SHUT_RDWR);
+            }
+        }
+        thread_.join();
+    }
+
+    int port() const { return port_; }
+
+    // the requests received (head, body), waiting up to 5 seconds for count of them
+    std::vector<std::pair<std::string, std::string>> requests(size_t count) {
+        for (int i = 0; i < 500; i++) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (requests_.size() >= count) {
+                    return requests_;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_;
+    }
+
+    size_t connections() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connections_;
+    }
+
+private:
+    int listen_fd_;
+    int conn_fd_ = -1;
+    int port_;
+    std::mutex mutex_;
+    std::deque<int> statuses_;
+    std::vector<std::pair<std::string, std::string>> requests_;
+    size_t connections_ = 0;
+    std::thread thread_;
+
+    void serve_() {
+        for (;;) {
+            int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                conn_fd_ = fd;
+                connections_++;
+            }
+            serve_connection_(fd);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                conn_fd_ = -1;
+            }
+            ::close(fd);
+        }
+    }
+
+    void serve_connection_(int fd) {
+        std::string in;
+        char buf[4096];
+        for (;;) {
+            size_t head_end;
+            while ((head_end = in.find("\r\n\r\n")) == std::string::npos) {
+                auto n = ::recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) {
+                    return;
+                }
+                in.append(buf, static_cast<size_t>(n));
+            }
+            auto head = in.substr(0, head_end + 2);
+            auto length_pos = head.find("Content-Length: ");
+            size_t length = length_pos == std::string::npos
+                                ? 0
+                                : std::stoul(head.substr(length_pos + 16));
+            while (in.size() < head_end + 4 + length) {
+                auto n = ::recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) {
+                    return;
+                }
+                in.append(buf, static_cast<size_t>(n));
+            }
+            int status = 200;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                requests_.emplace_back(head, in.substr(head_end + 4, length));
+                if (!statuses_.empty()) {
+                    status = statuses_.front();
+                    statuses_.pop_front();
+                }
+            }
+            in.erase(0, head_end + 4 + length);
+            auto response = "HTTP/1.1 " + std::to_string(status) +
+                            " Status\r\nContent-Type: application/json\r\nContent-Length: "
+                            "2\r\n\r\n{}";
+            ::send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+        }
+    }
+};
+
+spdlog::sinks::otlp_http_sink_config test_config(const test_collector &collector) {
+    spdlog::sinks::otlp_http_sink_config cfg("127.0.0.1", collector.port());
+    cfg.max_delay = std::chrono::hours(1);
+    cfg.reconnect_min_delay = std::chrono::milliseconds(1);
+    return cfg;
+}
+
+bool contains(const std::string &text, const std::string &part) {
+    return text.find(part) != std::string::npos;
+}
+}  // namespace
+
+TEST_CASE("otlp_http_sink json", "[otlp_http_sink]") {
+    test_collector collector;
+    auto cfg = test_config(collector);
+    cfg.encoding = spdlog::sinks::otlp_encoding::json;
+    cfg.service_name = "svc";
+    cfg.headers.emplace_back("Authorization", "Bearer token");
+    auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+    spdlog::logger first("first", sink);
+    spdlog::logger second("second", sink);
+
+    first.info("hello \"otlp\"");
+    {
+        spdlog::mdc::scoped_put put("request", "42");
+        first.warn("with mdc");
+    }
+    second.error("from second");
+    sink->flush();
+    auto requests = collector.requests(1);
+    REQUIRE(requests.size() == 1);
+    auto &head = requests[0].first;
+    auto &body = requests[0].second;
+    REQUIRE(head.find("POST /v1/logs HTTP/1.1\r\n") == 0);
+    REQUIRE(contains(head, "\r\nContent-Type: application/json\r\n"));
+    REQUIRE(contains(head, "\r\nAuthorization: Bearer token\r\n"));
+    REQUIRE(body.find("{\"resourceLogs\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\","
+                      "\"value\":{\"stringValue\":\"svc\"}}]},\"scopeLogs\":[{\"scope\":{\"name\":"
+                      "\"first\"},\"logRecords\":[{\"timeUnixNano\":\"") == 0);
+    REQUIRE(contains(body, "\"severityNumber\":9,\"severityText\":\"INFO\",\"body\":{"
+                           "\"stringValue\":\"hello \\\"otlp\\\"\"},\"attributes\":[{\"key\":"
+                           "\"thread.id\",\"value\":{\"intValue\":\""));
+    REQUIRE(contains(body, "{\"key\":\"request\",\"value\":{\"stringValue\":\"42\"}}"));
+    REQUIRE(contains(body, "]},{\"scope\":{\"name\":\"second\"},\"logRecords\":[{"));
+    REQUIRE(contains(body, "\"severityNumber\":17,\"severityText\":\"ERROR\""));
+    REQUIRE(body.substr(body.size() - 6) == "]}]}]}");
+
+    // on the same connection
+    first.info("again");
+    sink->flush();
+    REQUIRE(collector.requests(2).size() == 2);
+    REQUIRE(collector.connections() == 1);
+    REQUIRE(sink->dropped() == 0);
+}
+
+TEST_CASE("otlp_http_sink protobuf", "[otlp_http_sink]") {
+    test_collector collector;
+    auto cfg = test_config(collector);
+    auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+    spdlog::logger logger("proto", sink);
+
+    logger.info("hello");
+    sink->flush();
+    auto requests = collector.requests(1);
+    REQUIRE(requests.size() == 1);
+    REQUIRE(contains(requests[0].first, "\r\nContent-Type: application/x-protobuf\r\n"));
+    auto &body = requests[0].second;
+    // resource_logs = 1, a length delimited field spanning the whole body
+    REQUIRE(body[0] == 0x0a);
+    size_t size = 0;
+    size_t pos = 1;
+    for (int shift = 0;; shift += 7) {
+        auto byte = static_cast<unsigned char>(body[pos++]);
+        size |= static_cast<size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    REQUIRE(pos + size == body.size());
+    REQUIRE(contains(body, "\x0a\x05proto"));  // the scope name
+    REQUIRE(contains(body, std::string("\x2a\x07\x0a\x05hello")));
+    REQUIRE(contains(body, "\x1a\x04INFO"));
+    REQUIRE(contains(body, "thread.id"));
+}
+
+TEST_CASE("otlp_http_sink kv fields", "[otlp_http_sink]") {
+    test_collector collector;
+    auto cfg = test_config(collector);
+    cfg.encoding = spdlog::sinks::otlp_encoding::json;
+    auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+    spdlog::logger logger("kv", sink);
+    logger.info("done", spdlog::kv("status", 200), spdlog::kv("ratio", 0.5),
+                spdlog::kv("cached", true), spdlog::kv("path", "/users"));
+    sink->flush();
+    auto requests = collector.requests(1);
+    REQUIRE(requests.size() == 1);
+    REQUIRE(contains(requests[0].second,
+                     "{\"key\":\"status\",\"value\":{\"intValue\":\"200\"}},{\"key\":\"ratio\","
+                     "\"value\":{\"doubleValue\":0.5}},{\"key\":\"cached\",\"value\":{"
+                     "\"boolValue\":true}},{\"key\":\"path\",\"value\":{\"stringValue\":"
+                     "\"/users\"}}]"));
+}
+
+TEST_CASE("otlp_http_sink batches", "[otlp_http_sink]") {
+    test_collector collector;
+    auto cfg = test_config(collector);
+    cfg.encoding = spdlog::sinks::otlp_encoding::json;
+    cfg.max_batch_records = 3;
+    {
+        auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+        spdlog::logger logger("batches", sink);
+        for (int i = 0; i < 7; i++) {
+            logger.info("message {}", i);
+        }
+        // the full batches are sent without a flush
+        auto requests = collector.requests(2);
+        REQUIRE(requests.size() == 2);
+        REQUIRE(contains(requests[1].second, "message 5"));
+        REQUIRE_FALSE(contains(requests[1].second, "message 6"));
+    }
+    // the rest is sent when the sink is destroyed
+    auto requests = collector.requests(3);
+    REQUIRE(requests.size() == 3);
+    REQUIRE(contains(requests[2].second, "message 6"));
+}
+
+TEST_CASE("otlp_http_sink max_delay", "[otlp_http_sink]") {
+    test_collector collector;
+    auto cfg = test_config(collector);
+    cfg.max_delay = std::chrono::milliseconds(20);
+    auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+    spdlog::logger logger("delay", sink);
+    logger.info("sent without flush");
+    REQUIRE(collector.requests(1).size() == 1);
+}
+
+TEST_CASE("otlp_http_sink retries", "[otlp_http_sink]") {
+    test_collector collector({503, 429});
+    auto cfg = test_config(collector);
+    auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+    spdlog::logger logger("retries", sink);
+    logger.info("retried");
+    sink->flush();
+    auto requests = collector.requests(3);
+    REQUIRE(requests.size() == 3);
+    REQUIRE(requests[0].second == requests[2].second);
+    REQUIRE(sink->dropped() == 0);
+}
+
+TEST_CASE("otlp_http_sink rejected", "[otlp_http_sink]") {
+    test_collector collector({400});
+    auto cfg = test_config(collector);
+    auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+    spdlog::logger logger("rejected", sink);
+    logger.info("one");
+    logger.info("two");
+    sink->flush();
+    REQUIRE(collector.requests(1).size() == 1);
+    for (int i = 0; i < 500 && sink->dropped() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(sink->dropped() == 2);
+}
+
+#ifdef SPDLOG_ZLIB
+TEST_CASE("otlp_http_sink gzip", "[otlp_http_sink]") {
+    test_collector collector;
+    auto cfg = test_config(collector);
+    cfg.gzip = true;
+    auto sink = std::make_shared<spdlog::sinks::otlp_http_sink_mt>(cfg);
+    spdlog::logger logger("gzip", sink);
+    logger.info("compressed");
+    sink->flush();
+    auto requests = collector.requests(1);
+    REQUIRE(requests.size() == 1);
+    REQUIRE(contains(requests[0].first, "\r\nContent-Encoding: gzip\r\n"));
+    REQUIRE(requests[0].second.compare(0, 2, "\x1f\x8b") == 0);
+}
+#endif
@@ -1,5 +1,7 @@
 #include "includes.h"
 #include "test_sink.h"
+#include "spdlog/details/shared_format.h"
+#include "spdlog/sinks/dist_sink.h"
 
 using spdlog::memory_buf_t;
 using spdlog::details::to_string_view;
@@ -58,6 +60,49 @@ TEST_CASE("date MM/DD/YY ", "[pattern_formatter]") {
             oss.str());
 }
 
+TEST_CASE("cached time flags", "[pattern_formatter]") {
+    spdlog::pattern_formatter formatter("[%Y-%m-%d %H:%M:%S.%e] [%5!H%M] %v",
+                                        spdlog::pattern_time_type::utc, "\n");
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::info,
+                                 "some message");
+    auto format_at = [&](std::chrono::milliseconds time) {
+        msg.time = spdlog::log_clock::time_point(
+            std::chrono::duration_cast<spdlog::log_clock::duration>(time));
+        memory_buf_t formatted;
+        formatter.format(msg, formatted);
+        return std::string(formatted.data(), formatted.size());
+    };
+
+    REQUIRE(format_at(std::chrono::milliseconds(1700000000000)) ==
+            "[2023-11-14 22:13:20.000] [   2213] some message\n");
+    REQUIRE(format_at(std::chrono::milliseconds(1700000000250)) ==
+            "[2023-11-14 22:13:20.250] [   2213] some message\n");
+    REQUIRE(format_at(std::chrono::milliseconds(1700000061999)) ==
+            "[2023-11-14 22:14:21.999] [   2214] some message\n");
+    REQUIRE(format_at(std::chrono::milliseconds(1700000000001)) ==
+            "[2023-11-14 22:13:20.001] [   2213] some message\n");
+}
+
+TEST_CASE("padded fixed and variable width flags", "[pattern_formatter]") {
+    spdlog::pattern_formatter formatter("[%6Y|%-4m|%=5d|%1H|%2!e|%=10T] [%5t|%-6!n|%=9l] %v",
+                                        spdlog::pattern_time_type::utc, "\n");
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::info,
+                                 "some message");
+    msg.thread_id = 42;
+    auto format_at = [&](std::chrono::milliseconds time) {
+        msg.time = spdlog::log_clock::time_point(
+            std::chrono::duration_cast<spdlog::log_clock::duration>(time));
+        memory_buf_t formatted;
+        formatter.format(msg, formatted);
+        return std::string(formatted.data(), formatted.size());
+    };
+
+    const char *expected =
+        "[  2023|11  | 14  |22|12| 22:13:20 ] [   42|logger|  info   ] some message\n";
+    REQUIRE(format_at(std::chrono::milliseconds(1700000000123)) == expected);
+    REQUIRE(format_at(std::chrono::milliseconds(1700000000123)) == expected);
+}
+
 TEST_CASE("color range test1", "[pattern_formatter]") {
     auto formatter = std::make_shared<spdlog::pattern_formatter>(
         "%^%v%$", spdlog::pattern_time_type::local, "\n");
@@ -372,6 +417,40 @@ TEST_CASE("clone-custom_formatter", "[pattern_formatter]") {
     REQUIRE(to_string_view(formatted_2) == expected);
 }
 
+TEST_CASE("clone shares the compiled pattern", "[pattern_formatter]") {
+    auto formatter_1 = std::make_shared<spdlog::pattern_formatter>();
+    formatter_1->add_flag<custom_test_flag>('*', "custom").set_pattern(
+        "[%Y-%m-%d %H:%M:%S] [%2*] [%z] %v");
+    auto formatter_2 = formatter_1->clone();
+    auto formatter_3 = formatter_2->clone();
+    spdlog::details::log_msg msg("logger-name", spdlog::level::info, "some message");
+
+    // each clone has its own custom flag objects (custom_test_flag grows on each call)
+    memory_buf_t formatted_1;
+    formatter_1->format(msg, formatted_1);
+    formatted_1.clear();
+    formatter_1->format(msg, formatted_1);
+    memory_buf_t formatted_2;
+    formatter_2->format(msg, formatted_2);
+    memory_buf_t formatted_3;
+    formatter_3->format(msg, formatted_3);
+    std::string text_1(formatted_1.data(), formatted_1.size());
+    std::string text_2(formatted_2.data(), formatted_2.size());
+    REQUIRE(text_1.find("[    custom]") != std::string::npos);
+    REQUIRE(text_2.find("[  custom]") != std::string::npos);
+    REQUIRE(to_string_view(formatted_3) == to_string_view(formatted_2));
+
+    // a flag added after the pattern was compiled is only used by the clones (as before)
+    spdlog::pattern_formatter formatter_4("[%*] %v", spdlog::pattern_time_type::local, "");
+    formatter_4.add_flag<custom_test_flag>('*', "custom");
+    memory_buf_t formatted_4;
+    formatter_4.format(msg, formatted_4);
+    REQUIRE(to_string_view(formatted_4) == "[%*] some message");
+    memory_buf_t formatted_5;
+    formatter_4.clone()->format(msg, formatted_5);
+    REQUIRE(to_string_view(formatted_5) == "[custom] some message");
+}
+
 //
 // Test source location formatting
 //
@@ -415,6 +494,33 @@ TEST_CASE("short filename formatter-3", "[pattern_formatter]") {
     REQUIRE(to_string_view(formatted) == " Hello");
 }
 
+TEST_CASE("short filename at compile time", "[pattern_formatter]") {
+    static_assert(spdlog::details::short_filename_offset("", 0, 0) == 0, "");
+    static_assert(spdlog::details::short_filename_offset("myfile.cpp", 0, 10) == 0, "");
+    static_assert(spdlog::details::short_filename_offset("/", 0, 1) == 1, "");
+    static_assert(spdlog::details::short_filename_offset("/a/b//myfile.cpp", 0, 16) == 6, "");
+    static_assert(spdlog::details::short_filename_offset("a/bc/", 0, 5) == 5, "");
+    REQUIRE(std::string(SPDLOG_SHORT_FILENAME("/a/b//myfile.cpp")) == "myfile.cpp");
+    REQUIRE(std::string(SPDLOG_SHORT_FILENAME(__FILE__)) == "test_pattern_formatter.cpp");
+
+    // the precomputed short filename is used as is
+    spdlog::pattern_formatter formatter("%s|%g", spdlog::pattern_time_type::local, "");
+    memory_buf_t formatted;
+    spdlog::source_loc source_loc{"/a/b/long.cpp", 1, "some_func()", "short.cpp"};
+    spdlog::details::log_msg msg(source_loc, "logger-name", spdlog::level::info, "Hello");
+    formatter.format(msg, formatted);
+    REQUIRE(to_string_view(formatted) == "short.cpp|/a/b/long.cpp");
+
+    std::ostringstream oss;
+    auto logger = std::make_shared<spdlog::logger>(
+        "logger", std::make_shared<spdlog::sinks::ostream_sink_st>(oss));
+    logger->set_pattern("%s:%# %v");
+    SPDLOG_LOGGER_INFO(logger, "message");
+    REQUIRE(oss.str() ==
+            spdlog::fmt_lib::format("test_pattern_formatter.cpp:{} message{}", __LINE__ - 2,
+                                    spdlog::details::os::default_eol));
+}
+
 TEST_CASE("full filename formatter", "[pattern_formatter]") {
     spdlog::pattern_formatter formatter("%g", spdlog::pattern_time_type::local, "");
     memory_buf_t formatted;
@@ -460,6 +566,20 @@ TEST_CASE("custom flags-padding", "[pattern_formatter]") {
     REQUIRE(to_string_view(formatted) == expected);
 }
 
+TEST_CASE("set_pattern recompiles", "[pattern_formatter]") {
+    auto formatter = std::make_shared<spdlog::pattern_formatter>();
+    formatter->add_flag<custom_test_flag>('t', "custom1").set_pattern("[%t] %5l %v");
+    formatter->set_pattern("%% [%-6n] %Q%t%");
+
+    memory_buf_t formatted;
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger", spdlog::level::info,
+                                 "some message");
+    formatter->format(msg, formatted);
+    auto expected =
+        spdlog::fmt_lib::format("% [logger] %Qcustom1{}", spdlog::details::os::default_eol);
+    REQUIRE(to_string_view(formatted) == expected);
+}
+
 TEST_CASE("custom flags-exception", "[pattern_formatter]") {
     auto formatter = std::make_shared<spdlog::pattern_formatter>();
     formatter->add_flag<custom_test_flag>('t', "throw_me")
@@ -629,4 +749,298 @@ TEST_CASE("mdc empty", "[pattern_formatter]") {
 
     SECTION("Tear down") { spdlog::mdc::clear(); }
 }
+
+TEST_CASE("mdc scoped put", "[pattern_formatter]") {
+    auto formatter = std::make_shared<spdlog::pattern_formatter>("[%&] %v");
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::info,
+                                 "some message");
+    auto format = [&] {
+        memory_buf_t formatted;
+        formatter->format(msg, formatted);
+        return std::string(formatted.data(), formatted.size());
+    };
+    auto eol = std::string(spdlog::details::os::default_eol);
+
+    spdlog::mdc::put("b", "1");
+    {
+        spdlog::mdc::scoped_put a("a", "2");
+        spdlog::mdc::scoped_put b("b", "a longer value");
+        REQUIRE(format() == "[a:2 b:a longer value] some message" + eol);
+    }
+    REQUIRE(format() == "[b:1] some message" + eol);
+
+    // many updates reusing (and compacting) the storage
+    for (int i = 0; i < 1000; i++) {
+        spdlog::mdc::put("key_" + std::to_string(i % 7),
+                         std::string(static_cast<size_t>(i % 13), 'x'));
+        spdlog::mdc::remove("key_" + std::to_string((i + 3) % 7));
+    }
+    REQUIRE(spdlog::mdc::get("b") == "1");
+    REQUIRE(spdlog::mdc::get("key_" + std::to_string(999 % 7)) == std::string(999 % 13, 'x'));
+    REQUIRE(spdlog::mdc::get("key_" + std::to_string((999 + 3) % 7)).empty());
+
+    SECTION("Tear down") { spdlog::mdc::clear(); }
+}
+#endif
+
+#ifdef SPDLOG_HAS_STATIC_PATTERN_FORMATTER
+template <spdlog::details::static_pattern Pattern>
+static void require_same_as_pattern_formatter() {
+    spdlog::static_pattern_formatter<Pattern> static_formatter(spdlog::pattern_time_type::utc,
+                                                               "\n");
+    spdlog::pattern_formatter formatter(std::string(Pattern.chars),
+                                        spdlog::pattern_time_type::utc, "\n");
+    spdlog::source_loc source_loc{"/a/b/c/some_file.cpp", 123, "some_func()"};
+    spdlog::details::log_msg msg(source_loc, "logger-name", spdlog::level::warn, "message");
+
+    memory_buf_t expected;
+    memory_buf_t formatted;
+    formatter.format(msg, expected);
+    static_formatter.format(msg, formatted);
+    REQUIRE(to_string_view(formatted) == to_string_view(expected));
+    REQUIRE(msg.color_range_start <= msg.color_range_end);
+}
+
+TEST_CASE("static pattern formatter", "[pattern_formatter]") {
+    require_same_as_pattern_formatter<"">();
+    require_same_as_pattern_formatter<"%v">();
+    require_same_as_pattern_formatter<"%+">();
+    require_same_as_pattern_formatter<"[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] %v">();
+    require_same_as_pattern_formatter<"%a %A %b %h %B %c %C %D %x %I %p %r %R %T %X %z">();
+    require_same_as_pattern_formatter<"%f %F %E %L %P %t %N %@ %s %g %# %! %% %&">();
+    require_same_as_pattern_formatter<"[%8l] [%-8l] [%=8l] [%3!l] [%-3!v] [%=80n]">();
+    require_same_as_pattern_formatter<"[%10!] [%3!!] [%-8!Q] [%5Q] [%Q] [%-v] %">();
+    require_same_as_pattern_formatter<"[%6Y] [%-4m] [%=5d] [%3!D] [%=10T] [%5t] [%^%8l%$]">();
+
+    auto formatter = std::make_unique<spdlog::static_pattern_formatter<"[%n] %v">>();
+    REQUIRE(formatter->pattern() == "[%n] %v");
+    auto cloned = formatter->clone();
+    memory_buf_t formatted;
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "logger-name", spdlog::level::info,
+                                 "some message");
+    cloned->format(msg, formatted);
+    REQUIRE(to_string_view(formatted) ==
+            spdlog::fmt_lib::format("[logger-name] some message{}",
+                                    spdlog::details::os::default_eol));
+}
+#endif
+
+#ifdef __linux__
+TEST_CASE("thread name", "[pattern_formatter]") {
+    std::string named, renamed, invalidated;
+    std::unique_ptr<spdlog::details::log_msg_buffer> buffered;
+    std::thread thread([&] {
+        spdlog::details::os::set_thread_name("spdlog-test");
+        named = log_to_str("msg", "[%N] [%-13N] [%3!N] %v", spdlog::pattern_time_type::local, "");
+        ::pthread_setname_np(::pthread_self(), "renamed");
+        renamed = log_to_str("msg", "%N", spdlog::pattern_time_type::local, "");
+        spdlog::invalidate_thread_names();
+        invalidated = log_to_str("msg", "%N", spdlog::pattern_time_type::local, "");
+        spdlog::details::log_msg msg("logger", spdlog::level::info, "payload");
+        buffered.reset(new spdlog::details::log_msg_buffer(msg));
+    });
+    thread.join();
+
+    REQUIRE(named == "[spdlog-test] [spdlog-test  ] [spd] msg");
+    REQUIRE(renamed == "spdlog-test");
+    REQUIRE(invalidated == "renamed");
+    // the name outlives the thread in messages copied for later (e.g. async or backtrace)
+    spdlog::details::log_msg_buffer copy(*buffered);
+    buffered.reset();
+    REQUIRE(std::string(copy.thread_name.data(), copy.thread_name.size()) == "renamed");
+    REQUIRE(std::string(copy.logger_name.data(), copy.logger_name.size()) == "logger");
+    REQUIRE(std::string(copy.payload.data(), copy.payload.size()) == "payload");
+    copy.replace_payload("new payload");
+    REQUIRE(std::string(copy.thread_name.data(), copy.thread_name.size()) == "renamed");
+    REQUIRE(std::string(copy.payload.data(), copy.payload.size()) == "new payload");
+}
+#endif
+
+// records whether an identical formatter of a previous sink already formatted the message
+class shared_format_probe_sink : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+public:
+    std::vector<bool> shared;
+    std::vector<std::string> lines;
+    std::vector<std::pair<size_t, size_t>> color_ranges;
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override {
+        auto *shared_format = spdlog::details::shared_format::get(msg);
+        shared.push_back(shared_format != nullptr && shared_format->formatter != nullptr);
+        memory_buf_t formatted;
+        formatted.push_back('>');
+        formatter_->format(msg, formatted);
+        lines.emplace_back(formatted.data(), formatted.size());
+        color_ranges.emplace_back(msg.color_range_start, msg.color_range_end);
+    }
+    void flush_() override {}
+};
+
+TEST_CASE("format once for many sinks", "[pattern_formatter]") {
+    auto sink1 = std::make_shared<shared_format_probe_sink>();
+    auto sink2 = std::make_shared<shared_format_probe_sink>();
+    auto sink3 = std::make_shared<shared_format_probe_sink>();
+    auto dist_sink = std::make_shared<spdlog::sinks::dist_sink_st>();
+    dist_sink->add_sink(sink3);
+    spdlog::logger logger("logger", {sink1, sink2, dist_sink});
+    logger.set_pattern("[%n] [%^%l%$] %v");
+    sink2->set_pattern("%v");  // not identical: formatted on its own
+
+    logger.info("message 1");
+    sink3->set_pattern("[%n] [%^%l%$] %v");
+    logger.info("message 2");
+
+    auto eol = std::string(spdlog::details::os::default_eol);
+    REQUIRE(sink1->lines == std::vector<std::string>{">[logger] [info] message 1" + eol,
+                                                     ">[logger] [info] message 2" + eol});
+    REQUIRE(sink2->lines ==
+            std::vector<std::string>{">message 1" + eol, ">message 2" + eol});
+    REQUIRE(sink3->lines == sink1->lines);
+    REQUIRE(sink1->shared == std::vector<bool>{false, false});
+    REQUIRE(sink3->shared == std::vector<bool>{true, true});
+    REQUIRE(sink3->color_ranges == sink1->color_ranges);
+    REQUIRE(sink1->color_ranges[0] == std::make_pair(size_t(11), size_t(15)));
+}
+
+TEST_CASE("needed fields", "[pattern_formatter]") {
+    using spdlog::pattern_formatter;
+    namespace field = spdlog::msg_field;
+    REQUIRE(pattern_formatter("[%n] [%l] %v").needed_fields() == field::none);
+    REQUIRE(pattern_formatter("%t %v").needed_fields() == field::thread_id);
+    REQUIRE(pattern_formatter("%N %v").needed_fields() == field::thread_name);
+    REQUIRE(pattern_formatter("%s:%# %v").needed_fields() == field::source);
+    REQUIRE(pattern_formatter("%H:%M:%S.%e %v").needed_fields() == field::time);
+    REQUIRE(pattern_formatter("%+").needed_fields() == (field::time | field::source));
+    REQUIRE(pattern_formatter("%O %v").needed_fields() == field::time);
+
+    pattern_formatter need_localtime("%v");
+    need_localtime.need_localtime();
+    REQUIRE(need_localtime.needed_fields() == field::time);
+
+    pattern_formatter custom("%v");
+    custom.add_flag<custom_test_flag>('t', "custom").set_pattern("%t %v");
+    REQUIRE(custom.needed_fields() == field::all);
+
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_st>(std::cout);
+    REQUIRE(sink->needed_fields() == (field::time | field::source));  // default pattern
+    sink->set_pattern("%v");
+    REQUIRE(sink->needed_fields() == field::none);
+    REQUIRE(std::make_shared<spdlog::sinks::null_sink_st>()->needed_fields() == field::none);
+}
+
+// records the fields of the messages formatted
+class fields_probe_formatter : public spdlog::formatter {
+public:
+    fields_probe_formatter(unsigned fields, std::vector<spdlog::details::log_msg> &msgs)
+        : fields_(fields),
+          msgs_(msgs) {}
+    void format(const spdlog::details::log_msg &msg, spdlog::memory_buf_t &) override {
+        msgs_.push_back(msg);
+    }
+    std::unique_ptr<formatter> clone() const override {
+        return spdlog::details::make_unique<fields_probe_formatter>(fields_, msgs_);
+    }
+    unsigned needed_fields() const override { return fields_; }
+
+private:
+    unsigned fields_;
+    std::vector<spdlog::details::log_msg> &msgs_;
+};
+
+TEST_CASE("loggers fill only the needed fields", "[pattern_formatter]") {
+    std::vector<spdlog::details::log_msg> msgs;
+    std::ostringstream oss;
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_st>(oss);
+    spdlog::logger logger("logger", sink);
+    spdlog::source_loc loc{"file.cpp", 42, "func"};
+
+    sink->set_formatter(
+        spdlog::details::make_unique<fields_probe_formatter>(spdlog::msg_field::none, msgs));
+    logger.log(loc, spdlog::level::info, "not filled");
+    REQUIRE(msgs.back().time == spdlog::log_clock::time_point{});
+    REQUIRE(msgs.back().thread_id == 0);
+    REQUIRE(msgs.back().source.empty());
+    REQUIRE(msgs.back().payload == "not filled");
+
+    sink->set_formatter(
+        spdlog::details::make_unique<fields_probe_formatter>(spdlog::msg_field::all, msgs));
+    logger.log(loc, spdlog::level::info, "filled");
+    REQUIRE(msgs.back().time != spdlog::log_clock::time_point{});
+    REQUIRE(msgs.back().source.line == 42);
+#ifndef SPDLOG_NO_THREAD_ID
+    REQUIRE(msgs.back().thread_id != 0);
 #endif
+
+    // the backtrace may be dumped to other sinks: all the fields are kept
+    sink->set_formatter(
+        spdlog::details::make_unique<fields_probe_formatter>(spdlog::msg_field::none, msgs));
+    logger.enable_backtrace(4);
+    logger.log(loc, spdlog::level::info, "backtraced");
+    REQUIRE(msgs.back().source.line == 42);
+}
+
+TEST_CASE("control chars", "[pattern_formatter]") {
+    auto format = [](const std::string &pattern, spdlog::control_chars chars,
+                     const std::string &payload) {
+        spdlog::pattern_formatter formatter(pattern, spdlog::pattern_time_type::local, "");
+        formatter.set_control_chars(chars);
+        auto cloned = formatter.clone();
+        spdlog::details::log_msg msg(spdlog::source_loc{}, "logger", spdlog::level::info,
+                                     spdlog::string_view_t(payload.data(), payload.size()));
+        memory_buf_t formatted, formatted_by_clone;
+        formatter.format(msg, formatted);
+        cloned->format(msg, formatted_by_clone);
+        REQUIRE(to_string_view(formatted) == to_string_view(formatted_by_clone));
+        return std::string(formatted.data(), formatted.size());
+    };
+    const std::string forged = "user=x\n[info] admin logged in\r\t\x1b[0m\x7f end";
+    REQUIRE(format("%v", spdlog::control_chars::keep, forged) == forged);
+    REQUIRE(format("%v", spdlog::control_chars::escape, forged) ==
+            "user=x\\n[info] admin logged in\\r\\t\\x1b[0m\\x7f end");
+    REQUIRE(format("%v", spdlog::control_chars::strip, forged) ==
+            "user=x[info] admin logged in[0m end");
+    REQUIRE(format("[%12v]", spdlog::control_chars::escape, "a\nb") == "[        a\\nb]");
+    REQUIRE(format("[%-3!v]", spdlog::control_chars::escape, "a\nb") == "[a\\n]");
+    auto full = format("%+", spdlog::control_chars::escape, "a\nb");
+    REQUIRE(full.substr(full.size() - 4) == "a\\nb");
+
+    // the runs of the scanned blocks, and the chars after them
+    std::string long_payload(100, 'x');
+    long_payload[15] = '\n';
+    long_payload[16] = '\x01';
+    long_payload[99] = '\x1f';
+    std::string expected(long_payload);
+    expected.replace(99, 1, "\\x1f");
+    expected.replace(16, 1, "\\x01");
+    expected.replace(15, 1, "\\n");
+    REQUIRE(format("%v", spdlog::control_chars::escape, long_payload) == expected);
+    auto stripped = format("%v", spdlog::control_chars::strip, long_payload);
+    REQUIRE(stripped == std::string(97, 'x'));
+    std::string utf8 = "caf\xc3\xa9 \xe2\x82\xac";  // not control chars
+    REQUIRE(format("%v", spdlog::control_chars::strip, utf8) == utf8);
+}
+
+TEST_CASE("cached logger name and level", "[pattern_formatter]") {
+    spdlog::pattern_formatter formatter("<[%n] [%^%-8l%$] %v>", spdlog::pattern_time_type::local,
+                                        "");
+    // more names than cached per level, so the entries get replaced
+    const std::vector<std::string> names{"a", "bb", "ccc", "", "network", "bb2"};
+    for (int round = 0; round < 3; round++) {
+        for (const auto &name : names) {
+            for (int l = spdlog::level::trace; l < spdlog::level::off; l++) {
+                auto level = static_cast<spdlog::level::level_enum>(l);
+                spdlog::details::log_msg msg(spdlog::source_loc{}, name, level, "payload");
+                memory_buf_t formatted;
+                formatted.append(std::string("xyz"));  // the color range is rebased
+                formatter.format(msg, formatted);
+                auto level_name = spdlog::level::to_string_view(level);
+                auto padded = std::string(level_name.data(), level_name.size());
+                padded.resize(std::max<size_t>(padded.size(), 8), ' ');
+                REQUIRE(to_string_view(formatted) ==
+                        "xyz<[" + name + "] [" + padded + "] payload>");
+                REQUIRE(msg.color_range_start == 3 + 2 + name.size() + 3);
+                REQUIRE(msg.color_range_end == msg.color_range_start + padded.size());
+            }
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#include "includes.h"
+#include "test_sink.h"
+#include "spdlog/redactor.h"
+#include "spdlog/sinks/staged_sink.h"
+
+namespace {
+std::string redacted(const spdlog::redactor &redactor, std::string text) {
+    redactor.redact(&text[0], text.size());
+    return text;
+}
+}  // namespace
+
+TEST_CASE("redactor patterns", "[redactor]") {
+    spdlog::redactor cards({"\\d{4}[ -]?\\d{4}[ -]?\\d{4}[ -]?\\d{1,7}"});
+    REQUIRE(redacted(cards, "card 4111 1111-11111111 ok") == "card ****************** ok");
+    REQUIRE(redacted(cards, "id 12345678901 12:30:45") == "id 12345678901 12:30:45");
+    REQUIRE(redacted(cards, "41111111111111114111") == "*******************1");
+
+    spdlog::redactor tokens({"tok_\\w{4,}", "key=[^ ]+", "q.q", "x*y+z?"}, '#');
+    REQUIRE(redacted(tokens, "tok_abc tok_abcd_1!") == "tok_abc ##########!");
+    REQUIRE(redacted(tokens, "key=s3cr3t next") == "########## next");
+    REQUIRE(redacted(tokens, "qbq q\\q qq") == "### ### qq");
+    REQUIRE(redacted(tokens, "xxyyz xz y") == "##### xz #");
+    REQUIRE(redacted(tokens, "nothing") == "nothing");
+
+    spdlog::redactor escapes({"\\.\\*\\\\", "[\\d.]{3}", "[]x]"});
+    REQUIRE(redacted(escapes, ".*\\ 1.2 ]x") == "*** *** **");
+
+    std::string text = "tok_abcdefgh";
+    spdlog::memory_buf_t buf;
+    buf.append(text.data(), text.data() + text.size());
+    REQUIRE(tokens.redact(buf) == 1);
+    REQUIRE(tokens.match_at("tok_abcd", 8, 0) == 8);
+    REQUIRE(tokens.match_at("tok_abc", 7, 0) == 0);
+
+#ifndef SPDLOG_NO_EXCEPTIONS
+    for (const char *invalid : {"a{2", "a{3,1}", "*a", "[ab", "a\\", "a{100000}"}) {
+        REQUIRE_THROWS_AS(spdlog::redactor({invalid}), spdlog::spdlog_ex);
+    }
+#endif
+}
+
+TEST_CASE("redactor stage", "[redactor]") {
+    auto sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    auto staged = spdlog::sinks::make_staged_sink<spdlog::details::null_mutex>(
+        sink, spdlog::redactor({"\\d{16}"}));
+    staged->set_pattern("%v");
+    spdlog::logger logger("redacted", staged);
+    logger.info("card {} end", "4111111111111111");
+    logger.info("no card 12345");
+    logger.info(spdlog::static_msg("static 4111111111111111"));
+    REQUIRE(sink->lines() == std::vector<std::string>{"card **************** end",
+                                                      "no card 12345",
+                                                      "static ****************"});
+}
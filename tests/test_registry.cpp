@@ -1,4 +1,6 @@
 #include "includes.h"
+#include "test_sink.h"
+#include "spdlog/logger_ref.h"
 
 static const char *const tested_logger_name = "null_logger";
 static const char *const tested_logger_name2 = "null_logger2";
@@ -110,3 +112,263 @@ TEST_CASE("disable automatic registration", "[registry]") {
     spdlog::set_level(spdlog::level::info);
     spdlog::set_automatic_registration(true);
 }
+
+TEST_CASE("get by string_view", "[registry]") {
+    spdlog::drop_all();
+    auto logger = spdlog::create<spdlog::sinks::null_sink_mt>(tested_logger_name);
+    std::string names = std::string(tested_logger_name) + "|other";
+    spdlog::string_view_t name(names.data(), std::strlen(tested_logger_name));
+    REQUIRE(spdlog::get(name) == logger);
+    REQUIRE(spdlog::get(spdlog::string_view_t(names.data(), 4)) == nullptr);
+    spdlog::drop(tested_logger_name);
+    REQUIRE(spdlog::get(name) == nullptr);
+    spdlog::drop_all();
+}
+
+TEST_CASE("get after registering in any order", "[registry]") {
+    spdlog::drop_all();
+    const char *names[] = {"m", "c", "x", "a", "mm", "b", "z", "m.a", ""};
+    std::vector<std::shared_ptr<spdlog::logger>> loggers;
+    for (auto *name : names) {
+        loggers.push_back(spdlog::create<spdlog::sinks::null_sink_mt>(name));
+        for (size_t i = 0; i < loggers.size(); i++) {
+            REQUIRE(spdlog::get(names[i]) == loggers[i]);
+        }
+    }
+    REQUIRE(spdlog::get("y") == nullptr);
+    spdlog::drop("c");
+    REQUIRE(spdlog::get("c") == nullptr);
+    REQUIRE(spdlog::get("b") == loggers[5]);
+    spdlog::drop_all();
+}
+
+TEST_CASE("get while registering", "[registry]") {
+    spdlog::drop_all();
+    auto logger = spdlog::create<spdlog::sinks::null_sink_mt>(tested_logger_name);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> misses{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (!done) {
+                if (spdlog::get(tested_logger_name) != logger) {
+                    misses++;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 200; i++) {
+        auto name = "registered_" + std::to_string(i);
+        spdlog::create<spdlog::sinks::null_sink_mt>(name);
+        REQUIRE(spdlog::get(name) != nullptr);
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    REQUIRE(misses == 0);
+    spdlog::drop_all();
+}
+
+TEST_CASE("set_default_logger while logging", "[registry]") {
+    auto previous = spdlog::default_logger();
+    std::vector<std::shared_ptr<spdlog::sinks::test_sink_mt>> sinks;
+    auto make_default = [&](size_t i) {
+        sinks.push_back(std::make_shared<spdlog::sinks::test_sink_mt>());
+        auto name = "default_" + std::to_string(i);
+        spdlog::set_default_logger(std::make_shared<spdlog::logger>(name, sinks.back()));
+    };
+    make_default(0);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> logged{0};
+    std::vector<std::thread> loggers;
+    for (int i = 0; i < 4; i++) {
+        loggers.emplace_back([&] {
+            while (!done) {
+                spdlog::info("message");
+                logged++;
+            }
+        });
+    }
+    for (size_t i = 1; i < 100; i++) {
+        make_default(i);
+        // the previous one is only kept by the threads still logging with it
+        spdlog::drop("default_" + std::to_string(i - 1));
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    done = true;
+    for (auto &t : loggers) {
+        t.join();
+    }
+    size_t received = 0;
+    for (auto &sink : sinks) {
+        received += sink->msg_counter();
+    }
+    REQUIRE(received == logged);
+    spdlog::drop_all();
+    spdlog::set_default_logger(previous);
+}
+
+namespace {
+class slow_flush_sink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    explicit slow_flush_sink(std::chrono::milliseconds delay)
+        : delay_(delay) {}
+
+    size_t flushes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flushes_;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &) override {}
+    void flush_() override {
+        std::this_thread::sleep_for(delay_);
+        flushes_++;
+    }
+
+private:
+    std::chrono::milliseconds delay_;
+    size_t flushes_ = 0;
+};
+}  // namespace
+
+TEST_CASE("apply_all without the lock", "[registry]") {
+    spdlog::drop_all();
+    spdlog::create<spdlog::sinks::null_sink_mt>(tested_logger_name);
+    size_t found = 0;
+    // the registry can be used from the function
+    spdlog::apply_all([&](std::shared_ptr<spdlog::logger> l) {
+        if (spdlog::get(l->name()) == l) {
+            found++;
+        }
+    });
+    REQUIRE(found == 1);
+    spdlog::drop_all();
+}
+
+TEST_CASE("flush_all with a timeout", "[registry]") {
+    spdlog::drop_all();
+    auto sink1 = std::make_shared<slow_flush_sink>(std::chrono::milliseconds(300));
+    auto sink2 = std::make_shared<slow_flush_sink>(std::chrono::milliseconds(300));
+    spdlog::register_logger(std::make_shared<spdlog::logger>("slow1", sink1));
+    spdlog::register_logger(std::make_shared<spdlog::logger>("slow2", sink2));
+
+    // in parallel
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(spdlog::flush_all(std::chrono::seconds(5)));
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(590));
+    REQUIRE(sink1->flushes() == 1);
+    REQUIRE(sink2->flushes() == 1);
+
+    REQUIRE_FALSE(spdlog::flush_all(std::chrono::milliseconds(10)));
+    // finished by their threads
+    for (int i = 0; i < 500 && (sink1->flushes() < 2 || sink2->flushes() < 2); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(sink1->flushes() == 2);
+    REQUIRE(sink2->flushes() == 2);
+    spdlog::drop_all();
+}
+
+TEST_CASE("tree levels", "[registry]") {
+    spdlog::drop_all();
+    auto sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+    auto root = std::make_shared<spdlog::logger>("tree_test", sink);
+    auto child = std::make_shared<spdlog::logger>("tree_test.child", sink);
+    auto other = std::make_shared<spdlog::logger>("tree_test_other", sink);
+    spdlog::register_logger(root);
+    spdlog::register_logger(child);
+    spdlog::register_logger(other);
+
+    spdlog::set_tree_level("tree_test", spdlog::level::warn);
+    REQUIRE(root->level() == spdlog::level::warn);
+    REQUIRE(child->level() == spdlog::level::warn);
+    REQUIRE(other->level() == spdlog::level::info);
+    REQUIRE(child->inherits_level());
+
+    // registered after, and set again
+    auto grandchild = std::make_shared<spdlog::logger>("tree_test.child.grandchild", sink);
+    spdlog::register_logger(grandchild);
+    spdlog::set_tree_level("tree_test", spdlog::level::debug);
+    REQUIRE(grandchild->level() == spdlog::level::debug);
+    REQUIRE_FALSE(grandchild->should_log(spdlog::level::trace));
+    REQUIRE(grandchild->should_log(spdlog::level::debug));
+
+    // a nearer tree wins
+    spdlog::set_tree_level("tree_test.child", spdlog::level::err);
+    REQUIRE(root->level() == spdlog::level::debug);
+    REQUIRE(child->level() == spdlog::level::err);
+    REQUIRE(grandchild->level() == spdlog::level::err);
+    spdlog::set_tree_level("tree_test", spdlog::level::trace);
+    REQUIRE(grandchild->level() == spdlog::level::err);
+
+    // set_level on the logger detaches it
+    child->set_level(spdlog::level::critical);
+    REQUIRE_FALSE(child->inherits_level());
+    spdlog::set_tree_level("tree_test.child", spdlog::level::warn);
+    REQUIRE(child->level() == spdlog::level::critical);
+    REQUIRE(grandchild->level() == spdlog::level::warn);
+
+    // the global level sets them all
+    spdlog::set_level(spdlog::level::info);
+    REQUIRE(root->level() == spdlog::level::info);
+    REQUIRE(child->level() == spdlog::level::info);
+    REQUIRE(grandchild->level() == spdlog::level::info);
+    REQUIRE(grandchild->inherits_level());
+    spdlog::drop_all();
+}
+
+TEST_CASE("create_many", "[registry]") {
+    spdlog::drop_all();
+    spdlog::set_tree_level("many", spdlog::level::debug);
+    std::vector<std::string> names = {"many.c", "many.a", "other", "many.b"};
+    auto loggers = spdlog::create_many<spdlog::sinks::test_sink_mt>(names);
+    REQUIRE(loggers.size() == names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        REQUIRE(loggers[i]->name() == names[i]);
+        REQUIRE(spdlog::get(names[i]) == loggers[i]);
+        REQUIRE(loggers[i]->sinks() == loggers[0]->sinks());
+    }
+    REQUIRE(loggers[0]->level() == spdlog::level::debug);
+    REQUIRE(loggers[2]->level() == spdlog::level::info);
+    spdlog::set_tree_level("many", spdlog::level::err);
+    REQUIRE(loggers[3]->level() == spdlog::level::err);
+
+#ifndef SPDLOG_NO_EXCEPTIONS
+    // none of them is registered if one of the names is taken
+    REQUIRE_THROWS_AS(spdlog::create_many<spdlog::sinks::null_sink_mt>(
+                          std::vector<std::string>{"new", "other"}),
+                      spdlog::spdlog_ex);
+    REQUIRE(spdlog::get("new") == nullptr);
+    REQUIRE_THROWS_AS(spdlog::create_many<spdlog::sinks::null_sink_mt>(
+                          std::vector<std::string>{"new", "new2", "new"}),
+                      spdlog::spdlog_ex);
+    REQUIRE(spdlog::get("new") == nullptr);
+#endif
+    spdlog::set_level(spdlog::level::info);
+    spdlog::drop_all();
+}
+
+TEST_CASE("logger_ref", "[registry]") {
+    spdlog::drop_all();
+    spdlog::logger_ref ref("ref_test");
+    REQUIRE(ref.name() == "ref_test");
+    REQUIRE_FALSE(ref);
+
+    auto logger = spdlog::create<spdlog::sinks::test_sink_mt>("ref_test");
+    REQUIRE(ref.get() == logger.get());
+    auto version = spdlog::details::registry::instance().version();
+    ref->info("message");
+    REQUIRE(spdlog::details::registry::instance().version() == version);
+    auto sink = std::static_pointer_cast<spdlog::sinks::test_sink_mt>(logger->sinks()[0]);
+    REQUIRE(sink->msg_counter() == 1);
+
+    // dropped, then replaced
+    spdlog::drop("ref_test");
+    REQUIRE(ref.get() == nullptr);
+    auto replacement = spdlog::create<spdlog::sinks::test_sink_mt>("ref_test");
+    REQUIRE(ref.get() == replacement.get());
+    spdlog::drop_all();
+    REQUIRE_FALSE(ref);
+}
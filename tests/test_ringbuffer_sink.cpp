@@ -0,0 +1,77 @@
+#include "includes.h"
+#include "spdlog/sinks/lockfree_ringbuffer_sink.h"
+
+#include <thread>
+
+TEST_CASE("lockfree_ringbuffer_sink", "[ringbuffer_sink]") {
+    auto sink = std::make_shared<spdlog::sinks::lockfree_ringbuffer_sink>(3);
+    sink->set_pattern("%v");
+    spdlog::logger logger("ring", sink);
+
+    REQUIRE(sink->last_formatted().empty());
+    for (int i = 0; i < 5; i++) {
+        logger.info("message {}", i);
+    }
+
+    auto lines = sink->last_formatted();
+    REQUIRE(lines.size() == 3);
+    REQUIRE(lines[0] == "message 2" + std::string(spdlog::details::os::default_eol));
+    REQUIRE(lines[2] == "message 4" + std::string(spdlog::details::os::default_eol));
+    REQUIRE(sink->last_formatted(1).size() == 1);
+
+    auto raw = sink->last_raw(2);
+    REQUIRE(raw.size() == 2);
+    REQUIRE(std::string(raw[0].payload.data(), raw[0].payload.size()) == "message 3");
+    REQUIRE(std::string(raw[1].logger_name.data(), raw[1].logger_name.size()) == "ring");
+    REQUIRE(raw[1].level == spdlog::level::info);
+}
+
+TEST_CASE("lockfree_ringbuffer_sink truncates", "[ringbuffer_sink]") {
+    auto sink = std::make_shared<spdlog::sinks::lockfree_ringbuffer_sink>(2, 8);
+    spdlog::logger logger("ring", sink);
+    logger.info("0123456789");
+
+    auto raw = sink->last_raw();
+    REQUIRE(raw.size() == 1);
+    REQUIRE(std::string(raw[0].payload.data(), raw[0].payload.size()) == "0123");
+}
+
+TEST_CASE("lockfree_ringbuffer_sink concurrent", "[ringbuffer_sink]") {
+    auto sink = std::make_shared<spdlog::sinks::lockfree_ringbuffer_sink>(64);
+    sink->set_pattern("%v");
+    spdlog::logger logger("ring", sink);
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < 20000; i++) {
+                logger.info("thread {} message {:06d}", t, i);
+            }
+        });
+    }
+    size_t snapshots = 0;
+    size_t torn = 0;
+    std::thread reader([&] {
+        while (!done.load()) {
+            // each message returned is complete
+            for (auto &msg : sink->last_raw()) {
+                std::string payload(msg.payload.data(), msg.payload.size());
+                if (payload.size() != std::string("thread 0 message 000000").size() ||
+                    payload.compare(0, 7, "thread ") != 0) {
+                    torn++;
+                }
+            }
+            snapshots++;
+        }
+    });
+    for (auto &t : threads) {
+        t.join();
+    }
+    done = true;
+    reader.join();
+
+    REQUIRE(snapshots > 0);
+    REQUIRE(torn == 0);
+    REQUIRE(sink->last_formatted().size() == 64);
+}
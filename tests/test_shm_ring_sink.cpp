@@ -0,0 +1,128 @@
+#include "includes.h"
+#include "spdlog/sinks/shm_ring_sink.h"
+
+namespace {
+const std::string ring_name = "/spdlog_utests_ring";
+
+std::vector<std::string> read_all(spdlog::shm_ring_reader &reader, size_t max_records = 1000000) {
+    std::vector<std::string> records;
+    reader.poll(
+        [&](spdlog::string_view_t record) { records.emplace_back(record.data(), record.size()); },
+        max_records);
+    return records;
+}
+}  // namespace
+
+TEST_CASE("shm_ring_sink read back", "[shm_ring_sink]") {
+    spdlog::shm_ring_reader::remove(ring_name);
+    auto sink = std::make_shared<spdlog::sinks::shm_ring_sink_st>(ring_name, 4096);
+    sink->set_pattern("%v");
+    spdlog::logger logger("shm", sink);
+    spdlog::shm_ring_reader reader(ring_name);
+
+    logger.info("first");
+    logger.info("second message");
+    logger.info("");
+    auto records = read_all(reader);
+    REQUIRE(records.size() == 3);
+    REQUIRE(records[0] == "first" + std::string(spdlog::details::os::default_eol));
+    REQUIRE(records[1] == "second message" + std::string(spdlog::details::os::default_eol));
+    REQUIRE(records[2] == std::string(spdlog::details::os::default_eol));
+    REQUIRE(read_all(reader).empty());
+
+    logger.info("third");
+    logger.info("fourth");
+    REQUIRE(read_all(reader, 1).size() == 1);
+    REQUIRE(read_all(reader).size() == 1);
+    REQUIRE(sink->dropped() == 0);
+    spdlog::shm_ring_reader::remove(ring_name);
+}
+
+TEST_CASE("shm_ring_sink wrap around", "[shm_ring_sink]") {
+    spdlog::shm_ring_reader::remove(ring_name);
+    auto sink = std::make_shared<spdlog::sinks::shm_ring_sink_st>(ring_name, 4096);
+    sink->set_pattern("%v");
+    spdlog::logger logger("shm", sink);
+    spdlog::shm_ring_reader reader(ring_name);
+
+    // 8 + 100 + eol rounded up: not a divisor of the capacity, so the records wrap with a padding
+    for (int i = 0; i < 1000; i++) {
+        auto payload = std::to_string(i) + std::string(100, 'x');
+        logger.info(payload);
+        auto records = read_all(reader);
+        REQUIRE(records.size() == 1);
+        REQUIRE(records[0] == payload + spdlog::details::os::default_eol);
+    }
+    REQUIRE(sink->dropped() == 0);
+    spdlog::shm_ring_reader::remove(ring_name);
+}
+
+TEST_CASE("shm_ring_sink drops when full", "[shm_ring_sink]") {
+    spdlog::shm_ring_reader::remove(ring_name);
+    auto sink = std::make_shared<spdlog::sinks::shm_ring_sink_st>(ring_name, 4096);
+    sink->set_pattern("%v");
+    spdlog::logger logger("shm", sink);
+    spdlog::shm_ring_reader reader(ring_name);
+
+    // 128 bytes per record: 32 fit
+    auto payload = std::string(120 - std::strlen(spdlog::details::os::default_eol), 'x');
+    for (int i = 0; i < 40; i++) {
+        logger.info(payload);
+    }
+    REQUIRE(sink->dropped() == 8);
+    REQUIRE(reader.dropped() == 8);
+    REQUIRE(read_all(reader).size() == 32);
+
+    logger.info("after");
+    auto records = read_all(reader);
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0] == "after" + std::string(spdlog::details::os::default_eol));
+    spdlog::shm_ring_reader::remove(ring_name);
+}
+
+TEST_CASE("shm_ring_sink keeps an existing ring", "[shm_ring_sink]") {
+    spdlog::shm_ring_reader::remove(ring_name);
+    {
+        auto sink = std::make_shared<spdlog::sinks::shm_ring_sink_st>(ring_name, 4096);
+        sink->set_pattern("%v");
+        spdlog::logger("shm", sink).info("before restart");
+    }
+    auto sink = std::make_shared<spdlog::sinks::shm_ring_sink_st>(ring_name, 4096);
+    sink->set_pattern("%v");
+    spdlog::logger("shm", sink).info("after restart");
+    spdlog::shm_ring_reader reader(ring_name);
+    REQUIRE(read_all(reader).size() == 2);
+
+    // another capacity: a new ring
+    auto bigger = std::make_shared<spdlog::sinks::shm_ring_sink_st>(ring_name, 8192);
+    spdlog::shm_ring_reader other_reader(ring_name);
+    REQUIRE(read_all(other_reader).empty());
+    spdlog::shm_ring_reader::remove(ring_name);
+}
+
+TEST_CASE("shm_ring_sink binary records", "[shm_ring_sink]") {
+    spdlog::shm_ring_reader::remove(ring_name);
+    auto sink = std::make_shared<spdlog::sinks::shm_ring_sink_st>(ring_name, 4096);
+    sink->set_formatter(spdlog::details::make_unique<spdlog::binary_formatter>());
+    spdlog::logger logger("shm", sink);
+    spdlog::shm_ring_reader reader(ring_name);
+
+    logger.info("one");
+    logger.warn("two");
+    std::string stream;
+    reader.poll([&](spdlog::string_view_t record) { stream.append(record.data(), record.size()); });
+    spdlog::binary_log_reader binary_reader(stream);
+    spdlog::details::log_msg msg;
+    REQUIRE(binary_reader.next(msg));
+    REQUIRE(msg.payload == "one");
+    REQUIRE(binary_reader.next(msg));
+    REQUIRE(msg.payload == "two");
+    REQUIRE(msg.level == spdlog::level::warn);
+    REQUIRE_FALSE(binary_reader.next(msg));
+    spdlog::shm_ring_reader::remove(ring_name);
+}
+
+TEST_CASE("shm_ring_reader missing ring", "[shm_ring_sink]") {
+    spdlog::shm_ring_reader::remove(ring_name);
+    REQUIRE_THROWS_AS(spdlog::shm_ring_reader(ring_name), spdlog::spdlog_ex);
+}
@@ -25,6 +25,12 @@ public:
         return msg_counter_;
     }
 
+    // calls of log_batch()
+    size_t batch_counter() {
+        std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
+        return batch_counter_;
+    }
+
     size_t flush_counter() {
         std::lock_guard<Mutex> lock(base_sink<Mutex>::mutex_);
         return flush_counter_;
@@ -54,9 +60,15 @@ protected:
         std::this_thread::sleep_for(delay_);
     }
 
+    void sink_batch_(const details::log_msg *msgs, size_t count) override {
+        batch_counter_++;
+        base_sink<Mutex>::sink_batch_(msgs, count);
+    }
+
     void flush_() override { flush_counter_++; }
 
     size_t msg_counter_{0};
+    size_t batch_counter_{0};
     size_t flush_counter_{0};
     std::chrono::milliseconds delay_{std::chrono::milliseconds::zero()};
     std::vector<std::string> lines_;
@@ -0,0 +1,172 @@
+#include "includes.h"
+#include "test_sink.h"
+#include "spdlog/async.h"
+#include "spdlog/mdc.h"
+#include "spdlog/sinks/staged_sink.h"
+
+namespace {
+std::shared_ptr<spdlog::sinks::test_sink_st> filtered_sink(
+    std::shared_ptr<spdlog::sinks::sink_filter> filter) {
+    auto sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    sink->set_pattern("%v");
+    sink->set_filter(std::move(filter));
+    return sink;
+}
+}  // namespace
+
+TEST_CASE("sink_filter loggers", "[sink_filter]") {
+    auto filter = std::make_shared<spdlog::sinks::sink_filter>();
+    filter->loggers({"net", "db"});
+    auto sink = filtered_sink(filter);
+    spdlog::logger net("net", sink);
+    spdlog::logger db("db", sink);
+    spdlog::logger ui("ui", sink);
+    net.info("net");
+    ui.info("ui");
+    db.info("db");
+    REQUIRE(sink->lines() == std::vector<std::string>{"net", "db"});
+
+    // a sink's level still applies
+    sink->set_level(spdlog::level::warn);
+    net.info("info");
+    net.warn("warn");
+    REQUIRE(sink->lines().back() == "warn");
+    REQUIRE(sink->msg_counter() == 3);
+}
+
+TEST_CASE("sink_filter mdc", "[sink_filter]") {
+    auto filter = std::make_shared<spdlog::sinks::sink_filter>();
+    filter->mdc_key("request");
+    auto sink = filtered_sink(filter);
+    auto value_filter = std::make_shared<spdlog::sinks::sink_filter>();
+    value_filter->mdc_key("request", "42");
+    auto value_sink = filtered_sink(value_filter);
+    spdlog::logger logger("mdc", {sink, value_sink});
+
+    logger.info("without");
+    {
+        spdlog::mdc::scoped_put put("request", "41");
+        logger.info("41");
+    }
+    {
+        spdlog::mdc::scoped_put put("request", "42");
+        logger.info("42");
+    }
+    REQUIRE(sink->lines() == std::vector<std::string>{"41", "42"});
+    REQUIRE(value_sink->lines() == std::vector<std::string>{"42"});
+}
+
+TEST_CASE("sink_filter sample", "[sink_filter]") {
+    auto filter = std::make_shared<spdlog::sinks::sink_filter>();
+    filter->sample(0.25);
+    auto sink = filtered_sink(filter);
+    spdlog::logger logger("sample", sink);
+    for (int i = 0; i < 100; i++) {
+        logger.info("{}", i);
+    }
+    REQUIRE(sink->msg_counter() == 25);
+
+    auto none = std::make_shared<spdlog::sinks::sink_filter>();
+    none->sample(0);
+    auto all = std::make_shared<spdlog::sinks::sink_filter>();
+    all->sample(1);
+    auto none_sink = filtered_sink(none);
+    auto all_sink = filtered_sink(all);
+    spdlog::logger both("both", {none_sink, all_sink});
+    for (int i = 0; i < 10; i++) {
+        both.info("{}", i);
+    }
+    REQUIRE(none_sink->msg_counter() == 0);
+    REQUIRE(all_sink->msg_counter() == 10);
+
+    REQUIRE_THROWS_AS(filter->sample(1.5), spdlog::spdlog_ex);
+}
+
+TEST_CASE("sink_filter predicate and async batches", "[sink_filter]") {
+    auto filter = std::make_shared<spdlog::sinks::sink_filter>();
+    filter->predicate([](const spdlog::details::log_msg &msg) { return msg.payload.size() == 1; });
+    auto sink = std::make_shared<spdlog::sinks::test_sink_mt>();
+    sink->set_pattern("%v");
+    sink->set_filter(filter);
+    {
+        spdlog::details::thread_pool_options options(128, 1);
+        options.batch_size = 16;
+        auto tp = std::make_shared<spdlog::details::thread_pool>(std::move(options));
+        auto logger = std::make_shared<spdlog::async_logger>("as", sink, tp);
+        for (int i = 0; i < 100; i++) {
+            logger->info("{}", i);
+        }
+    }
+    REQUIRE(sink->msg_counter() == 10);
+    REQUIRE(sink->lines().back() == "9");
+
+    sink->set_filter(nullptr);
+    spdlog::logger logger("sync", sink);
+    logger.info("kept");
+    REQUIRE(sink->lines().back() == "kept");
+}
+
+namespace {
+struct every_other {
+    int n = 0;
+    bool pre_format(spdlog::details::log_msg &) { return n++ % 2 == 0; }
+};
+
+struct tag_payload {
+    std::string payload;
+    bool pre_format(spdlog::details::log_msg &msg) {
+        payload.assign("tagged ");
+        payload.append(msg.payload.data(), msg.payload.size());
+        msg.payload = spdlog::string_view_t(payload.data(), payload.size());
+        return true;
+    }
+};
+
+struct redact_digits {
+    void post_format(const spdlog::details::log_msg &, spdlog::memory_buf_t &formatted) {
+        std::replace_if(
+            formatted.begin(), formatted.end(), [](char c) { return c >= '0' && c <= '9'; },
+            '#');
+    }
+    unsigned needed_fields() const { return spdlog::msg_field::thread_id; }
+};
+}  // namespace
+
+TEST_CASE("staged sink", "[staged_sink]") {
+    using spdlog::sinks::staged_sink;
+    auto sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    REQUIRE(spdlog::sinks::make_staged_sink<spdlog::details::null_mutex>(sink) == sink);
+
+    auto staged = std::make_shared<
+        staged_sink<spdlog::details::null_mutex, every_other, tag_payload, redact_digits>>(
+        sink, every_other{}, tag_payload{}, redact_digits{});
+    staged->set_pattern("%v");
+    REQUIRE(staged->needed_fields() == (sink->needed_fields() | spdlog::msg_field::thread_id));
+    spdlog::logger logger("staged", staged);
+    for (int i = 0; i < 4; i++) {
+        logger.info("message {}", i);
+    }
+    REQUIRE(sink->lines() == std::vector<std::string>{"tagged message #", "tagged message #"});
+    REQUIRE(staged->stage<0>().n == 4);
+
+    // batches go through the stages too
+    spdlog::details::log_msg msgs[2] = {
+        spdlog::details::log_msg("staged", spdlog::level::info, "batch 1"),
+        spdlog::details::log_msg("staged", spdlog::level::info, "batch 2")};
+    staged->log_batch(msgs, 2);
+    REQUIRE(sink->lines().back() == "tagged batch #");
+    REQUIRE(sink->msg_counter() == 3);
+
+    // a post format stage only
+    auto redacted = spdlog::sinks::make_staged_sink<spdlog::details::null_mutex>(
+        sink, redact_digits{});
+    redacted->set_pattern("[%n] %v");
+    spdlog::logger redacted_logger("l2", redacted);
+    redacted_logger.info("42");
+    REQUIRE(sink->lines().back() == "[l#] ##");
+
+    // the level of the sink still applies
+    sink->set_level(spdlog::level::warn);
+    redacted_logger.info("dropped");
+    REQUIRE(sink->msg_counter() == 4);
+}
@@ -0,0 +1,133 @@
+#include "includes.h"
+#include "spdlog/sinks/spill_sink.h"
+
+#include <thread>
+
+namespace {
+const spdlog::filename_t spill_filename = SPDLOG_FILENAME_T("test_logs/spill.bin");
+
+// keeps the payloads, throwing while failing
+class flaky_sink final : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    std::atomic<bool> failing{false};
+
+    std::vector<std::string> payloads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return payloads_;
+    }
+
+    // wait up to 5 seconds for count payloads
+    std::vector<std::string> wait_payloads(size_t count) {
+        for (int i = 0; i < 500 && payloads().size() < count; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return payloads();
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override {
+        if (failing) {
+            throw spdlog::spdlog_ex("flaky_sink: failing");
+        }
+        payloads_.emplace_back(msg.payload.data(), msg.payload.size());
+    }
+    void flush_() override {}
+
+private:
+    std::vector<std::string> payloads_;
+};
+
+spdlog::sinks::spill_sink_config test_config() {
+    spdlog::details::os::create_dir(SPDLOG_FILENAME_T("test_logs"));
+    spdlog::details::os::remove(spill_filename);
+    spdlog::details::os::remove(spill_filename + SPDLOG_FILENAME_T(".replay"));
+    spdlog::sinks::spill_sink_config cfg(spill_filename);
+    cfg.retry_min_delay = std::chrono::milliseconds(1);
+    cfg.retry_max_delay = std::chrono::milliseconds(5);
+    return cfg;
+}
+
+std::vector<std::string> numbers(int first, int last) {
+    std::vector<std::string> ret;
+    for (int i = first; i < last; i++) {
+        ret.push_back(std::to_string(i));
+    }
+    return ret;
+}
+}  // namespace
+
+TEST_CASE("spill_sink pass through", "[spill_sink]") {
+    auto downstream = std::make_shared<flaky_sink>();
+    auto sink = std::make_shared<spdlog::sinks::spill_sink_mt>(downstream, test_config());
+    spdlog::logger logger("spill", sink);
+    for (int i = 0; i < 100; i++) {
+        logger.info("{}", i);
+    }
+    REQUIRE(downstream->wait_payloads(100) == numbers(0, 100));
+    REQUIRE(get_filesize(SPDLOG_FILENAME_T("test_logs/spill.bin")) == 0);
+    REQUIRE(sink->dropped() == 0);
+}
+
+TEST_CASE("spill_sink spills and replays in order", "[spill_sink]") {
+    auto downstream = std::make_shared<flaky_sink>();
+    downstream->failing = true;
+    auto cfg = test_config();
+    cfg.max_memory_bytes = 10 * (sizeof(spdlog::details::log_msg_buffer) + 16);
+    auto sink = std::make_shared<spdlog::sinks::spill_sink_mt>(downstream, cfg);
+    spdlog::logger logger("spill", sink);
+    for (int i = 0; i < 100; i++) {
+        logger.info("{}", i);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(downstream->payloads().empty());
+
+    downstream->failing = false;
+    for (int i = 100; i < 150; i++) {
+        logger.info("{}", i);
+    }
+    REQUIRE(downstream->wait_payloads(150) == numbers(0, 150));
+    REQUIRE_FALSE(spdlog::details::os::path_exists(spill_filename + SPDLOG_FILENAME_T(".replay")));
+    REQUIRE(sink->dropped() == 0);
+}
+
+TEST_CASE("spill_sink keeps the spill file for the next sink", "[spill_sink]") {
+    auto cfg = test_config();
+    cfg.max_memory_bytes = 10 * (sizeof(spdlog::details::log_msg_buffer) + 16);
+    {
+        auto downstream = std::make_shared<flaky_sink>();
+        downstream->failing = true;
+        auto sink = std::make_shared<spdlog::sinks::spill_sink_mt>(downstream, cfg);
+        spdlog::logger logger("spill", sink);
+        for (int i = 0; i < 100; i++) {
+            logger.info("{}", i);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        sink.reset();
+        logger.sinks().clear();
+    }
+    auto downstream = std::make_shared<flaky_sink>();
+    auto sink = std::make_shared<spdlog::sinks::spill_sink_mt>(downstream, cfg);
+    spdlog::logger logger("spill", sink);
+    logger.info("after restart");
+    auto payloads = downstream->wait_payloads(81);
+    // the first ones were in memory (dropped), the others in the spill files, kept in order
+    REQUIRE(payloads.size() > 80);
+    REQUIRE(payloads.back() == "after restart");
+    payloads.pop_back();
+    REQUIRE(payloads == numbers(100 - static_cast<int>(payloads.size()), 100));
+}
+
+TEST_CASE("spill_sink max_spill_bytes", "[spill_sink]") {
+    auto downstream = std::make_shared<flaky_sink>();
+    downstream->failing = true;
+    auto cfg = test_config();
+    cfg.max_memory_bytes = 0;
+    cfg.max_spill_bytes = 1;
+    auto sink = std::make_shared<spdlog::sinks::spill_sink_mt>(downstream, cfg);
+    spdlog::logger logger("spill", sink);
+    logger.info("spilled as the spill file is empty");
+    logger.info("dropped");
+    REQUIRE(sink->dropped() == 1);
+    downstream->failing = false;
+    REQUIRE(downstream->wait_payloads(1).size() == 1);
+}
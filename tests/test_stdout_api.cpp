@@ -5,6 +5,12 @@
 #include "includes.h"
 #include "spdlog/sinks/stdout_sinks.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
+
+#include <thread>
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
 TEST_CASE("stdout_st", "[stdout]") {
     auto l = spdlog::stdout_logger_st("test");
     l->set_pattern("%+");
@@ -62,6 +68,127 @@ TEST_CASE("stderr_color_st", "[stderr]") {
     spdlog::drop_all();
 }
 
+#ifndef _WIN32
+TEST_CASE("ansicolor_sink colors", "[stdout]") {
+    std::FILE *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    auto sink = std::make_shared<spdlog::sinks::ansicolor_sink<spdlog::details::console_nullmutex>>(
+        file, spdlog::color_mode::always);
+    spdlog::logger logger("test", sink);
+    logger.set_pattern("[%^%l%$] %v");
+    sink->set_color(spdlog::level::warn, sink->magenta);
+    logger.info("Test ansicolor");
+    logger.warn("Test ansicolor");
+    logger.set_pattern("%v");
+    logger.error("no color range");
+
+    std::rewind(file);
+    std::string content;
+    char buf[256];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+        content.append(buf, n);
+    }
+    std::fclose(file);
+    auto eol = std::string(spdlog::details::os::default_eol);
+    REQUIRE(content == "[\033[32minfo\033[m] Test ansicolor" + eol +
+                           "[\033[35mwarning\033[m] Test ansicolor" + eol + "no color range" + eol);
+}
+
+TEST_CASE("buffered_stdout_sink", "[stdout]") {
+    std::FILE *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    auto read_all = [file] {
+        std::rewind(file);
+        std::string content;
+        char buf[256];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+            content.append(buf, n);
+        }
+        return content;
+    };
+    spdlog::sinks::stdout_buffer_options options;
+    options.buffer_size = 64;
+    options.flush_level = spdlog::level::err;
+    options.max_delay = std::chrono::milliseconds(0);
+    auto sink =
+        std::make_shared<spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_mutex>>(
+            file, options);
+    spdlog::logger logger("test", sink);
+    logger.set_pattern("%v");
+    auto eol = std::string(spdlog::details::os::default_eol);
+
+    logger.info("buffered");
+    logger.warn("buffered");
+    REQUIRE(read_all().empty());
+    // written with the messages before it
+    logger.error("error");
+    REQUIRE(read_all() == "buffered" + eol + "buffered" + eol + "error" + eol);
+    // written once the buffer is full
+    logger.info(std::string(100, 'x'));
+    REQUIRE(read_all().size() == 3 * eol.size() + 21 + 100 + eol.size());
+    logger.info("flushed");
+    logger.flush();
+    REQUIRE(read_all().size() == 4 * eol.size() + 21 + 100 + 7 + eol.size());
+    std::fclose(file);
+}
+
+TEST_CASE("buffered_stdout_sink in the background", "[stdout]") {
+    // a pipe nobody reads yet, as a blocked terminal
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    std::FILE *file = ::fdopen(fds[1], "w");
+    REQUIRE(file != nullptr);
+    spdlog::sinks::stdout_buffer_options options;
+    options.buffer_size = 1024;
+    options.max_delay = std::chrono::milliseconds(0);
+    options.background = true;
+    options.max_pending = 64 * 1024;
+    auto sink =
+        std::make_shared<spdlog::sinks::buffered_stdout_sink_base<spdlog::details::console_mutex>>(
+            file, options);
+    spdlog::logger logger("test", sink);
+    logger.set_pattern("%v");
+
+    // more than the pipe and the pending buffer hold: dropped instead of blocking
+    const std::string message(100, 'x');
+    const size_t n_messages = 10000;
+    for (size_t i = 0; i < n_messages; i++) {
+        logger.info(message);
+    }
+    auto dropped = sink->dropped();
+    REQUIRE(dropped > 0);
+
+    std::string received;
+    std::thread reader([&] {
+        char buf[4096];
+        ssize_t n;
+        while ((n = ::read(fds[0], buf, sizeof(buf))) > 0) {
+            received.append(buf, static_cast<size_t>(n));
+        }
+    });
+    logger.flush();
+    REQUIRE(sink->dropped() == dropped);
+    logger.sinks().clear();
+    sink.reset();
+    std::fclose(file);
+    reader.join();
+    ::close(fds[0]);
+    auto eol = std::string(spdlog::details::os::default_eol);
+    REQUIRE(received.size() == (n_messages - dropped) * (message.size() + eol.size()));
+}
+
+#endif
+
+TEST_CASE("buffered_stdout_logger", "[stdout]") {
+    auto l = spdlog::buffered_stdout_logger_mt("test");
+    l->set_pattern("%+");
+    l->info("Test buffered_stdout_logger_mt");
+    l->warn("Test buffered_stdout_logger_mt");
+    spdlog::drop_all();
+}
+
 TEST_CASE("stderr_color_mt", "[stderr]") {
     auto l = spdlog::stderr_color_mt("test");
     l->set_pattern("%+");
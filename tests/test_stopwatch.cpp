@@ -1,6 +1,7 @@
 #include "includes.h"
 #include "test_sink.h"
 #include "spdlog/stopwatch.h"
+#include "spdlog/profiler.h"
 
 TEST_CASE("stopwatch1", "[stopwatch]") {
     using std::chrono::milliseconds;
@@ -40,3 +41,74 @@ TEST_CASE("stopwatch2", "[stopwatch]") {
     REQUIRE(val >= (diff_duration).count() - 0.001);
     REQUIRE(val <= (diff_duration + tolerance_duration).count());
 }
+
+TEST_CASE("tsc_stopwatch", "[stopwatch]") {
+    using std::chrono::milliseconds;
+    using clock = std::chrono::steady_clock;
+    // take the calibration samples
+    spdlog::tsc_stopwatch calibrating;
+    std::this_thread::sleep_for(milliseconds(20));
+    spdlog::details::tsc_clock::now();
+    if (spdlog::details::tsc_clock::available()) {
+        REQUIRE(spdlog::details::tsc_clock::ns_per_tick() > 0);
+    }
+
+    milliseconds wait_ms(200);
+    milliseconds tolerance_ms(250);
+    auto start = clock::now();
+    spdlog::tsc_stopwatch sw;
+    std::this_thread::sleep_for(wait_ms);
+    auto stop = clock::now();
+    auto diff_ms = std::chrono::duration_cast<milliseconds>(stop - start);
+    // within the calibration's error
+    REQUIRE(sw.elapsed_ms() >= diff_ms - milliseconds(2));
+    REQUIRE(sw.elapsed() <= diff_ms + tolerance_ms);
+    REQUIRE(std::stod(spdlog::fmt_lib::format("{}", sw)) >= 0.19);
+
+    sw.reset();
+    REQUIRE(sw.elapsed() < milliseconds(100));
+}
+
+namespace {
+void profiled(std::chrono::milliseconds sleep) {
+    SPDLOG_PROFILE_SCOPE("test profiled");
+    std::this_thread::sleep_for(sleep);
+}
+
+spdlog::latency_snapshot profile_of(const std::string &name) {
+    for (auto &snapshot : spdlog::profile_snapshots()) {
+        if (snapshot.name == name) {
+            return snapshot.durations;
+        }
+    }
+    return spdlog::latency_snapshot{};
+}
+}  // namespace
+
+TEST_CASE("profile scope", "[stopwatch]") {
+    auto before = profile_of("test profiled");
+    profiled(std::chrono::milliseconds(5));
+    std::thread([] {
+        profiled(std::chrono::milliseconds(0));
+        SPDLOG_PROFILE_SCOPE("test profiled");  // same name, other scope
+    }).join();
+    auto after = profile_of("test profiled");
+    REQUIRE(after.count - before.count == 3);  // the exited thread's durations are kept
+    REQUIRE(after.total_ns - before.total_ns >= 5000000);
+
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    auto logger = std::make_shared<spdlog::logger>("profile", test_sink);
+    logger->set_pattern("%v");
+    spdlog::profile_reporter reporter(logger, std::chrono::milliseconds(0));
+    reporter.report();
+    auto reported = test_sink->msg_counter();
+    REQUIRE(reported >= 1);
+    reporter.report();  // nothing since
+    REQUIRE(test_sink->msg_counter() == reported);
+    profiled(std::chrono::milliseconds(2));
+    reporter.report();
+    REQUIRE(test_sink->msg_counter() == reported + 1);
+    auto line = test_sink->lines().back();
+    REQUIRE(line.find("profile test profiled: 1 calls, mean ") == 0);
+    REQUIRE(line.find("ms, p50 ") != std::string::npos);
+}
@@ -12,3 +12,15 @@ TEST_CASE("systemd", "[all]") {
     SPDLOG_LOGGER_ERROR((&logger), "test spdlog error");
     SPDLOG_LOGGER_CRITICAL((&logger), "test spdlog critical");
 }
+
+#ifndef SPDLOG_NO_TLS
+    #include "spdlog/mdc.h"
+
+TEST_CASE("systemd mdc fields", "[all]") {
+    auto systemd_sink = std::make_shared<spdlog::sinks::systemd_sink_st>("spdlog_test");
+    spdlog::logger logger("spdlog_systemd_test", systemd_sink);
+    spdlog::mdc::scoped_put request("request-id", "42");
+    spdlog::mdc::scoped_put skipped("_not_a_field", "x");
+    SPDLOG_LOGGER_INFO((&logger), "test spdlog info with mdc fields");
+}
+#endif
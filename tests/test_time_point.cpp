@@ -1,6 +1,7 @@
 #include "includes.h"
 #include "test_sink.h"
 #include "spdlog/async.h"
+#include "spdlog/sinks/callback_sink.h"
 
 TEST_CASE("time_point1", "[time_point log_msg]") {
     std::shared_ptr<spdlog::sinks::test_sink_st> test_sink(new spdlog::sinks::test_sink_st);
@@ -33,3 +34,103 @@ TEST_CASE("time_point1", "[time_point log_msg]") {
     REQUIRE(lines[8] != lines[9]);
     spdlog::drop_all();
 }
+
+static bool near_system_time(spdlog::log_clock::time_point tp,
+                             spdlog::log_clock::time_point before,
+                             spdlog::log_clock::time_point after) {
+    auto tolerance = std::chrono::milliseconds(50);
+    return tp >= before - tolerance && tp <= after + tolerance;
+}
+
+TEST_CASE("clock sources", "[time_point]") {
+    using spdlog::clock_source;
+    for (auto source : {clock_source::standard, clock_source::coarse, clock_source::tsc}) {
+        auto before = spdlog::log_clock::now();
+        auto tp = spdlog::details::os::now(source);
+        auto after = spdlog::log_clock::now();
+        REQUIRE(near_system_time(tp, before, after));
+    }
+
+    // past the first calibration, the tsc clock keeps following the system clock
+    auto start = spdlog::log_clock::now();
+    auto last = spdlog::details::tsc_clock::now();
+    while (spdlog::log_clock::now() - start < std::chrono::milliseconds(30)) {
+        auto before = spdlog::log_clock::now();
+        last = spdlog::details::tsc_clock::now();
+        auto after = spdlog::log_clock::now();
+        REQUIRE(near_system_time(last, before, after));
+    }
+}
+
+TEST_CASE("logger clock", "[time_point]") {
+    auto test_sink = std::make_shared<spdlog::sinks::test_sink_st>();
+    spdlog::logger logger("test-clock", test_sink);
+    REQUIRE(logger.clock() == spdlog::clock_source::standard);
+    logger.set_clock(spdlog::clock_source::tsc);
+    auto cloned = logger.clone("test-clock-clone");
+    REQUIRE(cloned->clock() == spdlog::clock_source::tsc);
+
+    test_sink->set_pattern("%E");
+    auto before = std::chrono::duration_cast<std::chrono::seconds>(
+                      spdlog::log_clock::now().time_since_epoch())
+                      .count();
+    logger.info("message");
+    cloned->info("message");
+    auto after = std::chrono::duration_cast<std::chrono::seconds>(
+                     spdlog::log_clock::now().time_since_epoch())
+                     .count();
+    for (const auto &line : test_sink->lines()) {
+        auto seconds = std::stoll(line);
+        REQUIRE(seconds >= before - 1);
+        REQUIRE(seconds <= after + 1);
+    }
+    REQUIRE(test_sink->lines().size() == 2);
+}
+
+TEST_CASE("deferred tsc clock", "[time_point]") {
+    struct sunk {
+        bool tsc_time;
+        spdlog::log_clock::time_point time, before, after;
+    };
+    std::mutex mutex;
+    std::vector<sunk> times;
+    spdlog::log_clock::time_point before;
+    // the sinks get converted times
+    auto sink = std::make_shared<spdlog::sinks::callback_sink_mt>(
+        [&](const spdlog::details::log_msg &msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+            times.push_back(sunk{msg.tsc_time, msg.time, before, spdlog::log_clock::now()});
+        });
+    auto tp = std::make_shared<spdlog::details::thread_pool>(128, 1);
+    auto async = std::make_shared<spdlog::async_logger>("as", sink, tp);
+    spdlog::logger sync("sync", sink);
+    async->set_clock(spdlog::clock_source::tsc_deferred);
+    sync.set_clock(spdlog::clock_source::tsc_deferred);
+
+    // tsc until calibrated, then the raw counter
+    auto start = spdlog::log_clock::now();
+    while (spdlog::log_clock::now() - start < std::chrono::milliseconds(30)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            before = spdlog::log_clock::now();
+        }
+        sync.info("message");
+        async->info("message");
+        async->flush();
+    }
+    spdlog::details::log_msg msg(spdlog::source_loc{}, "raw", spdlog::level::info, "message",
+                                 spdlog::msg_field::time, spdlog::clock_source::tsc_deferred);
+#ifdef SPDLOG_HAS_TSC_CLOCK
+    REQUIRE(msg.tsc_time == spdlog::details::tsc_clock::available());
+#endif
+    msg.resolve_time();
+    REQUIRE_FALSE(msg.tsc_time);
+    REQUIRE(near_system_time(msg.time, start, spdlog::log_clock::now()));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(times.size() > 2);
+    for (const auto &t : times) {
+        REQUIRE_FALSE(t.tsc_time);
+        REQUIRE(near_system_time(t.time, t.before, t.after));
+    }
+}
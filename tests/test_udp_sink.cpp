@@ -0,0 +1,102 @@
+#include "includes.h"
+#include "spdlog/sinks/udp_sink.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+// bound to a port of 127.0.0.1, receiving the datagrams
+class test_receiver {
+public:
+    test_receiver() {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        timeval timeout{1, 0};
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~test_receiver() { ::close(fd_); }
+
+    uint16_t port() const { return port_; }
+
+    // the datagrams received until none comes for a second
+    std::vector<std::string> receive(size_t count) {
+        std::vector<std::string> datagrams;
+        char buf[65536];
+        while (datagrams.size() < count) {
+            auto n = ::recv(fd_, buf, sizeof(buf), 0);
+            if (n < 0) {
+                break;
+            }
+            datagrams.emplace_back(buf, static_cast<size_t>(n));
+        }
+        return datagrams;
+    }
+
+private:
+    int fd_;
+    uint16_t port_;
+};
+
+std::vector<spdlog::details::log_msg> make_batch(const std::vector<std::string> &payloads) {
+    std::vector<spdlog::details::log_msg> msgs;
+    for (auto &payload : payloads) {
+        msgs.emplace_back("udp", spdlog::level::info, payload);
+    }
+    return msgs;
+}
+}  // namespace
+
+TEST_CASE("udp_sink batch", "[udp_sink]") {
+    test_receiver receiver;
+    spdlog::sinks::udp_sink_st sink({"127.0.0.1", receiver.port()});
+    sink.set_pattern("%v");
+
+    std::vector<std::string> payloads;
+    for (int i = 0; i < 100; i++) {
+        payloads.push_back("message " + std::to_string(i));
+    }
+    auto msgs = make_batch(payloads);
+    sink.log_batch(msgs.data(), msgs.size());
+
+    auto datagrams = receiver.receive(100);
+    REQUIRE(datagrams.size() == 100);
+    REQUIRE(datagrams[0] == "message 0" + std::string(spdlog::details::os::default_eol));
+    REQUIRE(datagrams[99] == "message 99" + std::string(spdlog::details::os::default_eol));
+}
+
+TEST_CASE("udp_sink packed batch", "[udp_sink]") {
+    test_receiver receiver;
+    spdlog::sinks::udp_sink_config cfg("127.0.0.1", receiver.port());
+    cfg.max_datagram_size = 100;
+    spdlog::sinks::udp_sink_st sink(cfg);
+    sink.set_pattern("%v|");
+
+    // 11 bytes each with the eol: 9 per datagram, and the big one alone
+    std::vector<std::string> payloads(25, "123456789");
+    payloads.push_back(std::string(200, 'x'));
+    payloads.push_back("123456789");
+    auto msgs = make_batch(payloads);
+    sink.log_batch(msgs.data(), msgs.size());
+
+    std::string record = "123456789|" + std::string(spdlog::details::os::default_eol);
+    std::string full;
+    for (int i = 0; i < 9; i++) {
+        full += record;
+    }
+    auto datagrams = receiver.receive(6);
+    REQUIRE(datagrams.size() == 5);
+    REQUIRE(datagrams[0] == full);
+    REQUIRE(datagrams[1] == full);
+    REQUIRE(datagrams[2].size() == 7 * record.size());
+    REQUIRE(datagrams[3] == std::string(200, 'x') + "|" + spdlog::details::os::default_eol);
+    REQUIRE(datagrams[4] == record);
+}
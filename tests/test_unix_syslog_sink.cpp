@@ -0,0 +1,132 @@
+#include "includes.h"
+#include "spdlog/sinks/unix_syslog_sink.h"
+
+#include <regex>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+const std::string socket_path = "test_logs/syslog.sock";
+
+// bound to socket_path, receiving the datagrams like the syslog daemon
+class test_receiver {
+public:
+    test_receiver() {
+        spdlog::details::os::create_dir("test_logs");
+        ::unlink(socket_path.c_str());
+        fd_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, socket_path.c_str());
+        ::bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        timeval timeout{1, 0};
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~test_receiver() {
+        ::close(fd_);
+        ::unlink(socket_path.c_str());
+    }
+
+    // the datagrams received until none comes for a second
+    std::vector<std::string> receive(size_t count) {
+        std::vector<std::string> datagrams;
+        char buf[65536];
+        while (datagrams.size() < count) {
+            auto n = ::recv(fd_, buf, sizeof(buf), 0);
+            if (n < 0) {
+                break;
+            }
+            datagrams.emplace_back(buf, static_cast<size_t>(n));
+        }
+        return datagrams;
+    }
+
+private:
+    int fd_;
+};
+
+std::string header_regex(int pri, const std::string &app_name) {
+    return "<" + std::to_string(pri) +
+           ">1 \\d{4}-\\d\\d-\\d\\dT\\d\\d:\\d\\d:\\d\\d\\.\\d{6}Z - " + app_name + " " +
+           std::to_string(spdlog::details::os::pid()) + " - - ";
+}
+}  // namespace
+
+TEST_CASE("rfc5424 frame", "[unix_syslog_sink]") {
+    test_receiver receiver;
+    spdlog::rfc5424_options options;
+    options.app_name = "my app";
+    spdlog::sinks::unix_syslog_sink_st sink(options, socket_path);
+
+    sink.log(spdlog::details::log_msg("syslog", spdlog::level::info, "hello"));
+    sink.log(spdlog::details::log_msg("syslog", spdlog::level::err, "failed"));
+
+    auto datagrams = receiver.receive(2);
+    REQUIRE(datagrams.size() == 2);
+    REQUIRE(std::regex_match(datagrams[0], std::regex(header_regex(14, "myapp") + "hello")));
+    REQUIRE(std::regex_match(datagrams[1], std::regex(header_regex(11, "myapp") + "failed")));
+}
+
+TEST_CASE("unix_syslog_sink batch", "[unix_syslog_sink]") {
+    test_receiver receiver;
+    spdlog::sinks::unix_syslog_sink_st sink({}, socket_path);
+    sink.set_pattern("[%n] %v");
+
+    std::vector<spdlog::details::log_msg> msgs;
+    std::vector<std::string> payloads;
+    for (int i = 0; i < 100; i++) {
+        payloads.push_back("message " + std::to_string(i));
+    }
+    for (auto &payload : payloads) {
+        msgs.emplace_back("syslog", spdlog::level::warn, payload);
+    }
+    // the sends block once the receiver's queue is full (10 datagrams by default on linux)
+    std::vector<std::string> datagrams;
+    std::thread reader([&] { datagrams = receiver.receive(100); });
+    sink.log_batch(msgs.data(), msgs.size());
+    reader.join();
+
+    REQUIRE(datagrams.size() == 100);
+    std::string header = header_regex(12, "-");
+    REQUIRE(std::regex_match(datagrams[0], std::regex(header + "\\[syslog\\] message 0")));
+    REQUIRE(std::regex_match(datagrams[99], std::regex(header + "\\[syslog\\] message 99")));
+}
+
+TEST_CASE("unix_syslog_sink reconnect", "[unix_syslog_sink]") {
+    std::unique_ptr<test_receiver> receiver(new test_receiver);
+    spdlog::sinks::unix_syslog_sink_st sink({}, socket_path);
+    sink.log(spdlog::details::log_msg("syslog", spdlog::level::info, "first"));
+    REQUIRE(receiver->receive(1).size() == 1);
+
+    // the daemon restarted
+    receiver.reset();
+    receiver.reset(new test_receiver);
+    sink.log(spdlog::details::log_msg("syslog", spdlog::level::info, "second"));
+    auto datagrams = receiver->receive(1);
+    REQUIRE(datagrams.size() == 1);
+    REQUIRE(std::regex_match(datagrams[0], std::regex(header_regex(14, "-") + "second")));
+}
+
+TEST_CASE("rfc5424 octet counting", "[unix_syslog_sink]") {
+    spdlog::rfc5424_options options;
+    options.facility = 16;
+    options.hostname = "host";
+    options.msgid = "id";
+    options.octet_counting = true;
+    spdlog::rfc5424_formatter formatter(options);
+
+    spdlog::memory_buf_t formatted;
+    formatter.format(spdlog::details::log_msg("syslog", spdlog::level::critical, "payload"),
+                     formatted);
+    std::string frame(formatted.data(), formatted.size());
+    auto space = frame.find(' ');
+    REQUIRE(space != std::string::npos);
+    REQUIRE(std::stoul(frame.substr(0, space)) == frame.size() - space - 1);
+    auto rest = frame.substr(space + 1);
+    REQUIRE(rest.compare(0, 6, "<130>1") == 0);
+    REQUIRE(rest.find(" host - " + std::to_string(spdlog::details::os::pid()) + " id - payload") !=
+            std::string::npos);
+}
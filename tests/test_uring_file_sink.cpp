@@ -0,0 +1,61 @@
+#include "includes.h"
+#include "spdlog/sinks/uring_file_sink.h"
+
+#define URING_FILENAME "test_logs/uring_log.txt"
+
+using spdlog::sinks::uring_file_sink_mt;
+
+static std::shared_ptr<uring_file_sink_mt> make_uring_sink(size_t buffer_size,
+                                                           size_t buffers,
+                                                           bool sync_on_flush = false) {
+    try {
+        return std::make_shared<uring_file_sink_mt>(SPDLOG_FILENAME_T(URING_FILENAME), false,
+                                                    buffer_size, buffers, sync_on_flush);
+    } catch (const spdlog::spdlog_ex &) {
+        return nullptr;  // io_uring not available (e.g. disabled in the container)
+    }
+}
+
+TEST_CASE("uring_file_sink", "[uring_file_sink]") {
+    prepare_logdir();
+    {
+        auto sink = make_uring_sink(64, 2);
+        if (!sink) {
+            WARN("io_uring not available");
+            return;
+        }
+        spdlog::logger logger("uring_logger", sink);
+        logger.set_pattern("%v");
+        for (int i = 0; i < 100; i++) {
+            logger.info("Test message {}", i);
+        }
+        logger.flush();
+    }
+    std::string expected;
+    for (int i = 0; i < 100; i++) {
+        expected +=
+            spdlog::fmt_lib::format("Test message {}{}", i, spdlog::details::os::default_eol);
+    }
+    REQUIRE(file_contents(URING_FILENAME) == expected);
+}
+
+TEST_CASE("uring_file_sink appends and syncs", "[uring_file_sink]") {
+    prepare_logdir();
+    for (int round = 0; round < 2; round++) {
+        auto sink = make_uring_sink(1024, 4, true);
+        if (!sink) {
+            WARN("io_uring not available");
+            return;
+        }
+        spdlog::logger logger("uring_logger", sink);
+        logger.set_pattern("%v");
+        logger.info(std::string(3000, 'a' + static_cast<char>(round)));  // spans buffers
+        logger.flush();
+        logger.info("short");
+        logger.flush();
+        logger.flush();
+    }
+    auto eol = std::string(spdlog::details::os::default_eol);
+    REQUIRE(file_contents(URING_FILENAME) == std::string(3000, 'a') + eol + "short" + eol +
+                                                  std::string(3000, 'b') + eol + "short" + eol);
+}
@@ -0,0 +1,77 @@
+//
+// Copyright(c) 2015 Gabi Melman.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+// Print the files written with spdlog::binary_formatter as text.
+//
+// Usage: binary_decoder [-p pattern] [-u] file...
+//   -p pattern  the pattern_formatter pattern of the lines (spdlog's default pattern if omitted)
+//   -u          print the times in utc instead of local time
+
+#include "spdlog/binary_formatter.h"
+#include "spdlog/pattern_formatter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static void usage() {
+    std::fprintf(stderr, "Usage: binary_decoder [-p pattern] [-u] file...\n");
+}
+
+static bool read_file(const char *filename, std::string &content) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+int main(int argc, char *argv[]) {
+    std::string pattern = "%+";
+    auto time_type = spdlog::pattern_time_type::local;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            pattern = argv[++i];
+        } else if (std::strcmp(argv[i], "-u") == 0) {
+            time_type = spdlog::pattern_time_type::utc;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        usage();
+        return 1;
+    }
+
+    spdlog::pattern_formatter formatter(pattern, time_type);
+    spdlog::memory_buf_t line;
+    std::string content;
+    for (auto filename : files) {
+        if (!read_file(filename, content)) {
+            std::fprintf(stderr, "binary_decoder: failed opening %s\n", filename);
+            return 1;
+        }
+        try {
+            spdlog::binary_log_reader reader(spdlog::string_view_t(content.data(), content.size()));
+            spdlog::details::log_msg msg;
+            while (reader.next(msg)) {
+                line.clear();
+                formatter.format(msg, line);
+                std::fwrite(line.data(), 1, line.size(), stdout);
+            }
+        } catch (const std::exception &ex) {
+            std::fprintf(stderr, "binary_decoder: %s: %s\n", filename, ex.what());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,401 @@
+//
+// Copyright(c) 2015 Gabi Melman.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+// Receive the logs of many tcp_sink and udp_sink clients (linux, with epoll) and write them to
+// one file, each read being written as a batch (see sink::log_batch()).
+//
+// Usage: log_receiver [-t port] [-u port] [-b] [-z] [-d file] [-p pattern] [-o file]
+//   -t port     accept the tcp_sink connections on this port
+//   -u port     receive the udp_sink datagrams on this port
+//   -b          the tcp clients use the binary_formatter: their records are decoded and written
+//               with the pattern (the udp datagrams can't be decoded alone, so -u is text only)
+//   -z          the tcp clients compress their stream (buffered_tcp_sink_config::compression_level,
+//               needs SPDLOG_ZLIB)
+//   -d file     the preset dictionary of the compression, if the clients use one
+//   -p pattern  the pattern of the decoded records (spdlog's default pattern if omitted)
+//   -o file     the file written (stdout if omitted)
+//
+// In text mode, the lines received are written as they are. The file is flushed every second,
+// and on SIGINT or SIGTERM before exiting.
+
+#include "spdlog/binary_formatter.h"
+#include "spdlog/details/log_msg_buffer.h"
+#include "spdlog/sinks/basic_file_sink.h"
+#include "spdlog/sinks/stdout_sinks.h"
+
+#ifdef SPDLOG_ZLIB
+    #include <zlib.h>
+#endif
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const size_t max_line_size = 16 * 1024 * 1024;
+const unsigned datagram_batch = 64;
+const size_t max_datagram_size = 65536;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void on_signal(int) { stop_requested = 1; }
+
+void usage() {
+    std::fprintf(stderr,
+                 "Usage: log_receiver [-t port] [-u port] [-b] [-z] [-d file] [-p pattern] "
+                 "[-o file]\n");
+}
+
+struct connection {
+    std::string buffer;  // the data not consumed yet
+    std::unique_ptr<spdlog::binary_log_reader> reader;
+#ifdef SPDLOG_ZLIB
+    z_stream zstream{};
+    bool inflating = false;
+
+    ~connection() {
+        if (inflating) {
+            (void)inflateEnd(&zstream);
+        }
+    }
+#endif
+};
+
+class receiver {
+public:
+    receiver(spdlog::sink_ptr sink, bool binary, bool compressed, std::string dictionary)
+        : sink_(std::move(sink)),
+          binary_(binary),
+          compressed_(compressed),
+          dictionary_(std::move(dictionary)),
+          read_buffer_(256 * 1024),
+          datagrams_(datagram_batch * max_datagram_size) {}
+
+    // the messages of the text lines in data (up to the last '\n', or all of it if final),
+    // referring to data. return the size consumed.
+    size_t split_lines(const char *data, size_t size, bool final) {
+        size_t pos = 0;
+        while (pos < size) {
+            auto end = static_cast<const char *>(std::memchr(data + pos, '\n', size - pos));
+            if (end == nullptr) {
+                if (!final && size - pos < max_line_size) {
+                    break;
+                }
+                end = data + size;
+            }
+            auto line_size = static_cast<size_t>(end - (data + pos));
+            if (line_size > 0 && data[pos + line_size - 1] == '\r') {
+                line_size--;
+            }
+            batch_.emplace_back(spdlog::log_clock::time_point{}, spdlog::source_loc{},
+                                spdlog::string_view_t{}, spdlog::level::info,
+                                spdlog::string_view_t(data + pos, line_size));
+            pos = static_cast<size_t>(end - data) + (end == data + size ? 0 : 1);
+        }
+        return pos;
+    }
+
+    void write_batch() {
+        if (!batch_.empty()) {
+            sink_->log_batch(batch_.data(), batch_.size());
+            batch_.clear();
+        }
+    }
+
+    // return false when the connection is closed
+    bool read_connection(int fd, connection &conn) {
+        auto n = ::read(fd, read_buffer_.data(), read_buffer_.size());
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return true;
+        }
+        bool closed = n <= 0;
+        if (!closed && compressed_) {
+            if (!inflate_(conn, read_buffer_.data(), static_cast<size_t>(n))) {
+                return false;
+            }
+        } else if (!closed) {
+            conn.buffer.append(read_buffer_.data(), static_cast<size_t>(n));
+        }
+        if (binary_) {
+            return decode_binary(conn) && !closed;
+        }
+        auto consumed = split_lines(conn.buffer.data(), conn.buffer.size(), closed);
+        write_batch();
+        conn.buffer.erase(0, consumed);
+        return !closed;
+    }
+
+    // return false on invalid data
+    bool decode_binary(connection &conn) {
+        if (!conn.reader) {
+            conn.reader.reset(new spdlog::binary_log_reader(spdlog::string_view_t{}));
+        }
+        size_t count = 0;
+        try {
+            conn.reader->feed(spdlog::string_view_t(conn.buffer.data(), conn.buffer.size()));
+            spdlog::details::log_msg msg;
+            // the messages refer to the reader until its next call: copied
+            while (conn.reader->next(msg)) {
+                if (count == copies_.size()) {
+                    copies_.emplace_back(msg);
+                } else {
+                    copies_[count].assign(msg);
+                }
+                count++;
+            }
+        } catch (const std::exception &ex) {
+            std::fprintf(stderr, "log_receiver: %s\n", ex.what());
+            return false;
+        }
+        batch_.assign(copies_.begin(), copies_.begin() + static_cast<std::ptrdiff_t>(count));
+        write_batch();
+        conn.buffer.erase(0, conn.reader->consumed());
+        return true;
+    }
+
+    // the datagrams received by one system call
+    void read_datagrams(int fd) {
+        mmsghdr headers[datagram_batch];
+        iovec iovecs[datagram_batch];
+        std::memset(headers, 0, sizeof(headers));
+        for (unsigned i = 0; i < datagram_batch; i++) {
+            iovecs[i].iov_base = datagrams_.data() + i * max_datagram_size;
+            iovecs[i].iov_len = max_datagram_size;
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        auto count = ::recvmmsg(fd, headers, datagram_batch, MSG_DONTWAIT, nullptr);
+        for (int i = 0; i < count; i++) {
+            // with udp_sink_config::max_datagram_size, several lines per datagram
+            split_lines(datagrams_.data() + static_cast<size_t>(i) * max_datagram_size,
+                        headers[i].msg_len, true);
+        }
+        write_batch();
+    }
+
+    void flush() { sink_->flush(); }
+
+private:
+    spdlog::sink_ptr sink_;
+    bool binary_;
+    bool compressed_;
+    std::string dictionary_;
+    std::vector<char> read_buffer_;
+    std::vector<char> datagrams_;
+    std::vector<spdlog::details::log_msg> batch_;
+    std::vector<spdlog::details::log_msg_buffer> copies_;
+
+    // append the data decompressed to the buffer of the connection. false on invalid data.
+    bool inflate_(connection &conn, const char *data, size_t size) {
+#ifdef SPDLOG_ZLIB
+        auto &stream = conn.zstream;
+        if (!conn.inflating) {
+            if (inflateInit(&stream) != Z_OK) {
+                return false;
+            }
+            conn.inflating = true;
+        }
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream.avail_in = static_cast<uInt>(size);
+        char out[64 * 1024];
+        do {
+            stream.next_out = reinterpret_cast<Bytef *>(out);
+            stream.avail_out = static_cast<uInt>(sizeof(out));
+            int rv = inflate(&stream, Z_SYNC_FLUSH);
+            if (rv == Z_NEED_DICT && !dictionary_.empty()) {
+                rv = inflateSetDictionary(&stream,
+                                          reinterpret_cast<const Bytef *>(dictionary_.data()),
+                                          static_cast<uInt>(dictionary_.size()));
+            }
+            if (rv != Z_OK && rv != Z_BUF_ERROR) {
+                std::fprintf(stderr, "log_receiver: invalid compressed stream%s\n",
+                             rv == Z_NEED_DICT ? " (needs a dictionary)" : "");
+                return false;
+            }
+            conn.buffer.append(out, sizeof(out) - stream.avail_out);
+        } while (stream.avail_in > 0 || stream.avail_out == 0);
+        return true;
+#else
+        (void)conn;
+        (void)data;
+        (void)size;
+        return false;
+#endif
+    }
+};
+
+int listen_socket(int type, int port) {
+    int fd = ::socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int enable = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (type == SOCK_DGRAM) {
+        // room for the bursts of datagrams received between two reads
+        int size = 8 * 1024 * 1024;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        (type == SOCK_STREAM && ::listen(fd, SOMAXCONN) < 0)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool watch(int epoll_fd, int fd) {
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    return ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    int tcp_port = 0;
+    int udp_port = 0;
+    bool binary = false;
+    bool compressed = false;
+    std::string dictionary;
+    std::string pattern = "%+";
+    std::string filename;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            tcp_port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            udp_port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-b") == 0) {
+            binary = true;
+        } else if (std::strcmp(argv[i], "-z") == 0) {
+            compressed = true;
+        } else if (std::strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            std::ifstream in(argv[++i], std::ios::binary);
+            if (!in) {
+                std::fprintf(stderr, "log_receiver: failed opening %s\n", argv[i]);
+                return 1;
+            }
+            dictionary.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        } else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            pattern = argv[++i];
+        } else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            filename = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if ((tcp_port <= 0 && udp_port <= 0) || (binary && udp_port > 0)) {
+        usage();
+        return 1;
+    }
+#ifndef SPDLOG_ZLIB
+    if (compressed) {
+        std::fprintf(stderr, "log_receiver: -z needs zlib (build with SPDLOG_ZLIB)\n");
+        return 1;
+    }
+#endif
+
+    spdlog::sink_ptr sink;
+    try {
+        if (filename.empty()) {
+            sink = std::make_shared<spdlog::sinks::stdout_sink_st>();
+        } else {
+            sink = std::make_shared<spdlog::sinks::basic_file_sink_st>(filename);
+        }
+    } catch (const std::exception &ex) {
+        std::fprintf(stderr, "log_receiver: %s\n", ex.what());
+        return 1;
+    }
+    sink->set_pattern(binary ? pattern : "%v");
+    receiver recv(sink, binary, compressed, std::move(dictionary));
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    int tcp_fd = tcp_port > 0 ? listen_socket(SOCK_STREAM, tcp_port) : -1;
+    int udp_fd = udp_port > 0 ? listen_socket(SOCK_DGRAM, udp_port) : -1;
+    if (epoll_fd < 0 || (tcp_port > 0 && (tcp_fd < 0 || !watch(epoll_fd, tcp_fd))) ||
+        (udp_port > 0 && (udp_fd < 0 || !watch(epoll_fd, udp_fd)))) {
+        std::fprintf(stderr, "log_receiver: failed listening: %s\n", std::strerror(errno));
+        return 1;
+    }
+
+    std::unordered_map<int, connection> connections;
+    epoll_event events[64];
+    auto last_flush = std::chrono::steady_clock::now();
+    while (stop_requested == 0) {
+        int count = ::epoll_wait(epoll_fd, events, 64, 1000);
+        if (count < 0 && errno != EINTR) {
+            std::fprintf(stderr, "log_receiver: epoll_wait failed: %s\n", std::strerror(errno));
+            break;
+        }
+        try {
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (fd == tcp_fd) {
+                    int client = ::accept4(tcp_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client >= 0 && watch(epoll_fd, client)) {
+                        connections[client];
+                    } else if (client >= 0) {
+                        ::close(client);
+                    }
+                } else if (fd == udp_fd) {
+                    recv.read_datagrams(udp_fd);
+                } else if (!recv.read_connection(fd, connections[fd])) {
+                    ::close(fd);  // removed from the epoll set too
+                    connections.erase(fd);
+                }
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_flush >= std::chrono::seconds(1)) {
+                recv.flush();
+                last_flush = now;
+            }
+        } catch (const std::exception &ex) {
+            std::fprintf(stderr, "log_receiver: %s\n", ex.what());
+            break;
+        }
+    }
+
+    for (auto &conn : connections) {
+        ::close(conn.first);
+    }
+    try {
+        recv.flush();
+    } catch (const std::exception &ex) {
+        std::fprintf(stderr, "log_receiver: %s\n", ex.what());
+        return 1;
+    }
+    return 0;
+}